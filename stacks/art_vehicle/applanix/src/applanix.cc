@@ -134,19 +134,28 @@ int DevApplanix::connect_socket(void)
  
 // read the Applanix input socket
 //
+// Fills the largest contiguous free region of the ring buffer, so one
+// recv() drains everything the kernel has queued, up to that size: a
+// burst of packets costs a single syscall.
+//
 // returns 0 if any data received;
 //	   EAGAIN if no data received;
 //	   errno value if error
 int DevApplanix::read_packet(ros::Time *time)
 {
-  int nbytes;
+  size_t free_space = APPLANIX_RINGSIZE - ring_avail();
+  size_t tail_index = ring_tail & APPLANIX_RINGMASK;
+  size_t contig = APPLANIX_RINGSIZE - tail_index;
+  if (contig > free_space)
+    contig = free_space;
+  if (contig == 0)			// parser has fallen behind?
+    return EAGAIN;
 
-  // try to complete the packet in our buffer
+  int nbytes;
   do
     {
       ROS_DEBUG(DEVICE " reading socket");
-      nbytes = recv(sockfd, packet_buffer+buffer_length,
-		    sizeof(packet_buffer)-buffer_length, 0);
+      nbytes = recv(sockfd, ring_buffer+tail_index, contig, 0);
     }
   while ((nbytes < 0) && (errno == EINTR));
 
@@ -163,13 +172,87 @@ int DevApplanix::read_packet(ros::Time *time)
     }
 
   *time = ros::Time::now();
-  buffer_length += nbytes;
+  ring_tail += nbytes;
 
   ROS_DEBUG("Got packet with %d bytes, time %.6f", nbytes, time->toSec());
 
   return 0;
 }
 
+// return a contiguous view of the next len buffered bytes
+//
+// Usually this is a pointer directly into the ring (zero copy); only
+// a packet wrapping the end of the ring is copied out to the unwrap
+// staging buffer.  The message structs are packed, so unaligned
+// access through the returned pointer is safe.
+//
+// precondition: len <= ring_avail() and len <= APPLANIX_MAXMSGSIZE
+char *DevApplanix::ring_packet(size_t len)
+{
+  size_t head_index = ring_head & APPLANIX_RINGMASK;
+  if (head_index + len <= APPLANIX_RINGSIZE)
+    return ring_buffer + head_index;
+
+  size_t first = APPLANIX_RINGSIZE - head_index;
+  memcpy(unwrap_buffer, ring_buffer+head_index, first);
+  memcpy(unwrap_buffer+first, ring_buffer, len-first);
+  return unwrap_buffer;
+}
+
+// append len bytes to the ring buffer
+//
+// precondition: len <= free space remaining
+void DevApplanix::ring_put(const uint8_t *data, size_t len)
+{
+  size_t tail_index = ring_tail & APPLANIX_RINGMASK;
+  size_t contig = APPLANIX_RINGSIZE - tail_index;
+  if (contig > len)
+    contig = len;
+  memcpy(ring_buffer+tail_index, data, contig);
+  if (len > contig)			// wrapped around the end?
+    memcpy(ring_buffer, data+contig, len-contig);
+  ring_tail += len;
+}
+
+// estimate measurement time of a navigation solution
+//
+// The POS-LV stamps every group with its own time of validity, which
+// is when the measurement was actually taken.  The host receive time
+// adds socket and scheduling delay on top of that, plus the offset
+// between the two clocks.  Delay only ever increases the observed
+// offset, so tracking its minimum recovers the clock offset; a slow
+// upward creep follows relative drift between the clocks.
+//
+// returns measurement time in the host (ROS) time base; host_time
+// unfiltered if the device time of validity looks invalid
+ros::Time DevApplanix::time_estimate(double tov, ros::Time host_time)
+{
+  if (tov <= 0.0)			// no valid device time?
+    return host_time;
+
+  double offset = host_time.toSec() - tov;
+
+  if (tsync_valid && fabs(offset - tsync_offset) > 1.0)
+    {
+      // device clock stepped (GPS time acquired, POS restarted)
+      ROS_WARN(DEVICE " time jumped %.3f seconds, resetting time sync",
+	       offset - tsync_offset);
+      tsync_valid = false;
+    }
+
+  if (!tsync_valid)			// first observation?
+    {
+      tsync_offset = offset;
+      tsync_valid = true;
+    }
+  else if (offset < tsync_offset)	// less delayed than any before?
+    tsync_offset = offset;
+  else					// creep along with clock drift
+    tsync_offset += 0.0005 * (offset - tsync_offset);
+
+  return ros::Time(tov + tsync_offset);
+}
+
 // get next Applanix packet
 //
 // return the packet in the applanix data struct.  Update adata->time
@@ -180,23 +263,44 @@ int DevApplanix::read_packet(ros::Time *time)
 //	   errno value if error
 int DevApplanix::get_packet(applanix_data_t *adata)
 {
-  GRPHDR_MSG *hdr = (GRPHDR_MSG *) packet_buffer;
-  ros::Time packet_time = adata->time;
+  // Host time reference for the timestamp estimator.  Any read this
+  // call updates it; for data already buffered, now() is still a
+  // valid upper bound on the arrival time.
+  ros::Time packet_time = ros::Time::now();
+  size_t packet_length;
 
   // have we got a complete packet?
-  while ((buffer_length < sizeof(GRPHDR_MSG))
-	 || (buffer_length < hdr->bytecount + sizeof(GRPHDR_MSG)))
+  for (;;)
     {
+      if (ring_avail() >= sizeof(GRPHDR_MSG))
+	{
+	  GRPHDR_MSG *hdr = (GRPHDR_MSG *) ring_packet(sizeof(GRPHDR_MSG));
+	  packet_length = hdr->bytecount + sizeof(GRPHDR_MSG);
+	  if (packet_length > APPLANIX_MAXMSGSIZE)
+	    {
+	      // corrupt header: discard buffered input and resync
+	      ROS_WARN(DEVICE " absurd packet size %u, discarding input",
+		       (unsigned) packet_length);
+	      ring_head = ring_tail;
+	      continue;
+	    }
+	  if (ring_avail() >= packet_length)
+	    break;			// have a full packet
+	}
+
       int rc = read_packet(&packet_time);
       if (rc != 0)			// no data received?
 	{
           ROS_DEBUG_STREAM(DEVICE " partial packet received ("
-                           << buffer_length << " bytes)");
+                           << ring_avail() << " bytes)");
 	  return rc;
 	}
     }
 
   // have a full packet in the buffer
+  GRP_MSG *msg = (GRP_MSG *) ring_packet(packet_length);
+  GRPHDR_MSG *hdr = &msg->hdr;
+
   // \todo fix for 64-bit
   ROS_DEBUG(DEVICE " %*.*s %d packet, size %d",
             (int) sizeof(hdr->grpstart), (int) sizeof(hdr->grpstart),
@@ -206,21 +310,21 @@ int DevApplanix::get_packet(applanix_data_t *adata)
   switch(hdr->groupnum)
   {
   case 1:
-    unpack_grp1(adata, (GRP1_MSG *) packet_buffer);
-    adata->time = packet_time;
+    unpack_grp1(adata, &msg->grp1);
+    // stamp with estimated measurement time, not arrival time
+    adata->time = time_estimate(msg->grp1.data.timedist.time1, packet_time);
     break;
   case 4:
-    unpack_grp4(adata, (GRP4_MSG *) packet_buffer);
+    unpack_grp4(adata, &msg->grp4);
+    adata->grp4_time = time_estimate(msg->grp4.data.timedist.time1,
+                                     packet_time);
     break;
   default:
     break;
   }
 
-  // shift packet_buffer to the left
-  size_t packet_length = hdr->bytecount + sizeof(GRPHDR_MSG);
-  buffer_length -= packet_length;
-  if (buffer_length > 0)
-    memmove(packet_buffer, packet_buffer+packet_length, buffer_length);
+  // consuming the packet just advances the head index
+  ring_head += packet_length;
 
   return 0;
 }
@@ -263,12 +367,12 @@ int DevApplanixPCAP::read_packet(ros::Time *time)
   // read the next packet from the PCAP dump
   if ((res = pcap_next_ex(pcap_, &header, &pkt_data)) >= 0)
     {
-      if (header->len > sizeof(packet_buffer)-buffer_length)
+      if (header->len > APPLANIX_RINGSIZE - ring_avail())
         {
           // TODO Save this packet for next time?
           ROS_WARN_STREAM("PCAP packet (size " << header->len
                           << ") overflows buffer (" <<
-                          sizeof(packet_buffer)-buffer_length <<" left)");
+                          APPLANIX_RINGSIZE - ring_avail() <<" left)");
           return EAGAIN;                // buffer too full
         }
 
@@ -322,10 +426,9 @@ int DevApplanixPCAP::read_packet(ros::Time *time)
         }
 
 
-        // copy all packet data after headers to buffer
+        // copy all packet data after headers to the ring buffer
         size_t pkt_length = header->len - pkt_offset;
-        memcpy(packet_buffer + buffer_length, pkt_data + pkt_offset, pkt_length);
-        buffer_length += pkt_length;
+        ring_put(pkt_data + pkt_offset, pkt_length);
         *time = ros::Time::now();
         got_data_ = true;
         empty_ = false;
@@ -374,6 +477,97 @@ int DevApplanixPCAP::read_packet(ros::Time *time)
   return 0;
 }
 
+int DevApplanixReplay::connect_socket(void)
+{
+  ROS_INFO("Opening replay log \"%s\"", filename_.c_str());
+
+  fp_ = fopen(filename_.c_str(), "rb");
+  if (fp_ == NULL)
+    {
+      int rc = errno;
+      ROS_ERROR("failed to open \"%s\" (%s)",
+                filename_.c_str(), strerror(rc));
+      return rc;
+    }
+  return 0;
+}
+
+/** get packet from raw replay log
+ *
+ * Reads exactly one group packet per call, validating its header, and
+ * appends it to the ring buffer for the normal parsing path.  In
+ * paced mode successful calls alternate with EAGAIN, so the driver's
+ * main loop keeps cycling; unpaced replay streams the whole log
+ * through as fast as the parser consumes it.
+ *
+ * \returns 0 if any data received;
+ *	    EAGAIN if no data received;
+ *	    errno value if error
+ */
+int DevApplanixReplay::read_packet(ros::Time *time)
+{
+  if (time_scale_ > 0.0 && got_data_)
+    {
+      got_data_ = false;
+      return EAGAIN;
+    }
+
+  GRPHDR_MSG hdr;
+  if (fread(&hdr, sizeof(hdr), 1, fp_) != 1)
+    {
+      if (ferror(fp_))
+        {
+          clearerr(fp_);
+          return EIO;
+        }
+      return EAGAIN;			// end of log: nothing more
+    }
+
+  size_t packet_length = hdr.bytecount + sizeof(GRPHDR_MSG);
+  if (memcmp(hdr.grpstart, "$GRP", sizeof(hdr.grpstart)) != 0
+      || packet_length > APPLANIX_MAXMSGSIZE)
+    {
+      ROS_WARN("corrupt replay log header, stopping replay");
+      return EIO;
+    }
+
+  if (packet_length > APPLANIX_RINGSIZE - ring_avail())
+    {
+      // parser has fallen behind; re-read this packet next call
+      fseek(fp_, -(long) sizeof(hdr), SEEK_CUR);
+      return EAGAIN;
+    }
+
+  memcpy(read_buffer_, &hdr, sizeof(hdr));
+  if (fread(read_buffer_ + sizeof(hdr),
+            packet_length - sizeof(hdr), 1, fp_) != 1)
+    {
+      ROS_WARN("truncated packet at end of replay log");
+      clearerr(fp_);
+      return EAGAIN;
+    }
+
+  // pace navigation solutions by their recorded times of validity
+  if (time_scale_ > 0.0 && hdr.groupnum == 1)
+    {
+      double tov;
+      memcpy(&tov, read_buffer_ + sizeof(hdr), sizeof(tov));
+      if (last_tov_ > 0.0 && tov > last_tov_)
+        {
+          double delay = (tov - last_tov_) / time_scale_;
+          if (delay < 1.0)		// ignore time steps in the log
+            usleep(rint(delay * 1000000.0));
+        }
+      last_tov_ = tov;
+    }
+
+  ring_put(read_buffer_, packet_length);
+  *time = ros::Time::now();
+  got_data_ = true;
+
+  return 0;
+}
+
 int DevApplanixTest::connect_socket(void)
 {
   fp_ = fopen(testfile_.c_str(), "r");
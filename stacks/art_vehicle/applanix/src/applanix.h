@@ -40,6 +40,11 @@
 
 #define APPLANIX_MAXMSGSIZE 6000
 
+// Receive ring buffer size: a power of two so wrapped indexes can be
+// masked, large enough to hold several maximum-size messages.
+#define APPLANIX_RINGSIZE 16384
+#define APPLANIX_RINGMASK (APPLANIX_RINGSIZE-1)
+
 #define APPLANIX_DEFAULT_IP "192.168.1.25"
 
 #define APPLANIX_NMEA_DEG_PER_BIT 0.0054931640625
@@ -69,9 +74,19 @@ typedef enum {
   ApplStatusInvalid =	8
 } appl_alignment_status_t;
 
+// time and distance fields leading every group's data
+#pragma pack(1)
+typedef struct TIMEDIST_MSG_ {
+  double time1;                         /* time of validity (seconds) */
+  double time2;
+  double dist;
+  char timetypes;
+  char disttype;
+} TIMEDIST_MSG;
+
 #pragma pack(1)
 typedef struct GRP1DATA_MSG_ {
-  char timedist[26];
+  TIMEDIST_MSG timedist;
   double lat;
   double lon;
   double alt;
@@ -103,7 +118,7 @@ typedef struct GRP1_MSG_ {
 
 #pragma pack(1)
 typedef struct GRP4DATA_MSG_ {
-  char timedist[26];
+  TIMEDIST_MSG timedist;
   int32_t vel_x;
   int32_t vel_y;
   int32_t vel_z;
@@ -136,7 +151,8 @@ typedef struct GRP_MSG_ {
 typedef struct {
   GRP1DATA_MSG	grp1;
   GRP4DATA_MSG	grp4;
-  ros::Time time;
+  ros::Time time;			// last navigation solution (GRP1)
+  ros::Time grp4_time;			// last raw IMU sample (GRP4)
 } applanix_data_t;
 
 class DevApplanix
@@ -146,8 +162,11 @@ class DevApplanix
   DevApplanix(void)
     {
       serverhost = APPLANIX_DEFAULT_IP;
-      buffer_length = 0;
+      ring_head = 0;
+      ring_tail = 0;
       have_DGPS = true;
+      tsync_valid = false;
+      tsync_offset = 0.0;
     };
   virtual ~DevApplanix() {};
 
@@ -163,11 +182,32 @@ class DevApplanix
   const char                    *serverhost;
   struct hostent          *serverhostp;
 
-  char packet_buffer[APPLANIX_MAXMSGSIZE];
-  size_t buffer_length;
+  // Received bytes accumulate in a power-of-two ring buffer, indexed
+  // by free-running head and tail counts (masked on access).
+  // Consuming a packet just advances the head index; leftover bytes
+  // are never shifted.
+  char ring_buffer[APPLANIX_RINGSIZE];
+  size_t ring_head;                     // next byte to consume
+  size_t ring_tail;                     // next byte to fill
+  char unwrap_buffer[APPLANIX_MAXMSGSIZE];
+
+  // number of buffered bytes not yet consumed
+  size_t ring_avail(void) {return ring_tail - ring_head;}
+
+  char *ring_packet(size_t len);
+  void  ring_put(const uint8_t *data, size_t len);
 
   virtual int  read_packet(ros::Time *time);
 
+  // Timestamp estimator state: filtered offset from the POS-LV
+  // time-of-validity clock to host time.  Receive delay only ever
+  // adds to the observed offset, so the estimate tracks its minimum,
+  // creeping upward slowly to follow relative clock drift.
+  bool   tsync_valid;			// tsync_offset initialized
+  double tsync_offset;			// host time minus device time
+
+  ros::Time time_estimate(double tov, ros::Time host_time);
+
   // unpack specific message types
   virtual void unpack_grp1(applanix_data_t *adata, GRP1_MSG *msg);
   virtual void unpack_grp4(applanix_data_t *adata, GRP4_MSG *msg);
@@ -219,6 +259,46 @@ class DevApplanixPCAP: public DevApplanix
   double repeat_delay_;
 };
 
+/** Applanix input replayed from a raw packet log.
+ *
+ *  The log holds the byte stream of POS-LV group packets exactly as
+ *  read from the real-time data socket, with no capture framing.
+ *  Replay runs either as fast as possible (time_scale 0), for
+ *  benchmarking unpack_grp1(), unpack_grp4() and the odometry
+ *  pipeline, or paced by the recorded group times of validity scaled
+ *  by time_scale.
+ */
+class DevApplanixReplay: public DevApplanix
+{
+ public:
+
+ DevApplanixReplay(std::string filename,
+                   double time_scale=0.0): DevApplanix()
+    {
+      filename_ = filename;
+      fp_ = NULL;
+      got_data_ = false;
+      time_scale_ = time_scale;
+      last_tov_ = 0.0;
+      if (time_scale_ > 0.0)
+        ROS_INFO("Replay \"%s\" at %.2f times recorded rate.",
+                 filename_.c_str(), time_scale_);
+      else
+        ROS_INFO("Replay \"%s\" as fast as possible.", filename_.c_str());
+    }
+
+  virtual int connect_socket(void);
+  virtual int  read_packet(ros::Time *time);
+
+ private:
+  std::string filename_;
+  FILE *fp_;
+  bool got_data_;			// pacing: alternate with EAGAIN
+  double time_scale_;			// replay rate, 0 = unpaced
+  double last_tov_;			// previous group time of validity
+  uint8_t read_buffer_[APPLANIX_MAXMSGSIZE];
+};
+
 /** Unit test derived class */
 class DevApplanixTest: public DevApplanix
 {
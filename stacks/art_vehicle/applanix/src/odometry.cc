@@ -66,6 +66,8 @@ namespace
 
   // command parameters
   int qDepth = 1;                       // ROS topic queue size
+  bool imu_rate_ = false;               // publish at raw IMU rate
+  double tf_rate_ = 0.0;                // tf broadcast rate (0: every fix)
 
   // class for generating vehicle-relative frame IDs
   ArtFrames::VehicleRelative vr_;
@@ -73,8 +75,31 @@ namespace
   // GPS information
   applanix_data_t adata;		// saved applanix data packets
   DevApplanix *applanix_;		// Applanix device interface
+
+  // Preallocated publication messages.  Publishing a shared pointer
+  // lets roscpp hand the same message instance to subscribers within
+  // this process (pilot, navigator) without serializing and copying
+  // it.  A small pool is rotated so a message is never modified while
+  // an intraprocess subscriber may still be reading it.
+  const int MSG_POOL_SIZE = 4;
+  nav_msgs::OdometryPtr odom_pool_[MSG_POOL_SIZE];
+  sensor_msgs::ImuPtr imu_pool_[MSG_POOL_SIZE];
+  int pool_next_ = 0;
 };
 
+/** Allocate publication message pool, filling in constant fields. */
+void allocMessagePool(void)
+{
+  for (int i = 0; i < MSG_POOL_SIZE; ++i)
+    {
+      odom_pool_[i] = nav_msgs::OdometryPtr(new nav_msgs::Odometry());
+      odom_pool_[i]->header.frame_id = vr_.getFrame(ArtFrames::odom);
+      odom_pool_[i]->child_frame_id = vr_.getFrame(ArtFrames::vehicle);
+      imu_pool_[i] = sensor_msgs::ImuPtr(new sensor_msgs::Imu());
+      imu_pool_[i]->header.frame_id = vr_.getFrame(ArtFrames::vehicle);
+    }
+}
+
 
 /** Global to local coordinate transform. 
  *
@@ -143,6 +168,7 @@ bool GlobalToLocal(Position::Pose3D *current)
 bool getNewData(applanix_data_t *adata)
 {
   static ros::Time last_time;
+  static ros::Time last_imu_time;
 
   // read and unpack first packet
   int rc = applanix_->get_packet(adata);
@@ -161,8 +187,10 @@ bool getNewData(applanix_data_t *adata)
     }
   while (rc == 0);
 
-  // see if a new navigation solution is available
-  if (adata->time == last_time)
+  // see if a new navigation solution is available; in IMU-rate mode a
+  // new raw IMU sample between solutions is enough to publish
+  bool new_imu = (imu_rate_ && adata->grp4_time != last_imu_time);
+  if (adata->time == last_time && !new_imu)
     return false;
   // see if device is returning valid data yet
   if (adata->grp1.alignment == ApplStatusInvalid)
@@ -180,6 +208,7 @@ bool getNewData(applanix_data_t *adata)
 #endif
 
   last_time = adata->time;              // remember time of last update
+  last_imu_time = adata->grp4_time;
   return true;
 }
 
@@ -243,11 +272,17 @@ bool getOdom(Position::Position3D *odom_pos3d, ros::Time *odom_time,
   // Convert latitude and longitude (spherical coordinates) to
   // Universal Transverse Mercator (Cartesian).
   double utm_e, utm_n;			// easting, northing (in meters)
-  char zone[20];
-  UTM::LLtoUTM(adata.grp1.lat, adata.grp1.lon, utm_n, utm_e, zone);
+  static UTM::UTMConverter utm_conv;	// reuses zone constants between fixes
+  utm_conv.convert_local(adata.grp1.lat, adata.grp1.lon, utm_n, utm_e);
 
-  // publish GPS information topic
-  publishGPS(adata, utm_e, utm_n, zone, gps_pub);
+  // publish GPS information topic when a new fix arrived (in IMU-rate
+  // mode this call may be refreshing velocities between fixes)
+  static ros::Time last_fix_time;
+  if (adata.time != last_fix_time)
+    {
+      last_fix_time = adata.time;
+      publishGPS(adata, utm_e, utm_n, utm_conv.zone(), gps_pub);
+    }
 
   using namespace angles;
     
@@ -284,8 +319,26 @@ bool getOdom(Position::Position3D *odom_pos3d, ros::Time *odom_time,
   odom_pos3d->vel.pitch = from_degrees(-adata.grp1.arate_trans);
   odom_pos3d->vel.yaw =   from_degrees(-adata.grp1.arate_down);
 
+  // High-rate fusion: between navigation solutions, extrapolate the
+  // forward velocity to the latest raw IMU sample time using the
+  // measured longitudinal acceleration, and take the yaw rate from
+  // the IMU sample itself.  The pilot's speed controller then gets a
+  // fresh measurement every IMU period instead of waiting for the
+  // next full solution.
+  if (imu_rate_ && adata.grp4_time > adata.time)
+    {
+      double dt = (adata.grp4_time - adata.time).toSec();
+      if (dt < 0.5)			// stale solution: do not coast
+        {
+          odom_pos3d->vel.x += adata.grp1.accel_lon * dt;
+          odom_pos3d->vel.yaw = from_degrees(-APPLANIX_NMEA_DEG_PER_BIT
+                                             * adata.grp4.ang_z);
+          *odom_time = adata.grp4_time;
+        }
+    }
+
   return true;				// need to publish
-}  
+}
 
 /** subscriber callback for current shifter position data */
 void getShifter(const art_msgs::Shifter::ConstPtr &shifterIn)
@@ -309,58 +362,91 @@ void putPose(const Position::Position3D *odom_pos3d,
   geometry_msgs::Quaternion odom_quat;
   tf::quaternionTFToMsg(q, odom_quat);
 
-  // broadcast Transform from /earth to /vehicle
-  geometry_msgs::TransformStamped earth_tf;
-  earth_tf.header.stamp = *odom_time;
-  earth_tf.header.frame_id = vr_.getFrame(ArtFrames::earth);
-  earth_tf.child_frame_id = vr_.getFrame(ArtFrames::vehicle);
-  earth_tf.transform.translation.x = odom_pos3d->pos.x;
-  earth_tf.transform.translation.y = odom_pos3d->pos.y;
-  earth_tf.transform.translation.z = odom_pos3d->pos.z;
-  earth_tf.transform.rotation = odom_quat;
-  odom_broad->sendTransform(earth_tf);
-
-  // broadcast Transform from /odom to /earth with same X, Y position
-  // and orientation, but same Z coordinate as /vehicle
-  geometry_msgs::TransformStamped odom_tf;
-  odom_tf.header.stamp = *odom_time;
-  odom_tf.header.frame_id = vr_.getFrame(ArtFrames::odom);
-  odom_tf.child_frame_id = vr_.getFrame(ArtFrames::earth);
-  odom_tf.transform.translation.z = -odom_pos3d->pos.z;
-  odom_tf.transform.rotation.w = 1.0;
-  odom_broad->sendTransform(odom_tf);
+  // Decimate tf broadcasts to tf_rate_ when configured.  Stamps stay
+  // at the true measurement times, so tf listeners interpolate
+  // between the decimated samples; the odom topic still carries every
+  // fix for subscribers needing the full rate.
+  static ros::Time last_tf_time;
+  bool send_tf = true;
+  if (tf_rate_ > 0.0)
+    {
+      double elapsed = (*odom_time - last_tf_time).toSec();
+      send_tf = (elapsed >= 1.0/tf_rate_ || elapsed < 0.0);
+    }
+
+  if (send_tf)
+    {
+      last_tf_time = *odom_time;
+
+      // broadcast Transform from /earth to /vehicle
+      geometry_msgs::TransformStamped earth_tf;
+      earth_tf.header.stamp = *odom_time;
+      earth_tf.header.frame_id = vr_.getFrame(ArtFrames::earth);
+      earth_tf.child_frame_id = vr_.getFrame(ArtFrames::vehicle);
+      earth_tf.transform.translation.x = odom_pos3d->pos.x;
+      earth_tf.transform.translation.y = odom_pos3d->pos.y;
+      earth_tf.transform.translation.z = odom_pos3d->pos.z;
+      earth_tf.transform.rotation = odom_quat;
+
+      // plus the Transform from /odom to /earth with same X, Y
+      // position and orientation, but same Z coordinate as /vehicle
+      geometry_msgs::TransformStamped odom_tf;
+      odom_tf.header.stamp = *odom_time;
+      odom_tf.header.frame_id = vr_.getFrame(ArtFrames::odom);
+      odom_tf.child_frame_id = vr_.getFrame(ArtFrames::earth);
+      odom_tf.transform.translation.z = -odom_pos3d->pos.z;
+      odom_tf.transform.rotation.w = 1.0;
+
+      // send both together in a single tf message
+      std::vector<geometry_msgs::TransformStamped> transforms;
+      transforms.push_back(earth_tf);
+      transforms.push_back(odom_tf);
+      odom_broad->sendTransform(transforms);
+    }
+
+  // Take the next preallocated message pair from the pool.  The pool
+  // and this function each hold one reference; any more means some
+  // slow intraprocess subscriber still has the previous publication,
+  // so allocate fresh messages rather than overwrite it.
+  nav_msgs::OdometryPtr odom_msg = odom_pool_[pool_next_];
+  sensor_msgs::ImuPtr imu_msg = imu_pool_[pool_next_];
+  if (odom_msg.use_count() > 2 || imu_msg.use_count() > 2)
+    {
+      ROS_DEBUG("message pool entry %d still in use", pool_next_);
+      odom_msg = nav_msgs::OdometryPtr(new nav_msgs::Odometry());
+      odom_msg->header.frame_id = vr_.getFrame(ArtFrames::odom);
+      odom_msg->child_frame_id = vr_.getFrame(ArtFrames::vehicle);
+      imu_msg = sensor_msgs::ImuPtr(new sensor_msgs::Imu());
+      imu_msg->header.frame_id = vr_.getFrame(ArtFrames::vehicle);
+    }
+  pool_next_ = (pool_next_ + 1) % MSG_POOL_SIZE;
 
   // publish the Odometry message
-  nav_msgs::Odometry odom_msg;
-  odom_msg.header.stamp = *odom_time;
-  odom_msg.header.frame_id = vr_.getFrame(ArtFrames::odom);
-  odom_msg.pose.pose.position.x = odom_pos3d->pos.x;
-  odom_msg.pose.pose.position.y = odom_pos3d->pos.y;
-  odom_msg.pose.pose.position.z = odom_pos3d->pos.z;
-  odom_msg.pose.pose.orientation = odom_quat;
-  odom_msg.child_frame_id = vr_.getFrame(ArtFrames::vehicle);
+  odom_msg->header.stamp = *odom_time;
+  odom_msg->pose.pose.position.x = odom_pos3d->pos.x;
+  odom_msg->pose.pose.position.y = odom_pos3d->pos.y;
+  odom_msg->pose.pose.position.z = odom_pos3d->pos.z;
+  odom_msg->pose.pose.orientation = odom_quat;
 
   // Twist is relative to the /vehicle frame, not /odom
-  odom_msg.twist.twist.linear.x = odom_pos3d->vel.x;
-  odom_msg.twist.twist.linear.y = odom_pos3d->vel.y;
-  odom_msg.twist.twist.linear.z = odom_pos3d->vel.z;
-  odom_msg.twist.twist.angular.x = odom_pos3d->vel.roll;
-  odom_msg.twist.twist.angular.y = odom_pos3d->vel.pitch;
-  odom_msg.twist.twist.angular.z = odom_pos3d->vel.yaw;
+  odom_msg->twist.twist.linear.x = odom_pos3d->vel.x;
+  odom_msg->twist.twist.linear.y = odom_pos3d->vel.y;
+  odom_msg->twist.twist.linear.z = odom_pos3d->vel.z;
+  odom_msg->twist.twist.angular.x = odom_pos3d->vel.roll;
+  odom_msg->twist.twist.angular.y = odom_pos3d->vel.pitch;
+  odom_msg->twist.twist.angular.z = odom_pos3d->vel.yaw;
 
   /// \todo figure covariances of Pose and Twist
 
   odom_pub->publish(odom_msg);
 
   // publish the Imu message
-  sensor_msgs::Imu imu_msg;
-  imu_msg.header.stamp = *odom_time;
-  imu_msg.header.frame_id = vr_.getFrame(ArtFrames::vehicle);
-  imu_msg.orientation = odom_quat;
-  imu_msg.angular_velocity = odom_msg.twist.twist.angular;
-  imu_msg.linear_acceleration.x = adata.grp1.accel_lon;
-  imu_msg.linear_acceleration.y = adata.grp1.accel_trans;
-  imu_msg.linear_acceleration.z = - adata.grp1.accel_down;
+  imu_msg->header.stamp = *odom_time;
+  imu_msg->orientation = odom_quat;
+  imu_msg->angular_velocity = odom_msg->twist.twist.angular;
+  imu_msg->linear_acceleration.x = adata.grp1.accel_lon;
+  imu_msg->linear_acceleration.y = adata.grp1.accel_trans;
+  imu_msg->linear_acceleration.z = - adata.grp1.accel_down;
 
   /// \todo figure covariances of IMU data
 
@@ -377,7 +463,14 @@ void displayHelp()
             << "\t -h, -?       print usage message\n"
             << "\t -f <file>    use PCAP dump from <file>\n"
             << "\t -q <integer> set ROS topic queue depth (default: 1)\n"
+            << "\t -r <file>    replay raw packet log from <file>\n"
+            << "\t -s <scale>   pace replay at <scale> times recorded rate\n"
+            << "\t              (default: as fast as possible)\n"
             << "\t -t <file>    run unit test with fake data from <file>\n"
+            << "\t -u           publish velocity at the raw IMU rate,\n"
+            << "\t              extrapolating between navigation solutions\n"
+            << "\t -z <hz>      decimate tf broadcasts to <hz>\n"
+            << "\t              (default: broadcast every fix)\n"
             << std::endl
             << "Example:\n"
             << "  rosrun applanix odometry -q2\n"
@@ -392,11 +485,13 @@ void displayHelp()
 int getParameters(int argc, char *argv[])
 {
   static std::string pcap_file = "";    // pcap dump file
+  static std::string replay_file = "";  // raw packet log file
+  static double time_scale = 0.0;       // replay pacing (0: unpaced)
   static std::string test_file = "";    // unit test input file
 
   // use getopt to parse the flags
   char ch;
-  const char* optflags = "hf:q:t:?";
+  const char* optflags = "hf:q:r:s:t:uz:?";
   while(-1 != (ch = getopt(argc, argv, optflags)))
     {
       switch(ch)
@@ -409,9 +504,25 @@ int getParameters(int argc, char *argv[])
           if (qDepth < 1)
             qDepth = 1;
           break;
+        case 'r':
+          replay_file = optarg;
+          break;
+        case 's':
+          time_scale = atof(optarg);
+          if (time_scale < 0.0)
+            time_scale = 0.0;
+          break;
         case 't':
           test_file = optarg;
           break;
+        case 'u':
+          imu_rate_ = true;
+          break;
+        case 'z':
+          tf_rate_ = atof(optarg);
+          if (tf_rate_ < 0.0)
+            tf_rate_ = 0.0;
+          break;
         default:                        // unknown
           ROS_WARN("unknown parameter: %c", ch);
           // fall through to display help...
@@ -427,6 +538,8 @@ int getParameters(int argc, char *argv[])
   // Create Applanix odometry device interface
   if (pcap_file != "")
     applanix_ = new DevApplanixPCAP(pcap_file);
+  else if (replay_file != "")
+    applanix_ = new DevApplanixReplay(replay_file, time_scale);
   else if (test_file != "")
     applanix_ = new DevApplanixTest(test_file);
   else
@@ -446,6 +559,8 @@ int main(int argc, char** argv)
   if (0 != getParameters(argc, argv))
     return 9;
 
+  allocMessagePool();                   // preallocate publication messages
+
   // make this a class w/constructor to initialize?
   memset(&adata, 0, sizeof(adata));
   adata.grp1.alignment = ApplStatusInvalid; // no valid solution yet
@@ -471,7 +586,9 @@ int main(int argc, char** argv)
   if (rc != 0)				// device init failed?
     return 2;
 
-  ros::Rate cycle(20);                  // set driver cycle rate
+  // set driver cycle rate: IMU-rate mode must poll at the 200Hz raw
+  // IMU data rate to publish every sample
+  ros::Rate cycle(imu_rate_ ? 200 : 20);
   
   ROS_INFO(NODE ": starting main loop");
 
@@ -24,6 +24,7 @@
 #include <cmath>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <art/conversions.h>
 
@@ -222,7 +223,192 @@ static inline void LLtoUTM(const double Lat, const double Long,
 }
 
 /**
- * Converts UTM coords to lat/long.  Equations from USGS Bulletin 1532 
+ * Converter caching per-zone constants for repeated LLtoUTM() calls.
+ *
+ * LLtoUTM() recomputes its meridional arc coefficients and the zone
+ * designator string on every call, and evaluates several redundant
+ * trigonometric terms.  This class reuses the central meridian and
+ * zone string while successive points stay in the same zone, computes
+ * each trigonometric function once, and offers a batch interface for
+ * converting whole arrays of fixes.  Results match LLtoUTM() to
+ * floating point round-off.
+ */
+class UTMConverter
+{
+public:
+  UTMConverter(): zone_number_(0), zone_letter_('\0'), long_origin_rad_(0.0)
+  {
+    zone_[0] = '\0';
+    local_valid_ = false;
+    origin_lat_ = origin_lon_ = 0.0;
+    origin_n_ = origin_e_ = 0.0;
+    dn_dlat_ = dn_dlon_ = de_dlat_ = de_dlon_ = 0.0;
+    lon_radius_deg_ = 0.0;
+  }
+
+  /** Convert one lat/long fix to UTM northing and easting. */
+  void convert(double lat, double lon, double &northing, double &easting)
+  {
+    // meridional arc series coefficients, computed once
+    static const double m0 = (1 - UTM_E2/4 - 3*UTM_E4/64 - 5*UTM_E6/256);
+    static const double m1 = -(3*UTM_E2/8 + 3*UTM_E4/32 + 45*UTM_E6/1024);
+    static const double m2 = (15*UTM_E4/256 + 45*UTM_E6/1024);
+    static const double m3 = -(35*UTM_E6/3072);
+
+    // Make sure the longitude is between -180.00 .. 179.9
+    double LongTemp = (lon+180)-int((lon+180)/360)*360-180;
+
+    int ZoneNumber = int((LongTemp + 180)/6) + 1;
+
+    if (lat >= 56.0 && lat < 64.0 && LongTemp >= 3.0 && LongTemp < 12.0)
+      ZoneNumber = 32;
+
+    // Special zones for Svalbard
+    if (lat >= 72.0 && lat < 84.0)
+      {
+        if      (LongTemp >= 0.0  && LongTemp <  9.0) ZoneNumber = 31;
+        else if (LongTemp >= 9.0  && LongTemp < 21.0) ZoneNumber = 33;
+        else if (LongTemp >= 21.0 && LongTemp < 33.0) ZoneNumber = 35;
+        else if (LongTemp >= 33.0 && LongTemp < 42.0) ZoneNumber = 37;
+      }
+
+    // fast path: skip the central meridian and zone string work while
+    // successive points stay within the cached zone
+    char letter = UTMLetterDesignator(lat);
+    if (ZoneNumber != zone_number_ || letter != zone_letter_)
+      {
+        zone_number_ = ZoneNumber;
+        zone_letter_ = letter;
+        // +3 puts origin in middle of zone
+        long_origin_rad_ = (((ZoneNumber - 1)*6 - 180 + 3)
+                            * RADIANS_PER_DEGREE);
+        sprintf(zone_, "%d%c", ZoneNumber, letter);
+      }
+
+    double LatRad = lat*RADIANS_PER_DEGREE;
+    double LongRad = LongTemp*RADIANS_PER_DEGREE;
+
+    double slat = sin(LatRad);
+    double clat = cos(LatRad);
+    double tlat = slat/clat;
+
+    double N = WGS84_A/sqrt(1-UTM_E2*slat*slat);
+    double T = tlat*tlat;
+    double C = UTM_EP2*clat*clat;
+    double A = clat*(LongRad-long_origin_rad_);
+
+    double M = WGS84_A*(m0*LatRad + m1*sin(2*LatRad)
+                        + m2*sin(4*LatRad) + m3*sin(6*LatRad));
+
+    double A2 = A*A;
+    double A4 = A2*A2;
+
+    easting = (UTM_K0*N*(A + (1-T+C)*A2*A/6
+                         + (5-18*T+T*T+72*C-58*UTM_EP2)*A4*A/120)
+               + UTM_FE);
+
+    northing = UTM_K0*(M + N*tlat
+                       *(A2/2 + (5-T+9*C+4*C*C)*A4/24
+                         + (61-58*T+T*T+600*C-330*UTM_EP2)*A4*A2/720));
+
+    if (lat < 0)
+      {
+        // 10000000 meter offset for southern hemisphere
+        northing += UTM_FN_S;
+      }
+  }
+
+  /** Convert one fix through a local tangent-plane linearization.
+   *
+   *  Linearizes the projection around a cached origin, reducing the
+   *  per-fix cost to two multiply-adds per coordinate.  The origin
+   *  and its Jacobian (central differences of the exact projection)
+   *  are recomputed whenever the fix moves more than about 500 m from
+   *  the cached origin; within that radius the linearization error is
+   *  a few centimeters, well below GPS accuracy.  Fixes near a UTM
+   *  zone boundary, or in the latitudes with special zone rules, fall
+   *  back to the exact conversion automatically.
+   */
+  void convert_local(double lat, double lon,
+                     double &northing, double &easting)
+  {
+    const double radius_deg = 0.005;	// ~500 m of latitude
+    const double fd_step = 1e-4;	// finite difference step (~11 m)
+
+    if (local_valid_
+        && fabs(lat - origin_lat_) < radius_deg
+        && fabs(lon - origin_lon_) < lon_radius_deg_)
+      {
+        double dlat = lat - origin_lat_;
+        double dlon = lon - origin_lon_;
+        northing = origin_n_ + dn_dlat_*dlat + dn_dlon_*dlon;
+        easting  = origin_e_ + de_dlat_*dlat + de_dlon_*dlon;
+        return;
+      }
+
+    local_valid_ = false;
+
+    // Stay on the exact path close to a zone edge (the refresh radius
+    // plus the difference step could reach across it) and in the
+    // latitudes where the Norway and Svalbard exceptions bend the
+    // boundaries.
+    double LongTemp = (lon+180)-int((lon+180)/360)*360-180;
+    double in_zone = (LongTemp + 180) - 6.0*int((LongTemp + 180)/6);
+    double margin = radius_deg + fd_step;
+    if (fabs(lat) >= 56.0 || in_zone < margin || in_zone > 6.0 - margin)
+      {
+        convert(lat, lon, northing, easting);
+        return;
+      }
+
+    // re-linearize around this fix
+    double n1, e1, n2, e2;
+    convert(lat+fd_step, lon, n1, e1);
+    convert(lat-fd_step, lon, n2, e2);
+    dn_dlat_ = (n1-n2)/(2*fd_step);
+    de_dlat_ = (e1-e2)/(2*fd_step);
+    convert(lat, lon+fd_step, n1, e1);
+    convert(lat, lon-fd_step, n2, e2);
+    dn_dlon_ = (n1-n2)/(2*fd_step);
+    de_dlon_ = (e1-e2)/(2*fd_step);
+    convert(lat, lon, northing, easting);
+
+    origin_lat_ = lat;
+    origin_lon_ = lon;
+    origin_n_ = northing;
+    origin_e_ = easting;
+    lon_radius_deg_ = radius_deg / cos(lat*RADIANS_PER_DEGREE);
+    local_valid_ = true;
+  }
+
+  /** Convert a whole array of fixes in one call. */
+  void convert(const double *lat, const double *lon,
+               double *northing, double *easting, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      convert(lat[i], lon[i], northing[i], easting[i]);
+  }
+
+  /** Zone designator of the most recently converted point. */
+  const char *zone() const {return zone_;}
+
+private:
+  int zone_number_;			// cached UTM zone number
+  char zone_letter_;			// cached latitude band letter
+  double long_origin_rad_;		// central meridian of cached zone
+  char zone_[8];			// zone designator string
+
+  // local tangent-plane linearization state (convert_local)
+  bool local_valid_;			// linearization usable
+  double origin_lat_, origin_lon_;	// linearization origin
+  double origin_n_, origin_e_;		// origin in UTM coordinates
+  double dn_dlat_, dn_dlon_;		// Jacobian at the origin
+  double de_dlat_, de_dlon_;
+  double lon_radius_deg_;		// refresh radius in longitude
+};
+
+/**
+ * Converts UTM coords to lat/long.  Equations from USGS Bulletin 1532
  *
  * East Longitudes are positive, West longitudes are negative. 
  * North latitudes are positive, South latitudes are negative
@@ -288,6 +474,157 @@ static inline void UTMtoLL(const double UTMNorthing, const double UTMEasting,
 	Long = LongOrigin + Long * DEGREES_PER_RADIAN;
 
 }
+
+/**
+ * Converter caching per-zone constants for repeated UTMtoLL() calls.
+ *
+ * UTMtoLL() re-parses the zone designator string and recomputes the
+ * central meridian on every call.  This class parses the zone once
+ * while successive points stay in the same zone, and offers a batch
+ * interface for converting whole arrays of poses, so telemetry can
+ * stream geodetic positions computed on-vehicle.  Results match
+ * UTMtoLL() to floating point round-off.
+ */
+class UTMInverseConverter
+{
+public:
+  UTMInverseConverter()
+  {
+    zone_[0] = '\0';
+    long_origin_ = 0.0;
+    south_offset_ = 0.0;
+    local_valid_ = false;
+    origin_n_ = origin_e_ = 0.0;
+    origin_lat_ = origin_lon_ = 0.0;
+    dlat_dn_ = dlat_de_ = dlon_dn_ = dlon_de_ = 0.0;
+  }
+
+  /** Convert one UTM northing and easting to a lat/long fix. */
+  void convert(double northing, double easting, const char *zone,
+               double &lat, double &lon)
+  {
+    // inverse meridional arc series coefficients, computed once
+    static const double e1 = ((1-sqrt(1-UTM_E2))/(1+sqrt(1-UTM_E2)));
+    static const double j1 = (3*e1/2 - 27*e1*e1*e1/32);
+    static const double j2 = (21*e1*e1/16 - 55*e1*e1*e1*e1/32);
+    static const double j3 = (151*e1*e1*e1/96);
+    static const double mu0 = (1 - UTM_E2/4 - 3*UTM_E4/64 - 5*UTM_E6/256);
+
+    // fast path: skip the zone parse while successive points stay
+    // within the cached zone
+    if (strcmp(zone, zone_) != 0)
+      {
+        char *letter;
+        int zone_number = strtoul(zone, &letter, 10);
+        // +3 puts origin in middle of zone
+        long_origin_ = (zone_number - 1)*6 - 180 + 3;
+        south_offset_ = ((*letter - 'N') < 0)? UTM_FN_S: UTM_FN_N;
+        strncpy(zone_, zone, sizeof(zone_) - 1);
+        zone_[sizeof(zone_) - 1] = '\0';
+        local_valid_ = false;
+      }
+
+    double x = easting - UTM_FE;
+    double y = northing - south_offset_;
+
+    double mu = y / (UTM_K0 * WGS84_A * mu0);
+    double phi1 = mu + j1*sin(2*mu) + j2*sin(4*mu) + j3*sin(6*mu);
+
+    double sphi = sin(phi1);
+    double cphi = cos(phi1);
+    double tphi = sphi/cphi;
+
+    double ess = 1 - UTM_E2*sphi*sphi;
+    double N1 = WGS84_A/sqrt(ess);
+    double T1 = tphi*tphi;
+    double C1 = UTM_EP2*cphi*cphi;
+    double R1 = WGS84_A*(1-UTM_E2)/(ess*sqrt(ess));
+    double D = x/(N1*UTM_K0);
+
+    double D2 = D*D;
+    double D4 = D2*D2;
+
+    lat = phi1 - ((N1*tphi/R1)
+                  *(D2/2
+                    - (5+3*T1+10*C1-4*C1*C1-9*UTM_EP2)*D4/24
+                    + (61+90*T1+298*C1+45*T1*T1-252*UTM_EP2
+                       -3*C1*C1)*D4*D2/720));
+    lat = lat * DEGREES_PER_RADIAN;
+
+    lon = ((D - (1+2*T1+C1)*D2*D/6
+            + (5-2*C1+28*T1-3*C1*C1+8*UTM_EP2+24*T1*T1)*D4*D/120)
+           / cphi);
+    lon = long_origin_ + lon * DEGREES_PER_RADIAN;
+  }
+
+  /** Convert one pose through a local tangent-plane linearization.
+   *
+   *  Linearizes the inverse projection around a cached origin,
+   *  reducing the per-pose cost to two multiply-adds per coordinate.
+   *  The origin and its Jacobian (central differences of the exact
+   *  conversion) are recomputed whenever the pose moves more than
+   *  500 m from the cached origin; within that radius the
+   *  linearization error is a few centimeters, well below GPS
+   *  accuracy.  The zone is given explicitly, so no boundary fallback
+   *  is needed here.
+   */
+  void convert_local(double northing, double easting, const char *zone,
+                     double &lat, double &lon)
+  {
+    const double radius = 500.0;	// re-linearization radius (m)
+    const double fd_step = 100.0;	// finite difference step (m)
+
+    if (local_valid_
+        && strcmp(zone, zone_) == 0
+        && fabs(northing - origin_n_) < radius
+        && fabs(easting - origin_e_) < radius)
+      {
+        double dn = northing - origin_n_;
+        double de = easting - origin_e_;
+        lat = origin_lat_ + dlat_dn_*dn + dlat_de_*de;
+        lon = origin_lon_ + dlon_dn_*dn + dlon_de_*de;
+        return;
+      }
+
+    // re-linearize around this pose
+    double lat1, lon1, lat2, lon2;
+    convert(northing+fd_step, easting, zone, lat1, lon1);
+    convert(northing-fd_step, easting, zone, lat2, lon2);
+    dlat_dn_ = (lat1-lat2)/(2*fd_step);
+    dlon_dn_ = (lon1-lon2)/(2*fd_step);
+    convert(northing, easting+fd_step, zone, lat1, lon1);
+    convert(northing, easting-fd_step, zone, lat2, lon2);
+    dlat_de_ = (lat1-lat2)/(2*fd_step);
+    dlon_de_ = (lon1-lon2)/(2*fd_step);
+    convert(northing, easting, zone, lat, lon);
+
+    origin_n_ = northing;
+    origin_e_ = easting;
+    origin_lat_ = lat;
+    origin_lon_ = lon;
+    local_valid_ = true;
+  }
+
+  /** Convert a whole array of poses in one call. */
+  void convert(const double *northing, const double *easting,
+               const char *zone, double *lat, double *lon, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      convert(northing[i], easting[i], zone, lat[i], lon[i]);
+  }
+
+private:
+  char zone_[8];			// cached zone designator string
+  double long_origin_;			// central meridian of cached zone
+  double south_offset_;			// false northing of cached zone
+
+  // local tangent-plane linearization state (convert_local)
+  bool local_valid_;			// linearization usable
+  double origin_n_, origin_e_;		// linearization origin
+  double origin_lat_, origin_lon_;	// origin in geodetic coordinates
+  double dlat_dn_, dlat_de_;		// Jacobian at the origin
+  double dlon_dn_, dlon_de_;
+};
 } // end namespace UTM
 
 #endif // _UTM_H
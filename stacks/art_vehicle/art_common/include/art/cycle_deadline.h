@@ -0,0 +1,149 @@
+/* -*- mode: C++ -*-
+ *
+ *  ART cycle deadline monitor
+ *
+ *  Copyright (C) 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef _CYCLE_DEADLINE_H_
+#define _CYCLE_DEADLINE_H_
+
+#include <math.h>
+#include <time.h>
+
+#include <ros/ros.h>
+
+/** @file
+
+    @brief monotonic cycle deadline monitor.
+
+    Tracks the real-time performance of a fixed-rate control loop
+    using the monotonic clock, which neither jumps nor slews with
+    wall-clock adjustments.  Accumulates jitter and overrun statistics
+    so missed deadlines show up in logs and diagnostics instead of
+    only in vehicle behavior.
+*/
+
+class CycleDeadline
+{
+ public:
+
+  /** @brief Constructor
+   *
+   *  @param hertz expected cycle rate of the loop
+   */
+  CycleDeadline(double hertz)
+  {
+    period_ = 1.0 / hertz;
+    cycles_ = 0;
+    misses_ = 0;
+    total_jitter_ = 0.0;
+    max_duration_ = 0.0;
+    last_duration_ = 0.0;
+    have_start_ = false;
+    start_ = 0.0;
+  }
+
+  /** @brief mark the start of a control cycle */
+  void begin(void)
+  {
+    double start = now();
+    if (have_start_)
+      {
+	// accumulate start-to-start jitter relative to the period
+	total_jitter_ += fabs((start - start_) - period_);
+      }
+    start_ = start;
+    have_start_ = true;
+  }
+
+  /** @brief mark the end of a control cycle
+   *
+   *  @return true if this cycle overran its deadline
+   */
+  bool end(void)
+  {
+    if (!have_start_)
+      return false;
+
+    double duration = now() - start_;
+    ++cycles_;
+    last_duration_ = duration;
+    if (duration > max_duration_)
+      max_duration_ = duration;
+
+    bool missed = (duration > period_);
+    if (missed)
+      ++misses_;
+    return missed;
+  }
+
+  /** @brief change the expected cycle rate
+   *
+   *  @param hertz new cycle rate of the loop
+   *
+   *  For loops whose rate is configurable at startup, after the
+   *  monitor was constructed with the compiled-in default.
+   */
+  void set_rate(double hertz)
+  {
+    period_ = 1.0 / hertz;
+  }
+
+  /** @brief duration of the most recent cycle (seconds) */
+  double last_duration(void) const {return last_duration_;}
+
+  /** @brief number of completed cycles */
+  unsigned long cycles(void) const {return cycles_;}
+
+  /** @brief number of cycles that overran the deadline */
+  unsigned long misses(void) const {return misses_;}
+
+  /** @brief longest cycle duration seen (seconds) */
+  double max_duration(void) const {return max_duration_;}
+
+  /** @brief mean start-to-start jitter (seconds) */
+  double mean_jitter(void) const
+  {
+    if (cycles_ == 0)
+      return 0.0;
+    return total_jitter_ / cycles_;
+  }
+
+  /** @brief log accumulated deadline statistics
+   *
+   *  @param name loop name for the log message
+   */
+  void log_summary(const char *name) const
+  {
+    ROS_INFO("%s deadline statistics: %lu of %lu cycles missed "
+	     "%.1fms deadline, max %.3fms, mean jitter %.3fms",
+	     name, misses_, cycles_, period_ * 1e3,
+	     max_duration_ * 1e3, mean_jitter() * 1e3);
+  }
+
+ private:
+
+  /** @brief return monotonic time in seconds */
+  static double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+  }
+
+  double period_;			//< expected cycle period (sec)
+  unsigned long cycles_;		//< completed cycles
+  unsigned long misses_;		//< cycles exceeding the period
+  double total_jitter_;			//< accumulated period jitter (sec)
+  double max_duration_;			//< longest cycle duration (sec)
+  double last_duration_;		//< most recent cycle duration (sec)
+  bool have_start_;			//< begin() called at least once
+  double start_;			//< start of current cycle (sec)
+};
+
+#endif // _CYCLE_DEADLINE_H_
@@ -42,4 +42,94 @@ static inline float EWMA_smoothing(int N)
   return 2.0/(N + 1.0);
 }
 
+/**
+ * Multi-channel EWMA filter bank.
+ *
+ * Holds the filter state for NCHAN channels in contiguous arrays and
+ * updates every channel with one call, so a driver smoothing several
+ * related signals pays a single short loop the compiler can
+ * vectorize instead of per-channel function calls.  The channel
+ * count is a compile-time constant.
+ *
+ * Each channel has its own smoothing factor, interpreted as in
+ * EWMA_filter(); a factor of 1.0 (the default) passes that channel
+ * through unfiltered.  The first update of a channel primes its
+ * state with the input, so filters start from the first observation
+ * rather than from zero.
+ */
+template <int NCHAN>
+class EWMAFilterBank
+{
+public:
+  EWMAFilterBank()
+  {
+    for (int i = 0; i < NCHAN; ++i)
+      {
+	a_[i] = 1.0f;			// default: no smoothing
+	y_[i] = 0.0f;
+	primed_[i] = false;
+      }
+  }
+
+  /** set the smoothing factor of every channel */
+  void set_smoothing(float a)
+  {
+    for (int i = 0; i < NCHAN; ++i)
+      a_[i] = a;
+  }
+
+  /** set the smoothing factor of one channel */
+  void set_smoothing(int channel, float a)
+  {
+    a_[channel] = a;
+  }
+
+  /** reset filter state, the next update primes each channel */
+  void reset(void)
+  {
+    for (int i = 0; i < NCHAN; ++i)
+      primed_[i] = false;
+  }
+
+  /** update all channels in place from one contiguous input array */
+  void update(float *x)
+  {
+    for (int i = 0; i < NCHAN; ++i)
+      {
+	if (primed_[i])
+	  y_[i] = a_[i]*x[i] + (1.0f - a_[i])*y_[i];
+	else
+	  {
+	    y_[i] = x[i];
+	    primed_[i] = true;
+	  }
+	x[i] = y_[i];
+      }
+  }
+
+  /** update a single channel, sharing state with update()
+   *
+   *  for producers that acquire their channels one at a time
+   */
+  float update(int channel, float x)
+  {
+    if (primed_[channel])
+      y_[channel] = a_[channel]*x + (1.0f - a_[channel])*y_[channel];
+    else
+      {
+	y_[channel] = x;
+	primed_[channel] = true;
+      }
+    return y_[channel];
+  }
+
+  /** last output of one channel */
+  float value(int channel) const {return y_[channel];}
+
+private:
+  float a_[NCHAN];			// per-channel smoothing factors
+  float y_[NCHAN];			// per-channel filter state
+  bool	primed_[NCHAN];			// channel state initialized
+};
+
 #endif /* _FILTER_H */
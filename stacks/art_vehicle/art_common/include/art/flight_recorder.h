@@ -0,0 +1,232 @@
+/* -*- mode: C++ -*-
+ *
+ *  ART flight recorder: binary hot-loop trace ring buffers
+ *
+ *  Copyright (C) 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef _FLIGHT_RECORDER_H_
+#define _FLIGHT_RECORDER_H_
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/** @file
+
+    @brief always-on binary tracing for real-time control loops.
+
+    ROS_DEBUG formatting is too expensive for per-cycle use in the
+    control loops, so it gets compiled out or disabled in production,
+    leaving no trace of the moments leading up to an incident.  The
+    flight recorder keeps a small per-thread ring buffer of
+    fixed-size binary records instead: recording one costs a
+    monotonic clock read and a few stores, no formatting and no
+    locks, so the trace points can stay enabled on the vehicle.
+
+    Formatting happens only when the rings are dumped: on request via
+    dump(), on SIGUSR1, or from a fault handler just before the
+    process dies.  Each ring holds the most recent RING_RECORDS
+    events of its thread; older history is overwritten.
+
+    Record an event with the ART_RECORD macros:
+
+      ART_RECORD2("pilot cmd", cmd.velocity, cmd.angle);
+
+    The label must be a string literal (or otherwise outlive the
+    process): records store the pointer, not a copy.
+*/
+
+class FlightRecorder
+{
+ public:
+
+  // records per thread ring, must be a power of two
+  enum { RING_RECORDS = 4096 };
+
+  /** one fixed-size trace record */
+  struct Record
+  {
+    uint64_t stamp_ns;			//< monotonic time stamp
+    const char *label;			//< static label of the trace point
+    uint32_t count;			//< number of valid values
+    double v[4];			//< trace point values
+  };
+
+  /** @brief record one event in the calling thread's ring
+   *
+   *  Lock-free: each thread writes only its own ring.  A concurrent
+   *  dump may read the record being overwritten torn, which is
+   *  acceptable for incident forensics.
+   */
+  static void record(const char *label, unsigned count,
+		     double a = 0.0, double b = 0.0,
+		     double c = 0.0, double d = 0.0)
+  {
+    Ring *r = ring();
+    Record &rec = r->records[r->head & (RING_RECORDS - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    rec.stamp_ns = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    rec.label = label;
+    rec.count = count;
+    rec.v[0] = a;
+    rec.v[1] = b;
+    rec.v[2] = c;
+    rec.v[3] = d;
+    ++r->head;				// publish the record last
+  }
+
+  /** @brief dump all rings to a file
+   *
+   *  @param path output file name, NULL for the default
+   *              /tmp/flight_recorder.<pid>.log
+   *
+   *  Records are written per thread, oldest first.  Writers keep
+   *  running while the dump proceeds, so the newest few records of a
+   *  busy thread may be missing or torn.
+   */
+  static void dump(const char *path = NULL)
+  {
+    char default_path[64];
+    if (path == NULL)
+      {
+	snprintf(default_path, sizeof(default_path),
+		 "/tmp/flight_recorder.%d.log", (int) getpid());
+	path = default_path;
+      }
+    FILE *f = fopen(path, "w");
+    if (f == NULL)
+      return;
+
+    Global &g = global();
+    pthread_mutex_lock(&g.lock);
+    for (Ring *r = g.rings; r != NULL; r = r->next)
+      {
+	uint32_t head = r->head;
+	uint32_t n = (head < RING_RECORDS? head: (uint32_t) RING_RECORDS);
+	fprintf(f, "=== thread %lu: %u records ===\n",
+		(unsigned long) r->thread, n);
+	for (uint32_t i = head - n; i != head; ++i)
+	  {
+	    const Record &rec = r->records[i & (RING_RECORDS - 1)];
+	    if (rec.label == NULL)
+	      continue;			// torn or never written
+	    fprintf(f, "%llu.%09llu %s",
+		    (unsigned long long) (rec.stamp_ns / 1000000000ULL),
+		    (unsigned long long) (rec.stamp_ns % 1000000000ULL),
+		    rec.label);
+	    for (uint32_t k = 0; k < rec.count && k < 4; ++k)
+	      fprintf(f, " %.6g", rec.v[k]);
+	    fputc('\n', f);
+	  }
+      }
+    pthread_mutex_unlock(&g.lock);
+    fclose(f);
+  }
+
+  /** @brief install the dump signal handlers
+   *
+   *  SIGUSR1 dumps the rings and continues.  SIGSEGV, SIGBUS, SIGFPE
+   *  and SIGABRT dump the rings, then restore the default handler
+   *  and re-raise, so the usual core dump still happens.  Call once
+   *  from the node's main thread after startup.
+   */
+  static void install_handlers(void)
+  {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = &FlightRecorder::fault_handler;
+    sigaction(SIGSEGV, &sa, NULL);
+    sigaction(SIGBUS, &sa, NULL);
+    sigaction(SIGFPE, &sa, NULL);
+    sigaction(SIGABRT, &sa, NULL);
+    sa.sa_handler = &FlightRecorder::request_handler;
+    sigaction(SIGUSR1, &sa, NULL);
+  }
+
+ private:
+
+  /** one thread's ring buffer */
+  struct Ring
+  {
+    Record records[RING_RECORDS];
+    volatile uint32_t head;		//< next slot, monotonic
+    pthread_t thread;			//< owning thread
+    Ring *next;				//< global ring list link
+  };
+
+  /** global list of all thread rings */
+  struct Global
+  {
+    pthread_mutex_t lock;
+    Ring *rings;
+  };
+
+  static Global &global(void)
+  {
+    static Global g = {PTHREAD_MUTEX_INITIALIZER, NULL};
+    return g;
+  }
+
+  /** @brief return the calling thread's ring, creating it on first use
+   *
+   *  Creation takes the global lock once per thread; every later
+   *  record() is lock-free.
+   */
+  static Ring *ring(void)
+  {
+    static __thread Ring *tls = NULL;
+    if (tls == NULL)
+      {
+	Ring *r = new Ring;
+	memset(r->records, 0, sizeof(r->records));
+	r->head = 0;
+	r->thread = pthread_self();
+	Global &g = global();
+	pthread_mutex_lock(&g.lock);
+	r->next = g.rings;
+	g.rings = r;
+	pthread_mutex_unlock(&g.lock);
+	tls = r;
+      }
+    return tls;
+  }
+
+  /** fatal signal: dump the rings, then die the normal way */
+  static void fault_handler(int sig)
+  {
+    dump();
+    signal(sig, SIG_DFL);
+    raise(sig);
+  }
+
+  /** SIGUSR1: dump the rings on request and keep running */
+  static void request_handler(int sig)
+  {
+    dump();
+  }
+};
+
+/** record a trace event with zero to four numeric values */
+#define ART_RECORD0(label) \
+  FlightRecorder::record((label), 0)
+#define ART_RECORD1(label, a) \
+  FlightRecorder::record((label), 1, (double)(a))
+#define ART_RECORD2(label, a, b) \
+  FlightRecorder::record((label), 2, (double)(a), (double)(b))
+#define ART_RECORD3(label, a, b, c) \
+  FlightRecorder::record((label), 3, (double)(a), (double)(b), (double)(c))
+#define ART_RECORD4(label, a, b, c, d) \
+  FlightRecorder::record((label), 4, (double)(a), (double)(b), \
+			 (double)(c), (double)(d))
+
+#endif // _FLIGHT_RECORDER_H_
@@ -17,6 +17,7 @@
  */
 
 #include <float.h>
+#include <math.h>
 #include <ros/ros.h>
 
 /** @brief PID (Proportional, Integral, Derivative) control output. */
@@ -197,4 +198,117 @@ class Pid
 
 };
 
+/** @brief PID control output with filtered derivative and clamped
+ *         integrator.
+ *
+ *  Drop-in alternative to Pid with the same Configure(), Update(),
+ *  Clear() and CopyHistory() interface.  Differences:
+ *
+ *   - output saturation uses fminf()/fmaxf(), which compile to
+ *     min/max instructions instead of conditional jumps;
+ *   - the derivative term passes through a first-order low-pass
+ *     (parameter df, fraction of each new sample, 1.0 = unfiltered),
+ *     so measurement noise does not kick the output;
+ *   - anti-windup clamps the integrator magnitude directly
+ *     (parameter imax) instead of the C tracking heuristic.
+ *
+ *  The defaults (df 1.0, imax FLT_MAX) reproduce an unfiltered,
+ *  unclamped controller, so existing gains remain valid starting
+ *  points when switching.
+ */
+class FilteredPid: public Pid
+{
+ public:
+
+  /** @brief Constructor
+   *  @param ctlname control output name for log messages
+   */
+  FilteredPid(const char *ctlname):
+    Pid(ctlname), df(1.0), imax(FLT_MAX), dfiltered(0.0)
+    {};
+
+  FilteredPid(const char *ctlname, float kp, float ki, float kd,
+              float omax=FLT_MAX, float omin=-FLT_MAX,
+              float df=1.0, float imax=FLT_MAX):
+    Pid(ctlname, kp, ki, kd, omax, omin, 0.0),
+    df(df), imax(imax), dfiltered(0.0)
+    {};
+
+  virtual ~FilteredPid() {};
+
+  /** @brief Configure PID parameters */
+  virtual void Configure(const ros::NodeHandle &node)
+  {
+    Pid::Configure(node);
+    CfgParam(node, "df", &this->df);
+    CfgParam(node, "imax", &this->imax);
+    ROS_DEBUG("%s derivative filter %.3f, integrator limit %.1f",
+              this->name.c_str(), this->df, this->imax);
+  };
+
+  /** @brief Update PID control output.
+   *  @param error current output error
+   *  @param output current output level
+   *  @returns recommended change in output
+   */
+  float Update(float error, float output)
+  {
+    if (starting)
+      {
+        this->istate = 0;
+        this->dstate = output;
+        this->dfiltered = 0;
+        starting = false;
+      }
+
+    // Proportional term
+    float p = this->kp * error;
+
+    // Derivative term, low-pass filtered
+    this->dfiltered += this->df * ((output - this->dstate)
+                                   - this->dfiltered);
+    this->dstate = output;
+    float d = this->kd * this->dfiltered;
+
+    float i = this->ki * this->istate;
+
+    float PID_control = (p + i - d);
+
+    ROS_DEBUG("%s PID: %.3f = %.3f + %.3f - %.3f",
+              this->name.c_str(), PID_control, p, i, d);
+
+    // branch-free output saturation
+    float PID_out = fminf(this->omax, fmaxf(this->omin, PID_control));
+
+    // Integral term -- anti-windup by clamping the integrator
+    // magnitude directly, also branch-free.
+    this->istate = fminf(this->imax,
+                         fmaxf(-this->imax, this->istate + error));
+
+    if (isnan(istate) || isinf(istate))
+      istate = 0;
+
+    ROS_DEBUG("%s istate = %.3f, PID_out: %.3f",
+              this->name.c_str(), istate, PID_out);
+
+    return PID_out;
+  }
+
+  /** @brief Copy the error history from another filtered PID
+   *
+   *  @param pid The PID controller that has the history to copy
+   */
+  void CopyHistory(const FilteredPid* pid)
+  {
+    Pid::CopyHistory(pid);
+    this->dfiltered = pid->dfiltered;
+  }
+
+ protected:
+
+  float df;                     /**< derivative filter coefficient */
+  float imax;                   /**< integrator magnitude limit */
+  float dfiltered;              /**< filtered derivative state */
+};
+
 #endif // _PID_H_ //
@@ -74,16 +74,29 @@ class Polynomial
    */
   float inline value(const float x)
   {
-    float retval = 0.0;
-    float pow = 1.0;
-    for (unsigned i = 0; i < coef.size(); ++i)
-      {
-	retval += pow * coef.at(i);
-	pow *= x;
-      }
+    // Horner's scheme: one multiply and add per coefficient, reading
+    // the raw array directly to skip the at() range checks
+    unsigned n = coef.size();
+    if (n == 0)
+      return 0.0;
+    const float *c = &coef[0];
+    float retval = c[n-1];
+    for (unsigned i = n-1; i > 0; --i)
+      retval = retval * x + c[i-1];
     return retval;
   }
 
+  /** @brief evaluate polynomial at an array of points
+   * @param x array of points at which to evaluate
+   * @param y array receiving the corresponding values
+   * @param n number of points in each array
+   */
+  void inline value(const float *x, float *y, unsigned n)
+  {
+    for (unsigned i = 0; i < n; ++i)
+      y[i] = value(x[i]);
+  }
+
   // coef[i] applies to the x**i term
   std::vector<float> coef;             /**< polynomial coefficients */
 
@@ -93,4 +106,80 @@ protected:
 
 };
 
+/** @brief uniformly-spaced lookup table sampled from a polynomial
+ *
+ *  Built once at startup, so each cycle-rate conversion reduces to
+ *  one index computation and a linear interpolation between adjacent
+ *  table entries, instead of evaluating the polynomial.
+ *
+ *  The samples are checked for strict monotonicity when the table is
+ *  built: a calibration fit that doubles back within the operating
+ *  range is not a valid sensor mapping.  If the check fails, or an
+ *  input falls outside the sampled range, value() falls back to
+ *  direct polynomial evaluation.
+ */
+class PolyTable
+{
+ public:
+
+  PolyTable(): poly(NULL), ready(false) {}
+
+  /** @brief sample a polynomial over an input range
+   *
+   *  @param p polynomial to tabulate (must outlive this table)
+   *  @param xmin lower end of input range
+   *  @param xmax upper end of input range
+   *  @param n number of table entries
+   *  @returns true if the samples are strictly monotone and the
+   *           table is ready for use
+   */
+  bool create(Polynomial *p, float xmin, float xmax, unsigned n=256)
+  {
+    poly = p;
+    ready = false;
+    if (n < 2 || xmax <= xmin)
+      return false;
+
+    this->xmin = xmin;
+    scale = (n - 1) / (xmax - xmin);
+    y.resize(n);
+    for (unsigned i = 0; i < n; ++i)
+      y[i] = poly->value(xmin + i / scale);
+
+    // require strictly monotone samples, in either direction
+    bool increasing = (y[1] > y[0]);
+    for (unsigned i = 1; i < n; ++i)
+      {
+	if (increasing? (y[i] <= y[i-1]): (y[i] >= y[i-1]))
+	  return false;			// not a valid sensor mapping
+      }
+
+    ready = true;
+    return true;
+  }
+
+  /** @brief look up the polynomial value at a point
+   *  @param x point at which to evaluate
+   */
+  float inline value(const float x)
+  {
+    float fi = (x - xmin) * scale;
+    if (!ready || fi < 0.0 || fi > (float) (y.size() - 1))
+      return poly->value(x);		// outside table, evaluate
+    unsigned i = (unsigned) fi;
+    if (i >= y.size() - 1)
+      i = y.size() - 2;
+    float frac = fi - i;
+    return y[i] + frac * (y[i+1] - y[i]);
+  }
+
+ private:
+
+  Polynomial *poly;			/**< tabulated polynomial */
+  bool ready;				/**< table built and monotone */
+  float xmin;				/**< lower end of input range */
+  float scale;				/**< entries per unit of input */
+  std::vector<float> y;			/**< sampled values */
+};
+
 #endif // _POLYNOMIAL_HH_ //
@@ -0,0 +1,158 @@
+/* -*- mode: C++ -*-
+ *
+ *  Description:  shared control-time pose prediction
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef _POSE_PREDICT_H
+#define _POSE_PREDICT_H
+
+#include <math.h>
+#include <angles/angles.h>
+#include <nav_msgs/Odometry.h>
+#include <tf/tf.h>
+
+#include <art/epsilon.h>
+#include <art/steering.h>
+
+/** @brief
+ *
+ * Shared control-time pose prediction.
+ *
+ * The navigator and pilot both act on the most recent odometry
+ * message, which is one or two control cycles stale by the time their
+ * commands reach the actuators.  These functions extrapolate pose and
+ * velocity to a requested future time, so a controller can command
+ * the vehicle it will have then, not the one it last heard about.
+ */
+
+namespace PosePredict
+{
+
+  /** Predict speed a short time ahead.
+   *
+   *  @param speed current speed (m/s, non-negative)
+   *  @param accel current longitudinal acceleration (m/s^2, signed)
+   *  @param dt prediction interval (seconds)
+   *  @return predicted speed, never below zero: braking stops the
+   *          vehicle, it does not reverse it.
+   */
+  static inline float predict_speed(float speed, float accel, double dt)
+  {
+    return fmaxf(0.0, speed + accel * dt);
+  }
+
+  /** Predict odometry at a future time.
+   *
+   * This is inherently a two-dimensional calculation, assuming
+   * constant covariance, velocity and yaw rate.
+   *
+   * @param[in] odom odometry on which to base prediction, with time stamp
+   * @param est_time time for which predicted odometry desired
+   * @param est predicted odometry for time in @a est.header.stamp
+   *
+   * @todo Extrapolate speed and yaw rate using change from last
+   * cycle.  Use average of current and estimated derivatives to
+   * estimate control position.  When the car is accelerating, look
+   * farther ahead.
+   */
+  static inline void predict(const nav_msgs::Odometry &odom,
+                             ros::Time est_time,
+                             nav_msgs::Odometry &est)
+  {
+    // copy entire odom message, set predicted time stamp
+    // (with covariance, z dimension, velocity and yaw rate)
+    est = odom;
+    est.header.stamp = est_time;
+
+    if (odom.header.stamp == ros::Time() || est_time == ros::Time())
+      {
+        ROS_WARN_STREAM("invalid prediction time stamp, odom: "
+                        << odom.header.stamp
+                        << ", est_time: " << est_time);
+        return;                         // return unmodified odom
+      }
+
+    double dt = est_time.toSec() - odom.header.stamp.toSec();
+    if (dt < 0.0 || dt > 1.0)
+      {
+        ROS_WARN("bogus delta time for prediction: %.3f", dt);
+        return;                         // return unmodified odom
+      }
+
+    // Refine pose estimate based on last reported velocity and yaw
+    // rate: how far has the car travelled and its heading changed?
+
+    double odom_yaw = tf::getYaw(odom.pose.pose.orientation);
+    double odom_yawrate = odom.twist.twist.angular.z;
+    double est_dist = odom.twist.twist.linear.x * dt;
+    double est_yaw = angles::normalize_angle(odom_yaw
+                                             + odom_yawrate * dt);
+    if (fabs(odom_yawrate) < Epsilon::yaw)
+      {
+	// estimate straight line path at current velocity and heading
+	est.pose.pose.position.x = (odom.pose.pose.position.x
+                                    + est_dist * cos(odom_yaw));
+	est.pose.pose.position.y = (odom.pose.pose.position.y
+                                    + est_dist * sin(odom_yaw));
+
+        ROS_DEBUG("predicted straight path distance = %.3f", est_dist);
+      }
+    else					// turning
+      {
+	// Car is turning. Estimate circular path [see: _Probabilistic
+	// Robotics_, Thrun, Burgard and Fox, ISBN 0-262-20162-3,
+	// 2005; section 5.3.3, exact motion model, pp. 125-127].
+	double est_radius = est_dist / odom_yawrate;
+	est.pose.pose.position.x = (odom.pose.pose.position.x
+                                    - est_radius * sin(odom_yaw)
+                                    + est_radius * sin(est_yaw));
+	est.pose.pose.position.y = (odom.pose.pose.position.y
+                                    + est_radius * cos(odom_yaw)
+                                    - est_radius * cos(est_yaw));
+
+        ROS_DEBUG("predicted path distance = %.3f, radius = %.3f",
+		  est_dist, est_radius);
+      }
+
+    ROS_DEBUG("predicted control pose = (%.3f, %.3f, %.3f)",
+	      est.pose.pose.position.x,
+	      est.pose.pose.position.y,
+              est_yaw);
+
+    // @todo Preserve roll and pitch in the predicted quaternion.
+    // This implementation sets them to zero, which does not matter
+    // for the current navigator logic.
+    est.pose.pose.orientation = tf::createQuaternionMsgFromYaw(est_yaw);
+  }
+
+  /** Predict odometry at a future time from the vehicle model.
+   *
+   * Like predict(), but the yaw rate comes from the current speed and
+   * steering angle through the bicycle-model kinematics the simulated
+   * vehicle uses, instead of the odometry yaw rate, which lags the
+   * front wheels by the vehicle's yaw response.
+   *
+   * @param[in] odom odometry on which to base prediction, with time stamp
+   * @param steering_angle current steering angle (degrees)
+   * @param est_time time for which predicted odometry desired
+   * @param est predicted odometry for time in @a est.header.stamp
+   */
+  static inline void predict_steering(const nav_msgs::Odometry &odom,
+                                      float steering_angle,
+                                      ros::Time est_time,
+                                      nav_msgs::Odometry &est)
+  {
+    nav_msgs::Odometry kin = odom;
+    kin.twist.twist.angular.z =
+      Steering::angle_to_yaw(odom.twist.twist.linear.x, steering_angle);
+    predict(kin, est_time, est);
+  }
+
+}
+
+#endif // _POSE_PREDICT_H
@@ -0,0 +1,199 @@
+/* -*- mode: C++ -*-
+ *
+ *  ART section profiler and microbenchmark utilities
+ *
+ *  Copyright (C) 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <map>
+#include <string>
+
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+/** @file
+
+    @brief timing instrumentation for the ART control nodes.
+
+    Every timing question used to need ad-hoc gettimeofday code.
+    This header collects the standard pieces instead:
+
+      - Profiler: named streaming histograms of section durations,
+        reported on a diagnostics topic and in the ROS log;
+      - Profiler::Scope: RAII timer recording one section invocation;
+      - Profiler::ticks(): raw cycle counter for microbenchmarks too
+        short for a clock_gettime() call pair.
+
+    A node declares one Profiler, wraps interesting sections in
+    Scopes, and appends to_message() output to its once-a-second
+    diagnostics message.  The histograms are fixed size: recording
+    costs one clock read and a few adds, so scopes can stay enabled
+    in production loops.
+*/
+
+class Profiler
+{
+ public:
+
+  // histogram bucket b counts durations in [2^b, 2^(b+1)) microseconds;
+  // the last bucket is open-ended (32ms and up, most of a cycle)
+  static const unsigned n_buckets = 16;
+
+  struct Histogram
+  {
+    unsigned long count;		// number of invocations
+    double total;			// total duration (seconds)
+    double max;				// longest duration (seconds)
+    unsigned long buckets[n_buckets];
+
+    Histogram(): count(0), total(0.0), max(0.0)
+    {
+      for (unsigned b = 0; b < n_buckets; ++b)
+	buckets[b] = 0;
+    }
+  };
+
+  /** @brief Record one invocation of @a name lasting @a seconds. */
+  void record(const char *name, double seconds)
+  {
+    Histogram &h = stats_[name];
+    ++h.count;
+    h.total += seconds;
+    if (seconds > h.max)
+      h.max = seconds;
+    double us = seconds * 1e6;
+    unsigned b = 0;
+    while (b < n_buckets-1 && us >= (double) (1 << (b+1)))
+      ++b;
+    ++h.buckets[b];
+  }
+
+  /** @brief Append the accumulated histograms to a diagnostics message.
+   *
+   *  @param msg message to append to
+   *  @param prefix node name prefixed to each status name
+   */
+  void to_message(diagnostic_msgs::DiagnosticArray &msg,
+		  const char *prefix) const
+  {
+    for (stats_map::const_iterator i = stats_.begin();
+	 i != stats_.end(); ++i)
+      {
+	const Histogram &h = i->second;
+	diagnostic_msgs::DiagnosticStatus status;
+	status.level = diagnostic_msgs::DiagnosticStatus::OK;
+	status.name = std::string(prefix) + ": " + i->first;
+	char buf[64];
+	snprintf(buf, sizeof(buf), "mean %.3f ms, max %.3f ms",
+		 mean_ms(h), h.max*1e3);
+	status.message = buf;
+	add_value(status, "count", "%lu", h.count);
+	add_value(status, "mean (ms)", "%.3f", mean_ms(h));
+	add_value(status, "max (ms)", "%.3f", h.max*1e3);
+	for (unsigned b = 0; b < n_buckets; ++b)
+	  {
+	    if (h.buckets[b] == 0)
+	      continue;
+	    char key[32];
+	    snprintf(key, sizeof(key), "< %u us", 1 << (b+1));
+	    add_value(status, key, "%lu", h.buckets[b]);
+	  }
+	msg.status.push_back(status);
+      }
+  }
+
+  /** @brief Write the accumulated statistics to the ROS log. */
+  void log_summary(void) const
+  {
+    for (stats_map::const_iterator i = stats_.begin();
+	 i != stats_.end(); ++i)
+      {
+	const Histogram &h = i->second;
+	ROS_INFO("%s: %lu calls, mean %.3f ms, max %.3f ms",
+		 i->first.c_str(), h.count, mean_ms(h), h.max*1e3);
+	for (unsigned b = 0; b < n_buckets; ++b)
+	  if (h.buckets[b] != 0)
+	    ROS_INFO("  < %u us: %lu", 1 << (b+1), h.buckets[b]);
+      }
+  }
+
+  /** @brief Scoped timer recording one invocation on destruction. */
+  class Scope
+  {
+   public:
+    Scope(Profiler *profiler, const char *name):
+      profiler_(profiler), name_(name)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start_);
+    }
+
+    ~Scope()
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      profiler_->record(name_, ((now.tv_sec - start_.tv_sec)
+				+ 1e-9 * (now.tv_nsec - start_.tv_nsec)));
+    }
+
+   private:
+    Profiler *profiler_;
+    const char *name_;
+    struct timespec start_;
+  };
+
+  /** @brief raw cycle counter for microbenchmarks
+   *
+   *  Returns the processor time stamp counter where available,
+   *  nanoseconds otherwise.  Only differences between two readings
+   *  on the same processor are meaningful; for sections long enough
+   *  to afford two clock_gettime() calls, prefer Scope.
+   */
+  static inline uint64_t ticks(void)
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc": "=a" (lo), "=d" (hi));
+    return ((uint64_t) hi << 32) | lo;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+  }
+
+ private:
+
+  typedef std::map<std::string, Histogram> stats_map;
+
+  static double mean_ms(const Histogram &h)
+  {
+    return (h.count? (h.total / h.count) * 1e3: 0.0);
+  }
+
+  /** append one key/value pair to a diagnostic status */
+  template <class T>
+  static void add_value(diagnostic_msgs::DiagnosticStatus &status,
+			const char *key, const char *fmt, T value)
+  {
+    diagnostic_msgs::KeyValue kv;
+    kv.key = key;
+    char buf[32];
+    snprintf(buf, sizeof(buf), fmt, value);
+    kv.value = buf;
+    status.values.push_back(kv);
+  }
+
+  stats_map stats_;
+};
+
+#endif // _PROFILER_H_
@@ -2,7 +2,7 @@
  *  Copyright (C) 2009 Austin Robot Technology
  *
  *  License: Modified BSD Software License Agreement
- * 
+ *
  *  $Id$
  */
 
@@ -19,14 +19,21 @@
 @brief ROS static transform broadcaster for the ART autonomous vehicle.
 
 This node broadcasts static transforms from various devices to the
-"/vehicle" frame of reference.  Some ROS components require that to be
-done about once every 10 seconds.
+"/vehicle" frame of reference.  All the device transforms travel in a
+single consolidated tf message, republished at a low rate with stamps
+post-dated past the next cycle, so listeners always have current data
+while subscribers see one small message per period instead of a steady
+stream.
 
 @par Advertises
 
 - \b /tf topic: broadcast transforms from \b /velodyne, \b
   /front_sick, and \b /rear_sick frames to \b /vehicle frame.
 
+@par Parameters
+
+- \b ~rate: republish frequency in Hz (default: 1.0)
+
 \author Jack O'Quin
 
 */
@@ -35,20 +42,15 @@ done about once every 10 seconds.
 
 namespace
 {
-  /// These are *static* transforms, so it's safe to post-date them
-  //  into the future.  Otherwise, some transform listeners will see
-  //  old data at times.
-  ros::Duration transform_post_date_(1.0/art_msgs::ArtHertz::VEHICLE_TF);
-
   // class for generating vehicle-relative frame IDs
   ArtFrames::VehicleRelative vr_;
 }
 
-/** Publish the 3D pose of a device in the vehicle's frame of reference. */
-void broadcastTF(tf::TransformBroadcaster *tf_broadcaster,
-                 std::string device_frame,
-                 double x, double y, double z, 
-                 double roll, double pitch, double yaw)
+/** Append the 3D pose of a device in the vehicle's frame of reference. */
+void appendTF(std::vector<geometry_msgs::TransformStamped> *transforms,
+              std::string device_frame,
+              double x, double y, double z,
+              double roll, double pitch, double yaw)
 {
   // translate roll, pitch and yaw into a Quaternion
   tf::Quaternion q;
@@ -56,9 +58,8 @@ void broadcastTF(tf::TransformBroadcaster *tf_broadcaster,
   geometry_msgs::Quaternion tf_quat;
   tf::quaternionTFToMsg(q, tf_quat);
 
-  // broadcast Transform from vehicle to device
+  // Transform from vehicle to device (stamp filled in when sent)
   geometry_msgs::TransformStamped static_tf;
-  static_tf.header.stamp = ros::Time::now() + transform_post_date_;
   static_tf.header.frame_id = vr_.getFrame(ArtFrames::vehicle);
   static_tf.child_frame_id = vr_.getFrame(device_frame);
   static_tf.transform.translation.x = x;
@@ -66,22 +67,21 @@ void broadcastTF(tf::TransformBroadcaster *tf_broadcaster,
   static_tf.transform.translation.z = z;
   static_tf.transform.rotation = tf_quat;
 
-  tf_broadcaster->sendTransform(static_tf);
+  transforms->push_back(static_tf);
 }
 
-/** Publish the 3D pose of a device in the vehicle's frame of
+/** Append the 3D pose of a device in the vehicle's frame of
     reference, plus its optical frame. */
-void opticalTF(tf::TransformBroadcaster *tf_broadcaster,
-               std::string device_frame,
-               double x, double y, double z, 
-               double roll, double pitch, double yaw)
+void appendOpticalTF(std::vector<geometry_msgs::TransformStamped> *transforms,
+                     std::string device_frame,
+                     double x, double y, double z,
+                     double roll, double pitch, double yaw)
 {
-  // first broadcast the device frame
-  broadcastTF(tf_broadcaster, device_frame, x, y, z, roll, pitch, yaw);
+  // first the device frame
+  appendTF(transforms, device_frame, x, y, z, roll, pitch, yaw);
 
-  // broadcast Transform from device to corresponding optical frame
+  // then the Transform from device to corresponding optical frame
   geometry_msgs::TransformStamped optical_tf;
-  optical_tf.header.stamp = ros::Time::now() + transform_post_date_;
   optical_tf.header.frame_id = vr_.getFrame(device_frame);
   optical_tf.child_frame_id = vr_.getFrame(device_frame + "_optical");
 
@@ -91,7 +91,7 @@ void opticalTF(tf::TransformBroadcaster *tf_broadcaster,
   optical_tf.transform.rotation.y = 0.5;
   optical_tf.transform.rotation.z = -0.5;
 
-  tf_broadcaster->sendTransform(optical_tf);
+  transforms->push_back(optical_tf);
 }
 
 /** main program */
@@ -99,48 +99,54 @@ int main(int argc, char** argv)
 {
   ros::init(argc, argv, NODE);
   ros::NodeHandle node;
+  ros::NodeHandle private_nh("~");
 
   tf::TransformBroadcaster tf_broadcaster;
   vr_.getPrefixParam();                 // get vehicle-relative tf prefix
 
-  ros::Rate cycle(art_msgs::ArtHertz::VEHICLE_TF); // set driver cycle rate
-  
-  ROS_INFO(NODE ": starting main loop");
-
-  // main loop
-  while(ros::ok())
-    {
-      using art_msgs::ArtVehicle;
-
-      // Velodyne 3D LIDAR
-      broadcastTF(&tf_broadcaster, ArtFrames::velodyne,
-                  ArtVehicle::velodyne_px,
-                  ArtVehicle::velodyne_py,
-                  ArtVehicle::velodyne_pz,
-                  ArtVehicle::velodyne_roll,
-                  ArtVehicle::velodyne_pitch,
-                  ArtVehicle::velodyne_yaw);
-
-      // Front Sick LIDAR
-      broadcastTF(&tf_broadcaster, ArtFrames::front_sick,
-                  ArtVehicle::front_SICK_px,
-                  ArtVehicle::front_SICK_py,
-                  ArtVehicle::front_SICK_pz,
-                  ArtVehicle::front_SICK_roll,
-                  ArtVehicle::front_SICK_pitch,
-                  ArtVehicle::front_SICK_yaw);
-
-      // Rear Sick LIDAR
-      broadcastTF(&tf_broadcaster, ArtFrames::rear_sick,
-                  ArtVehicle::rear_SICK_px,
-                  ArtVehicle::rear_SICK_py,
-                  ArtVehicle::rear_SICK_pz,
-                  ArtVehicle::rear_SICK_roll,
-                  ArtVehicle::rear_SICK_pitch,
-                  ArtVehicle::rear_SICK_yaw);
-
-      // Left front camera
-      opticalTF(&tf_broadcaster, ArtFrames::left_front_camera,
+  // These transforms never change, so republishing is only needed to
+  // keep them current for late-joining listeners.  Stamps are
+  // post-dated two periods into the future, so lookups at any time
+  // always fall between two samples regardless of the rate.
+  double rate;
+  private_nh.param("rate", rate, 1.0);
+  if (rate <= 0.0)
+    rate = 1.0;
+  ros::Duration transform_post_date(2.0/rate);
+
+  // build the consolidated transform list once
+  using art_msgs::ArtVehicle;
+  std::vector<geometry_msgs::TransformStamped> transforms;
+
+  // Velodyne 3D LIDAR
+  appendTF(&transforms, ArtFrames::velodyne,
+           ArtVehicle::velodyne_px,
+           ArtVehicle::velodyne_py,
+           ArtVehicle::velodyne_pz,
+           ArtVehicle::velodyne_roll,
+           ArtVehicle::velodyne_pitch,
+           ArtVehicle::velodyne_yaw);
+
+  // Front Sick LIDAR
+  appendTF(&transforms, ArtFrames::front_sick,
+           ArtVehicle::front_SICK_px,
+           ArtVehicle::front_SICK_py,
+           ArtVehicle::front_SICK_pz,
+           ArtVehicle::front_SICK_roll,
+           ArtVehicle::front_SICK_pitch,
+           ArtVehicle::front_SICK_yaw);
+
+  // Rear Sick LIDAR
+  appendTF(&transforms, ArtFrames::rear_sick,
+           ArtVehicle::rear_SICK_px,
+           ArtVehicle::rear_SICK_py,
+           ArtVehicle::rear_SICK_pz,
+           ArtVehicle::rear_SICK_roll,
+           ArtVehicle::rear_SICK_pitch,
+           ArtVehicle::rear_SICK_yaw);
+
+  // Left front camera
+  appendOpticalTF(&transforms, ArtFrames::left_front_camera,
                   ArtVehicle::left_front_camera_px,
                   ArtVehicle::left_front_camera_py,
                   ArtVehicle::left_front_camera_pz,
@@ -148,8 +154,8 @@ int main(int argc, char** argv)
                   ArtVehicle::left_front_camera_pitch,
                   ArtVehicle::left_front_camera_yaw);
 
-      // Center front camera
-      opticalTF(&tf_broadcaster, ArtFrames::center_front_camera,
+  // Center front camera
+  appendOpticalTF(&transforms, ArtFrames::center_front_camera,
                   ArtVehicle::center_front_camera_px,
                   ArtVehicle::center_front_camera_py,
                   ArtVehicle::center_front_camera_pz,
@@ -157,8 +163,8 @@ int main(int argc, char** argv)
                   ArtVehicle::center_front_camera_pitch,
                   ArtVehicle::center_front_camera_yaw);
 
-      // Right front camera
-      opticalTF(&tf_broadcaster, ArtFrames::right_front_camera,
+  // Right front camera
+  appendOpticalTF(&transforms, ArtFrames::right_front_camera,
                   ArtVehicle::right_front_camera_px,
                   ArtVehicle::right_front_camera_py,
                   ArtVehicle::right_front_camera_pz,
@@ -166,6 +172,19 @@ int main(int argc, char** argv)
                   ArtVehicle::right_front_camera_pitch,
                   ArtVehicle::right_front_camera_yaw);
 
+  ros::Rate cycle(rate);                // set republish rate
+
+  ROS_INFO(NODE ": starting main loop");
+
+  // main loop
+  while(ros::ok())
+    {
+      // all the transforms go out in a single tf message
+      ros::Time stamp = ros::Time::now() + transform_post_date;
+      for (size_t i = 0; i < transforms.size(); ++i)
+        transforms[i].header.stamp = stamp;
+      tf_broadcaster.sendTransform(transforms);
+
       ros::spinOnce();                  // handle incoming messages
       cycle.sleep();                    // sleep until next cycle
     }
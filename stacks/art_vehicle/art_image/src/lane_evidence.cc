@@ -0,0 +1,291 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/** @file
+
+ @brief lane evidence preprocessing for the visual lane pipeline
+
+Converts camera frames into the scan-style evidence format the
+VisualLanes occupancy grid consumes (see addSickScan()): bright lane
+markings are thresholded, projected onto the ground plane through the
+camera model, and reduced to a polar range profile giving the nearest
+marking per bearing.  Runs at camera rate on the vehicle computer, so
+the visual lane pipeline no longer depends on offline processing.
+
+Subscribes:
+
+- @b camera/image_raw [sensor_msgs::Image] camera frames, received
+     through image_transport (zero-copy when run in the camera's
+     nodelet manager)
+- @b camera/camera_info [sensor_msgs::CameraInfo] camera calibration
+
+Publishes:
+
+- @b lane_evidence [sensor_msgs::LaserScan] nearest lane marking per
+     bearing, in the camera's ground-plane frame
+
+Parameters:
+
+- @b ~camera_height (double) optical center height above the ground
+     plane in meters (default 1.5)
+- @b ~camera_tilt (double) downward tilt of the optical axis in
+     radians (default 0.1)
+- @b ~threshold (int) minimum luma value treated as lane marking
+     evidence (default 200)
+- @b ~max_range (double) range reported when a bearing has no
+     evidence (default 60.0)
+
+@author Jack O'Quin
+
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#include <ros/ros.h>
+#include <image_transport/image_transport.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/image_encodings.h>
+
+namespace
+{
+  /** Colorspace kernel: packed RGB or BGR rows to 8-bit luma.
+   *
+   *  Fixed-point BT.601 weights, one multiply-add chain per pixel
+   *  with no branches, so the compiler can vectorize the loop.  The
+   *  red/blue weights are passed in to handle both channel orders
+   *  with the same kernel.
+   */
+  void luma_kernel(const uint8_t *row, int width, int pixel_step,
+                   int w0, int w2, uint8_t *luma)
+  {
+    for (int u = 0; u < width; ++u)
+      {
+        const uint8_t *p = row + u * pixel_step;
+        luma[u] = (uint8_t) ((w0*p[0] + 150*p[1] + w2*p[2]) >> 8);
+      }
+  }
+}
+
+/** ROS node class converting camera frames to lane evidence scans. */
+class LaneEvidenceNode
+{
+public:
+
+  LaneEvidenceNode(ros::NodeHandle node):
+    it_(node)
+  {
+    ros::NodeHandle private_nh("~");
+    private_nh.param("camera_height", camera_height_, 1.5);
+    private_nh.param("camera_tilt", camera_tilt_, 0.1);
+    private_nh.param("threshold", threshold_, 200);
+    private_nh.param("max_range", max_range_, 60.0);
+
+    cal_width_ = cal_height_ = 0;
+
+    scan_pub_ = node.advertise<sensor_msgs::LaserScan>("lane_evidence", 1);
+    cam_sub_ = it_.subscribeCamera("camera/image_raw", 1,
+                                   &LaneEvidenceNode::processImage, this);
+  }
+
+private:
+
+  /** Rebuild the projection tables when the calibration changes.
+   *
+   *  The ground-plane projection separates by axis: the bearing of a
+   *  pixel depends only on its column, and the forward distance only
+   *  on its row, so two small tables replace the per-pixel
+   *  trigonometry in the frame loop.
+   *
+   *  @return true if the tables are usable
+   */
+  bool updateCalibration(const sensor_msgs::CameraInfoConstPtr &cinfo)
+  {
+    if ((int) cinfo->width == cal_width_
+        && (int) cinfo->height == cal_height_)
+      return true;                      // tables still valid
+
+    double fx = cinfo->K[0];
+    double fy = cinfo->K[4];
+    double cx = cinfo->K[2];
+    double cy = cinfo->K[5];
+    if (fx <= 0.0 || fy <= 0.0)
+      {
+        ROS_WARN_THROTTLE(30, "camera not calibrated, "
+                          "cannot project lane evidence");
+        return false;
+      }
+
+    cal_width_ = cinfo->width;
+    cal_height_ = cinfo->height;
+
+    // per-column bearing and range scale: a column's view ray makes a
+    // fixed horizontal angle with the optical axis
+    col_bin_.resize(cal_width_);
+    col_scale_.resize(cal_width_);
+    double tan_left = (0.5 - cx) / fx;
+    double tan_right = (cal_width_ - 0.5 - cx) / fx;
+    angle_max_ = atan(-tan_left);       // scan x axis points forward
+    angle_min_ = atan(-tan_right);
+    angle_increment_ = (angle_max_ - angle_min_) / (nbins_ - 1);
+    for (int u = 0; u < cal_width_; ++u)
+      {
+        double tan_u = (u + 0.5 - cx) / fx;
+        int bin = (int) rint((atan(-tan_u) - angle_min_)
+                             / angle_increment_);
+        if (bin < 0)
+          bin = 0;
+        if (bin >= nbins_)
+          bin = nbins_ - 1;
+        col_bin_[u] = bin;
+        col_scale_[u] = sqrt(1.0 + tan_u*tan_u);
+      }
+
+    // per-row forward distance: rows at or above the horizon project
+    // to no ground point and get a negative entry
+    row_fwd_.resize(cal_height_);
+    for (int v = 0; v < cal_height_; ++v)
+      {
+        double depression = camera_tilt_ + atan((v + 0.5 - cy) / fy);
+        if (depression > 0.001)
+          row_fwd_[v] = camera_height_ / tan(depression);
+        else
+          row_fwd_[v] = -1.0;
+      }
+
+    ROS_INFO("lane evidence projection tables built: %dx%d, "
+             "bearings %.3f to %.3f", cal_width_, cal_height_,
+             angle_min_, angle_max_);
+    return true;
+  }
+
+  /** Convert one camera frame to a lane evidence scan. */
+  void processImage(const sensor_msgs::ImageConstPtr &image,
+                    const sensor_msgs::CameraInfoConstPtr &cinfo)
+  {
+    if (scan_pub_.getNumSubscribers() == 0)
+      return;                           // nobody listening
+
+    if (!updateCalibration(cinfo))
+      return;
+    if ((int) image->width != cal_width_
+        || (int) image->height != cal_height_)
+      {
+        ROS_WARN_THROTTLE(30, "image size does not match calibration");
+        return;
+      }
+
+    namespace enc = sensor_msgs::image_encodings;
+    int pixel_step;
+    int w0, w2;                         // luma weights for p[0], p[2]
+    if (image->encoding == enc::MONO8)
+      {
+        pixel_step = 1;
+        w0 = w2 = 0;                    // luma pass unused
+      }
+    else if (image->encoding == enc::RGB8)
+      {
+        pixel_step = 3;
+        w0 = 77;                        // red leads each pixel
+        w2 = 29;
+      }
+    else if (image->encoding == enc::BGR8)
+      {
+        pixel_step = 3;
+        w0 = 29;                        // blue leads each pixel
+        w2 = 77;
+      }
+    else
+      {
+        ROS_WARN_THROTTLE(30, "unsupported image encoding: %s",
+                          image->encoding.c_str());
+        return;
+      }
+
+    std::vector<float> ranges(nbins_, (float) max_range_);
+    if (luma_.size() < (size_t) cal_width_)
+      luma_.resize(cal_width_);
+
+    uint8_t thresh = (uint8_t) threshold_;
+    for (int v = 0; v < cal_height_; ++v)
+      {
+        double fwd = row_fwd_[v];
+        if (fwd < 0.0 || fwd > max_range_)
+          continue;                     // above horizon or too far
+
+        const uint8_t *row = &image->data[v * image->step];
+        const uint8_t *luma = row;
+        if (pixel_step != 1)
+          {
+            // color row: run the batch luma kernel first
+            luma_kernel(row, cal_width_, pixel_step, w0, w2, &luma_[0]);
+            luma = &luma_[0];
+          }
+
+        // threshold and project: nearer rows are processed last, so
+        // the minimum per bearing falls out of plain stores
+        for (int u = 0; u < cal_width_; ++u)
+          {
+            if (luma[u] >= thresh)
+              {
+                float range = (float) (fwd * col_scale_[u]);
+                int bin = col_bin_[u];
+                if (range < ranges[bin])
+                  ranges[bin] = range;
+              }
+          }
+      }
+
+    sensor_msgs::LaserScan scan;
+    scan.header = image->header;
+    scan.angle_min = angle_min_;
+    scan.angle_max = angle_max_;
+    scan.angle_increment = angle_increment_;
+    scan.range_min = 0.0;
+    scan.range_max = max_range_;
+    scan.ranges.swap(ranges);
+    scan_pub_.publish(scan);
+  }
+
+  // parameters:
+  double camera_height_;        ///< optical center height above ground (m)
+  double camera_tilt_;          ///< downward tilt of optical axis (rad)
+  int threshold_;               ///< minimum luma counted as evidence
+  double max_range_;            ///< range reported for empty bearings (m)
+
+  // topics
+  image_transport::ImageTransport it_;
+  image_transport::CameraSubscriber cam_sub_;
+  ros::Publisher scan_pub_;
+
+  // projection tables, rebuilt when the calibration changes
+  static const int nbins_ = 181;  ///< evidence bearing bins per scan
+  int cal_width_;               ///< calibrated image width
+  int cal_height_;              ///< calibrated image height
+  double angle_min_;            ///< bearing of last scan bin (rad)
+  double angle_max_;            ///< bearing of first scan bin (rad)
+  double angle_increment_;      ///< bearing step between bins (rad)
+  std::vector<int> col_bin_;    ///< scan bin for each image column
+  std::vector<double> col_scale_; ///< range per forward meter, by column
+  std::vector<double> row_fwd_; ///< ground distance for each image row
+
+  std::vector<uint8_t> luma_;   ///< reusable luma row buffer
+};
+
+/** main program */
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "lane_evidence");
+  ros::NodeHandle node;
+  LaneEvidenceNode lev(node);
+  ros::spin();
+  return 0;
+}
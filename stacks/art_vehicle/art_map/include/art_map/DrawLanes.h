@@ -22,6 +22,7 @@
 #include <math.h>
 #include <errno.h>
 #include <stdint.h>
+#include <stdio.h>
 //#include <art_map/zones.h>
 
 /*struct poly{
@@ -46,13 +47,28 @@ struct RGB {
 class DrawLanes {
 public:
   DrawLanes(int x,int y, float multi=DEFAULT_RATIO);
+
+  /** Tile constructor: draw only pixel rows [row0, row0+rows).
+   *
+   *  The tile accepts the same world coordinates as a full image, but
+   *  only stores and rasterizes its own band of rows, so independent
+   *  tiles can be rendered in parallel and stitched on write.
+   */
+  DrawLanes(int x, int y, float multi, int row0, int rows);
   ~DrawLanes();
-  
+
   void clear();
-  
+
   void savePGM(const char *filename);
   void saveBMP(const char *filename);
 
+  /** Append this image's rows to @a f as raw binary RGB triplets,
+   *  the pixel format of a P6 PPM body. */
+  void saveP6Rows(FILE *f);
+
+  int pixelWidth() const { return imageWidth; }
+  int pixelHeight() const { return imageHeight; }
+
   void addPoly(float x1, float x2, float x3, float x4,
                float y1, float y2,float y3, float y4,
                bool is_stop, bool is_exit);
@@ -69,6 +85,9 @@ private:
   RGB* image;
   int imageWidth;
   int imageHeight;
+  int bandStart;			// first stored pixel row
+  int bandRows;				// stored rows (== imageHeight
+					// for a full image)
 
   void line(float x0, float y0, float x1, float y1,RGB colour);
 };
@@ -21,6 +21,16 @@ class FilteredPolygon
   void SetPoint(int pointID, float x, float y);
   void UpdatePoint(int pointID, float visionDistance, float visionAngle,
                    float confidence,float rx, float ry, float rori);
+
+  // Batched update of all four points from one vision frame.  Gathers
+  // the filter states once and computes the distance and angle
+  // measurement terms for every point in contiguous arrays before
+  // applying the updates, instead of rebuilding Jacobian matrices one
+  // point at a time.  Points with update[i] false are skipped.
+  void UpdatePoints(const float visionDistance[NUM_POINTS],
+                    const float visionAngle[NUM_POINTS],
+                    const bool update[NUM_POINTS],
+                    float confidence, float rx, float ry, float rori);
   Matrix GetDistanceJacobian(float xb, float yb, float x, float y);
   Matrix GetAngleJacobian(float xb, float yb, float x, float y);
  
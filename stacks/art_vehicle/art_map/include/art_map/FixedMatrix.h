@@ -0,0 +1,118 @@
+/* -*- mode: C++ -*- */
+
+// $Id$
+
+#ifndef _FixedMatrix_h_DEFINED
+#define _FixedMatrix_h_DEFINED
+
+#include <art_map/Matrix.h>
+
+/** Fixed-size matrix with stack storage.
+ *
+ *  The dynamic Matrix class heap-allocates on every multiply and
+ *  transpose, which dominates the cost of the small (2x2, 4x4)
+ *  operations inside the Kalman filter updates.  This template keeps
+ *  the elements in a plain array, so temporaries live on the stack
+ *  and the small fixed-trip-count loops unroll at compile time.
+ */
+template <int R, int C>
+class FixedMatrix
+{
+public:
+  float m[R][C];
+
+  FixedMatrix()
+  {
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        m[i][j] = 0.0f;
+  }
+
+  /** copy elements from a dynamic Matrix (dimensions must match) */
+  explicit FixedMatrix(const Matrix& a)
+  {
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        m[i][j] = a[i][j];
+  }
+
+  float* operator[](int i) {return m[i];}
+  const float* operator[](int i) const {return m[i];}
+
+  /** identity (square instantiations only) */
+  static FixedMatrix<R,C> eye()
+  {
+    FixedMatrix<R,C> a;
+    for (int i = 0; i < R && i < C; i++)
+      a.m[i][i] = 1.0f;
+    return a;
+  }
+
+  FixedMatrix<R,C> operator+(const FixedMatrix<R,C>& b) const
+  {
+    FixedMatrix<R,C> r;
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        r.m[i][j] = m[i][j] + b.m[i][j];
+    return r;
+  }
+
+  FixedMatrix<R,C> operator-(const FixedMatrix<R,C>& b) const
+  {
+    FixedMatrix<R,C> r;
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        r.m[i][j] = m[i][j] - b.m[i][j];
+    return r;
+  }
+
+  /** matrix product; inner loops unroll for small dimensions */
+  template <int K>
+  FixedMatrix<R,K> operator*(const FixedMatrix<C,K>& b) const
+  {
+    FixedMatrix<R,K> r;
+    for (int i = 0; i < R; i++)
+      for (int k = 0; k < K; k++)
+        {
+          float sum = 0.0f;
+          for (int j = 0; j < C; j++)
+            sum += m[i][j] * b.m[j][k];
+          r.m[i][k] = sum;
+        }
+    return r;
+  }
+
+  FixedMatrix<R,C> operator*(float s) const
+  {
+    FixedMatrix<R,C> r;
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        r.m[i][j] = m[i][j] * s;
+    return r;
+  }
+
+  FixedMatrix<R,C> operator/(float s) const
+  {
+    return *this * (1.0f/s);
+  }
+
+  FixedMatrix<C,R> transp() const
+  {
+    FixedMatrix<C,R> r;
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        r.m[j][i] = m[i][j];
+    return r;
+  }
+
+  /** copy elements back into a dynamic Matrix without reallocating
+   *  it (dimensions must match) */
+  void copyTo(Matrix& a) const
+  {
+    for (int i = 0; i < R; i++)
+      for (int j = 0; j < C; j++)
+        a[i][j] = m[i][j];
+  }
+};
+
+#endif // _FixedMatrix_h_DEFINED
@@ -40,6 +40,7 @@ class Graph{
     edges_size = 0;
     nodes=NULL;
     edges.clear();
+    index_valid = false;
   };
 
   Graph(uint num_nodes, uint num_edges, 
@@ -54,6 +55,7 @@ class Graph{
     edges.clear();
    for (uint i=0; i< num_edges; i++)
      edges.push_back(nedges[i]);
+    index_valid = false;
   };
   
   Graph(Graph& that){
@@ -64,6 +66,7 @@ class Graph{
     
     this->edges_size=that.edges_size;
     this->edges=that.edges;
+    this->index_valid=false;
   };
 
 
@@ -73,6 +76,27 @@ class Graph{
     edges.clear();
   };
 
+  /** Exchange contents with another graph in constant time.
+   *
+   *  Hands off a freshly-built graph without copying the node array
+   *  (there is no assignment operator, and the copy constructor does
+   *  a full deep copy).
+   */
+  void swap(Graph &that)
+  {
+    std::swap(this->nodes, that.nodes);
+    this->edges.swap(that.edges);
+    std::swap(this->nodes_size, that.nodes_size);
+    std::swap(this->edges_size, that.edges_size);
+    std::swap(this->index_valid, that.index_valid);
+    this->adj_keys.swap(that.adj_keys);
+    this->adj_offset.swap(that.adj_offset);
+    this->adj_edges.swap(that.adj_edges);
+    this->id_order.swap(that.id_order);
+    this->index_order.swap(that.index_order);
+    this->id_keys.swap(that.id_keys);
+  };
+
   //Operators
   //bool operator==(const Graph &that);
   bool compare(const Graph &that)
@@ -96,6 +120,15 @@ class Graph{
   }
 
   WayPointEdgeList edges_from(const waypt_index_t index) const;
+
+  /** Collect positions in edges[] of the edges leaving a node.
+   *
+   *  Same lookup as edges_from(), but fills a caller-owned list with
+   *  edge positions instead of copying the edges, so callers can key
+   *  per-edge side tables and reuse the list's storage.
+   */
+  void edge_positions_from(const waypt_index_t index, intList& out) const;
+
   WayPointEdgeList edges_leaving_segment(const segment_id_t seg) const;
 
 
@@ -123,10 +156,31 @@ class Graph{
   WayPointNode* get_closest_node(const MapXY &p) const;
   WayPointNode* get_closest_node_within_radius(const MapXY &p) const;
 
+  /** Build the node and edge lookup indexes.
+   *
+   *  Creates a CSR-style adjacency table (edge positions grouped by
+   *  start node, with a binary-searched key list) plus node position
+   *  lists sorted by ElementID and way-point index, so edges_from()
+   *  and the get_node lookups stop scanning the whole graph.  Called
+   *  automatically once the way-point coordinates are final; adding
+   *  nodes or edges afterwards requires another call.
+   */
+  void build_index();
+
   WayPointNode* nodes;
   std::vector<WayPointEdge> edges;
   uint32_t nodes_size;
   uint32_t edges_size;
+
+  // lookup indexes built by build_index()
+  bool index_valid;
+  intList adj_keys;		// distinct start node indexes, sorted
+  intList adj_offset;		// first adj_edges entry for each key
+  intList adj_edges;		// edge positions grouped by start node
+  intList id_order;		// node positions sorted by ElementID
+  intList index_order;		// node positions sorted by way-point index
+  std::vector<uint64_t> id_keys;	// packed IDs, same order as id_order
+
   bool passing_allowed(int index, int index2, bool left);
 
   bool lanes_in_same_direction(int index1,int index2, bool& left_lane);
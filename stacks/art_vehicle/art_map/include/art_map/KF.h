@@ -8,6 +8,7 @@
 //#define DEBUGFILTER
 
 #include <stdio.h>
+#include <art_map/FixedMatrix.h>
 #include <art_map/Matrix.h>
 #include <art_map/MQMath.h>
 
@@ -55,6 +56,26 @@ class KF
 
     int MeasurementUpdateExtended(Matrix &C,KFStruct s);
 
+    // allocation-free fast path for the two-state filters; same maths
+    // as MeasurementUpdateExtended() with fixed-size stack matrices
+    int MeasurementUpdateExtended2(Matrix& C, float R, float Y, float Ybar,
+                                   bool rejectOutliers, float outlierError,
+                                   bool mainFilterAngleUpdate,
+                                   bool ignoreLongRangeUpdate,
+                                   float deadzoneSize, float dist,
+                                   bool ambigObject, bool changeAlpha);
+
+    // same fast path with the 1x2 Jacobian passed as scalars, so
+    // batched callers need not build a Matrix per measurement
+    int MeasurementUpdateExtended2(float c0, float c1, KFStruct s);
+    int MeasurementUpdateExtended2(float c0, float c1, float R, float Y,
+                                   float Ybar, bool rejectOutliers,
+                                   float outlierError,
+                                   bool mainFilterAngleUpdate,
+                                   bool ignoreLongRangeUpdate,
+                                   float deadzoneSize, float dist,
+                                   bool ambigObject, bool changeAlpha);
+
     void Reset();
     Matrix GetStates();
     void SetStates(Matrix Xbar);
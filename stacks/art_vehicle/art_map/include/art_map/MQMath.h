@@ -2,7 +2,11 @@
 
 // $Id$
 
+#ifndef __MQMATH_H__
+#define __MQMATH_H__
+
 #include <math.h>
+#include <art/epsilon.h>
 #define PI 3.141592
 #define PI_L 3141592L
 
@@ -47,3 +51,97 @@ inline double AngleFromXY2(double x,double y, double ori, double x2, double y2)
 {
   return Normalise_PI(atan2(x2-x,y2-y) - ori);
 }
+
+// Shared geometry kernels.  These are the innermost operations of
+// point-in-polygon and segment tests, kept here as inlines so the
+// loops calling them compile to straight arithmetic.
+
+// side of the directed line (x0,y0)->(x1,y1) the point (px,py) is on:
+// positive left, negative right, zero collinear
+inline double LineSideXY(double x0, double y0, double x1, double y1,
+			 double px, double py)
+{
+  return (x1-x0)*(py-y0) - (y1-y0)*(px-x0);
+}
+
+// true if the collinear point (px,py) lies within the bounding box of
+// the segment (x0,y0)-(x1,y1)
+inline bool CollinearOnSegmentXY(double px, double py,
+				 double x0, double y0,
+				 double x1, double y1)
+{
+  return (px >= fmin(x0,x1) && px <= fmax(x0,x1)
+	  && py >= fmin(y0,y1) && py <= fmax(y0,y1));
+}
+
+// true if segments (ax0,ay0)-(ax1,ay1) and (bx0,by0)-(bx1,by1)
+// intersect; touching end points count as intersecting
+inline bool SegmentsIntersectXY(double ax0, double ay0,
+				double ax1, double ay1,
+				double bx0, double by0,
+				double bx1, double by1)
+{
+  double d1 = LineSideXY(bx0,by0, bx1,by1, ax0,ay0);
+  double d2 = LineSideXY(bx0,by0, bx1,by1, ax1,ay1);
+  double d3 = LineSideXY(ax0,ay0, ax1,ay1, bx0,by0);
+  double d4 = LineSideXY(ax0,ay0, ax1,ay1, bx1,by1);
+
+  if (((d1 > 0.0) != (d2 > 0.0)) && ((d3 > 0.0) != (d4 > 0.0)))
+    return true;			// proper crossing
+
+  // collinear or touching cases: an end point on the other segment
+  if (d1 == 0.0
+      && CollinearOnSegmentXY(ax0,ay0, bx0,by0, bx1,by1)) return true;
+  if (d2 == 0.0
+      && CollinearOnSegmentXY(ax1,ay1, bx0,by0, bx1,by1)) return true;
+  if (d3 == 0.0
+      && CollinearOnSegmentXY(bx0,by0, ax0,ay0, ax1,ay1)) return true;
+  if (d4 == 0.0
+      && CollinearOnSegmentXY(bx1,by1, ax0,ay0, ax1,ay1)) return true;
+  return false;
+}
+
+// crossings (0 or 1) of the ray from (rx,ry) to the right with the
+// perimeter segment (x1,y1)->(x2,y2); (x3,y3) is the vertex after the
+// segment, so a ray passing exactly through (x2,y2) is counted once
+// instead of once per adjoining segment
+inline int RayRightCrossesSegmentXY(double x1, double y1,
+				    double x2, double y2,
+				    double x3, double y3,
+				    double rx, double ry)
+{
+  if (Epsilon::equal(y2, ry) && x2 >= rx) {
+    // (x2,y2) is on the ray
+    if ((y1 > ry && y3 > ry) || (y1 < ry && y3 < ry))
+      return 0;
+    return 1;
+  }
+
+  if ((x1 < rx) && (x2 < rx)) return 0;
+  if ((y1 < ry) == (y2 < ry)) return 0;
+  if ((x1 > rx) && (x2 > rx)) return 1;
+  // by this point the end points are in diagonal quadrants around r
+
+  if (y1 < ry)
+    return ((x2 - rx)*(y1 - ry) < (x1 - rx)*(y2 - ry));
+
+  return ((x2 - rx)*(y1 - ry) > (x1 - rx)*(y2 - ry));
+}
+
+// small-batch form: crossing parity of the closed polygon with
+// vertices (x[i],y[i]), i = 0..n-1, for the point (rx,ry); true means
+// the point is inside
+inline bool PointInPolygonXY(const float* x, const float* y, int n,
+			     float rx, float ry)
+{
+  int crossings = 0;
+  for (int i = 0; i < n; i++) {
+    int j = (i+1 == n? 0: i+1);
+    int k = (j+1 == n? 0: j+1);
+    crossings += RayRightCrossesSegmentXY(x[i],y[i], x[j],y[j],
+					  x[k],y[k], rx,ry);
+  }
+  return bool(crossings % 2);
+}
+
+#endif // __MQMATH_H__
@@ -21,6 +21,9 @@
 #include <math.h>
 #include <vector>
 #include <stdio.h>
+#include <stdint.h>
+
+#include <boost/thread/thread.hpp>
 
 #include <art/UTM.h>
 #include <art/error.h>
@@ -30,9 +33,11 @@
 #include <art_map/FilteredPolygon.h>
 #include <art_map/DrawLanes.h>
 #include <art_map/Graph.h>
+#include <art_map/PolyIndex.h>
 #include <art_map/PolyOps.h>
 #include <art_map/RNDF.h>
 #include <art_map/SmoothCurve.h>
+#include <art_map/VisionIndex.h>
 #include <art_map/types.h>
 #include <art_map/zones.h>
 
@@ -48,18 +53,110 @@ public:
     range = r;
     transition=false;
     trans_index=-1;
+    local_valid_ = false;
+    draw_thread_ = NULL;
   };
   ~MapLanes()
   {
+     if (draw_thread_ != NULL)
+       {
+         draw_thread_->join();		// finish any image dump
+         delete draw_thread_;
+       }
      #ifdef DEBUGMAP
       fclose(debugFile);
      #endif
    };
 
-  int MapRNDF(Graph* _graph, float _max_poly_size=MIN_POLY_SIZE);
+  /** Generate polygons from the way-point graph.
+   *
+   *  @param _graph way-point graph from the RNDF
+   *  @param _max_poly_size maximum polygon length (m)
+   *  @param _build_threads worker threads for polygon generation:
+   *         1 runs serially, 0 uses one thread per hardware core
+   */
+  int MapRNDF(Graph* _graph, float _max_poly_size=MIN_POLY_SIZE,
+              int _build_threads=1);
+
+  /** Generate polygons, reusing a stale cache where possible.
+   *
+   *  For when the RNDF has been edited since the cache was written:
+   *  diffs the per-lane signatures stored in the cache against the
+   *  new way-point graph, splices the cached polygons of unchanged
+   *  lanes back in, and regenerates only the changed lanes (plus all
+   *  transitions, which attach to the lane polygons).  During map
+   *  tuning, when an edit touches a lane or two, this skips nearly
+   *  the whole generation pass.
+   *
+   *  Falls back to MapRNDF() when the cache is missing, incompatible
+   *  or predates lane signatures.
+   *
+   *  @param _graph way-point graph from the edited RNDF
+   *  @param cache_fName cache file written by SaveCache()
+   *  @param _max_poly_size maximum polygon length (m)
+   *  @param _build_threads worker threads for a fallback full build
+   */
+  int MapRNDFIncremental(Graph* _graph, const char* cache_fName,
+                         float _max_poly_size=MIN_POLY_SIZE,
+                         int _build_threads=1);
+
+  /** Save generated polygons to a versioned binary cache file.
+   *
+   *  The cache holds fixed-size records that LoadCache() reads back
+   *  in bulk, so a mapl restart need not regenerate the polygon set
+   *  from the RNDF.  Per-lane signatures written after the polygon
+   *  records let MapRNDFIncremental() salvage the unchanged lanes
+   *  after an RNDF edit.
+   *
+   *  @param fName cache file name
+   *  @param rndf_checksum checksum of the RNDF contents these
+   *         polygons were generated from (see FileChecksum())
+   *  @return true if the cache was written successfully
+   */
+  bool SaveCache(const char* fName, uint32_t rndf_checksum);
+
+  /** Load polygons from a binary cache file written by SaveCache().
+   *
+   *  Fails (returning false) unless the magic number, format version,
+   *  record sizes and RNDF checksum all match, so a stale or
+   *  incompatible cache silently falls back to regeneration.
+   *
+   *  @param fName cache file name
+   *  @param rndf_checksum checksum of the current RNDF contents
+   *  @param _graph way-point graph for the current RNDF
+   *  @return true if the polygons were loaded successfully
+   */
+  bool LoadCache(const char* fName, uint32_t rndf_checksum, Graph* _graph);
+
+  /** Checksum of a file's contents (FNV-1a), for keying the cache to
+   *  the exact RNDF it was generated from.
+   *
+   *  @param fName file to hash
+   *  @return 32-bit checksum, 0 if the file could not be read
+   */
+  static uint32_t FileChecksum(const char* fName);
 
   int getAllLanes(art_msgs::ArtLanes *lanes);
+
+  /** All generated polygons, for sharing without message conversion. */
+  const poly_list_t &getAllPolys(void) const {return allPolys;}
   int getLanes(art_msgs::ArtLanes *lanes, MapXY here);
+
+  /** Get lanes within an ellipse around the vehicle.
+   *
+   *  Like getLanes() with a position, but the extraction region is an
+   *  ellipse aligned with the vehicle heading, so callers can ship a
+   *  long narrow map at speed and a short wide one in zones instead
+   *  of one fixed circle.
+   *
+   *  @param lanes output road map message
+   *  @param here vehicle pose, orienting the ellipse
+   *  @param forward ellipse semi-axis along the heading (m)
+   *  @param lateral ellipse semi-axis across the heading (m)
+   */
+  int getLanes(art_msgs::ArtLanes *lanes, MapPose here,
+	       float forward, float lateral);
+
   int getVisionLanes(art_msgs::ArtLanes *lanes, float x, float y, float heading);
 
   void SetGPS(double centerX, double centerY)
@@ -78,6 +175,28 @@ public:
   //for testing purposes, outputs an image of all polygons
   void testDraw(bool with_trans = false);
   void testDraw(bool with_trans, const ZonePerimeterList &zones);
+
+  /** Run testDraw() on a background thread.
+   *
+   *  Image generation and the file writes can take seconds on a big
+   *  RNDF, so a node triggering a debug dump hands it off here and
+   *  keeps publishing.  The thread reads the polygon and graph data
+   *  in place, which is safe once map generation has finished (the
+   *  only time a dump makes sense).  A second dump requested while
+   *  one is still writing waits for it to finish first.
+   */
+  void testDrawBackground(bool with_trans, const ZonePerimeterList &zones);
+
+  /** Render the testDraw() images as parallel tiles.
+   *
+   *  Splits each image into @a threads horizontal bands, renders the
+   *  bands concurrently into per-tile files, then stitches them into
+   *  binary PPM images equivalent to the testDraw() output.  A tile
+   *  file left by an interrupted run is reused instead of re-rendered,
+   *  so a killed dump resumes where it stopped.
+   */
+  void testDrawTiled(bool with_trans, const ZonePerimeterList &zones,
+                     int threads);
   void UpdateWithCurrent(int i);
 
   void UpdatePoly(polyUpdate upPoly, float rX, float rY, float rOri);
@@ -89,6 +208,8 @@ private:
 
   float max_poly_size;
 
+  int build_threads;
+
   float range;
 
   bool transition;
@@ -98,8 +219,59 @@ private:
 
   float rX,rY,rOri;
 
+  boost::thread *draw_thread_;		// background testDraw() worker
+
+  /** Image extent shared by testDraw() and testDrawTiled(): bounding
+   *  box of the graph and polygons, padded to the minimum image size,
+   *  with the pixels-per-meter ratio capped for very large courses.
+   */
+  void drawExtent(float &min_x, float &max_y,
+                  int &xsize, int &ysize, float &ratio);
+
+  /** One horizontal band of a tiled image dump. */
+  struct DrawTileSpec
+  {
+    int row0;				// first pixel row of the band
+    int rows;				// band height in pixel rows
+    float min_x;			// world-to-image offsets
+    float max_y;
+    int xsize;				// full image extent in meters
+    int ysize;
+    float ratio;			// pixels per meter
+    bool with_trans;
+    std::string edge_file;		// tile output files
+    std::string poly_file;
+  };
+
+  void drawTile(DrawTileSpec spec);
+
   void MakePolygons();
 
+  /** One independent unit of polygon generation: either a run of
+   *  same-lane waypoints or a single transition edge.  MakePolygons()
+   *  collects these in edge order, then processes them serially or
+   *  hands the lane runs to worker threads.
+   */
+  struct LaneWork
+  {
+    bool is_transition;
+    std::vector<WayPointNode> lane;
+    std::vector<Point2f> lane_pt;
+    std::vector<int> lane_map;
+    WayPointEdge e;
+    std::vector<WayPointEdge> pair_edges; // per-segment edges, final run only
+    int base_ind;			// transitions: exit way-point index
+    int chain;				// runs sharing a way-point: one chain
+  };
+
+  void CollectPolygonWork(std::vector<LaneWork> &work);
+  void ProcessLaneWork(const LaneWork &work);
+  void RunPolygonChains(std::vector<LaneWork> &work, int nthreads);
+  void PolygonChainWorker(const std::vector<LaneWork> *work,
+			  const std::vector<std::vector<int> > *chains,
+			  std::vector<std::vector<poly> > *results,
+			  int tid, int nthreads);
+
   poly build_waypoint_poly(const WayPointNode& w1, const WayPointEdge &e,
 			   const Point2f& _pt,
 			   float time,
@@ -121,6 +293,20 @@ private:
   void SetFilteredPolygons();
 
   PolyOps ops;
+
+  // incremental local-lane extraction state: the previous getLanes()
+  // result is patched in place instead of rescanning every filtered
+  // polygon each cycle
+  PolyIndex local_index_;		// spatial index over allPolys
+  bool local_valid_;			// previous local result usable?
+  std::vector<int> local_set_;		// sorted member indices of result
+  art_msgs::ArtLanes local_msg_;	// previous local lanes message
+  std::vector<int> local_scratch_;	// candidate scratch list
+
+  // camera frustum extraction: bearing-sector index so
+  // getVisionLanes() can run at camera frame rate
+  VisionIndex vision_index_;		// sector index over allPolys
+  std::vector<int> vision_scratch_;	// candidate scratch list
   
   // File Writing / Reading
   bool WriteToFile(char* fName);
@@ -0,0 +1,113 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  \file
+
+     Structure-of-arrays companion container for MapLanes polygons.
+
+     The poly class mixes four vertices, midpoint, heading, IDs and
+     boundary markings in one struct of roughly a hundred bytes, but
+     the closest-poly distance scans only need midpoints.  Streaming
+     whole poly structs through cache wastes most of the bandwidth on
+     our 5000-poly maps.  PolyArrays keeps the midpoint coordinates
+     (plus headings, IDs and a conservative per-poly radius) in
+     separate contiguous arrays, so a scan touches only the data it
+     uses.
+
+     \author Jack O'Quin
+
+ */
+
+#ifndef __POLYARRAYS_H__
+#define __POLYARRAYS_H__
+
+#include <vector>
+
+#include <art_map/PolyOps.h>
+
+/** Structure-of-arrays view of a polygon list.
+ *
+ *  Built once per lanes message from a poly_list_t.  Like PolyIndex,
+ *  it refers to the vector it was built from and must be rebuilt
+ *  whenever that vector changes.
+ */
+class PolyArrays
+{
+ public:
+
+  PolyArrays();
+  ~PolyArrays();
+
+  /** Build the arrays from a polygon list.
+   *
+   *  @param polys polygons to mirror; the caller must keep this
+   *               vector alive and unmodified while the arrays are in
+   *               use
+   */
+  void rebuild(const poly_list_t &polys);
+
+  /** Discard the array contents. */
+  void clear(void);
+
+  /** True if the arrays were built from this polygon vector and are
+   *  still current. */
+  bool matches(const poly_list_t &polys) const
+  {
+    return (polys_ == &polys && mid_x_.size() == polys.size());
+  }
+
+  /** True if no polygons are mirrored. */
+  bool empty(void) const
+  {
+    return mid_x_.empty();
+  }
+
+  /** Number of polygons mirrored. */
+  size_t size(void) const
+  {
+    return mid_x_.size();
+  }
+
+  /** Collect indices of polygons that could be closest to (x, y).
+   *
+   *  Scans only the contiguous midpoint arrays.  Since each midpoint
+   *  lies inside its polygon, the exact distance to polygon i is at
+   *  most the midpoint distance and at least the midpoint distance
+   *  minus the polygon radius.  Everything outside those bounds is
+   *  filtered out before any point-in-quadrilateral work.
+   *
+   *  @param x, y MapXY coordinates of query point
+   *  @param[out] candidates polygon indices, cleared first
+   */
+  void getCandidatesByMidpoint(float x, float y,
+                               std::vector<int> &candidates) const;
+
+  /** Midpoint coordinates of polygon i. */
+  float midX(int i) const {return mid_x_[i];}
+  float midY(int i) const {return mid_y_[i];}
+
+  /** Heading of polygon i. */
+  float heading(int i) const {return heading_[i];}
+
+  /** MapLanes ID of polygon i. */
+  poly_id_t polyId(int i) const {return poly_id_[i];}
+
+ private:
+
+  const poly_list_t *polys_;		// polygons these arrays mirror
+
+  // hot data in separate contiguous arrays
+  std::vector<float> mid_x_;		// midpoint x coordinates
+  std::vector<float> mid_y_;		// midpoint y coordinates
+  std::vector<float> radius_;		// midpoint-to-vertex upper bound
+  std::vector<float> heading_;		// polygon headings
+  std::vector<poly_id_t> poly_id_;	// MapLanes IDs
+};
+
+#endif // __POLYARRAYS_H__
@@ -0,0 +1,116 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  \file
+
+     C++ interface for a uniform-grid spatial index over MapLanes
+     polygons.
+
+     The navigator queries PolyOps::getContainingPoly() and
+     PolyOps::getClosestPoly() every cycle.  Scanning the whole
+     polygon list each time is O(n) with a point-in-quadrilateral test
+     per element, which gets expensive on full RNDF maps with
+     thousands of quads.  PolyIndex bins the polygons into a uniform
+     grid once per lanes message, so those queries only test the few
+     polygons overlapping nearby grid cells.
+
+     \author Jack O'Quin
+
+ */
+
+#ifndef __POLYINDEX_H__
+#define __POLYINDEX_H__
+
+#include <algorithm>
+#include <vector>
+
+#include <art_map/PolyOps.h>
+
+/** Uniform-grid spatial index for a polygon list.
+ *
+ *  The index holds a pointer to the vector it was built from.  It
+ *  must be rebuilt whenever that vector changes; matches() lets
+ *  callers detect a stale index.
+ */
+class PolyIndex
+{
+ public:
+
+  PolyIndex();
+  ~PolyIndex();
+
+  /** Build the index over a polygon list.
+   *
+   *  @param polys polygons to index; the caller must keep this vector
+   *               alive and unmodified while the index is in use
+   *  @param cell_size grid cell edge length in meters
+   */
+  void rebuild(const poly_list_t &polys, float cell_size = 4.0);
+
+  /** Discard the index contents. */
+  void clear(void);
+
+  /** True if the index was built from this polygon vector and is
+   *  still current. */
+  bool matches(const poly_list_t &polys) const
+  {
+    return (polys_ == &polys && indexed_size_ == polys.size());
+  }
+
+  /** True if no polygons are indexed. */
+  bool empty(void) const
+  {
+    return (indexed_size_ == 0);
+  }
+
+  /** Collect indices of polygons whose bounding boxes overlap the
+   *  grid cell containing (x, y).
+   *
+   *  @param x, y MapXY coordinates of query point
+   *  @param[out] candidates polygon indices, cleared first
+   */
+  void getCandidates(float x, float y, std::vector<int> &candidates) const;
+
+  /** Collect indices of polygons overlapping any cell within radius
+   *  of (x, y).
+   *
+   *  @param x, y MapXY coordinates of query point
+   *  @param radius search radius in meters
+   *  @param[out] candidates polygon indices, cleared first, may
+   *              contain duplicates of polygons spanning cells
+   */
+  void getCandidates(float x, float y, float radius,
+                     std::vector<int> &candidates) const;
+
+  /** Grid cell edge length in meters. */
+  float cellSize(void) const {return cell_size_;}
+
+  /** Longest grid dimension in meters.  A candidate search with this
+   *  radius covers every cell. */
+  float maxExtent(void) const
+  {
+    return cell_size_ * std::max(cols_, rows_);
+  }
+
+ private:
+
+  // grid column and row of a map point, clamped to the grid
+  int col(float x) const;
+  int row(float y) const;
+
+  // cells are stored row-major: cells_[row * cols_ + col]
+  const poly_list_t *polys_;		// polygons this index describes
+  size_t indexed_size_;			// polys_->size() when built
+  float cell_size_;			// cell edge length (meters)
+  float min_x_, min_y_;			// grid origin (map coordinates)
+  int cols_, rows_;			// grid dimensions
+  std::vector<std::vector<int> > cells_; // polygon indices per cell
+};
+
+#endif // __POLYINDEX_H__
@@ -0,0 +1,183 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  \file
+
+     Direct-to-poly deserialization of the ArtLanes message.
+
+     Subscribing with art_map::PolyLanes instead of art_msgs::ArtLanes
+     deserializes incoming lane quadrilaterals straight into internal
+     poly records.  The generated message type allocates a separate
+     Point32 vector for every quadrilateral, only for the poly
+     converting constructor to copy the values again; this reader
+     builds each poly in place from the wire bytes, with one
+     allocation for the whole list.
+
+     The type is wire-compatible with art_msgs/ArtLanes: publishers
+     need no change, and either type can subscribe to the same topic.
+     It is for receiving only; publish art_msgs::ArtLanes as before.
+
+     \author Jack O'Quin
+
+ */
+
+#ifndef _POLY_LANES_H_
+#define _POLY_LANES_H_
+
+#include <ros/ros.h>
+#include <art_msgs/ArtLanes.h>
+#include <art_map/PolyOps.h>
+
+namespace art_map
+{
+
+  /** ArtLanes received directly as internal poly records. */
+  struct PolyLanes
+  {
+    std_msgs::Header header;		///< message header
+    poly_list_t polys;			///< lane polygons
+
+    typedef boost::shared_ptr<PolyLanes> Ptr;
+    typedef boost::shared_ptr<PolyLanes const> ConstPtr;
+  };
+
+} // namespace art_map
+
+namespace ros
+{
+namespace message_traits
+{
+
+  // Wire-compatible with art_msgs/ArtLanes: delegate the connection
+  // header values to the generated message type.
+  template<> struct MD5Sum<art_map::PolyLanes>
+  {
+    static const char *value()
+    {
+      return MD5Sum<art_msgs::ArtLanes>::value();
+    }
+    static const char *value(const art_map::PolyLanes &)
+    {
+      return value();
+    }
+  };
+
+  template<> struct DataType<art_map::PolyLanes>
+  {
+    static const char *value()
+    {
+      return DataType<art_msgs::ArtLanes>::value();
+    }
+    static const char *value(const art_map::PolyLanes &)
+    {
+      return value();
+    }
+  };
+
+  template<> struct Definition<art_map::PolyLanes>
+  {
+    static const char *value()
+    {
+      return Definition<art_msgs::ArtLanes>::value();
+    }
+    static const char *value(const art_map::PolyLanes &)
+    {
+      return value();
+    }
+  };
+
+  template<> struct HasHeader<art_map::PolyLanes>: TrueType {};
+
+} // namespace message_traits
+
+namespace serialization
+{
+
+  template<> struct Serializer<art_map::PolyLanes>
+  {
+    /** deserialize one ArtLanes message straight into poly records */
+    template<typename Stream>
+    static void read(Stream &stream, art_map::PolyLanes &m)
+    {
+      deserialize(stream, m.header);
+
+      uint32_t npolys;
+      deserialize(stream, npolys);
+      m.polys.resize(npolys);
+
+      for (uint32_t i = 0; i < npolys; ++i)
+	{
+	  poly &p = m.polys[i];
+
+	  // geometry_msgs/Polygon: vertex count, then Point32 points
+	  uint32_t npoints;
+	  deserialize(stream, npoints);
+	  geometry_msgs::Point32 pt;
+	  for (uint32_t k = 0; k < npoints; ++k)
+	    {
+	      deserialize(stream, pt);
+	      switch (k)
+		{
+		case art_msgs::ArtQuadrilateral::bottom_left:
+		  p.p1 = MapXY(pt);
+		  break;
+		case art_msgs::ArtQuadrilateral::top_left:
+		  p.p2 = MapXY(pt);
+		  break;
+		case art_msgs::ArtQuadrilateral::top_right:
+		  p.p3 = MapXY(pt);
+		  break;
+		case art_msgs::ArtQuadrilateral::bottom_right:
+		  p.p4 = MapXY(pt);
+		  break;
+		default:		// extra vertices ignored
+		  break;
+		}
+	    }
+
+	  geometry_msgs::Point midpoint;
+	  deserialize(stream, midpoint);
+	  p.midpoint = MapXY(midpoint);
+
+	  deserialize(stream, p.heading);
+	  deserialize(stream, p.length);
+
+	  int32_t poly_id;
+	  deserialize(stream, poly_id);
+	  p.poly_id = poly_id;
+
+	  uint8_t flag;
+	  deserialize(stream, flag);
+	  p.is_stop = flag;
+	  deserialize(stream, flag);
+	  p.is_transition = flag;
+	  deserialize(stream, flag);
+	  p.contains_way = flag;
+
+	  art_msgs::MapID way;
+	  deserialize(stream, way);
+	  p.start_way = ElementID(way);
+	  deserialize(stream, way);
+	  p.end_way = ElementID(way);
+
+	  art_msgs::LaneMarking marking;
+	  deserialize(stream, marking);
+	  p.left_boundary = Lane_marking(marking.lane_marking);
+	  deserialize(stream, marking);
+	  p.right_boundary = Lane_marking(marking.lane_marking);
+	}
+    }
+
+    // receive-only type: no write() or serializedLength() provided
+  };
+
+} // namespace serialization
+} // namespace ros
+
+#endif // _POLY_LANES_H_
@@ -27,12 +27,22 @@
 #include <map>
 
 #include <art_msgs/ArtLanes.h>
+#include <art_msgs/ArtLanesCompact.h>
 #include <art_map/coordinates.h>
 #include <art_map/types.h>
 
 /** Polygon class used internally.
  *
  *  These polygons are always quadrilaterals.
+ *
+ *  The class is sixteen-byte aligned with the four vertices leading
+ *  it, so the whole vertex block (eight floats) loads as two aligned
+ *  sixteen-byte vectors; vectorized quad-test and batch-transform
+ *  kernels reach it through vertexes().  Heap allocations on the
+ *  platforms we run are at least sixteen-byte aligned, so elements of
+ *  a poly_list_t keep the guarantee; code running elsewhere must fall
+ *  back to unaligned loads.
+ *
  *  @todo change the class name to something like Quad
  */
 class poly
@@ -40,7 +50,9 @@ class poly
 public:
 
   // Each polygon is a quadrilateral.  The four vertex points are
-  // ordered relative to the heading of the lane containing it.
+  // ordered relative to the heading of the lane containing it.  They
+  // must stay contiguous at the top of the class: vertexes() exposes
+  // them as an array.
   MapXY p1;    // bottom left
   MapXY p2;    // top left
   MapXY p3;    // top right
@@ -118,7 +130,20 @@ public:
     msg.left_boundary.lane_marking = left_boundary;
     msg.right_boundary.lane_marking = right_boundary;
   }
-};
+
+  /** vertex-array view of p1..p4, in vertex order */
+  const MapXY *vertexes(void) const {return &p1;}
+  MapXY *vertexes(void) {return &p1;}
+
+  /** the same block as a flat array of eight floats (x1, y1, ... y4),
+   *  sixteen-byte aligned, for vectorized kernels
+   */
+  const float *vertex_floats(void) const {return &p1.x;}
+
+} __attribute__((aligned(16)));
+
+// vectorized kernels depend on this layout
+typedef char _poly_layout_check[((sizeof(poly) & 15) == 0)? 1: -1];
 
 typedef std::vector<poly> poly_list_t;  // polygon vector type
 
@@ -133,6 +158,14 @@ typedef struct polyUpdate
 } lanes_poly_vision_t;
 
 
+class PolyIndex;			// forward declaration
+
+class PolyArrays;			// forward declaration
+
+class ShmRoadMap;			// forward declaration
+
+class WayPointIndex;			// forward declaration
+
 /** Polygon operations.
  *
  *  @todo This class has no state.  It should be replaced by a
@@ -144,6 +177,54 @@ class PolyOps
   PolyOps();
   ~PolyOps();
 
+  /** Attach a spatial index for accelerating containing-poly and
+   *  closest-poly queries.
+   *
+   *  The index is only consulted when the polygon vector passed to a
+   *  query is the one the index was built from; other queries fall
+   *  back to the linear scan.  The caller owns the index and must
+   *  rebuild it whenever its polygon list changes.
+   */
+  void attachIndex(const PolyIndex *index) {poly_index_ = index;}
+
+  /** Detach any spatial index, reverting to linear scans. */
+  void detachIndex(void) {poly_index_ = NULL;}
+
+  /** Attach a structure-of-arrays view for cache-friendly distance
+   *  scans.
+   *
+   *  Used by getClosestPoly() as a midpoint pre-filter when no grid
+   *  index answers the query.  Same ownership and staleness rules as
+   *  attachIndex().
+   */
+  void attachArrays(const PolyArrays *arrays) {poly_arrays_ = arrays;}
+
+  /** Detach any structure-of-arrays view. */
+  void detachArrays(void) {poly_arrays_ = NULL;}
+
+  /** Attach a way-point hash index for accelerating way-point to
+   *  polygon resolution.
+   *
+   *  Consulted by get_waypoint_index() and getPolyWayPt().  Same
+   *  ownership and staleness rules as attachIndex().
+   */
+  void attachWaypointIndex(const WayPointIndex *index)
+  {waypt_index_ = index;}
+
+  /** Detach any way-point index, reverting to linear scans. */
+  void detachWaypointIndex(void) {waypt_index_ = NULL;}
+
+  /** Forget the memoized closest-poly result.
+   *
+   *  Call whenever a polygon vector previously queried through this
+   *  PolyOps instance is modified or destroyed.
+   */
+  void clearClosestPolyMemo(void)
+  {
+    memo_polys_ = NULL;
+    memo_index_ = -1;
+  }
+
   int get_waypoint_index(const std::vector<poly> &polys,
 			 const ElementID& waypoint);
 
@@ -193,8 +274,24 @@ class PolyOps
 
   void GetPolys(const art_msgs::ArtLanes &lanes, poly_list_t &polyList);
 
+  /** Copy polygons from an attached shared-memory road map.
+   *
+   *  One bulk copy at attach time replaces receiving the whole global
+   *  map as a serialized message; code that only reads the map can
+   *  skip even that by using the records mapped in place
+   *  (ShmRoadMap::polys()).
+   */
+  void GetPolys(const ShmRoadMap &shm, poly_list_t &polyList);
+
   void GetLanes(poly_list_t &polyList, art_msgs::ArtLanes &lanes);
 
+  // Conversions between polygons and the compact fixed-point message,
+  // with coordinates as centimeter offsets from lanes.origin.
+  void GetPolys(const art_msgs::ArtLanesCompact &lanes,
+                poly_list_t &polyList);
+
+  void GetLanes(poly_list_t &polyList, art_msgs::ArtLanesCompact &lanes);
+
   // true if curPoly is in the specified segment and lane
   // Note: this ignores stop line polygons, we don't want to use them
   // for steering.  Why do they interfere?
@@ -430,6 +527,10 @@ class PolyOps
   {
     return getShortestDistToPoly(pt.x, pt.y, p);
   }
+
+  // squared version of getShortestDistToPoly(), for the closest-poly
+  // scans that only compare distances and can skip the square roots
+  float getShortestDistToPolySquared(float x, float y, const poly& p);
   //float getShortestDistToPoly(const player_pose2d_t &pose, const poly& p)
   //{
   //  return getShortestDistToPoly(pose.px, pose.py, p);
@@ -501,9 +602,23 @@ class PolyOps
   // returned list starts with polygon containing or closest to the
   // first point. if second point is not inside a polygon, new list
   // will extend to end of the old one
-  std::vector<poly> getPolysBetweenPoints(const std::vector<poly>& polys, 
-					  float x1, float y1, 
+  std::vector<poly> getPolysBetweenPoints(const std::vector<poly>& polys,
+					  float x1, float y1,
 					  float x2, float y2);
+
+  // Index-range variant of getPolysBetweenPoints(): sets start_idx
+  // and end_idx (inclusive, in list order) into polys instead of
+  // copying, so callers can walk the existing lane-ordered storage.
+  // When a hint index is given, the first point is found by bounded
+  // bidirectional search outward from it, so consecutive queries from
+  // a slowly moving pose touch only a few polygons.  Returns false if
+  // no polygon is near the first point; end_idx < start_idx denotes
+  // an empty range.
+  bool getPolyRangeBetweenPoints(const std::vector<poly>& polys,
+				 float x1, float y1,
+				 float x2, float y2,
+				 int hint,
+				 int &start_idx, int &end_idx);
 		
   // returns list polygon edge midpoints - ideally these can be used
   // by navigator as waypoints
@@ -567,6 +682,13 @@ class PolyOps
   // Return a Set of unique lane IDs corresponding to the polys in the list
   std::set<ElementID> getPolyLaneIds(const std::vector<poly>& polys);
 
+  // Fill lane_ids with the unique lane IDs for the polys in the list,
+  // sorted by packed 64-bit key.  Flat-vector alternative to
+  // getPolyLaneIds() that does no per-insert node allocation, for use
+  // in per-cycle code.
+  void getPolyLaneIdVector(const std::vector<poly>& polys,
+			   std::vector<ElementID>& lane_ids);
+
   // Return a unique lane ID corresponding to the polys/dir given
   // (uses transition polygons to determine closest lanes)
   // input:  a) neighborhood polygons
@@ -693,6 +815,64 @@ class PolyOps
 
  private:
 
+  // optional spatial index (owned by the caller), NULL when detached
+  const PolyIndex *poly_index_;
+
+  // memoized result of the previous getClosestPoly() call, used to
+  // seed the next search when the same polygon vector is queried
+  // again from a nearby pose (as the navigator does every cycle)
+  const std::vector<poly> *memo_polys_;	// vector last queried
+  size_t memo_size_;			// its size at that time
+  int memo_index_;			// result of that query
+  float memo_x_, memo_y_;		// query point of that query
+
+  // optional structure-of-arrays view (owned by the caller)
+  const PolyArrays *poly_arrays_;
+
+  // optional way-point hash index (owned by the caller)
+  const WayPointIndex *waypt_index_;
+
+  // closest-poly search through the attached spatial index
+  int getClosestPolyIndexed(const std::vector<poly>& polys,
+                            float x, float y);
+
+  // closest-poly search pre-filtered by the attached midpoint arrays
+  int getClosestPolySoA(const std::vector<poly>& polys,
+                        float x, float y);
+
+  // closest-poly search seeded from the memoized previous result;
+  // returns -1 when the memo cannot answer the query
+  int getClosestPolyMemoized(const std::vector<poly>& polys,
+                             float x, float y);
+
+  // index of the polygon containing (x, y), searched bidirectionally
+  // outward from the hint index; -1 if no polygon contains the point
+  int findPolyFromHint(const std::vector<poly>& polys,
+                       float x, float y, int hint);
+
+  // remember a closest-poly result for the next query
+  void memoizeClosestPoly(const std::vector<poly>& polys,
+                          float x, float y, int index)
+  {
+    memo_polys_ = &polys;
+    memo_size_ = polys.size();
+    memo_index_ = index;
+    memo_x_ = x;
+    memo_y_ = y;
+  }
+
+  // cached prefix sums of polygon lengths for the vector last passed
+  // to length_between_polygons(); prefix_len_[i] is the total length
+  // of polygons [0 .. i-1], so any range sum is a subtraction
+  const std::vector<poly> *prefix_polys_;  // vector last tabulated
+  size_t prefix_size_;			   // its size at that time
+  poly_id_t prefix_first_id_;		   // its first poly ID
+  poly_id_t prefix_last_id_;		   // its last poly ID
+  std::vector<float> prefix_len_;	   // the prefix sums
+
+  // rebuild the prefix-sum table when the poly list changes
+  void updatePrefixSums(const std::vector<poly>& polygons);
+
   // TODO: (after Urban Challenge) use Euclidean::DistanceTo()...
   // simple distance between two points
   float distance(float x1, float y1, float x2, float y2);
@@ -0,0 +1,102 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  \file
+
+     C++ interface for the shared-memory road map segment.
+
+     The global road map is generated once per run and never changes
+     afterwards, yet as a ROS message it is megabytes re-serialized to
+     every late-joining subscriber.  ShmRoadMap puts the polygon
+     records in a named POSIX shared memory segment instead: maplanes
+     creates and fills it, announces the name and version on a small
+     latched topic, and readers map the records read-only in place.
+
+     The segment holds a fixed header followed by raw poly records,
+     the same layout the binary map cache uses on disk, so a version
+     or record-size mismatch is detected before any record is read.
+
+     \author Jack O'Quin
+
+ */
+
+#ifndef __SHMROADMAP_H__
+#define __SHMROADMAP_H__
+
+#include <stdint.h>
+#include <string>
+
+#include <art_map/PolyOps.h>
+
+/** Shared-memory road map segment.
+ *
+ *  One instance is either the writer (create()) or a reader
+ *  (attach()).  The writer unlinks the segment when destroyed;
+ *  readers just unmap it.  Records are immutable once ready, so
+ *  readers need no locking.
+ */
+class ShmRoadMap
+{
+ public:
+
+  ShmRoadMap();
+  ~ShmRoadMap();
+
+  /** Create the segment and fill it with polygon records.
+   *
+   *  Replaces any stale segment of the same name left by a previous
+   *  run.  The ready flag in the header is set only after every
+   *  record is written, so a reader attaching mid-fill backs off.
+   *
+   *  @param name POSIX shared memory object name (e.g. "/art_roadmap")
+   *  @param polys polygon records to share
+   *  @param version map contents version (RNDF checksum)
+   *  @return true if the segment was created and filled
+   */
+  bool create(const std::string &name, const poly_list_t &polys,
+              uint32_t version);
+
+  /** Attach an announced segment read-only.
+   *
+   *  @param name segment name from the announcement
+   *  @param version expected map contents version
+   *  @return true if the segment was mapped and its header checks out
+   */
+  bool attach(const std::string &name, uint32_t version);
+
+  /** Unmap the segment (and unlink it, if this is the writer). */
+  void detach(void);
+
+  /** True while a segment is mapped. */
+  bool valid(void) const {return (polys_ != NULL);}
+
+  /** Polygon records mapped in place (NULL unless valid()). */
+  const poly *polys(void) const {return polys_;}
+
+  /** Number of mapped polygon records. */
+  uint32_t size(void) const {return count_;}
+
+  /** Map contents version of the mapped segment. */
+  uint32_t version(void) const {return version_;}
+
+  /** Total segment size in bytes. */
+  uint32_t segmentSize(void) const {return seg_size_;}
+
+ private:
+
+  std::string name_;			// shared memory object name
+  bool owner_;				// this instance created the segment
+  void *base_;				// mapped segment address
+  uint32_t seg_size_;			// mapped segment size (bytes)
+  const poly *polys_;			// polygon records within segment
+  uint32_t count_;			// number of records
+  uint32_t version_;			// map contents version
+};
+
+#endif // __SHMROADMAP_H__
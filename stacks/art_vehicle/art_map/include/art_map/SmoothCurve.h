@@ -37,9 +37,15 @@ public:
   void clear();
 
   float curveLength();
-    
+
   Point2f evaluatePoint(float time);
 
+  /** Evaluate unsigned curvature (1/m) of the curve at time. */
+  float evaluateCurvature(float time);
+
+  /** Evaluate n points at uniform spacing on [t0,t1] into out[]. */
+  void evaluateRange(float t0, float t1, int n, Point2f out[]);
+
   int knotCount() const;
 
   std::vector<float> knots;
@@ -51,7 +57,16 @@ private:
   int dataPointsCount() const;
   
   std::vector<Point2f> dataPoints;
-  std::vector<Point2f> controlPoints; 
+  std::vector<Point2f> controlPoints;
+
+  // Power-basis coefficients baked from the Bezier segments by the
+  // constructor, four per segment, plus the reciprocal of each knot
+  // span.  evaluatePoint() reads these instead of recomputing the
+  // Bernstein basis.
+  std::vector<Point2f> coeffs;
+  std::vector<float> inv_span;
+
+  void compileCoefficients();
 
   int degree;
   
@@ -0,0 +1,113 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  \file
+
+     C++ interface for a bearing-sector index over MapLanes polygons.
+
+     MapLanes::getVisionLanes() extracts the polygons inside the
+     camera frustum for the vision lane tracker.  Scanning the whole
+     polygon list with an angle test per element is too slow to run
+     at camera frame rate, so VisionIndex buckets the polygons by
+     bearing as seen from each cell of a coarse grid.  A frustum
+     query then touches only the buckets overlapping the camera
+     heading, leaving the exact angle and distance tests to run over
+     a short candidate list.
+
+     \author Jack O'Quin
+
+ */
+
+#ifndef __VISIONINDEX_H__
+#define __VISIONINDEX_H__
+
+#include <vector>
+
+#include <art_map/PolyOps.h>
+
+/** Bearing-sector index for camera frustum queries.
+ *
+ *  The index holds a pointer to the vector it was built from.  It
+ *  must be rebuilt whenever that vector changes; matches() lets
+ *  callers detect a stale index.
+ */
+class VisionIndex
+{
+ public:
+
+  VisionIndex();
+  ~VisionIndex();
+
+  /** Build the index over a polygon list.
+   *
+   *  Transition and way-point polygons are left out: frustum queries
+   *  never return them.
+   *
+   *  @param polys polygons to index; the caller must keep this vector
+   *               alive and unmodified while the index is in use
+   *  @param range maximum query distance in meters
+   *  @param cell_size grid cell edge length in meters
+   *  @param nsectors bearing sectors per grid cell
+   */
+  void rebuild(const poly_list_t &polys, float range,
+               float cell_size = 8.0, int nsectors = 16);
+
+  /** Discard the index contents. */
+  void clear(void);
+
+  /** True if the index was built from this polygon vector and is
+   *  still current. */
+  bool matches(const poly_list_t &polys) const
+  {
+    return (polys_ == &polys && indexed_size_ == polys.size());
+  }
+
+  /** True if no polygons are indexed. */
+  bool empty(void) const
+  {
+    return (indexed_size_ == 0);
+  }
+
+  /** Collect indices of polygons bucketed near a camera heading.
+   *
+   *  Each polygon was entered into every sector its bearing can
+   *  occupy from anywhere in the cell, so no polygon passing the
+   *  exact frustum tests is ever missed; duplicates are possible for
+   *  polygons spanning sectors.
+   *
+   *  @param x, y MapXY coordinates of the camera
+   *  @param heading camera heading (radians)
+   *  @param half_angle half the frustum opening angle (radians)
+   *  @param[out] candidates polygon indices, cleared first
+   */
+  void query(float x, float y, float heading, float half_angle,
+             std::vector<int> &candidates) const;
+
+ private:
+
+  // grid column and row of a map point, clamped to the grid
+  int col(float x) const;
+  int row(float y) const;
+
+  // sector of a bearing in [-pi, pi]
+  int sector(float bearing) const;
+
+  // buckets are stored row-major by cell, then by sector:
+  // buckets_[(row * cols_ + col) * nsectors_ + sector]
+  const poly_list_t *polys_;		// polygons this index describes
+  size_t indexed_size_;			// polys_->size() when built
+  float cell_size_;			// cell edge length (meters)
+  float min_x_, min_y_;			// grid origin (map coordinates)
+  int cols_, rows_;			// grid dimensions
+  int nsectors_;			// bearing sectors per cell
+  float sector_width_;			// sector arc width (radians)
+  std::vector<std::vector<int> > buckets_; // polygon indices per sector
+};
+
+#endif // __VISIONINDEX_H__
@@ -20,6 +20,10 @@
 #define EPSILON 0.5
 #define MAX_RANGE 160.0
 
+// Occupancy cells are stored in square tiles of this many cells per
+// side, allocated on first touch.
+#define VL_TILE_SIZE 32
+
 
 typedef double cell;
 
@@ -85,7 +89,14 @@ public:
    * threshold.
    **/
   cell value(int x, int y);
-  
+
+  /**
+   * Read-only variant of value() that never allocates a tile, so a
+   * concurrent reader (see VisualLanesStage) cannot race against the
+   * tile table while the raster thread is drawing.
+   **/
+  cell readValue(int x, int y);
+
   void setThreshold(int threshold);
   void setCellShift(int shift);
   
@@ -147,8 +158,25 @@ private:
   void lighten(int x, int y);
   cell* at(int x, int y);
   cell *atgoal(int x, int y);
-  
-  cell **_m;
+
+  // Cell storage.  The grid is kept in fixed-size tiles allocated the
+  // first time a cell inside them is written; a NULL entry in the tile
+  // table reads as OCCUPANCY_UNKNOWN.  clear() and the scroll clearing
+  // functions free whole tiles, so memory and clearing cost scale with
+  // the area actually touched rather than the full grid extent.
+  cell *touchTile(int tx, int ty);	// tile base address, allocating
+  cell *tileCell(int x, int y);		// allocating cell access
+  cell tileValue(int x, int y);		// read-only, never allocates
+  void clearRegion(int x0, int x1, int y0, int y1);
+
+  // Batch clearing kernel for addSickScan(): traces all scan rays
+  // with fixed-point stepping and a cached tile pointer instead of
+  // one line() callback per cell.
+  void lightenRays(const std::vector<double> &xs,
+		   const std::vector<double> &ys);
+
+  std::vector<cell *> _tiles;
+  int _ntiles;				// tiles per grid side
   double _physical_size;
   int _resolution;
   double _x;
@@ -0,0 +1,115 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef __VISUAL_LANES_STAGE_H__
+#define __VISUAL_LANES_STAGE_H__
+
+/**  @file
+
+     @brief staged front end for the VisualLanes occupancy grid.
+
+     VisualLanes mutates its raster and filter state directly inside
+     setPosition() and addSickScan(), so sensor callbacks serialize
+     against drawing.  This wrapper decouples them: callbacks append
+     compact update records to a lock-free single-producer ring, a
+     dedicated raster thread applies them in batches, and readers see
+     a versioned snapshot through a sequence lock.  Sensor intake cost
+     is one record copy regardless of how much drawing is in flight.
+
+     The producer interface assumes a single caller thread (the node's
+     subscription callback thread); the raster thread is the only
+     consumer.  Readers may run on any thread.
+
+     @author Jack O'Quin
+ */
+
+#include <stdint.h>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+#include <art_map/VisualLanes.h>
+
+class VisualLanesStage
+{
+public:
+  VisualLanesStage(double physical_size, int resolution);
+  ~VisualLanesStage();
+
+  // Producer interface, called from the sensor callback thread.
+  // Each call copies one record into the ring and returns; when the
+  // ring is full the record is dropped and counted instead.
+  void initialize(double x, double y, double theta);
+  void setPosition(double x, double y, double theta);
+  void addSickScan(const std::vector<double> &ranges);
+  void clear();
+
+  /**
+   * Read one cell from the current snapshot.
+   *
+   * Retries while the raster thread is mid-batch, so the value always
+   * comes from a consistent grid state.  Richer queries (isPathClear
+   * and friends) mutate grid internals and must run on the raster
+   * thread or while updates are idle.
+   **/
+  cell value(int x, int y);
+
+  /** Snapshot version, incremented after each applied batch. */
+  uint32_t version() const {return version_ >> 1;}
+
+  /** Records dropped because the ring was full. */
+  uint32_t dropped() const {return dropped_;}
+
+  /** Block until every record queued so far has been applied. */
+  void flush();
+
+private:
+  enum RecordType
+    {
+      INITIALIZE,
+      SET_POSITION,
+      SICK_SCAN,
+      CLEAR_GRID
+    };
+
+  /** one queued update; fixed size so the ring needs no allocation */
+  struct UpdateRecord
+  {
+    int type;				// RecordType value
+    double x, y, theta;			// pose updates
+    double ranges[180];			// SICK_SCAN evidence
+  };
+
+  void push(const UpdateRecord &rec);
+  void rasterThread(void);
+
+  // ring size must be a power of two (indexes wrap modulo the size)
+  static const uint32_t QUEUE_SIZE = 64;
+
+  UpdateRecord queue_[QUEUE_SIZE];
+  volatile uint32_t head_;		// next slot to fill (producer)
+  volatile uint32_t tail_;		// next slot to apply (consumer)
+  volatile uint32_t dropped_;		// records dropped, ring full
+
+  // sequence lock: odd while a batch is being applied
+  volatile uint32_t version_;
+
+  // raster thread wakeup; the lock covers only the wait itself, never
+  // any drawing or intake work
+  boost::mutex wake_mutex_;
+  boost::condition wake_cond_;
+  volatile bool shutdown_;
+  boost::thread *thread_;
+
+  VisualLanes lanes_;			// the wrapped grid
+};
+
+#endif // __VISUAL_LANES_STAGE_H__
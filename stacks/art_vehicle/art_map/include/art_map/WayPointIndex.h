@@ -0,0 +1,97 @@
+/* -*- mode: C++ -*- */
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  \file
+
+     C++ interface for a way-point hash index over MapLanes polygons.
+
+     PolyOps::get_waypoint_index() and PolyOps::getPolyWayPt() scan
+     the whole polygon list comparing ElementIDs.  The navigator
+     resolves way-points to polygons in bursts whenever the plan or a
+     stop changes, so a replan pays dozens of those scans in one
+     cycle.  WayPointIndex hashes the way-point IDs once per lanes
+     message, making each resolution a single table lookup.
+
+     \author Jack O'Quin
+
+ */
+
+#ifndef __WAYPOINTINDEX_H__
+#define __WAYPOINTINDEX_H__
+
+#include <tr1/unordered_map>
+
+#include <art_map/PolyOps.h>
+
+/** Way-point to polygon-index hash table for a polygon list.
+ *
+ *  Like PolyIndex, it refers to the vector it was built from and
+ *  must be rebuilt whenever that vector changes; matches() lets
+ *  callers detect a stale index.
+ */
+class WayPointIndex
+{
+ public:
+
+  WayPointIndex();
+  ~WayPointIndex();
+
+  /** Build the index over a polygon list.
+   *
+   *  @param polys polygons to index; the caller must keep this vector
+   *               alive and unmodified while the index is in use
+   */
+  void rebuild(const poly_list_t &polys);
+
+  /** Discard the index contents. */
+  void clear(void);
+
+  /** True if the index was built from this polygon vector and is
+   *  still current. */
+  bool matches(const poly_list_t &polys) const
+  {
+    return (polys_ == &polys && indexed_size_ == polys.size());
+  }
+
+  /** Index of the polygon containing a way-point.
+   *
+   *  Hashed equivalent of PolyOps::get_waypoint_index(): the first
+   *  polygon whose start and end way-points both equal @a waypoint.
+   *
+   *  @return polygon index, -1 if none
+   */
+  int containingPoly(const ElementID &waypoint) const;
+
+  /** Index of the first polygon starting at a way-point.
+   *
+   *  Hashed equivalent of PolyOps::getPolyWayPt().
+   *
+   *  @return polygon index, -1 if none
+   */
+  int startingPoly(const ElementID &waypoint) const;
+
+ private:
+
+  /** way-point ID packed into one hashable integer */
+  static uint64_t key(const ElementID &id)
+  {
+    return (((uint64_t) (uint16_t) id.seg << 32)
+            | ((uint64_t) (uint16_t) id.lane << 16)
+            | (uint16_t) id.pt);
+  }
+
+  typedef std::tr1::unordered_map<uint64_t, int> waypt_map_t;
+
+  const poly_list_t *polys_;		// polygons this index describes
+  size_t indexed_size_;			// polys_->size() when built
+  waypt_map_t containing_;		// way-point contained by polygon
+  waypt_map_t starting_;		// way-point starting polygon
+};
+
+#endif // __WAYPOINTINDEX_H__
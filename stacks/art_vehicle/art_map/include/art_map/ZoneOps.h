@@ -156,10 +156,58 @@ namespace ZoneOps {
   ZonePerimeter build_zone_perimeter_from_zone(Graph &graph,
 					       Zone &zone);
 
+  /** Drop redundant perimeter vertices within @a tolerance meters of
+   *  the edge joining their neighbors.  Entry and exit way-points are
+   *  always kept.  Run once at load so every later containment query
+   *  and published perimeter sees the reduced vertex count.
+   */
+  void simplify_perimeter(ZonePerimeter &zone, float tolerance);
+
   int intersections_of_segment_and_ray_to_right(const MapXY &p1,
 						const MapXY &p2,
 						const MapXY &p3,
 						const MapXY &r);
 };
 
+/** Precomputed structure for repeated zone containment queries.
+ *
+ *  ZoneOps::containing_zone() ray-casts across every perimeter point
+ *  of every zone per call, which zone controllers pay each cycle.
+ *  rebuild() computes each zone's bounding box and sorts its
+ *  perimeter edges by minimum y, so a query outside all the boxes is
+ *  rejected with a few comparisons and the ray cast only visits the
+ *  edges whose y-range spans the query point.  Results match
+ *  ZoneOps::point_in_zone() exactly.
+ */
+class ZoneIndex
+{
+public:
+  ZoneIndex() {}
+
+  void rebuild(const ZonePerimeterList &zones);
+  void clear();
+  bool empty() const {return zones_.empty();}
+
+  /** id of the zone containing @a point, or -1 if none */
+  segment_id_t containing_zone(const MapXY &point) const;
+
+  /** true if @a point is inside zone list entry @a zone_num */
+  bool point_in_zone(unsigned zone_num, const MapXY &point) const;
+
+private:
+  ZonePerimeterList zones_;		// copy of the indexed zones
+
+  // per-zone bounding boxes
+  std::vector<float> min_x_, max_x_, min_y_, max_y_;
+
+  // per-zone perimeter edges sorted by minimum y, with a running
+  // maximum of edge maximum y for the backward candidate walk
+  std::vector<std::vector<int> > edge_order_;
+  std::vector<std::vector<float> > edge_min_y_;
+  std::vector<std::vector<float> > edge_running_max_y_;
+
+  // overall bounding box of every zone
+  float all_min_x_, all_max_x_, all_min_y_, all_max_y_;
+};
+
 #endif /* __ZONEOPS_H__ */
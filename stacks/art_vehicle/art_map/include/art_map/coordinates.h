@@ -70,8 +70,12 @@ public:
  *
  * We define our own class to emphasize its role in the system and the
  * fact that its origin is relative to the map for this run.
+ *
+ * The (x, y) pair is kept eight-byte aligned so a point always loads
+ * with a single aligned vector instruction and never straddles a
+ * cache line in arrays of points or polygon vertices.
  */
-class MapXY				
+class MapXY
 {
 public:
   float x;
@@ -116,8 +120,11 @@ public:
     pt.y = y;
     pt.z = 0;
   }
- 
-};
+
+} __attribute__((aligned(8)));
+
+// vectorized kernels depend on this layout
+typedef char _mapxy_layout_check[(sizeof(MapXY) == 2*sizeof(float))? 1: -1];
 
 typedef std::vector<MapXY> mapxy_list_t;
 
@@ -127,8 +134,12 @@ typedef std::vector<MapXY> mapxy_list_t;
  * These are two-dimensional poses relative to the MapXY origin with a
  * yaw angle in radians.  We define our own class to define useful
  * initializers.
+ *
+ * The pose is padded out to sixteen bytes so (x, y, yaw) loads as one
+ * aligned vector, letting batch-transform kernels process arrays of
+ * poses with aligned vector instructions.
  */
-class MapPose				
+class MapPose
 {
 public:
   MapXY map;
@@ -143,7 +154,7 @@ public:
     map = MapXY(pose.position);
     yaw = tf::getYaw(pose.orientation);
   };
-};
+} __attribute__((aligned(16)));
 
 /** egocentric polar coordinates
  *
@@ -211,21 +222,38 @@ namespace Coordinates
   }
 
   // transform MapXY coordinate to egocentric Polar
-  inline Polar MapXY_to_Polar(MapXY point,
-                              const nav_msgs::Odometry &origin)
+  //
+  // Cheaper overload for loops: hoist the MapPose conversion (which
+  // includes a quaternion to yaw transform) out of the per-point work.
+  inline Polar MapXY_to_Polar(MapXY point, const MapPose &origin)
   {
     // TODO: figure out how to use Euclidean::DistanceTo() function,
-    // (it is not working here for some reason) 
+    // (it is not working here for some reason)
 
     //PFB: It's because there are circular header dependencies.
     //euclidean_distance.h needs this header file.
-    
-    MapPose orgpose = MapPose(origin.pose.pose);
-    MapXY diff = point - orgpose.map;
-    return Polar(bearing(orgpose, point),
+
+    MapXY diff = point - origin.map;
+    return Polar(bearing(origin, point),
 		 sqrtf(diff.x*diff.x + diff.y*diff.y));
   }
 
+  // transform MapXY coordinate to egocentric Polar
+  inline Polar MapXY_to_Polar(MapXY point,
+                              const nav_msgs::Odometry &origin)
+  {
+    return MapXY_to_Polar(point, MapPose(origin.pose.pose));
+  }
+
+  // transform a whole array of MapXY coordinates to egocentric Polar,
+  // converting the origin pose only once
+  inline void MapXY_to_Polar(const MapXY *points, size_t n,
+                             const MapPose &origin, Polar *out)
+  {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = MapXY_to_Polar(points[i], origin);
+  }
+
   // transform egocentric Polar coordinate to MapXY
   inline MapXY Polar_to_MapXY(Polar polar, const MapPose &origin)
   {
@@ -237,6 +265,14 @@ namespace Coordinates
     return retval;
   }
 
+  // transform a whole array of egocentric Polar coordinates to MapXY
+  inline void Polar_to_MapXY(const Polar *polars, size_t n,
+                             const MapPose &origin, MapXY *out)
+  {
+    for (size_t i = 0; i < n; ++i)
+      out[i] = Polar_to_MapXY(polars[i], origin);
+  }
+
   inline float sign(float val)
   {
     return (val >= 0? 1.0f: -1.0f);
@@ -76,10 +76,34 @@ namespace Euclidean
 			       float &distanceSegment,
 			       float &distanceLine)
   {
-    return DistanceFromLine(c.x,c.y,a.x,a.y,b.x,b.y,distanceSegment, 
+    return DistanceFromLine(c.x,c.y,a.x,a.y,b.x,b.y,distanceSegment,
 			    distanceLine);
   }
 
+  /** squared distance from the point (cx,cy) to the line segment from
+   *  (ax,ay) to (bx,by), for callers that only compare distances and
+   *  can skip the square roots
+   */
+  float inline DistanceFromLineSquared(float cx, float cy,
+				       float ax, float ay,
+				       float bx, float by)
+    {
+      float r_numerator = (cx-ax)*(bx-ax) + (cy-ay)*(by-ay);
+      float r_denomenator = (bx-ax)*(bx-ax) + (by-ay)*(by-ay);
+
+      // projection falls on the segment: squared point-line distance
+      if (r_numerator >= 0 && r_numerator <= r_denomenator)
+	{
+	  float s = (ay-cy)*(bx-ax)-(ax-cx)*(by-ay);
+	  return (s*s) / r_denomenator;
+	}
+
+      // otherwise the nearest endpoint wins
+      float dist1 = (cx-ax)*(cx-ax) + (cy-ay)*(cy-ay);
+      float dist2 = (cx-bx)*(cx-bx) + (cy-by)*(cy-by);
+      return (dist1 < dist2? dist1: dist2);
+    }
+
   /** find the Euclidean distance between poses p1 and p2 */
   float inline DistanceTo(MapPose p1, MapPose p2)
     {
@@ -103,6 +127,45 @@ namespace Euclidean
       return sqrtf(dist.x*dist.x + dist.y*dist.y);
     }
 
+  /** find the squared Euclidean distance between poses p1 and p2 */
+  float inline DistanceToSquared(MapPose p1, MapPose p2)
+    {
+      float x_dist = p1.map.x - p2.map.x;
+      float y_dist = p1.map.y - p2.map.y;
+      return (x_dist*x_dist + y_dist*y_dist);
+    }
+
+  /** find the squared Euclidean distance between poses p1 and p2 */
+  float inline DistanceToSquared(float p1x, float p1y, float p2x, float p2y)
+    {
+      float x_dist = p1x - p2x;
+      float y_dist = p1y - p2y;
+      return (x_dist*x_dist + y_dist*y_dist);
+    }
+
+  /** find the squared Euclidean distance between MapXY coordinates p1
+   *  and p2 */
+  float inline DistanceToSquared(MapXY p1, MapXY p2)
+    {
+      MapXY dist = p1 - p2;
+      return (dist.x*dist.x + dist.y*dist.y);
+    }
+
+  /** return true if p1 and p2 lie within limit of each other, without
+   *  taking a square root */
+  bool inline DistanceLessThan(float p1x, float p1y,
+			       float p2x, float p2y, float limit)
+    {
+      return (DistanceToSquared(p1x, p1y, p2x, p2y) < limit*limit);
+    }
+
+  /** return true if p1 and p2 lie within limit of each other, without
+   *  taking a square root */
+  bool inline DistanceLessThan(MapXY p1, MapXY p2, float limit)
+    {
+      return (DistanceToSquared(p1, p2) < limit*limit);
+    }
+
   /** return how many seconds it takes to move a distance at a given
    *  speed.
    */
@@ -25,6 +25,25 @@ public:
   gaussian(float,float);
   float get_sample_1D();
 
+  /** Fill out[0..n-1] with independent samples.
+   *
+   *  Generates the Box-Muller pairs directly into the output array,
+   *  without the one-sample cache get_sample_1D() keeps between
+   *  calls.
+   */
+  void get_samples_1D(float* out, int n);
+
+  /** Density of the Gaussian at x (exact, one expf() call). */
+  float evaluate(float x) const;
+
+  /** Evaluate the density for a batch of values.
+   *
+   *  Replaces the libm exp() call with a polynomial approximation
+   *  whose relative error stays below 1e-4, so the loop carries no
+   *  function call and vectorizes.
+   */
+  void evaluate(const float* x, float* out, int n) const;
+
 private:
   bool _ready;  //<! when getting sample, two are actually computed.
 		//<! this flag tells us if one is waiting.
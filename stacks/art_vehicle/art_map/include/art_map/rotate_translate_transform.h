@@ -33,6 +33,8 @@ public:
 		      const posetype&);
   posetype apply_transform(const posetype&) const;
   posetype apply_inverse_transform(const posetype&) const;
+  void apply_transform(const posetype* in, posetype* out, int n) const;
+  void apply_inverse_transform(const posetype* in, posetype* out, int n) const;
 };
 
 #endif
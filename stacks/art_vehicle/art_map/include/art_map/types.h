@@ -119,6 +119,18 @@ public:
       return this->lane > that.lane;
     else return this->pt > that.pt;
   }
+  /** Pack this ID into a single 64-bit key.  Useful for hashing and
+   *  for single-word identity comparison; note that null (-1) fields
+   *  pack high, so packed order differs from operator<() for invalid
+   *  IDs.
+   */
+  uint64_t pack(void) const
+  {
+    return ((uint64_t) (uint16_t) seg << 32
+	    | (uint64_t) (uint16_t) lane << 16
+	    | (uint64_t) (uint16_t) pt);
+  }
+
   bool valid() const
   {
     return (seg >= 0 && lane >= 0 && pt >= 0);
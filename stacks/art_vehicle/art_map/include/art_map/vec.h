@@ -4,22 +4,16 @@
 #include <algorithm>
 #include <iostream>
 #include <float.h>
+#include <string.h>
 #include <art/epsilon.h>
 
-//==========[ Forward References ]=========================
-
-template <class T> class Vec;
-template <class T> class Vec3;
-template <class T> class Vec4;
-template <class T> class Mat3;
-template <class T> class Mat4;
-
-//==========[ Exception Classes ]==========================
-
-class VectorSizeMismatch {};
-
 //==========[ class Vec2 ]=================================
 
+// Everything here is defined in the class body so it inlines into the
+// polygon generation inner loops, and nothing throws: the old
+// VectorSizeMismatch exception class and forward references to
+// three- and four-element types that were never written are gone.
+
 template <class T>
 class Vec2 {
 
@@ -46,7 +40,7 @@ class Vec2 {
     { n[0] += v.n[0]; n[1] += v.n[1]; return *this; }
   Vec2<T>& operator -= ( const Vec2<T>& v )
     { n[0] -= v.n[0]; n[1] -= v.n[1]; return *this; }
-  float operator * ( const Vec2<T>& v )
+  float operator * ( const Vec2<T>& v ) const
   { return (n[0] * v.n[0] + n[1] * v.n[1]);}
   Vec2<T>& operator *= ( const T d )
     { n[0] *= d; n[1] *= d; return *this; }
@@ -62,11 +56,11 @@ class Vec2 {
 
   //---[ Arithmetic Operators ]----------------
 
-  Vec2<T> operator-( const Vec2<T>& a ) { 
+  Vec2<T> operator-( const Vec2<T>& a ) const {
     return Vec2<T>(n[0]-a.n[0],n[1]-a.n[1]); }
-  Vec2<T> operator+( const Vec2<T>& a ) { 
+  Vec2<T> operator+( const Vec2<T>& a ) const {
     return Vec2<T>(a.n[0]+n[0],a.n[1]+n[1]); }
-  Vec2<T> operator*( const T d) {
+  Vec2<T> operator*( const T d) const {
     return Vec2<T>(d*n[0],d*n[1] );}
   //---[ Conversion Operators ]----------------
 
@@ -90,37 +84,14 @@ class Vec2 {
   }
   //---[Dot Product]--------------------------
 	
-  float dot(const Vec2<T>& a){
+  float dot(const Vec2<T>& a) const {
     return n[0]*a.n[0]+n[1]*a.n[1];
   }
 
   //---[ Zero Test ]---------------------------
 
-  bool iszero() { return ( (n[0]==0 && n[1]==0) ? true : false); };
+  bool iszero() const { return ( (n[0]==0 && n[1]==0) ? true : false); };
   void zeroElements() { memset(n,0,sizeof(T)*2); }
-
-  //---[ Friend Methods ]----------------------
-  /* not implemented
-     template <class U> friend T operator *( const Vec3<T>& a, const Vec4<T>& b );
-     template <class U> friend T operator *( const Vec4<T>& b, const Vec3<T>& a );
-     template <class U> friend Vec3<T> operator -( const Vec3<T>& v );
-     template <class U> friend Vec3<T> operator *( const Vec3<T>& a, const double d );
-     template <class U> friend Vec3<T> operator *( const double d, const Vec3<T>& a );
-     template <class U> friend Vec3<T> operator *( const Vec3<T>& v, Mat4<T>& a );
-     template <class U> friend T operator *( const Vec3<T>& a, const Vec3<T>& b );
-     template <class U> friend Vec3<T> operator *( const Mat3<T>& a, const Vec3<T>& v );
-     template <class U> friend Vec3<T> operator *( const Vec3<T>& v, const Mat3<T>& a );
-     template <class U> friend Vec3<T> operator *( const Mat4<T>& a, const Vec3<T>& v );
-     template <class U> friend Vec3<T> operator /( const Vec3<T>& a, const double d );
-     template <class U> friend Vec3<T> operator ^( const Vec3<T>& a, const Vec3<T>& b );
-     template <class U> friend bool operator ==( const Vec3<T>& a, const Vec3<T>& b );
-     template <class U> friend bool operator !=( const Vec3<T>& a, const Vec3<T>& b );
-     template <class U> friend ostream& operator <<( ostream& os, const Vec3<T>& v );
-     template <class U> friend istream& operator >>( istream& is, Vec3<T>& v );
-     template <class U> friend Vec3<T> minimum( const Vec3<T>& a, const Vec3<T>& b );
-     template <class U> friend Vec3<T> maximum( const Vec3<T>& a, const Vec3<T>& b );
-     template <class U> friend Vec3<T> prod( const Vec3<T>& a, const Vec3<T>& b );
-  */
 };
 
 typedef Vec2<int> Vec2i;
@@ -27,6 +27,10 @@
 
 #define DEFAULT_ZONE_SPEED 3.0f
 
+// Tolerance (in meters) for dropping redundant perimeter vertices
+// when building runtime zone perimeters from the RNDF.
+#define ZONE_PERIMETER_TOLERANCE 0.05f
+
 
 typedef std::vector<MapXY> ObstacleList;
 
@@ -1,13 +1,28 @@
 #include <art_map/DrawLanes.h>
 #include <art_map/euclidean_distance.h>
 
+#include <stdio.h>
 #include <iostream>
 
 DrawLanes::DrawLanes(int x, int y, float multi) {
   MULT=multi;
   imageWidth=int(ceil(x*MULT));
   imageHeight=int(ceil(y*MULT));
-  image = new RGB[imageWidth*imageHeight];
+  bandStart=0;
+  bandRows=imageHeight;
+  image = new RGB[imageWidth*bandRows];
+  clear();
+}
+
+DrawLanes::DrawLanes(int x, int y, float multi, int row0, int rows) {
+  MULT=multi;
+  imageWidth=int(ceil(x*MULT));
+  imageHeight=int(ceil(y*MULT));
+  bandStart=row0;
+  bandRows=rows;
+  if (bandStart+bandRows > imageHeight)	// last tile may run short
+    bandRows=imageHeight-bandStart;
+  image = new RGB[imageWidth*bandRows];
   clear();
 }
 
@@ -16,26 +31,30 @@ DrawLanes::~DrawLanes() {
   delete[] image;
 }
 
-void DrawLanes::clear() { 
-  for (int h=0; h<imageHeight; h++) {
+void DrawLanes::clear() {
+  for (int h=0; h<bandRows; h++) {
     for (int w=0; w<imageWidth; w++) {
       int index=h*imageWidth+w;
       image[index].r=255;
       image[index].g=255;
       image[index].b=255;
     }
-  } 
+  }
   // Stage crops white from around and image this fixes this by drawing a line
   // at the top and bottom of the image
   for (int w=0; w<imageWidth; w++) {
-    int index=w;
-    image[index].r=0;
-    image[index].g=0;
-    image[index].b=0;
-    index=((imageHeight-1)*imageWidth)+w;
-    image[index].r=0;
-    image[index].g=0;
-    image[index].b=0;
+    if (bandStart == 0) {
+      int index=w;
+      image[index].r=0;
+      image[index].g=0;
+      image[index].b=0;
+    }
+    if (bandStart+bandRows == imageHeight) {
+      int index=((bandRows-1)*imageWidth)+w;
+      image[index].r=0;
+      image[index].g=0;
+      image[index].b=0;
+    }
   }
 }
 
@@ -63,30 +82,59 @@ void DrawLanes::line(float x0, float y0, float x1, float y1, RGB colour)
     
     int xcell=(int)roundf(newx);
     int ycell=(int)roundf(newy);
-  
-    int index=imageWidth*ycell+xcell;
-    
+
+    // clip to the stored band (also guards a full image's edges)
+    if (xcell < 0 || xcell >= imageWidth
+	|| ycell < bandStart || ycell >= bandStart+bandRows)
+      continue;
+
+    int index=imageWidth*(ycell-bandStart)+xcell;
+
     image[index]=colour;
   }
 }
 
 void DrawLanes::savePGM(const char *filename) {
   FILE *f = fopen(filename, "w+");
+  if (f == NULL)
+    return;
 
   fprintf(f,"P3\n");
   fprintf(f,"#%s\n",filename);
   fprintf(f,"%i %i\n",imageWidth,imageHeight);
   fprintf(f,"%i\n",256); // Image width
-  for (int h=0; h<imageHeight; h++) {
+
+  // format each row into a memory buffer and write it as one block;
+  // a per-pixel fprintf call dominated the save time on large maps
+  std::vector<char> row(imageWidth*12 + 2);	// "255 255 255 " max
+  for (int h=0; h<bandRows; h++) {
+    char *p = &row[0];
     for (int w=0; w<imageWidth; w++) {
       int index=h*imageWidth+w;
-      fprintf(f,"%i %i %i ",image[index].r,image[index].g,image[index].b);
+      p += sprintf(p,"%i %i %i ",
+		   image[index].r,image[index].g,image[index].b);
     }
-    fprintf(f,"\n");
+    *p++ = '\n';
+    fwrite(&row[0], 1, p - &row[0], f);
   }
   fclose(f);
 }
 
+void DrawLanes::saveP6Rows(FILE *f) {
+  // binary triplets give every row the same size, so a stitcher (or a
+  // resume check) can reason about tile files by length alone
+  std::vector<unsigned char> row(imageWidth*3);
+  for (int h=0; h<bandRows; h++) {
+    for (int w=0; w<imageWidth; w++) {
+      int index=h*imageWidth+w;
+      row[w*3]   = (unsigned char) image[index].r;
+      row[w*3+1] = (unsigned char) image[index].g;
+      row[w*3+2] = (unsigned char) image[index].b;
+    }
+    fwrite(&row[0], 1, row.size(), f);
+  }
+}
+
 void DrawLanes::addTrace(float w1lat, float w1long, float w2lat, float w2long){
   RGB color;
   color.r=0;
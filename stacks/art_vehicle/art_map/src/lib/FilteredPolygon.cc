@@ -123,6 +123,69 @@ void FilteredPolygon::UpdatePoint(int pointID, float visionDistance,
 }
 
 
+// Batched update of all four points from one vision frame.  The
+// measurement model terms (Jacobians, predicted distance and bearing,
+// measurement variance) are computed for every point in one pass over
+// contiguous arrays, then the accept/reject and covariance updates
+// run point by point through the scalar-Jacobian KF fast path.
+void FilteredPolygon::UpdatePoints(const float visionDistance[NUM_POINTS],
+                                   const float visionAngle[NUM_POINTS],
+                                   const bool update[NUM_POINTS],
+                                   float confidence,
+                                   float rX, float rY, float rOri)
+{
+  // gather the filter states once
+  float px[NUM_POINTS], py[NUM_POINTS];
+  for (int i=0; i<NUM_POINTS; i++) {
+    px[i] = point[i].GetState(0);
+    py[i] = point[i].GetState(1);
+  }
+
+  // measurement model terms for all points; plain loops over local
+  // arrays that the compiler can vectorize
+  float cd0[NUM_POINTS], cd1[NUM_POINTS]; // distance Jacobian
+  float ca0[NUM_POINTS], ca1[NUM_POINTS]; // angle Jacobian
+  float estDist[NUM_POINTS];
+  float estAngle[NUM_POINTS];
+  float Rdist[NUM_POINTS];
+  for (int i=0; i<NUM_POINTS; i++) {
+    float dx = px[i] - rX;
+    float dy = py[i] - rY;
+    float distSqrd = dx*dx + dy*dy;
+    float dist = sqrt(distSqrd);
+    estDist[i] = dist;
+    if (dist == 0) dist = 0.00001;
+    if (distSqrd == 0) distSqrd = 0.00001;
+    cd0[i] = dx/dist;
+    cd1[i] = dy/dist;
+    ca0[i] = -dy/distSqrd;
+    ca1[i] = dx/distSqrd;
+    estAngle[i] = Normalise_PI(atan2(rY-py[i],rX-px[i]) - rOri);
+    Rdist[i] = visionDistance[i]*visionDistance[i]/50;
+  }
+
+  for (int i=0; i<NUM_POINTS; i++) {
+    if (!update[i]) continue;
+
+    // ---- Distance Update
+    distStruct.R=Rdist[i];
+    distStruct.Y=ABS(visionDistance[i]);
+    distStruct.Ybar=estDist[i];
+    distStruct.dist=visionDistance[i];
+    point[i].MeasurementUpdateExtended2(cd0[i],cd1[i],distStruct);
+    // ----
+
+    // ---- Angle Update
+    angleStruct.R=0.002*10;
+    angleStruct.Y=visionAngle[i];
+    angleStruct.Ybar=estAngle[i];
+    angleStruct.dist=visionDistance[i];
+    point[i].MeasurementUpdateExtended2(ca0[i],ca1[i],angleStruct);
+    // ----
+  }
+}
+
+
 // Jacobian for Distance and Angle, pass in the location of the robot
 // and then the current x,y of the point. Returns a matrix ..
 Matrix FilteredPolygon::GetDistanceJacobian(float xb, float yb,
@@ -10,8 +10,98 @@
 #include <art_map/euclidean_distance.h>
 #include <art_map/Graph.h>
 
+// comparators for the lookup indexes, usable with node or edge
+// positions and with the bare key being searched for
+namespace
+{
+  struct NodeIdLess
+  {
+    const WayPointNode* nodes;
+    bool operator()(int a, int b) const
+    {return nodes[a].id < nodes[b].id;}
+    bool operator()(int a, const ElementID &id) const
+    {return nodes[a].id < id;}
+  };
+
+  struct NodeIndexLess
+  {
+    const WayPointNode* nodes;
+    bool operator()(int a, int b) const
+    {return nodes[a].index < nodes[b].index;}
+    bool operator()(int a, const waypt_index_t index) const
+    {return nodes[a].index < index;}
+  };
+
+  struct EdgeStartLess
+  {
+    const std::vector<WayPointEdge>* edges;
+    bool operator()(int a, int b) const
+    {return (*edges)[a].startnode_index < (*edges)[b].startnode_index;}
+  };
+
+  // pack an ElementID into one integer, ordered the same way as
+  // ElementID::operator< (flipping the sign bit maps each int16_t
+  // field to a uint16_t preserving its order)
+  inline uint64_t pack_id(const ElementID &id)
+  {
+    return ((uint64_t)(uint16_t)(id.seg ^ 0x8000) << 32)
+      | ((uint64_t)(uint16_t)(id.lane ^ 0x8000) << 16)
+      | (uint64_t)(uint16_t)(id.pt ^ 0x8000);
+  }
+}
+
+void Graph::build_index() {
+  id_order.resize(nodes_size);
+  index_order.resize(nodes_size);
+  for(uint i=0; i<nodes_size; i++) {
+    id_order[i] = i;
+    index_order[i] = i;
+  }
+  NodeIdLess by_id = {nodes};
+  std::sort(id_order.begin(), id_order.end(), by_id);
+  // packed copies of the sorted keys: one integer compare per probe
+  // in get_node_by_id(), instead of field-by-field ElementID compares
+  id_keys.resize(nodes_size);
+  for(uint i=0; i<nodes_size; i++)
+    id_keys[i] = pack_id(nodes[id_order[i]].id);
+  NodeIndexLess by_index = {nodes};
+  std::sort(index_order.begin(), index_order.end(), by_index);
+
+  // group edge positions by start node, keeping the original edge
+  // order within each group (stable sort), then record where each
+  // distinct start node's group begins
+  adj_edges.resize(edges_size);
+  for(uint i=0; i<edges_size; i++)
+    adj_edges[i] = i;
+  EdgeStartLess by_start = {&edges};
+  std::stable_sort(adj_edges.begin(), adj_edges.end(), by_start);
+
+  adj_keys.clear();
+  adj_offset.clear();
+  for(uint i=0; i<edges_size; i++) {
+    int start = edges[adj_edges[i]].startnode_index;
+    if (adj_keys.empty() || adj_keys.back() != start) {
+      adj_keys.push_back(start);
+      adj_offset.push_back(i);
+    }
+  }
+  adj_offset.push_back(edges_size);
+
+  index_valid = true;
+};
+
 WayPointEdgeList Graph::edges_from(const waypt_index_t index) const {
   WayPointEdgeList new_edges;
+  if (index_valid) {
+    intList::const_iterator key =
+      std::lower_bound(adj_keys.begin(), adj_keys.end(), index);
+    if (key != adj_keys.end() && *key == index) {
+      int k = key - adj_keys.begin();
+      for(int i=adj_offset[k]; i<adj_offset[k+1]; i++)
+	new_edges.push_back(edges[adj_edges[i]]);
+    }
+    return new_edges;
+  }
   for(uint i=0; i<edges_size; i++) {
     if(edges[i].startnode_index == index)
       new_edges.push_back(edges[i]);
@@ -19,6 +109,24 @@ WayPointEdgeList Graph::edges_from(const waypt_index_t index) const {
   return new_edges;
 };
 
+void Graph::edge_positions_from(const waypt_index_t index, intList& out) const {
+  out.clear();
+  if (index_valid) {
+    intList::const_iterator key =
+      std::lower_bound(adj_keys.begin(), adj_keys.end(), index);
+    if (key != adj_keys.end() && *key == index) {
+      int k = key - adj_keys.begin();
+      for(int i=adj_offset[k]; i<adj_offset[k+1]; i++)
+	out.push_back(adj_edges[i]);
+    }
+    return;
+  }
+  for(uint i=0; i<edges_size; i++) {
+    if(edges[i].startnode_index == index)
+      out.push_back(i);
+  }
+};
+
 WayPointEdgeList Graph::edges_leaving_segment(const segment_id_t seg) const {
   WayPointEdgeList new_edges;
   for(uint i=0; i<edges_size; i++) {
@@ -29,13 +137,38 @@ WayPointEdgeList Graph::edges_leaving_segment(const segment_id_t seg) const {
 };
 
 WayPointNode* Graph::get_node_by_index(const waypt_index_t index) const {
-  for(uint i=0; i<nodes_size; i++) 
+  if (index_valid) {
+    NodeIndexLess by_index = {nodes};
+    intList::const_iterator pos =
+      std::lower_bound(index_order.begin(), index_order.end(),
+		       index, by_index);
+    if (pos != index_order.end() && nodes[*pos].index == index)
+      return &nodes[*pos];
+    return NULL;
+  }
+  for(uint i=0; i<nodes_size; i++)
     if(nodes[i].index == index)
       return &nodes[i];
   return NULL;
 };
 
 WayPointNode* Graph::get_node_by_id(const ElementID id) const {
+  if (index_valid) {
+    // branchless lower bound over the packed keys: the span shrinks
+    // by half each step and the base moves by a conditional add, so
+    // there is no mispredicted branch per probe
+    uint64_t key = pack_id(id);
+    uint base = 0;
+    uint len = nodes_size;
+    while (len > 1) {
+      uint half = len >> 1;
+      base += (id_keys[base + half - 1] < key) ? half : 0;
+      len -= half;
+    }
+    if (len == 1 && id_keys[base] == key)
+      return &nodes[id_order[base]];
+    return NULL;
+  }
   for(uint i=0; i<nodes_size; i++) {
     if(nodes[i].id == id)
       return &nodes[i];
@@ -232,7 +365,8 @@ bool Graph::load(const char* fName){
   else if (current_node != number_of_nodes) return false;
   else if (current_edge != number_of_edges) return false;
   //ONE MORE CONDITION: CHECK CURRENT_EDGE, CURRENT_NODE
-  else return true;
+  build_index();
+  return true;
 }
 
 void Graph::clear(){
@@ -242,7 +376,14 @@ void Graph::clear(){
   for(uint i = 0; i < edges_size; i++)
     edges[i].clear();
   edges_size = 0;
-  
+
+  index_valid = false;
+  adj_keys.clear();
+  adj_offset.clear();
+  adj_edges.clear();
+  id_order.clear();
+  index_order.clear();
+  id_keys.clear();
 }
 
 void Graph::printNodes(){
@@ -345,6 +486,8 @@ void Graph::xy_rndf() {
     
     edges[i].distance=Euclidean::DistanceTo(start->map,end->map);
   }
+
+  build_index();
 }
 
 /** Fill in MapXY coordinates for map graph.
@@ -366,8 +509,9 @@ void Graph::find_mapxy(void)
   // the graph.  Use temporaries because MapXY is defined in floats,
   // while the UTM function returns doubles.
   double tX;
-  double tY;  
-  UTM::UTM(nodes[0].ll.latitude, nodes[0].ll.longitude, &tX, &tY);
+  double tY;
+  UTM::UTMConverter utm;		// caches zone constants between points
+  utm.convert(nodes[0].ll.latitude, nodes[0].ll.longitude, tY, tX);
 
   // Round UTM origin of map to nearest UTM grid intersection.  All
   // odometry is reported relative to that location.
@@ -382,7 +526,7 @@ void Graph::find_mapxy(void)
   // boundary.
   for(uint i = 1; i < nodes_size; i++)
     {
-      UTM::UTM(nodes[i].ll.latitude, nodes[i].ll.longitude, &tX, &tY);
+      utm.convert(nodes[i].ll.latitude, nodes[i].ll.longitude, tY, tX);
       nodes[i].map = MapXY(tX - grid_x, tY - grid_y);
     }
 
@@ -394,6 +538,8 @@ void Graph::find_mapxy(void)
     //    std::cerr << "Edge "<<i<<" "<<start->id.name().str<<" "<<
     //      end->id.name().str<<" "<<edges[i].distance<<std::endl;
   }
+
+  build_index();
 }
 
 bool Graph::passing_allowed(int index, int index2, bool left) {
@@ -549,7 +695,9 @@ bool Graph::lanes_in_same_direction(int index1,int index2, bool& left_lane) {
 }
 
 void Graph::find_implicit_edges() {
-  
+  // new edges invalidate the adjacency index until rebuilt below
+  index_valid = false;
+
   for (unsigned i=0; i< nodes_size; i++)
     {
       WayPointNode node1=nodes[i];
@@ -637,6 +785,8 @@ void Graph::find_implicit_edges() {
 	  }
       }
     }
+
+  build_index();
 }
 
       
@@ -133,6 +133,9 @@ int KF::MeasurementUpdateExtended(Matrix& C, float R, float Y, float Ybar, bool
     cout << "Incorrect matrix dimensions in method MeasurementUpdateExtended()" << endl << flush;
     return KF_CRASH;
   }
+  // the lane filters are all two-state; take the stack-matrix path
+  if (numStates == 2)
+    return MeasurementUpdateExtended2(C, R, Y, Ybar, rejectOutliers, outlierSD, mainFilterAngleUpdate, ignoreLongRangeUpdate, deadzoneSize, dist, ambigObj, changeAlpha);
   //E.g. C is 1x5
   float innovation = Y - Ybar;
   float posVar = convDble(C*P*C.transp());
@@ -203,7 +206,117 @@ int KF::MeasurementUpdateExtended(Matrix& C, float R, float Y, float Ybar, bool
   return KF_SUCCESS;
 }
 
-// Resets the P matrix, basically increases the location uncertainty. 
+// Same update as MeasurementUpdateExtended() for the numStates == 2
+// case, with every intermediate product held in a FixedMatrix on the
+// stack.  The dynamic Matrix temporaries in the generic path malloc
+// and free on every multiply and transpose, and this update runs for
+// each vertex of every filtered polygon.
+int KF::MeasurementUpdateExtended2(Matrix& C, float R, float Y, float Ybar, bool rejectOutliers, float outlierSD, bool mainFilterAngleUpdate, bool ignoreLongRangeUpdate, float deadzoneSize, float dist, bool ambigObj, bool changeAlpha) {
+  return MeasurementUpdateExtended2(C[0][0], C[0][1], R, Y, Ybar, rejectOutliers, outlierSD, mainFilterAngleUpdate, ignoreLongRangeUpdate, deadzoneSize, dist, ambigObj, changeAlpha);
+}
+
+
+int KF::MeasurementUpdateExtended2(float c0, float c1, KFStruct s) {
+	return MeasurementUpdateExtended2(c0, c1, s.R, s.Y, s.Ybar, s.rejectOutliers, s.outlierSD, s.mainFilterAngleUpdate, s.ingoreLongRangeUpdate, s.deadzoneSize, s.dist, s.ambigObject, s.changeAlpha);
+}
+
+
+int KF::MeasurementUpdateExtended2(float c0, float c1, float R, float Y, float Ybar, bool rejectOutliers, float outlierSD, bool mainFilterAngleUpdate, bool ignoreLongRangeUpdate, float deadzoneSize, float dist, bool ambigObj, bool changeAlpha) {
+  float innovation = Y - Ybar;
+  // posVar = C*P*C' expanded for the 1x2 C
+  float posVar = c0*c0*P[0][0] + c0*c1*(P[0][1] + P[1][0]) + c1*c1*P[1][1];
+
+  if (mainFilterAngleUpdate) {
+    innovation = Normalise_PI(innovation);
+    R += SQUARE((P[0][0]+P[1][1])/(dist*dist));    // Moved from object update into here on 22/3/2007
+  }
+
+  Xchange[0][0] -= X[0][0];
+  Xchange[1][0] -= X[1][0];
+
+  if (posVar < 0.0) {
+    Reset();
+    posVar = c0*c0*P[0][0] + c0*c1*(P[0][1] + P[1][0]) + c1*c1*P[1][1];
+    cout << "KF reset due to negative variance" << endl << flush;
+  }
+  // add in deadzone calculations: RHM 1/6/06
+  Deadzone(&R, &innovation, posVar, deadzoneSize);
+
+  float varPredError = posVar + R;
+
+  // All gate tests are decided up front and reduced to one blend
+  // factor.  The update math below then runs unconditionally and the
+  // gated cases fall out of the arithmetic, so the per-vertex batch
+  // in the filter bank keeps a straight instruction stream no matter
+  // what each vertex decides.
+  bool ignore = (ignoreLongRangeUpdate
+                 && (innovation > S_D_RANGE_REJECT*sqrt(varPredError)));
+  bool outlier = (rejectOutliers
+                  && (innovation*innovation > outlierSD*outlierSD*varPredError));
+  bool gated = (ignore || outlier);
+  float apply = (gated ? 0.0f : 1.0f);	// compiles to a select
+
+  if (ignore)
+    cout << "Ignore Long range update" << endl << flush;
+
+  // RHM 7/7/07: Shifted alpha changes to here.  Gated updates halve
+  // alpha, applied ones scale it by the innovation-based factor.
+  float alphaFactor = 1.0f;
+  if (changeAlpha) {
+    alphaFactor = R/(R + innovation*innovation);
+    if (ambigObj)
+      alphaFactor = std::max(alphaFactor, 0.01f); //0.1);
+  }
+  alpha *= (gated ? 0.5f : alphaFactor);
+
+  FixedMatrix<2,2> p(P);
+  // J = P*C'/varPredError, a 2x1
+  FixedMatrix<2,1> J;
+  J[0][0] = (p[0][0]*c0 + p[0][1]*c1) / varPredError;
+  J[1][0] = (p[1][0]*c0 + p[1][1]*c1) / varPredError;
+  // newP = (I - J*C)*P
+  FixedMatrix<2,2> IJC;
+  IJC[0][0] = 1.0f - J[0][0]*c0;
+  IJC[0][1] =      - J[0][0]*c1;
+  IJC[1][0] =      - J[1][0]*c0;
+  IJC[1][1] = 1.0f - J[1][0]*c1;
+  FixedMatrix<2,2> newP = IJC*p;
+
+  // blend: a gated vertex keeps its old covariance and state
+  for (int i = 0; i < 2; i++)
+    for (int j = 0; j < 2; j++)
+      newP[i][j] = apply*newP[i][j] + (1.0f - apply)*p[i][j];
+
+  // the reset-and-retry path stays a branch: it is cold, and must
+  // not run for a gated update (whose covariance did not change)
+  if (!gated)
+    for (int i = 0; i < 2; i++) {
+      if (newP[i][i] <= 0) {
+        //cout << "Numerics error" << endl << flush;
+        Reset();
+        return MeasurementUpdateExtended2(c0, c1, R, Y, Ybar, rejectOutliers, outlierSD, mainFilterAngleUpdate, ignoreLongRangeUpdate, deadzoneSize, dist, ambigObj,changeAlpha);
+      }
+      for (int j = i+1; j < 2; j++)
+        if (newP[i][j]*newP[i][j] > newP[i][i]*newP[j][j]) {
+          //cout << "Numerics error" << ", KF reset" << endl << flush;
+          Reset();
+          return MeasurementUpdateExtended2(c0, c1, R, Y, Ybar, rejectOutliers, outlierSD, mainFilterAngleUpdate, ignoreLongRangeUpdate, deadzoneSize, dist, ambigObj,changeAlpha);
+        }
+    }
+
+  X[0][0] += apply*J[0][0]*innovation;
+  X[1][0] += apply*J[1][0]*innovation;
+  newP.copyTo(P);
+  // a gated update leaves Xchange decremented, as it always has
+  Xchange[0][0] += apply*X[0][0];
+  Xchange[1][0] += apply*X[1][0];
+
+  if (ignore)
+    return KF_SUCCESS;
+  return (outlier ? KF_OUTLIER : KF_SUCCESS);
+}
+
+// Resets the P matrix, basically increases the location uncertainty.
 // This sovles problems like the 'kidnappend robot' scenario.
 void KF::Reset() {
   P = initP;
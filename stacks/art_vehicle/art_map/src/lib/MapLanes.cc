@@ -14,11 +14,19 @@
 
  */
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <art/epsilon.h>
+#include <map>
+#include <set>
 #include <vector>
 
+#include <sys/stat.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <art_map/gaussian.h>
 #include <art_map/MapLanes.h>
 #include <art_map/euclidean_distance.h>
@@ -32,17 +40,36 @@
 
 #define way_poly_size 0.5 // half of length of polygon that goes
 			  // around waypoints
+
+// Curvature-adaptive polygon sizing.  POLY_CURVATURE is the lane
+// curvature (1/m) at which the nominal max_poly_size applies; nearly
+// straight spans may emit polygons up to STRAIGHT_POLY_FACTOR times
+// longer, while sharper curves subdivide below the nominal size,
+// never finer than MIN_POLY_SIZE.
+#define POLY_CURVATURE 0.02
+#define STRAIGHT_POLY_FACTOR 4.0
 int writecounter=0;
 int aCount=0;
 int bCount=0;
 int cCount=0;
     
-int MapLanes::MapRNDF(Graph* _graph, float _max_poly_size)
+int MapLanes::MapRNDF(Graph* _graph, float _max_poly_size,
+                      int _build_threads)
 {
   graph=_graph;
 
   max_poly_size=fmaxf(_max_poly_size, MIN_POLY_SIZE);
 
+  build_threads=_build_threads;
+  if (build_threads <= 0)
+    build_threads=boost::thread::hardware_concurrency();
+  if (build_threads < 1)
+    build_threads=1;
+#ifdef DEBUGMAP
+  // the debug file is shared state, keep generation serial
+  build_threads=1;
+#endif
+
   allPolys.clear();
   //filtPolys.clear();
 
@@ -69,20 +96,48 @@ int MapLanes::MapRNDF(Graph* _graph, float _max_poly_size)
 }
 
 void MapLanes::MakePolygons()
+{
+  // Collect the independent units of generation work in edge order,
+  // then process them.  Lane runs only couple through the last
+  // polygon of the preceding run when both cover the same way-point,
+  // so runs group into chains that can generate concurrently.
+  // Transitions look up the way-point polygons the runs create (the
+  // edge list puts transition edges after lane edges), so they always
+  // stay serial, after every lane run has finished.
+  std::vector<LaneWork> work;
+  CollectPolygonWork(work);
+
+  if (build_threads > 1)
+    {
+      RunPolygonChains(work, build_threads);
+      for (uint i = 0; i < work.size(); i++)
+	if (work[i].is_transition)
+	  ProcessLaneWork(work[i]);
+    }
+  else
+    {
+      for (uint i = 0; i < work.size(); i++)
+	ProcessLaneWork(work[i]);
+    }
+}
+
+/** Walk the graph edges, partitioning them into lane runs and
+ *  transitions exactly the way the old serial loop did, but emitting
+ *  work items instead of generating polygons inline.
+ */
+void MapLanes::CollectPolygonWork(std::vector<LaneWork> &work)
 {
   // Add Waypoints to WayPointImage
   std::vector<WayPointNode> lane;
   std::vector<Point2f> lane_pt;
   std::vector<int> lane_map;
 
-  SmoothCurve lc,rc;
-
   ElementID prev_lane;             // used to determine when the edges
                                    // switch lanes
 
   // Walk along graph edges, pushing nodes (and the associated points
   // that the curve code uses) from same lane onto a list, then
-  // process the list whenever a new lane is encountered (or an transition)
+  // emit the list whenever a new lane is encountered (or a transition)
   // or before leaving the function if the list isn't empty.
 
   for(uint j = 0; j < graph->edges_size; j++)
@@ -104,26 +159,18 @@ void MapLanes::MakePolygons()
 	      w1.id.pt != prev_lane.pt)
 	    //if new lane push start waypoint onto list
 	    {
-	      // If last lane info is still around, process it
+	      // If last lane info is still around, emit it
 	      if (lane.size()>1)
 		{
-		  Point2f diff_pt=lane_pt[1]-lane_pt[0];
-		  Point2f diff_pt2=lane_pt[lane_pt.size()-1]-
-		    lane_pt[lane_pt.size()-2];
-		  SmoothCurve c=
-		    SmoothCurve(lane_pt,
-				atan2f(diff_pt[1],diff_pt[0]), 1,
-				atan2f(diff_pt2[1],diff_pt2[0]), 1);
-		  
-		  for (uint i=0;i<lane.size()-1;i++)
-		    {
-		      MakeLanePolygon(lane[i],lane[i+1],e,
-				      c.knots[lane_map[i]],
-				      c.knots[lane_map[i+1]],
-				      c, true,
-				      0,0,lc,
-				      0,0,rc);
-		    }
+		  work.push_back(LaneWork());
+		  LaneWork &lw = work.back();
+		  lw.is_transition = false;
+		  lw.lane.swap(lane);
+		  lw.lane_pt.swap(lane_pt);
+		  lw.lane_map.swap(lane_map);
+		  lw.e = e;
+		  lw.base_ind = 0;
+		  lw.chain = -1;
 		}
 	      
 	      // Set up new lane
@@ -153,23 +200,17 @@ void MapLanes::MakePolygons()
 	// Transition; 
 	{
 	  if (lane.size()>1)
-	    // Process out previous lane if one exists
+	    // Emit previous lane if one exists
 	    {
-	      Point2f diff_pt=lane_pt[1]-lane_pt[0];
-	      Point2f diff_pt2=lane_pt[lane_pt.size()-1]-
-		lane_pt[lane_pt.size()-2];
-	      
-	      SmoothCurve c=
-		SmoothCurve(lane_pt,
-			    atan2f(diff_pt[1],diff_pt[0]), 1,
-			    atan2f(diff_pt2[1],diff_pt2[0]), 1);
-	      
-	      for (uint i=0;i<lane.size()-1;i++)
-		MakeLanePolygon(lane[i],lane[i+1],e,
-				c.knots[lane_map[i]],
-				c.knots[lane_map[i+1]],
-				c, true,
-				0,0,lc,0,0,rc);
+	      work.push_back(LaneWork());
+	      LaneWork &lw = work.back();
+	      lw.is_transition = false;
+	      lw.lane.swap(lane);
+	      lw.lane_pt.swap(lane_pt);
+	      lw.lane_map.swap(lane_map);
+	      lw.e = e;
+	      lw.base_ind = 0;
+	      lw.chain = -1;
 	    }
 	  
 	  // Make transition polygons
@@ -233,17 +274,15 @@ void MapLanes::MakePolygons()
 	    }
 	    
 	  
-	  Point2f diff_pt=lane_pt[1]-lane_pt[0];
-	  Point2f diff_pt2=lane_pt[lane_pt.size()-1]-
-	    lane_pt[lane_pt.size()-2];
-	  
-	  SmoothCurve c=
-	    SmoothCurve(lane_pt,
-			atan2f(diff_pt[1],diff_pt[0]), 1,
-			atan2f(diff_pt2[1],diff_pt2[0]), 1);
-	  
-	  MakeTransitionPolygon(lane[base_ind],lane[base_ind+1],e,
-				c.knots[lane_map[base_ind]],c.knots[lane_map[base_ind+1]],c);
+	  work.push_back(LaneWork());
+	  LaneWork &lw = work.back();
+	  lw.is_transition = true;
+	  lw.lane.swap(lane);
+	  lw.lane_pt.swap(lane_pt);
+	  lw.lane_map.swap(lane_map);
+	  lw.e = e;
+	  lw.base_ind = base_ind;
+	  lw.chain = -1;
 	  
 	  // Clear out transition
 	  lane.clear();
@@ -253,18 +292,17 @@ void MapLanes::MakePolygons()
 	}
     }
   
-  // If last lane info is still around, process it
+  // If last lane info is still around, emit it with the edge linking
+  // each waypoint pair looked up individually
   if (lane.size()>1)
     {
-      // Clear out previous lane
-      Point2f diff_pt=lane_pt[1]-lane_pt[0];
-      Point2f diff_pt2=lane_pt[lane_pt.size()-1]-
-	lane_pt[lane_pt.size()-2];
-      SmoothCurve c=
-	SmoothCurve(lane_pt,
-		    atan2f(diff_pt[1],diff_pt[0]), 1,
-		    atan2f(diff_pt2[1],diff_pt2[0]), 1);
-      
+      work.push_back(LaneWork());
+      LaneWork &lw = work.back();
+      lw.is_transition = false;
+      lw.base_ind = 0;
+      lw.chain = -1;
+
+      lw.pair_edges.resize(lane.size()-1);
       for (uint i=0;i<lane.size()-1;i++) {
 	// Find the edge that links lane[i] and lane[i+1]
 	WayPointEdge e;
@@ -281,18 +319,122 @@ void MapLanes::MakePolygons()
 	      
 	      break;
 	  }
-	
-	MakeLanePolygon(lane[i],lane[i+1],e,
-			c.knots[lane_map[i]],
-			c.knots[lane_map[i+1]],
-			c, true,0,0,lc,0,0,rc);
+	lw.pair_edges[i] = e;
       }
+
+      lw.lane.swap(lane);
+      lw.lane_pt.swap(lane_pt);
+      lw.lane_map.swap(lane_map);
+    }
+}
+
+/** Generate the polygons for one work item, appending to allPolys. */
+void MapLanes::ProcessLaneWork(const LaneWork &lw)
+{
+  const std::vector<WayPointNode> &lane = lw.lane;
+  const std::vector<Point2f> &lane_pt = lw.lane_pt;
+  const std::vector<int> &lane_map = lw.lane_map;
+
+  Point2f diff_pt=lane_pt[1]-lane_pt[0];
+  Point2f diff_pt2=lane_pt[lane_pt.size()-1]-
+    lane_pt[lane_pt.size()-2];
+  SmoothCurve c=
+    SmoothCurve(lw.lane_pt,
+		atan2f(diff_pt[1],diff_pt[0]), 1,
+		atan2f(diff_pt2[1],diff_pt2[0]), 1);
+
+  if (lw.is_transition)
+    {
+      MakeTransitionPolygon(lane[lw.base_ind],lane[lw.base_ind+1],lw.e,
+			    c.knots[lane_map[lw.base_ind]],
+			    c.knots[lane_map[lw.base_ind+1]],c);
+      return;
+    }
+
+  SmoothCurve lc,rc;
+  for (uint i=0;i<lane.size()-1;i++)
+    {
+      const WayPointEdge &e =
+	lw.pair_edges.empty()? lw.e: lw.pair_edges[i];
+      MakeLanePolygon(lane[i],lane[i+1],e,
+		      c.knots[lane_map[i]],
+		      c.knots[lane_map[i+1]],
+		      c, true,
+		      0,0,lc,
+		      0,0,rc);
+    }
+}
+
+/** Generate the lane-run polygons with a pool of worker threads.
+ *
+ *  Consecutive runs covering the same way-point reuse each other's
+ *  last polygon, so those stay together in one chain.  Each worker
+ *  generates whole chains into a private buffer; the buffers merge
+ *  back into allPolys in chain order, renumbering poly ids.
+ */
+void MapLanes::RunPolygonChains(std::vector<LaneWork> &work, int nthreads)
+{
+  std::vector<std::vector<int> > chains;
+  int prev_run = -1;
+  for (uint i = 0; i < work.size(); i++)
+    {
+      if (work[i].is_transition)
+	continue;
+      if (prev_run >= 0
+	  && work[i].lane.front().id == work[prev_run].lane.back().id)
+	work[i].chain = work[prev_run].chain;
+      else
+	{
+	  work[i].chain = chains.size();
+	  chains.push_back(std::vector<int>());
+	}
+      chains[work[i].chain].push_back(i);
+      prev_run = i;
+    }
+
+  std::vector<std::vector<poly> > results(chains.size());
+
+  boost::thread_group pool;
+  for (int tid = 0; tid < nthreads; tid++)
+    pool.create_thread(boost::bind(&MapLanes::PolygonChainWorker, this,
+				   &work, &chains, &results,
+				   tid, nthreads));
+  pool.join_all();
+
+  // merge per-chain buffers in order; chain order is run order, so
+  // this matches the serial layout with transitions moved to the end
+  for (uint c = 0; c < results.size(); c++)
+    for (uint i = 0; i < results[c].size(); i++)
+      {
+	results[c][i].poly_id = poly_id_counter++;
+	allPolys.push_back(results[c][i]);
+      }
+}
+
+/** Worker: generate every nthreads-th chain into a private buffer. */
+void MapLanes::PolygonChainWorker(const std::vector<LaneWork> *work,
+				  const std::vector<std::vector<int> > *chains,
+				  std::vector<std::vector<poly> > *results,
+				  int tid, int nthreads)
+{
+  for (uint c = tid; c < chains->size(); c += nthreads)
+    {
+      // a scratch instance gives the chain its own allPolys and
+      // poly_id_counter, keeping MakeLanePolygon unchanged
+      MapLanes scratch;
+      scratch.graph = graph;
+      scratch.max_poly_size = max_poly_size;
+      scratch.poly_id_counter = 0;
+      scratch.rX = rX;
+      scratch.rY = rY;
+      scratch.rOri = rOri;
+
+      const std::vector<int> &chain = (*chains)[c];
+      for (uint i = 0; i < chain.size(); i++)
+	scratch.ProcessLaneWork((*work)[chain[i]]);
+
+      (*results)[c].swap(scratch.allPolys);
     }
-  
-  // Set up new lane
-  lane.clear();
-  lane_pt.clear();
-  lane_map.clear();
 }
 
 void MapLanes::SetFilteredPolygons()
@@ -570,9 +712,20 @@ void MapLanes::MakeLanePolygon(WayPointNode w1, WayPointNode w2,
 
       float cdist = fmax(time2-time1,0.0);
 
+      // Sample the sharpest centerline curvature on this span and
+      // size the polygon accordingly: long polygons where the lane
+      // runs straight, fine subdivision only where it actually bends.
+      float kappa = fmaxf(c.evaluateCurvature((time1+time2)/2),
+			  fmaxf(c.evaluateCurvature(time1),
+				c.evaluateCurvature(time2)));
+      float poly_size = max_poly_size*STRAIGHT_POLY_FACTOR;
+      if (kappa > Epsilon::float_value)
+	poly_size = fminf(poly_size, max_poly_size*(POLY_CURVATURE/kappa));
+      poly_size = fmaxf(poly_size, fminf(max_poly_size, MIN_POLY_SIZE));
+
       if(Epsilon::equal(cdist,0.0) ||
 	 Epsilon::equal(edist,0.0) ||
-	 cdist <= max_poly_size*edist/cdist)
+	 cdist <= poly_size*edist/cdist)
 	{
 	  	  
 	  poly newPoly;
@@ -809,27 +962,98 @@ int MapLanes::getAllLanes(art_msgs::ArtLanes *lanes)
 
 
 int MapLanes::getLanes(art_msgs::ArtLanes *lanes, MapXY here)
+{
+  // circular region: heading does not matter
+  return getLanes(lanes, MapPose(here, 0.0), range, range);
+}
+
+int MapLanes::getLanes(art_msgs::ArtLanes *lanes, MapPose here,
+                       float forward, float lateral)
 {
   if (range < 0)
     return getAllLanes(lanes);
 
-  lanes->polygons.clear();
+  // (re)build the spatial index whenever the polygon set changed
+  if (!local_index_.matches(allPolys))
+    {
+      local_index_.rebuild(allPolys);
+      local_valid_ = false;
+    }
 
-  for(unsigned int i = 0; i < filtPolys.size(); i++)
+  // collect indices of polygons near here, using the index so the
+  // cost scales with the local set, not the map size
+  local_index_.getCandidates(here.map.x, here.map.y,
+                             fmaxf(forward, lateral)
+                             + local_index_.cellSize(),
+                             local_scratch_);
+  std::sort(local_scratch_.begin(), local_scratch_.end());
+  local_scratch_.erase(std::unique(local_scratch_.begin(),
+                                   local_scratch_.end()),
+                       local_scratch_.end());
+
+  // membership test: inside an ellipse whose major axis follows the
+  // vehicle heading (a circle when forward == lateral)
+  float cos_h = cosf(here.yaw);
+  float sin_h = sinf(here.yaw);
+  float fwd2 = forward * forward;
+  float lat2 = lateral * lateral;
+
+  std::vector<int> members;
+  members.reserve(local_scratch_.size());
+  for (unsigned k = 0; k < local_scratch_.size(); ++k)
     {
-      art_msgs::ArtQuadrilateral temp = filtPolys.at(i).GetQuad();
-      float dist = Euclidean::DistanceTo(MapXY(temp.midpoint), here);
-      
-      if(dist <= range)
+      int i = local_scratch_[k];
+      float dx = allPolys[i].midpoint.x - here.map.x;
+      float dy = allPolys[i].midpoint.y - here.map.y;
+      float fwd = dx * cos_h + dy * sin_h;
+      float lat = dy * cos_h - dx * sin_h;
+      if (fwd * fwd * lat2 + lat * lat * fwd2 <= fwd2 * lat2)
+        members.push_back(i);
+    }
+
+  if (local_valid_ && members == local_set_)
+    {
+      // nothing entered or left the range circle: reuse the previous
+      // message as is
+      *lanes = local_msg_;
+      return 0;
+    }
+
+  // patch the previous message: polygons still in range keep their
+  // converted quads, only newcomers go through GetQuad()
+  art_msgs::ArtLanes updated;
+  updated.polygons.reserve(members.size());
+  unsigned old_pos = 0;
+  for (unsigned k = 0; k < members.size(); ++k)
+    {
+      int i = members[k];
+      while (local_valid_
+             && old_pos < local_set_.size()
+             && local_set_[old_pos] < i)
+        ++old_pos;			// polygon left the range circle
+
+      if (local_valid_
+          && old_pos < local_set_.size()
+          && local_set_[old_pos] == i)
         {
-          lanes->polygons.push_back(temp);
-          allPolys[i] = poly(temp);
+          updated.polygons.push_back(local_msg_.polygons[old_pos]);
+        }
+      else
+        {
+          updated.polygons.push_back(filtPolys.at(i).GetQuad());
+          allPolys[i] = poly(updated.polygons.back());
         }
     }
 
+  local_msg_.polygons.swap(updated.polygons);
+  local_set_.swap(members);
+  local_valid_ = true;
+  *lanes = local_msg_;
+
   ROS_DEBUG_STREAM("found " << lanes->polygons.size()
-                   << " polygons within " << range
-                   << " meters of (" << here.x << "," << here.y << ")");
+                   << " polygons within " << forward << "x" << lateral
+                   << " meters of (" << here.map.x
+                   << "," << here.map.y << ")");
 
   return 0;
 }
@@ -849,23 +1073,37 @@ int MapLanes::getVisionLanes(art_msgs::ArtLanes *lanes, float x, float y,
     }
 
   poly current = allPolys.at(index);
-  for(unsigned int i = 0; i < filtPolys.size(); i++)
+
+  // (re)build the bearing-sector index whenever the polygon set changed
+  if (!vision_index_.matches(allPolys))
+    vision_index_.rebuild(allPolys, range);
+
+  // Only polygons bucketed near the camera heading are candidates;
+  // the exact frustum tests below run on that short list alone, so
+  // this can be called at camera frame rate.
+  vision_index_.query(x, y, heading, DEG_T_RAD*25, vision_scratch_);
+  std::sort(vision_scratch_.begin(), vision_scratch_.end());
+  vision_scratch_.erase(std::unique(vision_scratch_.begin(),
+                                    vision_scratch_.end()),
+                        vision_scratch_.end());
+
+  for(unsigned int k = 0; k < vision_scratch_.size(); k++)
     {
-      art_msgs::ArtQuadrilateral temp = filtPolys.at(i).GetQuad();
+      int i = vision_scratch_[k];
+      const poly &temp = allPolys.at(i);
 
       if (temp.start_way.lane != current.start_way.lane
-          || temp.start_way.seg != current.start_way.seg
-          || temp.is_transition
-          || temp.contains_way)
+          || temp.start_way.seg != current.start_way.seg)
         continue;
 
     float angle=AngleFromXY(x,y,heading,temp.midpoint.x,temp.midpoint.y);
     float dist=DistFromXY(x,y,temp.midpoint.x,temp.midpoint.y);
-  
+
     if((dist <= range) && (dist>10.0) && (fabs(angle)<DEG_T_RAD*25))
       {
-        lanes->polygons.push_back(temp);
-      }  
+        // convert only the polygons actually returned
+        lanes->polygons.push_back(filtPolys.at(i).GetQuad());
+      }
     }
 
   //testDraw();
@@ -898,6 +1136,12 @@ void MapLanes::UpdatePoly(polyUpdate upPoly, float rrX, float rrY, float rrOri)
   //static gaussian g1(0.0,3.0);
   //upPoly.distance=upPoly.distance+g1.get_sample_1D();
   filt->UpdatePoint(upPoly.point_id,upPoly.distance,upPoly.bearing,upPoly.confidence,rrX,rrY,Normalise_PI(rrOri+PI));
+
+  // polygon geometry changed: the cached local lanes message and the
+  // spatial indexes are stale now
+  local_valid_ = false;
+  local_index_.clear();
+  vision_index_.clear();
   
   #ifdef DEBUGMAP
    WritePolygonToDebugFile(upPoly.poly_id);
@@ -932,21 +1176,19 @@ void MapLanes::UpdateWithCurrent(int i){
   poly temp2 = filtPolys.at(i).GetPolygon();
   if (temp2.is_transition || temp2.contains_way) return;
 
-  float angle=AngleFromXY(rX,rY,rOri,temp2.p1.x,temp2.p1.y);
-  float distU=DistFromXY(rX,rY,temp2.p1.x,temp2.p1.y);
-  if (distU>5 && distU<80 && fabs(angle) < 0.2) filt->UpdatePoint(0,distU+g1.get_sample_1D(),angle,1.0,rX,rY,rOri);
-      
-  angle=AngleFromXY(rX,rY,rOri,temp2.p2.x,temp2.p2.y);
-  distU=DistFromXY(rX,rY,temp2.p2.x,temp2.p2.y);
-  if (distU>5 && distU<80 && fabs(angle) < 0.2) filt->UpdatePoint(1,distU+g1.get_sample_1D(),angle,1.0,rX,rY,rOri);
-
-  angle=AngleFromXY(rX,rY,rOri,temp2.p3.x,temp2.p3.y);
-  distU=DistFromXY(rX,rY,temp2.p3.x,temp2.p3.y);
-  if (distU>5 && distU<80 && fabs(angle) < 0.2) filt->UpdatePoint(2,distU+g1.get_sample_1D(),angle,1.0,rX,rY,rOri);     
-
-  angle=AngleFromXY(rX,rY,rOri,temp2.p4.x,temp2.p4.y);
-  distU=DistFromXY(rX,rY,temp2.p4.x,temp2.p4.y);
-  if (distU>5 && distU<80 && fabs(angle) < 0.2) filt->UpdatePoint(3,distU+g1.get_sample_1D(),angle,1.0,rX,rY,rOri);
+  MapXY pts[NUM_POINTS]={temp2.p1,temp2.p2,temp2.p3,temp2.p4};
+  float dist[NUM_POINTS];
+  float angle[NUM_POINTS];
+  float noise[NUM_POINTS];
+  bool update[NUM_POINTS];
+  g1.get_samples_1D(noise, NUM_POINTS);	// one batch for all vertices
+  for (int j=0; j<NUM_POINTS; j++) {
+    angle[j]=AngleFromXY(rX,rY,rOri,pts[j].x,pts[j].y);
+    float distU=DistFromXY(rX,rY,pts[j].x,pts[j].y);
+    update[j]=(distU>5 && distU<80 && fabs(angle[j]) < 0.2);
+    dist[j]=(update[j]? distU+noise[j]: distU);
+  }
+  filt->UpdatePoints(dist,angle,update,1.0,rX,rY,rOri);
 }
 
 
@@ -956,29 +1198,18 @@ void MapLanes::testDraw(bool with_trans)
   MapLanes::testDraw(with_trans, empty_zones);
 }
 
-//test function which outputs all polygons to a pgm image.
-void MapLanes::testDraw(bool with_trans, const ZonePerimeterList &zones)
+// image extent shared by testDraw() and testDrawTiled()
+void MapLanes::drawExtent(float &min_x, float &max_y,
+                          int &xsize, int &ysize, float &ratio)
 {
   float max_x = -FLT_MAX;
-  float min_x = FLT_MAX;
-  float max_y = -FLT_MAX;
   float min_y = FLT_MAX;
-  
-  FILE* gpsFile = fopen("gps.kml","wb");
-
-  fprintf(gpsFile,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n <kml xmlns=\"http://earth.google.com/kml/2.2\">\n <Document>\n<name>Maplanes Polygon centres</name>\n<description>Path of the polygons</description>\n<Style id=\"yellowLineGreenPoly\">\n<LineStyle>\n<color>7f00ffff</color>\n<width>4</width>\n</LineStyle>\n<PolyStyle>\n<color>7f00ff00</color>\n</PolyStyle>\n</Style>\n<Placemark>\n<name>Absolute Extruded</name>\n<description>Transparent green wall with yellow outlines</description>\n<styleUrl>#yellowLineGreenPoly</styleUrl>\n<LineString>\n<extrude>1</extrude>\n<tessellate>1</tessellate>\n<altitudeMode>clampToGround</altitudeMode>\n<coordinates>\n");
-
-  float yOff = 7.5;//5.17;
-  float xOff = 2.9; //2.89;
+  min_x = FLT_MAX;
+  max_y = -FLT_MAX;
 
   for(int i = 0; i < (int)filtPolys.size(); i++)
     {
       poly node=(filtPolys.at(i).GetPolygon());
-      double lon,lat;
-      UTM::UTMtoLL(cY+node.midpoint.y+yOff,cX+node.midpoint.x+xOff,
-                   "11S",lon,lat);
-      fprintf(gpsFile,"%lf,%lf,0\n",lat,lon);
-
       max_x=fmax(fmax(fmax(fmax(node.p1.x,node.p2.x),
                            node.p3.x), node.p4.x),max_x);
       max_y=fmax(fmax(fmax(fmax(node.p1.y,node.p2.y),
@@ -988,9 +1219,6 @@ void MapLanes::testDraw(bool with_trans, const ZonePerimeterList &zones)
       min_y=fmin(fmin(fmin(fmin(node.p1.y,node.p2.y),
                            node.p3.y),node.p4.y),min_y);
     }
-  fprintf(gpsFile,
-          "</coordinates>\n</LineString>\n</Placemark>\n</Document>\n</kml>");
-  fclose(gpsFile);
 
   // find bounding box for coordinates of all way-points in graph
   for(uint i = 0; i < graph->nodes_size; i++)
@@ -1001,16 +1229,16 @@ void MapLanes::testDraw(bool with_trans, const ZonePerimeterList &zones)
       min_y=fmin(graph->nodes[i].map.y,min_y);
     }
 
-  int xsize=(int)ceil(max_x - min_x);
-  int ysize=(int)ceil(max_y - min_y);
-  
+  xsize=(int)ceil(max_x - min_x);
+  ysize=(int)ceil(max_y - min_y);
+
   if (xsize < 240)
     {
       min_x -= (240-xsize)/2;
       max_x += (240-xsize)/2;
       xsize=240;
     }
-  
+
   if (ysize < 168)
     {
       min_y -= (168-ysize)/2;
@@ -1018,14 +1246,40 @@ void MapLanes::testDraw(bool with_trans, const ZonePerimeterList &zones)
       ysize=168;
     }
 
-  float ratio=3;
+  ratio=3;
   float image_size=xsize*ysize*DEFAULT_RATIO*DEFAULT_RATIO;
   if (image_size > (2048.0*2048))
     ratio=sqrtf((2047*2047.0)/(xsize*ysize));
 
   std::cerr << "World size: "<<xsize<<","<<ysize<<std::endl;
   std::cerr << "Image size: "<<xsize*ratio<<","<<ysize*ratio<<std::endl;
-  
+}
+
+//test function which outputs all polygons to a pgm image.
+void MapLanes::testDraw(bool with_trans, const ZonePerimeterList &zones)
+{
+  FILE* gpsFile = fopen("gps.kml","wb");
+
+  fprintf(gpsFile,"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n <kml xmlns=\"http://earth.google.com/kml/2.2\">\n <Document>\n<name>Maplanes Polygon centres</name>\n<description>Path of the polygons</description>\n<Style id=\"yellowLineGreenPoly\">\n<LineStyle>\n<color>7f00ffff</color>\n<width>4</width>\n</LineStyle>\n<PolyStyle>\n<color>7f00ff00</color>\n</PolyStyle>\n</Style>\n<Placemark>\n<name>Absolute Extruded</name>\n<description>Transparent green wall with yellow outlines</description>\n<styleUrl>#yellowLineGreenPoly</styleUrl>\n<LineString>\n<extrude>1</extrude>\n<tessellate>1</tessellate>\n<altitudeMode>clampToGround</altitudeMode>\n<coordinates>\n");
+
+  float yOff = 7.5;//5.17;
+  float xOff = 2.9; //2.89;
+
+  for(int i = 0; i < (int)filtPolys.size(); i++)
+    {
+      poly node=(filtPolys.at(i).GetPolygon());
+      double lon,lat;
+      UTM::UTMtoLL(cY+node.midpoint.y+yOff,cX+node.midpoint.x+xOff,
+                   "11S",lon,lat);
+      fprintf(gpsFile,"%lf,%lf,0\n",lat,lon);
+    }
+  fprintf(gpsFile,
+          "</coordinates>\n</LineString>\n</Placemark>\n</Document>\n</kml>");
+  fclose(gpsFile);
+
+  float min_x, max_y, ratio;
+  int xsize, ysize;
+  drawExtent(min_x, max_y, xsize, ysize, ratio);
 
   //initialize VisualLanes
   DrawLanes* edgeImage = new DrawLanes(xsize,ysize,ratio);
@@ -1080,6 +1334,173 @@ void MapLanes::testDraw(bool with_trans, const ZonePerimeterList &zones)
   polyImage->savePGM(temp);
   delete temp;
 
+  delete edgeImage;
+  delete polyImage;
+}
+
+// run testDraw() on a background thread (see header comment)
+void MapLanes::testDrawBackground(bool with_trans,
+                                  const ZonePerimeterList &zones)
+{
+  if (draw_thread_ != NULL)
+    {
+      draw_thread_->join();		// previous dump still writing
+      delete draw_thread_;
+    }
+  // bind copies the zone list, so the caller's list may go away
+  draw_thread_ =
+    new boost::thread(boost::bind((void (MapLanes::*)
+                                   (bool, const ZonePerimeterList &))
+                                  &MapLanes::testDraw,
+                                  this, with_trans, zones));
+}
+
+// render one horizontal band of the tiled image dump
+void MapLanes::drawTile(DrawTileSpec spec)
+{
+  // a tile file of exactly the right size was finished by an earlier
+  // (interrupted) run; binary rows have a fixed length, so length is
+  // enough to tell a complete tile from a truncated one
+  int widthpx = (int) ceil(spec.xsize*spec.ratio);
+  int heightpx = (int) ceil(spec.ysize*spec.ratio);
+  int band = spec.rows;
+  if (spec.row0+band > heightpx)
+    band = heightpx-spec.row0;
+  off_t expected = (off_t) band * widthpx * 3;
+  struct stat st;
+  if (stat(spec.edge_file.c_str(), &st) == 0 && st.st_size == expected
+      && stat(spec.poly_file.c_str(), &st) == 0 && st.st_size == expected)
+    {
+      ROS_INFO("tile rows %d-%d already rendered, reusing",
+               spec.row0, spec.row0+band);
+      return;
+    }
+
+  DrawLanes edgeImage(spec.xsize, spec.ysize, spec.ratio,
+                      spec.row0, spec.rows);
+  DrawLanes polyImage(spec.xsize, spec.ysize, spec.ratio,
+                      spec.row0, spec.rows);
+
+  for(uint i = 0; i < graph->edges_size; i++)
+    {
+      WayPointNode w1=graph->nodes[graph->edges[i].startnode_index];
+      WayPointNode w2=graph->nodes[graph->edges[i].endnode_index];
+      edgeImage.addTrace(w1.map.x-spec.min_x, spec.max_y-w1.map.y,
+                         w2.map.x-spec.min_x, spec.max_y-w2.map.y);
+    }
+
+  for(uint i = 0; i < graph->nodes_size; i++)
+    {
+      WayPointNode w1=graph->nodes[i];
+      polyImage.addWay(w1.map.x-spec.min_x, spec.max_y-w1.map.y);
+    }
+
+  for(int i = 0; i < (int)filtPolys.size(); i++)
+    {
+      poly temp = filtPolys.at(i).GetPolygon();
+      polyImage.addPoly(temp.p1.x-spec.min_x, temp.p2.x-spec.min_x,
+                        temp.p3.x-spec.min_x, temp.p4.x-spec.min_x,
+                        spec.max_y-temp.p1.y, spec.max_y-temp.p2.y,
+                        spec.max_y-temp.p3.y, spec.max_y-temp.p4.y,
+                        temp.is_stop,
+                        temp.is_transition && !spec.with_trans);
+    }
+
+  FILE *f = fopen(spec.edge_file.c_str(), "wb");
+  if (f != NULL)
+    {
+      edgeImage.saveP6Rows(f);
+      fclose(f);
+    }
+  f = fopen(spec.poly_file.c_str(), "wb");
+  if (f != NULL)
+    {
+      polyImage.saveP6Rows(f);
+      fclose(f);
+    }
+}
+
+namespace
+{
+  // concatenate finished tile files into one binary PPM, deleting
+  // each tile once its rows are copied
+  void stitch_tiles(const char *filename, int widthpx, int heightpx,
+                    const std::vector<std::string> &tiles)
+  {
+    FILE *out = fopen(filename, "wb");
+    if (out == NULL)
+      return;
+    fprintf(out, "P6\n#%s\n%i %i\n255\n", filename, widthpx, heightpx);
+    std::vector<char> buf(1 << 16);
+    for (size_t t = 0; t < tiles.size(); t++)
+      {
+        FILE *in = fopen(tiles[t].c_str(), "rb");
+        if (in == NULL)
+          continue;
+        size_t n;
+        while ((n = fread(&buf[0], 1, buf.size(), in)) > 0)
+          fwrite(&buf[0], 1, n, out);
+        fclose(in);
+        remove(tiles[t].c_str());
+      }
+    fclose(out);
+  }
+}
+
+// tiled, parallel version of testDraw() (see header comment)
+void MapLanes::testDrawTiled(bool with_trans,
+                             const ZonePerimeterList &zones, int threads)
+{
+  if (threads < 1)
+    threads = 1;
+
+  float min_x, max_y, ratio;
+  int xsize, ysize;
+  drawExtent(min_x, max_y, xsize, ysize, ratio);
+
+  int widthpx = (int) ceil(xsize*ratio);
+  int heightpx = (int) ceil(ysize*ratio);
+  int band = (heightpx + threads - 1) / threads;
+
+  char name[255];
+  std::vector<std::string> edge_tiles;
+  std::vector<std::string> poly_tiles;
+  std::vector<boost::thread*> workers;
+  for (int t = 0; t*band < heightpx; t++)
+    {
+      DrawTileSpec spec;
+      spec.row0 = t*band;
+      spec.rows = band;
+      spec.min_x = min_x;
+      spec.max_y = max_y;
+      spec.xsize = xsize;
+      spec.ysize = ysize;
+      spec.ratio = ratio;
+      spec.with_trans = with_trans;
+      sprintf(name, "wayImage.part%02d", t);
+      spec.edge_file = name;
+      sprintf(name, "polyImage%i.part%02d", writecounter, t);
+      spec.poly_file = name;
+      edge_tiles.push_back(spec.edge_file);
+      poly_tiles.push_back(spec.poly_file);
+      workers.push_back(new boost::thread(boost::bind(&MapLanes::drawTile,
+                                                      this, spec)));
+    }
+
+  for (size_t t = 0; t < workers.size(); t++)
+    {
+      workers[t]->join();
+      delete workers[t];
+    }
+
+  ROS_INFO("Writing way-point image");
+  stitch_tiles("wayImage.ppm", widthpx, heightpx, edge_tiles);
+
+  sprintf(name, "polyImage%i.ppm", writecounter);
+  writecounter++;
+
+  ROS_INFO("Writing polygons image");
+  stitch_tiles(name, widthpx, heightpx, poly_tiles);
 }
 
 #ifdef DEBUGMAP
@@ -1093,6 +1514,361 @@ void MapLanes::WritePolygonToDebugFile(int i) {
 }
 #endif
 
+// binary map cache format: fixed header followed by fixed-size
+// records, suitable for a single bulk read (or mmap)
+namespace
+{
+  const uint32_t MAP_CACHE_MAGIC = 0x4152544cu;	// "ARTL"
+  const uint32_t MAP_CACHE_VERSION = 2;
+
+  // Only the plain poly records are cached.  FilteredPolygon holds
+  // Kalman filter matrices with heap storage, so it cannot be copied
+  // byte-wise; the filter bank is rebuilt from the polygons on load,
+  // just as MapRNDF() does after generation.
+  struct MapCacheHeader
+  {
+    uint32_t magic;			// MAP_CACHE_MAGIC
+    uint32_t version;			// MAP_CACHE_VERSION
+    uint32_t rndf_checksum;		// RNDF contents checksum
+    uint32_t poly_record;		// sizeof(poly) when written
+    uint32_t n_all;			// allPolys count
+    uint32_t lane_record;		// sizeof(MapCacheLaneSig)
+    uint32_t n_lanes;			// lane signature count
+  };
+
+  // Per-lane signature of the way-point data polygon generation
+  // reads, written after the polygon records.  When an edited RNDF
+  // invalidates the whole-file checksum, MapRNDFIncremental() matches
+  // these against the new graph to find the lanes that actually
+  // changed.
+  struct MapCacheLaneSig
+  {
+    int16_t seg;			// ElementID segment
+    int16_t lane;			// ElementID lane
+    uint32_t checksum;			// lane contents checksum
+  };
+
+  typedef std::pair<int, int> lane_key_t;
+
+  // fold bytes into an FNV-1a hash
+  inline void fnv_accumulate(uint32_t &hash, const void *data, size_t len)
+  {
+    const unsigned char *p = (const unsigned char *) data;
+    for (size_t i = 0; i < len; ++i)
+      {
+        hash ^= p[i];
+        hash *= 16777619u;
+      }
+  }
+
+  /** Checksum the per-lane inputs of polygon generation: every lane
+   *  way-point and every non-implicit edge joining two way-points of
+   *  the same lane, in graph order.  Any RNDF edit that would change
+   *  a lane's polygons changes its signature.  Exits to other lanes
+   *  are not hashed: the transition polygons they produce are always
+   *  regenerated.
+   */
+  void compute_lane_signatures(const Graph *graph,
+                               std::map<lane_key_t, uint32_t> &sigs)
+  {
+    sigs.clear();
+    for (uint32_t i = 0; i < graph->nodes_size; ++i)
+      {
+        const WayPointNode &w = graph->nodes[i];
+        if (w.is_perimeter || w.is_spot)
+          continue;			// no lane polygons generated
+        lane_key_t key(w.id.seg, w.id.lane);
+        uint32_t &hash =
+          sigs.insert(std::make_pair(key, 2166136261u)).first->second;
+        fnv_accumulate(hash, &w.id.pt, sizeof(w.id.pt));
+        fnv_accumulate(hash, &w.map.x, sizeof(w.map.x));
+        fnv_accumulate(hash, &w.map.y, sizeof(w.map.y));
+        fnv_accumulate(hash, &w.lane_width, sizeof(w.lane_width));
+        uint8_t flags = (w.is_stop? 1: 0) | (w.is_lane_change? 2: 0);
+        fnv_accumulate(hash, &flags, sizeof(flags));
+      }
+    for (uint32_t j = 0; j < graph->edges_size; ++j)
+      {
+        const WayPointEdge &e = graph->edges[j];
+        if (e.is_implicit)
+          continue;
+        const WayPointNode &w1 = graph->nodes[e.startnode_index];
+        const WayPointNode &w2 = graph->nodes[e.endnode_index];
+        if (!w1.id.same_lane(w2.id)
+            || w1.is_perimeter || w1.is_spot
+            || w2.is_perimeter || w2.is_spot)
+          continue;			// transition or zone edge
+        lane_key_t key(w1.id.seg, w1.id.lane);
+        std::map<lane_key_t, uint32_t>::iterator si = sigs.find(key);
+        if (si == sigs.end())
+          continue;
+        fnv_accumulate(si->second, &w1.id.pt, sizeof(w1.id.pt));
+        fnv_accumulate(si->second, &w2.id.pt, sizeof(w2.id.pt));
+        fnv_accumulate(si->second, &e.left_boundary,
+                       sizeof(e.left_boundary));
+        fnv_accumulate(si->second, &e.right_boundary,
+                       sizeof(e.right_boundary));
+        uint8_t flags = (e.is_exit? 1: 0);
+        fnv_accumulate(si->second, &flags, sizeof(flags));
+      }
+  }
+
+  /** Read every record of a cache file written by this code version.
+   *
+   *  Verifies magic, version and record sizes but not the RNDF
+   *  checksum: the caller decides whether a stale cache is usable.
+   */
+  bool read_cache_records(const char *fName, MapCacheHeader &hdr,
+                          std::vector<poly> &polys,
+                          std::vector<MapCacheLaneSig> &sigs)
+  {
+    FILE* f = fopen(fName, "rb");
+    if (f == NULL)
+      return false;			// no cache yet, not an error
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1) {
+      ROS_WARN("MapLanes cache read failed - Failed header read");
+      fclose(f);
+      return false;
+    }
+
+    if (hdr.magic != MAP_CACHE_MAGIC
+        || hdr.version != MAP_CACHE_VERSION
+        || hdr.poly_record != sizeof(poly)
+        || hdr.lane_record != sizeof(MapCacheLaneSig)) {
+      fclose(f);
+      return false;			// incompatible cache
+    }
+
+    polys.resize(hdr.n_all);
+    sigs.resize(hdr.n_lanes);
+
+    bool ok = true;
+    if (hdr.n_all > 0)
+      ok = (fread(&polys[0], sizeof(poly), hdr.n_all, f) == hdr.n_all);
+    if (ok && hdr.n_lanes > 0)
+      ok = (fread(&sigs[0], sizeof(MapCacheLaneSig), hdr.n_lanes, f)
+            == hdr.n_lanes);
+    fclose(f);
+
+    if (!ok) {
+      ROS_WARN("MapLanes cache read failed - Failed record read");
+      polys.clear();
+      sigs.clear();
+      return false;
+    }
+    return true;
+  }
+}
+
+// FNV-1a hash of a file's contents
+uint32_t MapLanes::FileChecksum(const char* fName)
+{
+  FILE* f = fopen(fName, "rb");
+  if (f == NULL)
+    return 0;
+
+  uint32_t hash = 2166136261u;
+  unsigned char buf[4096];
+  size_t got;
+  while ((got = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+      for (size_t i = 0; i < got; ++i)
+        {
+          hash ^= buf[i];
+          hash *= 16777619u;
+        }
+    }
+  fclose(f);
+  return hash;
+}
+
+bool MapLanes::SaveCache(const char* fName, uint32_t rndf_checksum)
+{
+  FILE* f = fopen(fName, "wb");
+  if (f == NULL) {
+    ROS_WARN("MapLanes::SaveCache Failed - Can't open file");
+    return false;
+  }
+
+  // lane signatures, for salvaging unchanged lanes after an edit
+  std::map<lane_key_t, uint32_t> sigs;
+  compute_lane_signatures(graph, sigs);
+  std::vector<MapCacheLaneSig> sig_recs;
+  sig_recs.reserve(sigs.size());
+  for (std::map<lane_key_t, uint32_t>::const_iterator si = sigs.begin();
+       si != sigs.end(); ++si)
+    {
+      MapCacheLaneSig ls;
+      ls.seg = si->first.first;
+      ls.lane = si->first.second;
+      ls.checksum = si->second;
+      sig_recs.push_back(ls);
+    }
+
+  MapCacheHeader hdr;
+  hdr.magic = MAP_CACHE_MAGIC;
+  hdr.version = MAP_CACHE_VERSION;
+  hdr.rndf_checksum = rndf_checksum;
+  hdr.poly_record = sizeof(poly);
+  hdr.n_all = allPolys.size();
+  hdr.lane_record = sizeof(MapCacheLaneSig);
+  hdr.n_lanes = sig_recs.size();
+
+  bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1);
+  if (ok && hdr.n_all > 0)
+    ok = (fwrite(&allPolys[0], sizeof(poly), hdr.n_all, f) == hdr.n_all);
+  if (ok && hdr.n_lanes > 0)
+    ok = (fwrite(&sig_recs[0], sizeof(MapCacheLaneSig), hdr.n_lanes, f)
+          == hdr.n_lanes);
+  fclose(f);
+
+  if (!ok) {
+    ROS_WARN("MapLanes::SaveCache Failed - Failed cache write");
+    return false;
+  }
+
+  ROS_INFO("MapLanes cache saved: %u polys", hdr.n_all);
+  return true;
+}
+
+bool MapLanes::LoadCache(const char* fName, uint32_t rndf_checksum,
+                         Graph* _graph)
+{
+  MapCacheHeader hdr;
+  std::vector<poly> polys;
+  std::vector<MapCacheLaneSig> sigs;
+  if (!read_cache_records(fName, hdr, polys, sigs))
+    return false;
+
+  // reject anything not written for this exact RNDF
+  if (hdr.rndf_checksum != rndf_checksum) {
+    ROS_INFO("MapLanes cache stale, regenerating map");
+    return false;
+  }
+
+  allPolys.swap(polys);
+  graph = _graph;
+  poly_id_counter = hdr.n_all;
+
+  // rebuild the filter bank over the loaded polygons, as MapRNDF()
+  // does after generation
+  filtPolys.clear();
+  SetFilteredPolygons();
+
+  ROS_INFO("MapLanes cache loaded: %u polys", hdr.n_all);
+  return true;
+}
+
+int MapLanes::MapRNDFIncremental(Graph* _graph, const char* cache_fName,
+                                 float _max_poly_size, int _build_threads)
+{
+#ifdef DEBUGMAP
+  // the debug file expects a full generation pass
+  return MapRNDF(_graph, _max_poly_size, _build_threads);
+#else
+  MapCacheHeader hdr;
+  std::vector<poly> cached;
+  std::vector<MapCacheLaneSig> cached_sigs;
+  if (!read_cache_records(cache_fName, hdr, cached, cached_sigs)
+      || cached_sigs.empty())
+    // nothing to salvage: generate everything
+    return MapRNDF(_graph, _max_poly_size, _build_threads);
+
+  graph=_graph;
+
+  max_poly_size=fmaxf(_max_poly_size, MIN_POLY_SIZE);
+
+  allPolys.clear();
+  poly_id_counter = 0;
+
+  rX=0.0;
+  rY=0.0;
+  rOri=0.0;
+
+  cX=0.0;
+
+  // diff the new graph against the cached lane signatures
+  std::map<lane_key_t, uint32_t> sigs;
+  compute_lane_signatures(graph, sigs);
+
+  // collect the cached polygons of unchanged lanes, keyed by lane and
+  // kept in cache (= generation) order; transitions are regenerated
+  std::map<lane_key_t, std::vector<poly> > reuse;
+  for (uint i = 0; i < cached_sigs.size(); ++i)
+    {
+      lane_key_t key(cached_sigs[i].seg, cached_sigs[i].lane);
+      std::map<lane_key_t, uint32_t>::const_iterator si = sigs.find(key);
+      if (si != sigs.end() && si->second == cached_sigs[i].checksum)
+        reuse[key];			// mark lane reusable
+    }
+  for (uint i = 0; i < cached.size(); ++i)
+    {
+      if (cached[i].is_transition)
+        continue;
+      lane_key_t key(cached[i].start_way.seg, cached[i].start_way.lane);
+      std::map<lane_key_t, std::vector<poly> >::iterator ri =
+        reuse.find(key);
+      if (ri != reuse.end())
+        ri->second.push_back(cached[i]);
+    }
+
+  std::vector<LaneWork> work;
+  CollectPolygonWork(work);
+
+  // Lane runs precede transitions in edge order, so splicing a reused
+  // lane in when its first run comes up reproduces the layout
+  // MakePolygons() would build, and the transitions find every
+  // way-point polygon they attach to.  Renumbering the spliced
+  // polygons keeps poly ids dense and poly_id_counter equal to
+  // allPolys.size(), which MakeLanePolygon() depends on.
+  std::set<lane_key_t> emitted;
+  int reused = 0;
+  int regenerated = 0;
+  int transitions = 0;
+  for (uint i = 0; i < work.size(); i++)
+    {
+      if (work[i].is_transition)
+        {
+          ProcessLaneWork(work[i]);
+          ++transitions;
+          continue;
+        }
+      lane_key_t key(work[i].lane.front().id.seg,
+                     work[i].lane.front().id.lane);
+      std::map<lane_key_t, std::vector<poly> >::iterator ri =
+        reuse.find(key);
+      if (ri != reuse.end())
+        {
+          if (emitted.insert(key).second)
+            {
+              std::vector<poly> &lane_polys = ri->second;
+              for (uint j = 0; j < lane_polys.size(); ++j)
+                {
+                  lane_polys[j].poly_id = poly_id_counter++;
+                  allPolys.push_back(lane_polys[j]);
+                }
+              ++reused;
+            }
+          // later runs of an already-spliced lane: nothing to do
+        }
+      else
+        {
+          if (emitted.insert(key).second)
+            ++regenerated;
+          ProcessLaneWork(work[i]);
+        }
+    }
+
+  SetFilteredPolygons();
+
+  ROS_INFO("MapLanes incremental rebuild: "
+           "%d lanes reused, %d regenerated, %d transitions",
+           reused, regenerated, transitions);
+  return 0;				// success
+#endif
+}
+
 bool MapLanes::WriteToFile(char* fName) {
   FILE* f = fopen(fName,"wb");
   if (f==NULL) {
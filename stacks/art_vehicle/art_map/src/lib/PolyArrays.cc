@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     C++ class providing a structure-of-arrays view of MapLanes
+     polygons for cache-friendly distance scans.
+
+     @author Jack O'Quin
+
+ */
+
+#include <math.h>
+#include <float.h>
+
+#include <art_map/euclidean_distance.h>
+#include <art_map/PolyArrays.h>
+
+PolyArrays::PolyArrays()
+{
+  clear();
+}
+
+PolyArrays::~PolyArrays()
+{
+}
+
+void PolyArrays::clear(void)
+{
+  polys_ = NULL;
+  mid_x_.clear();
+  mid_y_.clear();
+  radius_.clear();
+  heading_.clear();
+  poly_id_.clear();
+}
+
+void PolyArrays::rebuild(const poly_list_t &polys)
+{
+  clear();
+
+  size_t n = polys.size();
+  mid_x_.resize(n);
+  mid_y_.resize(n);
+  radius_.resize(n);
+  heading_.resize(n);
+  poly_id_.resize(n);
+
+  for (size_t i = 0; i < n; ++i)
+    {
+      const poly &p = polys[i];
+      mid_x_[i] = p.midpoint.x;
+      mid_y_[i] = p.midpoint.y;
+      heading_[i] = p.heading;
+      poly_id_[i] = p.poly_id;
+
+      // conservative bound on distance from midpoint to any point of
+      // the polygon: the farthest vertex
+      float r = Euclidean::DistanceTo(p.midpoint, p.p1);
+      r = fmaxf(r, Euclidean::DistanceTo(p.midpoint, p.p2));
+      r = fmaxf(r, Euclidean::DistanceTo(p.midpoint, p.p3));
+      r = fmaxf(r, Euclidean::DistanceTo(p.midpoint, p.p4));
+      radius_[i] = r;
+    }
+
+  polys_ = &polys;
+}
+
+void PolyArrays::getCandidatesByMidpoint(float x, float y,
+                                         std::vector<int> &candidates) const
+{
+  candidates.clear();
+  size_t n = mid_x_.size();
+  if (n == 0)
+    return;
+
+  // first pass: upper bound on the exact closest distance is the
+  // smallest squared midpoint distance (midpoints lie inside their
+  // polygons, so dist(poly) <= dist(midpoint))
+  float bound2 = FLT_MAX;
+  for (size_t i = 0; i < n; ++i)
+    {
+      float dx = mid_x_[i] - x;
+      float dy = mid_y_[i] - y;
+      float d2 = dx*dx + dy*dy;
+      if (d2 < bound2)
+        bound2 = d2;
+    }
+  float bound = sqrtf(bound2);
+
+  // second pass: keep polygons whose exact distance could beat the
+  // bound, i.e. midpoint distance minus polygon radius within bound
+  for (size_t i = 0; i < n; ++i)
+    {
+      float dx = mid_x_[i] - x;
+      float dy = mid_y_[i] - y;
+      float reach = bound + radius_[i];
+      if (dx*dx + dy*dy <= reach*reach)
+        candidates.push_back(i);
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     C++ class for a uniform-grid spatial index over MapLanes
+     polygons.
+
+     @author Jack O'Quin
+
+ */
+
+#include <math.h>
+#include <float.h>
+
+#include <ros/ros.h>
+
+#include <art_map/PolyIndex.h>
+
+PolyIndex::PolyIndex()
+{
+  clear();
+}
+
+PolyIndex::~PolyIndex()
+{
+}
+
+void PolyIndex::clear(void)
+{
+  polys_ = NULL;
+  indexed_size_ = 0;
+  cell_size_ = 1.0;
+  min_x_ = min_y_ = 0.0;
+  cols_ = rows_ = 0;
+  cells_.clear();
+}
+
+int PolyIndex::col(float x) const
+{
+  int c = (int) floorf((x - min_x_) / cell_size_);
+  return std::max(0, std::min(cols_ - 1, c));
+}
+
+int PolyIndex::row(float y) const
+{
+  int r = (int) floorf((y - min_y_) / cell_size_);
+  return std::max(0, std::min(rows_ - 1, r));
+}
+
+void PolyIndex::rebuild(const poly_list_t &polys, float cell_size)
+{
+  clear();
+
+  if (polys.empty())
+    return;
+
+  cell_size_ = cell_size;
+
+  // bounding box of all polygon vertices
+  float max_x = -FLT_MAX;
+  float max_y = -FLT_MAX;
+  min_x_ = FLT_MAX;
+  min_y_ = FLT_MAX;
+  for (unsigned i = 0; i < polys.size(); ++i)
+    {
+      const poly &p = polys[i];
+      min_x_ = fminf(fminf(fminf(fminf(min_x_, p.p1.x), p.p2.x),
+                           p.p3.x), p.p4.x);
+      min_y_ = fminf(fminf(fminf(fminf(min_y_, p.p1.y), p.p2.y),
+                           p.p3.y), p.p4.y);
+      max_x = fmaxf(fmaxf(fmaxf(fmaxf(max_x, p.p1.x), p.p2.x),
+                          p.p3.x), p.p4.x);
+      max_y = fmaxf(fmaxf(fmaxf(fmaxf(max_y, p.p1.y), p.p2.y),
+                          p.p3.y), p.p4.y);
+    }
+
+  cols_ = std::max(1, (int) ceilf((max_x - min_x_) / cell_size_));
+  rows_ = std::max(1, (int) ceilf((max_y - min_y_) / cell_size_));
+  cells_.resize(cols_ * rows_);
+
+  // add each polygon to every cell its bounding box overlaps
+  for (unsigned i = 0; i < polys.size(); ++i)
+    {
+      const poly &p = polys[i];
+      float pminx = fminf(fminf(fminf(p.p1.x, p.p2.x), p.p3.x), p.p4.x);
+      float pminy = fminf(fminf(fminf(p.p1.y, p.p2.y), p.p3.y), p.p4.y);
+      float pmaxx = fmaxf(fmaxf(fmaxf(p.p1.x, p.p2.x), p.p3.x), p.p4.x);
+      float pmaxy = fmaxf(fmaxf(fmaxf(p.p1.y, p.p2.y), p.p3.y), p.p4.y);
+      int c0 = col(pminx);
+      int c1 = col(pmaxx);
+      int r0 = row(pminy);
+      int r1 = row(pmaxy);
+      for (int r = r0; r <= r1; ++r)
+        for (int c = c0; c <= c1; ++c)
+          cells_[r * cols_ + c].push_back(i);
+    }
+
+  polys_ = &polys;
+  indexed_size_ = polys.size();
+
+  ROS_DEBUG("built polygon index: %u polys, %dx%d cells of %.1fm",
+            (unsigned) indexed_size_, cols_, rows_, cell_size_);
+}
+
+void PolyIndex::getCandidates(float x, float y,
+                              std::vector<int> &candidates) const
+{
+  candidates.clear();
+  if (empty())
+    return;
+
+  const std::vector<int> &cell = cells_[row(y) * cols_ + col(x)];
+  candidates.insert(candidates.end(), cell.begin(), cell.end());
+}
+
+void PolyIndex::getCandidates(float x, float y, float radius,
+                              std::vector<int> &candidates) const
+{
+  candidates.clear();
+  if (empty())
+    return;
+
+  int c0 = col(x - radius);
+  int c1 = col(x + radius);
+  int r0 = row(y - radius);
+  int r1 = row(y + radius);
+  for (int r = r0; r <= r1; ++r)
+    for (int c = c0; c <= c1; ++c)
+      {
+        const std::vector<int> &cell = cells_[r * cols_ + c];
+        candidates.insert(candidates.end(), cell.begin(), cell.end());
+      }
+}
@@ -18,6 +18,7 @@
  */
 #include <float.h>
 #include <assert.h>
+#include <algorithm>
 #include <limits>
 #include <iostream>
 
@@ -26,13 +27,26 @@
 #include <art_map/coordinates.h>
 #include <art_map/euclidean_distance.h>
 #include <art_map/PolyOps.h>
+#include <art_map/PolyArrays.h>
+#include <art_map/PolyIndex.h>
+#include <art_map/ShmRoadMap.h>
+#include <art_map/WayPointIndex.h>
 
 // for turning on extremely verbose driver logging:
 //#define EXTREME_DEBUG 1
 
 PolyOps::PolyOps()
 {
-  //constructor
+  poly_index_ = NULL;
+  poly_arrays_ = NULL;
+  waypt_index_ = NULL;
+  memo_polys_ = NULL;
+  memo_size_ = 0;
+  memo_index_ = -1;
+  memo_x_ = memo_y_ = 0.0;
+  prefix_polys_ = NULL;
+  prefix_size_ = 0;
+  prefix_first_id_ = prefix_last_id_ = -1;
 }
 
 PolyOps::~PolyOps()
@@ -150,19 +164,189 @@ float PolyOps::getShortestDistToPoly(float x, float y, const poly& p)
        < dist)
     dist = d;
 
-  if ( (d = shortestDistToLineSegment(x, y, p.p4.x, p.p4.y, p.p1.x, p.p1.y)) 
+  if ( (d = shortestDistToLineSegment(x, y, p.p4.x, p.p4.y, p.p1.x, p.p1.y))
        < dist)
     dist = d;
-	
+
+  return dist;
+}
+
+// squared version of getShortestDistToPoly(): same result ordering,
+// no square roots
+float PolyOps::getShortestDistToPolySquared(float x, float y, const poly& p)
+{
+  float dist = 0;
+  float d;
+
+  // first check if point lies inside polygon - if so, return 0
+  if (pointInPoly(x, y, p))
+    return dist;
+
+  dist = Euclidean::DistanceFromLineSquared(x, y, p.p1.x, p.p1.y,
+					    p.p2.x, p.p2.y);
+
+  if ( (d = Euclidean::DistanceFromLineSquared(x, y, p.p2.x, p.p2.y,
+					       p.p3.x, p.p3.y)) < dist)
+    dist = d;
+
+  if ( (d = Euclidean::DistanceFromLineSquared(x, y, p.p3.x, p.p3.y,
+					       p.p4.x, p.p4.y)) < dist)
+    dist = d;
+
+  if ( (d = Euclidean::DistanceFromLineSquared(x, y, p.p4.x, p.p4.y,
+					       p.p1.x, p.p1.y)) < dist)
+    dist = d;
+
   return dist;
 }
 
+// closest-poly search through the attached spatial index
+//
+// Expands the candidate radius until the best distance found is
+// certain: nothing outside the searched cells can be closer than the
+// radius covering them.
+int PolyOps::getClosestPolyIndexed(const std::vector<poly>& polys,
+                                   float x, float y)
+{
+  std::vector<int> candidates;
+  float radius = poly_index_->cellSize();
+  for (;;)
+    {
+      poly_index_->getCandidates(x, y, radius, candidates);
+
+      int index = -1;
+      float min_dist2 = std::numeric_limits<float>::max();
+      for (unsigned i = 0; i < candidates.size(); ++i)
+        {
+          float d2 = getShortestDistToPolySquared(x, y,
+                                                  polys.at(candidates[i]));
+          if (Epsilon::equal(d2, 0))	// point is inside polygon
+            return candidates[i];
+          if (d2 < min_dist2)
+            {
+              min_dist2 = d2;
+              index = candidates[i];
+            }
+        }
+
+      // accept the best candidate only if no unsearched polygon
+      // could possibly be closer
+      if (index >= 0 && min_dist2 <= radius*radius)
+        return index;
+
+      // radius covered the whole map without finding anything closer
+      if (radius >= poly_index_->maxExtent())
+        return index;
+
+      radius *= 2;
+    }
+}
+
+// closest-poly search pre-filtered by the attached midpoint arrays
+//
+// The structure-of-arrays scan touches only contiguous midpoint
+// coordinates to prune the list, then the exact distance test runs
+// over the few surviving candidates.
+int PolyOps::getClosestPolySoA(const std::vector<poly>& polys,
+                               float x, float y)
+{
+  std::vector<int> candidates;
+  poly_arrays_->getCandidatesByMidpoint(x, y, candidates);
+
+  int index = -1;
+  float min_dist2 = std::numeric_limits<float>::max();
+  for (unsigned i = 0; i < candidates.size(); ++i)
+    {
+      float d2 = getShortestDistToPolySquared(x, y, polys.at(candidates[i]));
+      if (Epsilon::equal(d2, 0))	// point is inside polygon
+        return candidates[i];
+      if (d2 < min_dist2)
+        {
+          min_dist2 = d2;
+          index = candidates[i];
+        }
+    }
+
+  return index;
+}
+
+// closest-poly search seeded from the memoized previous result
+//
+// On consecutive navigator cycles the vehicle pose moves only a
+// fraction of a polygon length, so the closest polygon is almost
+// always the previous one or an immediate neighbor in list order.
+// Returns -1 when the memo is stale or cannot answer with certainty,
+// in which case the caller falls back to a wider search.
+int PolyOps::getClosestPolyMemoized(const std::vector<poly>& polys,
+                                    float x, float y)
+{
+  if (memo_polys_ != &polys
+      || memo_size_ != polys.size()
+      || memo_index_ < 0
+      || memo_index_ >= (int) polys.size())
+    return -1;				// memo stale for this vector
+
+  // only trust the memo while the query point stays within a polygon
+  // length of the previous one
+  float poly_length = polys.at(memo_index_).length;
+  if (!Euclidean::DistanceLessThan(x, y, memo_x_, memo_y_, poly_length))
+    return -1;
+
+  // check the remembered polygon and its immediate neighbors
+  int lo = std::max(0, memo_index_ - 2);
+  int hi = std::min((int) polys.size() - 1, memo_index_ + 2);
+  int best = -1;
+  float min_dist2 = std::numeric_limits<float>::max();
+  for (int i = lo; i <= hi; ++i)
+    {
+      float d2 = getShortestDistToPolySquared(x, y, polys.at(i));
+      if (Epsilon::equal(d2, 0))	// point is inside polygon
+        return i;
+      if (d2 < min_dist2)
+        {
+          min_dist2 = d2;
+          best = i;
+        }
+    }
+
+  // accept the nearest neighbor only while it remains close to the
+  // lane; otherwise some other lane's polygon may now be closer
+  if (best >= 0 && min_dist2 < poly_length*poly_length)
+    return best;
+
+  return -1;
+}
+
 // if the point lies within a polygon, that polygon is returned.
 // otherwise, the nearest polygon from the list is returned index of
 // winning poly within list is stored in index
-int PolyOps::getClosestPoly(const std::vector<poly>& polys, float x, 
+int PolyOps::getClosestPoly(const std::vector<poly>& polys, float x,
 			    float y)
 {
+  // seed from last cycle's result when possible
+  int memo = getClosestPolyMemoized(polys, x, y);
+  if (memo >= 0)
+    {
+      memoizeClosestPoly(polys, x, y, memo);
+      return memo;
+    }
+
+  // use the spatial index when one is attached and current
+  if (poly_index_ != NULL && poly_index_->matches(polys))
+    {
+      memo = getClosestPolyIndexed(polys, x, y);
+      memoizeClosestPoly(polys, x, y, memo);
+      return memo;
+    }
+
+  // otherwise, use the structure-of-arrays midpoint pre-filter
+  if (poly_arrays_ != NULL && poly_arrays_->matches(polys))
+    {
+      memo = getClosestPolySoA(polys, x, y);
+      memoizeClosestPoly(polys, x, y, memo);
+      return memo;
+    }
+
   poly p;
   float d;
   int index = -1;
@@ -172,11 +356,12 @@ int PolyOps::getClosestPoly(const std::vector<poly>& polys, float x,
   for (int i = 0; (unsigned)i < polys.size(); i++)
     {
       p = polys.at(i);
-      d = getShortestDistToPoly(x, y, p);
+      d = getShortestDistToPolySquared(x, y, p);
 
       if (Epsilon::equal(d,0)) // point is inside polygon
 	{
 	  index = i;
+	  memoizeClosestPoly(polys, x, y, index);
 	  return index;
 	}
 
@@ -185,7 +370,7 @@ int PolyOps::getClosestPoly(const std::vector<poly>& polys, float x,
 	  min_dist = d;
 	  index = 0;
 	}
-		
+
       if (d < min_dist) // new minimum
 	{
 	  min_dist = d;
@@ -193,6 +378,7 @@ int PolyOps::getClosestPoly(const std::vector<poly>& polys, float x,
 	}
     }
 
+  memoizeClosestPoly(polys, x, y, index);
   return index;
 }
 
@@ -213,7 +399,7 @@ int PolyOps::getClosestNonTransPoly(const std::vector<poly>& polys, float x,
       p = polys.at(i);
       if (p.is_transition)
         continue;
-      d = getShortestDistToPoly(x, y, p);
+      d = getShortestDistToPolySquared(x, y, p);
 
       if (Epsilon::equal(d,0)) // point is inside polygon
 	{
@@ -290,59 +476,78 @@ float PolyOps::getLength(const poly& p)
 
 std::vector<poly> 
 PolyOps::getPolysBetweenPoints(const std::vector<poly>& polys,
-			       float x1, float y1, 
+			       float x1, float y1,
 			       float x2, float y2)
 {
   std::vector<poly> retPolys;
-  bool foundFirstPoint = false;
+  int start_idx, end_idx;
+  if (!getPolyRangeBetweenPoints(polys, x1, y1, x2, y2, -1,
+				 start_idx, end_idx))
+    return retPolys;
 
-  /*	
-	for (int i = 0; (unsigned)i < polys.size(); i++)
-	{
-	if(!foundFirstPoint)
-	{
-	if(pointInPoly(x1, y1, polys.at(i)))
-	foundFirstPoint = true;
-	}
-	else
-	{
-	if(pointInPoly(x2, y2, polys.at(i)))
-	break;
-				
-	retPolys.push_back(polys.at(i));
-	}
-	}
-  */
+  for (int i = start_idx; i <= end_idx; i++)
+    retPolys.push_back(polys.at(i));
+
+  return retPolys;
+}
+
+int PolyOps::findPolyFromHint(const std::vector<poly>& polys,
+			      float x, float y, int hint)
+{
+  int n = (int) polys.size();
+  if (hint < 0 || hint >= n)
+    {
+      // no usable hint: plain forward scan
+      for (int i = 0; i < n; i++)
+	if (pointInPoly(x, y, polys.at(i)))
+	  return i;
+      return -1;
+    }
+
+  // expand outward from the hint in both directions
+  for (int step = 0; step < n; step++)
+    {
+      int fwd = hint + step;
+      if (fwd < n && pointInPoly(x, y, polys.at(fwd)))
+	return fwd;
+      int back = hint - step;
+      if (step > 0 && back >= 0 && pointInPoly(x, y, polys.at(back)))
+	return back;
+      if (fwd >= n && back < 0)
+	break;				// both ends of the list reached
+    }
+  return -1;
+}
 
+bool PolyOps::getPolyRangeBetweenPoints(const std::vector<poly>& polys,
+					float x1, float y1,
+					float x2, float y2,
+					int hint,
+					int &start_idx, int &end_idx)
+{
   // find polygon corresponding to first point
-  int i;
-  for (i = 0; (unsigned)i < polys.size(); i++)
+  start_idx = findPolyFromHint(polys, x1, y1, hint);
+
+  if (start_idx < 0) // first point not in poly - find nearest poly
+    {
+      start_idx = getClosestPoly(polys, x1, y1);
+      if (start_idx < 0)
+	return false;
+    }
+
+  // The range ends just before the polygon containing the second
+  // point, or at the end of the list when that point is not found.
+  end_idx = (int) polys.size() - 1;
+  for (int i = start_idx; (unsigned) i < polys.size(); i++)
     {
-      if(pointInPoly(x1, y1, polys.at(i)))
+      if (pointInPoly(x2, y2, polys.at(i)))
 	{
-	  foundFirstPoint = true;
+	  end_idx = i - 1;
 	  break;
 	}
     }
-	
-  if (!foundFirstPoint) // first point not in poly - find nearest poly
-    {	
-      poly p;
-      i= getClosestPoly(polys, x1, y1);
-      if (i<0)
-	return retPolys;
-      p=polys.at(i);
-    }
 
-  for ( ; (unsigned)i < polys.size(); i++)
-    {
-      if(pointInPoly(x2, y2, polys.at(i)))
-	break;
-				
-      retPolys.push_back(polys.at(i));
-    }
-	
-  return retPolys;
+  return true;
 }
 
 // copy from_polys polygons to to_polygons after nearest to point
@@ -442,7 +647,9 @@ float PolyOps::shortestDistToLineSegment(float x, float y,
 int PolyOps::get_waypoint_index(const std::vector<poly> &polys,
 				const ElementID& waypoint)
 {
-  
+  if (waypt_index_ != NULL && waypt_index_->matches(polys))
+    return waypt_index_->containingPoly(waypoint);
+
   for (unsigned i=0; i<polys.size(); i++)
     if (polys.at(i).start_way==waypoint &&
 	polys.at(i).end_way==waypoint)
@@ -454,6 +661,9 @@ int PolyOps::get_waypoint_index(const std::vector<poly> &polys,
 int PolyOps::getPolyWayPt(const std::vector<poly> &polys,
 				const ElementID& waypoint) {
 
+  if (waypt_index_ != NULL && waypt_index_->matches(polys))
+    return waypt_index_->startingPoly(waypoint);
+
   for (unsigned i=0; i<polys.size(); i++)
     if (polys.at(i).start_way==waypoint)
       return i;
@@ -599,6 +809,15 @@ void PolyOps::GetPolys(const art_msgs::ArtLanes &lanes, poly_list_t &polyList)
   }
 }
 
+void PolyOps::GetPolys(const ShmRoadMap &shm, poly_list_t &polyList)
+{
+  if (!shm.valid()) {
+    polyList.clear();
+    return;
+  }
+  polyList.assign(shm.polys(), shm.polys() + shm.size());
+}
+
 void PolyOps::GetLanes(poly_list_t &polyList, art_msgs::ArtLanes &lanes)
 {
   lanes.polygons.resize(polyList.size());
@@ -607,6 +826,100 @@ void PolyOps::GetLanes(poly_list_t &polyList, art_msgs::ArtLanes &lanes)
   }
 }
 
+// centimeters per meter: fixed-point scale of the compact messages
+static const float compact_scale = 100.0;
+
+// coordinate to centimeter offset from the message origin
+static int16_t compactOffset(float coord, float origin)
+{
+  return (int16_t) rintf((coord - origin) * compact_scale);
+}
+
+// centimeter offset from the message origin back to a coordinate
+static float expandOffset(int16_t offset, float origin)
+{
+  return origin + offset / compact_scale;
+}
+
+void PolyOps::GetPolys(const art_msgs::ArtLanesCompact &lanes,
+                       poly_list_t &polyList)
+{
+  using art_msgs::ArtQuadrilateralCompact;
+  float ox = lanes.origin.x;
+  float oy = lanes.origin.y;
+  polyList.resize(lanes.polygons.size());
+  for (unsigned i = 0; i < lanes.polygons.size(); i++) {
+    const ArtQuadrilateralCompact &q = lanes.polygons[i];
+    poly &p = polyList[i];
+    p.p1 = MapXY(expandOffset(q.vertices[0], ox),
+                 expandOffset(q.vertices[1], oy));
+    p.p2 = MapXY(expandOffset(q.vertices[2], ox),
+                 expandOffset(q.vertices[3], oy));
+    p.p3 = MapXY(expandOffset(q.vertices[4], ox),
+                 expandOffset(q.vertices[5], oy));
+    p.p4 = MapXY(expandOffset(q.vertices[6], ox),
+                 expandOffset(q.vertices[7], oy));
+    p.midpoint = MapXY(expandOffset(q.midpoint[0], ox),
+                       expandOffset(q.midpoint[1], oy));
+    p.heading = q.heading;
+    p.length = q.length / compact_scale;
+    p.poly_id = q.poly_id;
+    p.is_stop = q.flags & ArtQuadrilateralCompact::IS_STOP;
+    p.is_transition = q.flags & ArtQuadrilateralCompact::IS_TRANSITION;
+    p.contains_way = q.flags & ArtQuadrilateralCompact::CONTAINS_WAY;
+    p.start_way = ElementID(q.start_way);
+    p.end_way = ElementID(q.end_way);
+    p.left_boundary =
+      Lane_marking((q.flags >> ArtQuadrilateralCompact::LEFT_BOUNDARY_SHIFT)
+                   & ArtQuadrilateralCompact::BOUNDARY_MASK);
+    p.right_boundary =
+      Lane_marking((q.flags >> ArtQuadrilateralCompact::RIGHT_BOUNDARY_SHIFT)
+                   & ArtQuadrilateralCompact::BOUNDARY_MASK);
+  }
+}
+
+void PolyOps::GetLanes(poly_list_t &polyList, art_msgs::ArtLanesCompact &lanes)
+{
+  using art_msgs::ArtQuadrilateralCompact;
+
+  // use the first midpoint as origin, keeping every offset small
+  lanes.origin = geometry_msgs::Point();
+  if (!polyList.empty()) {
+    lanes.origin.x = polyList[0].midpoint.x;
+    lanes.origin.y = polyList[0].midpoint.y;
+  }
+  float ox = lanes.origin.x;
+  float oy = lanes.origin.y;
+
+  lanes.polygons.resize(polyList.size());
+  for (unsigned i = 0; i < polyList.size(); i++) {
+    poly &p = polyList[i];
+    ArtQuadrilateralCompact &q = lanes.polygons[i];
+    q.vertices[0] = compactOffset(p.p1.x, ox);
+    q.vertices[1] = compactOffset(p.p1.y, oy);
+    q.vertices[2] = compactOffset(p.p2.x, ox);
+    q.vertices[3] = compactOffset(p.p2.y, oy);
+    q.vertices[4] = compactOffset(p.p3.x, ox);
+    q.vertices[5] = compactOffset(p.p3.y, oy);
+    q.vertices[6] = compactOffset(p.p4.x, ox);
+    q.vertices[7] = compactOffset(p.p4.y, oy);
+    q.midpoint[0] = compactOffset(p.midpoint.x, ox);
+    q.midpoint[1] = compactOffset(p.midpoint.y, oy);
+    q.heading = p.heading;
+    q.length = (uint16_t) rintf(p.length * compact_scale);
+    q.poly_id = p.poly_id;
+    q.flags = ((p.is_stop? ArtQuadrilateralCompact::IS_STOP: 0)
+               | (p.is_transition? ArtQuadrilateralCompact::IS_TRANSITION: 0)
+               | (p.contains_way? ArtQuadrilateralCompact::CONTAINS_WAY: 0)
+               | (p.left_boundary
+                  << ArtQuadrilateralCompact::LEFT_BOUNDARY_SHIFT)
+               | (p.right_boundary
+                  << ArtQuadrilateralCompact::RIGHT_BOUNDARY_SHIFT));
+    q.start_way = p.start_way.toMapID();
+    q.end_way = p.end_way.toMapID();
+  }
+}
+
 // true if curPoly is in the specified segment and lane
 bool PolyOps::LanePoly(const poly &curPoly, WayPointNode waypt)
 {
@@ -768,21 +1081,55 @@ PolyOps::updateLaneLocation(const std::vector<poly>& polygons,
 }
 #endif
 
+/** Rebuild the prefix-sum arc-length table when the poly list changes.
+ *
+ *  Like the closest-poly memo, the cache is keyed on the vector's
+ *  address and size; the first and last poly IDs guard against a
+ *  list rebuilt in place with the same length.
+ */
+void PolyOps::updatePrefixSums(const std::vector<poly>& polygons)
+{
+  if (prefix_polys_ == &polygons
+      && prefix_size_ == polygons.size()
+      && !polygons.empty()
+      && prefix_first_id_ == polygons.front().poly_id
+      && prefix_last_id_ == polygons.back().poly_id)
+    return;				// table still valid
+
+  prefix_len_.resize(polygons.size() + 1);
+  prefix_len_[0] = 0.0;
+  for (unsigned i = 0; i < polygons.size(); ++i)
+    prefix_len_[i+1] = prefix_len_[i] + polygons[i].length;
+
+  prefix_polys_ = &polygons;
+  prefix_size_ = polygons.size();
+  if (!polygons.empty())
+    {
+      prefix_first_id_ = polygons.front().poly_id;
+      prefix_last_id_ = polygons.back().poly_id;
+    }
+  else
+    {
+      prefix_first_id_ = prefix_last_id_ = -1;
+    }
+}
+
 float PolyOps::length_between_polygons(const std::vector<poly>& polygons,
 				       int index1,
-				       int index2) 
+				       int index2)
 {
-  float length = 0;
-
   index1=std::max(0,index1);
   index1=std::min(int(polygons.size()),index1);
-  
+
   index2=std::max(0,index2);
   index2=std::min(int(polygons.size()),index2);
-  
-  for(int i = index1+1; i < index2; i++)
-    length += polygons.at(i).length;
-  return length;
+
+  // sum of lengths of polygons strictly between index1 and index2
+  if (index2 <= index1 + 1)
+    return 0;
+
+  updatePrefixSums(polygons);
+  return prefix_len_[index2] - prefix_len_[index1 + 1];
 }
 
 //Finds the distance between the midpoints of two polygons
@@ -926,6 +1273,27 @@ std::set<ElementID> PolyOps::getPolyLaneIds(const std::vector<poly>& polys)
   return lane_ids;
 }
 
+// order lane IDs by packed 64-bit key: one word compare per element
+static bool packedIdLess(const ElementID &a, const ElementID &b)
+{
+  return a.pack() < b.pack();
+}
+
+// Fill a sorted vector of unique lane IDs for the polys in the list
+void PolyOps::getPolyLaneIdVector(const std::vector<poly>& polys,
+				  std::vector<ElementID>& lane_ids)
+{
+  lane_ids.clear();
+  lane_ids.reserve(polys.size());
+  for (uint i = 0; i < polys.size(); ++i) {
+    lane_ids.push_back(ElementID(polys.at(i).start_way.seg,
+				 polys.at(i).start_way.lane, 0));
+  }
+  std::sort(lane_ids.begin(), lane_ids.end(), packedIdLess);
+  lane_ids.erase(std::unique(lane_ids.begin(), lane_ids.end()),
+		 lane_ids.end());
+}
+
 #if 0 //TODO
 // Return a unique lane ID corresponding to the polys/dir given
 // (uses transition polygons to determine closest lanes)
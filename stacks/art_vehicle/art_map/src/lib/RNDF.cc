@@ -63,9 +63,30 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 
 
 
+  // Read the whole file into one buffer, then scan lines out of it.
+  // Competition-size RNDFs run to tens of thousands of lines, and a
+  // single read is much faster than that many getline calls.
+  std::string contents;
+  rndf_file.seekg(0, std::ios::end);
+  contents.resize(rndf_file.tellg());
+  rndf_file.seekg(0, std::ios::beg);
+  if (contents.size() > 0)
+    rndf_file.read(&contents[0], contents.size());
+
+  size_t scan_pos = 0;
   std::string lineread;
-  while(getline(rndf_file, lineread)) // Read line by line
+  while(scan_pos <= contents.size()) // Read line by line
     {
+      size_t eol = contents.find('\n', scan_pos);
+      if (eol == std::string::npos)
+	{
+	  if (scan_pos >= contents.size())
+	    break;
+	  eol = contents.size();
+	}
+      lineread.assign(contents, scan_pos, eol - scan_pos);
+      scan_pos = eol + 1;
+
       line_number++;
       uint real_characters=0;
 
@@ -129,6 +150,7 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 	    parse_integer(lineread, std::string("num_segments"),
 			  line_number, valid, verbose);
 	  if (number_of_segments <= 0) valid = false;
+	  else segments.reserve(number_of_segments);
 	}
 	//NUM_ZONES
 	else if (token.compare("num_zones") == 0){
@@ -136,6 +158,7 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 	    parse_integer(lineread, std::string("num_zones"),
 			  line_number, valid, verbose);
 	  if (number_of_zones < 0) valid = false;
+	  else zones.reserve(number_of_zones);
 	}
 	//FORMAT_VERSION
 	else if (token.compare("format_version") == 0)
@@ -174,6 +197,7 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 	    parse_integer(lineread, std::string("num_lanes"),
 			  line_number, valid, verbose);
 	  if (temp_segment.number_of_lanes <= 0) valid = false;
+	  else temp_segment.lanes.reserve(temp_segment.number_of_lanes);
 	}
 	//SEGMENT_NAME
 	else if(token.compare("segment_name") == 0)
@@ -215,6 +239,7 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 	    parse_integer(lineread, std::string("num_waypoints"),
 			  line_number, valid, verbose);
 	  if (temp_lane.number_of_waypoints <= 0) valid = false;
+	  else temp_lane.waypoints.reserve(temp_lane.number_of_waypoints);
 	}
 	//LANE_WIDTH
 	else if(token.compare("lane_width") == 0){
@@ -303,6 +328,7 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 	    parse_integer(lineread, std::string("num_spots"),
 			  line_number, valid, verbose);
 	  if (temp_zone.number_of_parking_spots < 0) valid = false;	
+	  else temp_zone.spots.reserve(temp_zone.number_of_parking_spots);
 	}
 	//ZONE_NAME
 	else if(token.compare("zone_name") == 0)
@@ -347,6 +373,9 @@ RNDF::RNDF(std::string rndfname, bool verbose)
 			  line_number, valid, verbose);
 	  if (temp_perimeter.number_of_perimeterpoints <= 0)
 	    valid = false;
+	  else
+	    temp_perimeter.perimeterpoints.reserve
+	      (temp_perimeter.number_of_perimeterpoints);
 	}
 	//EXIT
 	else if(token.compare("exit") == 0){
@@ -0,0 +1,200 @@
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     C++ class for the shared-memory road map segment.
+
+     @author Jack O'Quin
+
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ros/ros.h>
+
+#include <art_map/ShmRoadMap.h>
+
+// segment format: reject anything not written by this layout
+#define SHM_MAP_MAGIC   0x4d525348      // "HSRM"
+#define SHM_MAP_VERSION 2
+
+namespace
+{
+  /** fixed segment header, followed by raw poly records.
+   *
+   *  The header is padded to 32 bytes so the records behind it start
+   *  on a 16-byte boundary, preserving the poly class alignment for
+   *  readers using vector loads (format version 2).
+   */
+  struct ShmMapHeader
+  {
+    uint32_t magic;			// SHM_MAP_MAGIC
+    uint32_t format;			// SHM_MAP_VERSION
+    uint32_t poly_record;		// sizeof(poly) when written
+    uint32_t n_polys;			// number of records
+    uint32_t map_version;		// map contents version
+    volatile uint32_t ready;		// set last, after records written
+    uint32_t reserved[2];		// pad records to 16-byte boundary
+  };
+}
+
+ShmRoadMap::ShmRoadMap()
+{
+  owner_ = false;
+  base_ = NULL;
+  seg_size_ = 0;
+  polys_ = NULL;
+  count_ = 0;
+  version_ = 0;
+}
+
+ShmRoadMap::~ShmRoadMap()
+{
+  detach();
+}
+
+bool ShmRoadMap::create(const std::string &name, const poly_list_t &polys,
+                        uint32_t version)
+{
+  detach();
+
+  // replace any stale segment a previous run left behind
+  shm_unlink(name.c_str());
+
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+    {
+      ROS_ERROR("shm_open(%s) failed: %s", name.c_str(), strerror(errno));
+      return false;
+    }
+
+  uint32_t size = sizeof(ShmMapHeader) + polys.size() * sizeof(poly);
+  if (ftruncate(fd, size) != 0)
+    {
+      ROS_ERROR("ftruncate(%s) failed: %s", name.c_str(), strerror(errno));
+      close(fd);
+      shm_unlink(name.c_str());
+      return false;
+    }
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);				// mapping keeps the segment open
+  if (base == MAP_FAILED)
+    {
+      ROS_ERROR("mmap(%s) failed: %s", name.c_str(), strerror(errno));
+      shm_unlink(name.c_str());
+      return false;
+    }
+
+  ShmMapHeader *hdr = (ShmMapHeader *) base;
+  hdr->magic = SHM_MAP_MAGIC;
+  hdr->format = SHM_MAP_VERSION;
+  hdr->poly_record = sizeof(poly);
+  hdr->n_polys = polys.size();
+  hdr->map_version = version;
+  hdr->ready = 0;
+  hdr->reserved[0] = hdr->reserved[1] = 0;
+
+  // raw poly records, same layout as the binary map cache
+  if (!polys.empty())
+    memcpy(hdr + 1, &polys[0], polys.size() * sizeof(poly));
+
+  // publish the records to any reader already attached
+  hdr->ready = 1;
+
+  name_ = name;
+  owner_ = true;
+  base_ = base;
+  seg_size_ = size;
+  polys_ = (const poly *) (hdr + 1);
+  count_ = hdr->n_polys;
+  version_ = version;
+
+  ROS_INFO("shared road map %s created: %u polys, %u bytes",
+           name.c_str(), count_, seg_size_);
+  return true;
+}
+
+bool ShmRoadMap::attach(const std::string &name, uint32_t version)
+{
+  detach();
+
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    {
+      ROS_WARN("shm_open(%s) failed: %s", name.c_str(), strerror(errno));
+      return false;
+    }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0
+      || (size_t) st.st_size < sizeof(ShmMapHeader))
+    {
+      ROS_WARN("shared road map %s: bad segment size", name.c_str());
+      close(fd);
+      return false;
+    }
+
+  void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    {
+      ROS_WARN("mmap(%s) failed: %s", name.c_str(), strerror(errno));
+      return false;
+    }
+
+  const ShmMapHeader *hdr = (const ShmMapHeader *) base;
+  if (hdr->magic != SHM_MAP_MAGIC
+      || hdr->format != SHM_MAP_VERSION
+      || hdr->poly_record != sizeof(poly)
+      || hdr->map_version != version
+      || !hdr->ready
+      || ((size_t) st.st_size
+          < sizeof(ShmMapHeader) + hdr->n_polys * sizeof(poly)))
+    {
+      ROS_WARN("shared road map %s stale or incompatible, not attached",
+               name.c_str());
+      munmap(base, st.st_size);
+      return false;
+    }
+
+  name_ = name;
+  owner_ = false;
+  base_ = base;
+  seg_size_ = st.st_size;
+  polys_ = (const poly *) (hdr + 1);
+  count_ = hdr->n_polys;
+  version_ = hdr->map_version;
+
+  ROS_INFO("shared road map %s attached: %u polys, version %u",
+           name.c_str(), count_, version_);
+  return true;
+}
+
+void ShmRoadMap::detach(void)
+{
+  if (base_ != NULL)
+    {
+      munmap(base_, seg_size_);
+      if (owner_)
+        shm_unlink(name_.c_str());
+    }
+  name_.clear();
+  owner_ = false;
+  base_ = NULL;
+  seg_size_ = 0;
+  polys_ = NULL;
+  count_ = 0;
+  version_ = 0;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <art_map/SmoothCurve.h>
 
 
@@ -129,7 +131,32 @@ SmoothCurve::SmoothCurve(const std::vector<Point2f>& ctrl,
       controlPoints[i]-= tempVec1 * del;
     }
   }
-  
+
+  compileCoefficients();
+}
+
+/**
+ * Bake power-basis coefficients for every Bezier segment, so
+ * evaluatePoint() reduces to one Horner evaluation instead of
+ * recomputing the Bernstein basis with powf() on each call.
+ */
+void SmoothCurve::compileCoefficients()
+{
+  int nseg = (int)dataPoints.size() - 1;
+  coeffs.resize(nseg*4);
+  inv_span.resize(nseg);
+  for(int s=0;s<nseg;s++){
+    Point2f b0 = bezierPoint(3*s);
+    Point2f b1 = bezierPoint(3*s+1);
+    Point2f b2 = bezierPoint(3*s+2);
+    Point2f b3 = bezierPoint(3*s+3);
+    coeffs[4*s]   = b0;
+    coeffs[4*s+1] = (b1-b0)*3.0f;
+    coeffs[4*s+2] = (b0-b1*2.0f+b2)*3.0f;
+    coeffs[4*s+3] = b3-b0+(b1-b2)*3.0f;
+    float dt = knots[s+1]-knots[s];
+    inv_span[s] = (dt > 0) ? 1.0f/dt : 0.0f;
+  }
 }
   
 SmoothCurve::~SmoothCurve() {}
@@ -202,6 +229,8 @@ void SmoothCurve::clear()
   dataPoints.clear();
   knots.clear();
   controlPoints.clear();
+  coeffs.clear();
+  inv_span.clear();
 }
     
 
@@ -216,31 +245,89 @@ Point2f SmoothCurve::evaluatePoint(float time)
   if (dataPoints.empty())
     return Point2f();
 
-  unsigned int i=0;
-  
-  while (i < knots.size() &&
-	 knots[i] <= time)
-    i++;
+  // first knot greater than time
+  unsigned int i=
+    std::upper_bound(knots.begin(),knots.end(),time)-knots.begin();
 
   if (i == 0)
     return dataPoints[0];
   if (i >= knots.size())
     return dataPoints.back();
-      
-  // Curves and Surfaces for Computer Aided Geometric Design 1st Edition
-  // Gerald Farin 
-  // Chapter 4 p 34
-  Point2f sum(0,0);
-  std::vector<float> b(degree+1,0);
-  float u = (time-knots[i-1])/(knots[i]-knots[i-1]);
-  
-  b[0]=powf(1-u,3);
-  b[1]=3*(u*powf(1-u,2));
-  b[2]=3*(powf(u,2)*powf(1-u,1));
-  b[3]=powf(u,3);
-  
-  i=(i-1)*3;
-  for(int j=0;j<degree+1;j++)
-    sum+=bezierPoint(i+j)*b[j];
-  return sum;
+
+  // Horner evaluation of the baked segment polynomial; see
+  // compileCoefficients().
+  float u = (time-knots[i-1])*inv_span[i-1];
+  Point2f *c = &coeffs[(i-1)*4];
+  return ((c[3]*u+c[2])*u+c[1])*u+c[0];
+}
+
+/**
+ * Unsigned curvature at time, from the first and second derivatives
+ * of the baked segment polynomial.  Returns zero off the ends of the
+ * curve, or wherever the parameterization momentarily stalls.
+ */
+float SmoothCurve::evaluateCurvature(float time)
+{
+  if (dataPoints.empty())
+    return 0.0;
+
+  // first knot greater than time
+  unsigned int i=
+    std::upper_bound(knots.begin(),knots.end(),time)-knots.begin();
+
+  if (i == 0 || i >= knots.size())
+    return 0.0;
+
+  float u = (time-knots[i-1])*inv_span[i-1];
+  Point2f *c = &coeffs[(i-1)*4];
+
+  // derivatives with respect to time, via the chain rule
+  Point2f d1 = ((c[3]*(3.0f*u)+c[2]*2.0f)*u+c[1])*inv_span[i-1];
+  Point2f d2 = (c[3]*(6.0f*u)+c[2]*2.0f)*(inv_span[i-1]*inv_span[i-1]);
+
+  float speed2 = d1[0]*d1[0] + d1[1]*d1[1];
+  if (speed2 < Epsilon::float_value)
+    return 0.0;
+
+  return (fabsf(d1[0]*d2[1] - d1[1]*d2[0])
+	  / (speed2 * sqrtf(speed2)));
+}
+
+/**
+ * Evaluate n points at uniform spacing on [t0,t1], writing them to
+ * out[].  Walks the segments in order instead of searching the knot
+ * vector for every sample.
+ */
+void SmoothCurve::evaluateRange(float t0, float t1, int n, Point2f out[])
+{
+  if (n <= 0)
+    return;
+  if (dataPoints.empty())
+    {
+      for(int k=0;k<n;k++)
+	out[k]=Point2f();
+      return;
+    }
+
+  float dt = (n > 1) ? (t1-t0)/(n-1) : 0.0f;
+  unsigned int seg=0;
+  for(int k=0;k<n;k++)
+    {
+      float time = t0 + dt*k;
+      if (time < knots.front())
+	{
+	  out[k]=dataPoints[0];
+	  continue;
+	}
+      if (time >= knots.back())
+	{
+	  out[k]=dataPoints.back();
+	  continue;
+	}
+      while (knots[seg+1] <= time)
+	seg++;
+      float u = (time-knots[seg])*inv_span[seg];
+      Point2f *c = &coeffs[seg*4];
+      out[k] = ((c[3]*u+c[2])*u+c[1])*u+c[0];
+    }
 }
@@ -0,0 +1,169 @@
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     C++ class for a bearing-sector index over MapLanes polygons.
+
+     @author Jack O'Quin
+
+ */
+
+#include <math.h>
+#include <float.h>
+
+#include <ros/ros.h>
+
+#include <art_map/VisionIndex.h>
+
+VisionIndex::VisionIndex()
+{
+  clear();
+}
+
+VisionIndex::~VisionIndex()
+{
+}
+
+void VisionIndex::clear(void)
+{
+  polys_ = NULL;
+  indexed_size_ = 0;
+  cell_size_ = 1.0;
+  min_x_ = min_y_ = 0.0;
+  cols_ = rows_ = 0;
+  nsectors_ = 1;
+  sector_width_ = 2.0 * M_PI;
+  buckets_.clear();
+}
+
+int VisionIndex::col(float x) const
+{
+  int c = (int) floorf((x - min_x_) / cell_size_);
+  return std::max(0, std::min(cols_ - 1, c));
+}
+
+int VisionIndex::row(float y) const
+{
+  int r = (int) floorf((y - min_y_) / cell_size_);
+  return std::max(0, std::min(rows_ - 1, r));
+}
+
+int VisionIndex::sector(float bearing) const
+{
+  int s = (int) floorf((bearing + M_PI) / sector_width_);
+  return ((s % nsectors_) + nsectors_) % nsectors_;
+}
+
+void VisionIndex::rebuild(const poly_list_t &polys, float range,
+                          float cell_size, int nsectors)
+{
+  clear();
+
+  if (polys.empty() || range <= 0.0)
+    return;
+
+  cell_size_ = cell_size;
+  nsectors_ = std::max(1, nsectors);
+  sector_width_ = 2.0 * M_PI / nsectors_;
+
+  // bounding box of all polygon midpoints: queries come from inside
+  // some polygon, so the grid need not cover more than that
+  float max_x = -FLT_MAX;
+  float max_y = -FLT_MAX;
+  min_x_ = FLT_MAX;
+  min_y_ = FLT_MAX;
+  for (unsigned i = 0; i < polys.size(); ++i)
+    {
+      min_x_ = fminf(min_x_, polys[i].midpoint.x);
+      min_y_ = fminf(min_y_, polys[i].midpoint.y);
+      max_x = fmaxf(max_x, polys[i].midpoint.x);
+      max_y = fmaxf(max_y, polys[i].midpoint.y);
+    }
+
+  cols_ = std::max(1, (int) ceilf((max_x - min_x_) / cell_size_));
+  rows_ = std::max(1, (int) ceilf((max_y - min_y_) / cell_size_));
+  buckets_.resize(cols_ * rows_ * nsectors_);
+
+  // half the diagonal of a cell: the farthest a query point can be
+  // from the center of its cell
+  float half_diag = 0.5 * sqrtf(2.0) * cell_size_;
+
+  // Bucket each polygon by bearing from the center of every cell
+  // within query range of its midpoint.  The bearing varies with the
+  // query position inside a cell, so the polygon goes into every
+  // sector that variation can reach.
+  for (unsigned i = 0; i < polys.size(); ++i)
+    {
+      const poly &p = polys[i];
+      if (p.is_transition || p.contains_way)
+        continue;                       // frustum queries skip these
+
+      int c0 = col(p.midpoint.x - range - half_diag);
+      int c1 = col(p.midpoint.x + range + half_diag);
+      int r0 = row(p.midpoint.y - range - half_diag);
+      int r1 = row(p.midpoint.y + range + half_diag);
+      for (int r = r0; r <= r1; ++r)
+        for (int c = c0; c <= c1; ++c)
+          {
+            float cx = min_x_ + (c + 0.5) * cell_size_;
+            float cy = min_y_ + (r + 0.5) * cell_size_;
+            float dx = p.midpoint.x - cx;
+            float dy = p.midpoint.y - cy;
+            float dist = sqrtf(dx*dx + dy*dy);
+            if (dist > range + half_diag)
+              continue;                 // cell corner case, out of range
+
+            // worst-case bearing change across the cell
+            float slop;
+            if (dist > 2.0 * half_diag)
+              slop = atan2f(half_diag, dist - half_diag);
+            else
+              slop = M_PI;              // close by: every sector
+
+            float bearing = atan2f(dy, dx);
+            int s0 = (int) floorf((bearing - slop + M_PI) / sector_width_);
+            int s1 = (int) floorf((bearing + slop + M_PI) / sector_width_);
+            if (s1 - s0 >= nsectors_)
+              s1 = s0 + nsectors_ - 1;
+            for (int s = s0; s <= s1; ++s)
+              {
+                int si = ((s % nsectors_) + nsectors_) % nsectors_;
+                buckets_[(r * cols_ + c) * nsectors_ + si].push_back(i);
+              }
+          }
+    }
+
+  polys_ = &polys;
+  indexed_size_ = polys.size();
+
+  ROS_DEBUG("built vision index: %u polys, %dx%d cells, %d sectors",
+            (unsigned) indexed_size_, cols_, rows_, nsectors_);
+}
+
+void VisionIndex::query(float x, float y, float heading, float half_angle,
+                        std::vector<int> &candidates) const
+{
+  candidates.clear();
+  if (empty())
+    return;
+
+  const std::vector<int> *cell =
+    &buckets_[(row(y) * cols_ + col(x)) * nsectors_];
+
+  int s0 = (int) floorf((heading - half_angle + M_PI) / sector_width_);
+  int s1 = (int) floorf((heading + half_angle + M_PI) / sector_width_);
+  if (s1 - s0 >= nsectors_)
+    s1 = s0 + nsectors_ - 1;
+  for (int s = s0; s <= s1; ++s)
+    {
+      int si = ((s % nsectors_) + nsectors_) % nsectors_;
+      candidates.insert(candidates.end(),
+                        cell[si].begin(), cell[si].end());
+    }
+}
@@ -8,7 +8,6 @@
 
 VisualLanes::VisualLanes(double physical_size,
 			     int resolution) :
-  _m(NULL),
   _physical_size(physical_size),
   _resolution(resolution),
   _x(0),
@@ -22,27 +21,95 @@ VisualLanes::VisualLanes(double physical_size,
   scan_off_bottom_side(false),
   scan_off_top_side(false),
   count(0) {
-  int r;
-  _m = new cell*[_resolution];
-  for(r = 0; r < _resolution; r++) {
-    _m[r] = NULL;
-    _m[r] = new cell[_resolution];
-  }
+  _ntiles = (_resolution + VL_TILE_SIZE - 1) / VL_TILE_SIZE;
+  _tiles.resize(_ntiles * _ntiles, NULL);
 }
 
 VisualLanes::~VisualLanes() {
-  int r;
-  for(r = 0; r < _resolution; r++) {
-    delete[] _m[r];
+  int t;
+  for(t = 0; t < _ntiles * _ntiles; t++) {
+    delete[] _tiles[t];
   }
-  delete[] _m;
 }
 
 void VisualLanes::clear() {
-  int r, c;
-  for(r = 0; r < _resolution; r++) {
-    for(c = 0; c < _resolution; c++) {
-      _m[r][c] = OCCUPANCY_UNKNOWN;
+  int t;
+  for(t = 0; t < _ntiles * _ntiles; t++) {
+    delete[] _tiles[t];
+    _tiles[t] = NULL;
+  }
+}
+
+/**
+ * Allocating access to the cell at grid indexes (x,y), both already
+ * wrapped into [0,_resolution).  The enclosing tile is created and
+ * filled with OCCUPANCY_UNKNOWN the first time a cell inside it is
+ * reached.
+ */
+cell *VisualLanes::tileCell(int x, int y)
+{
+  cell *tile = touchTile(x / VL_TILE_SIZE, y / VL_TILE_SIZE);
+  return &tile[(x % VL_TILE_SIZE) * VL_TILE_SIZE + (y % VL_TILE_SIZE)];
+}
+
+/**
+ * Base address of tile (tx,ty), creating it if necessary.
+ */
+cell *VisualLanes::touchTile(int tx, int ty)
+{
+  int t = tx * _ntiles + ty;
+  cell *tile = _tiles[t];
+  if(tile == NULL) {
+    tile = new cell[VL_TILE_SIZE * VL_TILE_SIZE];
+    for(int i = 0; i < VL_TILE_SIZE * VL_TILE_SIZE; i++)
+      tile[i] = OCCUPANCY_UNKNOWN;
+    _tiles[t] = tile;
+  }
+  return tile;
+}
+
+/**
+ * Read-only access to the cell at grid indexes (x,y); cells in tiles
+ * never touched read as OCCUPANCY_UNKNOWN without being allocated.
+ */
+cell VisualLanes::tileValue(int x, int y)
+{
+  cell *tile = _tiles[(x / VL_TILE_SIZE) * _ntiles + (y / VL_TILE_SIZE)];
+  if(tile == NULL)
+    return OCCUPANCY_UNKNOWN;
+  return tile[(x % VL_TILE_SIZE) * VL_TILE_SIZE + (y % VL_TILE_SIZE)];
+}
+
+/**
+ * Reset all cells with first index in [x0,x1) and second index in
+ * [y0,y1) to OCCUPANCY_UNKNOWN.  Tiles lying entirely inside the
+ * region are freed; tiles straddling its edge have just the covered
+ * cells reset.  Cost scales with the tiles actually allocated, not
+ * the region extent.
+ */
+void VisualLanes::clearRegion(int x0, int x1, int y0, int y1)
+{
+  for(int tx = 0; tx < _ntiles; tx++) {
+    int tx0 = tx * VL_TILE_SIZE;
+    int tx1 = tx0 + VL_TILE_SIZE;
+    if(tx1 <= x0 || tx0 >= x1)
+      continue;
+    for(int ty = 0; ty < _ntiles; ty++) {
+      cell *tile = _tiles[tx * _ntiles + ty];
+      if(tile == NULL)
+	continue;
+      int ty0 = ty * VL_TILE_SIZE;
+      int ty1 = ty0 + VL_TILE_SIZE;
+      if(ty1 <= y0 || ty0 >= y1)
+	continue;
+      if(tx0 >= x0 && tx1 <= x1 && ty0 >= y0 && ty1 <= y1) {
+	delete[] tile;
+	_tiles[tx * _ntiles + ty] = NULL;
+	continue;
+      }
+      for(int i = std::max(tx0, x0); i < std::min(tx1, x1); i++)
+	for(int j = std::max(ty0, y0); j < std::min(ty1, y1); j++)
+	  tile[(i - tx0) * VL_TILE_SIZE + (j - ty0)] = OCCUPANCY_UNKNOWN;
     }
   }
 }
@@ -66,31 +133,22 @@ void VisualLanes::initialize(double x, double y, double theta) {
 
 void VisualLanes::clearBottom()
 {
-  for(int num = _resolution/2; num < _resolution; num++)
-    for(int num2 = 0; num2 < _resolution; num2++)	
-      _m[num][num2] = 0;
-  
+  clearRegion(_resolution/2, _resolution, 0, _resolution);
 }
 
 void VisualLanes::clearTop()
 {
-  for(int num = 0; num < _resolution/2; num++)
-    for(int num2 = 0; num2 < _resolution; num2++)
-      _m[num][num2] = 0;
+  clearRegion(0, _resolution/2, 0, _resolution);
 }
 
 void VisualLanes::clearRight()
 {
-  for(int num = 0; num < _resolution; num++)
-    for(int num2 = _resolution/2; num2 < _resolution; num2++)
-      _m[num][num2] = 0;
+  clearRegion(0, _resolution, _resolution/2, _resolution);
 }
 
 void VisualLanes::clearLeft()
 {
-  for(int num = 0; num < _resolution; num++)
-    for(int num2 = 0; num2 < _resolution/2; num2++)
-      _m[num][num2] = 0;
+  clearRegion(0, _resolution, 0, _resolution/2);
 }
 
 void VisualLanes::setPosition(double x, double y, double theta) {
@@ -189,9 +247,78 @@ std::vector<float>* VisualLanes::getPose()
   return temp;
 }
 
+/**
+ * Trace every ray from the robot cell toward its endpoint in 16.16
+ * fixed point, applying the cellLighten() decrement to each visited
+ * cell.  The offset wrap is computed once per scan and the current
+ * tile pointer is reused until a ray crosses a tile boundary, so this
+ * does the work of 180 line() traces without a member function call
+ * and modulo per cell.
+ */
+void VisualLanes::lightenRays(const std::vector<double> &xs,
+			      const std::vector<double> &ys)
+{
+  int ox = (_resolution / 2 + _x_offset) % _resolution;
+  int oy = (_resolution / 2 + _y_offset) % _resolution;
+  if(ox < 0)
+    ox += _resolution;
+  if(oy < 0)
+    oy += _resolution;
+
+  int prev_tx = -1;
+  int prev_ty = -1;
+  cell *tile = NULL;
+
+  for(unsigned r = 0; r < xs.size(); r++) {
+    int x1 = (int)xs[r];
+    int y1 = (int)ys[r];
+    int ax = (x1 < 0) ? -x1 : x1;
+    int ay = (y1 < 0) ? -y1 : y1;
+    int n = std::max(ax, ay);
+    int32_t fx = 0;
+    int32_t fy = 0;
+    int32_t dfx = 0;
+    int32_t dfy = 0;
+    if(n > 0) {
+      dfx = (int32_t)((x1 << 16) / n);
+      dfy = (int32_t)((y1 << 16) / n);
+    }
+    for(int s = 0; s <= n; s++) {
+      int x = fx >> 16;
+      int y = fy >> 16;
+      fx += dfx;
+      fy += dfy;
+      if(!valid(x, y))
+	continue;
+      int cx = x + ox;
+      int cy = y + oy;
+      if(cx < 0)
+	cx += _resolution;
+      else if(cx >= _resolution)
+	cx -= _resolution;
+      if(cy < 0)
+	cy += _resolution;
+      else if(cy >= _resolution)
+	cy -= _resolution;
+      int tx = cx / VL_TILE_SIZE;
+      int ty = cy / VL_TILE_SIZE;
+      if(tx != prev_tx || ty != prev_ty) {
+	tile = touchTile(tx, ty);
+	prev_tx = tx;
+	prev_ty = ty;
+      }
+      cell &c = tile[(cx % VL_TILE_SIZE) * VL_TILE_SIZE
+		     + (cy % VL_TILE_SIZE)];
+      c = std::max(c - LOGODDS_OCCUPANCY_DECREMENT, LOGODDS_MIN_OCCUPANCY);
+    }
+  }
+}
+
 void VisualLanes::addSickScan(std::vector<double> ranges) {
   int l;
   double temp_theta = _theta - angles::from_degrees(90);
+  std::vector<double> ray_x(180);
+  std::vector<double> ray_y(180);
   for (l = 0; l < 180; l++) {
     
     double tempTheta = temp_theta + angles::from_degrees(l);
@@ -244,12 +371,18 @@ void VisualLanes::addSickScan(std::vector<double> ranges) {
       }
     
     
-    //fp = VisualLanes::cellLighten;
-    
-    
-    VisualLanes::line( 0, 0, (int)x, (int)y, (&VisualLanes::cellLighten));
-    
-    //lighten(x, y);
+    //queue the ray for the batch clearing kernel
+    ray_x[l] = x;
+    ray_y[l] = y;
+    //}
+  }
+
+  //clear along every ray in one pass
+  lightenRays(ray_x, ray_y);
+
+  for (l = 0; l < 180; l++) {
+    double x = ray_x[l];
+    double y = ray_y[l];
     double distance = Euclidean::DistanceTo(x,y,0,0);
 if ( ( distance < (laser_range / _physical_size - EPSILON)) && ranges[l] != 0)
       {
@@ -265,9 +398,8 @@ if ( ( distance < (laser_range / _physical_size - EPSILON)) && ranges[l] != 0)
 		//printf("moo\n");
 		(*c) = LOGODDS_MAX_OCCUPANCY;
 	      }
-	  }	
+	  }
       }
-    //}
   }
 }
 
@@ -434,6 +566,19 @@ cell VisualLanes::value(int x, int y) {
   else return OCCUPANCY_UNKNOWN;
 }
 
+cell VisualLanes::readValue(int x, int y) {
+  if(!valid(x, y))
+    return OCCUPANCY_UNKNOWN;
+  // same index mapping as at(), but through the non-allocating path
+  int cellX = (x + _resolution / 2 + _x_offset) % _resolution;
+  int cellY = (y + _resolution / 2 + _y_offset) % _resolution;
+  if(cellX < 0)
+    cellX += _resolution;
+  if(cellY < 0)
+    cellY += _resolution;
+  return tileValue(cellX, cellY);
+}
+
 bool VisualLanes::valid(int x, int y) {
   return (x < _resolution / 2 &&
 	  y < _resolution / 2 &&
@@ -456,7 +601,7 @@ void VisualLanes::savePGM(const char *filename) {
   fprintf(file, "P5 %d %d 255\n", _resolution, _resolution);
   for (j = _resolution - 1; j >= 0; j--) {
     for (i = 0; i < _resolution; i++) {
-      c = _m[i][j];
+      c = tileValue(i, j);
       
       d = (unsigned char)((unsigned int)(((20 - c)*255/40)));
       
@@ -758,7 +903,13 @@ cell *VisualLanes::atgoal(int x, int y)
 {
   //printf(" cell x index %i\n",
   //       ((x + _resolution)/2 + x_offsetCurrentGoal) % _resolution);
-  return &(_m[x % _resolution][y % _resolution]);
+  int cellX = x % _resolution;
+  int cellY = y % _resolution;
+  if(cellX < 0)
+    cellX += _resolution;
+  if(cellY < 0)
+    cellY += _resolution;
+  return tileCell(cellX, cellY);
 }
 
 
@@ -777,16 +928,11 @@ cell *VisualLanes::at(int x, int y) {
     //	printf("Cell Value: %i\n",
     //         (y + _resolution/2 + _y_offset) % _resolution);
     //}
-    if( cellX >= 0 && cellY >= 0 )
-      return &_m[cellX][cellY];
-    else if(cellY < 0 && cellX < 0)
-      return &_m[_resolution+cellX][_resolution+cellY];
-    else if(cellX < 0)
-      return &_m[_resolution+cellX][cellY];
-    else
-      return &_m[cellX][_resolution+cellY];
-    
-    
+    if(cellX < 0)
+      cellX += _resolution;
+    if(cellY < 0)
+      cellY += _resolution;
+    return tileCell(cellX, cellY);
   }
   return NULL;
 }
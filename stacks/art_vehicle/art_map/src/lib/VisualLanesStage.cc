@@ -0,0 +1,186 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Staged front end for the VisualLanes occupancy grid.  See
+     art_map/VisualLanesStage.h for the design.
+
+     @author Jack O'Quin
+
+ */
+
+#include <string.h>
+
+#include <boost/bind.hpp>
+
+#include <art_map/VisualLanesStage.h>
+
+VisualLanesStage::VisualLanesStage(double physical_size, int resolution):
+  lanes_(physical_size, resolution)
+{
+  head_ = 0;
+  tail_ = 0;
+  dropped_ = 0;
+  version_ = 0;
+  shutdown_ = false;
+  thread_ = new boost::thread(boost::bind(&VisualLanesStage::rasterThread,
+                                          this));
+}
+
+VisualLanesStage::~VisualLanesStage()
+{
+  {
+    boost::mutex::scoped_lock lock(wake_mutex_);
+    shutdown_ = true;
+    wake_cond_.notify_one();
+  }
+  thread_->join();
+  delete thread_;
+}
+
+void VisualLanesStage::initialize(double x, double y, double theta)
+{
+  UpdateRecord rec;
+  rec.type = INITIALIZE;
+  rec.x = x;
+  rec.y = y;
+  rec.theta = theta;
+  push(rec);
+}
+
+void VisualLanesStage::setPosition(double x, double y, double theta)
+{
+  UpdateRecord rec;
+  rec.type = SET_POSITION;
+  rec.x = x;
+  rec.y = y;
+  rec.theta = theta;
+  push(rec);
+}
+
+void VisualLanesStage::addSickScan(const std::vector<double> &ranges)
+{
+  UpdateRecord rec;
+  rec.type = SICK_SCAN;
+  // addSickScan() reads exactly 180 rays; pad a short vector with
+  // zeros, which the raster pass already treats as no return
+  size_t n = std::min(ranges.size(), (size_t) 180);
+  memset(rec.ranges, 0, sizeof(rec.ranges));
+  for (size_t i = 0; i < n; ++i)
+    rec.ranges[i] = ranges[i];
+  push(rec);
+}
+
+void VisualLanesStage::clear()
+{
+  UpdateRecord rec;
+  rec.type = CLEAR_GRID;
+  push(rec);
+}
+
+/** Append one record to the ring (producer side).
+ *
+ *  Never waits for the raster thread: when the ring is full the
+ *  record is dropped and counted, keeping sensor intake latency flat
+ *  however far drawing has fallen behind.
+ */
+void VisualLanesStage::push(const UpdateRecord &rec)
+{
+  uint32_t head = head_;
+  if (head - tail_ >= QUEUE_SIZE)
+    {
+      ++dropped_;                       // ring full, raster way behind
+      return;
+    }
+  queue_[head % QUEUE_SIZE] = rec;
+  __sync_synchronize();                 // record before publication
+  head_ = head + 1;
+
+  // wake the raster thread; the lock covers only the wakeup
+  boost::mutex::scoped_lock lock(wake_mutex_);
+  wake_cond_.notify_one();
+}
+
+/** Raster thread: applies queued records in batches.
+ *
+ *  Each pass drains everything queued so far under an odd sequence
+ *  number, so readers either see the grid as it was before the batch
+ *  or after it, never mid-drawing.
+ */
+void VisualLanesStage::rasterThread(void)
+{
+  for (;;)
+    {
+      {
+        boost::mutex::scoped_lock lock(wake_mutex_);
+        while (head_ == tail_ && !shutdown_)
+          wake_cond_.wait(lock);
+      }
+      if (head_ == tail_)
+        return;                         // shut down with nothing queued
+
+      ++version_;                       // odd: batch in progress
+      __sync_synchronize();
+
+      while (tail_ != head_)
+        {
+          UpdateRecord &rec = queue_[tail_ % QUEUE_SIZE];
+          switch (rec.type)
+            {
+            case INITIALIZE:
+              lanes_.initialize(rec.x, rec.y, rec.theta);
+              break;
+            case SET_POSITION:
+              lanes_.setPosition(rec.x, rec.y, rec.theta);
+              break;
+            case SICK_SCAN:
+              lanes_.addSickScan(std::vector<double>(rec.ranges,
+                                                     rec.ranges + 180));
+              break;
+            case CLEAR_GRID:
+              lanes_.clear();
+              break;
+            }
+          __sync_synchronize();         // done with the slot
+          ++tail_;
+        }
+
+      __sync_synchronize();
+      ++version_;                       // even: snapshot stable
+    }
+}
+
+cell VisualLanesStage::value(int x, int y)
+{
+  for (;;)
+    {
+      uint32_t v0 = version_;
+      if (v0 & 1)
+        {
+          // batch in progress, let the raster thread finish
+          boost::this_thread::yield();
+          continue;
+        }
+      __sync_synchronize();
+      cell c = lanes_.readValue(x, y);
+      __sync_synchronize();
+      if (version_ == v0)
+        return c;                       // grid unchanged while reading
+    }
+}
+
+void VisualLanesStage::flush()
+{
+  uint32_t head = head_;
+  while ((int32_t) (tail_ - head) < 0)
+    boost::this_thread::yield();
+  // wait out any batch still applying its last record
+  while (version_ & 1)
+    boost::this_thread::yield();
+}
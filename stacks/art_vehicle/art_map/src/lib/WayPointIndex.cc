@@ -0,0 +1,70 @@
+/*
+ *  Copyright (C) 2010 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     C++ class for a way-point hash index over MapLanes polygons.
+
+     @author Jack O'Quin
+
+ */
+
+#include <art_map/WayPointIndex.h>
+
+WayPointIndex::WayPointIndex()
+{
+  clear();
+}
+
+WayPointIndex::~WayPointIndex()
+{
+}
+
+void WayPointIndex::clear(void)
+{
+  polys_ = NULL;
+  indexed_size_ = 0;
+  containing_.clear();
+  starting_.clear();
+}
+
+void WayPointIndex::rebuild(const poly_list_t &polys)
+{
+  clear();
+
+  polys_ = &polys;
+  indexed_size_ = polys.size();
+
+  for (unsigned i = 0; i < polys.size(); ++i)
+    {
+      const poly &p = polys[i];
+      uint64_t start = key(p.start_way);
+
+      // insert() keeps the first occurrence, matching the list-order
+      // scans these tables replace
+      starting_.insert(std::make_pair(start, (int) i));
+      if (p.start_way == p.end_way)
+        containing_.insert(std::make_pair(start, (int) i));
+    }
+}
+
+int WayPointIndex::containingPoly(const ElementID &waypoint) const
+{
+  waypt_map_t::const_iterator it = containing_.find(key(waypoint));
+  if (it == containing_.end())
+    return -1;				// no match
+  return it->second;
+}
+
+int WayPointIndex::startingPoly(const ElementID &waypoint) const
+{
+  waypt_map_t::const_iterator it = starting_.find(key(waypoint));
+  if (it == starting_.end())
+    return -1;				// no match
+  return it->second;
+}
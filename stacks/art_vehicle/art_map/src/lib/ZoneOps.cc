@@ -1,6 +1,7 @@
 
 #include <unistd.h>
 #include <float.h>
+#include <algorithm>
 #include <vector>
 #include <map>
 
@@ -14,6 +15,7 @@
 #include <art_map/euclidean_distance.h>
 #include <art_map/PolyOps.h>
 #include <art_map/Graph.h>
+#include <art_map/MQMath.h>
 
 ZoneManager::ZoneManager(const ZonePerimeter &_zone,
 			 float _safety_radius,
@@ -616,9 +618,49 @@ ZonePerimeter ZoneOps::build_zone_perimeter_from_zone(Graph &graph,
     }
   }
 
+  simplify_perimeter(zp, ZONE_PERIMETER_TOLERANCE);
+
   return zp;
 }
 
+void ZoneOps::simplify_perimeter(ZonePerimeter &zone, float tolerance)
+{
+  PerimeterPointList &pts = zone.perimeter_points;
+  size_t npts = pts.size();
+  if (npts < 4)				// already minimal
+    return;
+
+  // Walk the ring, keeping a vertex unless it lies within tolerance
+  // of the segment joining its surviving predecessor and its
+  // successor.  Using the surviving predecessor collapses whole
+  // chains of collinear vertices in one pass.  Entry and exit
+  // way-points are always kept: other code refers to them by ID.
+  PerimeterPointList kept;
+  kept.reserve(npts);
+  kept.push_back(pts[0]);
+  for (size_t i = 1; i < npts; ++i)
+    {
+      if (!pts[i].is_entry && !pts[i].is_exit)
+	{
+	  const MapXY &prev = kept.back().map;
+	  const MapXY &next = pts[(i + 1) % npts].map;
+	  float dist_seg, dist_line;
+	  Euclidean::DistanceFromLine(pts[i].map, prev, next,
+				      dist_seg, dist_line);
+	  if (dist_seg <= tolerance && kept.size() + (npts - i) > 3)
+	    continue;			// redundant vertex
+	}
+      kept.push_back(pts[i]);
+    }
+
+  if (kept.size() < npts)
+    {
+      ROS_DEBUG("zone %d perimeter simplified from %u to %u points",
+		zone.zone_id, (unsigned) npts, (unsigned) kept.size());
+      pts.swap(kept);
+    }
+}
+
 void ZoneOps::print_zone_list(const ZonePerimeterList &zones)
 {
   ROS_DEBUG_STREAM("Number of Zones: " << zones.size());
@@ -673,24 +715,160 @@ int ZoneOps::intersections_of_segment_and_ray_to_right(const MapXY &p1,
 						       const MapXY &p3,
 						       const MapXY &r)
 {
-  if(Epsilon::equal(p2.y, r.y) && p2.x >= r.x) {
-    // p2 is on the ray
-    if ((p1.y > r.y && p3.y > r.y) || (p1.y < r.y && p3.y < r.y))
-      return 0;
-    return 1;
+  // the kernel itself lives in MQMath.h so every caller inlines it
+  return RayRightCrossesSegmentXY(p1.x, p1.y, p2.x, p2.y,
+				  p3.x, p3.y, r.x, r.y);
+}
+
+namespace
+{
+  // orders perimeter edge positions by their precomputed minimum y
+  class EdgeMinYLess
+  {
+  public:
+    explicit EdgeMinYLess(const std::vector<float> &min_y): min_y_(min_y) {}
+    bool operator()(int a, int b) const {return min_y_[a] < min_y_[b];}
+  private:
+    const std::vector<float> &min_y_;
+  };
+}
+
+void ZoneIndex::clear()
+{
+  zones_.clear();
+  min_x_.clear();
+  max_x_.clear();
+  min_y_.clear();
+  max_y_.clear();
+  edge_order_.clear();
+  edge_min_y_.clear();
+  edge_running_max_y_.clear();
+  all_min_x_ = FLT_MAX;
+  all_max_x_ = -FLT_MAX;
+  all_min_y_ = FLT_MAX;
+  all_max_y_ = -FLT_MAX;
+}
+
+void ZoneIndex::rebuild(const ZonePerimeterList &zones)
+{
+  clear();
+  zones_ = zones;
+
+  min_x_.resize(zones_.size());
+  max_x_.resize(zones_.size());
+  min_y_.resize(zones_.size());
+  max_y_.resize(zones_.size());
+  edge_order_.resize(zones_.size());
+  edge_min_y_.resize(zones_.size());
+  edge_running_max_y_.resize(zones_.size());
+
+  for(unsigned z = 0; z < zones_.size(); z++) {
+    const ZonePerimeter &zone = zones_[z];
+    unsigned n = zone.perimeter_points.size();
+
+    float minx = FLT_MAX;
+    float maxx = -FLT_MAX;
+    float miny = FLT_MAX;
+    float maxy = -FLT_MAX;
+    for(unsigned i = 0; i < n; i++) {
+      minx = fminf(minx, zone.perimeter_points[i].map.x);
+      maxx = fmaxf(maxx, zone.perimeter_points[i].map.x);
+      miny = fminf(miny, zone.perimeter_points[i].map.y);
+      maxy = fmaxf(maxy, zone.perimeter_points[i].map.y);
+    }
+    if(n == 0)
+      minx = maxx = miny = maxy = 0.0;
+
+    // Epsilon::equal() accepts relative as well as absolute error, so
+    // pad every stored bound far enough that any query the ray cast
+    // could count against a vertex still passes the filters.
+    float extent = fmaxf(fmaxf(fabsf(minx), fabsf(maxx)),
+			 fmaxf(fabsf(miny), fabsf(maxy)));
+    float pad = Epsilon::float_value * (2.0f + extent);
+
+    min_x_[z] = minx - pad;
+    max_x_[z] = maxx + pad;
+    min_y_[z] = miny - pad;
+    max_y_[z] = maxy + pad;
+
+    all_min_x_ = fminf(all_min_x_, min_x_[z]);
+    all_max_x_ = fmaxf(all_max_x_, max_x_[z]);
+    all_min_y_ = fminf(all_min_y_, min_y_[z]);
+    all_max_y_ = fmaxf(all_max_y_, max_y_[z]);
+
+    // collect each edge's padded y-range, keyed by the position of
+    // its first perimeter point
+    std::vector<float> raw_min(n);
+    std::vector<float> raw_max(n);
+    edge_order_[z].resize(n);
+    for(unsigned i = 0; i < n; i++) {
+      float y1 = zone.perimeter_points[i].map.y;
+      float y2 = zone.perimeter_points[(i+1) % n].map.y;
+      raw_min[i] = fminf(y1, y2) - pad;
+      raw_max[i] = fmaxf(y1, y2) + pad;
+      edge_order_[z][i] = i;
+    }
+
+    std::sort(edge_order_[z].begin(), edge_order_[z].end(),
+	      EdgeMinYLess(raw_min));
+
+    // rewrite the ranges in sorted order; the running maximum lets a
+    // query walk backward and stop as soon as no earlier edge can
+    // reach its y coordinate
+    edge_min_y_[z].resize(n);
+    edge_running_max_y_[z].resize(n);
+    float running_max = -FLT_MAX;
+    for(unsigned k = 0; k < n; k++) {
+      edge_min_y_[z][k] = raw_min[edge_order_[z][k]];
+      running_max = fmaxf(running_max, raw_max[edge_order_[z][k]]);
+      edge_running_max_y_[z][k] = running_max;
+    }
   }
+}
 
+bool ZoneIndex::point_in_zone(unsigned zone_num, const MapXY &point) const
+{
+  const ZonePerimeter &zone = zones_[zone_num];
+  unsigned n = zone.perimeter_points.size();
 
-  if((p1.x < r.x) && (p2.x < r.x)) return 0;
-  if((p1.y < r.y) == (p2.y < r.y)) return 0;
-  if((p1.x > r.x) && (p2.x > r.x)) return 1;
-  //By this point, we know p1 and p2 are in diagonal coordinates relative to r
+  if(n < 3)
+    return false;
 
-  if((p1.x > r.x) && (p1.y < r.y))
-    return ((p2.x - r.x)*(p1.y - r.y) < (p1.x - r.x)*(p2.y - r.y));
+  if(point.x < min_x_[zone_num] || point.x > max_x_[zone_num] ||
+     point.y < min_y_[zone_num] || point.y > max_y_[zone_num])
+    return false;
 
-  if((p1.x < r.x) && (p1.y < r.y))
-    return ((p2.x - r.x)*(p1.y - r.y) < (p1.x - r.x)*(p2.y - r.y));
-  
-  return ((p2.x - r.x)*(p1.y - r.y) > (p1.x - r.x)*(p2.y - r.y));
+  const std::vector<float> &mins = edge_min_y_[zone_num];
+  const std::vector<float> &maxs = edge_running_max_y_[zone_num];
+  const std::vector<int> &order = edge_order_[zone_num];
+
+  int intersections = 0;
+
+  // only edges whose padded y-range spans the query can contribute a
+  // crossing, so the parity here matches ZoneOps::point_in_zone()
+  int hi = std::upper_bound(mins.begin(), mins.end(), point.y) - mins.begin();
+  for(int k = hi - 1; k >= 0 && maxs[k] >= point.y; k--) {
+    unsigned i = order[k];
+    intersections += ZoneOps::intersections_of_segment_and_ray_to_right
+      (zone.perimeter_points[i].map,
+       zone.perimeter_points[(i+1) % n].map,
+       zone.perimeter_points[(i+2) % n].map,
+       point);
+  }
+
+  // Returns false is intersections is even, true if odd
+  return bool(intersections % 2);
+}
+
+segment_id_t ZoneIndex::containing_zone(const MapXY &point) const
+{
+  if(point.x < all_min_x_ || point.x > all_max_x_ ||
+     point.y < all_min_y_ || point.y > all_max_y_)
+    return -1;
+
+  for(unsigned i = 0; i < zones_.size(); i++) {
+    if(point_in_zone(i, point))
+      return zones_[i].zone_id;
+  }
+  return -1;
 }
@@ -5,6 +5,7 @@ Written and maintained by Patrick Beeson (pbeeson@cs.utexas.edu)
 //////////////////////////////////////////////////////////////////////
 #include <cstdlib>
 #include <math.h>
+#include <stdint.h>
 #include <art_map/gaussian.h>
 
 inline float real_random(float multi=1.0){
@@ -70,7 +71,81 @@ float gaussian::get_sample_1D() {
   y2 = x2 * w;
 
   float tmp=y1*_std1+_mean1;
-  
+
   return  tmp;
-}  
-  
+}
+
+/**
+   Fills out[0..n-1] with independent samples, generating the
+   Box-Muller pairs straight into the output array.
+**/
+void gaussian::get_samples_1D(float* out, int n) {
+  int i=0;
+  while (i<n) {
+    float x1, x2, w;
+    do {
+      x1 = 2.0 * real_random() - 1.0;
+      x2 = 2.0 * real_random() - 1.0;
+      w = x1 * x1 + x2 * x2;
+    } while (w>1.0 || w==0.0);
+
+    w = sqrtf((-2.0 * log(w))/w );
+    out[i++] = x1*w*_std1+_mean1;
+    if (i<n)
+      out[i++] = x2*w*_std1+_mean1;
+  }
+}
+
+namespace {
+  // exp(x) for x <= 0 with relative error below 1e-4: split
+  // x*log2(e) into integer and fraction, approximate 2^f on [0,1)
+  // with a cubic, and put the integer part back through the float
+  // exponent field.  No libm call, so a loop over it vectorizes.
+  inline float fast_expf(float x)
+  {
+    if (x < -87.0f)			// expf() underflows here too
+      return 0.0;
+    float y = x * 1.44269504f;		// x*log2(e)
+    int k = (int)floorf(y);
+    float f = y - k;
+    // cubic fit of 2^f over [0,1), relative error < 7.5e-5
+    float p = 0.99992520f
+      + f*(0.69583354f + f*(0.22606716f + f*0.078024523f));
+    union { float fl; int32_t i; } u;
+    u.fl = p;
+    u.i += (k << 23);
+    return u.fl;
+  }
+}
+
+/**
+   Density of the Gaussian at x.
+**/
+float gaussian::evaluate(float x) const {
+  if (_var1 <= 0.0)
+    return 0.0;
+  float d = x - _mean1;
+  return expf(-0.5f*d*d/_var1) / (_std1*sqrtf(2.0f*M_PI));
+}
+
+/**
+   Evaluates the density for each of x[0..n-1] into out[0..n-1].
+
+   Same density as evaluate(float), with the exp() replaced by a
+   bounded-error approximation so the whole batch runs branch- and
+   call-free.
+**/
+void gaussian::evaluate(const float* x, float* out, int n) const {
+  if (_var1 <= 0.0) {
+    for (int i=0; i<n; i++)
+      out[i] = 0.0;
+    return;
+  }
+  const float norm = 1.0f / (_std1*sqrtf(2.0f*M_PI));
+  const float half_inv_var = -0.5f / _var1;
+  for (int i=0; i<n; i++) {
+    float d = x[i] - _mean1;
+    out[i] = norm * fast_expf(half_inv_var*d*d);
+  }
+}
+
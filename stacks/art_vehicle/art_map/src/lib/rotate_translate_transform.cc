@@ -76,3 +76,34 @@ posetype rotate_translate_transform::apply_inverse_transform(const posetype& c2)
 
   return c1;
 }
+
+/**
+   Transform a whole array of coordinates (from C1 to C2) with the
+   cached rotation and offset.  The loop body has no calls, so the
+   compiler is free to vectorize it.
+**/
+void rotate_translate_transform::apply_transform(const posetype* in,
+						 posetype* out, int n) const {
+  for (int i=0; i<n; i++) {
+    out[i].x=in[i].x*actual_cs+in[i].y*-actual_sn+actual_transform.x;
+    out[i].y=in[i].x*actual_sn+in[i].y*actual_cs+actual_transform.y;
+    out[i].theta=in[i].theta+actual_transform.theta;
+  }
+}
+
+/**
+   Apply the inverse transform to a whole array of coordinates (from
+   C2 to C1).
+**/
+void rotate_translate_transform::apply_inverse_transform(const posetype* in,
+							 posetype* out,
+							 int n) const {
+  for (int i=0; i<n; i++) {
+    float rotated_x=in[i].x-actual_transform.x;
+    float rotated_y=in[i].y-actual_transform.y;
+
+    out[i].x=rotated_x*actual_cs+rotated_y*actual_sn;
+    out[i].y=rotated_x*-actual_sn+rotated_y*actual_cs;
+    out[i].theta=in[i].theta-actual_transform.theta;
+  }
+}
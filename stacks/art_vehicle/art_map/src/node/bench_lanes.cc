@@ -0,0 +1,343 @@
+/*
+ *  benchmark for art_map geometry hot paths
+ *
+ *  Copyright (C) 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <string.h>
+#include <float.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <art_msgs/ArtLanes.h>
+#include <art_map/MapLanes.h>
+#include <art_map/MQMath.h>
+#include <art_map/PolyArrays.h>
+#include <art_map/PolyIndex.h>
+#include <art_map/PolyOps.h>
+#include <art_map/ZoneOps.h>
+
+/** @file
+
+ @brief benchmark the art_map geometry kernels.
+
+ Loads an RNDF, generates its polygons via MapLanes::MapRNDF(), then
+ times getClosestPoly(), getContainingPoly(), distanceAlongLane() and
+ getPolysBetweenPoints() over increasing polygon counts, reporting
+ ns/op for each.  Run it before and after changing any of the map hot
+ paths to catch regressions.
+
+ @author Jack O'Quin
+
+*/
+
+// default parameters
+char *pname;				// program name
+char *rndf_name;
+int verbose = 0;
+bool use_index = false;
+int iterations = 10000;
+
+RNDF *rndf = NULL;
+Graph *graph = NULL;
+
+#define CMD "bench_lanes: "		// message prefix
+
+/** monotonic clock in nanoseconds */
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** build road map graph from Road Network Definition File */
+bool build_RNDF()
+{
+  rndf = new RNDF(rndf_name);
+
+  if (!rndf->is_valid)
+    {
+      std::cerr << "RNDF not valid\n";
+      return false;
+    }
+
+  graph = new Graph();
+  rndf->populate_graph(*graph);
+
+  if (graph->rndf_is_gps())
+    graph->find_mapxy();
+  else
+    graph->xy_rndf();
+
+  return true;
+}
+
+/** parse command line arguments */
+void parse_args(int argc, char *argv[])
+{
+  bool print_usage = false;
+  const char *options = "hin:v";
+  int opt = 0;
+  int option_index = 0;
+  struct option long_options[] =
+    {
+      { "help", 0, 0, 'h' },
+      { "index", 0, 0, 'i' },
+      { "iterations", 1, 0, 'n' },
+      { "verbose", 0, 0, 'v' },
+      { 0, 0, 0, 0 }
+    };
+
+  /* basename $0 */
+  pname = strrchr(argv[0], '/');
+  if (pname == 0)
+    pname = argv[0];
+  else
+    pname++;
+
+  opterr = 0;
+  while ((opt = getopt_long(argc, argv, options,
+			    long_options, &option_index)) != EOF)
+    {
+      switch (opt)
+	{
+	case 'i':
+	  use_index = true;
+	  break;
+
+	case 'n':
+	  iterations = atoi(optarg);
+	  break;
+
+	case 'v':
+	  ++verbose;
+	  break;
+
+	default:
+	  fprintf(stderr, "unknown option character %c\n", optopt);
+	  /*fallthru*/
+	case 'h':
+	  print_usage = true;
+	}
+    }
+
+  if (print_usage || optind >= argc)
+    {
+      fprintf(stderr,
+	      "usage: %s [options] RNDF_name\n\n"
+	      "    Benchmark map geometry kernels.  Possible options:\n"
+	      "\t-h, --help\tprint this message\n"
+	      "\t-i, --index\tattach the spatial index to PolyOps\n"
+	      "\t-n, --iterations\tqueries per kernel (default %d)\n"
+	      "\t-v, --verbose\tprint verbose messages\n",
+	      pname, iterations);
+      exit(9);
+    }
+
+  rndf_name = argv[optind];
+}
+
+/** deterministic query points spread over the polygon bounding box */
+static void make_query_points(const std::vector<poly> &polys,
+			      int count, std::vector<MapXY> &points)
+{
+  float min_x = FLT_MAX;
+  float min_y = FLT_MAX;
+  float max_x = -FLT_MAX;
+  float max_y = -FLT_MAX;
+  for (size_t i = 0; i < polys.size(); ++i)
+    {
+      min_x = fminf(min_x, polys[i].midpoint.x);
+      min_y = fminf(min_y, polys[i].midpoint.y);
+      max_x = fmaxf(max_x, polys[i].midpoint.x);
+      max_y = fmaxf(max_y, polys[i].midpoint.y);
+    }
+
+  // fixed seed so successive runs time identical query sequences
+  srand(42);
+  points.resize(count);
+  for (int i = 0; i < count; ++i)
+    {
+      points[i].x = min_x + (max_x-min_x) * (rand() / (float) RAND_MAX);
+      points[i].y = min_y + (max_y-min_y) * (rand() / (float) RAND_MAX);
+    }
+}
+
+/** time the four geometry kernels over the first @a size polygons */
+static void run_sweep(PolyOps &ops, const std::vector<poly> &all_polys,
+		      size_t size)
+{
+  std::vector<poly> polys(all_polys.begin(), all_polys.begin() + size);
+
+  PolyIndex index;
+  PolyArrays arrays;
+  if (use_index)
+    {
+      index.rebuild(polys);
+      arrays.rebuild(polys);
+      ops.attachIndex(&index);
+      ops.attachArrays(&arrays);
+    }
+
+  std::vector<MapXY> points;
+  make_query_points(polys, iterations, points);
+
+  // keep a checksum of each kernel's results so the compiler cannot
+  // discard the timed calls
+  long sink = 0;
+  uint64_t t0, t1;
+
+  t0 = now_ns();
+  for (int i = 0; i < iterations; ++i)
+    sink += ops.getClosestPoly(polys, points[i].x, points[i].y);
+  t1 = now_ns();
+  double closest_ns = (double) (t1-t0) / iterations;
+
+  t0 = now_ns();
+  for (int i = 0; i < iterations; ++i)
+    sink += ops.getContainingPoly(polys, points[i].x, points[i].y);
+  t1 = now_ns();
+  double contain_ns = (double) (t1-t0) / iterations;
+
+  t0 = now_ns();
+  for (int i = 0; i+1 < iterations; ++i)
+    sink += (long) ops.distanceAlongLane(polys, points[i], points[i+1]);
+  t1 = now_ns();
+  double along_ns = (double) (t1-t0) / (iterations-1);
+
+  // getPolysBetweenPoints copies whole polygon runs, so fewer queries
+  int between_iters = std::max(iterations/100, 1);
+  t0 = now_ns();
+  for (int i = 0; i+1 < between_iters; ++i)
+    sink += ops.getPolysBetweenPoints(polys,
+				      points[i].x, points[i].y,
+				      points[i+1].x, points[i+1].y).size();
+  t1 = now_ns();
+  double between_ns = (double) (t1-t0) / std::max(between_iters-1, 1);
+
+  if (use_index)
+    {
+      ops.detachIndex();
+      ops.detachArrays();
+    }
+
+  printf("%8zu %14.1f %14.1f %14.1f %14.1f\n",
+	 size, closest_ns, contain_ns, along_ns, between_ns);
+  if (verbose)
+    printf("  (checksum %ld)\n", sink);
+}
+
+/** time the point-in-polygon kernel, out-of-line versus inline.
+ *
+ *  Uses a synthetic 16-gon so the comparison is independent of the
+ *  RNDF: ZoneOps::point_in_zone() goes through the out-of-line
+ *  crossing test, PointInPolygonXY() inlines the same arithmetic from
+ *  MQMath.h.
+ */
+static void run_kernel_bench(void)
+{
+  const int nvert = 16;
+  float vx[nvert], vy[nvert];
+  ZonePerimeter zone;
+  for (int i = 0; i < nvert; ++i)
+    {
+      vx[i] = 50.0f * cosf(2.0f*PI*i/nvert);
+      vy[i] = 50.0f * sinf(2.0f*PI*i/nvert);
+      WayPointNode wp;
+      wp.map = MapXY(vx[i], vy[i]);
+      zone.perimeter_points.push_back(wp);
+    }
+
+  srand(42);
+  std::vector<MapXY> points(iterations);
+  for (int i = 0; i < iterations; ++i)
+    {
+      points[i].x = -60.0f + 120.0f * (rand() / (float) RAND_MAX);
+      points[i].y = -60.0f + 120.0f * (rand() / (float) RAND_MAX);
+    }
+
+  long sink = 0;
+  uint64_t t0, t1;
+
+  t0 = now_ns();
+  for (int i = 0; i < iterations; ++i)
+    sink += ZoneOps::point_in_zone(zone, points[i]);
+  t1 = now_ns();
+  double zone_ns = (double) (t1-t0) / iterations;
+
+  t0 = now_ns();
+  for (int i = 0; i < iterations; ++i)
+    sink += PointInPolygonXY(vx, vy, nvert, points[i].x, points[i].y);
+  t1 = now_ns();
+  double inline_ns = (double) (t1-t0) / iterations;
+
+  printf("point-in-polygon (%d vertices): "
+	 "%.1f ns/op out-of-line, %.1f ns/op inline\n",
+	 nvert, zone_ns, inline_ns);
+  if (verbose)
+    printf("  (checksum %ld)\n", sink);
+}
+
+/** main program */
+int main(int argc, char *argv[])
+{
+  int rc;
+
+  parse_args(argc, argv);
+
+  if (!build_RNDF())
+    {
+      std::cerr << "RNDF not valid\n";
+      return 1;
+    }
+
+  MapLanes *mapl = new MapLanes(verbose);
+
+  rc = mapl->MapRNDF(graph);
+  if (rc != 0)
+    {
+      std::cout << "cannot process RNDF! (error code " << rc <<")\n";
+      return 1;
+    }
+
+  art_msgs::ArtLanes lanedata;
+  rc = mapl->getAllLanes(&lanedata);
+  if (rc < 0)
+    {
+      std::cout << "error getting all polygons!\n";
+      return 1;
+    }
+
+  PolyOps ops;
+  std::vector<poly> all_polys;
+  ops.GetPolys(lanedata, all_polys);
+
+  size_t total = all_polys.size();
+  std::cout << CMD << total << " polygons from " << rndf_name
+	    << (use_index? " (indexed)": "") << "\n";
+  printf("%8s %14s %14s %14s %14s\n", "polys",
+	 "closest ns/op", "contain ns/op", "along ns/op", "between ns/op");
+
+  // sweep over increasing polygon counts to expose scaling behavior
+  for (int div = 8; div >= 1; div /= 2)
+    {
+      size_t size = total / div;
+      if (size > 0)
+	run_sweep(ops, all_polys, size);
+    }
+
+  run_kernel_bench();
+
+  return 0;
+}
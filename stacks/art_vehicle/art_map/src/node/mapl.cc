@@ -16,15 +16,24 @@
 #include <ros/ros.h>
 #include <tf/tf.h>
 
+#include <boost/thread.hpp>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
 #include <art_msgs/ArtHertz.h>
 #include <sensor_msgs/PointCloud.h>
 #include <nav_msgs/Odometry.h>
 #include <visualization_msgs/MarkerArray.h>
 
 #include <art_msgs/ArtLanes.h>
+#include <art_msgs/BringupState.h>
+#include <art_msgs/DriverState.h>
+#include <art_msgs/GetRoadMap.h>
+#include <art_msgs/RoadMapShm.h>
 #include <art_map/Graph.h>
 #include <art_map/MapLanes.h>
 #include <art_map/RNDF.h>
+#include <art_map/ShmRoadMap.h>
 
 #include <art_msgs/ArtVehicle.h>
 
@@ -40,9 +49,21 @@ Publishes:
 
 - @b roadmap_global [art_msgs::ArtLanes] global road map lanes (latched topic)
 - @b roadmap_local [art_msgs::ArtLanes] local area road map lanes
+- @b roadmap_local_compact [art_msgs::ArtLanesCompact] fixed-point
+     local road map, published only when subscribed
+- @b roadmap_shm [art_msgs::RoadMapShm] shared-memory segment
+     announcement for the global road map (latched topic)
+- @b bringup/state [art_msgs::BringupState] bringup readiness
+     reports for launch tooling (latched topic)
 - @b visualization_marker_array [visualization_msgs::MarkerArray]
      markers for map visualization
 
+Services:
+
+- @b roadmap_fetch [art_msgs::GetRoadMap] global road map as a cached
+     serialized blob, with a version stamp so restarting clients can
+     skip re-parsing an unchanged map
+
 @todo Provide centralized interface to allow map updates during
       operation.  Could be done in maplanes or in a separate node that
       reads the RNDF and publishes the graph.
@@ -68,14 +89,17 @@ public:
   bool buildRoadMap(void);
   int  Setup(ros::NodeHandle node);
   int  Shutdown(void);
-  void Spin(void);
+  void Spin(bool embedded = false);
 
 private:
 
+  art_msgs::ArtLanes::Ptr allocLanesMsg(void);
+  void announceBringup(uint8_t state, const char *detail);
   void markCar();
   void processOdom(const nav_msgs::Odometry::ConstPtr &odomIn);
   void publishGlobalMap(void);
   void publishLocalMap(void);
+  void publishShmMap(void);
   void publishMapCloud(ros::Publisher &pub,
                        const art_msgs::ArtLanes &lane_data);
   void publishMapMarks(ros::Publisher &pub,
@@ -84,9 +108,14 @@ private:
                        const art_msgs::ArtLanes &lane_data);
 
   // parameters:
-  double range_;                ///< radius of local lanes to report (m)
+  double range_;                ///< maximum local lanes extent (m)
+  double min_range_;            ///< minimum local lanes extent (m)
+  double lookahead_;            ///< forward extent per m/s of speed (s)
   double poly_size_;            ///< maximum polygon size (m)
+  int build_threads_;           ///< map build threads (0: one per core)
   std::string rndf_name_;       ///< Road Network Definition File name
+  std::string cache_name_;      ///< binary map cache file name
+  std::string shm_name_;        ///< shared-memory segment name
   std::string frame_id_;        ///< frame ID of map (default "/map")
 
   // topics and messages
@@ -94,11 +123,23 @@ private:
   nav_msgs::Odometry odom_msg_;      // last Odometry message received
 
   ros::Publisher roadmap_global_;       // global road map publisher
+  ros::Publisher roadmap_shm_;          // shared-memory map announcement
   ros::Publisher roadmap_local_;        // local road map publisher
+  ros::Publisher roadmap_compact_;      // compact local road map publisher
   ros::Publisher mapmarks_;             // rviz visualization markers
   ros::Publisher car_image_;            // rviz marker for 3D image of car
 
   ros::Publisher roadmap_cloud_;        // local road map point cloud
+  ros::Publisher bringup_state_;        // bringup readiness reports
+
+  /// background binary cache write, joined in Shutdown()
+  boost::shared_ptr<boost::thread> cache_save_thread_;
+
+  // these are only used while publishing the compact local map
+  // we define them here to avoid memory allocation on every cycle
+  PolyOps pops_;
+  poly_list_t compact_polys_;
+  art_msgs::ArtLanesCompact compact_msg_;
 
   // this vector is only used while publishMapMarks() is running
   // we define it here to avoid memory allocation on every cycle
@@ -108,9 +149,25 @@ private:
   // we define it here to avoid memory allocation on every cycle
   visualization_msgs::MarkerArray marks_msg_;
 
+  // Pool of preallocated local map messages.  Publishing a shared
+  // pointer lets intraprocess subscribers use the message without a
+  // copy; a pooled message is reused (keeping the point storage of
+  // every quad) once all subscribers have released it.
+  std::vector<art_msgs::ArtLanes::Ptr> lanes_pool_;
+
   Graph *graph_;                  ///< graph object (used by MapLanes)
   MapLanes* map_;                 ///< MapLanes object instance
   bool initial_position_;         ///< true if initial odometry received
+
+  ShmRoadMap shm_map_;            ///< shared-memory map segment (writer)
+  uint32_t map_version_;          ///< map contents version (RNDF checksum)
+
+  // map fetch service: the global map serialized once, served to
+  // every late joiner from the cache
+  bool fetchRoadMap(art_msgs::GetRoadMap::Request &req,
+                    art_msgs::GetRoadMap::Response &rsp);
+  ros::ServiceServer roadmap_fetch_;    ///< map fetch service
+  std::vector<uint8_t> map_blob_;       ///< cached serialized global map
 };
 
 /** constructor */
@@ -130,9 +187,21 @@ MapLanesDriver::MapLanesDriver(void)
   nh.param("range", range_, 80.0);
   ROS_INFO("range to publish = %.0f meters", range_);
 
+  // The local map region adapts to speed: long and narrow on the
+  // open road, short and wide at parking-lot speeds, so downstream
+  // consumers never process map they cannot reach.
+  nh.param("min_range", min_range_, 30.0);
+  ROS_INFO("minimum range to publish = %.0f meters", min_range_);
+
+  nh.param("lookahead", lookahead_, 6.0);
+  ROS_INFO("forward lookahead = %.1f seconds", lookahead_);
+
   nh.param("poly_size", poly_size_, MIN_POLY_SIZE);
   ROS_INFO("polygon size = %.0f meters", poly_size_);
 
+  nh.param("build_threads", build_threads_, 0);
+  ROS_INFO("map build threads = %d (0: one per core)", build_threads_);
+
   rndf_name_ = "";
   std::string rndf_param;
   if (nh.searchParam("rndf", rndf_param))
@@ -145,9 +214,21 @@ MapLanesDriver::MapLanesDriver(void)
       ROS_ERROR("RNDF not defined");
     }
 
+  // binary map cache, keyed to the RNDF contents; an empty name
+  // disables caching
+  nh.param("map_cache", cache_name_, rndf_name_ + ".cache");
+  if (cache_name_ != "")
+    ROS_INFO_STREAM("map cache: " << cache_name_);
+
+  // shared-memory segment for the global map; an empty name disables it
+  nh.param("shm_name", shm_name_, std::string("/art_roadmap"));
+  if (shm_name_ != "")
+    ROS_INFO_STREAM("shared map segment: " << shm_name_);
+
   // create the MapLanes class
   map_ = new MapLanes(range_);
   graph_ = NULL;
+  map_version_ = 1;
 }
 
 /** @brief create marker for car pose.
@@ -208,6 +289,11 @@ int MapLanesDriver::Setup(ros::NodeHandle node)
   roadmap_local_ =
     node.advertise<art_msgs::ArtLanes>("roadmap_local", qDepth);
 
+  // Compact local road map publisher, for telemetry links
+  roadmap_compact_ =
+    node.advertise<art_msgs::ArtLanesCompact>("roadmap_local_compact",
+                                              qDepth);
+
   // Local road map point cloud publisher
   cloud_msg_.channels.clear();
   roadmap_cloud_ =
@@ -216,6 +302,19 @@ int MapLanesDriver::Setup(ros::NodeHandle node)
   // Use latched publisher for global road map and visualization topics
   roadmap_global_ =
     node.advertise<art_msgs::ArtLanes>("roadmap_global", 1, true);
+  roadmap_shm_ =
+    node.advertise<art_msgs::RoadMapShm>("roadmap_shm", 1, true);
+
+  // map fetch service for late-joining nodes
+  roadmap_fetch_ =
+    node.advertiseService("roadmap_fetch", &MapLanesDriver::fetchRoadMap,
+                          this);
+
+  // bringup readiness reports, latched so launch tooling that
+  // subscribes late still sees the current state
+  bringup_state_ =
+    node.advertise<art_msgs::BringupState>("bringup/state", 1, true);
+  announceBringup(art_msgs::DriverState::OPENED, "building road map");
   mapmarks_ = node.advertise <visualization_msgs::MarkerArray>
     ("visualization_marker_array", 1);
 
@@ -234,9 +333,27 @@ int MapLanesDriver::Shutdown()
 {
   // Stop and join the driver thread
   ROS_INFO("shutting down maplanes");
+  if (cache_save_thread_)
+    cache_save_thread_->join();         // finish the binary cache write
   return 0;
 }
 
+/** Report this node's bringup readiness.
+ *
+ *  @param state DriverState value: OPENED while initializing, RUNNING
+ *               once the road map has been published
+ *  @param detail short progress note for the operator
+ */
+void MapLanesDriver::announceBringup(uint8_t state, const char *detail)
+{
+  art_msgs::BringupState msg;
+  msg.header.stamp = ros::Time::now();
+  msg.node = ros::this_node::getName();
+  msg.state.state = state;
+  msg.detail = detail;
+  bringup_state_.publish(msg);
+}
+
 /** Handle odometry input */
 void MapLanesDriver::processOdom(const nav_msgs::Odometry::ConstPtr &odomIn)
 {
@@ -453,11 +570,111 @@ void MapLanesDriver::publishGlobalMap(void)
 #endif
 }
 
+/** Share the global road map through a shared-memory segment.
+ *
+ *  Creates the segment with the generated polygons, then announces
+ *  its name and version on a latched topic.  The map is immutable
+ *  once generated, so late joiners attach instantly and read the
+ *  records in place, instead of having the multi-megabyte global map
+ *  re-serialized to each of them.
+ */
+void MapLanesDriver::publishShmMap(void)
+{
+  if (shm_name_ == "")
+    return;                             // segment disabled
+
+  if (!shm_map_.create(shm_name_, map_->getAllPolys(), map_version_))
+    return;                             // already logged
+
+  art_msgs::RoadMapShm announce;
+  announce.header.stamp = ros::Time::now();
+  announce.header.frame_id = frame_id_;
+  announce.name = shm_name_;
+  announce.version = map_version_;
+  announce.segment_size = shm_map_.segmentSize();
+  announce.polygons = shm_map_.size();
+  roadmap_shm_.publish(announce);
+}
+
+/** Map fetch service callback.
+ *
+ *  Returns the global road map as a serialized ArtLanes blob.  The
+ *  map is immutable once generated, so it is serialized exactly once,
+ *  on the first request; every later navigator or observer restart
+ *  gets the cached bytes back with a single copy instead of the
+ *  latched topic re-serializing the multi-megabyte message per
+ *  subscriber.  A client already holding the current version gets an
+ *  empty blob and keeps its parsed map.
+ */
+bool MapLanesDriver::fetchRoadMap(art_msgs::GetRoadMap::Request &req,
+                                  art_msgs::GetRoadMap::Response &rsp)
+{
+  rsp.version = map_version_;
+  rsp.frame_id = frame_id_;
+
+  if (req.have_version != 0 && req.have_version == map_version_)
+    return true;                        // client map is current, no blob
+
+  if (map_blob_.empty())
+    {
+      // serialize the global map once, on first request
+      art_msgs::ArtLanes lane_data;
+      if (0 == map_->getAllLanes(&lane_data))
+        {
+          ROS_WARN("no map data available to serve");
+          return false;
+        }
+      lane_data.header.stamp = ros::Time::now();
+      lane_data.header.frame_id = frame_id_;
+
+      uint32_t nbytes = ros::serialization::serializationLength(lane_data);
+      map_blob_.resize(nbytes);
+      ros::serialization::OStream stream(&map_blob_[0], nbytes);
+      ros::serialization::serialize(stream, lane_data);
+      ROS_INFO("global road map serialized once: %u bytes, version %u",
+               nbytes, map_version_);
+    }
+
+  rsp.blob = map_blob_;
+  return true;
+}
+
+/** @brief Get a local map message from the pool.
+ *
+ *  Reuses a pooled message once every subscriber has released it,
+ *  keeping its polygon and point storage allocated across cycles.
+ */
+art_msgs::ArtLanes::Ptr MapLanesDriver::allocLanesMsg(void)
+{
+  for (unsigned i = 0; i < lanes_pool_.size(); ++i)
+    {
+      if (lanes_pool_[i].unique())
+        return lanes_pool_[i];
+    }
+
+  // all pooled messages still referenced by subscribers: grow the pool
+  art_msgs::ArtLanes::Ptr fresh(new art_msgs::ArtLanes());
+  lanes_pool_.push_back(fresh);
+  return fresh;
+}
+
 /** Publish current local road map */
 void MapLanesDriver::publishLocalMap(void)
 {
-  art_msgs::ArtLanes lane_data;
-  if (0 != map_->getLanes(&lane_data, MapXY(odom_msg_.pose.pose.position)))
+  // Size the extraction ellipse from the current speed: the forward
+  // semi-axis covers ~lookahead_ seconds of travel, and the lateral
+  // one widens as the forward one shrinks (roughly constant area), so
+  // a parked or zone-speed vehicle gets a short wide map instead of
+  // the full highway circle.
+  double speed = fabs(odom_msg_.twist.twist.linear.x);
+  double forward = fmin(range_, fmax(min_range_, speed * lookahead_));
+  double lateral = fmin(range_, fmax(min_range_,
+                                     min_range_ * range_ / forward));
+
+  art_msgs::ArtLanes::Ptr lane_data = allocLanesMsg();
+  if (0 != map_->getLanes(lane_data.get(),
+                          MapPose(odom_msg_.pose.pose),
+                          forward, lateral))
     {
       ROS_DEBUG("no map data available to publish");
       return;
@@ -465,32 +682,51 @@ void MapLanesDriver::publishLocalMap(void)
 
   // the map is in the /map frame of reference with time of the
   // latest odometry message
-  lane_data.header.stamp = odom_msg_.header.stamp;
-  lane_data.header.frame_id = frame_id_;
+  lane_data->header.stamp = odom_msg_.header.stamp;
+  lane_data->header.frame_id = frame_id_;
 
-  ROS_DEBUG_STREAM("publishing " <<  lane_data.polygons.size()
+  ROS_DEBUG_STREAM("publishing " <<  lane_data->polygons.size()
                    <<" local roadmap polygons");
+
+  // publishing the shared pointer avoids serialization and copying
+  // for intraprocess subscribers
   roadmap_local_.publish(lane_data);
 
+  // build the fixed-point compact map only when someone subscribes
+  if (roadmap_compact_.getNumSubscribers() > 0)
+    {
+      pops_.GetPolys(*lane_data, compact_polys_);
+      pops_.GetLanes(compact_polys_, compact_msg_);
+      compact_msg_.header = lane_data->header;
+      roadmap_compact_.publish(compact_msg_);
+    }
+
   // publish local map with temporary duration
   publishMapMarks(mapmarks_, "local_roadmap",
-                  ros::Duration(art_msgs::ArtHertz::MAPLANES), lane_data);
+                  ros::Duration(art_msgs::ArtHertz::MAPLANES), *lane_data);
 
   // publish local map with temporary duration
-  publishMapCloud(roadmap_cloud_, lane_data);
+  publishMapCloud(roadmap_cloud_, *lane_data);
 }
 
-/** Spin function for driver thread */
-void MapLanesDriver::Spin() 
+/** Spin function for driver thread
+ *
+ *  @param embedded true when running inside a nodelet manager, whose
+ *                  threads already service our message callbacks
+ */
+void MapLanesDriver::Spin(bool embedded)
 {
   publishGlobalMap();                   // publish global map once at start
+  publishShmMap();                      // share it through shared memory
+  announceBringup(art_msgs::DriverState::RUNNING, "road map published");
 
   ros::Rate cycle(art_msgs::ArtHertz::MAPLANES); // set driver cycle rate
 
   // Loop publishing MapLanes state until driver Shutdown().
   while(ros::ok())
     {
-      ros::spinOnce();                  // handle incoming messages
+      if (!embedded)
+        ros::spinOnce();                // handle incoming messages
 
       if (initial_position_)
         {
@@ -502,10 +738,19 @@ void MapLanesDriver::Spin()
     }
 }
 
+namespace
+{
+  /** checksum thread: re-reads the RNDF while the parser runs */
+  void checksumRndf(const std::string *name, uint32_t *sum)
+  {
+    *sum = MapLanes::FileChecksum(name->c_str());
+  }
+}
+
 /** Build road map
  *
  *  @return true if successful
- */  
+ */
 bool MapLanesDriver::buildRoadMap(void)
 {
   if (rndf_name_ == "")
@@ -514,11 +759,18 @@ bool MapLanesDriver::buildRoadMap(void)
       return false;
     }
 
+  // Checksum the RNDF on a separate thread: it re-reads the whole
+  // file, which can overlap the parse below, and the result is not
+  // needed until the cache check.
+  uint32_t rndf_sum = 0;
+  boost::thread sum_thread(checksumRndf, &rndf_name_, &rndf_sum);
+
   RNDF *rndf = new RNDF(rndf_name_);
-  
+
   if (!rndf->is_valid)
     {
       ROS_FATAL("RNDF not valid");
+      sum_thread.join();
       delete rndf;
       return false;;
     }
@@ -530,10 +782,33 @@ bool MapLanesDriver::buildRoadMap(void)
   rndf->populate_graph(*graph_);
   graph_->find_mapxy();
 
+  // Try the binary map cache first: loading it takes a single bulk
+  // read instead of regenerating every polygon from the RNDF.  The
+  // cache is keyed to the RNDF contents, so an edited RNDF always
+  // regenerates.
+  sum_thread.join();
+  if (rndf_sum != 0)
+    map_version_ = rndf_sum;            // versions the shared map segment
+  if (cache_name_ != "" && rndf_sum != 0
+      && map_->LoadCache(cache_name_.c_str(), rndf_sum, graph_))
+    {
+      ROS_INFO("road map loaded from cache");
+      delete rndf;
+      return true;
+    }
+
   // MapRNDF() saves a pointer to the Graph object, so we can't delete it here.
   // That is why graph_ is a class variable, deleted in the deconstructor.
   // TODO: fix this absurd interface
-  int rc = map_->MapRNDF(graph_, poly_size_);
+  int rc;
+  if (cache_name_ != "")
+    // An edited RNDF leaves a stale cache behind: salvage the
+    // polygons of unchanged lanes and regenerate only what the edit
+    // touched, instead of a full generation pass.
+    rc = map_->MapRNDFIncremental(graph_, cache_name_.c_str(),
+                                  poly_size_, build_threads_);
+  else
+    rc = map_->MapRNDF(graph_, poly_size_, build_threads_);
   delete rndf;
 
   if (rc != 0)
@@ -542,6 +817,14 @@ bool MapLanesDriver::buildRoadMap(void)
       return false;
     }
 
+  // Save the generated polygons for the next start.  The write goes
+  // to a background thread so publishing the map is not delayed
+  // behind disk I/O; the polygons are immutable from here on.
+  if (cache_name_ != "" && rndf_sum != 0)
+    cache_save_thread_.reset
+      (new boost::thread(boost::bind(&MapLanes::SaveCache, map_,
+                                     cache_name_.c_str(), rndf_sum)));
+
   return true;
 }
 
@@ -561,3 +844,50 @@ int main(int argc, char** argv)
 
   return 0;
 }
+
+/** Nodelet version of the road map driver.
+ *
+ *  Running in the nodelet manager process lets local subscribers like
+ *  the observers and navigator receive the road map by shared pointer
+ *  with no serialization.  The standalone maplanes executable remains
+ *  available for distributed deployments.
+ *
+ *  Note: private parameters (~rndf, ~range, etc.) resolve in the
+ *  manager's namespace, so launch the manager with them set there.
+ */
+class MaplNodelet: public nodelet::Nodelet
+{
+public:
+  MaplNodelet() {}
+  ~MaplNodelet()
+    {
+      if (thread_)
+        thread_->join();                // wait for driver thread
+    }
+
+private:
+  virtual void onInit(void)
+    {
+      // Run the driver cycle in a separate thread: onInit() must not
+      // block, and buildRoadMap() can take seconds on a large RNDF.
+      thread_.reset(new boost::thread(boost::bind(&MaplNodelet::run, this)));
+    }
+
+  /** driver thread: runs until ROS shutdown */
+  void run(void)
+    {
+      ros::NodeHandle node = getNodeHandle();
+      if (dvr_.Setup(node) != 0)
+        return;
+      if (!dvr_.buildRoadMap())
+        return;
+      dvr_.Spin(true);                  // manager services our callbacks
+      dvr_.Shutdown();
+    }
+
+  MapLanesDriver dvr_;                  ///< the wrapped driver
+  boost::shared_ptr<boost::thread> thread_; ///< driver thread
+};
+
+// Register this plugin with pluginlib.
+PLUGINLIB_DECLARE_CLASS(art_map, MaplNodelet, MaplNodelet, nodelet::Nodelet);
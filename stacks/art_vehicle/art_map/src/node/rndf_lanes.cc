@@ -37,6 +37,7 @@ bool with_trans = false;
 int verbose = 0;
 char *rndf_name;
 float poly_size=-1;
+int jobs = 1;				// image rendering threads
 
 gps_info pos = {0, 0};
 RNDF *rndf = NULL;
@@ -148,13 +149,14 @@ bool build_RNDF()
 void parse_args(int argc, char *argv[])
 {
   bool print_usage = false;
-  const char *options = "hiops:tx:y:v";
+  const char *options = "hij:ops:tx:y:v";
   int opt = 0;
   int option_index = 0;
   struct option long_options[] = 
     { 
       { "help", 0, 0, 'h' },
       { "image", 0, 0, 'i' },
+      { "jobs", 1, 0, 'j' },
       { "latitude", 1, 0, 'x' },
       { "longitude", 1, 0, 'y' },
       { "size", 1, 0, 's' },
@@ -182,6 +184,10 @@ void parse_args(int argc, char *argv[])
 	  make_image = true;
 	  break;
 
+	case 'j':
+	  jobs = atoi(optarg);
+	  break;
+
 	case 'p':
 	  print_polys = true;
 	  break;
@@ -226,6 +232,7 @@ void parse_args(int argc, char *argv[])
 	      "    Display RNDF lane information.  Possible options:\n"
 	      "\t-h, --help\tprint this message\n"
 	      "\t-i, --image\tmake .pgm image of polygons\n"
+	      "\t-j, --jobs\trender the image in this many parallel tiles\n"
 	      "\t-y, --latitude\tinitial pose latitude\n"
 	      "\t-x, --longitude\tinitial pose longitude\n"
 	      "\t-s, --size\tmax polygon size\n"
@@ -344,7 +351,10 @@ int main(int argc, char *argv[])
   if (make_image) {
     ZonePerimeterList zones = ZoneOps::build_zone_list_from_rndf(*rndf, *graph);
     mapl->SetGPS(centerx,centery);
-	  mapl->testDraw(with_trans, zones);
+    if (jobs > 1)
+      mapl->testDrawTiled(with_trans, zones, jobs);
+    else
+      mapl->testDraw(with_trans, zones);
   }
   return rc;
 }
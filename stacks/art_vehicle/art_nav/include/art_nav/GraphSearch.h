@@ -14,16 +14,199 @@
 
 #include <art_map/Graph.h>
 #include <art_map/types.h>
+#include <float.h>
+#include <stdint.h>
 #include <queue>
 #include <vector>
 #include <map>
 #include <iostream>
 
 namespace GraphSearch {
+
+  /** Landmark-distance lower bounds for the A* heuristic.
+   *
+   *  Precomputes shortest travel times between a few well-spread
+   *  landmark way-points and every node (both directions), using the
+   *  same edge cost as the search at unlimited speed.  The triangle
+   *  inequality then gives a lower bound on the time between any two
+   *  nodes that is much tighter than straight-line distance across a
+   *  road network, so replanning expands far fewer nodes.  Build once
+   *  after the graph is loaded; blockages only increase edge costs,
+   *  so the bounds stay valid during a mission.
+   */
+  class LandmarkHeuristic
+  {
+  public:
+    LandmarkHeuristic(): built_(false) {}
+
+    void build(const Graph& graph, int num_landmarks = 8);
+    bool built() const {return built_;}
+
+    /** lower bound on travel time from @a from to @a to (seconds) */
+    double lowerBound(const Graph& graph,
+		      waypt_index_t from, waypt_index_t to) const;
+
+  private:
+    bool built_;
+    std::vector<int> landmarks_;	     // node array positions
+    std::vector<std::vector<double> > from_landmark_;
+    std::vector<std::vector<double> > to_landmark_;
+  };
+
+  /** Reusable A* working storage.
+   *
+   *  astar_search() needs per-node closed marks, best costs and
+   *  parent edges.  Allocating those containers fresh for every plan
+   *  shows up as allocation spikes while replanning, so a context
+   *  owns them as flat arrays sized to the node count, indexed by
+   *  node array position.  Each slot carries a generation stamp:
+   *  "clearing" between searches is one counter increment, and a slot
+   *  is live only while its stamp matches.  Keep one context per
+   *  planner; after the first search over a graph, repeated replans
+   *  allocate nothing.
+   *
+   *  Not thread safe: searches sharing a context must not overlap.
+   */
+  class SearchContext
+  {
+  public:
+
+    /** open queue entry: ((estimated total cost, cost so far),
+     *  (node index, predecessor index)) */
+    typedef std::pair<std::pair<double,double>,
+      std::pair<waypt_index_t,waypt_index_t> > SearchEntry;
+
+    SearchContext(): generation_(0), cost_speedlimit_(-1.0) {}
+
+    /** ready the arrays for a new search over @a nodes_size nodes */
+    void prepare(unsigned nodes_size);
+
+    bool closed(int pos) const
+    {
+      return (stamp_[pos] == generation_ && closed_[pos]);
+    }
+    void close(int pos) {touch(pos); closed_[pos] = true;}
+
+    /** best cost found so far to the node at @a pos, DBL_MAX if the
+     *  node has not been reached this search */
+    double bestCost(int pos) const
+    {
+      return (stamp_[pos] == generation_? best_cost_[pos]: DBL_MAX);
+    }
+    void setBest(int pos, double cost, const WayPointEdge& parent)
+    {
+      touch(pos);
+      best_cost_[pos] = cost;
+      parent_[pos] = parent;
+    }
+    const WayPointEdge& parentEdge(int pos) const {return parent_[pos];}
+
+    /** Per-edge traversal times, indexed by edge position.
+     *
+     *  cost() re-derives an edge's traversal time from its length,
+     *  speed limits and the stopping penalty on every relaxation.
+     *  None of those inputs change after the RNDF is loaded (graph
+     *  snapshots copy them unchanged, and blockages are tested
+     *  separately from cost), so the table is rebuilt only when the
+     *  edge count or the mission speed limit changes.
+     */
+    const std::vector<double>& edgeCosts(const Graph& graph,
+					 float speedlimit);
+
+    std::vector<SearchEntry> open_;	//< binary heap, capacity reused
+    std::vector<int> out_edges_;	//< edge-position scratch list
+
+  private:
+
+    // mark a slot live in the current generation, resetting its
+    // contents on first touch
+    void touch(int pos)
+    {
+      if (stamp_[pos] != generation_)
+	{
+	  stamp_[pos] = generation_;
+	  closed_[pos] = false;
+	  best_cost_[pos] = DBL_MAX;
+	}
+    }
+
+    uint32_t generation_;		//< current search number
+    std::vector<uint32_t> stamp_;	//< generation of each slot
+    std::vector<bool> closed_;		//< node already expanded
+    std::vector<double> best_cost_;	//< cheapest cost found so far
+    std::vector<WayPointEdge> parent_;	//< edge that achieved best_cost_
+
+    float cost_speedlimit_;		//< speed limit edge_cost_ assumes
+    std::vector<double> edge_cost_;	//< traversal time per edge position
+  };
+
+  WayPointEdgeList astar_search(const Graph& graph,
+				waypt_index_t start_id,
+				waypt_index_t goal_id,
+				float speedlimit,
+				const LandmarkHeuristic* landmarks,
+				SearchContext& context);
+
+  /** one-shot overload: allocates a throwaway context */
   WayPointEdgeList astar_search(const Graph& graph,
 				waypt_index_t start_id,
-				waypt_index_t goal_id, 
-				float speedlimit=1.0);
+				waypt_index_t goal_id,
+				float speedlimit=1.0,
+				const LandmarkHeuristic* landmarks=NULL);
+
+  /** Incremental route planner (D* Lite style).
+   *
+   *  Maintains a goal-rooted cost-to-goal field over the way-point
+   *  graph between calls.  While the goal is unchanged, replanning
+   *  from a new start position is just a greedy descent of the stored
+   *  field, and a blockage repairs only the region whose cost
+   *  actually changed instead of searching the full graph again.
+   *  Edge changes need not be reported: each call re-derives the
+   *  per-node one-step costs from the graph it is given (a cheap
+   *  linear pass) and queues only the nodes that became inconsistent.
+   *
+   *  Not thread safe: calls must not overlap.
+   */
+  class IncrementalPlanner
+  {
+  public:
+    IncrementalPlanner(): valid_(false) {}
+
+    /** plan or repair a route from @a start_id to @a goal_id;
+     *  returns an empty list if the goal is unreachable */
+    WayPointEdgeList plan(const Graph& graph,
+			  waypt_index_t start_id,
+			  waypt_index_t goal_id,
+			  float speedlimit);
+
+    /** discard all planner state (graph replaced wholesale) */
+    void invalidate(void) {valid_ = false;}
+
+  private:
+    /** one outgoing edge, pre-costed */
+    struct out_edge_t
+    {
+      int to;				//< successor node position
+      double cost;			//< traversal cost (seconds)
+      WayPointEdge edge;		//< edge for path extraction
+    };
+
+    void rebuild_adjacency(const Graph& graph);
+    void update_vertex(int u);
+    void compute(void);
+
+    bool valid_;			//< field below usable
+    waypt_index_t goal_id_;		//< goal the field is rooted at
+    float speedlimit_;			//< speed limit used for costs
+    int goal_pos_;			//< goal node array position
+    std::vector<std::vector<out_edge_t> > out_; //< successors per node
+    std::vector<std::vector<int> > pred_;	//< predecessors per node
+    std::vector<double> g_;		//< cost to goal per node
+    std::vector<double> rhs_;		//< one-step lookahead cost
+    std::priority_queue<std::pair<double,int>,
+      std::vector<std::pair<double,int> >,
+      std::greater<std::pair<double,int> > > open_; //< inconsistent nodes
+  };
 
   WayPointNodeList edge_list_to_node_list(const Graph& graph,
 					  WayPointEdgeList& edges);
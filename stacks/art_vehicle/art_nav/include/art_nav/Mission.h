@@ -50,10 +50,24 @@ class Mission{
   bool load(const char* fName, const Graph& graph);
   void clear();
 
+  // Binary mission snapshot: remaining checkpoints plus the blockage
+  // edges below in one compact record, written in well under a
+  // millisecond.  load() recognizes the snapshot magic number, so the
+  // old text format still loads.
+  void save_binary(const char* fName);
+  bool load_binary(const char* fName, const Graph& graph);
+
   //NOTE: Checkpoints are stored in reverse order
   std::deque<int> checkpoint_ids;
-  //Element ID is stored here. 
+  //Element ID is stored here.
   std::deque<ElementID> checkpoint_elementid;
+
+  // Blockage state captured by the commander at snapshot time: edges
+  // flagged blocked and u-turn edges added since the graph was built.
+  // Restored into the commander's blockage list on restart, so a
+  // mid-mission crash does not forget where the road was blocked.
+  std::vector<WayPointEdge> snap_blocked_edges;
+  std::vector<WayPointEdge> snap_added_edges;
 };
 
 /*int parse_integer(std::string line, std::string token, bool& valid);*/
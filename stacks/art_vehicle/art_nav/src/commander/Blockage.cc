@@ -180,3 +180,63 @@ void Blockages::add_block(ElementID other_lane_way)
     }
   blocks.push_back(new_block);
 }
+
+void Blockages::export_edges(std::vector<WayPointEdge>& blocked,
+			     std::vector<WayPointEdge>& added) const
+{
+  blocked.clear();
+  added.clear();
+  for (uint i = 0; i < blocks.size(); i++)
+    {
+      for (uint j = 0; j < blocks.at(i).added_blocks.size(); j++)
+	blocked.push_back(blocks.at(i).added_blocks.at(j));
+      for (uint j = 0; j < blocks.at(i).added_edges.size(); j++)
+	added.push_back(blocks.at(i).added_edges.at(j));
+    }
+}
+
+void Blockages::import_edges(const std::vector<WayPointEdge>& blocked,
+			     const std::vector<WayPointEdge>& added)
+{
+  if (blocked.empty() && added.empty())
+    return;
+
+  // reconstruct the saved state as one merged block: the individual
+  // block boundaries and times are gone, but the graph ends up with
+  // the same edges blocked and the same u-turn edges added
+  block new_block;
+  timeval time;
+  gettimeofday(&time, NULL);
+  new_block.block_time = time.tv_sec + (time.tv_usec/1000000.0);
+  new_block.count = 1;
+
+  for (uint i = 0; i < blocked.size(); i++)
+    for (uint j = 0; j < b_graph->edges_size; j++)
+      if ((b_graph->edges.at(j).startnode_index ==
+	   blocked.at(i).startnode_index) &&
+	  (b_graph->edges.at(j).endnode_index ==
+	   blocked.at(i).endnode_index))
+	{
+	  ROS_INFO_STREAM("Restoring blocked edge between "
+                          <<b_graph->nodes[b_graph->edges.at(j).startnode_index].id.name().str
+                          <<" and "
+                          <<b_graph->nodes[b_graph->edges.at(j).endnode_index].id.name().str);
+	  b_graph->edges.at(j).blocked=true;
+	  new_block.added_blocks.push_back(b_graph->edges[j]);
+	  break;
+	}
+
+  for (uint i = 0; i < added.size(); i++)
+    {
+      ROS_INFO_STREAM("Restoring added edge between "
+                      <<b_graph->nodes[added.at(i).startnode_index].id.name().str
+                      <<" and "
+                      <<b_graph->nodes[added.at(i).endnode_index].id.name().str);
+      new_block.added_edges.push_back(added.at(i));
+      b_graph->edges.push_back(added.at(i));
+      b_graph->edges_size++;
+    }
+
+  blocks.push_back(new_block);
+  b_graph->build_index();		// edge set changed
+}
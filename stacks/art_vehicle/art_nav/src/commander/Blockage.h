@@ -35,11 +35,19 @@ public:
     return blocks.empty();
   }
 
-  void pop_oldest(); 
-  void pop_newest(); 
-  void pop_block(uint index); 
+  void pop_oldest();
+  void pop_newest();
+  void pop_block(uint index);
   void add_block(ElementID next);
-  
+
+  // copy every block's edges out for the mission snapshot
+  void export_edges(std::vector<WayPointEdge>& blocked,
+		    std::vector<WayPointEdge>& added) const;
+
+  // restore snapshot edges into the graph as one merged block
+  void import_edges(const std::vector<WayPointEdge>& blocked,
+		    const std::vector<WayPointEdge>& added);
+
 private:
   Graph* b_graph;
   Path* b_path;
@@ -47,80 +47,80 @@
 // transition, if necessary.  Currently they do not, which is simpler.
 
 
+// The FSM graph as static const data: one row per arrow, ordered by
+// event, then previous state.  Besides building the dispatch table,
+// this array is the machine-readable transition table for offline
+// analysis of cycle paths.
+const CmdrFSM::transition_desc_t CmdrFSM::graph_[] =
+{
+  {CmdrEvent::Blocked,	CmdrState::Done,  CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::Blocked,	CmdrState::Init,  CmdrState::Init,  &CmdrFSM::ActionInInit},
+  {CmdrEvent::Blocked,	CmdrState::Road,  CmdrState::Road,  &CmdrFSM::BlockedInRoad},
+
+  {CmdrEvent::Done,	CmdrState::Done,  CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::Done,	CmdrState::Init,  CmdrState::Done,  &CmdrFSM::ActionToDone},
+  {CmdrEvent::Done,	CmdrState::Road,  CmdrState::Done,  &CmdrFSM::ActionToDone},
+
+  {CmdrEvent::EnterLane, CmdrState::Done, CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::EnterLane, CmdrState::Init, CmdrState::Road,  &CmdrFSM::InitToRoad},
+  {CmdrEvent::EnterLane, CmdrState::Road, CmdrState::Road,  &CmdrFSM::ActionInRoad},
+
+  {CmdrEvent::Fail,	CmdrState::Done,  CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::Fail,	CmdrState::Init,  CmdrState::Done,  &CmdrFSM::ActionFail},
+  {CmdrEvent::Fail,	CmdrState::Road,  CmdrState::Done,  &CmdrFSM::ActionFail},
+
+  {CmdrEvent::None,	CmdrState::Done,  CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::None,	CmdrState::Init,  CmdrState::Init,  &CmdrFSM::ActionInInit},
+  {CmdrEvent::None,	CmdrState::Road,  CmdrState::Road,  &CmdrFSM::ActionInRoad},
+
+  {CmdrEvent::Wait,	CmdrState::Done,  CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::Wait,	CmdrState::Init,  CmdrState::Init,  &CmdrFSM::ActionInInit},
+  {CmdrEvent::Wait,	CmdrState::Road,  CmdrState::Road,  &CmdrFSM::ActionWait},
+
+  {CmdrEvent::Replan,	CmdrState::Done,  CmdrState::Done,  &CmdrFSM::ActionInDone},
+  {CmdrEvent::Replan,	CmdrState::Init,  CmdrState::Init,  &CmdrFSM::ActionInInit},
+  {CmdrEvent::Replan,	CmdrState::Road,  CmdrState::Road,  &CmdrFSM::ReplanInRoad},
+};
+const size_t CmdrFSM::graph_size_ = sizeof(graph_) / sizeof(graph_[0]);
+
+// dense dispatch table, built once from graph_ and shared by all
+// instances, making dispatch a two-load operation
+CmdrFSM::transtion_t CmdrFSM::ttable[CmdrEvent::N_events][CmdrState::N_states];
+bool CmdrFSM::ttable_built = false;
+
+const CmdrFSM::transition_desc_t *CmdrFSM::transition_graph(size_t &count)
+{
+  count = graph_size_;
+  return graph_;
+}
+
 CmdrFSM::CmdrFSM(Commander *cmdr_ptr, int verbosity)
 {
   verbose = verbosity;
   cmdr = cmdr_ptr;
 
-  // initialize transition table
-  for (int event = 0; event < (int) CmdrEvent::N_events; ++event)
-    for (int state = 0; state < (int) CmdrState::N_states; ++state)
-      {
-	transtion_t *xp = &ttable[event][state];
-	xp->action = &CmdrFSM::ActionError;
-	xp->next = (CmdrState::state_t) state;
-      }
-
-  // initialize transition table:
-
-  Add(CmdrEvent::Blocked,	&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::Blocked,	&CmdrFSM::ActionInInit,
-      CmdrState::Init,		CmdrState::Init);
-  Add(CmdrEvent::Blocked,	&CmdrFSM::BlockedInRoad,
-      CmdrState::Road,		CmdrState::Road);
-
-  Add(CmdrEvent::Done,		&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::Done,		&CmdrFSM::ActionToDone,
-      CmdrState::Init,		CmdrState::Done);
-  Add(CmdrEvent::Done,		&CmdrFSM::ActionToDone,
-      CmdrState::Road,		CmdrState::Done);
-
-  Add(CmdrEvent::EnterLane,	&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::EnterLane,	&CmdrFSM::InitToRoad,
-      CmdrState::Init,		CmdrState::Road);
-  Add(CmdrEvent::EnterLane,	&CmdrFSM::ActionInRoad,
-      CmdrState::Road,		CmdrState::Road);
-
-  Add(CmdrEvent::Fail,		&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::Fail,		&CmdrFSM::ActionFail,
-      CmdrState::Init,		CmdrState::Done);
-  Add(CmdrEvent::Fail,		&CmdrFSM::ActionFail,
-      CmdrState::Road,		CmdrState::Done);
-
-
-  Add(CmdrEvent::None,		&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::None,		&CmdrFSM::ActionInInit,
-      CmdrState::Init,		CmdrState::Init);
-  Add(CmdrEvent::None,		&CmdrFSM::ActionInRoad,
-      CmdrState::Road,		CmdrState::Road);
-
-  Add(CmdrEvent::Wait,		&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::Wait,		&CmdrFSM::ActionInInit,
-      CmdrState::Init,		CmdrState::Init);
-  Add(CmdrEvent::Wait,		&CmdrFSM::ActionWait,
-      CmdrState::Road,		CmdrState::Road);
-
-  Add(CmdrEvent::Replan,	&CmdrFSM::ActionInDone,
-      CmdrState::Done,		CmdrState::Done);
-  Add(CmdrEvent::Replan,	&CmdrFSM::ActionInInit,
-      CmdrState::Init,		CmdrState::Init);
-  Add(CmdrEvent::Replan,	&CmdrFSM::ReplanInRoad,
-      CmdrState::Road,		CmdrState::Road);
-}
+  if (!ttable_built)
+    {
+      // unused entries cause an error action without a state change
+      for (int event = 0; event < (int) CmdrEvent::N_events; ++event)
+	for (int state = 0; state < (int) CmdrState::N_states; ++state)
+	  {
+	    transtion_t *xp = &ttable[event][state];
+	    xp->action = &CmdrFSM::ActionError;
+	    xp->next = (CmdrState::state_t) state;
+	  }
 
-// add a transition to the table
-void CmdrFSM::Add(CmdrEvent::event_t event, action_t action,
-		  CmdrState::state_t from_state, CmdrState::state_t to_state)
-{
-  transtion_t *xp = &ttable[event][from_state];
-  xp->action = action;
-  xp->next = to_state;
+      // expand the graph description into the dense dispatch table
+      for (size_t i = 0; i < graph_size_; ++i)
+	{
+	  const transition_desc_t *arrow = &graph_[i];
+	  transtion_t *xp = &ttable[arrow->event][arrow->from_state];
+	  xp->action = arrow->action;
+	  xp->next = arrow->to_state;
+	}
+
+      ttable_built = true;
+    }
 }
 
 art_msgs::Order CmdrFSM::control(const art_msgs::NavigatorState *_navstate)
@@ -353,6 +353,10 @@ art_msgs::Order CmdrFSM::BlockedInRoad(CmdrEvent event)
   ROS_INFO("Road blocked, making a new plan.");
 
   cmdr->blockages->add_block(navstate.replan_waypt);
+  cmdr->save_state();			// record the blockage, in case
+					// of a restart before it clears
+  cmdr->invalidate_pending_route();	// graph changed under any
+					// search already in flight
 
   if (cmdr->replan_route() == false)
     return ActionWait(event);
@@ -61,6 +61,24 @@ public:
     action_t	action;
   } transtion_t;
 
+  /** one arrow of the FSM graph.
+   *
+   *  The whole graph is a single static const array of these in
+   *  FSM.cc, so it is compile-time data shared by all instances and
+   *  a machine-readable transition table for offline analysis.
+   */
+  typedef struct
+  {
+    CmdrEvent::event_t	event;		///< triggering event
+    CmdrState::state_t	from_state;	///< previous state
+    CmdrState::state_t	to_state;	///< next state
+    action_t		action;		///< transition action
+  } transition_desc_t;
+
+  /** access the FSM graph description
+   *  @param count returns the number of arrows */
+  static const transition_desc_t *transition_graph(size_t &count);
+
   CmdrFSM(Commander *cmdr_ptr, int verbosity);
   ~CmdrFSM() {};
 
@@ -79,16 +97,20 @@ private:
   art_msgs::NavigatorState navstate;
   CmdrState prev;
   CmdrState state;
-  transtion_t ttable[CmdrEvent::N_events][CmdrState::N_states];
+
+  // dense dispatch table indexed by (event, state), built once from
+  // the static graph description and shared by all instances
+  static transtion_t ttable[CmdrEvent::N_events][CmdrState::N_states];
+  static bool ttable_built;
+
+  // the FSM graph as static const data
+  static const transition_desc_t graph_[];
+  static const size_t graph_size_;
 
   // Event state variables
   ElementID old_replan;
   bool was_in_route_network;
 
-  // add a transition to the table
-  void Add(CmdrEvent::event_t event, action_t action,
-	   CmdrState::state_t from_state, CmdrState::state_t to_state);
-
   // return most urgent current event
   CmdrEvent current_event();
 
@@ -8,12 +8,19 @@
  * $Id$
  */
 
+#include <boost/bind.hpp>
+
+#include <art_msgs/ArtHertz.h>
 #include <art_nav/GraphSearch.h>
 #include <art_nav/NavEstopState.h>
 
 #include "command.h"
 #include "FSM.h"
 
+// way-point look-ahead window sizing (see prepare_order)
+static const unsigned MIN_ORDER_WAYPTS = 5; // floor, the former fixed size
+static const double LOOKAHEAD_CYCLES = 4.0; // stall gaps the window covers
+
 Commander::Commander(int verbosity, double limit, 
 		     Graph* _graph, Mission* _mission,
 		     const ZonePerimeterList& _zones) 
@@ -27,12 +34,36 @@ Commander::Commander(int verbosity, double limit,
   graph = _graph;
   mission = _mission;
   blockages = new Blockages(graph, route);
+
+  // a mission snapshot may carry blockage state from before a
+  // restart: restore it before anything derived from the graph is
+  // built, so the landmark table and checkpoint matrix see the
+  // blocked edges
+  blockages->import_edges(mission->snap_blocked_edges,
+			  mission->snap_added_edges);
+
+  landmarks.build(*graph);
   set_checkpoint_goals();
+  chkpt_cache_valid_ = false;
+  build_checkpoint_matrix();
   replan_num = 0;
+  planner_thread_ = NULL;
+  planner_busy_ = false;
+  result_ready_ = false;
+  result_found_ = false;
+  planner_seq_ = 0;
+  snapshot_seq_ = -1;			// no snapshot copied yet
+  cycle_gap_worst_ = 0.0;
 }
 
 Commander::~Commander()
 {
+  save_state();				// snapshot mission at shutdown
+  if (planner_thread_ != NULL)
+    {
+      planner_thread_->join();
+      delete planner_thread_;
+    }
   delete blockages;
   delete fsm;
   delete route;
@@ -49,6 +80,18 @@ art_msgs::Order Commander::command(const art_msgs::NavigatorState &_navstate)
 {
   navstate = &_navstate;       // save state pointer in class variable
 
+  // track cycle regularity: the worst recent gap between cycles
+  // sizes the way-point look-ahead window in prepare_order()
+  ros::WallTime now = ros::WallTime::now();
+  if (!last_cycle_.isZero())
+    {
+      double gap = (now - last_cycle_).toSec();
+      cycle_gap_worst_ *= 0.995;	// forget old stalls gradually
+      if (gap > cycle_gap_worst_)
+	cycle_gap_worst_ = gap;
+    }
+  last_cycle_ = now;
+
   order = art_msgs::Order();             // begin with empty order
   //order.max_speed = 0.0;
   //order.min_speed = 0.0;
@@ -69,6 +112,9 @@ art_msgs::Order Commander::command(const art_msgs::NavigatorState &_navstate)
       return order;
     }
 
+  // apply any route the background planner has finished
+  check_planner();
+
   // determine most urgent event, and perform state transition for it,
   // returning next command
   return fsm->control(navstate);
@@ -78,6 +124,44 @@ art_msgs::Order Commander::command(const art_msgs::NavigatorState &_navstate)
 // Private methods
 ////////////////////////////////////////////////////////////////////
 
+// Precompute shortest paths between every ordered pair of mission
+// checkpoints.
+//
+// The MDF lists few checkpoints and the graph is static apart from
+// blockages, so this runs once at load time.  Re-sequencing the
+// mission afterwards (a skipped or failed checkpoint, or the normal
+// advance to the next one) turns the checkpoint-to-checkpoint leg of
+// each replan into a matrix lookup plus path extraction rather than
+// another full search.
+void Commander::build_checkpoint_matrix(void)
+{
+  chkpt_routes_.clear();
+
+  const std::deque<ElementID> &chkpts = mission->checkpoint_elementid;
+  unsigned routable = 0;
+  for (unsigned i = 0; i < chkpts.size(); ++i)
+    for (unsigned j = 0; j < chkpts.size(); ++j)
+      {
+	if (i == j)
+	  continue;
+	WayPointNode *from = graph->get_node_by_id(chkpts.at(i));
+	WayPointNode *to = graph->get_node_by_id(chkpts.at(j));
+	if (from == NULL || to == NULL)
+	  continue;
+	WayPointEdgeList edges =
+	  GraphSearch::astar_search(*graph, from->index, to->index,
+				    speedlimit, &landmarks, search_ctx_);
+	if (edges.empty())		// no route (zone between them?)
+	  continue;
+	chkpt_routes_[std::make_pair(from->index, to->index)] = edges;
+	++routable;
+      }
+
+  chkpt_cache_valid_ = true;
+  ROS_INFO("checkpoint route matrix: %u routable pairs among %u checkpoints",
+	   routable, (unsigned) chkpts.size());
+}
+
 // get next checkpoint, return true if any remain
 //
 // updates:
@@ -96,9 +180,9 @@ bool Commander::next_checkpoint(void)
   // remove the former checkpoint from the head of the queue
   bool retval=mission->nextPoint();
 
-  mission->save("mission_state");  
-  
-  
+  save_state();
+
+
   if (!retval)				// none left?
     return false;			// done with mission
 
@@ -193,6 +277,29 @@ art_msgs::Order Commander::prepare_order(art_msgs::Behavior::_value_type behavio
   ROS_DEBUG_STREAM("Max speed = " << order.max_speed << " m/s");
   ROS_DEBUG_STREAM("Min speed = " << order.min_speed << " m/s");
 
+  // Adaptive look-ahead: size the way-point window to cover the
+  // distance traveled at the order speed limit during several worst
+  // recent commander cycle gaps, so a brief commander stall cannot
+  // starve the navigator of way-points at speed.  The message array
+  // stays fixed size: unused tail entries repeat the last way-point
+  // of the window, which the navigator already skips as padding.
+  double period = 1.0 / art_msgs::ArtHertz::COMMANDER;
+  double horizon = LOOKAHEAD_CYCLES * fmax(cycle_gap_worst_, period);
+  double cover = order.max_speed * horizon;
+  double covered = 0.0;
+  for (unsigned i = 0; i < MIN_ORDER_WAYPTS-1; ++i)
+    covered += route->at(i).distance;
+  unsigned n_waypts = MIN_ORDER_WAYPTS;
+  while (n_waypts < art_msgs::Order::N_WAYPTS && covered < cover)
+    {
+      covered += route->at(n_waypts-1).distance;
+      ++n_waypts;
+    }
+  for (unsigned i = n_waypts; i < art_msgs::Order::N_WAYPTS; ++i)
+    order.waypt[i] = order.waypt[n_waypts-1];
+  ROS_DEBUG("look-ahead window %u waypts (%.1fm covers %.1fm)",
+	    n_waypts, covered, cover);
+
   order.replan_num=replan_num;
   order.next_uturn=-1;
 
@@ -212,13 +319,17 @@ art_msgs::Order Commander::prepare_order(art_msgs::Behavior::_value_type behavio
 }
 
 // replan route, return true if successful
+//
+// The replacement route is computed on a background thread from a
+// snapshot of the graph, so this returns immediately and the FSM
+// keeps issuing orders from the current route until check_planner()
+// swaps the new one in.  Only the initial plan, when there is no
+// route to follow yet, is computed synchronously.
 bool Commander::replan_route()
 {
-  replan_num++;
-
   // get current way-point node
   WayPointNode *current;
-  
+
   current= graph->get_node_by_id(navstate->last_waypt);
   if (current == NULL)
     {
@@ -227,79 +338,270 @@ bool Commander::replan_route()
                       << " is not in the RNDF graph");
       return false;
     }
-  
+
   // We've already checked for this in FSM::current_event(), if
   // still true its the end of the run.
   if (current->index==goal.index)
     return true;
 
-  // call A* from current to goal
-  WayPointEdgeList edges =
-    GraphSearch::astar_search(*graph, current->index, goal.index, speedlimit);
-    
-  // Edges will be empty if we are planning inside a zone
-  if (edges.empty()) // no route?
+  boost::mutex::scoped_lock lock(planner_mutex_);
+
+  if (route->size() > 0)
+    {
+      // have a route to follow in the mean time, search in background
+      if (!planner_busy_)
+	submit_replan(current->index);
+      return true;
+    }
+
+  if (planner_busy_)
+    // a background search is already running; wait for its result
+    // rather than racing it on the shared planner state
+    return true;
+
+  // initial plan: nothing to follow yet, so search synchronously
+  replan_num++;
+
+  Path new_route;
+
+  while (!search_route(*graph, current->index,
+		       goal.index, goal2.index, new_route))
     {
-      if (!blockages->empty())
+      if (blockages->empty())
 	{
-	  ROS_ERROR("No path found. Removing blockage and trying again");
-	  blockages->pop_oldest();
-	  replan_num--;
-	  return replan_route();
-	}
-      else 
-	{ 
 	  ROS_ERROR("No path found to next checkpoint");
 	  ROS_ERROR_STREAM(" Attempted to find a path between "
                            << current->id.name().str << " and "
                            << goal.id.name().str);
 	  return false;
 	}
+      ROS_ERROR("No path found. Removing blockage and trying again");
+      blockages->pop_oldest();
+      ++planner_seq_;			// graph changed
+      chkpt_cache_valid_ = false;
     }
-  
+
+  *route=new_route;
+
+
+  // optionally print the entire route path
+  if (verbose)
+    route->print(*graph);
+
+  return true;
+}
+
+// apply or discard a finished background plan
+//
+// Called once per cycle.  The worker's route is swapped in atomically
+// only while still fresh: the graph must not have changed since the
+// search was submitted, the goals must still match, and the route
+// must pass through the current way-point.  A stale result is
+// discarded and a new search submitted from the current state, which
+// bounds how long Navigator runs on an outdated plan to one more
+// search.
+void Commander::check_planner(void)
+{
+  boost::mutex::scoped_lock lock(planner_mutex_);
+
+  if (!result_ready_)
+    return;				// nothing to do
+
+  result_ready_ = false;
+
+  WayPointNode *current = graph->get_node_by_id(navstate->last_waypt);
+  if (current == NULL || current->index == goal.index)
+    return;				// no longer need a route
+
+  if (!result_found_)			// search failed?
+    {
+      if (request_.sequence == planner_seq_)
+	{
+	  if (blockages->empty())
+	    {
+	      ROS_ERROR("No path found to next checkpoint");
+	      ROS_ERROR_STREAM(" Attempted to find a path between "
+                               << current->id.name().str << " and "
+                               << goal.id.name().str);
+	      return;			// keep following current route
+	    }
+	  ROS_ERROR("No path found. Removing blockage and trying again");
+	  blockages->pop_oldest();
+	  ++planner_seq_;		// graph changed
+	  chkpt_cache_valid_ = false;
+	}
+      submit_replan(current->index);
+      return;
+    }
+
+  if (request_.sequence == planner_seq_
+      && request_.goal_index == goal.index
+      && request_.goal2_index == goal2.index)
+    {
+      // trim way-points already passed while the search ran
+      Path new_route = result_route_;
+      while (new_route.size() > 1
+	     && new_route.at(0).startnode_index != current->index)
+	new_route.pop_front();
+
+      if (new_route.at(0).startnode_index == current->index)
+	{
+	  replan_num++;
+	  *route = new_route;
+
+	  // optionally print the entire route path
+	  if (verbose)
+	    route->print(*graph);
+	  return;
+	}
+      ROS_WARN("vehicle left planned route during search, replanning");
+    }
+
+  // graph, goals or position changed while searching: plan again
+  submit_replan(current->index);
+}
+
+// discard any route still being computed
+//
+// Called when a blockage was added, so a search already in flight
+// cannot be trusted.
+void Commander::invalidate_pending_route(void)
+{
+  boost::mutex::scoped_lock lock(planner_mutex_);
+  ++planner_seq_;
+  chkpt_cache_valid_ = false;
+}
+
+// planner thread body
+//
+// The graph snapshot belongs to this thread, the landmark table and
+// speed limit are read-only, and the result fields are only touched
+// with planner_mutex_ held.
+void Commander::run_planner(boost::shared_ptr<const Graph> snapshot)
+{
   Path new_route;
+  bool found = search_route(*snapshot, request_.start_index,
+			    request_.goal_index, request_.goal2_index,
+			    new_route);
+  snapshot.reset();			// done with the shared graph
+
+  boost::mutex::scoped_lock lock(planner_mutex_);
+  result_route_ = new_route;
+  result_found_ = found;
+  result_ready_ = true;
+  planner_busy_ = false;
+}
 
-  new_route.new_path(current->index,goal.index,edges);
-  
-  
-  if (goal2.index != goal.index) {
-    
-    edges = GraphSearch::astar_search(*graph, goal.index, goal2.index,
-				      speedlimit);
-    
-    if (edges.empty())		// no route?
+// run A* searches for a route from start_index to the goals
+//
+// @return true if a route was found, leaving it in new_route
+bool Commander::search_route(const Graph &search_graph,
+			     waypt_index_t start_index,
+			     waypt_index_t goal_index,
+			     waypt_index_t goal2_index,
+			     Path &new_route)
+{
+  // The leg from the vehicle to the next checkpoint reuses the
+  // incremental planner's goal-rooted cost field: while the goal is
+  // unchanged, a moved start is a path extraction with no search, and
+  // a blockage repairs only the affected region.
+  WayPointEdgeList edges =
+    inc_planner_.plan(search_graph, start_index, goal_index, speedlimit);
+
+  if (edges.empty())
+    // repair produced nothing (e.g. zone between, or field stale in a
+    // way the repair could not express): try a full A* search before
+    // giving up
+    edges = GraphSearch::astar_search(search_graph, start_index, goal_index,
+				      speedlimit, &landmarks, search_ctx_);
+
+  // Edges will be empty if we are planning inside a zone
+  if (edges.empty()) // no route?
+    return false;
+
+  new_route.new_path(start_index, goal_index, edges);
+
+
+  if (goal2_index != goal_index) {
+
+    // both ends of this leg are checkpoints: take the precomputed
+    // route when the matrix is still valid (no blockages since load)
+    bool cached = false;
+    if (chkpt_cache_valid_)
       {
-	if (!blockages->empty())
+	chkpt_route_map_t::const_iterator it =
+	  chkpt_routes_.find(std::make_pair(goal_index, goal2_index));
+	if (it != chkpt_routes_.end())
 	  {
-	    ROS_ERROR("No path found. Removing blockage and trying again");
-	    blockages->pop_oldest();
-	    replan_num--;
-	    return replan_route();
-	  }
-	else 
-	  { 
-	    ROS_ERROR_STREAM("No path found to next checkpoint");
-	    ROS_ERROR_STREAM("Attempted to find a path between "
-                             << current->id.name().str << " and "
-                             << goal.id.name().str);
-	    return false;
+	    edges = it->second;
+	    cached = true;
 	  }
       }
-    
-  
-    new_route.append_path(goal.index, goal2.index, edges);
-  }
 
-  *route=new_route;
+    if (!cached)
+      edges = GraphSearch::astar_search(search_graph, goal_index, goal2_index,
+					speedlimit, &landmarks, search_ctx_);
 
+    if (edges.empty())		// no route?
+      return false;
+
+    new_route.append_path(goal_index, goal2_index, edges);
+  }
 
-  // optionally print the entire route path
-  if (verbose)
-    route->print(*graph);
-  
   return true;
 }
 
+// hand a new request to the planner thread
+//
+// entry: planner_mutex_ held, planner_busy_ false
+void Commander::submit_replan(waypt_index_t start_index)
+{
+  request_.sequence = planner_seq_;
+  request_.start_index = start_index;
+  request_.goal_index = goal.index;
+  request_.goal2_index = goal2.index;
+  planner_busy_ = true;
+  result_ready_ = false;
+
+  // The worker searches an immutable snapshot of the graph, so
+  // blockage updates here never race with the search.  Deep copy the
+  // multi-thousand-node graph only when it has actually changed since
+  // the last snapshot; ordinary replans (goal advanced, no blockage)
+  // reuse the shared copy already in hand.
+  if (snapshot_seq_ != planner_seq_)
+    {
+      // copying a graph drops its lookup indexes: rebuild them so the
+      // worker's searches walk the CSR adjacency instead of scanning
+      // every edge per expansion
+      Graph *copy = new Graph(*graph);
+      copy->build_index();
+      snapshot_ = boost::shared_ptr<const Graph>(copy);
+      snapshot_seq_ = planner_seq_;
+    }
+
+  if (planner_thread_ != NULL)
+    {
+      planner_thread_->join();		// already finished, reclaim it
+      delete planner_thread_;
+    }
+  planner_thread_ =
+    new boost::thread(boost::bind(&Commander::run_planner, this, snapshot_));
+}
+
+// snapshot mission and blockage state for fast restart
+//
+// Written whenever either changes (checkpoint reached, blockage
+// added) and again at shutdown.  A commander restarted with this file
+// as its mission_state parameter resumes from the same checkpoint
+// with the same edges blocked, instead of re-running the mission from
+// the top of the MDF.
+void Commander::save_state(void)
+{
+  blockages->export_edges(mission->snap_blocked_edges,
+			  mission->snap_added_edges);
+  mission->save_binary("mission_state");
+}
+
 // set immediate checkpoint goals from mission
 //
 // exit:
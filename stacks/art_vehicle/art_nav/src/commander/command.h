@@ -13,8 +13,13 @@
 
 #include <ros/ros.h>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <art_map/zones.h>
 
+#include <art_nav/GraphSearch.h>
 #include <art_nav/NavBehavior.h>
 #include <art_nav/Mission.h>
 #include <art_msgs/NavigatorCommand.h>
@@ -45,6 +50,15 @@ class Commander
   Graph* graph;
   Mission* mission;
 
+  // landmark-distance table, built once at startup so replanning
+  // after a blockage expands far fewer graph nodes
+  GraphSearch::LandmarkHeuristic landmarks;
+
+  // preallocated A* working arrays, reused by every search so
+  // replanning does not allocate (calls never overlap, see
+  // inc_planner_)
+  GraphSearch::SearchContext search_ctx_;
+
   Blockages* blockages;
 
   ElementID current_way;
@@ -61,8 +75,86 @@ class Commander
   float speedlimit;
   int replan_num;
 
+  // commander cycle confidence: decaying worst gap observed between
+  // successive command() cycles (seconds).  Long gaps grow the
+  // order's way-point look-ahead window in prepare_order(), so a
+  // brief commander stall cannot starve the navigator of way-points
+  // at speed.
+  double cycle_gap_worst_;
+  ros::WallTime last_cycle_;
+
+  // Background route planner.  A worker thread runs the A* searches
+  // on a private snapshot of the graph, so the FSM keeps issuing
+  // orders from the current route while a replacement is computed.
+  // All of these fields are guarded by planner_mutex_, except that
+  // the worker reads request_ without it (the main thread never
+  // writes request_ while planner_busy_).
+  typedef struct
+  {
+    int sequence;			//< planner_seq_ when submitted
+    waypt_index_t start_index;		//< way-point planned from
+    waypt_index_t goal_index;		//< goal at submission
+    waypt_index_t goal2_index;		//< goal2 at submission
+  } plan_request_t;
+
+  boost::thread *planner_thread_;
+  boost::mutex planner_mutex_;
+  bool planner_busy_;			//< worker still searching
+  bool result_ready_;			//< result fields below valid
+  bool result_found_;			//< worker found a route
+  Path result_route_;			//< route the worker computed
+  plan_request_t request_;		//< request the worker is serving
+  int planner_seq_;			//< bumped when the graph changes
+
+  // Shared immutable snapshot handed to the worker thread.  Deep
+  // copied from the master graph only when the graph has changed
+  // since the last snapshot; successive replans on an unchanged graph
+  // (the usual case, a blockage is rare) share one copy.  The handle
+  // keeps the snapshot alive until the worker drops its reference.
+  boost::shared_ptr<const Graph> snapshot_;
+  int snapshot_seq_;			//< planner_seq_ when copied
+
+  // All-checkpoint-pairs route matrix, built once at MDF load.  The
+  // checkpoint-to-checkpoint legs of every replan come from here by
+  // lookup instead of a second A* search.  Any blockage invalidates
+  // the matrix, since cached edges may cross the blocked segment; a
+  // stale read by the worker is harmless because check_planner()
+  // already discards results whose sequence does not match.
+  typedef std::map<std::pair<waypt_index_t, waypt_index_t>,
+		   WayPointEdgeList> chkpt_route_map_t;
+  chkpt_route_map_t chkpt_routes_;
+  volatile bool chkpt_cache_valid_;
+
+  // Incremental planner for the leg from the vehicle to the next
+  // checkpoint.  Keeps the goal-rooted cost field between replans, so
+  // advancing along the route extracts a path without searching and a
+  // blockage repairs only the affected region.  Calls never overlap:
+  // search_route() runs either synchronously (worker idle) or on the
+  // single worker thread.
+  GraphSearch::IncrementalPlanner inc_planner_;
+
   // private methods:
 
+  // build the all-checkpoint-pairs route matrix
+  void build_checkpoint_matrix(void);
+
+  // apply or discard a finished background plan (called every cycle)
+  void check_planner(void);
+
+  // discard any route still being computed (the graph changed)
+  void invalidate_pending_route(void);
+
+  // planner thread body
+  void run_planner(boost::shared_ptr<const Graph> snapshot);
+
+  // run A* searches for a route from start_index to the goals
+  bool search_route(const Graph &search_graph, waypt_index_t start_index,
+		    waypt_index_t goal_index, waypt_index_t goal2_index,
+		    Path &new_route);
+
+  // hand a new request to the planner thread (planner_mutex_ held)
+  void submit_replan(waypt_index_t start_index);
+
   // return most urgent current event
   CmdrEvent current_event(void);
 
@@ -75,6 +167,9 @@ class Commander
   // replan route, return true if successful
   bool replan_route();
 
+  // snapshot mission and blockage state for fast restart
+  void save_state(void);
+
   // set immediate checkpoint goals from mission
   void set_checkpoint_goals(void);
 };
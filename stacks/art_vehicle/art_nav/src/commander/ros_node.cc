@@ -12,6 +12,7 @@
 #include <iostream>
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 
 #include <art_msgs/ArtHertz.h>
 #include <art_map/ZoneOps.h>
@@ -72,6 +73,9 @@
 */
 
 
+/** seconds between heartbeat repeats of an unchanged order */
+static const double HEARTBEAT_PERIOD = 1.0;
+
 /** @brief Commander node class */
 class CommanderNode
 {
@@ -79,6 +83,9 @@ public:
   CommanderNode()
   {
     verbose_ = 1;
+    have_last_order_ = false;
+    order_seq_ = 0;
+    nav_state_changed_ = false;
 
     // use private node handle to get parameters
     ros::NodeHandle nh("~");
@@ -120,6 +127,15 @@ public:
 
     nh.param("start_run", startrun_, false);
 
+    // Event-driven cycle: wake on navigator state arrival instead of
+    // polling on a fixed timer, with the nominal period as watchdog.
+    // Cuts worst-case decision latency after a navigator transition
+    // from a full period to the message transport delay, and idles
+    // the process between events.
+    nh.param("event_driven", event_driven_, true);
+    if (event_driven_)
+      ROS_INFO("event-driven commander cycle");
+
     // class objects
     rndf_ = new RNDF(rndf_name_);
     mdf_ = new MDF(mdf_name_);
@@ -155,6 +171,19 @@ public:
   void processNavState(const art_msgs::NavigatorState::ConstPtr &nst)
   {
     ROS_DEBUG("navigator state message received");
+
+    // note decision-relevant differences, so the event-driven cycle
+    // only runs the commander when something actually changed
+    if (nst->estop.state != navState_.estop.state
+        || nst->road.state != navState_.road.state
+        || ElementID(nst->last_waypt) != ElementID(navState_.last_waypt)
+        || ElementID(nst->replan_waypt) != ElementID(navState_.replan_waypt)
+        || nst->lane_blocked != navState_.lane_blocked
+        || nst->road_blocked != navState_.road_blocked
+        || nst->stopped != navState_.stopped
+        || nst->have_zones != navState_.have_zones)
+      nav_state_changed_ = true;
+
     navState_ = *nst;
   }
 
@@ -252,16 +281,68 @@ public:
   }
 
   
-  /** Send order in command to navigator driver */
+  /** Compare two orders, field by field.
+   *
+   *  Ignores the sequence number and any data derived from the
+   *  way-point IDs, so repeating the same plan compares equal.
+   */
+  bool sameOrder(const art_msgs::Order &o1, const art_msgs::Order &o2)
+  {
+    if (o1.behavior.value != o2.behavior.value
+        || o1.min_speed != o2.min_speed
+        || o1.max_speed != o2.max_speed
+        || o1.replan_num != o2.replan_num
+        || o1.next_uturn != o2.next_uturn)
+      return false;
+
+    for (unsigned i = 0; i < art_msgs::Order::N_WAYPTS; ++i)
+      if (ElementID(o1.waypt[i].id) != ElementID(o2.waypt[i].id)
+          || o1.waypt[i].is_entry != o2.waypt[i].is_entry
+          || o1.waypt[i].is_exit != o2.waypt[i].is_exit
+          || o1.waypt[i].is_goal != o2.waypt[i].is_goal
+          || o1.waypt[i].is_lane_change != o2.waypt[i].is_lane_change
+          || o1.waypt[i].is_spot != o2.waypt[i].is_spot
+          || o1.waypt[i].is_stop != o2.waypt[i].is_stop
+          || o1.waypt[i].is_perimeter != o2.waypt[i].is_perimeter)
+        return false;
+
+    for (unsigned i = 0; i < art_msgs::Order::N_CHKPTS; ++i)
+      if (ElementID(o1.chkpt[i].id) != ElementID(o2.chkpt[i].id))
+        return false;
+
+    return true;
+  }
+
+  /** Send order in command to navigator driver
+   *
+   *  Publishes only when the order changed, plus a low-rate heartbeat
+   *  repeat of the current order so the navigator and anyone
+   *  monitoring the topic can tell commander is still alive.  The
+   *  sequence number advances only for changed orders, letting the
+   *  navigator skip reprocessing heartbeat repeats.
+   */
   void putOrder(const art_msgs::Order &order)
   {
+    ros::Time now = ros::Time::now();
+    bool changed = (!have_last_order_ || !sameOrder(order, last_order_));
+    if (!changed
+        && now - last_order_time_ < ros::Duration(HEARTBEAT_PERIOD))
+      return;                           // unchanged, heartbeat not due
+
     art_msgs::NavigatorCommand cmd;
-    cmd.header.stamp = ros::Time::now();
+    cmd.header.stamp = now;
     cmd.header.frame_id = frame_id_;
     cmd.order = order;
+    if (changed)
+      ++order_seq_;                     // orders are numbered from one
+    cmd.order.seq = order_seq_;
     ROS_DEBUG_STREAM("sending behavior "
                      << NavBehavior(cmd.order.behavior).Name());
     nav_cmd_pub_.publish(cmd);
+
+    last_order_ = order;
+    have_last_order_ = true;
+    last_order_time_ = now;
   }
 
   /** Main spin loop */
@@ -281,9 +362,28 @@ public:
     // loop until end of mission
     ROS_INFO("begin mission");
     ros::Rate cycle(art_msgs::ArtHertz::COMMANDER);
+    double period = 1.0 / art_msgs::ArtHertz::COMMANDER;
+    ros::Time last_decision = ros::Time::now();
     while(ros::ok())
       {
-        ros::spinOnce();                  // handle incoming messages
+        if (event_driven_)
+          {
+            // Sleep until navigator input arrives or the watchdog
+            // period expires, then decide immediately when the state
+            // changed; otherwise only the watchdog runs a cycle.
+            ros::getGlobalCallbackQueue()
+              ->callAvailable(ros::WallDuration(period));
+            ros::Time now = ros::Time::now();
+            if (!nav_state_changed_
+                && (now - last_decision).toSec() < period)
+              continue;                 // nothing new, watchdog not due
+            nav_state_changed_ = false;
+            last_decision = now;
+          }
+        else
+          {
+            ros::spinOnce();            // handle incoming messages
+          }
 
         ROS_DEBUG_STREAM("navstate = "
                          << NavEstopState(navState_.estop).Name()
@@ -311,7 +411,8 @@ public:
 	if (next_order.behavior.value != NavBehavior::None)
 	  putOrder(next_order);
 
-        cycle.sleep();                  // sleep until next cycle
+        if (!event_driven_)
+          cycle.sleep();                // sleep until next cycle
 
       }	//end of mission while loop
 
@@ -356,7 +457,8 @@ private:
   // parameters
   std::string mission_file_;
   bool load_mission_;
-  bool startrun_; 
+  bool startrun_;
+  bool event_driven_;           ///< wake on navigator state arrival
   double speed_limit_;
   std::string rndf_name_;
   std::string mdf_name_;
@@ -367,6 +469,14 @@ private:
   ros::Subscriber nav_state_topic_;       // navigator state topic
   ros::Publisher nav_cmd_pub_;            // navigator command topic
   art_msgs::NavigatorState navState_;     // last received
+  bool nav_state_changed_;                // decision-relevant change seen
+
+  // delta publication state: orders are republished when they
+  // change, plus a heartbeat repeat at HEARTBEAT_PERIOD
+  art_msgs::Order last_order_;            // last order sent
+  bool have_last_order_;                  // last_order_ valid
+  uint32_t order_seq_;                    // last sequence number sent
+  ros::Time last_order_time_;             // when last order was sent
 
   RNDF *rndf_;
   MDF *mdf_;
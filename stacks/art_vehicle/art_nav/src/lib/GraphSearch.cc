@@ -9,6 +9,8 @@
 #include <art_nav/GraphSearch.h>
 #include <art_map/euclidean_distance.h>
 #include <float.h>
+#include <algorithm>
+#include <functional>
 
 namespace GraphSearch {
   WayPointNodeList edge_list_to_node_list(const Graph& graph,
@@ -204,22 +206,329 @@ namespace GraphSearch {
     }
   }
   
+  // run Dijkstra over an adjacency list of (neighbor, cost) pairs,
+  // filling dist with the cost from source to every node position
+  static void dijkstra(const std::vector<std::vector<
+			 std::pair<int,double> > >& adj,
+		       int source, std::vector<double>& dist)
+  {
+    typedef std::pair<double,int> QueueEntry;
+    dist.assign(adj.size(), DBL_MAX);
+    dist[source] = 0.0;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+      std::greater<QueueEntry> > q;
+    q.push(QueueEntry(0.0, source));
+    while(!q.empty()) {
+      QueueEntry top = q.top();
+      q.pop();
+      if(top.first > dist[top.second])
+	continue;
+      const std::vector<std::pair<int,double> >& out = adj[top.second];
+      for(uint i = 0; i < out.size(); i++) {
+	double next = top.first + out[i].second;
+	if(next < dist[out[i].first]) {
+	  dist[out[i].first] = next;
+	  q.push(QueueEntry(next, out[i].first));
+	}
+      }
+    }
+  }
+
+  void LandmarkHeuristic::build(const Graph& graph, int num_landmarks) {
+    built_ = false;
+    uint n = graph.nodes_size;
+    if(n == 0)
+      return;
+
+    // adjacency over node array positions, in both edge directions,
+    // costed exactly like the search but with no speed limit so the
+    // resulting times lower-bound any limited query
+    std::vector<std::vector<std::pair<int,double> > > fwd(n), rev(n);
+    for(uint i = 0; i < graph.edges_size; i++) {
+      WayPointNode* s = graph.get_node_by_index(graph.edges[i].startnode_index);
+      WayPointNode* t = graph.get_node_by_index(graph.edges[i].endnode_index);
+      if(s == NULL || t == NULL)
+	continue;
+      int sp = s - graph.nodes;
+      int tp = t - graph.nodes;
+      double c = cost(graph, graph.edges[i], Infinite::distance);
+      fwd[sp].push_back(std::pair<int,double>(tp, c));
+      rev[tp].push_back(std::pair<int,double>(sp, c));
+    }
+
+    // farthest-point selection spreads the landmarks over the map
+    landmarks_.clear();
+    landmarks_.push_back(0);
+    while((int)landmarks_.size() < num_landmarks
+	  && landmarks_.size() < n) {
+      int far = -1;
+      float far_dist = 0.0;
+      for(uint v = 0; v < n; v++) {
+	float d = FLT_MAX;
+	for(uint l = 0; l < landmarks_.size(); l++)
+	  d = fminf(d, Euclidean::DistanceTo(graph.nodes[v].map,
+					     graph.nodes[landmarks_[l]].map));
+	if(d > far_dist) {
+	  far_dist = d;
+	  far = v;
+	}
+      }
+      if(far < 0)
+	break;
+      landmarks_.push_back(far);
+    }
+
+    from_landmark_.resize(landmarks_.size());
+    to_landmark_.resize(landmarks_.size());
+    for(uint l = 0; l < landmarks_.size(); l++) {
+      dijkstra(fwd, landmarks_[l], from_landmark_[l]);
+      dijkstra(rev, landmarks_[l], to_landmark_[l]);
+    }
+    built_ = true;
+  }
+
+  double LandmarkHeuristic::lowerBound(const Graph& graph,
+				       waypt_index_t from,
+				       waypt_index_t to) const {
+    if(!built_)
+      return 0.0;
+    WayPointNode* f = graph.get_node_by_index(from);
+    WayPointNode* t = graph.get_node_by_index(to);
+    if(f == NULL || t == NULL)
+      return 0.0;
+    int fp = f - graph.nodes;
+    int tp = t - graph.nodes;
+    double bound = 0.0;
+    for(uint l = 0; l < landmarks_.size(); l++) {
+      // d(f,t) >= d(L,t) - d(L,f) and d(f,t) >= d(f,L) - d(t,L)
+      if(from_landmark_[l][tp] < DBL_MAX && from_landmark_[l][fp] < DBL_MAX)
+	bound = std::max(bound, from_landmark_[l][tp] - from_landmark_[l][fp]);
+      if(to_landmark_[l][fp] < DBL_MAX && to_landmark_[l][tp] < DBL_MAX)
+	bound = std::max(bound, to_landmark_[l][fp] - to_landmark_[l][tp]);
+    }
+    return bound;
+  }
+
+  // combined heuristic: straight-line time, tightened by the
+  // landmark bounds when a table was built
+  static double estimate(const Graph& graph,
+			 waypt_index_t from_id,
+			 waypt_index_t goal_id,
+			 float speedlimit,
+			 const LandmarkHeuristic* landmarks) {
+    double h = heuristic(graph, from_id, goal_id, speedlimit);
+    if(landmarks != NULL && landmarks->built())
+      h = std::max(h, landmarks->lowerBound(graph, from_id, goal_id));
+    return h;
+  }
+
+  // rebuild the successor and predecessor lists from the given graph
+  //
+  // Runs in one linear pass over the edges, so each plan() can
+  // re-derive current costs without being told which edges changed
+  // (blockages both flag edges blocked and add or delete u-turn
+  // edges).
+  void IncrementalPlanner::rebuild_adjacency(const Graph& graph)
+  {
+    uint n = graph.nodes_size;
+    out_.assign(n, std::vector<out_edge_t>());
+    pred_.assign(n, std::vector<int>());
+    for(uint i = 0; i < graph.edges_size; i++) {
+      const WayPointEdge& e = graph.edges[i];
+      if(e.blocked)
+	continue;
+      WayPointNode* s = graph.get_node_by_index(e.startnode_index);
+      WayPointNode* t = graph.get_node_by_index(e.endnode_index);
+      if(s == NULL || t == NULL)
+	continue;
+      out_edge_t oe;
+      oe.to = t - graph.nodes;
+      oe.cost = cost(graph, e, speedlimit_);
+      oe.edge = e;
+      out_[s - graph.nodes].push_back(oe);
+      pred_[oe.to].push_back(s - graph.nodes);
+    }
+  }
+
+  // restore node u's one-step lookahead cost, queueing it if the
+  // stored cost no longer agrees
+  void IncrementalPlanner::update_vertex(int u)
+  {
+    if(u != goal_pos_) {
+      double r = DBL_MAX;
+      const std::vector<out_edge_t>& out = out_[u];
+      for(uint i = 0; i < out.size(); i++)
+	if(g_[out[i].to] < DBL_MAX)
+	  r = std::min(r, out[i].cost + g_[out[i].to]);
+      rhs_[u] = r;
+    }
+    if(g_[u] != rhs_[u])
+      open_.push(std::pair<double,int>(std::min(g_[u], rhs_[u]), u));
+  }
+
+  // propagate queued inconsistencies until the cost field settles
+  //
+  // With no heuristic the keys are plain costs to goal, so this is an
+  // incremental Dijkstra rooted at the goal: after a local edge
+  // change only the affected region is expanded.
+  void IncrementalPlanner::compute(void)
+  {
+    while(!open_.empty()) {
+      double k = open_.top().first;
+      int u = open_.top().second;
+      open_.pop();
+      double ku = std::min(g_[u], rhs_[u]);
+      if(k > ku) {			// stale queue entry
+	open_.push(std::pair<double,int>(ku, u));
+	continue;
+      }
+      if(k < ku)			// already settled
+	continue;
+      if(g_[u] > rhs_[u]) {
+	g_[u] = rhs_[u];
+	for(uint i = 0; i < pred_[u].size(); i++)
+	  update_vertex(pred_[u][i]);
+      }
+      else if(g_[u] < rhs_[u]) {
+	g_[u] = DBL_MAX;
+	update_vertex(u);
+	for(uint i = 0; i < pred_[u].size(); i++)
+	  update_vertex(pred_[u][i]);
+      }
+    }
+  }
+
+  WayPointEdgeList IncrementalPlanner::plan(const Graph& graph,
+					    waypt_index_t start_id,
+					    waypt_index_t goal_id,
+					    float speedlimit)
+  {
+    WayPointEdgeList empty_list;
+    WayPointNode* start_node = graph.get_node_by_index(start_id);
+    WayPointNode* goal_node = graph.get_node_by_index(goal_id);
+    if(start_node == NULL || goal_node == NULL) {
+      std::cerr<<"ERROR: Start or goal index doesn't exist in graph!!\n";
+      return empty_list;
+    }
+    if(start_id == goal_id)
+      return empty_list;
+
+    uint n = graph.nodes_size;
+    if(!valid_ || goal_id != goal_id_ || speedlimit != speedlimit_
+       || g_.size() != n) {
+      // new goal (or graph shape): root a fresh field at the goal
+      goal_id_ = goal_id;
+      speedlimit_ = speedlimit;
+      goal_pos_ = goal_node - graph.nodes;
+      rebuild_adjacency(graph);
+      g_.assign(n, DBL_MAX);
+      rhs_.assign(n, DBL_MAX);
+      while(!open_.empty())
+	open_.pop();
+      rhs_[goal_pos_] = 0.0;
+      open_.push(std::pair<double,int>(0.0, goal_pos_));
+      valid_ = true;
+    }
+    else {
+      // same goal: re-cost the graph and queue whatever changed
+      rebuild_adjacency(graph);
+      for(uint u = 0; u < n; u++)
+	if((int) u != goal_pos_)
+	  update_vertex(u);
+    }
+    compute();
+
+    // extract the route by greedy descent of the cost field
+    int at = start_node - graph.nodes;
+    int prev = -1;
+    WayPointEdgeList path;
+    for(uint steps = 0; steps < n; steps++) {
+      if(at == goal_pos_)
+	return path;
+      const std::vector<out_edge_t>& out = out_[at];
+      int best = -1;
+      double best_cost = DBL_MAX;
+      for(uint i = 0; i < out.size(); i++) {
+	if(g_[out[i].to] >= DBL_MAX)
+	  continue;
+	// Don't go into a zone and right back out just to turn around.
+	WayPointNode* prev_node =
+	  (prev >= 0? &graph.nodes[prev]: NULL);
+	WayPointNode* from_node = &graph.nodes[at];
+	WayPointNode* next_node = &graph.nodes[out[i].to];
+	if (prev_node != NULL &&
+	    prev_node->id.lane != 0 &&
+	    from_node->id.lane == 0 &&
+	    next_node->id.lane != 0)
+	  if (!prev_node->is_spot &&
+	      !next_node->is_spot)
+	    continue;
+	double c = out[i].cost + g_[out[i].to];
+	if(c < best_cost) {
+	  best_cost = c;
+	  best = i;
+	}
+      }
+      if(best < 0)			// goal unreachable from here
+	return empty_list;
+      path.push_back(out_[at][best].edge);
+      prev = at;
+      at = out_[at][best].to;
+    }
+    return empty_list;			// cycle: should not happen
+  }
+
+  void SearchContext::prepare(unsigned nodes_size)
+  {
+    if(stamp_.size() != nodes_size) {
+      // first use, or graph size changed: (re)allocate everything
+      stamp_.assign(nodes_size, 0);
+      closed_.assign(nodes_size, false);
+      best_cost_.assign(nodes_size, DBL_MAX);
+      parent_.resize(nodes_size);
+      generation_ = 0;
+    }
+    if(++generation_ == 0) {
+      // stamp counter wrapped: invalidate every slot the slow way,
+      // once per 2^32 searches
+      std::fill(stamp_.begin(), stamp_.end(), (uint32_t) 0);
+      generation_ = 1;
+    }
+    open_.clear();			// capacity is retained
+  }
+
+  const std::vector<double>& SearchContext::edgeCosts(const Graph& graph,
+						      float speedlimit)
+  {
+    if(edge_cost_.size() != graph.edges_size
+       || cost_speedlimit_ != speedlimit) {
+      edge_cost_.resize(graph.edges_size);
+      for(uint i = 0; i < graph.edges_size; i++)
+	edge_cost_[i] = cost(graph, graph.edges[i], speedlimit);
+      cost_speedlimit_ = speedlimit;
+    }
+    return edge_cost_;
+  }
+
   WayPointEdgeList astar_search(const Graph& graph,
 				waypt_index_t start_id,
 				waypt_index_t goal_id,
-				float speedlimit) {
-
-    std::map<waypt_index_t,bool> closed;
-    closed[start_id] = true;
-    PathPriorityQueue* q = new PathPriorityQueue(PossiblePathComparision());
-    PossiblePath empty;
-    empty.first.first = empty.first.second = 0;
+				float speedlimit,
+				const LandmarkHeuristic* landmarks,
+				SearchContext& context) {
+
+    // Each queue entry holds only the estimated total cost, the cost
+    // so far, the frontier node and its predecessor; the path itself
+    // is rebuilt from the parent edges at the end.  All per-node
+    // bookkeeping lives in the context arrays, indexed by node array
+    // position, so a context reused across replans allocates nothing
+    // after its first search.
+    typedef SearchContext::SearchEntry SearchEntry;
+    std::greater<SearchEntry> entry_order;
     WayPointEdgeList empty_list;
 
-    if (start_id==goal_id) {
-      delete q;
+    if (start_id==goal_id)
       return empty_list;
-    }
 
     // If checkpoint is parking spot, match on segment to get path
     // into zone
@@ -227,39 +536,122 @@ namespace GraphSearch {
 
     if(goal_node == NULL) {
       std::cerr<<"ERROR: Goal index ("<<goal_id<<") doesn't exist in graph!!\n";
-      delete q;
-      return empty_list;      
+      return empty_list;
     }
 
+    WayPointNode *start_node = graph.get_node_by_index(start_id);
+    if(start_node == NULL) {
+      std::cerr<<"ERROR: Start index ("<<start_id
+	       <<") doesn't exist in graph!!\n";
+      return empty_list;
+    }
+
+    // bake per-edge traversal times once, so each relaxation reads
+    // one float instead of recomputing the cost from the edge
+    const std::vector<double>& edge_cost =
+      context.edgeCosts(graph, speedlimit);
+
+    context.prepare(graph.nodes_size);
+
     // Seed the search....
-    empty.second = empty_list;
-    add_to_queue(graph, q, start_id, empty, goal_id, speedlimit, -1);
-    
-    // Main searching loop
-    while(!q->empty()) {
-      PossiblePath path = q->top();
-      q->pop();
-      WayPointEdge final_edge = path.second.back();
-      if(closed[final_edge.endnode_index])
-	continue;
+    context.setBest(start_node - graph.nodes, 0.0, WayPointEdge());
+    context.open_.push_back(SearchEntry(std::pair<double,double>
+					(estimate(graph, start_id, goal_id,
+						  speedlimit, landmarks), 0.0),
+					std::pair<waypt_index_t,waypt_index_t>
+					(start_id, -1)));
 
-      WayPointNode *final_node = graph.get_node_by_index(final_edge.endnode_index);
-      if(final_node == NULL) {
-	std::cerr<<"ERROR: Final index ("<<final_edge.endnode_index
+    // Main searching loop
+    while(!context.open_.empty()) {
+      SearchEntry entry = context.open_.front();
+      std::pop_heap(context.open_.begin(), context.open_.end(), entry_order);
+      context.open_.pop_back();
+      double cost_so_far = entry.first.second;
+      waypt_index_t from_index = entry.second.first;
+      waypt_index_t prev_index = entry.second.second;
+
+      WayPointNode *from_node = graph.get_node_by_index(from_index);
+      WayPointNode *prev_node = graph.get_node_by_index(prev_index);
+      if(from_node == NULL) {
+	std::cerr<<"ERROR: From index ("<<from_index
 		 <<") doesn't exist in graph!!\n";
-	delete q;
-	return empty_list;      
+	return empty_list;
       }
 
-      if(final_edge.endnode_index == goal_id) {
-	delete q;
-	return path.second;
+      int from_pos = from_node - graph.nodes;
+      if(context.closed(from_pos))
+	continue;
+      context.close(from_pos);
+
+      if(from_index == goal_id) {
+	// walk the parent edges back to the start
+	WayPointEdgeList path;
+	WayPointNode *at = goal_node;
+	while(at != NULL && at->index != start_id) {
+	  const WayPointEdge &e = context.parentEdge(at - graph.nodes);
+	  path.push_back(e);
+	  at = graph.get_node_by_index(e.startnode_index);
+	}
+	std::reverse(path.begin(), path.end());
+	return path;
+      }
+
+      graph.edge_positions_from(from_index, context.out_edges_);
+      for(uint n = 0; n < context.out_edges_.size(); n++) {
+	int epos = context.out_edges_[n];
+	const WayPointEdge *i = &graph.edges[epos];
+	WayPointNode *next_node = graph.get_node_by_index(i->endnode_index);
+
+	if(next_node == NULL) {
+	  std::cerr<<"ERROR: Next index ("<<i->endnode_index
+		   <<") doesn't exist in graph!!\n";
+	  continue;
+	}
+
+	// Don't go into a zone and right back out just to turn around.
+	if (prev_node!=NULL &&
+	    prev_node->id.lane != 0 &&
+	    from_node->id.lane == 0 &&
+	    next_node->id.lane != 0)
+	  if (!prev_node->is_spot &&
+	      !next_node->is_spot)
+	    continue;
+	if (i->blocked)
+	  continue;
+
+	int next_pos = next_node - graph.nodes;
+	if (context.closed(next_pos))
+	  continue;
+
+	double new_cost = cost_so_far + edge_cost[epos];
+	if (context.bestCost(next_pos) <= new_cost)
+	  continue;
+	context.setBest(next_pos, new_cost, *i);
+	context.open_.push_back(SearchEntry(std::pair<double,double>
+					    (new_cost
+					     + estimate(graph,
+							i->endnode_index,
+							goal_id, speedlimit,
+							landmarks),
+					     new_cost),
+					    std::pair<waypt_index_t,
+					    waypt_index_t>
+					    (i->endnode_index, from_index)));
+	std::push_heap(context.open_.begin(), context.open_.end(),
+		       entry_order);
       }
-      closed[final_edge.endnode_index] = true;
-      add_to_queue(graph, q, final_edge.endnode_index, path, goal_id, speedlimit, final_edge.startnode_index);
     }
-    delete q;
     return empty_list;
   }
 
+  WayPointEdgeList astar_search(const Graph& graph,
+				waypt_index_t start_id,
+				waypt_index_t goal_id,
+				float speedlimit,
+				const LandmarkHeuristic* landmarks) {
+    SearchContext context;
+    return astar_search(graph, start_id, goal_id, speedlimit,
+			landmarks, context);
+  }
+
 };
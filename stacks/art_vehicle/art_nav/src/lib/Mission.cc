@@ -27,6 +27,8 @@ Mission::Mission(const MDF& mdf){
 Mission::Mission(const Mission& that){
   checkpoint_ids = std::deque<int>(that.checkpoint_ids);
   checkpoint_elementid = std::deque<ElementID>(that.checkpoint_elementid);
+  snap_blocked_edges = that.snap_blocked_edges;
+  snap_added_edges = that.snap_added_edges;
 };
 
 bool Mission::compare(const Mission &that){
@@ -113,8 +115,147 @@ void Mission::save(const char* fName){
   fclose (f);
 }
 
+// binary mission snapshot format: fixed header, checkpoint records,
+// then the blocked and added edge records, all fixed size
+namespace
+{
+  const uint32_t MISSION_SNAP_MAGIC = 0x4152544du;	// "ARTM"
+  const uint32_t MISSION_SNAP_VERSION = 1;
+
+  struct MissionSnapHeader
+  {
+    uint32_t magic;			// MISSION_SNAP_MAGIC
+    uint32_t version;			// MISSION_SNAP_VERSION
+    uint32_t edge_record;		// sizeof(WayPointEdge) when written
+    uint32_t n_chkpts;			// remaining checkpoint count
+    uint32_t n_blocked;			// snap_blocked_edges count
+    uint32_t n_added;			// snap_added_edges count
+  };
+
+  struct MissionSnapChkpt
+  {
+    int32_t id;				// checkpoint ID
+    int32_t seg;			// ElementID fields
+    int32_t lane;
+    int32_t pt;
+  };
+}
+
+void Mission::save_binary(const char* fName)
+{
+  FILE* f = fopen(fName, "wb");
+  if (f == NULL) {
+    ROS_WARN("Mission::save_binary Failed - Can't open file");
+    return;
+  }
+
+  MissionSnapHeader hdr;
+  hdr.magic = MISSION_SNAP_MAGIC;
+  hdr.version = MISSION_SNAP_VERSION;
+  hdr.edge_record = sizeof(WayPointEdge);
+  hdr.n_chkpts = checkpoint_ids.size();
+  hdr.n_blocked = snap_blocked_edges.size();
+  hdr.n_added = snap_added_edges.size();
+
+  bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1);
+  for (uint i = 0; ok && i < hdr.n_chkpts; i++) {
+    MissionSnapChkpt rec;
+    rec.id = checkpoint_ids[i];
+    rec.seg = checkpoint_elementid[i].seg;
+    rec.lane = checkpoint_elementid[i].lane;
+    rec.pt = checkpoint_elementid[i].pt;
+    ok = (fwrite(&rec, sizeof(rec), 1, f) == 1);
+  }
+  if (ok && hdr.n_blocked > 0)
+    ok = (fwrite(&snap_blocked_edges[0], sizeof(WayPointEdge),
+		 hdr.n_blocked, f) == hdr.n_blocked);
+  if (ok && hdr.n_added > 0)
+    ok = (fwrite(&snap_added_edges[0], sizeof(WayPointEdge),
+		 hdr.n_added, f) == hdr.n_added);
+  fclose(f);
+
+  if (!ok)
+    ROS_WARN("Mission::save_binary Failed - Failed snapshot write");
+}
+
+bool Mission::load_binary(const char* fName, const Graph& graph)
+{
+  FILE* f = fopen(fName, "rb");
+  if (f == NULL)
+    return false;
+
+  MissionSnapHeader hdr;
+  if (fread(&hdr, sizeof(hdr), 1, f) != 1) {
+    fclose(f);
+    return false;
+  }
+
+  // reject anything not written by this version of this code
+  if (hdr.magic != MISSION_SNAP_MAGIC
+      || hdr.version != MISSION_SNAP_VERSION
+      || hdr.edge_record != sizeof(WayPointEdge)) {
+    fclose(f);
+    return false;
+  }
+
+  clear();
+  bool ok = true;
+  for (uint i = 0; ok && i < hdr.n_chkpts; i++) {
+    MissionSnapChkpt rec;
+    ok = (fread(&rec, sizeof(rec), 1, f) == 1);
+    if (ok) {
+      checkpoint_ids.push_back(rec.id);
+      checkpoint_elementid.push_back(ElementID(rec.seg, rec.lane, rec.pt));
+    }
+  }
+  if (ok && hdr.n_blocked > 0) {
+    snap_blocked_edges.resize(hdr.n_blocked);
+    ok = (fread(&snap_blocked_edges[0], sizeof(WayPointEdge),
+		hdr.n_blocked, f) == hdr.n_blocked);
+  }
+  if (ok && hdr.n_added > 0) {
+    snap_added_edges.resize(hdr.n_added);
+    ok = (fread(&snap_added_edges[0], sizeof(WayPointEdge),
+		hdr.n_added, f) == hdr.n_added);
+  }
+  fclose(f);
+
+  if (!ok) {
+    ROS_ERROR("Mission::load_binary Failed - Failed snapshot read");
+    clear();
+    return false;
+  }
+
+  // the snapshot must agree with this graph, just as the text loader
+  // checks each checkpoint's element ID
+  for (uint j = 0; j < checkpoint_ids.size(); j++) {
+    WayPointNode *node = graph.get_node_by_id(checkpoint_elementid.at(j));
+    if (node == NULL || node->checkpoint_id != checkpoint_ids.at(j)) {
+      ROS_ERROR("Mission snapshot does not match this road network");
+      clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool Mission::load(const char* fName, const Graph& graph)
 {
+  // a binary snapshot announces itself with its magic number; fall
+  // back to the old text format for files written before it existed
+  {
+    FILE* f = fopen(fName, "rb");
+    if (f != NULL) {
+      uint32_t magic = 0;
+      bool is_snap = (fread(&magic, sizeof(magic), 1, f) == 1
+		      && magic == MISSION_SNAP_MAGIC);
+      fclose(f);
+      if (is_snap)
+	return load_binary(fName, graph);
+    }
+  }
+
   int number_of_checkpoints = 0;
   std::ifstream mission_file;
   mission_file.open(fName);
@@ -122,7 +263,7 @@ bool Mission::load(const char* fName, const Graph& graph)
     ROS_ERROR("Error in opening Mission Log file");
     return false;
   }
-  
+
   int line_number = 0;
   bool valid = true;
   std::string lineread;
@@ -181,6 +322,8 @@ bool Mission::load(const char* fName, const Graph& graph)
 void Mission::clear(){
   checkpoint_ids.clear();
   checkpoint_elementid.clear();
+  snap_blocked_edges.clear();
+  snap_added_edges.clear();
 }
 
 void Mission::print(){
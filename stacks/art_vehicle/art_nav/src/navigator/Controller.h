@@ -57,6 +57,11 @@ public:
     verbose = _verbose;
     nav = navptr;
 
+    // every controller starts out active; the state machines mark
+    // subordinates dormant when their state is not selected
+    active_ = true;
+    dormant_count_ = 0;
+
     // save pointers to frequently-used Navigator data
     course = nav->course;
     estimate = &nav->estimate;
@@ -80,6 +85,38 @@ public:
     return OK;
   };
 
+  /** @brief mark this controller active or dormant
+   *
+   *  The finite state machines call this as states change, so
+   *  controllers outside the selected subtree can skip most of their
+   *  per-cycle setup work via dormant_cycle().
+   */
+  void set_active(bool active)
+  {
+    if (active_ != active)
+      {
+	active_ = active;
+	dormant_count_ = 0;		// run the next dormant cycle soon
+	if (verbose >= 4)
+	  ART_MSG(8, "controller going %s", (active? "active": "dormant"));
+      }
+  }
+
+  /** @brief return true if this controller is currently active */
+  bool is_active(void) const {return active_;}
+
+  /** @brief set or clear cycle budget pressure
+   *
+   *  The queue manager sets pressure when the control cycle exceeds
+   *  its time budget.  While set, dormant controllers skip even their
+   *  reduced-rate refresh ticks, so the whole budget goes to the
+   *  active subtree; the ticks resume once the cycle fits again.
+   */
+  static void set_cycle_pressure(bool pressure)
+  {
+    cycle_pressure_ = pressure;
+  }
+
   // reset the controller and all its subordinates to a known state
   virtual void reset(void) {};
 
@@ -122,6 +159,32 @@ protected:
 
   // reset this controller only
   virtual void reset_me(void) {};
+
+  /** @brief return true when a dormant controller should skip this cycle
+   *
+   *  Active controllers never skip.  Dormant ones still run one cycle
+   *  in every DORMANT_TICK_INTERVAL, so cached state gets refreshed
+   *  at a reduced rate while the full cycle budget goes to the
+   *  controllers that need it.
+   */
+  bool dormant_cycle(void)
+  {
+    if (active_)
+      return false;
+    if (cycle_pressure_)
+      return true;			// over budget: defer refresh ticks
+    if (++dormant_count_ >= DORMANT_TICK_INTERVAL)
+      dormant_count_ = 0;
+    return (dormant_count_ != 0);
+  }
+
+private:
+
+  // reduced-rate scheduling for dormant controllers
+  enum { DORMANT_TICK_INTERVAL = 10 };
+  bool active_;				// activation mask
+  unsigned dormant_count_;		// cycles since last dormant tick
+  static bool cycle_pressure_;		// cycle over budget, defer ticks
 };
 
 #endif // __CONTROLLER_HH__
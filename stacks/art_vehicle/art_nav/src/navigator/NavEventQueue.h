@@ -0,0 +1,126 @@
+/* -*- mode: C++ -*-
+ *
+ *  Navigator bounded lock-free event queue
+ *
+ *  Copyright (C) 2011, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef __NAV_EVENT_QUEUE_HH__
+#define __NAV_EVENT_QUEUE_HH__
+
+/** @file
+
+    @brief bounded lock-free multi-producer event queue.
+
+    Fixed ring of preallocated event records: producers claim slots
+    with an atomic sequence handshake and mark them ready, the single
+    consumer (the FSM in the control cycle) drains ready slots in
+    posting order.  Posting from a message callback never takes a lock
+    and never contends with the consumer.  When the ring is full the
+    event is dropped and counted, so a stalled control thread cannot
+    back-pressure the callbacks.
+
+    The slot protocol follows the usual bounded MPMC sequence scheme,
+    restricted here to a single consumer: each record carries the
+    sequence number it expects next, producers advance it by one when
+    the record is ready, and the consumer advances it a full lap when
+    the slot is free again.
+*/
+
+#include <stdint.h>
+
+template <uint32_t SIZE>		// ring capacity, power of two
+class NavEventQueue
+{
+public:
+
+  NavEventQueue()
+  {
+    head_ = 0;
+    tail_ = 0;
+    dropped_ = 0;
+    for (uint32_t i = 0; i < SIZE; ++i)
+      ring_[i].seq = i;
+  }
+
+  /** post one event code (callable from any thread)
+   *
+   *  @return false if the ring was full and the event dropped
+   */
+  bool post(int event)
+  {
+    uint32_t pos = head_;
+    for (;;)
+      {
+	record *rec = &ring_[pos & (SIZE - 1)];
+	int32_t dif = (int32_t) (rec->seq - pos);
+	if (dif == 0)
+	  {
+	    // slot free: claim it if no other producer got here first
+	    if (__sync_bool_compare_and_swap(&head_, pos, pos + 1))
+	      {
+		rec->event = event;
+		__sync_synchronize();	// record before ready mark
+		rec->seq = pos + 1;
+		return true;
+	      }
+	    pos = head_;
+	  }
+	else if (dif < 0)
+	  {
+	    // consumer a full lap behind: ring full
+	    __sync_fetch_and_add(&dropped_, 1);
+	    return false;
+	  }
+	else
+	  pos = head_;			// another producer claimed it
+      }
+  }
+
+  /** take the oldest posted event (single consumer only)
+   *
+   *  @return false when the queue is empty
+   */
+  bool take(int &event)
+  {
+    record *rec = &ring_[tail_ & (SIZE - 1)];
+    if ((int32_t) (rec->seq - (tail_ + 1)) < 0)
+      return false;			// nothing ready
+    __sync_synchronize();		// ready mark before record
+    event = rec->event;
+    rec->seq = tail_ + SIZE;		// free the slot a lap ahead
+    ++tail_;
+    return true;
+  }
+
+  /** discard everything queued (single consumer only) */
+  void drain(void)
+  {
+    int discard;
+    while (take(discard))
+      ;
+  }
+
+  /** events dropped because the ring was full */
+  uint32_t dropped(void) const {return dropped_;}
+
+private:
+
+  /** one preallocated event record */
+  struct record
+  {
+    volatile uint32_t seq;		// slot sequence handshake
+    int event;				// posted event code
+  };
+
+  record ring_[SIZE];
+  volatile uint32_t head_;		// next slot producers claim
+  uint32_t tail_;			// next slot the consumer reads
+  volatile uint32_t dropped_;		// events dropped, ring full
+};
+
+#endif // __NAV_EVENT_QUEUE_HH__
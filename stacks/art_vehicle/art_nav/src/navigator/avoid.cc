@@ -12,7 +12,9 @@
 #include "Controller.h"
 #include "avoid.h"
 
+#include "course.h"
 #include "lane_edge.h"
+#include "obstacle.h"
 #include "safety.h"
 
 Avoid::Avoid(Navigator *navptr, int _verbose):
@@ -37,10 +39,91 @@ void Avoid::configure()
   right_offset_ratio = cf->ReadFloat(section, "right_offset_ratio", -0.8);
   ART_MSG(2, "\toffset ratio to right of lane is %.3f", right_offset_ratio);
 
+  // candidate offsets evaluated per cycle, spread evenly from the
+  // right offset to the left; all are ranked in a single obstacle
+  // pass, so more candidates cost almost nothing extra
+  avoid_candidates = cf->ReadInt(section, "avoid_candidates", 7);
+  ART_MSG(2, "\t%d avoidance offset candidates", avoid_candidates);
+  offset_ratio_.resize(avoid_candidates);
+  for (int i = 0; i < avoid_candidates; ++i)
+    offset_ratio_[i] = (right_offset_ratio
+			+ ((left_offset_ratio - right_offset_ratio) * i
+			   / (avoid_candidates - 1)));
+
   lane_edge->configure(cf, section);
   safety->configure(cf, section);
 }
 
+// Evaluate lateral clearance for every candidate offset in one pass.
+//
+// Collects the obstacle points binned to the planned lane polygons,
+// converts each point to a signed lateral offset from the lane
+// center, then updates the whole clearance array for that point.
+// Cost is one pass over the nearby obstacles no matter how many
+// candidates are ranked.
+//
+// exit:
+//	clearance_[i] = smallest lateral distance (m) between the path
+//		at offset_ratio_[i] and any obstacle point in the plan
+// returns:
+//	index of the candidate with the most clearance, preferring the
+//	smaller offset magnitude on near ties; -1 if there are no
+//	binned obstacle points to rank
+//
+int Avoid::evaluate_offsets(void)
+{
+  clearance_.assign(offset_ratio_.size(), Infinite::distance);
+
+  bool have_points = false;
+  poly_list_t one_poly(1);
+  for (uint j = 0; j < course->plan.size(); ++j)
+    {
+      const poly &p = course->plan.at(j);
+      one_poly.at(0) = p;
+      mapxy_list_t points;
+      obstacle->obstacles_in_polys(one_poly, points);
+      if (points.empty())
+	continue;
+      have_points = true;
+
+      // lane bisector and half-width of this polygon
+      MapXY b1 = pops->midpoint(p.p1, p.p4);
+      MapXY b2 = pops->midpoint(p.p2, p.p3);
+      float dx = b2.x - b1.x;
+      float dy = b2.y - b1.y;
+      float len = sqrtf(dx*dx + dy*dy);
+      if (len < Epsilon::distance)
+	continue;
+      float half_width = Euclidean::DistanceTo(p.p1, p.p4) / 2.0;
+
+      for (uint i = 0; i < points.size(); ++i)
+	{
+	  // signed lateral offset of this point, positive to the left
+	  float lat = ((points.at(i).x - b1.x) * -dy
+		       + (points.at(i).y - b1.y) * dx) / len;
+
+	  // one sweep updates every candidate for this point
+	  for (uint c = 0; c < offset_ratio_.size(); ++c)
+	    clearance_[c] =
+	      fminf(clearance_[c],
+		    fabsf(lat - offset_ratio_[c] * half_width));
+	}
+    }
+
+  if (!have_points)
+    return -1;
+
+  int best = 0;
+  for (uint c = 1; c < offset_ratio_.size(); ++c)
+    {
+      if (clearance_[c] > clearance_[best] + Epsilon::distance
+	  || (Epsilon::equal(clearance_[c], clearance_[best])
+	      && fabsf(offset_ratio_[c]) < fabsf(offset_ratio_[best])))
+	best = c;
+    }
+  return best;
+}
+
 // avoid obstacles in travel lane
 //
 // entry:
@@ -57,11 +140,33 @@ Controller::result_t Avoid::control(pilot_command_t &pcmd,
   // make copies of primary controller output
   pilot_command_t right_cmd = pcmd;
   pilot_command_t left_cmd = pcmd;
+  pilot_command_t cand_cmd = pcmd;
   result_t result = safety->control(pcmd);
   if (result != OK)			// safety modified pcmd?
     {
-      // Try some avoidance maneuvers.  Each reruns the safety
-      // controller on its output before returning.
+      // Rank every candidate offset by clearance in one pass over the
+      // binned obstacles, then steer the clearest one, rerunning the
+      // safety controller on its output.
+      int best = evaluate_offsets();
+      if (best >= 0)
+	{
+	  result_t cand_result =
+	    lane_edge->control(cand_cmd, offset_ratio_[best]);
+	  if (cand_result < result)
+	    {
+	      if (verbose >= 2)
+		ART_MSG(5, "avoiding at offset %.2f (clearance %.2fm)",
+			offset_ratio_[best], clearance_[best]);
+	      pcmd = cand_cmd;
+	      result = cand_result;
+	    }
+	  trace("avoid controller", pcmd, result);
+	  return result;
+	}
+
+      // No binned obstacle points to rank: fall back to trying the
+      // two lane edges.  Each reruns the safety controller on its
+      // output before returning.
       result_t edge_right = lane_edge->control(right_cmd, right_offset_ratio);
       result_t edge_left = lane_edge->control(left_cmd, left_offset_ratio);
 
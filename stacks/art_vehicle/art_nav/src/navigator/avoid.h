@@ -30,10 +30,16 @@ private:
   // .cfg variables
   float left_offset_ratio;
   float right_offset_ratio;
+  int avoid_candidates;
+
+  // candidate lane offsets, ranked together in one obstacle pass
+  std::vector<float> offset_ratio_;	// candidate offset ratios
+  std::vector<float> clearance_;	// lateral clearance per candidate
 
   LaneEdge *lane_edge;
   Safety *safety;
 
+  int evaluate_offsets(void);
   void reset_me(void);
 };
 
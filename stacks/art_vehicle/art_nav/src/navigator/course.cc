@@ -10,11 +10,13 @@
 #include <angles/angles.h>
 
 #include <art/DARPA_rules.h>
+#include <art/flight_recorder.h>
 
 #include "navigator_internal.h"
 #include "course.h"
 #include <art/steering.h>
 #include <art_map/coordinates.h>
+#include <art_map/ZoneOps.h>
 #include <art_nav/estimate.h>
 using art_msgs::ArtVehicle;
 using Coordinates::bearing;
@@ -23,6 +25,9 @@ using Coordinates::normalize;
 /** @todo Use ROS tf instead of art_map/rotate_translate_transform */
 #include <art_map/rotate_translate_transform.h>
 
+// stop approach profile speed ramp resolution (m)
+static const float stop_ramp_step = 0.25;
+
 // Constructor
 Course::Course(Navigator *_nav, int _verbose)
 {
@@ -39,6 +44,21 @@ Course::Course(Navigator *_nav, int _verbose)
 
   // initialize polygon vectors
   plan.clear();
+  plan_version = 0;
+  closest_plan_cached_ = false;
+  closest_plan_index_ = -1;
+  closest_plan_version_ = -1;
+  w1_index_ = -1;
+  stop_profile_version_ = -1;
+  stop_profile_index_ = -1;
+  stop_profile_end_ = 0.0;
+  edge_geo_version_ = -1;
+  spline_version_ = -1;
+  spline_plan_size_ = 0;
+  spline_first_id_ = -1;
+  spline_last_id_ = -1;
+  cached_zone_id_ = -1;
+  zone_cache_valid_ = false;
   polygons.clear();
 
   for (unsigned i = 0; i < 2; ++i)
@@ -60,6 +80,7 @@ Course::Course(Navigator *_nav, int _verbose)
 void Course::begin_run_cycle(void)
 {
   waypoint_checked = false;
+  closest_plan_cached_ = false;		// new cycle, new pose estimate
 
   // Finding the current polygon is easy in a travel lane, but
   // more difficult in intersections.  They have many overlapping
@@ -245,17 +266,18 @@ void Course::desired_heading(pilot_command_t &pcmd, float offset_ratio)
       // Look in plan
       aim_index = pops->getPolyIndex(plan, aim_poly);
 
-      poly_list_t edge;
-      pops->add_polys_for_waypts(plan,edge,order->waypt[0].id,
+      // reuse the scratch list, retaining its heap allocation
+      edge_polys_.clear();
+      pops->add_polys_for_waypts(plan,edge_polys_,order->waypt[0].id,
                                  order->waypt[1].id);
 
       // get closest polygon to estimated position
       int nearby_poly =
-        pops->getClosestPoly(edge, MapPose(estimate->pose.pose));
+        pops->getClosestPoly(edge_polys_, MapPose(estimate->pose.pose));
       if (nearby_poly >= 0)
-	nearby_poly = pops->getPolyIndex(plan,edge.at(nearby_poly));
+	nearby_poly = pops->getPolyIndex(plan,edge_polys_.at(nearby_poly));
       else
-        nearby_poly = pops->getClosestPoly(plan, MapPose(estimate->pose.pose));
+        nearby_poly = closest_plan_index();
 
       if (aim_poly.poly_id != -1
           && aim_index >= 0
@@ -275,13 +297,16 @@ void Course::desired_heading(pilot_command_t &pcmd, float offset_ratio)
 
 	  aim_distance = Euclidean::DistanceTo(plan.at(aim_index+1).midpoint,
 					       plan.at(aim_index).midpoint);
-	  aim_next_heading = atan2f(plan.at(aim_index+1).midpoint.y-
-				    plan.at(aim_index).midpoint.y,
-				    plan.at(aim_index+1).midpoint.x-
-				    plan.at(aim_index).midpoint.x);
+	  float aim_curvature;
+	  if (!spline_heading_at(aim_index, aim_next_heading, aim_curvature))
+	    // no spline available, use the discrete segment heading
+	    aim_next_heading = atan2f(plan.at(aim_index+1).midpoint.y-
+				      plan.at(aim_index).midpoint.y,
+				      plan.at(aim_index+1).midpoint.x-
+				      plan.at(aim_index).midpoint.x);
 
 	  aim_in_plan = true;
-	  
+
           ROS_DEBUG("steering down the lane toward polygon %d",
                     plan.at(aim_index).poly_id);
 	}
@@ -304,10 +329,14 @@ void Course::desired_heading(pilot_command_t &pcmd, float offset_ratio)
                     Euclidean::DistanceTo(plan.at(aim_index+1).midpoint,
                                           plan.at(aim_index).midpoint);
 
-		  aim_next_heading = atan2f(plan.at(aim_index+1).midpoint.y-
-					    plan.at(aim_index).midpoint.y,
-					    plan.at(aim_index+1).midpoint.x-
-					    plan.at(aim_index).midpoint.x);
+		  float aim_curvature;
+		  if (!spline_heading_at(aim_index, aim_next_heading,
+					 aim_curvature))
+		    // no spline available, use the segment heading
+		    aim_next_heading = atan2f(plan.at(aim_index+1).midpoint.y-
+					      plan.at(aim_index).midpoint.y,
+					      plan.at(aim_index+1).midpoint.x-
+					      plan.at(aim_index).midpoint.x);
 
 		  aim_in_plan = true;
 		  
@@ -399,6 +428,12 @@ void Course::desired_heading(pilot_command_t &pcmd, float offset_ratio)
     pcmd.velocity = fminf(pcmd.velocity,Steering::steer_speed_min);
 #endif  
 
+  // flight recorder: the polygon aimed for and the lane offset used
+  ART_RECORD4("course aim", plan_version,
+	      (aim_index >= 0 && aim_index < (int) plan.size()
+	       ? plan.at(aim_index).poly_id: -1),
+	      offset_ratio, aim_in_plan);
+
   nav->trace_controller("desired_heading", pcmd);
 }
 
@@ -452,16 +487,18 @@ void Course::end_run_cycle()
 int Course::find_aim_polygon(poly_list_t &lane)
 {
 
-  poly_list_t edge;
-  pops->add_polys_for_waypts(lane,edge,order->waypt[0].id,
+  // reuse the scratch list, retaining its heap allocation
+  edge_polys_.clear();
+  pops->add_polys_for_waypts(lane,edge_polys_,order->waypt[0].id,
 			     order->waypt[1].id);
-  
+
   // get closest polygon to estimated position
-  int nearby_poly = pops->getClosestPoly(edge, MapPose(estimate->pose.pose));
+  int nearby_poly = pops->getClosestPoly(edge_polys_,
+					 MapPose(estimate->pose.pose));
   if (nearby_poly < 0)
     nearby_poly = pops->getClosestPoly(lane, MapPose(estimate->pose.pose));
   else
-    nearby_poly = pops->getPolyIndex(lane,edge.at(nearby_poly));
+    nearby_poly = pops->getPolyIndex(lane,edge_polys_.at(nearby_poly));
 
   if (nearby_poly < 0)
     return -1;
@@ -517,6 +554,25 @@ int Course::find_aim_polygon(poly_list_t &lane)
 #endif
 }
 
+// Return index in plan of polygon closest to the estimated pose.
+//
+// Several controllers need this every cycle; the result only changes
+// with a new pose estimate or a new plan, so it is computed at most
+// once per run cycle and plan version.
+//
+int Course::closest_plan_index(void)
+{
+  if (!closest_plan_cached_
+      || closest_plan_version_ != plan_version)
+    {
+      closest_plan_index_ =
+	pops->getClosestPoly(plan, MapPose(estimate->pose.pose));
+      closest_plan_version_ = plan_version;
+      closest_plan_cached_ = true;
+    }
+  return closest_plan_index_;
+}
+
 // Find an appropriate polygon path for passing an obstacle blocking
 // the current travel lane.
 //
@@ -547,7 +603,7 @@ bool Course::find_passing_lane(void)
 
 #if 1 // more general implementation, experimental
 
-  int cur_index = pops->getClosestPoly(plan, MapPose(estimate->pose.pose));
+  int cur_index = closest_plan_index();
   if (cur_index == -1)
     {
       ROS_WARN("no polygon nearby in plan");
@@ -568,8 +624,8 @@ bool Course::find_passing_lane(void)
       if (adj_lane[i].lane == 0)	// ID not valid?
 	continue;
 
-      // collect lane polygons
-      pops->AddLanePolys(polygons, adj_polys[i], adj_lane[i]);
+      // collect lane polygons from the per-lane index
+      add_lane_polys(adj_polys[i], adj_lane[i], false);
       int this_index =
         pops->getClosestPoly(adj_polys[i],
                              MapXY(order->waypt[1].mapxy));
@@ -589,7 +645,7 @@ bool Course::find_passing_lane(void)
 	{
 	  // collect polygons in reverse direction, instead
 	  adj_polys[i].clear();
-	  pops->AddReverseLanePolys(polygons, adj_polys[i], adj_lane[i]);
+	  add_lane_polys(adj_polys[i], adj_lane[i], true);
 	}
 
       if (verbose >= 4)
@@ -680,13 +736,25 @@ void Course::find_travel_lane(bool rejoin)
     {
       ROS_DEBUG("find_travel_lane() plan still valid");
     }
+  else if (extend_plan())
+    {
+      // the order way-points only shifted forward: the previous plan
+      // was reused and extended in place
+      ROS_DEBUG("find_travel_lane() extended previous plan");
+      aim_poly.poly_id = -1;		// no aim polygon defined
+      set_plan_waypts();
+      log("find_travel_lane() plan", plan);
+      record_plan("course plan extended");
+    }
   else
     {
       // make a new plan
       plan.clear();
+      ++plan_version;
+      plan_covered = -1;
       aim_poly.poly_id = -1;		// no aim polygon defined
       set_plan_waypts();
-    
+
       if (polygons.size() == 0)		// no lane data available?
 	{
           ROS_WARN("find_travel_lane() has no polygons");
@@ -700,6 +768,7 @@ void Course::find_travel_lane(bool rejoin)
         log("debug plan", plan);
 
       // add polygons leading to the target waypt entries
+      plan_covered = Order::N_WAYPTS - 1;
       for (int i = 1; i < Order::N_WAYPTS; ++i)
 	{
 	  // Do not repeat polygons for repeated way-points in the order.
@@ -712,7 +781,10 @@ void Course::find_travel_lane(bool rejoin)
 				       order->waypt[i].id);
 	  // don't plan past a zone entry
 	  if (order->waypt[i].is_perimeter)
-	    break;
+	    {
+	      plan_covered = i;
+	      break;
+	    }
 	}
 
       if (plan.size() > 1)
@@ -727,8 +799,9 @@ void Course::find_travel_lane(bool rejoin)
                     plan.at(1).poly_id);
 	}
       log("find_travel_lane() plan", plan);
+      record_plan("course plan new");
     }
-  
+
   new_plan_lanes = false;		// plan reflects current lanes
   aim_poly.poly_id = -1;		// no aim polygon defined
 
@@ -757,6 +830,79 @@ void Course::find_travel_lane(bool rejoin)
     }
 }
 
+// Extend the previous plan after the order way-points shifted forward.
+//
+// Commander shifts the way-points left as each one is reached, so
+// most new orders share all but their last few way-points with the
+// plan already built.  In that case drop the polygons behind the new
+// waypt[0] and append only the new final legs, instead of rescanning
+// the whole polygons vector for every leg.
+//
+// returns: true if the plan was updated incrementally, false if a
+//	    full rebuild is needed
+//
+bool Course::extend_plan(void)
+{
+  if (plan.empty() || new_plan_lanes || polygons.empty())
+    return false;
+  if (plan_covered != Order::N_WAYPTS - 1)
+    return false;			// previous plan stopped early
+
+  // find the smallest forward shift matching the saved way-points
+  int shift = 0;
+  for (int k = 1; k < Order::N_WAYPTS; ++k)
+    {
+      bool match = true;
+      for (int i = 0; k + i < Order::N_WAYPTS; ++i)
+	if (plan_waypt[k+i] != order->waypt[i].id)
+	  {
+	    match = false;
+	    break;
+	  }
+      if (match)
+	{
+	  shift = k;
+	  break;
+	}
+    }
+  if (shift == 0)
+    return false;			// not a simple advance
+
+  // drop the polygons behind the new first way-point
+  unsigned first = 0;
+  while (first < plan.size()
+	 && !pops->match_waypt_poly(plan.at(first), order->waypt[0].id))
+    ++first;
+  if (first >= plan.size())
+    return false;			// waypt[0] polygon not in plan
+  plan.erase(plan.begin(), plan.begin() + first);
+
+  // Append the legs the previous plan did not cover, mirroring the
+  // full rebuild below: skip repeated way-points and do not plan past
+  // a zone entry.
+  plan_covered = Order::N_WAYPTS - 1;
+  for (int i = 1; i < Order::N_WAYPTS; ++i)
+    {
+      if (i >= Order::N_WAYPTS - shift
+	  && (ElementID(order->waypt[i-1].id)
+	      != ElementID(order->waypt[i].id)))
+	pops->add_polys_for_waypts(polygons, plan,
+				   order->waypt[i-1].id,
+				   order->waypt[i].id);
+      if (order->waypt[i].is_perimeter)
+	{
+	  plan_covered = i;
+	  break;
+	}
+    }
+
+  // erasing the front shifted every index: invalidate the caches
+  // keyed on the plan version
+  ++plan_version;
+
+  return true;
+}
+
 // Head directly for next reachable way-point.
 //
 // This is trouble: the plan stops too soon for navigating
@@ -864,21 +1010,14 @@ bool Course::lane_waypoint_reached(void)
   // car has reached a line through the way-point perpendicular to
   // the direction of its lane.
 
-  // get polygon index of waypt[1] (TODO: save somewhere)
-  int w1_index = -1;
+  // polygon index and pose of waypt[1] come from the cursor
+  update_waypt_cursor();
 
-  w1_index = pops->get_waypoint_index(polygons, order->waypt[1].id);
-  
-  if (w1_index >= 0)
+  if (w1_index_ >= 0)
     {
-      // form way-point pose using polygon heading
-      // TODO: save somewhere
-      MapPose w1_pose(MapXY(order->waypt[1].mapxy),
-		      pops->PolyHeading(polygons.at(w1_index)));
-      
       // Is the bearing of the car from that pose within 90
       // degrees of the polygon heading?
-      float bearing_from_w1 = bearing(w1_pose,
+      float bearing_from_w1 = bearing(w1_pose_,
                                       MapXY(odom->pose.pose.position));
       if (fabsf(bearing_from_w1) < angles::from_degrees(90))
 	{
@@ -899,6 +1038,32 @@ bool Course::lane_waypoint_reached(void)
   return found;
 }
 
+// Update the way-point cursor for order->waypt[1].
+//
+// The polygon index and pose of the next way-point only change when
+// the order advances past a way-point or new polygons arrive, so
+// they are cached here instead of rescanned on every reached test.
+// lanes_message() invalidates the cursor.
+//
+void Course::update_waypt_cursor(void)
+{
+  if (ElementID(order->waypt[1].id) == w1_id_)
+    return;				// cursor still current
+
+  w1_id_ = ElementID(order->waypt[1].id);
+  if (order->waypt[1].is_perimeter)
+    // perimeter points have no containing polygon, use the closest
+    w1_index_ = pops->getClosestPoly(polygons,
+				     MapXY(order->waypt[1].mapxy));
+  else
+    w1_index_ = pops->get_waypoint_index(polygons, w1_id_);
+
+  if (w1_index_ >= 0)
+    // form way-point pose using polygon heading
+    w1_pose_ = MapPose(MapXY(order->waypt[1].mapxy),
+		       pops->PolyHeading(polygons.at(w1_index_)));
+}
+
 /** Handle lanes message.
  *
  *  Called from the topic subscription callback when new lanes data
@@ -911,15 +1076,88 @@ void Course::lanes_message(const art_msgs::ArtLanes &lanes)
   for (unsigned num = 0; num < lanes.polygons.size(); num++)
     polygons.at(num) = lanes.polygons[num];
 
+  lanes_received();
+};
+
+// handle lanes data already deserialized into poly records
+void Course::lanes_message(const poly_list_t &lane_polys)
+{
+  polygons = lane_polys;
+  lanes_received();
+};
+
+// rebuild indexes after new lane polygons arrive
+void Course::lanes_received(void)
+{
   if (polygons.empty())
     ROS_WARN("empty lanes polygon list received!");
 
-  // force plan to be recomputed
+  // rebuild the per-lane polygon index
+  lane_table_.clear();
+  for (unsigned num = 0; num < polygons.size(); num++)
+    {
+      const poly &p = polygons.at(num);
+      if (p.is_transition
+	  || p.start_way.seg != p.end_way.seg
+	  || p.start_way.lane != p.end_way.lane)
+	continue;			// not a lane polygon
+      lane_table_[ElementID(p.start_way.seg,
+			    p.start_way.lane, 0)].push_back(p);
+    }
+
+  // rebuild the way-point hash index over the new polygons
+  waypt_index_.rebuild(polygons);
+  pops->attachWaypointIndex(&waypt_index_);
+
+  // force plan to be recomputed, invalidate the way-point cursor
   new_plan_lanes = true;
+  w1_id_ = ElementID();
 
   log("lanes input:", polygons);
 };
 
+/** Zone perimeter for a zone ID, from a one-entry cache.
+ *
+ *  The zone controllers ask for the same zone on every control cycle
+ *  while driving through it.  Zones never change once the RNDF is
+ *  loaded, so the list scan and perimeter vector copy happen only
+ *  when a different zone is requested.
+ */
+const ZonePerimeter &Course::zone_perimeter(segment_id_t zone_id)
+{
+  if (!zone_cache_valid_ || zone_id != cached_zone_id_)
+    {
+      cached_zone_ = ZoneOps::get_zone_by_id(zones, zone_id);
+      cached_zone_id_ = zone_id;
+      zone_cache_valid_ = true;
+    }
+  return cached_zone_;
+}
+
+/** Replace the zone list, invalidating the perimeter cache. */
+void Course::set_zones(const ZonePerimeterList &_zones)
+{
+  zones = _zones;
+  zone_cache_valid_ = false;
+}
+
+// append cached polygons for a lane, forward or reverse of list order
+void Course::add_lane_polys(poly_list_t &to_polys, ElementID id,
+			    bool reverse) const
+{
+  lane_table_t::const_iterator it =
+    lane_table_.find(ElementID(id.seg, id.lane, 0));
+  if (it == lane_table_.end())
+    return;				// no polygons in that lane
+
+  if (reverse)
+    to_polys.insert(to_polys.end(),
+		    it->second.rbegin(), it->second.rend());
+  else
+    to_polys.insert(to_polys.end(),
+		    it->second.begin(), it->second.end());
+};
+
 // log a vector of polygons
 void Course::log(const char *str, const poly_list_t &polys)
 {
@@ -948,6 +1186,24 @@ void Course::log(const char *str, const poly_list_t &polys)
     }
 }
 
+// record a plan decision in the flight recorder
+//
+// One fixed-size binary record per decision instead of the ROS_DEBUG
+// poly dumps in log(), cheap enough to stay on in the field, so
+// plan-selection history is captured even with debug logging off.
+// Format the rings with FlightRecorder::dump() (or send SIGUSR1).
+void Course::record_plan(const char *label)
+{
+  int first_id = -1;
+  int last_id = -1;
+  if (!plan.empty())
+    {
+      first_id = plan.front().poly_id;
+      last_id = plan.back().poly_id;
+    }
+  ART_RECORD4(label, plan_version, plan.size(), first_id, last_id);
+}
+
 // return true if current order does not match saved way-points
 bool Course::new_waypts(void)
 {
@@ -972,7 +1228,10 @@ void Course::reset(void)
 
   // clear the previous plan
   plan.clear();
+  ++plan_version;
+  plan_covered = -1;
   aim_poly.poly_id = -1;
+  record_plan("course plan reset");
 }
 
 // replan after road block
@@ -989,8 +1248,7 @@ ElementID Course::replan_roadblock(void)
     }
 
   // Get closest polygon in current plan.
-  int uturn_exit_index = 
-    pops->getClosestPoly(plan,MapPose(estimate->pose.pose));
+  int uturn_exit_index = closest_plan_index();
 
   MapPose exit_pose;
   exit_pose.map.x=plan.at(uturn_exit_index).midpoint.x;
@@ -1052,6 +1310,28 @@ float Course::stop_waypt_distance(bool same_lane)
 
       if (order->waypt[i].is_stop)
 	{
+	  // Reuse the precomputed approach profile when the stop
+	  // way-point and the plan are both unchanged.  The profiled
+	  // index must still name the stop polygon in the current
+	  // plan: the distance table is indexed by plan position, so
+	  // a shifted plan with a missed version bump would report a
+	  // stop distance wrong by the shifted prefix length.
+	  if (ElementID(order->waypt[i].id) == stop_profile_id_
+	      && plan_version == stop_profile_version_
+	      && stop_profile_index_ >= 0
+	      && stop_profile_index_ < (int) plan.size()
+	      && (plan.at(stop_profile_index_).poly_id
+		  == stop_profile_poly_.poly_id))
+	    {
+	      stop_poly = stop_profile_poly_;
+	      stop_waypt = WayPointNode(order->waypt[i]);
+	      float wayptdist =
+		stop_profile_distance(MapPose(estimate->pose.pose));
+	      ROS_DEBUG("Stop at waypoint %s is %.3fm away",
+			stop_waypt.id.name().str, wayptdist);
+	      return wayptdist;
+	    }
+
 	  // find stop way-point polygon
 	  int stop_index =
             pops->getContainingPoly(polygons,
@@ -1061,6 +1341,7 @@ float Course::stop_waypt_distance(bool same_lane)
 
 	  stop_poly = polygons.at(stop_index);
 	  stop_waypt = WayPointNode(order->waypt[i]);
+	  build_stop_profile();		// for the following cycles
 	  float wayptdist = distance_in_plan(MapPose(estimate->pose.pose),
                                              stop_waypt);
           ROS_DEBUG("Stop at waypoint %s is %.3fm away",
@@ -1071,6 +1352,101 @@ float Course::stop_waypt_distance(bool same_lane)
   return Infinite::distance;
 }
 
+// Build the approach profile for stop_waypt over the current plan.
+//
+// Tabulates the arc length from each plan polygon's leading edge to
+// the stop point, so the per-cycle distance query reduces to the
+// memoized closest-polygon lookup plus one edge distance, and samples
+// the constant-deceleration speed ramp for the approach.
+//
+void Course::build_stop_profile(void)
+{
+  stop_profile_id_ = ElementID();	// invalid until fully built
+  stop_profile_dist_.clear();
+  stop_profile_ramp_.clear();
+
+  int stop_index = pops->getClosestPoly(plan, stop_waypt.map);
+  if (stop_index < 0)			// stop point not in plan?
+    return;				// recompute distance each cycle
+
+  // distance of the stop point from the trailing edge of its
+  // polygon, projected on the lane bisector the same way
+  // distanceAlongLane() does
+  poly p = plan.at(stop_index);
+  MapXY b1 = pops->midpoint(p.p1, p.p4);
+  MapXY b2 = pops->midpoint(p.p2, p.p3);
+  MapXY stop_point = pops->GetClosestPointToLine(b1, b2, stop_waypt.map,
+						 true);
+  float tmp;
+  Euclidean::DistanceFromLine(stop_point, p.p1, p.p4,
+			      stop_profile_end_, tmp);
+
+  // arc length from each earlier polygon's leading edge to the stop
+  // point: the lengths of the polygons strictly between, plus the
+  // stop point offset
+  stop_profile_dist_.resize(stop_index + 1, stop_profile_end_);
+  for (int i = stop_index - 2; i >= 0; --i)
+    stop_profile_dist_[i] = stop_profile_dist_[i+1] + plan.at(i+1).length;
+
+  // speed ramp for a constant-deceleration stop, sampled every
+  // stop_ramp_step of remaining distance
+  float span = stop_profile_dist_[0] + plan.at(0).length;
+  int nsteps = int(span / stop_ramp_step) + 2;
+  stop_profile_ramp_.resize(nsteps);
+  for (int k = 0; k < nsteps; ++k)
+    stop_profile_ramp_[k] = sqrtf(2.0 * config_->stop_deceleration
+				  * k * stop_ramp_step);
+
+  stop_profile_index_ = stop_index;
+  stop_profile_version_ = plan_version;
+  stop_profile_poly_ = stop_poly;
+  stop_profile_id_ = stop_waypt.id;
+}
+
+// Distance to the stop point through the profile table.
+//
+// Same result as distance_in_plan() when the vehicle is within the
+// profiled span, without rescanning the plan for the stop polygon or
+// summing polygon lengths.
+//
+float Course::stop_profile_distance(const MapPose &pose)
+{
+  int index = closest_plan_index();
+  if (index < 0 || index > stop_profile_index_)
+    // outside the profiled span: use the generic computation
+    return distance_in_plan(pose, stop_waypt);
+
+  poly p = plan.at(index);
+  MapXY b1 = pops->midpoint(p.p1, p.p4);
+  MapXY b2 = pops->midpoint(p.p2, p.p3);
+  MapXY start_point = pops->GetClosestPointToLine(b1, b2, pose.map, true);
+
+  float dist, tmp;
+  if (index < stop_profile_index_)
+    {
+      // distance to this polygon's leading edge, then the table
+      Euclidean::DistanceFromLine(start_point, p.p2, p.p3, dist, tmp);
+      return dist + stop_profile_dist_[index];
+    }
+
+  // same polygon as the stop point
+  Euclidean::DistanceFromLine(start_point, p.p1, p.p4, dist, tmp);
+  return stop_profile_end_ - dist;
+}
+
+// Speed limit from the precomputed stop approach ramp.
+//
+float Course::stop_approach_speed_limit(float distance)
+{
+  if (distance <= 0.0)
+    return 0.0;
+  unsigned step = (unsigned) (distance / stop_ramp_step);
+  if (step < stop_profile_ramp_.size())
+    return stop_profile_ramp_[step];
+  // past the end of the ramp (or no profile built)
+  return sqrtf(2.0 * config_->stop_deceleration * distance);
+}
+
 // switch to previously selected passing lane
 //
 // entry:
@@ -1098,9 +1474,12 @@ bool Course::switch_to_passing_lane()
 
   // collect all the polygons from aim_index to end of passing lane
   plan.clear();
+  ++plan_version;
+  plan_covered = -1;			// plan no longer follows way-points
   pops->CollectPolys(adj_polys[passing_lane], plan, aim_index);
-  
+
   log("switch_to_passing_lane() plan", plan);
+  record_plan("course plan passing");
   if (plan.empty())
     {
       ROS_WARN("no polygons in passing lane past aiming point");
@@ -1222,21 +1601,16 @@ bool Course::zone_perimeter_reached(void)
   bool found = false;
   waypoint_checked = true;
   
-  int w1_index =
-    pops->getClosestPoly(polygons,
-                         MapXY(order->waypt[1].mapxy));
-  if (w1_index >= 0)
+  // polygon index and pose of waypt[1] come from the cursor
+  update_waypt_cursor();
+
+  if (w1_index_ >= 0)
     {
-      // form way-point pose using polygon heading
-      // TODO: save somewhere
-      MapPose w1_pose(order->waypt[1].mapxy, 
-		      pops->PolyHeading(polygons.at(w1_index)));
-      
 #if 1
       // Is the bearing of the car from that pose within 90
       // degrees of the polygon heading?
       float bearing_from_w1 =
-        bearing(w1_pose, MapXY(odom->pose.pose.position));
+        bearing(w1_pose_, MapXY(odom->pose.pose.position));
 #else // experimental code -- not working right yet
       // Is the bearing of a point slightly ahead of the front bumper
       // from that pose within 90 degrees of the polygon heading?
@@ -1244,7 +1618,7 @@ bool Course::zone_perimeter_reached(void)
 			 (ArtVehicle::front_bumper_px
 			  + DARPA_rules::stop_line_to_bumper));
       MapXY bumper_pos = Polar_to_MapXY(bumper_polar, odom->pos);
-      float bearing_from_w1 = bearing(w1_pose, bumper_pos);
+      float bearing_from_w1 = bearing(w1_pose_, bumper_pos);
 #endif
       if (fabsf(bearing_from_w1) < angles::from_degrees(90))
 	{
@@ -1341,7 +1715,148 @@ float Course::max_speed_for_change_in_heading(const float& dheading,
 }
 
 
-float Course::get_yaw_spring_system(const Polar& aim_polar, 
+// Rebuild the per-polygon lane edge geometry table for the plan.
+//
+// The lateral quantities used by offset steering (leading edge width
+// and the usable space between lane center and the left boundary)
+// depend only on the plan polygons, so they are extracted once per
+// plan instead of from the boundary points on every call.
+//
+// uniform arc-length step of the compiled path spline (m)
+static const float SPLINE_STEP = 0.5;
+
+// rebuild the path spline for the current plan
+//
+// Headings come from central differences of the plan midpoints
+// (one-sided at the ends), unwrapped so they interpolate across the
+// +/-pi seam, then resampled at uniform arc-length steps.  Curvature
+// is the arc-length derivative of the resampled heading.
+//
+void Course::build_path_spline(void)
+{
+  spline_version_ = plan_version;
+  spline_plan_size_ = plan.size();
+  spline_first_id_ = (plan.empty()? -1: plan.front().poly_id);
+  spline_last_id_ = (plan.empty()? -1: plan.back().poly_id);
+  spline_mid_s_.clear();
+  spline_heading_.clear();
+  spline_curvature_.clear();
+
+  if (plan.size() < 3)
+    return;				// too short to smooth
+
+  // cumulative arc length at each plan midpoint
+  spline_mid_s_.resize(plan.size());
+  spline_mid_s_[0] = 0.0;
+  for (unsigned i = 1; i < plan.size(); ++i)
+    spline_mid_s_[i] = spline_mid_s_[i-1]
+      + Euclidean::DistanceTo(plan.at(i).midpoint, plan.at(i-1).midpoint);
+
+  float total = spline_mid_s_.back();
+  if (total < 2.0 * SPLINE_STEP)
+    {
+      spline_mid_s_.clear();
+      return;				// degenerate plan geometry
+    }
+
+  // smoothed, unwrapped heading at each midpoint
+  std::vector<float> mid_heading(plan.size());
+  for (unsigned i = 0; i < plan.size(); ++i)
+    {
+      unsigned prev = (i == 0? 0: i-1);
+      unsigned next = (i == plan.size()-1? i: i+1);
+      float h = atan2f(plan.at(next).midpoint.y - plan.at(prev).midpoint.y,
+		       plan.at(next).midpoint.x - plan.at(prev).midpoint.x);
+      if (i > 0)			// unwrap relative to previous
+	h = mid_heading[i-1] + normalize(h - mid_heading[i-1]);
+      mid_heading[i] = h;
+    }
+
+  // resample at uniform arc length
+  unsigned nsamples = (unsigned) (total / SPLINE_STEP) + 1;
+  spline_heading_.resize(nsamples);
+  unsigned seg = 0;
+  for (unsigned k = 0; k < nsamples; ++k)
+    {
+      float s = k * SPLINE_STEP;
+      while (seg + 2 < spline_mid_s_.size() && spline_mid_s_[seg+1] < s)
+	++seg;
+      float span = spline_mid_s_[seg+1] - spline_mid_s_[seg];
+      float frac = (span > 0.0? (s - spline_mid_s_[seg]) / span: 0.0);
+      frac = fmaxf(0.0, fminf(1.0, frac));
+      spline_heading_[k] = (mid_heading[seg]
+			    + frac * (mid_heading[seg+1]
+				      - mid_heading[seg]));
+    }
+
+  // curvature from central differences of the resampled heading
+  spline_curvature_.resize(nsamples);
+  for (unsigned k = 0; k < nsamples; ++k)
+    {
+      unsigned prev = (k == 0? 0: k-1);
+      unsigned next = (k == nsamples-1? k: k+1);
+      spline_curvature_[k] = ((spline_heading_[next]
+			       - spline_heading_[prev])
+			      / ((next - prev) * SPLINE_STEP));
+    }
+
+  ROS_DEBUG("path spline compiled: %.1fm, %u samples", total, nsamples);
+}
+
+// smoothed heading and curvature for the plan segment at index
+bool Course::spline_heading_at(int index, float &heading, float &curvature)
+{
+  // Rebuild for a new plan.  The plan contents are checked as well
+  // as the version: a stale spline evaluated with indices into a
+  // changed plan would steer on headings and curvatures from the
+  // wrong arc-length positions, so a missed version bump must not
+  // go unnoticed here.
+  if (spline_version_ != plan_version
+      || spline_plan_size_ != plan.size()
+      || spline_first_id_ != (plan.empty()? -1: plan.front().poly_id)
+      || spline_last_id_ != (plan.empty()? -1: plan.back().poly_id))
+    build_path_spline();
+
+  if (spline_heading_.size() < 2
+      || index < 0
+      || index + 1 >= (int) spline_mid_s_.size())
+    return false;
+
+  // evaluate midway along the segment, where the discrete heading
+  // nominally applies
+  float s = 0.5 * (spline_mid_s_[index] + spline_mid_s_[index+1]);
+  float pos = s / SPLINE_STEP;
+  unsigned k = (unsigned) pos;
+  if (k + 1 >= spline_heading_.size())
+    k = spline_heading_.size() - 2;
+  float frac = fmaxf(0.0, fminf(1.0, pos - k));
+
+  heading = normalize(spline_heading_[k]
+		      + frac * (spline_heading_[k+1] - spline_heading_[k]));
+  curvature = (spline_curvature_[k]
+	       + frac * (spline_curvature_[k+1] - spline_curvature_[k]));
+  return true;
+}
+
+void Course::build_edge_geometry(void)
+{
+  edge_geo_.resize(plan.size());
+  for (unsigned i = 0; i < plan.size(); ++i)
+    {
+      const poly &p = plan.at(i);
+      edge_geo_[i].width = Euclidean::DistanceTo(p.p2, p.p3);
+
+      // distance from polygon midpoint to middle of the left lane
+      // boundary, minus half the width of the car
+      MapXY mid_left_side = pops->midpoint(p.p1, p.p2);
+      float half_lane_width =
+	Euclidean::DistanceTo(p.midpoint, mid_left_side);
+      edge_geo_[i].lane_space = half_lane_width - ArtVehicle::halfwidth;
+    }
+  edge_geo_version_ = plan_version;
+}
+
+float Course::get_yaw_spring_system(const Polar& aim_polar,
 				    int poly_id,
 				    float poly_heading,
 				    float max_yaw,
@@ -1362,6 +1877,14 @@ float Course::get_yaw_spring_system(const Polar& aim_polar,
  
   if (poly_id >=0)
     {
+      // Rebuild for a new plan, or whenever the table is too small
+      // for this plan index: a missed version bump must degrade to a
+      // rebuild, not an out-of-bounds read feeding the steering
+      // offset.
+      if (edge_geo_version_ != plan_version
+	  || poly_id >= (int) edge_geo_.size())
+	build_edge_geometry();
+
       poly current_poly=plan.at(poly_id);
       posetype origin;			// (0, 0, 0)
       posetype cpoly(current_poly.midpoint.x, current_poly.midpoint.y,
@@ -1373,7 +1896,7 @@ float Course::get_yaw_spring_system(const Polar& aim_polar,
                    0.0);
       posetype car_rel=trans.apply_transform(car);
 
-      float width=Euclidean::DistanceTo(current_poly.p2,current_poly.p3);
+      float width=edge_geo_[poly_id].width;
 
       // transverse offset error, positive if left of center (push right)
       error=car_rel.y;
@@ -1384,19 +1907,15 @@ float Course::get_yaw_spring_system(const Polar& aim_polar,
       if (!Epsilon::equal(offset_ratio, 0.0))
 	{
 	  // To steer for an offset from lane center, adjust error by
-	  // subtracting offset from polygon midpoint to middle of
-	  // left lane boundary minus width of car.  
-
-	  MapXY mid_left_side =
-	    pops->midpoint(current_poly.p1, current_poly.p2);
-	  float half_lane_width =
-	    Euclidean::DistanceTo(current_poly.midpoint, mid_left_side);
-	  float lane_space = half_lane_width - ArtVehicle::halfwidth;
+	  // the cached offset from polygon midpoint to middle of
+	  // left lane boundary minus width of car.
+
+	  float lane_space = edge_geo_[poly_id].lane_space;
 	  float error_offset = 0.0;
 	  if (lane_space > 0.0)		// any room in this lane?
 	    error_offset = offset_ratio * lane_space;
-          ROS_DEBUG("error offset %.3f, half lane width %.3f, ratio %.3f",
-		    error_offset, half_lane_width, offset_ratio);
+          ROS_DEBUG("error offset %.3f, lane space %.3f, ratio %.3f",
+		    error_offset, lane_space, offset_ratio);
 
 	  // Increasing error term pushes right, decreasing left.
 	  error -= error_offset;
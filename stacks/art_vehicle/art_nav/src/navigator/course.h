@@ -12,11 +12,13 @@
 #ifndef _COURSE_HH_
 #define _COURSE_HH_
 
+#include <map>
 #include <vector>
 
 #include <art/infinity.h>
 #include <art_msgs/ArtLanes.h>
 #include <art_map/coordinates.h>
+#include <art_map/WayPointIndex.h>
 #include <art_map/zones.h>
 
 #include "Controller.h"
@@ -63,6 +65,15 @@ class Course
   /** @brief Course class termination for run state cycle. */
   void end_run_cycle(void);
 
+  /** @brief index in plan of the polygon closest to the estimated pose
+   *
+   *  Memoized for the current run cycle and plan version, so the
+   *  controllers needing it each cycle share a single search.
+   *
+   *  @return index in plan, -1 if plan empty
+   */
+  int closest_plan_index(void);
+
   /** find the index in lane of a polygon to aim for ahead of the car
    *  (returns -1 if none)
    */
@@ -74,6 +85,18 @@ class Course
   /** @brief Find a path in the travel lane to the next few way-points. */
   void find_travel_lane(bool rejoin);
 
+  /** @brief extend the previous plan after the order way-points
+   *  shifted forward
+   *
+   *  Commander shifts the order way-points left one at a time as they
+   *  are reached, so most replans only need the polygons for the new
+   *  final leg.  Reuses the polygons already in the plan instead of
+   *  rescanning the whole lane list for every leg.
+   *
+   *  @return true if the plan was updated incrementally
+   */
+  bool extend_plan(void);
+
   /** @brief return true if pose is in the current travel lane */
   bool in_lane(const MapPose &pose) const
   {
@@ -105,9 +128,24 @@ class Course
    */
   void lanes_message(const art_msgs::ArtLanes &lanes);
 
+  /** @brief handle lanes data already deserialized into poly records
+   *
+   *  For subscribers using art_map::PolyLanes, which skips the
+   *  intermediate message representation entirely.
+   *
+   * @param lane_polys polygons received for the local road map
+   */
+  void lanes_message(const poly_list_t &lane_polys);
+
   /** @brief log a vector of polygons */
   void log(const char *str, const poly_list_t &polys);
 
+  /** @brief record a plan decision in the flight recorder
+   *
+   *  @param label static string naming the decision
+   */
+  void record_plan(const char *label);
+
   /** @brief confirm that the next way-point was reached */
   void new_waypoint_reached(ElementID new_way)
   {
@@ -170,6 +208,14 @@ class Course
    */
   float stop_waypt_distance(bool same_lane);
 
+  /** @brief speed limit from the precomputed stop approach ramp
+   *
+   * @param distance remaining distance to the stop way-point
+   * @return fastest speed from which a constant-deceleration stop
+   *	     still fits in that distance
+   */
+  float stop_approach_speed_limit(float distance);
+
   /** @brief set turn signal for passing */
   void signal_pass(void)
   {
@@ -265,6 +311,9 @@ class Course
   // public class data
   poly_list_t polygons;			//< all polygons for local area
   poly_list_t plan;			//< planned course
+  int plan_version;			//< incremented when plan changes,
+					//  so controllers can cache
+					//  plan-derived tables
 
   poly_list_t passed_lane;		//< original lane being passed
   bool passing_left;			//< when passing, true if to left
@@ -276,7 +325,19 @@ class Course
 					//  (none if its poly_id = -1)
   ZonePerimeterList zones;
 
-  
+  /** @brief zone perimeter for a zone ID, from a one-entry cache
+   *
+   *  Zones are fixed once the RNDF is loaded, so the linear scan and
+   *  perimeter vector copy inside ZoneOps::get_zone_by_id() run only
+   *  when the requested ID changes or set_zones() replaces the list.
+   *  The reference stays valid until the next call.
+   */
+  const ZonePerimeter &zone_perimeter(segment_id_t zone_id);
+
+  /** @brief replace the zone list, invalidating the perimeter cache */
+  void set_zones(const ZonePerimeterList &_zones);
+
+
   float max_speed_for_slow_down(const float& final_speed,
 				const float& distance,
 				const float& max, 
@@ -303,19 +364,128 @@ class Course
 
  private:
 
+  /** @brief rebuild indexes after new lane polygons arrive */
+  void lanes_received(void);
+
   // Internal state.  Some of these vectors are class variables to
   // minimize dynamic memory allocation, instead of making them
   // automatic.
   ElementID plan_waypt[art_msgs::Order::N_WAYPTS]; //< waypts in the plan
+  poly_list_t edge_polys_;		//< scratch list reused every
+					//  cycle by desired_heading()
+					//  and find_aim_polygon()
+  int plan_covered;			//< last waypt index plan reached
+					//  (-1 if not built by
+					//  find_travel_lane)
   bool new_plan_lanes;			//< new lanes since plan made
   bool waypoint_checked;
   int poly_index;			// index in polygons of odom pose
 
+  // way-point cursor: cached polygon index and pose for waypt[1],
+  // recomputed only when the order advances past a way-point or new
+  // lane polygons arrive, so per-cycle reached tests are O(1)
+  ElementID w1_id_;			// way-point the cursor tracks
+  int w1_index_;			// its polygon index (-1 if none)
+  MapPose w1_pose_;			// way-point pose w/ lane heading
+
+  /** @brief update the way-point cursor for order->waypt[1] */
+  void update_waypt_cursor(void);
+
+  // one-entry cache for zone_perimeter()
+  ZonePerimeter cached_zone_;		// last zone returned
+  segment_id_t cached_zone_id_;		// ID it was requested for
+  bool zone_cache_valid_;		// cached_zone_ matches zones
+
+  // memoized closest_plan_index() state
+  bool closest_plan_cached_;		// cache valid this cycle
+  int closest_plan_index_;		// cached index in plan
+  int closest_plan_version_;		// plan_version when cached
+
+  // precomputed stop way-point approach profile, rebuilt by
+  // stop_waypt_distance() when the stop way-point or plan changes
+  ElementID stop_profile_id_;		// way-point profiled (null if none)
+  int stop_profile_version_;		// plan_version when built
+  int stop_profile_index_;		// plan polygon of the stop point
+  float stop_profile_end_;		// stop point offset from trailing
+					//  edge of its polygon
+  poly stop_profile_poly_;		// polygon containing stop waypt
+  std::vector<float> stop_profile_dist_; // arc length to stop point from
+					 //  each plan polygon's leading edge
+  std::vector<float> stop_profile_ramp_; // sampled deceleration speed ramp
+
+  // per-plan lane edge geometry, rebuilt when the plan changes:
+  // lateral clearances derived from each plan polygon's boundary
+  // points, so offset steering need not rederive them every cycle
+  struct lane_edge_geo
+  {
+    float width;			// width of the leading edge
+    float lane_space;			// offset room beside lane center
+  };
+  std::vector<lane_edge_geo> edge_geo_;
+  int edge_geo_version_;		// plan_version when built
+
+  // Compiled path spline, rebuilt when the plan changes: heading and
+  // curvature along the plan center line, smoothed with central
+  // differences and resampled at uniform arc-length steps.  Per-cycle
+  // heading evaluation becomes a constant-time table read instead of
+  // the quantized per-segment midpoint headings the pilot then has to
+  // smooth out.
+  std::vector<float> spline_mid_s_;	// arc length at each plan midpoint
+  std::vector<float> spline_heading_;	// unwrapped heading, uniform steps
+  std::vector<float> spline_curvature_;	// curvature (1/m), uniform steps
+  int spline_version_;			// plan_version when built
+  unsigned spline_plan_size_;		// plan.size() when built
+  int spline_first_id_;			// first and last plan poly_id
+  int spline_last_id_;			//  when built: staleness check
+					//  against plan contents, in
+					//  case a version bump is missed
+
+  /** @brief rebuild the path spline for the current plan */
+  void build_path_spline(void);
+
+  /** @brief smoothed heading and curvature at a plan segment
+   *
+   *  Evaluates the compiled spline at the arc length of the segment
+   *  from plan polygon @a index to the next one, rebuilding the
+   *  spline first if the plan changed.
+   *
+   *  @return false when no spline is available (short or empty plan);
+   *          callers fall back to the discrete segment heading.
+   */
+  bool spline_heading_at(int index, float &heading, float &curvature);
+
+  /** @brief rebuild edge_geo_ for the current plan */
+  void build_edge_geometry(void);
+
+  /** @brief build the stop approach profile for stop_waypt */
+  void build_stop_profile(void);
+
+  /** @brief distance to the stop point using the profile table */
+  float stop_profile_distance(const MapPose &pose);
+
   // Passing lane selection data.
   ElementID adj_lane[2];		// adjacent lane IDs
   poly_list_t adj_polys[2];		// adjacent lanes in segment
   int passing_lane;			// index of passing lane (or -1)
 
+  // per-lane polygon index, rebuilt when new lane polygons arrive:
+  // maps lane ID (pt 0) to that lane's polygons in list order
+  typedef std::map<ElementID, poly_list_t> lane_table_t;
+  lane_table_t lane_table_;
+
+  // way-point hash index over polygons, rebuilt when new lane
+  // polygons arrive and attached to pops, so the bursts of
+  // way-point resolutions a replan triggers are table lookups
+  WayPointIndex waypt_index_;
+
+  /** @brief append cached polygons for a lane
+   *
+   *  Table lookup replacement for PolyOps::AddLanePolys and
+   *  AddReverseLanePolys, using the index built by lanes_message().
+   */
+  void add_lane_polys(poly_list_t &to_polys, ElementID id,
+		      bool reverse) const;
+
   // saved order way-points for road block
   ElementID saved_waypt_id[art_msgs::Order::N_WAYPTS];
   int saved_replan_num;
@@ -112,6 +112,8 @@ void Estop::Add(NavEstopEvent::event_t event, action_t action,
 
 Controller::result_t Estop::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "Estop");
+
   event = current_event();
 
   // state transition table pointer
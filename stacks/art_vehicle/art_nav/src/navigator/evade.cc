@@ -59,6 +59,50 @@ void Evade::configure()
   halt->configure(cf, section);
   lane_edge->configure(cf, section);
   safety->configure(cf, section);
+
+  build_maneuvers();
+  ART_MSG(2, "\tevade maneuver library has %u entries",
+	  (unsigned) maneuvers_.size());
+}
+
+// Build the evasive maneuver library.
+//
+// One entry per entry-speed band.  Each maneuver tracks the
+// configured lane offset at a fixed speed chosen for its band, so
+// triggering an evade selects a stored entry instead of deriving the
+// maneuver reactively, and the commands stay deterministic while the
+// oncoming car closes.  Lane width scaling is inherent: offset_ratio
+// is normalized against the available lane space downstream.
+//
+void Evade::build_maneuvers(void)
+{
+  // entry speed band upper bounds (m/s); the last band is unbounded
+  static const float band_limit[] = {2.5, 5.0, 10.0, 999.0};
+  int nbands = sizeof(band_limit) / sizeof(band_limit[0]);
+
+  maneuvers_.clear();
+  for (int i = 0; i < nbands; ++i)
+    {
+      evade_maneuver_t m;
+      m.max_entry_speed = band_limit[i];
+
+      // never accelerate toward the approaching car: track the
+      // lesser of the evasion speed and the band entry speed, but
+      // keep moving
+      m.speed = fmaxf(fminf(evasion_speed, band_limit[i]), 1.0);
+      m.offset_ratio = evade_offset_ratio;
+      maneuvers_.push_back(m);
+    }
+}
+
+// return index of the maneuver for this entry speed
+int Evade::select_maneuver(float entry_speed)
+{
+  int i = 0;
+  while (i < (int) maneuvers_.size() - 1
+	 && entry_speed > maneuvers_.at(i).max_entry_speed)
+    ++i;
+  return i;
 }
 
 // This controller is called from Road when a car is approaching in
@@ -81,6 +125,9 @@ Controller::result_t Evade::control(pilot_command_t &pcmd)
       // Initial state of the Evade controller, reached via reset().
       if (verbose)
 	ART_MSG(1, "Begin emergency obstacle evasion");
+      // select the stored maneuver for the current speed band
+      active_maneuver_ =
+	select_maneuver(fabsf(estimate->twist.twist.linear.x));
       course->turn_signal_on(false);	// signal right
       set_state(Leave);
       // fall through
@@ -154,13 +201,14 @@ Controller::result_t Evade::control(pilot_command_t &pcmd)
 // returns: safety controller result
 Controller::result_t Evade::leave_lane_right(pilot_command_t &pcmd)
 {
-  // go slowly while leaving lane
-  pcmd.velocity = fminf(pcmd.velocity, evasion_speed);
+  // track the maneuver selected when the evasion triggered
+  evade_maneuver_t m = maneuvers_.at(active_maneuver_);
+  pcmd.velocity = fminf(pcmd.velocity, m.speed);
 
   result_t result = Unsafe;
   if (obstacle->observer_clear(ObserverID::Adjacent_right))
     {
-      result = lane_edge->control(pcmd, evade_offset_ratio);
+      result = lane_edge->control(pcmd, m.offset_ratio);
       if (result < Unsafe)
 	{
 	  // evade right did not stop immediately
@@ -188,6 +236,7 @@ void Evade::reset_me(void)
 {
   evade_timer->Cancel();
   state = Init;
+  active_maneuver_ = 0;
 }
 
 // perform state transition
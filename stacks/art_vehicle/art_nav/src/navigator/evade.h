@@ -12,6 +12,8 @@
 #ifndef __EVADE_HH__
 #define __EVADE_HH__
 
+#include <vector>
+
 class Halt;
 class LaneEdge;
 class Safety;
@@ -45,6 +47,18 @@ private:
 
   state_t state;			// current FSM state
 
+  // precomputed evasive maneuver, selected by entry speed band when
+  // the evasion triggers and tracked unchanged until reset
+  typedef struct
+  {
+    float max_entry_speed;		// band upper bound (m/s)
+    float speed;			// speed to track while leaving
+    float offset_ratio;			// lateral offset to track
+  } evade_maneuver_t;
+
+  std::vector<evade_maneuver_t> maneuvers_; // library built by configure()
+  int active_maneuver_;			// index selected at trigger time
+
   NavTimer *evade_timer;
 
   // subordinate controllers
@@ -52,8 +66,10 @@ private:
   LaneEdge *lane_edge;
   Safety *safety;
 
+  void build_maneuvers(void);
   Controller::result_t leave_lane_right(pilot_command_t &pcmd);
   void reset_me(void);
+  int select_maneuver(float entry_speed);
   void set_state(state_t newstate);
 };
 
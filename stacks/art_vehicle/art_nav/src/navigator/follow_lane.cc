@@ -140,6 +140,8 @@ FollowLane::~FollowLane()
 //
 Controller::result_t FollowLane::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "FollowLane");
+
   if (order->waypt[1].is_perimeter)
     pcmd.velocity=fminf(pcmd.velocity,1.0); //Make this config
 
@@ -196,6 +198,10 @@ Controller::result_t FollowLane::control(pilot_command_t &pcmd)
   if (course->plan.empty())
     nav->reduce_speed_with_min(pcmd, config_->lost_speed);
 
+  // the stop area check only matters when a stopping point or
+  // intersection is coming up; otherwise let it idle at reduced rate
+  stop_area->set_active(way_table[wtype].do_stop || in_intersection);
+
   bool in_safety_area = (in_intersection
 			 || stop_area->control(pcmd) == OK);
 
@@ -40,11 +40,13 @@ FollowSafely::~FollowSafely() {};
 //
 Controller::result_t FollowSafely::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "FollowSafely");
+
   bool was_blocked = navdata->lane_blocked;
   navdata->lane_blocked = false;
 
   result_t result = OK;
-  art_msgs::Observation fobs =
+  const Obstacle::obs_digest_t &fobs =
     obstacle->observation(art_msgs::Observation::Nearest_forward);
 
   ROS_DEBUG("Nearest_forward: C%d A%d, dist %.3f, time %.3f, vel %.3f",
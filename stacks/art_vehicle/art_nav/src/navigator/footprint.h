@@ -0,0 +1,239 @@
+/* -*- mode: C++ -*-
+ *
+ *  Navigator precomputed vehicle footprint
+ *
+ *  Copyright (C) 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef __FOOTPRINT_HH__
+#define __FOOTPRINT_HH__
+
+#include <art/infinity.h>
+#include <art_msgs/ArtVehicle.h>
+#include <art_map/coordinates.h>
+
+/** @brief Precomputed vehicle footprint.
+ *
+ *  Controllers used to rebuild vehicle-outline geometry from
+ *  art_msgs::ArtVehicle dimensions every time they tested clearance.
+ *  This class does that work once at start-up: the outline hull, and
+ *  the swept volume of each discrete steering arc the navigator
+ *  actually commands (hard or half steering lock either way, and
+ *  straight ahead).  A clearance test then reduces to transforming
+ *  an obstacle point into the vehicle frame and comparing it against
+ *  the precomputed bounds, cheap enough to run over every point the
+ *  obstacle bins return.
+ *
+ *  The vehicle outline is a rectangle in the vehicle frame, so the
+ *  hull containment test is just four compares.  Each curved swept
+ *  volume is an annulus about the corresponding turning circle
+ *  center, bounded by the nearest and farthest hull corners.
+ */
+class VehicleFootprint
+{
+public:
+
+  // the discrete steering arcs we command
+  typedef enum
+    {
+      MaxRight,				// hard right steering lock
+      HalfRight,			// half right lock
+      Straight,				// wheels centered
+      HalfLeft,				// half left lock
+      MaxLeft,				// hard left steering lock
+      N_ARCS
+    } arc_t;
+
+  VehicleFootprint()
+  {
+    using art_msgs::ArtVehicle;
+
+    // outline hull: vehicle-frame bounding rectangle
+    hx_min_ = ArtVehicle::rear_bumper_px;
+    hx_max_ = ArtVehicle::front_bumper_px;
+    hy_ = ArtVehicle::halfwidth;
+
+    // steering angle commanded for each arc (degrees)
+    static const float arc_fraction[N_ARCS] = {-1.0, -0.5, 0.0, 0.5, 1.0};
+
+    for (int i = 0; i < N_ARCS; ++i)
+      {
+	arcs_[i].steer_degrees =
+	  arc_fraction[i] * ArtVehicle::max_steer_degrees;
+
+	if (i == Straight)		// infinite radius
+	  {
+	    arcs_[i].center_y = 0.0;
+	    arcs_[i].radius = 0.0;
+	    arcs_[i].inner2 = 0.0;
+	    arcs_[i].outer2 = 0.0;
+	    arcs_[i].lead_phi = 0.0;
+	    arcs_[i].trail_phi = 0.0;
+	    continue;
+	  }
+
+	// bicycle-model turning circle center, on the y axis through
+	// the rear axle, positive to the left
+	float radius =
+	  (ArtVehicle::wheelbase
+	   / tanf(angles::from_degrees(fabsf(arcs_[i].steer_degrees))));
+	arcs_[i].radius = radius;
+	arcs_[i].center_y = (arcs_[i].steer_degrees > 0.0? radius: -radius);
+
+	// swept annulus: nearest and farthest hull corners
+	float inner = fmaxf(0.0, radius - hy_);
+	arcs_[i].inner2 = inner * inner;
+	float outer = 0.0;
+	float xs[2] = {hx_min_, hx_max_};
+	float ys[2] = {-hy_, hy_};
+	for (int cx = 0; cx < 2; ++cx)
+	  for (int cy = 0; cy < 2; ++cy)
+	    {
+	      float dx = xs[cx];
+	      float dy = ys[cy] - arcs_[i].center_y;
+	      outer = fmaxf(outer, dx*dx + dy*dy);
+	    }
+	arcs_[i].outer2 = outer;
+
+	// angle subtended by the hull ahead of and behind the origin
+	// along this circle, so arc distances measure from the bumper
+	arcs_[i].lead_phi = atan2f(hx_max_, radius);
+	arcs_[i].trail_phi = atan2f(-hx_min_, radius);
+      }
+  }
+
+  ~VehicleFootprint() {};
+
+  /** @brief nearest precomputed arc for a commanded steering angle */
+  arc_t nearest_arc(float steer_degrees) const
+  {
+    arc_t best = Straight;
+    float best_err = Infinite::distance;
+    for (int i = 0; i < N_ARCS; ++i)
+      {
+	float err = fabsf(steer_degrees - arcs_[i].steer_degrees);
+	if (err < best_err)
+	  {
+	    best_err = err;
+	    best = (arc_t) i;
+	  }
+      }
+    return best;
+  }
+
+  /** @brief true if a map point lies within the vehicle outline
+   *  @param pose vehicle pose in map coordinates
+   *  @param point map point to test
+   */
+  bool contains(const MapPose &pose, const MapXY &point) const
+  {
+    float vx, vy;
+    to_vehicle(pose, point, vx, vy);
+    return (vx >= hx_min_ && vx <= hx_max_ && fabsf(vy) <= hy_);
+  }
+
+  /** @brief arc distance until the footprint first touches a point
+   *
+   *  @param pose vehicle pose in map coordinates
+   *  @param arc precomputed steering arc to sweep along
+   *  @param points obstacle points to test (map coordinates)
+   *  @param reverse true when travelling backwards along the arc
+   *  @return distance along the arc, measured at the turning circle
+   *	through the rear axle, before the swept volume reaches the
+   *	nearest point; zero if already touching,
+   *	Infinite::distance if no point lies in the swept volume.
+   */
+  float arc_to_hit(const MapPose &pose, arc_t arc,
+		   const mapxy_list_t &points,
+		   bool reverse = false) const
+  {
+    float min_hit = Infinite::distance;
+    const arc_data_t &a = arcs_[arc];
+    for (unsigned i = 0; i < points.size(); ++i)
+      {
+	float vx, vy;
+	to_vehicle(pose, points.at(i), vx, vy);
+
+	if (arc == Straight)
+	  {
+	    if (fabsf(vy) > hy_)
+	      continue;			// outside the swept lane
+	    if (reverse)
+	      {
+		if (vx > hx_min_)
+		  continue;		// not behind the car
+		min_hit = fminf(min_hit, hx_min_ - vx);
+	      }
+	    else
+	      {
+		if (vx < hx_max_)
+		  continue;		// not ahead of the car
+		min_hit = fminf(min_hit, vx - hx_max_);
+	      }
+	    continue;
+	  }
+
+	// curved arc: annulus membership first
+	float dx = vx;
+	float dy = vy - a.center_y;
+	float d2 = dx*dx + dy*dy;
+	if (d2 < a.inner2 || d2 > a.outer2)
+	  continue;			// outside the swept annulus
+
+	// angular travel from the vehicle origin to the point, in
+	// the direction of motion around the turning circle
+	float origin_bearing = (a.center_y > 0.0? -HALFPI: HALFPI);
+	float phi = atan2f(dy, dx) - origin_bearing;
+	if (a.center_y < 0.0)		// turning right
+	  phi = -phi;
+	if (reverse)			// backing up
+	  phi = -phi;
+	while (phi < 0.0)
+	  phi += TWOPI;
+
+	// measure from the end of the hull, not the origin
+	float lead = (reverse? a.trail_phi: a.lead_phi);
+	min_hit = fminf(min_hit, fmaxf(0.0, (phi - lead) * a.radius));
+      }
+    return min_hit;
+  }
+
+private:
+
+  // outline hull: vehicle-frame bounding rectangle
+  float hx_min_;			// rear bumper x
+  float hx_max_;			// front bumper x
+  float hy_;				// half vehicle width
+
+  // precomputed swept volume of one steering arc
+  typedef struct
+  {
+    float steer_degrees;		// commanded steering angle
+    float center_y;			// turning circle center (signed)
+    float radius;			// turning circle radius
+    float inner2;			// swept annulus inner radius^2
+    float outer2;			// swept annulus outer radius^2
+    float lead_phi;			// hull angle ahead of origin
+    float trail_phi;			// hull angle behind origin
+  } arc_data_t;
+
+  arc_data_t arcs_[N_ARCS];
+
+  // transform a map point into the vehicle frame
+  void to_vehicle(const MapPose &pose, const MapXY &point,
+		  float &vx, float &vy) const
+  {
+    float cy = cosf(pose.yaw);
+    float sy = sinf(pose.yaw);
+    float dx = point.x - pose.map.x;
+    float dy = point.y - pose.map.y;
+    vx = cy*dx + sy*dy;
+    vy = -sy*dx + cy*dy;
+  }
+};
+
+#endif // __FOOTPRINT_HH__
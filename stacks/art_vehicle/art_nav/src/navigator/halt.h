@@ -14,25 +14,110 @@
 
 #include "course.h"
 
+/** @brief Halt controller.
+ *
+ *  Stops the vehicle along a precomputed deceleration profile instead
+ *  of commanding an immediate zero, so stopping distance depends only
+ *  on the selected profile, not on how the pilot happens to shape a
+ *  step input.  The profiles are built ahead of time, one per
+ *  initial-speed band, so each control cycle does just a band lookup
+ *  and one subtraction.
+ */
 class Halt: public Controller
 {
 public:
 
   Halt(Navigator *navptr, int _verbose):
-    Controller(navptr, _verbose) {};
+    Controller(navptr, _verbose)
+  {
+    last_cmd_ = 0.0;
+    build_profiles();
+  };
 
   ~Halt() {};
 
-  // halt immediately
+  // halt following the precomputed profile for the current speed band
   result_t control(pilot_command_t &pcmd)
   {
     course->no_waypoint_reached();
-    pcmd.velocity = 0.0;
+
+    // rebuild the profile table if deceleration parameters changed
+    // (rare), keeping every Halt instance current without a
+    // configure() cascade through all the parent controllers
+    if (profile_stop_decel_ != config_->stop_deceleration
+	|| profile_halt_decel_ != config_->halt_deceleration)
+      build_profiles();
+
+    float speed = fabsf(odom->twist.twist.linear.x);
+    int band = profile_band(speed);
+
+    if (last_cmd_ <= Epsilon::speed && speed >= Epsilon::speed)
+      // engaging while the vehicle is moving: report the profile
+      // selected, its stop distance bounds the safety case
+      ROS_DEBUG("halt engaged at %.2f m/s: %.2f m/s^2 profile,"
+		" stops within %.1f m",
+		speed, profile_[band].decel, profile_[band].distance);
+
+    // one step down the deceleration ramp for this band
+    pcmd.velocity = fmaxf(0.0, speed - profile_[band].step);
     pcmd.yawRate = 0.0;
+    last_cmd_ = pcmd.velocity;
     return OK;
   };
 
 private:
+
+  // number of initial-speed bands profiled
+  static const int N_bands = 4;
+
+  /** one precomputed stopping profile */
+  typedef struct
+  {
+    float top_speed;			///< band upper bound (m/s)
+    float decel;			///< deceleration used (m/s^2)
+    float step;				///< velocity decrement per cycle (m/s)
+    float distance;			///< stop distance from top_speed (m)
+  } stop_profile_t;
+
+  /** Build the per-band stopping profiles.
+   *
+   *  Deceleration ramps from the normal stopping rate in the lowest
+   *  band up to the emergency halt rate in the highest, so creeping
+   *  stops stay smooth while a halt from road speed uses the brakes
+   *  fully.
+   */
+  void build_profiles(void)
+  {
+    // band upper bounds; the last covers any speed the vehicle reaches
+    static const float bounds[N_bands] = {2.0, 5.0, 9.0, 26.0};
+
+    profile_stop_decel_ = config_->stop_deceleration;
+    profile_halt_decel_ = config_->halt_deceleration;
+    float lo = profile_stop_decel_;
+    float hi = fmaxf(lo, profile_halt_decel_);
+    for (int i = 0; i < N_bands; ++i)
+      {
+	profile_[i].top_speed = bounds[i];
+	profile_[i].decel = lo + (hi - lo) * i / (N_bands - 1);
+	profile_[i].step = profile_[i].decel / art_msgs::ArtHertz::NAVIGATOR;
+	profile_[i].distance = (bounds[i] * bounds[i]
+				/ (2.0 * profile_[i].decel));
+      }
+  }
+
+  /** band of the profile table covering @a speed */
+  int profile_band(float speed) const
+  {
+    for (int i = 0; i < N_bands - 1; ++i)
+      if (speed <= profile_[i].top_speed)
+	return i;
+    return N_bands - 1;
+  }
+
+  stop_profile_t profile_[N_bands];	///< per-band stopping profiles
+  float profile_stop_decel_;		///< stop_deceleration when built
+  float profile_halt_decel_;		///< halt_deceleration when built
+  float last_cmd_;			///< previous velocity command
 };
 
 #endif // __HALT_HH__
@@ -0,0 +1,36 @@
+/* -*- mode: C++ -*-
+ *
+ *  Navigator cycle timing statistics
+ *
+ *  Copyright (C) 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef _NAV_TIMING_HH_
+#define _NAV_TIMING_HH_
+
+#include <art/profiler.h>
+
+/** @brief Navigator node timing statistics class.
+ *
+ *  A thin wrapper around the art_common section profiler, keeping
+ *  the navigator's original interface: the nested Scope class times
+ *  one Controller::control() invocation, and to_message() builds the
+ *  node's diagnostics message with the "navigator" prefix.
+ */
+class NavTiming: public Profiler
+{
+ public:
+
+  /** @brief Fill a diagnostics message with the accumulated histograms. */
+  void to_message(diagnostic_msgs::DiagnosticArray &msg) const
+  {
+    msg.status.clear();
+    Profiler::to_message(msg, "navigator");
+  }
+};
+
+#endif // _NAV_TIMING_HH_
@@ -19,6 +19,9 @@
 // subordinate controller classes
 #include "estop.h"
 
+// cycle budget pressure, shared by all controllers (see Controller.h)
+bool Controller::cycle_pressure_ = false;
+
 /** Main ART navigator class.
 
     The Navigator class instantiates some infrastructure and the
@@ -74,6 +77,9 @@ Navigator::~Navigator()
  */
 pilot_command_t Navigator::navigate(void)
 {
+  // time the whole cycle as well as the individual controllers
+  NavTiming::Scope timing_scope(&timing, "navigate");
+
   pilot_command_t pcmd;			// pilot command to return
 
   // report whether odometry reports vehicle currently stopped
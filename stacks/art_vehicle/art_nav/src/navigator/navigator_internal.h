@@ -37,6 +37,9 @@
 
 #include <art_nav/NavBehavior.h>
 
+#include "nav_timing.h"
+#include "footprint.h"
+
 #include "art_nav/NavigatorConfig.h"
 typedef art_nav::NavigatorConfig Config;
 
@@ -76,6 +79,8 @@ public:
   // public data used by controllers
   art_msgs::Order order;               // current commander order
   art_msgs::NavigatorState navdata;    // current navigator state data
+  NavTiming timing;                    // controller timing statistics
+  VehicleFootprint footprint;          // precomputed vehicle outline
   nav_msgs::Odometry estimate;         // estimated control position
   nav_msgs::Odometry *odometry;
 
@@ -49,6 +49,10 @@ Obstacle::Obstacle(Navigator *_nav, int _verbose)
   // exception: initialize Nearest_forward not applicable
   obstate.obs[Observation::Nearest_forward].applicable = false;
 
+  // build the initial observation digest
+  for (unsigned i = 0; i < Observation::N_Observers; ++i)
+    digest_observation(obstate.obs[i]);
+
   // allocate timers
   blockage_timer = new NavTimer();
   was_stopped = false;
@@ -71,7 +75,7 @@ bool Obstacle::car_approaching()
     return false;
 
   Observation::_oid_type oid = Observation::Nearest_forward;
-  if (obstate.obs[oid].clear || !obstate.obs[oid].applicable)
+  if (obs_digest_[oid].clear || !obs_digest_[oid].applicable)
     {
       if (verbose >= 4)
 	ART_MSG(6, "no known car approaching from ahead");
@@ -80,7 +84,7 @@ bool Obstacle::car_approaching()
 
   // estimate absolute speed of obstacle from closing velocity and
   // vehicle speed
-  float rel_speed = obstate.obs[oid].velocity;
+  float rel_speed = obs_digest_[oid].velocity;
 #if 0
   // use vehicle speed at time of observation
   float abs_speed = rel_speed - obstate.odom.twist.twist.linear.x;
@@ -121,20 +125,21 @@ void Obstacle::closest_in_lane(const poly_list_t &lane,
       return;
     }
 
-#if 0 // ignoring obstacles at the moment
-  
-  for (uint i=0; i< lasers->all_obstacle_list.size(); i++)
-    if (in_lane(lasers->all_obstacle_list.at(i), lane, 0))
-      {
-	float distance = pops->distanceAlongLane(lane, estimate->pos,
-						 lasers->all_obstacle_list.at(i));					
-	if (distance < 0)
-	  behind = fminf(behind, -distance);
-	else
-	  ahead = fminf(ahead, distance);
-      }
-
-#endif // ignoring obstacles at the moment
+  // Query the binned obstacle store instead of intersecting every
+  // obstacle against the whole poly list.  The bins are empty until
+  // update_obstacles() runs with a new sensor update.
+  mapxy_list_t lane_obstacles;
+  obstacles_in_polys(lane, lane_obstacles);
+  MapXY here(estimate->pose.pose.position);
+  for (uint i = 0; i < lane_obstacles.size(); i++)
+    {
+      float distance = pops->distanceAlongLane(lane, here,
+					       lane_obstacles.at(i));
+      if (distance < 0)
+	behind = fminf(behind, -distance);
+      else
+	ahead = fminf(ahead, distance);
+    }
 
   ROS_DEBUG("Closest obstacles in lane %s are %.3fm ahead and %.3fm behind",
 	    lane.at(closest_poly_index).start_way.lane_name().str,
@@ -191,10 +196,46 @@ void
   for (uint32_t i = 0; i < obs_msg->obs.size(); ++i)
     {
       obstate.obs[obs_msg->obs[i].oid] = obs_msg->obs[i];
+      digest_observation(obs_msg->obs[i]);
       // TODO (maybe) track time stamps separately for each OID?
     }
 }
 
+// append obstacle points binned to any polygon in the given list
+void Obstacle::obstacles_in_polys(const poly_list_t &polys,
+				  mapxy_list_t &points) const
+{
+  for (uint i = 0; i < polys.size(); i++)
+    {
+      obstacle_bins_t::const_iterator bin =
+	obstacle_bins_.find(polys.at(i).poly_id);
+      if (bin == obstacle_bins_.end())
+	continue;
+      points.insert(points.end(), bin->second.begin(), bin->second.end());
+    }
+}
+
+// rebuild the spatial obstacle bins from a new set of points
+//
+// entry:
+//	points = obstacle locations from the latest sensor update
+// exit:
+//	obstacle_bins_ maps containing polygon ID to the points inside
+//	it; points outside every road polygon are dropped
+//
+void Obstacle::update_obstacles(const mapxy_list_t &points)
+{
+  obstacle_bins_.clear();
+  const poly_list_t &polys = course->polygons;
+  for (uint i = 0; i < points.size(); i++)
+    {
+      int index = pops->getContainingPoly(polys, points.at(i));
+      if (index < 0)
+	continue;			// not on any road polygon
+      obstacle_bins_[polys.at(index).poly_id].push_back(points.at(i));
+    }
+}
+
 // return true when observer reports passing lane clear
 bool Obstacle::passing_lane_clear(void)
 {
@@ -207,5 +248,6 @@ bool Obstacle::passing_lane_clear(void)
 // reset obstacle class
 void Obstacle::reset(void)
 {
+  obstacle_bins_.clear();
   unblocked();
 }
@@ -11,6 +11,7 @@
 #ifndef _OBSTACLE_HH_
 #define _OBSTACLE_HH_
 
+#include <map>
 #include <vector>
 #include "ntimer.h"
 
@@ -51,6 +52,22 @@ class Obstacle
     blockage_timer->Start(config_->blockage_timeout_secs);
   }
 
+  /** @brief observation digest, unpacked once per message
+   *
+   *  Plain copies of the observer fields the controllers consume, so
+   *  each cycle reads these instead of copying whole Observation
+   *  messages.
+   */
+  typedef struct
+  {
+    bool applicable;			//< observation applies
+    bool clear;				//< reports clear to go
+    float time;				//< time to obstacle (sec)
+    float distance;			//< distance to obstacle (m)
+    float velocity;			//< closing velocity (m/s)
+    int nobjects;			//< number of objects seen
+  } obs_digest_t;
+
   /** @brief is there a car approaching from ahead in our lane? */
   bool car_approaching();
 
@@ -67,16 +84,16 @@ class Obstacle
   /** @brief maximum scan range accessor. */
   float maximum_range(void) {return max_range;}
 
-  /** @brief return current observation state */
-  art_msgs::Observation observation(art_msgs::Observation::_oid_type oid)
+  /** @brief return current observation digest */
+  const obs_digest_t &observation(art_msgs::Observation::_oid_type oid) const
   {
-    return obstate.obs[oid];
+    return obs_digest_[oid];
   }
 
   /** @brief return true when observer reports clear to go */
   bool observer_clear(art_msgs::Observation::_oid_type oid)
   {
-    bool clear = obstate.obs[oid].clear && obstate.obs[oid].applicable;
+    bool clear = obs_digest_[oid].clear && obs_digest_[oid].applicable;
 
     // if waiting on observers, reset the blockage_timer
     if (!clear)
@@ -86,9 +103,21 @@ class Obstacle
 
   void observers_message(const art_msgs::ObservationArrayConstPtr obs_msg);
 
+  /** @brief append obstacle points binned to any polygon in @a polys */
+  void obstacles_in_polys(const poly_list_t &polys,
+                          mapxy_list_t &points) const;
+
   /** @brief return true when observer reports passing lane clear */
   bool passing_lane_clear(void);
 
+  /** @brief rebuild the spatial obstacle bins (once per sensor update)
+   *
+   *  Bins each obstacle point by the ID of its containing road
+   *  polygon, so each controller can query lane membership by index
+   *  lookup instead of rescanning the whole poly list per cycle.
+   */
+  void update_obstacles(const mapxy_list_t &points);
+
   /** @brief reset obstacles. */
   void reset(void);
 
@@ -128,6 +157,25 @@ class Obstacle
   // observers data
   art_msgs::ObservationArray obstate;   //< current observers state
 
+  // digest of obstate, rebuilt as messages arrive
+  obs_digest_t obs_digest_[art_msgs::Observation::N_Observers];
+
+  /** @brief unpack one observation into its digest entry */
+  void digest_observation(const art_msgs::Observation &obs)
+  {
+    obs_digest_t &digest = obs_digest_[obs.oid];
+    digest.applicable = obs.applicable;
+    digest.clear = obs.clear;
+    digest.time = obs.time;
+    digest.distance = obs.distance;
+    digest.velocity = obs.velocity;
+    digest.nobjects = obs.nobjects;
+  }
+
+  // obstacle points binned by containing polygon ID
+  typedef std::map<int, mapxy_list_t> obstacle_bins_t;
+  obstacle_bins_t obstacle_bins_;
+
   // blockage timer
   NavTimer *blockage_timer;
   bool was_stopped;			// previous cycle's stop state
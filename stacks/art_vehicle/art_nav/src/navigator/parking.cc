@@ -264,7 +264,20 @@ Controller::result_t PARK_control::control(pilot_command_t &pcmd,
   for(int i = 0; i < N_ORDER_WAYPTS; i++)
     new_waypts.push_back(order->waypt[i]);
 
-  if(find_a_better_spot) {
+  // The adjusted spot and approach goal pose depend only on the
+  // designated spot way-points, so compute them once when the spot is
+  // designated, then replay the cached plan until the order changes.
+  bool replay_approach = (approach_valid_
+			  && approach_id1_ == new_waypts[1].id
+			  && approach_id2_ == new_waypts[2].id);
+  if (replay_approach)
+    {
+      new_waypts = approach_waypts_;
+      state = approach_state_;
+      new_end_pose = approach_end_pose_;
+    }
+
+  if(!replay_approach && find_a_better_spot) {
     adjust_spot(new_waypts,
 		obstacle->lasers->all_obstacle_list,
 		find_spot_max_x_offset,
@@ -272,6 +285,8 @@ Controller::result_t PARK_control::control(pilot_command_t &pcmd,
 		find_spot_step_size);
   }
 
+  if (!replay_approach)
+    {
   if (!new_waypts[1].is_spot)
     state=hit_waypoint;
   else
@@ -283,6 +298,7 @@ Controller::result_t PARK_control::control(pilot_command_t &pcmd,
 	  new_waypts[1].id.pt==2 && new_waypts[2].id.pt==1)
 	state=pull_in;
       else state=pull_out;
+    }
 
   if (course->spot_ahead())
     spot_points=course->calculate_spot_points(new_waypts);
@@ -296,8 +312,9 @@ Controller::result_t PARK_control::control(pilot_command_t &pcmd,
 
 	// Try going striaght back, then various ways of backwards and
 	// turning.  Then forwards.
-	
-  
+
+  if (!replay_approach)
+    {
   switch (state)
     {
     case hit_waypoint:
@@ -352,9 +369,17 @@ Controller::result_t PARK_control::control(pilot_command_t &pcmd,
       }
       break;
     }
-  
 
-  
+  // save the approach plan for later cycles
+  approach_valid_ = true;
+  approach_id1_ = order->waypt[1].id;
+  approach_id2_ = order->waypt[2].id;
+  approach_state_ = state;
+  approach_waypts_ = new_waypts;
+  approach_end_pose_ = new_end_pose;
+    }
+
+
   pcmd.velocity=speed_limit;
   navdata->reverse=false;
   
@@ -489,6 +514,7 @@ void PARK_control::reset_me(void)
   last_park_dist=0.0;
   min_adj_dist=Infinite::distance;
   min_obst=10000;
+  approach_valid_=false;
 }
 
 
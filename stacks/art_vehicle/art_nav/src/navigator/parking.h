@@ -93,6 +93,15 @@ private:
   float lastYaw;
   std::vector<MapXY> spot_points;
   int min_obst;
+
+  // approach plan, computed once when the spot way-points are
+  // designated and replayed on later cycles
+  bool approach_valid_;			// plan below is usable
+  ElementID approach_id1_;		// way-points the plan was built for
+  ElementID approach_id2_;
+  state_t approach_state_;		// FSM state when plan was built
+  std::vector<WayPointNode> approach_waypts_; // adjusted way-points
+  player_pose2d_t approach_end_pose_;	// goal pose for the approach
 };
 
 #endif // __REED_SHEPP_HH__
@@ -46,6 +46,8 @@ Passing::~Passing()
 //	Finished, if original lane reached.
 Controller::result_t Passing::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "Passing");
+
 #if 0 // not doing avoid right now
   pilot_command_t incmd = pcmd;		// copy of original input
 #endif // not doing avoid right now
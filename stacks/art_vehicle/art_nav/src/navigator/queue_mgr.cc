@@ -9,13 +9,23 @@
 
 #include <unistd.h>
 
+#include <boost/thread.hpp>
 #include <dynamic_reconfigure/server.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 
+#include <art/cycle_deadline.h>
+#include <art/flight_recorder.h>
 #include <art/frames.h>
+#include <art/realtime.h>
 
+#include <art_msgs/BringupState.h>
+#include <art_msgs/DriverState.h>
 #include <art_msgs/IOadrCommand.h>
 #include <art_msgs/IOadrState.h>
+#include <art_msgs/PipelineEvent.h>
 #include <art/steering.h>
+#include <art_map/PolyLanes.h>
 #include <art_map/ZoneOps.h>
 
 #include <art_msgs/CarCommand.h>
@@ -25,6 +35,7 @@
 
 #include "navigator_internal.h"
 #include "course.h"
+#include "Controller.h"
 //#include "obstacle.h"
 
 /** @file
@@ -54,13 +65,15 @@ public:
 
   bool setup(ros::NodeHandle node);
   bool shutdown();
-  void spin(void);
+  void spin(bool embedded = false);
 
 private:
 
+  void announceBringup(uint8_t state, const char *detail);
+  void applySnapshots(void);
   void processNavCmd(const art_msgs::NavigatorCommand::ConstPtr &cmdIn);
   void processOdom(const nav_msgs::Odometry::ConstPtr &odomIn);
-  void processRoadMap(const art_msgs::ArtLanes::ConstPtr &cmdIn);
+  void processRoadMap(const art_map::PolyLanes::ConstPtr &cmdIn);
   void processRelays(const art_msgs::IOadrState::ConstPtr &sigIn);
   void PublishState(void);
   void reconfig(Config &newconfig, uint32_t level);
@@ -68,9 +81,12 @@ private:
   void SetSpeed(pilot_command_t pcmd);
 
   // ROS topics
+  ros::Publisher  bringup_state_;       // bringup readiness reports
   ros::Publisher  car_cmd_;             // pilot CarCommand
+  ros::Publisher  diagnostics_;         // controller timing diagnostics
   ros::Subscriber nav_cmd_;             // NavigatorCommand topic
   ros::Publisher  nav_state_;           // navigator state topic
+  ros::Publisher  trace_pub_;           // pipeline latency trace events
   ros::Subscriber odom_state_;          // odometry
   ros::Subscriber roadmap_;             // local road map polygons
   ros::Publisher  signals_cmd_;
@@ -87,36 +103,170 @@ private:
   // Odometry data
   nav_msgs::Odometry odom_msg_;
 
+  // Latest message snapshots, swapped in by the subscription
+  // callbacks (a shared pointer assignment, nothing more) and applied
+  // by the control cycle in applySnapshots().  A burst of messages
+  // between cycles costs at most one conversion, and navigate()
+  // always sees input from a single, consistent snapshot.
+  art_msgs::NavigatorCommand::ConstPtr latest_cmd_;
+  nav_msgs::Odometry::ConstPtr latest_odom_;
+  art_map::PolyLanes::ConstPtr latest_map_;
+
   // time stamps of latest messages received
   ros::Time cmd_time_;
   ros::Time map_time_;
 
+  // Intake instrumentation.  Each snapshot slot above is latest-wins:
+  // a message arriving before the previous one was applied overwrites
+  // it, so after a scheduling glitch the control cycle resumes from
+  // fresh data instead of chewing through stale backlog.  These
+  // counters record how often that happens and how old the inputs
+  // actually applied were, reported on the diagnostics topic.
+  uint32_t odom_received_;              // messages received per topic
+  uint32_t cmd_received_;
+  uint32_t map_received_;
+  uint32_t odom_dropped_;               // snapshots overwritten unapplied
+  uint32_t cmd_dropped_;
+  uint32_t map_dropped_;
+  uint32_t stale_cycles_;               // cycles run on stale odometry
+  double max_odom_age_;                 // max applied odometry age (s)
+
+  // sequence number of last order applied (commander numbers orders
+  // from one and repeats the current one as a low-rate heartbeat)
+  uint32_t last_order_seq_;
+
+  // E-stop fast path.  The subscription callback latches the behavior
+  // of any Pause, Quit or Abort order here, bypassing the snapshot
+  // queue.  SetSpeed() checks the latch before publishing, so an
+  // e-stop arriving while navigate() was computing this cycle's
+  // command still halts the vehicle this cycle; the state machine
+  // processes the order normally on the next applySnapshots().  A
+  // single aligned word, written by the callback and cleared by the
+  // control cycle, so no lock is needed.
+  volatile int32_t estop_latch_;
+
+  // state as last published, for change detection
+  art_msgs::NavigatorState last_navstate_;
+  ros::Time last_state_time_;
+
   // navigator implementation class
   Navigator *nav_;
 
+  // control cycle deadline monitor
+  CycleDeadline deadline_;
+
+  // Configurable control cycle rate and per-cycle time budget.  The
+  // compiled-in ArtHertz rate is the default; high-speed tests can
+  // raise it once the budget metrics show headroom.  When a cycle
+  // exceeds its budget (a fraction of the period), dormant
+  // controllers skip their reduced-rate refresh ticks until the
+  // cycle fits again.
+  double cycle_rate_;                   // control cycle rate (Hz)
+  double cycle_budget_;                 // budget, as fraction of period
+  unsigned long budget_overruns_;       // cycles exceeding the budget
+  double budget_util_total_;            // accumulated budget utilization
+
   // configuration callback
   dynamic_reconfigure::Server<Config> ccb_;
 };
 
 /** constructor */
-NavQueueMgr::NavQueueMgr()
+NavQueueMgr::NavQueueMgr():
+  deadline_(art_msgs::ArtHertz::NAVIGATOR)
 {
   signal_on_left_ = signal_on_right_ = false;
   flasher_on_ = alarm_on_ = false;
+  last_order_seq_ = 0;
+  estop_latch_ = art_msgs::Behavior::NONE;
+  odom_received_ = cmd_received_ = map_received_ = 0;
+  odom_dropped_ = cmd_dropped_ = map_dropped_ = 0;
+  stale_cycles_ = 0;
+  max_odom_age_ = 0.0;
+  cycle_rate_ = art_msgs::ArtHertz::NAVIGATOR;
+  cycle_budget_ = 0.8;
+  budget_overruns_ = 0;
+  budget_util_total_ = 0.0;
 
   // create control driver, declare dynamic reconfigure callback
   nav_ = new Navigator(&odom_msg_);
   ccb_.setCallback(boost::bind(&NavQueueMgr::reconfig, this, _1, _2));
 }
 
+/** Apply latest message snapshots.
+ *
+ *  Called by the control cycle after handling incoming messages, so
+ *  all per-message work happens here, once per cycle, no matter how
+ *  many messages arrived in between.
+ */
+void NavQueueMgr::applySnapshots(void)
+{
+  if (latest_cmd_)
+    {
+      cmd_time_ = latest_cmd_->header.stamp;
+      if (latest_cmd_->order.seq != last_order_seq_)
+        {
+          // new order, not just a heartbeat repeat of the current one
+          last_order_seq_ = latest_cmd_->order.seq;
+          nav_->order = latest_cmd_->order;
+        }
+      latest_cmd_.reset();
+
+      // The E-stop state machine sees the latest order this cycle,
+      // so the fast-path latch has served its purpose.
+      estop_latch_ = art_msgs::Behavior::NONE;
+    }
+
+  if (latest_odom_)
+    {
+      // note the age of the estimate actually driving this cycle: an
+      // input older than two control periods means the navigator is
+      // steering on stale state, however fast messages are arriving
+      double age = (ros::Time::now() - latest_odom_->header.stamp).toSec();
+      if (age > max_odom_age_)
+        max_odom_age_ = age;
+      if (age > 2.0 / cycle_rate_)
+        ++stale_cycles_;
+
+      odom_msg_ = *latest_odom_;
+      latest_odom_.reset();
+    }
+
+  if (latest_map_)
+    {
+      if (map_time_.isZero())
+        // first road map: the navigator is now ready for orders
+        announceBringup(art_msgs::DriverState::RUNNING,
+                        "road map received");
+      map_time_ = latest_map_->header.stamp;
+      nav_->course->lanes_message(latest_map_->polys);
+      latest_map_.reset();
+    }
+}
+
 /** Handle command input. */
 void NavQueueMgr::processNavCmd(const
                                 art_msgs::NavigatorCommand::ConstPtr &cmdIn)
 {
   ROS_DEBUG_STREAM("Navigator order:"
                    << NavBehavior(cmdIn->order.behavior).Name());
-  cmd_time_ = cmdIn->header.stamp;
-  nav_->order = cmdIn->order;
+  ++cmd_received_;
+  if (latest_cmd_)
+    ++cmd_dropped_;                     // previous snapshot never applied
+  latest_cmd_ = cmdIn;
+
+  // E-stop fast path: latch halt-demanding behaviors immediately, so
+  // SetSpeed() suppresses whatever command this cycle was already
+  // computing when the order arrived.
+  switch (cmdIn->order.behavior.value)
+    {
+    case NavBehavior::Abort:
+    case NavBehavior::Quit:
+    case NavBehavior::Pause:
+      estop_latch_ = cmdIn->order.behavior.value;
+      break;
+    default:
+      break;
+    }
 }
 
 /** Handle Odometry input. */
@@ -132,15 +282,20 @@ void NavQueueMgr::processOdom(const nav_msgs::Odometry::ConstPtr &odomIn)
 
   float vel = odomIn->twist.twist.linear.x;
   ROS_DEBUG("current velocity = %.3f m/sec, (%02.f mph)", vel, mps2mph(vel));
-  odom_msg_ = *odomIn;
+  ++odom_received_;
+  if (latest_odom_)
+    ++odom_dropped_;                    // previous snapshot never applied
+  latest_odom_ = odomIn;
 }
 
 /** Handle road map polygons. */
-void NavQueueMgr::processRoadMap(const art_msgs::ArtLanes::ConstPtr &mapIn)
+void NavQueueMgr::processRoadMap(const art_map::PolyLanes::ConstPtr &mapIn)
 {
-  ROS_DEBUG_STREAM(mapIn->polygons.size() << " lanes polygons received");
-  map_time_ = mapIn->header.stamp;
-  nav_->course->lanes_message(*mapIn);
+  ROS_DEBUG_STREAM(mapIn->polys.size() << " lanes polygons received");
+  ++map_received_;
+  if (latest_map_)
+    ++map_dropped_;                     // previous snapshot never applied
+  latest_map_ = mapIn;
 }
 
 /** Handle relays state message. */
@@ -201,6 +356,23 @@ bool NavQueueMgr::setup(ros::NodeHandle node)
   ros::TransportHints noDelay = ros::TransportHints().tcpNoDelay(true);
   static uint32_t qDepth = 1;
 
+  // Control cycle rate and budget fraction.  The budget is the share
+  // of the cycle period navigate() may use before dormant controller
+  // ticks get deferred; the remainder covers publishing and jitter.
+  ros::NodeHandle private_nh("~");
+  private_nh.param("cycle_rate", cycle_rate_,
+                   (double) art_msgs::ArtHertz::NAVIGATOR);
+  private_nh.param("cycle_budget", cycle_budget_, 0.8);
+  cycle_rate_ = fmax(1.0, cycle_rate_);
+  cycle_budget_ = fmax(0.1, fmin(1.0, cycle_budget_));
+  deadline_.set_rate(cycle_rate_);
+  if (cycle_rate_ != art_msgs::ArtHertz::NAVIGATOR)
+    ROS_INFO("navigator cycle rate %.1f Hz (budget %.0f%% of period)",
+             cycle_rate_, cycle_budget_ * 100.0);
+
+  // dump flight recorder rings on fault or SIGUSR1
+  FlightRecorder::install_handlers();
+
   // topics to read
   odom_state_ = node.subscribe("odom", qDepth,
                                &NavQueueMgr::processOdom, this, noDelay);
@@ -213,13 +385,41 @@ bool NavQueueMgr::setup(ros::NodeHandle node)
 
   // topics to write
   car_cmd_ = node.advertise<art_msgs::CarCommand>("pilot/cmd", qDepth);
+  bringup_state_ =
+    node.advertise<art_msgs::BringupState>("bringup/state", 1, true);
+  diagnostics_ =
+    node.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", qDepth);
   nav_state_ =
     node.advertise<art_msgs::NavigatorState>("navigator/state", qDepth);
   signals_cmd_ = node.advertise<art_msgs::IOadrCommand>("ioadr/cmd", qDepth);
+  trace_pub_ =
+    node.advertise<art_msgs::PipelineEvent>("pipeline_trace", qDepth);
+
+  // the navigator cannot do anything until maplanes sends a road map
+  announceBringup(art_msgs::DriverState::OPENED, "waiting for road map");
 
   return true;
 }
 
+/** Report this node's bringup readiness.
+ *
+ *  Published latched, so launch tooling subscribing late still sees
+ *  the current state.
+ *
+ *  @param state DriverState value: OPENED while waiting for inputs,
+ *               RUNNING once the first road map has been applied
+ *  @param detail short progress note for the operator
+ */
+void NavQueueMgr::announceBringup(uint8_t state, const char *detail)
+{
+  art_msgs::BringupState msg;
+  msg.header.stamp = ros::Time::now();
+  msg.node = ros::this_node::getName();
+  msg.state.state = state;
+  msg.detail = detail;
+  bringup_state_.publish(msg);
+}
+
 // Shutdown the node
 bool NavQueueMgr::shutdown()
 {
@@ -231,6 +431,10 @@ bool NavQueueMgr::shutdown()
   cmd.yawRate = 0.0;
   SetSpeed(cmd);
 
+  // dump accumulated controller timing and deadline statistics
+  nav_->timing.log_summary();
+  deadline_.log_summary("navigator");
+
 #if 0
   nav_->obstacle->lasers->unsubscribe_lasers();
   nav_->odometry->unsubscribe();
@@ -302,6 +506,15 @@ void NavQueueMgr::SetSpeed(pilot_command_t pcmd)
       return;
     }
 
+  if (estop_latch_ != art_msgs::Behavior::NONE)
+    {
+      // an e-stop order arrived after this cycle's snapshots were
+      // applied: halt now instead of publishing the computed command
+      ROS_INFO_THROTTLE(2, "E-stop order pending, halting immediately");
+      pcmd.velocity = 0.0;
+      pcmd.yawRate = 0.0;
+    }
+
   art_msgs::CarCommand cmd;
   cmd.header.stamp = ros::Time::now();
   cmd.header.frame_id = ArtFrames::vehicle;
@@ -315,11 +528,45 @@ void NavQueueMgr::SetSpeed(pilot_command_t pcmd)
     
   ROS_DEBUG("Navigator CMD_CAR (%.3f m/s, %.3f degrees)",
 	    cmd.control.velocity, cmd.control.angle);
-  
+
+  // flight recorder: the command actually sent to the pilot
+  ART_RECORD2("nav pilot cmd", cmd.control.velocity, cmd.control.angle);
+
   car_cmd_.publish(cmd);
 }
 
-/** Publish current navigator state data */
+/** Compare navigator state content, ignoring the header */
+static bool same_nav_state(const art_msgs::NavigatorState &a,
+			   const art_msgs::NavigatorState &b)
+{
+  return (a.estop.state == b.estop.state
+	  && a.road.state == b.road.state
+	  && ElementID(a.last_waypt) == ElementID(b.last_waypt)
+	  && ElementID(a.replan_waypt) == ElementID(b.replan_waypt)
+	  && a.cur_poly == b.cur_poly
+	  && a.alarm == b.alarm
+	  && a.flasher == b.flasher
+	  && a.lane_blocked == b.lane_blocked
+	  && a.road_blocked == b.road_blocked
+	  && a.reverse == b.reverse
+	  && a.signal_left == b.signal_left
+	  && a.signal_right == b.signal_right
+	  && a.stopped == b.stopped
+	  && a.have_zones == b.have_zones
+	  && a.last_order.replan_num == b.last_order.replan_num
+	  && a.last_order.behavior.value == b.last_order.behavior.value
+	  && ElementID(a.last_order.waypt[1].id)
+	     == ElementID(b.last_order.waypt[1].id));
+}
+
+/** Publish current navigator state data
+ *
+ *  The message itself lives in the Navigator class and is reused
+ *  across cycles.  It is published when its content changes, plus a
+ *  configurable low-rate heartbeat, instead of at full cycle rate:
+ *  idle at a stop line nothing changes, so fleet telemetry carries
+ *  the heartbeat only.
+ */
 void NavQueueMgr::PublishState(void)
 {
   nav_->navdata.header.stamp = ros::Time::now();
@@ -337,17 +584,39 @@ void NavQueueMgr::PublishState(void)
 	    ElementID(nav_->navdata.last_order.waypt[1].id).name().str,
 	    ElementID(nav_->navdata.last_order.chkpt[0].id).name().str);
 
+  double period = 1.0 / fmax(nav_->config_.state_heartbeat_hz, 0.1);
+  bool heartbeat_due =
+    ((nav_->navdata.header.stamp - last_state_time_).toSec() >= period);
+  if (!heartbeat_due && same_nav_state(nav_->navdata, last_navstate_))
+    return;				// unchanged, heartbeat not due
+
   // Publish this info for all subscribers
+  last_navstate_ = nav_->navdata;
+  last_state_time_ = nav_->navdata.header.stamp;
   nav_state_.publish(nav_->navdata);
 }
 
-/** Spin method for main thread */
-void NavQueueMgr::spin() 
+/** Spin method for main thread
+ *
+ *  @param embedded true when running inside a nodelet manager, whose
+ *                  threads already service our message callbacks
+ */
+void NavQueueMgr::spin(bool embedded)
 {
-  ros::Rate cycle(art_msgs::ArtHertz::NAVIGATOR);
+  // apply real-time scheduling configuration, if any
+  Realtime::configure("navigator");
+
+  ros::Rate cycle(cycle_rate_);
+  double budget = cycle_budget_ / cycle_rate_; // seconds per cycle
+  uint32_t cycle_count = 0;
   while(ros::ok())
     {
-      ros::spinOnce();                  // handle incoming messages
+      deadline_.begin();                // start of control cycle
+
+      if (!embedded)
+        ros::spinOnce();                // handle incoming messages
+
+      applySnapshots();                 // apply latest input snapshots
 
       // invoke appropriate Navigator method, pass result to Pilot
       SetSpeed(nav_->navigate());
@@ -356,6 +625,149 @@ void NavQueueMgr::spin()
 
       PublishState();
 
+      // report latency from the odometry estimate driving this cycle
+      // to publication of the resulting pilot command
+      art_msgs::PipelineEvent event;
+      event.header.stamp = ros::Time::now();
+      event.origin = odom_msg_.header.stamp;
+      event.node = "navigator";
+      event.topic = "odom";
+      trace_pub_.publish(event);
+
+      if (deadline_.end())              // end of control cycle
+        ROS_WARN_THROTTLE(10, "navigator cycle overran its deadline"
+                          " (%lu misses in %lu cycles)",
+                          deadline_.misses(), deadline_.cycles());
+
+      // Enforce the per-cycle budget.  When this cycle ran over,
+      // dormant controllers defer their refresh ticks next cycle; the
+      // pressure clears as soon as a cycle fits again.
+      double used = deadline_.last_duration() / budget;
+      budget_util_total_ += used;
+      bool over_budget = (used > 1.0);
+      if (over_budget)
+        ++budget_overruns_;
+      Controller::set_cycle_pressure(over_budget);
+
+      // publish controller timing diagnostics about once a second
+      if (++cycle_count >= (uint32_t) cycle_rate_)
+        {
+          cycle_count = 0;
+          diagnostic_msgs::DiagnosticArray diag_msg;
+          diag_msg.header.stamp = ros::Time::now();
+          nav_->timing.to_message(diag_msg);
+
+          // append cycle deadline status
+          diagnostic_msgs::DiagnosticStatus ds;
+          ds.name = "navigator: cycle deadline";
+          char summary[80];
+          snprintf(summary, sizeof(summary),
+                   "%lu of %lu cycles missed deadline",
+                   deadline_.misses(), deadline_.cycles());
+          ds.message = summary;
+          ds.level = (deadline_.misses() == 0?
+                      diagnostic_msgs::DiagnosticStatus::OK:
+                      diagnostic_msgs::DiagnosticStatus::WARN);
+          diagnostic_msgs::KeyValue kv;
+          char value[32];
+          kv.key = "deadline misses";
+          snprintf(value, sizeof(value), "%lu", deadline_.misses());
+          kv.value = value;
+          ds.values.push_back(kv);
+          kv.key = "max cycle (ms)";
+          snprintf(value, sizeof(value), "%.3f",
+                   deadline_.max_duration() * 1e3);
+          kv.value = value;
+          ds.values.push_back(kv);
+          kv.key = "mean jitter (ms)";
+          snprintf(value, sizeof(value), "%.3f",
+                   deadline_.mean_jitter() * 1e3);
+          kv.value = value;
+          ds.values.push_back(kv);
+          diag_msg.status.push_back(ds);
+
+          // append cycle budget utilization, so rate increases can be
+          // trialed against measured headroom
+          diagnostic_msgs::DiagnosticStatus bs;
+          bs.name = "navigator: cycle budget";
+          double mean_util = (deadline_.cycles()?
+                              budget_util_total_ / deadline_.cycles(): 0.0);
+          snprintf(summary, sizeof(summary),
+                   "mean %.0f%% of %.1fms budget, %lu overruns",
+                   mean_util * 100.0, budget * 1e3, budget_overruns_);
+          bs.message = summary;
+          bs.level = (budget_overruns_ == 0?
+                      diagnostic_msgs::DiagnosticStatus::OK:
+                      diagnostic_msgs::DiagnosticStatus::WARN);
+          kv.key = "cycle rate (hz)";
+          snprintf(value, sizeof(value), "%.1f", cycle_rate_);
+          kv.value = value;
+          bs.values.push_back(kv);
+          kv.key = "budget (ms)";
+          snprintf(value, sizeof(value), "%.3f", budget * 1e3);
+          kv.value = value;
+          bs.values.push_back(kv);
+          kv.key = "mean utilization (%)";
+          snprintf(value, sizeof(value), "%.1f", mean_util * 100.0);
+          kv.value = value;
+          bs.values.push_back(kv);
+          kv.key = "budget overruns";
+          snprintf(value, sizeof(value), "%lu", budget_overruns_);
+          kv.value = value;
+          bs.values.push_back(kv);
+          diag_msg.status.push_back(bs);
+
+          // append message intake status: how many inputs arrived,
+          // how many stale snapshots latest-wins intake dropped, and
+          // the worst odometry age actually applied
+          diagnostic_msgs::DiagnosticStatus intake;
+          intake.name = "navigator: message intake";
+          snprintf(summary, sizeof(summary),
+                   "%u stale messages dropped, %u stale cycles",
+                   odom_dropped_ + cmd_dropped_ + map_dropped_,
+                   stale_cycles_);
+          intake.message = summary;
+          intake.level = (stale_cycles_ == 0?
+                          diagnostic_msgs::DiagnosticStatus::OK:
+                          diagnostic_msgs::DiagnosticStatus::WARN);
+          kv.key = "odom received";
+          snprintf(value, sizeof(value), "%u", odom_received_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "odom dropped";
+          snprintf(value, sizeof(value), "%u", odom_dropped_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "cmd received";
+          snprintf(value, sizeof(value), "%u", cmd_received_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "cmd dropped";
+          snprintf(value, sizeof(value), "%u", cmd_dropped_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "map received";
+          snprintf(value, sizeof(value), "%u", map_received_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "map dropped";
+          snprintf(value, sizeof(value), "%u", map_dropped_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "stale cycles";
+          snprintf(value, sizeof(value), "%u", stale_cycles_);
+          kv.value = value;
+          intake.values.push_back(kv);
+          kv.key = "max odom age (ms)";
+          snprintf(value, sizeof(value), "%.3f", max_odom_age_ * 1e3);
+          kv.value = value;
+          intake.values.push_back(kv);
+          diag_msg.status.push_back(intake);
+          max_odom_age_ = 0.0;          // age high-water mark per report
+
+          diagnostics_.publish(diag_msg);
+        }
+
       // wait for next cycle
       cycle.sleep();
     }
@@ -381,3 +793,48 @@ int main(int argc, char **argv)
 
   return 0;
 }
+
+/** Nodelet version of the navigator node.
+ *
+ *  Running in the same nodelet manager as the maplanes driver and
+ *  observers delivers the road map and observations by shared
+ *  pointer, without serialization.  The standalone navigator
+ *  executable remains available for distributed deployments.
+ */
+class NavigatorNodelet: public nodelet::Nodelet
+{
+public:
+  NavigatorNodelet() {}
+  ~NavigatorNodelet()
+    {
+      if (thread_)
+        thread_->join();                // wait for navigator thread
+    }
+
+private:
+  virtual void onInit(void)
+    {
+      // run the control cycle in a separate thread: onInit() must
+      // not block
+      thread_.reset(new boost::thread(boost::bind(&NavigatorNodelet::run,
+                                                  this)));
+    }
+
+  /** navigator thread: runs until ROS shutdown */
+  void run(void)
+    {
+      ros::NodeHandle node = getNodeHandle();
+      nq_.reset(new NavQueueMgr);
+      if (!nq_->setup(node))
+        return;
+      nq_->spin(true);                  // manager services our callbacks
+      nq_->shutdown();
+    }
+
+  boost::shared_ptr<NavQueueMgr> nq_;   ///< the wrapped node
+  boost::shared_ptr<boost::thread> thread_; ///< navigator thread
+};
+
+// Register this plugin with pluginlib.
+PLUGINLIB_DECLARE_CLASS(art_nav, NavigatorNodelet,
+                        NavigatorNodelet, nodelet::Nodelet);
@@ -14,23 +14,27 @@
 #include "halt.h"
 #include "real_zone.h"
 #include "voronoi_zone.h"
+#include "zone_grid.h"
 
 RealZone::RealZone(Navigator *navptr, int _verbose):
   Controller(navptr, _verbose)
 {
   halt = new Halt(navptr, _verbose);
-  voronoi = new VoronoiZone(navptr, _verbose);
+  zone_grid = new ZoneObstacleGrid();
+  voronoi = new VoronoiZone(navptr, _verbose, zone_grid);
 }
 
 RealZone::~RealZone()
 {
   delete halt;
   delete voronoi;
+  delete zone_grid;
 }
 
 // configuration method
 void RealZone::configure(ConfigFile* cf, int section)
 {
+  zone_grid->configure(cf, section);
   voronoi->configure(cf, section);
   halt->configure(cf, section);
 }
@@ -48,6 +52,7 @@ Controller::result_t RealZone::control(pilot_command_t &pcmd)
     result = voronoi->control(pcmd);
   } else {
     halt->control(pcmd);
+    zone_grid->clear();			// not driving a zone leg
     result = NotApplicable;
   }
 
@@ -62,4 +67,5 @@ void RealZone::reset(void)
   trace_reset("RealZone");
   halt->reset();
   voronoi->reset();
+  zone_grid->clear();
 }
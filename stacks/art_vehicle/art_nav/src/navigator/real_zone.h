@@ -14,6 +14,7 @@
 
 class Halt;
 class VoronoiZone;
+class ZoneObstacleGrid;
 
 class RealZone: public Controller
 {
@@ -31,6 +32,9 @@ private:
 
   Halt *halt;
   VoronoiZone *voronoi;
+
+  // zone occupancy grid owned here, shared with the zone controllers
+  ZoneObstacleGrid *zone_grid;
 };
 
 #endif // __REAL_ZONE_HH__
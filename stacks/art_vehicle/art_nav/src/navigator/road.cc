@@ -23,129 +23,113 @@
 #include "uturn.h"
 //#include "voronoi_zone.h"
 
+// The FSM graph as static const data: one row per arrow,
+// alphabetically by previous state, event.  Besides building the
+// dispatch table, this array is the machine-readable transition table
+// for offline analysis of cycle paths.
+const Road::transition_desc_t Road::graph_[] =
+{
+  {NavRoadEvent::Collision,  NavRoadState::Block, NavRoadState::Evade,  &Road::ActionToEvade},
+  {NavRoadEvent::FollowLane, NavRoadState::Block, NavRoadState::Follow, &Road::ActionToFollow},
+  {NavRoadEvent::None,	     NavRoadState::Block, NavRoadState::Block,  &Road::ActionInBlock},
+  {NavRoadEvent::Uturn,	     NavRoadState::Block, NavRoadState::Uturn,  &Road::ActionToUturn},
+
+#if 0 // JOQ: I don't think this is possible
+  {NavRoadEvent::Block,	     NavRoadState::Evade, NavRoadState::Evade,  &Road::ActionInEvade},
+#endif
+  {NavRoadEvent::FollowLane, NavRoadState::Evade, NavRoadState::Follow, &Road::ActionEvadeToFollow},
+  {NavRoadEvent::None,	     NavRoadState::Evade, NavRoadState::Evade,  &Road::ActionInEvade},
+  {NavRoadEvent::Pass,	     NavRoadState::Evade, NavRoadState::Pass,   &Road::ActionToPass},
+  // JOQ: this looks wrong:
+  {NavRoadEvent::WaitPass,   NavRoadState::Evade, NavRoadState::Evade,  &Road::ActionInEvade},
+
+  {NavRoadEvent::Block,	     NavRoadState::Follow, NavRoadState::Block,     &Road::ActionToBlock},
+  {NavRoadEvent::ChangeLane, NavRoadState::Follow, NavRoadState::WaitLane,  &Road::ActionToWaitLane},
+  {NavRoadEvent::Collision,  NavRoadState::Follow, NavRoadState::Evade,     &Road::ActionToEvade},
+  {NavRoadEvent::FollowLane, NavRoadState::Follow, NavRoadState::Follow,    &Road::ActionInFollow},
+  {NavRoadEvent::Merge,	     NavRoadState::Follow, NavRoadState::WaitCross, &Road::ActionToWaitCross},
+  {NavRoadEvent::None,	     NavRoadState::Follow, NavRoadState::Follow,    &Road::ActionInFollow},
+  {NavRoadEvent::Perimeter,  NavRoadState::Follow, NavRoadState::Zone,      &Road::ActionToZone},
+  {NavRoadEvent::StopLine,   NavRoadState::Follow, NavRoadState::WaitStop,  &Road::ActionToWaitStop},
+  {NavRoadEvent::Uturn,	     NavRoadState::Follow, NavRoadState::Uturn,     &Road::ActionToUturn},
+  {NavRoadEvent::WaitPass,   NavRoadState::Follow, NavRoadState::WaitPass,  &Road::ActionToWaitPass},
+
+  {NavRoadEvent::FollowLane, NavRoadState::Init, NavRoadState::Follow,    &Road::ActionToFollow},
+  {NavRoadEvent::Merge,	     NavRoadState::Init, NavRoadState::WaitCross, &Road::ActionToWaitCross},
+  {NavRoadEvent::None,	     NavRoadState::Init, NavRoadState::Init,      &Road::ActionInInit},
+  {NavRoadEvent::Perimeter,  NavRoadState::Init, NavRoadState::Zone,      &Road::ActionToZone},
+
+  {NavRoadEvent::Block,	     NavRoadState::Pass, NavRoadState::Block,  &Road::ActionPassToBlock},
+  {NavRoadEvent::Collision,  NavRoadState::Pass, NavRoadState::Evade,  &Road::ActionPassToEvade},
+  {NavRoadEvent::FollowLane, NavRoadState::Pass, NavRoadState::Follow, &Road::ActionPassToFollow},
+  {NavRoadEvent::None,	     NavRoadState::Pass, NavRoadState::Pass,   &Road::ActionInPass},
+  {NavRoadEvent::Pass,	     NavRoadState::Pass, NavRoadState::Pass,   &Road::ActionInPass},
+
+  {NavRoadEvent::FollowLane, NavRoadState::Uturn, NavRoadState::Follow, &Road::ActionToFollow},
+  {NavRoadEvent::None,	     NavRoadState::Uturn, NavRoadState::Uturn,  &Road::ActionInUturn},
+
+  {NavRoadEvent::FollowLane, NavRoadState::WaitCross, NavRoadState::Follow,    &Road::ActionToFollow},
+  {NavRoadEvent::None,	     NavRoadState::WaitCross, NavRoadState::WaitCross, &Road::ActionInWaitCross},
+  {NavRoadEvent::Merge,	     NavRoadState::WaitCross, NavRoadState::WaitCross, &Road::ActionInWaitCross},
+
+  {NavRoadEvent::FollowLane, NavRoadState::WaitLane, NavRoadState::Follow,   &Road::ActionToFollow},
+  {NavRoadEvent::None,	     NavRoadState::WaitLane, NavRoadState::WaitLane, &Road::ActionInWaitLane},
+  {NavRoadEvent::ChangeLane, NavRoadState::WaitLane, NavRoadState::WaitLane, &Road::ActionInWaitLane},
+
+  {NavRoadEvent::Block,	     NavRoadState::WaitPass, NavRoadState::Block,    &Road::ActionToBlock},
+  {NavRoadEvent::Collision,  NavRoadState::WaitPass, NavRoadState::Evade,    &Road::ActionToEvade},
+  {NavRoadEvent::FollowLane, NavRoadState::WaitPass, NavRoadState::Follow,   &Road::ActionWaitPassToFollow},
+  {NavRoadEvent::None,	     NavRoadState::WaitPass, NavRoadState::WaitPass, &Road::ActionInWaitPass},
+  {NavRoadEvent::Pass,	     NavRoadState::WaitPass, NavRoadState::Pass,     &Road::ActionToPass},
+  {NavRoadEvent::WaitPass,   NavRoadState::WaitPass, NavRoadState::WaitPass, &Road::ActionInWaitPass},
+
+  {NavRoadEvent::Merge,	     NavRoadState::WaitStop, NavRoadState::WaitCross, &Road::ActionToWaitCross},
+  {NavRoadEvent::None,	     NavRoadState::WaitStop, NavRoadState::WaitStop,  &Road::ActionInWaitStop},
+  {NavRoadEvent::StopLine,   NavRoadState::WaitStop, NavRoadState::WaitStop,  &Road::ActionInWaitStop},
+
+  {NavRoadEvent::None,	     NavRoadState::Zone, NavRoadState::Zone,      &Road::ActionInZone},
+  {NavRoadEvent::Perimeter,  NavRoadState::Zone, NavRoadState::WaitCross, &Road::ActionZoneToWaitCross},
+};
+const size_t Road::graph_size_ = sizeof(graph_) / sizeof(graph_[0]);
+
+// dense dispatch table, built once from graph_ and shared by all
+// instances, making dispatch a two-load operation
+Road::transtion_t Road::ttable[NavRoadEvent::N_events][NavRoadState::N_states];
+bool Road::ttable_built = false;
+
+const Road::transition_desc_t *Road::transition_graph(size_t &count)
+{
+  count = graph_size_;
+  return graph_;
+}
+
 Road::Road(Navigator *navptr, int _verbose):
   Controller(navptr, _verbose)
 {
   passing_first=true;
 
-  // initialize transition table, unused entries cause an error action
-  for (int event = 0; event < (int) NavRoadEvent::N_events; ++event)
-    for (int state = 0; state < (int) NavRoadState::N_states; ++state)
-      {
-	transtion_t *xp = &ttable[event][state];
-	xp->action = &Road::ActionError;
-	xp->next = (NavRoadState::state_t) state;
-      }
+  if (!ttable_built)
+    {
+      // initialize transition table, unused entries cause an error action
+      for (int event = 0; event < (int) NavRoadEvent::N_events; ++event)
+	for (int state = 0; state < (int) NavRoadState::N_states; ++state)
+	  {
+	    transtion_t *xp = &ttable[event][state];
+	    xp->action = &Road::ActionError;
+	    xp->next = (NavRoadState::state_t) state;
+	  }
+
+      // expand the graph description into the dense dispatch table
+      for (size_t i = 0; i < graph_size_; ++i)
+	{
+	  const transition_desc_t *arrow = &graph_[i];
+	  transtion_t *xp = &ttable[arrow->event][arrow->from_state];
+	  xp->action = arrow->action;
+	  xp->next = arrow->to_state;
+	}
 
-  // valid transitions alphabetically by previous state, event
-  
-  Add(NavRoadEvent::Collision,		&Road::ActionToEvade,
-      NavRoadState::Block,		NavRoadState::Evade);
-  Add(NavRoadEvent::FollowLane,		&Road::ActionToFollow,
-      NavRoadState::Block,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInBlock,
-      NavRoadState::Block,		NavRoadState::Block);
-  Add(NavRoadEvent::Uturn,		&Road::ActionToUturn,
-      NavRoadState::Block,		NavRoadState::Uturn);
-  
-#if 0 // JOQ: I don't think this is possible
-  Add(NavRoadEvent::Block,		&Road::ActionInEvade,
-      NavRoadState::Evade,		NavRoadState::Evade);
-#endif
-  Add(NavRoadEvent::FollowLane,		&Road::ActionEvadeToFollow,
-      NavRoadState::Evade,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInEvade,
-      NavRoadState::Evade,		NavRoadState::Evade);
-  Add(NavRoadEvent::Pass,		&Road::ActionToPass,
-      NavRoadState::Evade,		NavRoadState::Pass);
-  // JOQ: this looks wrong:
-  Add(NavRoadEvent::WaitPass,		&Road::ActionInEvade,
-      NavRoadState::Evade,		NavRoadState::Evade);
-  
-  Add(NavRoadEvent::Block,		&Road::ActionToBlock,
-      NavRoadState::Follow,		NavRoadState::Block);
-  Add(NavRoadEvent::ChangeLane,		&Road::ActionToWaitLane,
-      NavRoadState::Follow,		NavRoadState::WaitLane);
-  Add(NavRoadEvent::Collision,		&Road::ActionToEvade,
-      NavRoadState::Follow,		NavRoadState::Evade);
-  Add(NavRoadEvent::FollowLane,		&Road::ActionInFollow,
-      NavRoadState::Follow,		NavRoadState::Follow);
-  Add(NavRoadEvent::Merge,		&Road::ActionToWaitCross,
-      NavRoadState::Follow,		NavRoadState::WaitCross);
-  Add(NavRoadEvent::None,		&Road::ActionInFollow,
-      NavRoadState::Follow,		NavRoadState::Follow);
-  Add(NavRoadEvent::Perimeter,		&Road::ActionToZone,
-      NavRoadState::Follow,		NavRoadState::Zone);
-  Add(NavRoadEvent::StopLine,		&Road::ActionToWaitStop,
-      NavRoadState::Follow,		NavRoadState::WaitStop);
-  Add(NavRoadEvent::Uturn,		&Road::ActionToUturn,
-      NavRoadState::Follow,		NavRoadState::Uturn);
-  Add(NavRoadEvent::WaitPass,		&Road::ActionToWaitPass,
-      NavRoadState::Follow,		NavRoadState::WaitPass);
-
-  Add(NavRoadEvent::FollowLane,		&Road::ActionToFollow,
-      NavRoadState::Init,		NavRoadState::Follow);
-  Add(NavRoadEvent::Merge,		&Road::ActionToWaitCross,
-      NavRoadState::Init,		NavRoadState::WaitCross);
-  Add(NavRoadEvent::None,		&Road::ActionInInit,
-      NavRoadState::Init,		NavRoadState::Init);
-  Add(NavRoadEvent::Perimeter,		&Road::ActionToZone,
-      NavRoadState::Init,		NavRoadState::Zone);
-  
-  Add(NavRoadEvent::Block,		&Road::ActionPassToBlock,
-      NavRoadState::Pass,		NavRoadState::Block);
-  Add(NavRoadEvent::Collision,		&Road::ActionPassToEvade,
-      NavRoadState::Pass,		NavRoadState::Evade);
-  Add(NavRoadEvent::FollowLane,		&Road::ActionPassToFollow,
-      NavRoadState::Pass,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInPass,
-      NavRoadState::Pass,		NavRoadState::Pass);
-  Add(NavRoadEvent::Pass,		&Road::ActionInPass,
-      NavRoadState::Pass,		NavRoadState::Pass);
-
-  Add(NavRoadEvent::FollowLane,		&Road::ActionToFollow,
-      NavRoadState::Uturn,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInUturn,
-      NavRoadState::Uturn,		NavRoadState::Uturn);
-
-  Add(NavRoadEvent::FollowLane,		&Road::ActionToFollow,
-      NavRoadState::WaitCross,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInWaitCross,
-      NavRoadState::WaitCross,		NavRoadState::WaitCross);
-  Add(NavRoadEvent::Merge,		&Road::ActionInWaitCross,
-      NavRoadState::WaitCross,		NavRoadState::WaitCross);
-
-  Add(NavRoadEvent::FollowLane,		&Road::ActionToFollow,
-      NavRoadState::WaitLane,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInWaitLane,
-      NavRoadState::WaitLane,		NavRoadState::WaitLane);
-  Add(NavRoadEvent::ChangeLane,		&Road::ActionInWaitLane,
-      NavRoadState::WaitLane,		NavRoadState::WaitLane);
-
-  Add(NavRoadEvent::Block,		&Road::ActionToBlock,
-      NavRoadState::WaitPass,		NavRoadState::Block);
-  Add(NavRoadEvent::Collision,		&Road::ActionToEvade,
-      NavRoadState::WaitPass,		NavRoadState::Evade);
-  Add(NavRoadEvent::FollowLane,		&Road::ActionWaitPassToFollow,
-      NavRoadState::WaitPass,		NavRoadState::Follow);
-  Add(NavRoadEvent::None,		&Road::ActionInWaitPass,
-      NavRoadState::WaitPass,		NavRoadState::WaitPass);
-  Add(NavRoadEvent::Pass,		&Road::ActionToPass,
-      NavRoadState::WaitPass,		NavRoadState::Pass);
-  Add(NavRoadEvent::WaitPass,		&Road::ActionInWaitPass,
-      NavRoadState::WaitPass,		NavRoadState::WaitPass);
-
-  Add(NavRoadEvent::Merge,		&Road::ActionToWaitCross,
-      NavRoadState::WaitStop,		NavRoadState::WaitCross);
-  Add(NavRoadEvent::None,		&Road::ActionInWaitStop,
-      NavRoadState::WaitStop,		NavRoadState::WaitStop);
-  Add(NavRoadEvent::StopLine,		&Road::ActionInWaitStop,
-      NavRoadState::WaitStop,		NavRoadState::WaitStop);
-
-  Add(NavRoadEvent::None,		&Road::ActionInZone,
-      NavRoadState::Zone,		NavRoadState::Zone);
-  Add(NavRoadEvent::Perimeter,		&Road::ActionZoneToWaitCross,
-      NavRoadState::Zone,		NavRoadState::WaitCross);
+      ttable_built = true;
+    }
 
   // allocate subordinate controllers
   //evade = new Evade(navptr, _verbose);
@@ -182,16 +166,6 @@ Road::~Road()
   delete stop_line_timer;
 };
 
-// add a transition to the table
-void Road::Add(NavRoadEvent::event_t event, action_t action,
-	       NavRoadState::state_t from_state,
-	       NavRoadState::state_t to_state)
-{
-  transtion_t *xp = &ttable[event][from_state];
-  xp->action = action;
-  xp->next = to_state;
-}
-
 void Road::cancel_all_timers(void)
 {
   passing_timer->Cancel();
@@ -200,11 +174,58 @@ void Road::cancel_all_timers(void)
   stop_line_timer->Cancel();
 }
 
+/** Build the precedence context for a waiting state.
+ *
+ *  Runs once on stop-line or merge arrival.  Resolves the governing
+ *  observer, the crossing direction, and the conflicting lane
+ *  polygons near the intersection entry, so the waiting cycles read
+ *  cached state instead of re-deriving any of it.
+ */
+void Road::build_precedence_context(Observation::_oid_type observer,
+				    Course::direction_t direction)
+{
+  precedence_.observer = observer;
+  precedence_.direction = direction;
+  precedence_.conflicting_polys.clear();
+
+  // Collect polygons of other lanes near the intersection entry
+  // way-point: these are the lanes whose traffic governs precedence.
+  // The scan runs once here; subordinate checks reuse the list.
+  const float radius = 30.0;		// conflict area radius (m)
+  ElementID w0(order->waypt[0].id);
+  ElementID w1(order->waypt[1].id);
+  MapXY entry(order->waypt[1].mapxy);
+  for (unsigned i = 0; i < course->polygons.size(); ++i)
+    {
+      const poly &p = course->polygons.at(i);
+      if (pops->LanePoly(p, w0) || pops->LanePoly(p, w1))
+	continue;			// our own lane
+      if (pops->getShortestDistToPolySquared(entry.x, entry.y, p)
+	  < radius * radius)
+	precedence_.conflicting_polys.push_back(p);
+    }
+
+  precedence_.valid = true;
+  if (verbose >= 2)
+    ART_MSG(5, "precedence context: observer %d, %u conflicting polys",
+	    precedence_.observer,
+	    (unsigned) precedence_.conflicting_polys.size());
+}
+
 Controller::result_t Road::control(pilot_command_t &pcmd)
 {
-  // get next event
+  NavTiming::Scope timing_scope(&nav->timing, "Road");
+
+  // get next event: internally generated transitions first, then any
+  // event posted lock-free from outside the control cycle
   event = pending_event;
   pending_event = NavRoadEvent::None;
+  if (event == NavRoadEvent::None)
+    {
+      int posted;
+      if (posted_events_.take(posted))
+	event = (NavRoadEvent::event_t) posted;
+    }
 
   // state transition table pointer
   transtion_t *xp = &ttable[event.Value()][state.Value()];
@@ -226,6 +247,12 @@ Controller::result_t Road::control(pilot_command_t &pcmd)
 		state.Name(), event.Name());
     }
 
+  // update subordinate activation masks, so dormant subtrees can skip
+  // their per-cycle setup work
+  follow_lane->set_active(state == NavRoadState::Follow);
+  passing->set_active(state == NavRoadState::Pass);
+  uturn->set_active(state == NavRoadState::Uturn);
+
   // perform transition action, returning next Pilot command
   action_t action = xp->action;
   return (this->*action)(pcmd);
@@ -251,6 +278,11 @@ void Road::reset_me(void)
   state = NavRoadState();		// initial state
   event = NavRoadEvent::None;
   pending_event = NavRoadEvent::None;
+  posted_events_.drain();		// discard stale posted events
+  precedence_.valid = false;
+  precedence_.observer = Observation::Intersection;
+  precedence_.direction = Course::Straight;
+  precedence_.conflicting_polys.clear();
   cancel_all_timers();
 }
 
@@ -450,40 +482,24 @@ Controller::result_t Road::ActionInWaitCross(pilot_command_t &pcmd)
 {
   result_t result = halt->control(pcmd); // stay put this cycle
   // TODO: add a timeout for when the observer is not applicable?
-  if (obstacle->observer_clear(crossing_observer))
+  if (obstacle->observer_clear(precedence_.observer))
     {
       pending_event = NavRoadEvent::FollowLane;
     }
   return result;
-}  
+}
 
 Controller::result_t Road::ActionInWaitLane(pilot_command_t &pcmd)
 {
   result_t result = halt->control(pcmd); // stay put this cycle
-  if (lane_direction == Course::Straight) // missing polygons?
+  if (!precedence_.valid)		// missing polygons?
     {
-      ART_MSG(1, "Not waiting for lane to clear -- polygons missing.");
       pending_event = NavRoadEvent::FollowLane;
     }
-  else
+  // TODO: add a timeout for when the observer is not applicable?
+  else if (obstacle->observer_clear(precedence_.observer))
     {
-      // direction known, query the relevant observer
-      Observation::_oid_type lane_observer;
-      if (lane_direction == Course::Left)
-	{
-	  ART_MSG(1, "Waiting for nearest left lane to clear.");
-	  lane_observer = Observation::Adjacent_left;
-	}
-      else
-	{
-	  ART_MSG(1, "Waiting for nearest right lane to clear.");
-	  lane_observer = Observation::Adjacent_right;
-	}
-      // TODO: add a timeout for when the observer is not applicable?
-      if (obstacle->observer_clear(lane_observer))
-	{
-	  pending_event = NavRoadEvent::FollowLane;
-	}
+      pending_event = NavRoadEvent::FollowLane;
     }
   return result;
 }
@@ -521,7 +537,7 @@ Controller::result_t Road::ActionInWaitStop(pilot_command_t &pcmd)
 
   // wait until stopped for a while, then query observer
   if (stop_line_timer->Check()		// initial timer expired?
-      && obstacle->observer_clear(Observation::Intersection))
+      && obstacle->observer_clear(precedence_.observer))
     {
       ART_MSG(1, "Our turn to cross intersection.");
       stop_line_timer->Cancel();
@@ -530,7 +546,8 @@ Controller::result_t Road::ActionInWaitStop(pilot_command_t &pcmd)
     }
 
   // restart precedence timer if number of cars remaining changed
-  Observation obs = obstacle->observation(Observation::Intersection);
+  const Obstacle::obs_digest_t &obs =
+    obstacle->observation(precedence_.observer);
   if (obs.applicable && obs.nobjects != prev_nobjects)
     {
       prev_nobjects = obs.nobjects;
@@ -679,6 +696,7 @@ Controller::result_t Road::ActionToUturn(pilot_command_t &pcmd)
 Controller::result_t Road::ActionToWaitCross(pilot_command_t &pcmd)
 {
   Course::direction_t crossing_direction = course->intersection_direction();
+  Observation::_oid_type crossing_observer;
 #if 0  // always use Merge_across_all, Merge_into_nearest is broken
   if (crossing_direction == Course::Right)
     {
@@ -694,13 +712,29 @@ Controller::result_t Road::ActionToWaitCross(pilot_command_t &pcmd)
       ART_MSG(1, "Waiting for all intersection lanes to clear.");
       crossing_observer = Observation::Merge_across_all;
     }
+  build_precedence_context(crossing_observer, crossing_direction);
   course->signal_for_direction(crossing_direction);
   return ActionInWaitCross(pcmd);
 }  
 
 Controller::result_t Road::ActionToWaitLane(pilot_command_t &pcmd)
 {
-  lane_direction = course->lane_change_direction();
+  Course::direction_t lane_direction = course->lane_change_direction();
+  if (lane_direction == Course::Straight) // missing polygons?
+    {
+      ART_MSG(1, "Not waiting for lane to clear -- polygons missing.");
+      precedence_.valid = false;
+    }
+  else if (lane_direction == Course::Left)
+    {
+      ART_MSG(1, "Waiting for nearest left lane to clear.");
+      build_precedence_context(Observation::Adjacent_left, lane_direction);
+    }
+  else
+    {
+      ART_MSG(1, "Waiting for nearest right lane to clear.");
+      build_precedence_context(Observation::Adjacent_right, lane_direction);
+    }
   course->signal_for_direction(lane_direction);
   return ActionInWaitLane(pcmd);
 }  
@@ -729,7 +763,9 @@ Controller::result_t Road::ActionToWaitPass(pilot_command_t &pcmd)
 Controller::result_t Road::ActionToWaitStop(pilot_command_t &pcmd)
 {
   ART_MSG(1, "Waiting for intersection precedence.");
-  course->signal_for_direction(course->intersection_direction());
+  Course::direction_t crossing_direction = course->intersection_direction();
+  build_precedence_context(Observation::Intersection, crossing_direction);
+  course->signal_for_direction(crossing_direction);
   stop_line_timer->Start(config_->stop_line_delay);
   precedence_timer->Start(config_->precedence_delay);
   prev_nobjects = -1;
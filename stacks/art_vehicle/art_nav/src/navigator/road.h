@@ -12,6 +12,7 @@
 #define __ROAD_HH__
 
 #include <art_nav/NavRoadState.h>
+#include "NavEventQueue.h"
 #include "NavRoadEvent.h"
 
 //class Evade;
@@ -37,13 +38,45 @@ public:
     return state;
   }
 
+  // state transition action method pointer
+  typedef result_t (Road::*action_t)(pilot_command_t &pcmd);
+
+  /** one arrow of the FSM graph.
+   *
+   *  The whole graph is a single static const array of these in
+   *  road.cc, so it is compile-time data shared by all instances and
+   *  a machine-readable transition table for offline analysis.
+   */
+  typedef struct
+  {
+    NavRoadEvent::event_t event;	///< triggering event
+    NavRoadState::state_t from_state;	///< previous state
+    NavRoadState::state_t to_state;	///< next state
+    action_t		  action;	///< transition action
+  } transition_desc_t;
+
+  /** access the FSM graph description
+   *  @param count returns the number of arrows */
+  static const transition_desc_t *transition_graph(size_t &count);
+
+  /** post an event from outside the control cycle.
+   *
+   *  Lock-free and safe from any thread, including message
+   *  callbacks.  Events posted here are consumed by the FSM one per
+   *  cycle, in posting order, whenever no internally generated
+   *  transition is pending.  The internal transitions set by the
+   *  action methods keep the single-slot @c pending_event path,
+   *  which the control thread owns exclusively.
+   */
+  void post_event(NavRoadEvent::event_t ev)
+  {
+    posted_events_.post((int) ev);
+  }
+
 private:
 
   bool passing_first;
 
-  // state transition action method pointer
-  typedef result_t (Road::*action_t)(pilot_command_t &pcmd);
-
   // state transition table entry
   typedef struct
   {
@@ -55,9 +88,35 @@ private:
   NavRoadState	state;
   NavRoadEvent	event;			// current event
   NavRoadEvent	pending_event;
-  Observation::_oid_type crossing_observer;
-  Course::direction_t lane_direction;
-  transtion_t	ttable[NavRoadEvent::N_events][NavRoadState::N_states];
+
+  // events posted from other threads, preallocated bounded ring
+  NavEventQueue<16> posted_events_;
+
+  // dense dispatch table indexed by (event, state), built once from
+  // the static graph description and shared by all instances
+  static transtion_t ttable[NavRoadEvent::N_events][NavRoadState::N_states];
+  static bool ttable_built;
+
+  // the FSM graph as static const data
+  static const transition_desc_t graph_[];
+  static const size_t graph_size_;
+
+  /** Precedence context, built once on entry to a waiting state.
+   *
+   *  Waiting at an intersection is where the cycle budget is
+   *  tightest, with zone and obstacle work running at the same time.
+   *  Everything derivable from the order and lane geometry is
+   *  resolved here on stop-line or merge arrival, so the per-cycle
+   *  waiting checks reduce to observer digest flag reads.
+   */
+  typedef struct
+  {
+    bool valid;				// context matches current wait
+    Observation::_oid_type observer;	// observer governing this wait
+    Course::direction_t direction;	// crossing or lane change direction
+    poly_list_t conflicting_polys;	// other lanes near the crossing
+  } precedence_context_t;
+  precedence_context_t precedence_;
 
   // ActionInWaitStop() state:
   int32_t prev_nobjects;		// previous number of cars
@@ -77,11 +136,9 @@ private:
   NavTimer		*roadblock_timer;
   NavTimer		*stop_line_timer;
 
-  // add a transition to the table
-  void Add(NavRoadEvent::event_t event, action_t action,
-	   NavRoadState::state_t from_state, NavRoadState::state_t to_state);
-
   // private methods
+  void build_precedence_context(Observation::_oid_type observer,
+				Course::direction_t direction);
   void cancel_all_timers(void);
   void reset_me(void);
   void set_waypt_event(void);
@@ -86,6 +86,8 @@ void Run::begin_escape(void)
 */
 Controller::result_t Run::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "Run");
+
   // Do nothing if the order is still Run.  Wait until Commander sends
   // a new behavior.  Also, wait until the course controller receives
   // data from the maplanes driver.
@@ -103,9 +105,14 @@ Controller::result_t Run::control(pilot_command_t &pcmd)
   pcmd.yawRate = 0.0;
   pcmd.velocity = fminf(order->max_speed, config_->max_speed);
   
-  // estimate current dead reckoning position based on time of current
-  // cycle and latest odometry course and speed
-  Estimate::control_pose(*odom, ros::Time::now(), *estimate);
+  // Estimate dead reckoning position for the time this cycle's
+  // commands take effect, about one pilot cycle from now, based on
+  // the latest odometry course and speed.  Course::desired_heading()
+  // and the other subordinate controllers then steer the pose the
+  // vehicle will actually have at actuation time.
+  ros::Duration actuation_latency(1.0 / art_msgs::ArtHertz::PILOT);
+  Estimate::control_pose(*odom, ros::Time::now() + actuation_latency,
+                         *estimate);
 
   course->begin_run_cycle();
 
@@ -20,6 +20,8 @@
 
 Controller::result_t SlowForCurves::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "SlowForCurves");
+
   
   if (pcmd.velocity < config_->min_speed_for_curves)
     {
@@ -29,8 +31,7 @@ Controller::result_t SlowForCurves::control(pilot_command_t &pcmd)
   
 
   // These indices are checked in max_safe_speed
-  int start_index = pops->getClosestPoly(course->plan,
-                                         MapPose(estimate->pose.pose));
+  int start_index = course->closest_plan_index();
 
   // TODO: lookahead_distance should probably be time in seconds.
   int stop_index = pops->index_of_downstream_poly(course->plan,
@@ -93,23 +94,21 @@ float SlowForCurves::max_safe_speed(const std::vector<poly>& polygons,
 	    polygons.at(stop_index).poly_id,
 	    polygons.at(stop_index).start_way.name().str);
 
-  float distance = 0;
+  // make sure the precomputed arc-length tables match the current plan
+  update_profile(polygons);
+
   float max_speed = 100;
 
   char limiting_string[512] = "";
   int limiting_id = 0;
 
   for(int begin = start_index; begin < stop_index; begin++) {
-    distance += (polygons.at(begin).length +
-		 polygons.at(begin+1).length)/2.0;
-
-    float length = 0;
-    int end = begin;
-    while(end < stop_index && length < config_->min_curve_length) {
-      length += (polygons.at(end).length +
-		 polygons.at(end+1).length)/2.0;
-      end++;
-    }
+    float distance = cum_dist_[begin+1] - cum_dist_[start_index];
+
+    int end = curve_end_[begin];
+    if (end > stop_index)
+      end = stop_index;
+    float length = cum_dist_[end] - cum_dist_[begin];
 		
     float dheading =
       Coordinates::normalize(polygons[end].heading - polygons[begin].heading);
@@ -152,6 +151,43 @@ float SlowForCurves::max_safe_speed(const std::vector<poly>& polygons,
   return max_speed;
 }
 
+// Rebuild the curvature profile tables whenever the plan changes.
+//
+// cum_dist_[i] is the arc length along the plan to polygon i, using
+// the same midpoint spacing max_safe_speed() used to accumulate, so
+// any span is one subtraction.  curve_end_[i] is the first polygon at
+// least min_curve_length beyond polygon i (capped at the last one),
+// found with a single forward sweep instead of a nested scan on every
+// cycle.
+void SlowForCurves::update_profile(const std::vector<poly>& polygons) {
+  if (profile_version_ == course->plan_version
+      && cum_dist_.size() == polygons.size())
+    return;				// tables still current
+
+  profile_version_ = course->plan_version;
+
+  int n = polygons.size();
+  cum_dist_.resize(n);
+  curve_end_.resize(n);
+  if (n == 0)
+    return;
+
+  cum_dist_[0] = 0.0;
+  for (int i = 1; i < n; ++i)
+    cum_dist_[i] = cum_dist_[i-1] + (polygons[i-1].length +
+				     polygons[i].length)/2.0;
+
+  int end = 0;
+  for (int i = 0; i < n; ++i) {
+    if (end < i)
+      end = i;
+    while (end < n-1
+	   && cum_dist_[end] - cum_dist_[i] < config_->min_curve_length)
+      end++;
+    curve_end_[i] = end;
+  }
+}
+
 
 void SlowForCurves::reset(void) {
   trace_reset("SlowForCurves");
@@ -11,26 +11,37 @@
 #ifndef __SLOW_FOR_CURVES_HH__
 #define __SLOW_FOR_CURVES_HH__
 
+#include <vector>
+
 class SlowForCurves: public Controller
 {
 public:
 
   SlowForCurves(Navigator *navptr, int _verbose):
-    Controller(navptr, _verbose), current_limiting_id(0) {}
+    Controller(navptr, _verbose), current_limiting_id(0),
+    profile_version_(-1) {}
   ~SlowForCurves() {}
   result_t control(pilot_command_t &pcmd);
   void reset(void);
 
 
 private:
-  
+
   // state
   int current_limiting_id;
-  
+
+  // curvature profile tables, rebuilt by update_profile() whenever the
+  // course plan changes
+  int profile_version_;			// course->plan_version of tables
+  std::vector<float> cum_dist_;		// arc length to each poly midpoint
+  std::vector<int> curve_end_;		// end poly spanning min_curve_length
+
   float max_safe_speed(const std::vector<poly>& polygons,
 		       const int& start_index,
 		       const int& stop_index,
 		       const float& max);
+
+  void update_profile(const std::vector<poly>& polygons);
 };
 
 #endif // __SLOW_FOR_CURVES_HH__
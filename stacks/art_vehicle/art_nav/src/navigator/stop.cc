@@ -71,6 +71,8 @@ Controller::result_t Stop::control(pilot_command_t &pcmd,
                                    float threshold,
 				   float topspeed)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "Stop");
+
   result_t result = OK;
 
   // stop_latency compensates for latency in the braking system.
@@ -33,6 +33,11 @@ StopArea::~StopArea() {};
 //
 Controller::result_t StopArea::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "StopArea");
+
+  if (dormant_cycle())			// no stopping point coming up?
+    return NotApplicable;		// skip the stop way-point scan
+
   using art_msgs::ArtVehicle;
   float wayptdist = (course->stop_waypt_distance(true)
 		     - ArtVehicle::front_bumper_px);
@@ -40,8 +45,11 @@ Controller::result_t StopArea::control(pilot_command_t &pcmd)
   if (wayptdist >= DARPA_rules::stop_line_safety_area)
     return NotApplicable;
 
-  // reduce speed within stop line safety area
-  nav->reduce_speed_with_min(pcmd, config_->stop_approach_speed);
+  // reduce speed within stop line safety area, following the
+  // precomputed deceleration ramp down to the approach speed
+  nav->reduce_speed_with_min(pcmd,
+			     fmaxf(config_->stop_approach_speed,
+				   course->stop_approach_speed_limit(wayptdist)));
 
   if (!in_safety_area)
     {
@@ -278,6 +278,8 @@ bool Uturn::circle_and_line_intersect(MapXY c, float r,
 //
 Controller::result_t Uturn::control(pilot_command_t &pcmd)
 {
+  NavTiming::Scope timing_scope(&nav->timing, "Uturn");
+
   // This controller never marks a way-point officially reached.
   // Don't want run controller to get upset about that.
   course->no_waypoint_reached();
@@ -354,6 +356,18 @@ Controller::result_t Uturn::control(pilot_command_t &pcmd)
 	  }
 	
 	float arc_length = estimate_uturn_distance(true, desired_arc_length);
+
+	// Also stop short of any obstacle points binned to the U-turn
+	// lanes that lie in the precomputed swept volume of this hard
+	// left arc.
+	mapxy_list_t uturn_obstacles;
+	obstacle->obstacles_in_polys(uturn_polys, uturn_obstacles);
+	if (!uturn_obstacles.empty())
+	  arc_length =
+	    fminf(arc_length,
+		  nav->footprint.arc_to_hit(MapPose(estimate->pose.pose),
+					    VehicleFootprint::MaxLeft,
+					    uturn_obstacles));
 #if 0
  	if (remaining_angle <= config_->uturn_stop_heading
 	    || arc_length > desired_arc_length)
@@ -401,6 +415,16 @@ Controller::result_t Uturn::control(pilot_command_t &pcmd)
 	  float arc_length = estimate_uturn_distance(false,
 						     desired_arc_length);
 
+	  // stop short of obstacle points in the swept reverse arc
+	  mapxy_list_t uturn_obstacles;
+	  obstacle->obstacles_in_polys(uturn_polys, uturn_obstacles);
+	  if (!uturn_obstacles.empty())
+	    arc_length =
+	      fminf(arc_length,
+		    nav->footprint.arc_to_hit(MapPose(estimate->pose.pose),
+					      VehicleFootprint::MaxRight,
+					      uturn_obstacles, true));
+
 	  // continue backing
 	  if (stop->control(pcmd, arc_length, config_->uturn_threshold) == Finished)
 	    {
@@ -522,15 +546,15 @@ float Uturn::estimate_uturn_distance(bool forward, float desired_arc_length)
 	    (forward? "forward": "backward"), center.x, center.y);
   
   float min_arc_length = Infinite::distance;
-  
-  // check lane polygon right boundaries in the direction of lane heading
-  for (unsigned pidx = 0; pidx < uturn_polys.size(); ++pidx)
-    {
-      MapXY p1 = uturn_polys.at(pidx).p4; // bottom right
-      MapXY p2 = uturn_polys.at(pidx).p3; // top right
 
+  // check the turn-plan curb segments, one per lane polygon, in the
+  // direction of the lane heading
+  for (unsigned pidx = 0; pidx < curb_segments_.size(); ++pidx)
+    {
       float arc_length =
-	calculate_arc_length(forward,center,safety_radius,p1,p2);      
+	calculate_arc_length(forward, center, safety_radius,
+			     curb_segments_[pidx].p1,
+			     curb_segments_[pidx].p2);
       min_arc_length = fminf(arc_length, min_arc_length);
     }
 
@@ -541,64 +565,17 @@ float Uturn::estimate_uturn_distance(bool forward, float desired_arc_length)
 		(forward? "forward": "backward"), min_arc_length);
       return min_arc_length;
     }
-  
-  int index=pops->getClosestPoly(uturn_polys,uturn_entry.midpoint);
-  if (index >= 0)
-    {
-      MapXY p1 = uturn_polys.at(index).p4; // bottom right
-      MapXY p2 = uturn_polys.at(index).p3; // top right
-
-      MapXY mid=pops->midpoint(p1,p2);
-      posetype origin(0,0,0);
-      posetype origin_abs(mid.x,mid.y,bearing(p1,p2));
-      
-      posetype far(300,0,0);
-      
-      rotate_translate_transform long_trans;
-      long_trans.find_transform(origin, origin_abs);
-      posetype far_abs=long_trans.apply_transform(far);
-      far.x*=-1;
-      posetype nfar_abs=long_trans.apply_transform(far);
-      
-      p2.x=far_abs.x;
-      p2.y=far_abs.y;
-      p1.x=nfar_abs.x;
-      p1.y=nfar_abs.y;
 
-  
-      float arc_length =
-	calculate_arc_length(forward,center,safety_radius,p1,p2);      
-      min_arc_length = fminf(arc_length, min_arc_length);
-    }
-  
-  index=pops->getClosestPoly(uturn_polys,uturn_exit.midpoint);
-  if (index >= 0)
+  // no nearby intersection: check the extended entry and exit curbs
+  for (unsigned i = 0; i < extended_segments_.size(); ++i)
     {
-      MapXY p1 = uturn_polys.at(index).p4; // bottom right
-      MapXY p2 = uturn_polys.at(index).p3; // top right
-      
-      MapXY mid=pops->midpoint(p1,p2);
-      posetype origin(0,0,0);
-      posetype origin_abs(mid.x,mid.y,bearing(p1,p2));
-      
-      posetype far(300,0,0);
-      
-      rotate_translate_transform long_trans;
-      long_trans.find_transform(origin, origin_abs);
-      posetype far_abs=long_trans.apply_transform(far);
-      far.x*=-1;
-      posetype nfar_abs=long_trans.apply_transform(far);
-      
-      p2.x=far_abs.x;
-      p2.y=far_abs.y;
-      p1.x=nfar_abs.x;
-      p1.y=nfar_abs.y;
-
       float arc_length =
-	calculate_arc_length(forward,center,safety_radius,p1,p2);      
+	calculate_arc_length(forward, center, safety_radius,
+			     extended_segments_[i].p1,
+			     extended_segments_[i].p2);
       min_arc_length = fminf(arc_length, min_arc_length);
     }
-      
+
   if (min_arc_length < Infinite::distance)
     {
       if (verbose >= 4)
@@ -680,9 +657,65 @@ Controller::result_t Uturn::initialize(void)
   // save heading of the goal polygon
   goal_heading = pops->PolyHeading(uturn_polys.at(p_index));
 
+  // the curb geometry is fixed for the whole turn, extract it now
+  build_turn_plan();
+
   return OK;
 }
 
+// build the turn plan when the U-turn is initiated
+//
+// Collects the right curb segment of every U-turn polygon, plus the
+// extended entry and exit curbs, so estimate_uturn_distance() can
+// replay them each cycle with only the pose-relative circle
+// recomputed, instead of searching the polygons again.
+//
+void Uturn::build_turn_plan(void)
+{
+  curb_segments_.clear();
+  extended_segments_.clear();
+
+  for (unsigned pidx = 0; pidx < uturn_polys.size(); ++pidx)
+    {
+      curb_segment_t seg;
+      seg.p1 = uturn_polys.at(pidx).p4;	// bottom right
+      seg.p2 = uturn_polys.at(pidx).p3;	// top right
+      curb_segments_.push_back(seg);
+    }
+
+  add_extended_curb(uturn_entry.midpoint);
+  add_extended_curb(uturn_exit.midpoint);
+}
+
+// add the curb of the polygon closest to a way-point to the turn
+// plan, extended far in both directions
+void Uturn::add_extended_curb(const MapXY &midpoint)
+{
+  int index = pops->getClosestPoly(uturn_polys, midpoint);
+  if (index < 0)
+    return;
+
+  MapXY p1 = uturn_polys.at(index).p4;	// bottom right
+  MapXY p2 = uturn_polys.at(index).p3;	// top right
+
+  MapXY mid = pops->midpoint(p1, p2);
+  posetype origin(0, 0, 0);
+  posetype origin_abs(mid.x, mid.y, bearing(p1, p2));
+
+  posetype far(300, 0, 0);
+
+  rotate_translate_transform long_trans;
+  long_trans.find_transform(origin, origin_abs);
+  posetype far_abs = long_trans.apply_transform(far);
+  far.x *= -1;
+  posetype nfar_abs = long_trans.apply_transform(far);
+
+  curb_segment_t seg;
+  seg.p1 = MapXY(nfar_abs.x, nfar_abs.y);
+  seg.p2 = MapXY(far_abs.x, far_abs.y);
+  extended_segments_.push_back(seg);
+}
+
 // return true when either front wheel is outside the U-turn lanes.
 bool Uturn::outside_lanes_front(void)
 {
@@ -766,6 +799,8 @@ void Uturn::reset_me(void)
   state = Wait;
   do_init = true;
   uturn_polys.clear();
+  curb_segments_.clear();
+  extended_segments_.clear();
 }
 
 // set new state
@@ -47,7 +47,21 @@ private:
   poly uturn_entry;		        // U-turn entry (goal) poly
   poly_list_t  uturn_polys;		// polygons for U-turn lanes
 
-  float calculate_arc_length(bool forward, const MapXY& center, 
+  // right curb line segment in the direction of the lane
+  typedef struct
+  {
+    MapXY p1;				// bottom right corner
+    MapXY p2;				// top right corner
+  } curb_segment_t;
+
+  // turn plan: curb segments extracted once when the U-turn is
+  // initiated, replayed every cycle with pose-relative updates only
+  std::vector<curb_segment_t> curb_segments_;	  // one per U-turn poly
+  std::vector<curb_segment_t> extended_segments_; // entry, exit extended
+
+  void add_extended_curb(const MapXY &midpoint);
+  void build_turn_plan(void);
+  float calculate_arc_length(bool forward, const MapXY& center,
 			     float safety_radius,
 			     const MapXY& p1, const MapXY& p2);
   bool circle_and_line_intersect(MapXY center, float radius,
@@ -20,11 +20,15 @@
 #include <art/steering.h>
 #include "safety.h"
 #include "halt.h"
+#include "zone_grid.h"
 
-VoronoiZone::VoronoiZone(Navigator *navptr, int _verbose):
+VoronoiZone::VoronoiZone(Navigator *navptr, int _verbose,
+			 ZoneObstacleGrid *grid):
   Controller(navptr, _verbose), in_fake_zone(false)
 {
+  zone_grid = grid;
   zmanager = NULL;
+  cached_path_valid = false;
   safety = new Safety(navptr, _verbose, 1);
   halt = new Halt(navptr, _verbose);
   park = new PARK_control(navptr, _verbose);
@@ -85,7 +89,15 @@ void VoronoiZone::configure(ConfigFile* cf, int section)
 
   zone_aim_point = cf->ReadFloat(section, "zone_aim_point", 8.0);
   ART_MSG(2, "\tzone_aim_point is %.3f", zone_aim_point);
-  
+
+  // how far an obstacle must move before the cached Voronoi path is
+  // recomputed
+  zone_obstacle_change_threshold =
+    cf->ReadFloat(section, "zone_obstacle_change_threshold", 1.0);
+  ART_MSG(2, "\tzone_obstacle_change_threshold is %.1f m",
+	  zone_obstacle_change_threshold);
+
+
   safety->configure(cf, section);
   halt->configure(cf, section);
   park->configure(cf, section);
@@ -149,9 +161,44 @@ void VoronoiZone::reset(void)
     delete zmanager;
   zmanager = NULL;
 
+  cached_path_valid = false;
+  cached_path.clear();
+  cached_obs_points.clear();
+
+  if (zone_grid)			// leaving the zone
+    zone_grid->clear();
+
   spot_points.clear();
 }
 
+// compare the current obstacle points against the set the cached path
+// was computed from
+//
+// returns: true if any obstacle moved more than
+// zone_obstacle_change_threshold, or if points appeared or vanished.
+//
+bool VoronoiZone::obstacles_changed(const mapxy_list_t &obs_points)
+{
+  if (obs_points.size() != cached_obs_points.size())
+    return true;
+
+  for (unsigned i = 0; i < obs_points.size(); i++)
+    {
+      float closest = zone_obstacle_change_threshold;
+      for (unsigned j = 0; j < cached_obs_points.size(); j++)
+	{
+	  float d = Euclidean::DistanceTo(obs_points.at(i),
+					  cached_obs_points.at(j));
+	  if (d < closest)
+	    closest = d;
+	}
+      if (closest >= zone_obstacle_change_threshold)
+	return true;
+    }
+
+  return false;
+}
+
 // set heading to next way-point
 Controller::result_t VoronoiZone::set_heading(pilot_command_t &pcmd)
 {
@@ -250,7 +297,35 @@ Controller::result_t VoronoiZone::set_heading(pilot_command_t &pcmd)
   else if (!course->curr_spot())
     spot_points.clear();
 
-  mapxy_list_t obs_points=obstacle->lasers->all_obstacle_list;
+  mapxy_list_t obs_points;
+  if (zone_grid)
+    {
+      // Accumulate this cycle's observations in the persistent zone
+      // grid and plan against its contents, so obstacles seen earlier
+      // in the zone stay in the picture even when occluded now.
+      if (!zone_grid->active())
+	{
+	  const ZonePerimeter &zone =
+	    course->zone_perimeter(order->waypt[1].id.seg);
+	  if (zone.perimeter_points.size() >= 3)
+	    {
+	      MapXY ur = zone.perimeter_points[0].map;
+	      MapXY ll = ur;
+	      ZoneOps::expand_bounding_box_of_waypoints(zone.perimeter_points,
+							ll, ur);
+	      zone_grid->set_bounds(ll, ur);
+	    }
+	}
+      if (zone_grid->active())
+	{
+	  zone_grid->update(obstacle->lasers->all_obstacle_list);
+	  zone_grid->get_points(obs_points);
+	}
+    }
+  if (obs_points.empty())
+    // no grid coverage (fake zone, or none allocated): plan against
+    // the raw sensor points as before
+    obs_points = obstacle->lasers->all_obstacle_list;
 
   for (uint i=0;i<spot_points.size();i++)
     obs_points.push_back(spot_points.at(i));
@@ -263,7 +338,19 @@ Controller::result_t VoronoiZone::set_heading(pilot_command_t &pcmd)
    
     WayPointNodeList nodes;
     bool use_zone_manager = false;
-    if(use_zone_manager) {
+
+    // Reuse last cycle's path while the goal and the obstacle set are
+    // essentially unchanged, instead of rebuilding the Voronoi
+    // diagram from scratch.  The aim-point walk below still evaluates
+    // the path against the current vehicle position.
+    bool reuse_path = (cached_path_valid &&
+		       cached_end == end &&
+		       !obstacles_changed(obs_points));
+    if(reuse_path) {
+      ART_MSG(8, "Reusing cached zone path");
+      nodes = cached_path;
+    }
+    else if(use_zone_manager) {
       bool is_a_zone = ZoneOps::is_a_zone_id(course->zones,
 					     order->waypt[1].id.seg);
       if(zmanager == NULL ||
@@ -275,9 +362,9 @@ Controller::result_t VoronoiZone::set_heading(pilot_command_t &pcmd)
 	  delete zmanager;	
 	}
 	
-	ZonePerimeter zone =
-	  ZoneOps::get_zone_by_id(course->zones, order->waypt[1].id.seg);
-	
+	// copied, since a fake zone may replace it below
+	ZonePerimeter zone = course->zone_perimeter(order->waypt[1].id.seg);
+
 	if(zone.perimeter_points.size() < 3) {
 	  std::vector<MapXY> points_to_include;
 	  points_to_include.push_back(start);
@@ -335,9 +422,9 @@ Controller::result_t VoronoiZone::set_heading(pilot_command_t &pcmd)
       
     }
     else {
-      ZonePerimeter zone =
-	ZoneOps::get_zone_by_id(course->zones, order->waypt[1].id.seg);
-      
+      // copied, since a fake zone may replace it below
+      ZonePerimeter zone = course->zone_perimeter(order->waypt[1].id.seg);
+
       bool use_lane_based_zones = false;
       if(use_lane_based_zones) {
 	if(order->waypt[1].id.seg == 10 && order->waypt[0].id.seg == 10) {
@@ -411,6 +498,14 @@ Controller::result_t VoronoiZone::set_heading(pilot_command_t &pcmd)
 				   zone_evg_thin_scale,
 				   zone_grid_max_cells);
     }
+
+    if(!reuse_path) {
+      cached_path = nodes;
+      cached_obs_points = obs_points;
+      cached_end = end;
+      cached_path_valid = true;
+    }
+
     ART_MSG(8, "EXITING path_through_zone().");
     //    ART_MSG(1, "Current path size=%d", nodes.size());
     
@@ -17,12 +17,14 @@
 class Safety;
 class Halt;
 class ZoneManager;
+class ZoneObstacleGrid;
 
 class VoronoiZone: public Controller
 {
 public:
 
-  VoronoiZone(Navigator *navptr, int _verbose);
+  VoronoiZone(Navigator *navptr, int _verbose,
+	      ZoneObstacleGrid *grid = NULL);
   ~VoronoiZone();
   void configure();
   result_t control(pilot_command_t &pcmd);
@@ -50,8 +52,21 @@ private:
   Safety *safety;
   Halt *halt;
 
+  // persistent zone occupancy grid, shared with RealZone (not owned)
+  ZoneObstacleGrid *zone_grid;
+
+  // Voronoi path cached between cycles, reused while the obstacle set
+  // is stable and the goal unchanged
+  bool cached_path_valid;
+  WayPointNodeList cached_path;
+  mapxy_list_t cached_obs_points;
+  MapXY cached_end;
+  float zone_obstacle_change_threshold;
+
   Controller::result_t set_heading(pilot_command_t &pcmd);
 
+  bool obstacles_changed(const mapxy_list_t &obs_points);
+
   rotate_translate_transform trans;
 
   PolyOps pops;
@@ -0,0 +1,133 @@
+/* -*- mode: C++ -*-
+ *
+ *  Navigator zone obstacle grid
+ *
+ *  Copyright (C) 2007, 2010, Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef __ZONE_GRID_HH__
+#define __ZONE_GRID_HH__
+
+/** @brief Persistent zone occupancy grid.
+ *
+ *  Accumulates obstacle observations over the zone's bounding box
+ *  while the vehicle drives an unstructured zone, so the planner
+ *  works from everything seen since entry instead of rebuilding its
+ *  obstacle representation from each sensor cycle alone.  Cells
+ *  expire after a configurable number of cycles without a fresh
+ *  observation, letting moving obstacles clear out.  One instance is
+ *  shared by the zone controllers and cleared when the zone is left.
+ */
+class ZoneObstacleGrid
+{
+public:
+
+  ZoneObstacleGrid()
+  {
+    cell_size = 0.5;
+    expire_cycles = 50;
+    max_cells = 250000;
+    active_ = false;
+    cycle_ = 0;
+  };
+
+  ~ZoneObstacleGrid() {};
+
+  void configure(ConfigFile* cf, int section)
+  {
+    cell_size = cf->ReadFloat(section, "zone_grid_cell_size", 0.5);
+    ART_MSG(2, "\tzone_grid_cell_size is %.2f m", cell_size);
+
+    expire_cycles = cf->ReadInt(section, "zone_grid_expire_cycles", 50);
+    ART_MSG(2, "\tzone_grid_expire_cycles is %d", expire_cycles);
+
+    max_cells = cf->ReadInt(section, "zone_grid_max_cells", 250000);
+    ART_MSG(2, "\tzone_grid_max_cells is %d", max_cells);
+  }
+
+  /** @brief true when covering a zone */
+  bool active(void) const {return active_;}
+
+  /** @brief cover a new zone bounding box, dropping any old contents
+   *
+   *  Coarsens the cell size as needed to respect max_cells, so a
+   *  large zone cannot exhaust memory.
+   */
+  void set_bounds(MapXY ll, MapXY ur)
+  {
+    ll_ = ll;
+    float width = ur.x - ll.x;
+    float height = ur.y - ll.y;
+    scale_ = cell_size;
+    while ((int) (width / scale_ + 1) * (int) (height / scale_ + 1)
+	   > max_cells)
+      scale_ *= 2;
+    cols_ = (int) (width / scale_) + 1;
+    rows_ = (int) (height / scale_) + 1;
+    last_seen_.assign(cols_ * rows_, -1);
+    cycle_ = 0;
+    active_ = true;
+  }
+
+  /** @brief merge one cycle of obstacle points into the grid */
+  void update(const mapxy_list_t &points)
+  {
+    if (!active_)
+      return;
+    ++cycle_;
+    for (unsigned i = 0; i < points.size(); i++)
+      {
+	int col = (int) ((points.at(i).x - ll_.x) / scale_);
+	int row = (int) ((points.at(i).y - ll_.y) / scale_);
+	if (col < 0 || col >= cols_ || row < 0 || row >= rows_)
+	  continue;			// outside the zone
+	last_seen_[row * cols_ + col] = cycle_;
+      }
+  }
+
+  /** @brief append the centers of all live cells to @a points
+   *
+   *  Cells expire lazily here, so update() stays one store per
+   *  observed point with no per-cycle sweep of the whole grid.
+   */
+  void get_points(mapxy_list_t &points) const
+  {
+    for (int row = 0; row < rows_; row++)
+      for (int col = 0; col < cols_; col++)
+	{
+	  int seen = last_seen_[row * cols_ + col];
+	  if (seen < 0 || cycle_ - seen > expire_cycles)
+	    continue;
+	  points.push_back(MapXY(ll_.x + (col + 0.5) * scale_,
+				 ll_.y + (row + 0.5) * scale_));
+	}
+  }
+
+  /** @brief drop all contents, called when leaving the zone */
+  void clear(void)
+  {
+    active_ = false;
+    last_seen_.clear();
+  }
+
+private:
+
+  // .cfg variables
+  float cell_size;			// requested cell size (m)
+  int expire_cycles;			// cycles until a cell expires
+  int max_cells;			// grid allocation limit
+
+  bool active_;				// grid covers a zone
+  MapXY ll_;				// lower left corner of the zone
+  float scale_;				// actual cell size (m)
+  int cols_;				// grid columns
+  int rows_;				// grid rows
+  int cycle_;				// update cycle counter
+  std::vector<int> last_seen_;		// cycle each cell was last hit
+};
+
+#endif // __ZONE_GRID_HH__
@@ -0,0 +1,276 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Headless bag-replay benchmark for the navigator.
+
+     Replays recorded navigator inputs straight into
+     Navigator::navigate() without the ROS graph, applying each
+     message the same way the queue manager control cycle does, and
+     times every cycle.  The per-controller breakdown comes from the
+     navigator's own timing instrumentation, so the numbers are
+     directly comparable with the on-vehicle diagnostics.  Run it
+     before and after changing a controller to quantify the
+     difference.
+
+     @section Synopsis
+
+     nav_bench [bagfile]
+
+     The bag should contain the topics the navigator subscribes to:
+
+        navigator/cmd   (art_msgs/NavigatorCommand)
+        odom            (nav_msgs/Odometry)
+        roadmap_local   (art_msgs/ArtLanes)
+        observations    (art_msgs/ObservationArray)
+
+     ROS time is driven from the bag, so message age calculations
+     behave as they did during the recording.  With no bag argument a
+     built-in idle sequence is replayed, so the benchmark also runs
+     without log data, exercising only the E-stop cycle machinery.
+
+     @author Jack O'Quin
+
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+#include <art_msgs/ArtHertz.h>
+#include <art_msgs/ArtLanes.h>
+
+#include "../src/navigator/navigator_internal.h"
+#include "../src/navigator/course.h"
+#include "../src/navigator/obstacle.h"
+
+namespace
+{
+
+/** replay state: the bench stands in for the queue manager */
+class NavBench
+{
+ public:
+
+  NavBench():
+    nav_(&odom_msg_),
+    last_order_seq_(-1),
+    next_cycle_(0, 0)
+  {
+    // run with the default configuration, as reconfig() would set it
+    nav_.config_ = Config::__getDefault__();
+    nav_.configure();
+    latencies_.reserve(64 * 1024);
+  }
+
+  /** Apply one commander order, as applySnapshots() would. */
+  void apply_order(const NavigatorCommand &cmd)
+  {
+    if ((int) cmd.order.seq != last_order_seq_)
+      {
+        // new order, not just a heartbeat repeat of the current one
+        last_order_seq_ = cmd.order.seq;
+        nav_.order = cmd.order;
+      }
+  }
+
+  /** Apply one odometry estimate. */
+  void apply_odometry(const Odometry &odom)
+  {
+    odom_msg_ = odom;
+  }
+
+  /** Apply one recorded message, as applySnapshots() would. */
+  void apply(const rosbag::MessageInstance &m)
+  {
+    // drive ROS time from the bag, so message age calculations
+    // behave as they did during the recording
+    ros::Time::setNow(m.getTime());
+
+    NavigatorCommand::ConstPtr cmd = m.instantiate<NavigatorCommand>();
+    if (cmd)
+      {
+        apply_order(*cmd);
+        return;
+      }
+
+    Odometry::ConstPtr odom = m.instantiate<Odometry>();
+    if (odom)
+      {
+        apply_odometry(*odom);
+        return;
+      }
+
+    art_msgs::ArtLanes::ConstPtr map = m.instantiate<art_msgs::ArtLanes>();
+    if (map)
+      {
+        nav_.course->lanes_message(*map);
+        return;
+      }
+
+    ObservationArray::ConstPtr obs = m.instantiate<ObservationArray>();
+    if (obs)
+      nav_.obstacle->observers_message(obs);
+  }
+
+  /** Run any control cycles due by bag time @a now. */
+  void run_due_cycles(const ros::Time &now)
+  {
+    ros::Duration period(1.0 / art_msgs::ArtHertz::NAVIGATOR);
+    if (next_cycle_.isZero())
+      next_cycle_ = now + period;       // first message: start the clock
+
+    while (next_cycle_ <= now)
+      {
+        ros::WallTime before = ros::WallTime::now();
+        nav_.navigate();
+        latencies_.push_back((ros::WallTime::now() - before).toSec());
+        next_cycle_ += period;
+      }
+  }
+
+  /** Report cycle latency distribution and controller breakdown. */
+  void report(void)
+  {
+    if (latencies_.empty())
+      {
+        ROS_ERROR("no navigator cycles replayed");
+        return;
+      }
+
+    std::sort(latencies_.begin(), latencies_.end());
+    double mean = 0.0;
+    for (unsigned i = 0; i < latencies_.size(); ++i)
+      mean += latencies_[i];
+    mean /= latencies_.size();
+    double p99 = latencies_[(latencies_.size() * 99) / 100];
+    double worst = latencies_[latencies_.size() - 1];
+
+    printf("%u navigator cycles: "
+           "latency mean %.1f us, p99 %.1f us, max %.1f us\n",
+           (unsigned) latencies_.size(),
+           mean * 1.0e6, p99 * 1.0e6, worst * 1.0e6);
+
+    // per-controller breakdown from the navigator's own timing
+    // instrumentation, same histograms as the vehicle diagnostics
+    nav_.timing.log_summary();
+  }
+
+ private:
+
+  nav_msgs::Odometry odom_msg_;         // odometry for the navigator
+  Navigator nav_;                       // navigator under test
+  int last_order_seq_;                  // last commander order sequence
+  ros::Time next_cycle_;                // next control cycle due (bag time)
+  std::vector<double> latencies_;       // per-cycle wall clock latency
+};
+
+/** replay a recorded bag through the navigator */
+bool replay_bag(const char *path, NavBench &bench)
+{
+  rosbag::Bag bag;
+  try
+    {
+      bag.open(path, rosbag::bagmode::Read);
+    }
+  catch (rosbag::BagException &e)
+    {
+      ROS_ERROR("unable to open bag file %s: %s", path, e.what());
+      return false;
+    }
+
+  std::vector<std::string> topics;
+  topics.push_back("navigator/cmd");
+  topics.push_back("odom");
+  topics.push_back("roadmap_local");
+  topics.push_back("observations");
+
+  rosbag::View view(bag, rosbag::TopicQuery(topics));
+  unsigned messages = 0;
+  for (rosbag::View::iterator it = view.begin(); it != view.end(); ++it)
+    {
+      bench.apply(*it);
+      bench.run_due_cycles(it->getTime());
+      ++messages;
+    }
+  bag.close();
+
+  if (messages == 0)
+    {
+      ROS_ERROR("no navigator input topics found in %s", path);
+      return false;
+    }
+
+  ROS_INFO("replayed %u messages from %s", messages, path);
+  return true;
+}
+
+/** replay a built-in idle sequence: Pause orders and stationary
+ *  odometry, enough to time the cycle machinery without log data
+ */
+void replay_synthetic(NavBench &bench)
+{
+  ros::Time t(1.0);                     // arbitrary nonzero epoch
+  ros::Duration period(1.0 / art_msgs::ArtHertz::NAVIGATOR);
+
+  for (int cycle = 0; cycle < 30 * (int) art_msgs::ArtHertz::NAVIGATOR;
+       ++cycle)
+    {
+      ros::Time::setNow(t);
+
+      // Pause order heartbeat at 2Hz, as the commander sends them
+      if (cycle % ((int) art_msgs::ArtHertz::NAVIGATOR / 2) == 0)
+        {
+          NavigatorCommand cmd;
+          cmd.header.stamp = t;
+          cmd.order.seq = cycle;
+          cmd.order.behavior.value = art_msgs::Behavior::Pause;
+          // apply directly: no MessageInstance for local data
+          bench.apply_order(cmd);
+        }
+
+      Odometry odom;
+      odom.header.stamp = t;
+      bench.apply_odometry(odom);
+
+      bench.run_due_cycles(t);
+      t += period;
+    }
+}
+
+}; // anonymous namespace
+
+/** main entry point */
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "nav_bench");
+  ros::NodeHandle node;                 // for controller subscriptions
+
+  NavBench bench;
+
+  if (argc > 1)
+    {
+      if (!replay_bag(argv[1], bench))
+        return 1;
+    }
+  else
+    {
+      ROS_INFO("no bag file given, replaying built-in idle sequence");
+      replay_synthetic(bench);
+    }
+
+  bench.report();
+  return 0;
+}
@@ -0,0 +1,122 @@
+/* -*- mode: C++ -*-
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART observers per-lane quad partition.
+
+     Lane selections used to scan every quad of the local road map
+     once per observer per cycle.  This partition is rebuilt once per
+     local map message: it groups the indices of all non-transition
+     quads sharing a (segment, lane) pair, contiguously and in map
+     order.  A lane selection then walks just its own group.
+
+     @author Michael Quinlan
+
+ */
+
+#ifndef __LANE_PARTITION_H__
+#define __LANE_PARTITION_H__
+
+#include <vector>
+
+#include <art_msgs/ArtLanes.h>
+#include <art_observers/QuadrilateralOps.h>
+
+namespace quad_ops
+{
+  /** Per-lane partition of the quads of an ArtLanes map. */
+  class LanePartition
+  {
+  public:
+
+    LanePartition(): total_(0) {}
+
+    /** Rebuild the partition from a local road map.
+     *
+     *  @param quads local map; the caller must keep the message
+     *               alive and unmodified while the partition is in use
+     */
+    void rebuild(const art_msgs::ArtLanes &quads);
+
+    /** Discard the partition contents. */
+    void clear(void);
+
+    /** True if nothing is partitioned. */
+    bool empty(void) const {return groups_.empty();}
+
+    /** Number of map polygons the partition was built from. */
+    size_t size(void) const {return total_;}
+
+    /** Select quads from the lane containing @a base.
+     *
+     *  Equivalent to filterLanes(base, quads, filter) when the
+     *  partition was built from @a quads, but only the quads sharing
+     *  the base quad's lane are visited.
+     *
+     *  @param base quad whose lane is selected
+     *  @param quads the map this partition was built from
+     *  @param filter lane comparison predicate, as for filterLanes()
+     */
+    art_msgs::ArtLanes filterLanes(const Quad &base,
+				   const art_msgs::ArtLanes &quads,
+				   bool(*filter)(const Quad&,
+						 const Quad&)) const;
+
+    /** Select quads from the lane containing @a base into a view
+     *  over @a quads, without copying them.
+     */
+    void filterLanes(const Quad &base,
+		     const art_msgs::ArtLanes &quads,
+		     bool(*filter)(const Quad&, const Quad&),
+		     QuadView &view) const;
+
+  private:
+
+    /// grouping key: start and end segment and lane IDs
+    struct LaneKey
+    {
+      uint16_t start_seg;
+      uint16_t start_lane;
+      uint16_t end_seg;
+      uint16_t end_lane;
+
+      bool operator<(const LaneKey &that) const
+      {
+	if (start_seg != that.start_seg)   return start_seg < that.start_seg;
+	if (start_lane != that.start_lane) return start_lane < that.start_lane;
+	if (end_seg != that.end_seg)	   return end_seg < that.end_seg;
+	return end_lane < that.end_lane;
+      }
+      bool operator==(const LaneKey &that) const
+      {
+	return (start_seg == that.start_seg
+		&& start_lane == that.start_lane
+		&& end_seg == that.end_seg
+		&& end_lane == that.end_lane);
+      }
+    };
+
+    static LaneKey keyOf(const Quad &q);
+
+    /// one lane group: a range of indexes_
+    struct Group
+    {
+      LaneKey key;
+      int begin;
+      int end;
+    };
+
+    std::vector<Group> groups_;		///< lane groups, sorted by key
+    std::vector<int> indexes_;		///< quad indices, grouped, map order
+    size_t total_;			///< map polygon count at rebuild
+  };
+
+} // namespace quad_ops
+
+#endif // __LANE_PARTITION_H__
@@ -33,7 +33,12 @@ namespace art_observers
     /// default constructor
     ObserversConfig():
       map_frame_id(std::string("/map")),
-      robot_frame_id(std::string("vehicle"))
+      robot_frame_id(std::string("vehicle")),
+      parallel_observers(false),
+      voxel_size(0.0),
+      heartbeat_period(1.0),
+      gate_observers(true),
+      backward_gate_speed(0.0)
     {};
     ObserversConfig(const ObserversConfig &that)
     {
@@ -44,6 +49,18 @@ namespace art_observers
       // get configuration parameters
       priv_nh.param("map_frame_id", map_frame_id, std::string("/map"));
       priv_nh.param("robot_frame_id", robot_frame_id, std::string("vehicle"));
+      priv_nh.param("parallel_observers", parallel_observers, false);
+      if (parallel_observers)
+	ROS_INFO("running observers in parallel");
+      priv_nh.param("voxel_size", voxel_size, 0.0);
+      if (voxel_size > 0.0)
+	ROS_INFO("deduplicating obstacle points in %.2fm cells", voxel_size);
+      priv_nh.param("heartbeat_period", heartbeat_period, 1.0);
+      priv_nh.param("gate_observers", gate_observers, true);
+      priv_nh.param("backward_gate_speed", backward_gate_speed, 0.0);
+      if (backward_gate_speed > 0.0)
+	ROS_INFO("gating backward observer above %.1f m/s",
+		 backward_gate_speed);
 
       // apply tf_prefix to robot frame ID, if needed
       std::string tf_prefix = tf::getPrefixParam(priv_nh);
@@ -55,6 +72,16 @@ namespace art_observers
 
     std::string map_frame_id;		///< frame ID of map
     std::string robot_frame_id;		///< frame ID of robot
+    bool parallel_observers;		///< run observers concurrently
+    double voxel_size;			///< obstacle dedup cell size
+					///  in meters, 0.0 disables
+    double heartbeat_period;		///< seconds between publications
+					///  when observations unchanged
+    bool gate_observers;		///< skip observers whose map
+					///  context makes them irrelevant
+    double backward_gate_speed;		///< skip the backward observer
+					///  above this speed (m/s) when
+					///  nothing is behind, 0 disables
   };
 
 }; // namespace art_observers
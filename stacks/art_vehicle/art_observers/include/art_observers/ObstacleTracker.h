@@ -0,0 +1,109 @@
+/* -*- mode: C++ -*-
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART observers obstacle track store.
+
+     Every observer recomputes its nearest obstacle from scratch each
+     cycle, so nothing in the pipeline knows whether this cycle's
+     obstacle is the same object as last cycle's.  ObstacleTracker
+     associates the per-cycle obstacle quads into per-lane tracks with
+     stable IDs, maintaining a filtered velocity for each track with
+     the shared observer filter classes.  Observers use the IDs to
+     keep their derived values consistent across cycles, and the
+     tracks are published for downstream consumers.
+
+     @author Michael Quinlan
+
+ */
+
+#ifndef _OBSTACLE_TRACKER_H_
+#define _OBSTACLE_TRACKER_H_
+
+#include <vector>
+
+#include <art_msgs/ArtLanes.h>
+#include <art_msgs/ObstacleTrackArray.h>
+#include <art_observers/filter.h>
+
+namespace observers
+{
+
+/** Per-lane obstacle track store. */
+class ObstacleTracker
+{
+public:
+
+  /** One tracked obstacle. */
+  struct Track
+  {
+    uint32_t id;			///< stable track ID
+    int16_t seg;			///< lane containing the obstacle
+    int16_t lane;
+    float x, y;				///< last associated position
+    float vx, vy;			///< filtered velocity (m/s)
+    uint32_t age;			///< updates since track start
+    int misses;				///< cycles since last association
+    MeanFilter vx_filter_;		///< velocity smoothing state
+    MeanFilter vy_filter_;
+  };
+
+  ObstacleTracker(): next_id_(0) {}
+
+  /** Associate this cycle's obstacle quads with the tracks.
+   *
+   *  Matched tracks get a new velocity sample, unmatched detections
+   *  start new tracks, and tracks missing for several cycles are
+   *  dropped.
+   *
+   *  @param obstacle_quads road map quads containing obstacles
+   *  @param stamp time of the obstacle data
+   */
+  void update(const art_msgs::ArtLanes &obstacle_quads,
+	      const ros::Time &stamp);
+
+  /** Track ID of the obstacle in a road map quad.
+   *
+   *  @param quad map quad containing the obstacle
+   *  @return track ID, -1 if the quad matches no track
+   */
+  int trackId(const art_msgs::ArtQuadrilateral &quad) const;
+
+  /** Drop every track. */
+  void clear(void);
+
+  /** Copy all tracks to an ObstacleTrackArray message. */
+  void toMsg(art_msgs::ObstacleTrackArray &msg) const;
+
+  /** Number of live tracks. */
+  size_t size(void) const {return tracks_.size();}
+
+private:
+
+  /** One coalesced obstacle detection. */
+  struct Detection
+  {
+    int16_t seg;			///< lane of the detection
+    int16_t lane;
+    float x, y;				///< position (quad midpoints)
+    int quads;				///< quads coalesced into it
+    int track;				///< matched track index or -1
+  };
+
+  void collectDetections(const art_msgs::ArtLanes &obstacle_quads,
+			 std::vector<Detection> &detections) const;
+
+  std::vector<Track> tracks_;		///< live tracks
+  uint32_t next_id_;			///< next track ID to assign
+  ros::Time prev_update_;		///< stamp of previous update
+};
+
+}; // namespace observers
+
+#endif // _OBSTACLE_TRACKER_H_
@@ -0,0 +1,87 @@
+/* -*- mode: C++ -*-
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART observers quadrilateral interval index.
+
+     Point-in-map queries used to scan every quad of the local road
+     map.  This index is rebuilt once per local map message: it stores
+     axis-aligned bounding boxes for all quads, sorted by minimum x
+     with a running maximum of the right edges.  A per-point query
+     binary-searches the sorted left edges and walks back only while
+     boxes can still straddle the point, so most quads are rejected
+     with two comparisons and never see a crossing test.
+
+     @author Michael Quinlan
+
+ */
+
+#ifndef __QUAD_INDEX_H__
+#define __QUAD_INDEX_H__
+
+#include <vector>
+
+#include <art_msgs/ArtLanes.h>
+#include <art_observers/QuadrilateralOps.h>
+
+namespace quad_ops
+{
+  /** Sorted interval index over the quads of an ArtLanes map. */
+  class QuadIndex
+  {
+  public:
+
+    QuadIndex() {}
+
+    /** Rebuild the index from a local road map.
+     *
+     *  @param quads local map; the caller must keep the message
+     *               alive and unmodified while the index is in use
+     */
+    void rebuild(const art_msgs::ArtLanes &quads);
+
+    /** Discard the index contents. */
+    void clear(void);
+
+    /** True if nothing is indexed. */
+    bool empty(void) const {return order_.empty();}
+
+    /** Number of quads indexed. */
+    size_t size(void) const {return order_.size();}
+
+    /** Collect indices of quads whose bounding box contains (x, y).
+     *
+     *  @param x, y map coordinates of query point
+     *  @param[out] candidates quad indices into the original map
+     *              polygon vector, cleared first
+     */
+    void getCandidates(float x, float y,
+                       std::vector<int> &candidates) const;
+
+    /** Bounding box of quad i (original map polygon order). */
+    float minX(int i) const {return min_x_[i];}
+    float maxX(int i) const {return max_x_[i];}
+    float minY(int i) const {return min_y_[i];}
+    float maxY(int i) const {return max_y_[i];}
+
+  private:
+
+    // bounding boxes in original map polygon order
+    std::vector<float> min_x_, max_x_, min_y_, max_y_;
+
+    // quad indices sorted by ascending min_x_, plus that sorted key
+    // and a running maximum of max_x_ over the sorted order
+    std::vector<int> order_;
+    std::vector<float> sorted_min_x_;
+    std::vector<float> running_max_x_;
+  };
+
+} // namespace quad_ops
+
+#endif // __QUAD_INDEX_H__
@@ -36,12 +36,114 @@ namespace quad_ops
                    const geometry_msgs::Point32 *p4);  
 
   bool quickPointInPoly(float x, float y, const Quad& p);
-  
+
   bool quickPointInPolyRatio(float x, float y, const Quad& p, float ratio);
 
+  /** Batch test of N points against one quad.
+   *
+   *  Equivalent to calling quickPointInPolyRatio() for each point,
+   *  but runs the unrolled crossing tests four points at a time with
+   *  SSE when available.  Intended for the per-cycle obstacle cloud
+   *  filtering, where hundreds of thousands of point/quad tests
+   *  happen per cycle.
+   *
+   *  @param x, y contiguous point coordinate arrays of length n
+   *  @param n number of points
+   *  @param p quad to test against
+   *  @param ratio inner percentage of the quad to use (1.0 for all)
+   *  @param[out] inside per-point result bytes (0 or 1), length n
+   *  @return number of points inside
+   */
+  size_t pointsInPolyBatch(const float *x, const float *y, size_t n,
+                           const Quad& p, float ratio,
+                           unsigned char *inside);
+
+  /** Early-exit batch test: true if any of the N points is inside
+   *  the quad.  Same kernel as pointsInPolyBatch(). */
+  bool anyPointInPoly(const float *x, const float *y, size_t n,
+                      const Quad& p, float ratio);
+
+  /** Batch test of one point against N quads.
+   *
+   *  @param x, y point to test
+   *  @param quads quads to test against
+   *  @param ratio inner percentage of each quad to use (1.0 for all)
+   *  @param[out] inside per-quad result bytes (0 or 1), resized to
+   *              quads.size()
+   */
+  void pointInPolysBatch(float x, float y,
+                         const std::vector<Quad> &quads, float ratio,
+                         std::vector<unsigned char> &inside);
+
   art_msgs::ArtLanes filterLanes(const Quad& base_quad,
                                  const art_msgs::ArtLanes& quads,
                                  bool(*filter)(const Quad&, const Quad&));
+
+  /** Read-only view of selected quads in an ArtLanes message.
+   *
+   *  Holds indices into the polygons array of the source message
+   *  instead of copying the selected quads, so building a lane
+   *  selection costs one integer per quad.  Only valid while the
+   *  source message stays alive and unmodified.
+   */
+  class QuadView
+  {
+  public:
+
+    QuadView(): source_(NULL) {}
+
+    /** forward iterator over the selected quads */
+    class const_iterator
+    {
+    public:
+      const_iterator(const QuadView *view, size_t pos):
+        view_(view), pos_(pos) {}
+      const Quad& operator*() const {return (*view_)[pos_];}
+      const Quad* operator->() const {return &(*view_)[pos_];}
+      const_iterator& operator++() {++pos_; return *this;}
+      bool operator==(const const_iterator &that) const
+        {return pos_ == that.pos_;}
+      bool operator!=(const const_iterator &that) const
+        {return pos_ != that.pos_;}
+    private:
+      const QuadView *view_;
+      size_t pos_;
+    };
+
+    /** Reset the view, optionally attaching a new source message. */
+    void clear(const art_msgs::ArtLanes *source = NULL)
+    {
+      source_ = source;
+      indices_.clear();
+    }
+
+    /** Add the source polygon with index @a i to the view. */
+    void push_back(size_t i) {indices_.push_back(i);}
+
+    size_t size(void) const {return indices_.size();}
+    bool empty(void) const {return indices_.empty();}
+
+    /** The i-th selected quad, in selection order. */
+    const Quad& operator[](size_t i) const
+      {return source_->polygons[indices_[i]];}
+
+    const_iterator begin(void) const {return const_iterator(this, 0);}
+    const_iterator end(void) const
+      {return const_iterator(this, indices_.size());}
+
+  private:
+
+    const art_msgs::ArtLanes *source_;	///< viewed message (not owned)
+    std::vector<size_t> indices_;	///< selected polygon indices
+  };
+
+  /** Select quads into a view over the original message, without
+   *  copying them.  Same selection as the copying filterLanes().
+   */
+  void filterLanes(const Quad& base_quad,
+                   const art_msgs::ArtLanes& quads,
+                   bool(*filter)(const Quad&, const Quad&),
+                   QuadView &view);
   art_msgs::ArtLanes filterAdjacentLanes(MapPose &pose,
                                  const art_msgs::ArtLanes& quads,
                                  const int lane);
@@ -77,13 +179,64 @@ namespace quad_ops
 
   inline bool compare_backward_seg_lane(const Quad& base, const Quad& comp)
   {
-    return ( (base.poly_id > comp.poly_id) && 
-             (base.start_way.seg == comp.start_way.seg) && 
+    return ( (base.poly_id > comp.poly_id) &&
+             (base.start_way.seg == comp.start_way.seg) &&
              (base.start_way.lane == comp.start_way.lane) &&
-             (base.end_way.seg == comp.end_way.seg) && 
+             (base.end_way.seg == comp.end_way.seg) &&
              (base.end_way.lane == comp.end_way.lane) &&
              (!comp.is_transition) );
   };
+
+  class LanePartition;			// forward declaration
+
+  /** Per-cycle cache of shared lane filtering products.
+   *
+   *  Several observers re-derive the same data from the local map and
+   *  obstacle quads every cycle: the polygon containing the robot and
+   *  the filtered quads for the current and adjacent lanes.  The
+   *  driver fills this cache once per obstacle cloud, then every
+   *  observer reads from it.  The cache is strictly read-only while
+   *  the observers run, so they may run concurrently.
+   */
+  class FilterCache
+  {
+  public:
+    FilterCache():
+      have_robot_quad(false),
+      index_left(-1),
+      index_right(-1)
+    {};
+
+    /** @param partition per-lane partition of local_map, or NULL to
+     *         select lane quads by scanning the whole map
+     */
+    void update(const art_msgs::ArtLanes &local_map,
+                const art_msgs::ArtLanes &obstacles,
+                MapPose pose,
+                const LanePartition *partition);
+
+    bool have_robot_quad;		///< robot_quad below is valid
+    Quad robot_quad;			///< polygon containing the robot
+
+    // The current-lane map selections are views over the local map
+    // message (valid until the next map arrives), so the hundreds of
+    // quads in the lane are never copied.  The adjacent lanes go
+    // through a PolyOps conversion that reorders by lane direction,
+    // so they remain copies.
+    QuadView lanes_forward;		///< current lane quads ahead
+    art_msgs::ArtLanes obstacles_forward; ///< obstacles ahead in lane
+    QuadView lanes_backward;		///< current lane quads behind
+    art_msgs::ArtLanes obstacles_backward; ///< obstacles behind in lane
+    // The adjacent lanes and their occupancy come from one lateral
+    // pass: a single map conversion serves both sides, and one
+    // traversal of the obstacle quads bins them into either lane.
+    art_msgs::ArtLanes lanes_left;	///< adjacent left lane quads
+    art_msgs::ArtLanes lanes_right;	///< adjacent right lane quads
+    art_msgs::ArtLanes obstacles_left;	///< obstacles in left lane
+    art_msgs::ArtLanes obstacles_right;	///< obstacles in right lane
+    int index_left;		///< closest left quad to robot (-1 if none)
+    int index_right;		///< closest right quad to robot (-1 if none)
+  };
 }
 
 #endif // __QUADRILATERAL_OPS_H__
@@ -32,10 +32,8 @@ public:
   AdjacentRight(art_observers::ObserversConfig &config);
   ~AdjacentRight();
 
-  virtual art_msgs::Observation
-    update(const art_msgs::ArtLanes &local_map,
-           const art_msgs::ArtLanes &obstacles,
-	   MapPose pose_);
+  virtual art_msgs::Observation update(const ObserverInput &input);
+  virtual bool applies(const ObserverInput &input);
 
 private:
 
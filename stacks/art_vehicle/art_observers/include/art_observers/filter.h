@@ -2,12 +2,12 @@
  *
  *  Copyright (C) 2011 Austin Robot Technology
  *  License: Modified BSD Software License Agreement
- * 
+ *
  *  $Id$
  */
 
 /**  @file
- 
+
      ART observers data filtering class interfaces.
 
      @author Michael Quinlan
@@ -17,26 +17,114 @@
 #ifndef _LANE_FILTER_H_
 #define _LANE_FILTER_H_
 
-#include <filters/mean.h>
-#include <filters/median.h>
-#include <filters/realtime_circular_buffer.h>
-
-class MedianFilter : public filters::MedianFilter<float> 
+/** Fixed-window median filter.
+ *
+ *  Keeps the window in a ring buffer and maintains a sorted copy of
+ *  it incrementally: each update removes the outgoing sample and
+ *  sorted-inserts the incoming one, instead of re-sorting the whole
+ *  window.  The window size is a compile-time parameter, so the
+ *  arrays live inside the object with no heap allocation.
+ */
+template <int W>
+class MedianFilterT
 {
 public:
-  MedianFilter();
-  ~MedianFilter();
-  bool configure();
-  bool isFull();
+  MedianFilterT(): next_(0), count_(0) {};
+
+  /** no-op, retained for interface compatibility */
+  bool configure() {return true;};
+
+  /** true when the window is fully populated */
+  bool isFull() {return count_ == W;};
+
+  /** add a sample, returning the median of the window in @a out */
+  bool update(const float &in, float &out)
+  {
+    if (count_ == W)			// window full: drop oldest
+      {
+	float old = ring_[next_];
+
+	// Find the outgoing sample in the sorted window.  NaN never
+	// compares equal to itself, so match NaN slots explicitly.
+	int pos = 0;
+	while (pos < count_ - 1
+	       && sorted_[pos] != old
+	       && !(old != old && sorted_[pos] != sorted_[pos]))
+	  ++pos;
+	for (; pos < count_ - 1; ++pos)
+	  sorted_[pos] = sorted_[pos+1];
+	--count_;
+      }
+
+    ring_[next_] = in;
+    next_ = (next_ + 1) % W;
+
+    // insert the incoming sample in sorted position
+    int pos = count_;
+    while (pos > 0 && sorted_[pos-1] > in)
+      {
+	sorted_[pos] = sorted_[pos-1];
+	--pos;
+      }
+    sorted_[pos] = in;
+    ++count_;
+
+    if (count_ & 1)
+      out = sorted_[count_/2];
+    else
+      out = 0.5f * (sorted_[count_/2 - 1] + sorted_[count_/2]);
+    return true;
+  };
+
+private:
+  float ring_[W];			///< samples in arrival order
+  float sorted_[W];			///< the same samples, sorted
+  int next_;				///< next ring slot to replace
+  int count_;				///< samples currently held
 };
 
-class MeanFilter : public filters::MeanFilter<float> 
+/** Fixed-window mean filter.
+ *
+ *  Same ring-buffer window as MedianFilterT.  The sum is recomputed
+ *  over the window each update: with only W terms that costs no more
+ *  than maintaining a running sum, and an infinite sample leaving the
+ *  window cannot leave NaN behind in an accumulator.
+ */
+template <int W>
+class MeanFilterT
 {
 public:
-  MeanFilter();
-  ~MeanFilter();
-  bool configure();
-  bool isFull();
+  MeanFilterT(): next_(0), count_(0) {};
+
+  /** no-op, retained for interface compatibility */
+  bool configure() {return true;};
+
+  /** true when the window is fully populated */
+  bool isFull() {return count_ == W;};
+
+  /** add a sample, returning the mean of the window in @a out */
+  bool update(const float &in, float &out)
+  {
+    ring_[next_] = in;
+    next_ = (next_ + 1) % W;
+    if (count_ < W)
+      ++count_;
+
+    double sum = 0.0;
+    for (int i = 0; i < count_; ++i)
+      sum += ring_[i];
+    out = sum / count_;
+    return true;
+  };
+
+private:
+  float ring_[W];			///< samples in arrival order
+  int next_;				///< next ring slot to replace
+  int count_;				///< samples currently held
 };
 
+/// window size shared by all current observers
+typedef MedianFilterT<5> MedianFilter;
+typedef MeanFilterT<5> MeanFilter;
+
 #endif // _LANE_FILTER_H_
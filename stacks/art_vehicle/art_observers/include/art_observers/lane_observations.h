@@ -21,10 +21,16 @@
 #include <vector>
 #include <tr1/unordered_set>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <ros/ros.h>
 
 #include <art_msgs/ArtLanes.h>
 #include <art_msgs/ObservationArray.h>
+#include <art_msgs/PipelineEvent.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
@@ -35,6 +41,10 @@
 #include <visualization_msgs/MarkerArray.h>
 #include <nav_msgs/Odometry.h>
 
+#include <art_observers/LanePartition.h>
+#include <art_observers/ObstacleTracker.h>
+#include <art_observers/QuadIndex.h>
+#include <art_observers/QuadrilateralOps.h>
 #include <art_observers/nearest_forward.h>
 #include <art_observers/nearest_backward.h>
 #include <art_observers/adjacent_left.h>
@@ -43,8 +53,12 @@
 #include <art_observers/ObserversConfig.h>
 typedef art_observers::ObserversConfig Config;
 
-class LaneObservations 
+class LaneObservations
 {
+  /// replay benchmark feeds recorded messages into the private
+  /// processing methods, bypassing ROS transport
+  friend class ObserversBench;
+
 public:
 
   LaneObservations(ros::NodeHandle &node,
@@ -77,7 +91,9 @@ private:
   void processPose(const nav_msgs::Odometry &odom);
   void publishObstacleVisualization();
   void runObservers();
+  void runOneObserver(const observers::ObserverInput &input, unsigned i);
   void transformPointCloud(const PtCloud &msg);
+  void vizThread();
 
   ros::NodeHandle node_;		///< node handle
   ros::NodeHandle priv_nh_;		///< private node handle
@@ -98,26 +114,102 @@ private:
   ros::Subscriber road_map_sub_;
   ros::Subscriber odom_sub_;
   ros::Publisher observations_pub_;
+  ros::Publisher tracks_pub_;		///< obstacle tracks output
   ros::Publisher viz_pub_;
+  ros::Publisher trace_pub_;		///< pipeline latency trace events
 
   PtCloud obstacles_;			///< current obstacle data
   art_msgs::ArtLanes local_map_;	///< local road map
 
+  /// bounding-box interval index over local_map_, rebuilt once per
+  /// map message
+  quad_ops::QuadIndex map_index_;
+
+  /// per-lane partition of local_map_, rebuilt once per map message
+  quad_ops::LanePartition lane_partition_;
+
+  /// scratch candidate list for map_index_ queries, a class variable
+  /// only to avoid allocation on every query
+  std::vector<int> quad_candidates_;
+
   /// vector of observers, in order of the observations they publish
   std::vector<observers::Observer *> observers_;
 
+  /// shared quad filter products, refreshed once per obstacle cloud
+  quad_ops::FilterCache filter_cache_;
+
+  /// per-lane obstacle tracks, updated once per obstacle cloud
+  observers::ObstacleTracker obstacle_tracker_;
+  art_msgs::ObstacleTrackArray tracks_msg_;
+
   /// current observations from the observers
   art_msgs::ObservationArray observations_;
 
+  /// observations as of the last publication, for change detection
+  std::vector<art_msgs::Observation> prev_obs_;
+  ros::Time last_publish_time_;		///< time of last publication
+
   std::tr1::unordered_set<int> added_quads_; ///< set of obstacle quads
   art_msgs::ArtLanes obs_quads_;	///< vector of obstacle quads
   std::vector<art_msgs::ArtQuadrilateral>::iterator obs_it_;
   art_msgs::ArtQuadrilateral robot_polygon_; ///< robot's current polygon
   MapPose pose_; // pose of Map
+  float robot_speed_;			///< current robot speed (m/s)
 
-  /// Only used within LaneObservations::publishObstacleVisualization(), a
-  /// class variable only to avoid memory allocation on every cycle.
+  /// Pose of one visualized quad: everything the marker builder needs.
+  typedef struct
+  {
+    geometry_msgs::Point position;	///< quad midpoint
+    float heading;			///< quad heading
+  } VizQuad;
+
+  /// Compact snapshot of observer state for the visualization thread.
+  typedef struct
+  {
+    bool fresh;				///< not yet consumed
+    ros::Time stamp;			///< observation cycle time
+    std::vector<VizQuad> quads;		///< obstacle quads, robot last
+  } VizSnapshot;
+
+  /** Visualization worker thread state.
+   *
+   *  publishObstacleVisualization() only copies quad midpoints and
+   *  headings into @c viz_shared_ and signals the worker; marker
+   *  construction and publication happen on @c viz_thread_, so
+   *  enabling rviz costs the observation cycle a small memcpy
+   *  instead of milliseconds of message building.  The producer
+   *  scratch vector and shared slot exchange storage with
+   *  vector::swap, so neither side allocates in steady state.
+   */
+  boost::shared_ptr<boost::thread> viz_thread_;
+  boost::mutex viz_mutex_;		///< guards viz_shared_
+  boost::condition viz_cond_;		///< snapshot available
+  bool viz_shutdown_;			///< worker shutdown request
+  VizSnapshot viz_shared_;		///< handoff slot to the worker
+  std::vector<VizQuad> viz_scratch_;	///< producer-side scratch
+
+  /// Marker pool, only used within vizThread().  Constant marker
+  /// fields are filled once when a pool entry is first created and
+  /// reused across frames; only stamps and poses change per frame.
   visualization_msgs::MarkerArray marks_msg_;
+
+  /// Contiguous obstacle point coordinates for the batch point-in-quad
+  /// kernel, class variables only to avoid allocation on every cycle.
+  std::vector<float> points_x_;
+  std::vector<float> points_y_;
+
+  /// occupied voxel cells for obstacle point deduplication, a class
+  /// variable only to avoid allocation on every cycle
+  std::tr1::unordered_set<int64_t> voxel_cells_;
+
+  /// map-frame envelope of local_map_, recomputed once per map
+  /// message; transformed into the cloud frame it pre-crops obstacle
+  /// points with axis comparisons before any per-point transform
+  bool map_env_valid_;			///< envelope below usable
+  float map_env_min_x_;
+  float map_env_max_x_;
+  float map_env_min_y_;
+  float map_env_max_y_;
 };
 
 #endif // _LANE_OBSERVATIONS_H_
@@ -30,10 +30,8 @@ public:
   NearestBackward(art_observers::ObserversConfig &config);
   ~NearestBackward();
 
-  virtual art_msgs::Observation
-    update(const art_msgs::ArtLanes &local_map,
-           const art_msgs::ArtLanes &obstacles,
-	   MapPose pose_);
+  virtual art_msgs::Observation update(const ObserverInput &input);
+  virtual bool applies(const ObserverInput &input);
 
 private:
   std::vector<float> distance_;
@@ -42,6 +40,7 @@ private:
   MeanFilter velocity_filter_;
 
   ros::Time prev_update_;
+  int tracked_id_;			///< track of the nearest obstacle
 };
 
 }; // namespace observers
@@ -30,10 +30,7 @@ public:
   NearestForward(art_observers::ObserversConfig &config);
   ~NearestForward();
 
-  virtual art_msgs::Observation
-    update(const art_msgs::ArtLanes &local_map,
-           const art_msgs::ArtLanes &obstacles,
-	   const MapPose pose_);
+  virtual art_msgs::Observation update(const ObserverInput &input);
 
 private:
   std::vector<float> distance_;
@@ -42,6 +39,7 @@ private:
   MeanFilter velocity_filter_;
 
   ros::Time prev_update_;
+  int tracked_id_;			///< track of the nearest obstacle
 };
 
 }; // namespace observers
@@ -21,11 +21,45 @@
 #include <art_msgs/ArtLanes.h>
 #include <art_msgs/Observation.h>
 #include <art_observers/ObserversConfig.h>
+#include <art_observers/ObstacleTracker.h>
+#include <art_observers/QuadrilateralOps.h>
 #include <art_map/PolyOps.h>
 
 namespace observers
 {
 
+/** @brief Shared per-cycle observer input snapshot.
+ *
+ *  Prepared once by the driver before any observer runs: the local
+ *  road map, the obstacle quads, the robot pose and the shared quad
+ *  filter cache.  Everything here is read-only while the observers
+ *  run, so a batch of observers may consume one snapshot
+ *  concurrently.  The referenced messages must outlive the batch.
+ */
+struct ObserverInput
+{
+  ObserverInput(const art_msgs::ArtLanes &local_map_,
+		const art_msgs::ArtLanes &obstacles_,
+		MapPose pose_,
+		const quad_ops::FilterCache &cache_,
+		const ObstacleTracker *tracks_,
+		float robot_speed_):
+    local_map(local_map_),
+    obstacles(obstacles_),
+    pose(pose_),
+    cache(cache_),
+    tracks(tracks_),
+    robot_speed(robot_speed_)
+  {}
+
+  const art_msgs::ArtLanes &local_map;	///< road map lanes in range
+  const art_msgs::ArtLanes &obstacles;	///< quads containing obstacles
+  MapPose pose;				///< current pose of robot
+  const quad_ops::FilterCache &cache;	///< shared filter products
+  const ObstacleTracker *tracks;	///< obstacle tracks, may be NULL
+  float robot_speed;			///< current robot speed (m/s)
+};
+
 /** @brief Observers base class. */
 class Observer 
 {
@@ -58,19 +92,32 @@ public:
   /** Generic observer update function.
    *
    *  Called whenever there are new obstacle data, assuming the
-   *  local_map is also available.
+   *  local_map is also available.  May run concurrently with other
+   *  observers over the same input snapshot: the input is read-only
+   *  and shared, only the observer's own state may be modified.
    *
-   *  @param robot_quad    quadrilateral containing the robot
-   *  @param local_map     road map lanes within range of the robot
-   *  @param obstacles     local map quads currently containing obstacles
-   *  @param pose          current pose of robot
+   *  @param input shared input snapshot for this batch of updates
+   */
+  virtual art_msgs::Observation update(const ObserverInput &input) = 0;
+
+  /** Applicability predicate.
+   *
+   *  Checked before update(): when false, this cycle's update is
+   *  skipped entirely and the observation is reported not applicable.
+   *  The default is always applicable; observers whose output only
+   *  matters in some map or motion context override this with a
+   *  cheap test of the input snapshot.
    *
-   *  @todo Make pure virtual once deprecated version is deleted. 
+   *  @param input shared input snapshot for this batch of updates
    */
-  virtual art_msgs::Observation
-    update(const art_msgs::ArtLanes &local_map,
-           const art_msgs::ArtLanes &obstacles,
-	   MapPose pose) = 0;
+  virtual bool applies(const ObserverInput &input) {return true;}
+
+  /** Observation reported for a skipped cycle. */
+  art_msgs::Observation skipped(void)
+  {
+    observation_.applicable = false;
+    return observation_;
+  }
 
   /** Used by all observers to get obstacles in polygons of interest
    *
@@ -18,6 +18,11 @@
 
 */
 
+#include <float.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <sensor_msgs/point_cloud_conversion.h>
 #include <art_observers/lane_observations.h>
 #include <art_observers/QuadrilateralOps.h>
@@ -32,8 +37,13 @@ LaneObservations::LaneObservations(ros::NodeHandle &node,
   nearest_backward_observer_(config_),
   adjacent_left_observer_(config_),
   adjacent_right_observer_(config_),
-  tf_listener_(new tf::TransformListener())
-{ 
+  tf_listener_(new tf::TransformListener()),
+  robot_speed_(0.0),
+  viz_shutdown_(false),
+  map_env_valid_(false)
+{
+  viz_shared_.fresh = false;
+
   // subscribe to point cloud topics
   pc_sub_ =
     node_.subscribe("velodyne/obstacles", 1,
@@ -62,16 +72,35 @@ LaneObservations::LaneObservations(ros::NodeHandle &node,
     node_.advertise<visualization_msgs::MarkerArray>(viz_topic, 1, true);
   observations_pub_ =
     node_.advertise <art_msgs::ObservationArray>("observations", 1, true);
+  tracks_pub_ =
+    node_.advertise <art_msgs::ObstacleTrackArray>("obstacle_tracks", 1, true);
+  trace_pub_ =
+    node_.advertise <art_msgs::PipelineEvent>("pipeline_trace", 10);
 
   // Initialize observers.  They will be updated in this order.
   addObserver(nearest_forward_observer_);
   addObserver(nearest_backward_observer_);
   addObserver(adjacent_left_observer_);
   addObserver(adjacent_right_observer_);
+
+  // start the visualization worker thread; it sleeps until
+  // publishObstacleVisualization() hands it a snapshot
+  viz_thread_.reset(new boost::thread(&LaneObservations::vizThread, this));
 }
 
 /** @brief Deconstructor. */
-LaneObservations::~LaneObservations() {}
+LaneObservations::~LaneObservations()
+{
+  if (viz_thread_)
+    {
+      {
+        boost::mutex::scoped_lock lock(viz_mutex_);
+        viz_shutdown_ = true;
+      }
+      viz_cond_.notify_one();
+      viz_thread_->join();
+    }
+}
 
 /** @brief Obstacles point cloud processing.  Starts all the observers
  *
@@ -112,40 +141,222 @@ void LaneObservations::processPointCloud2(const sensor_msgs::PointCloud2::ConstP
 }
 
 /** @brief Local road map callback. */
-void LaneObservations::processLocalMap(const art_msgs::ArtLanes::ConstPtr &msg) 
+void LaneObservations::processLocalMap(const art_msgs::ArtLanes::ConstPtr &msg)
 {
   local_map_ = *msg;
+
+  // index and partition the new map once, so per-point and per-lane
+  // queries need not scan it
+  map_index_.rebuild(local_map_);
+  lane_partition_.rebuild(local_map_);
+
+  // envelope of the new map, for the obstacle cloud pre-crop
+  map_env_valid_ = (map_index_.size() > 0);
+  if (map_env_valid_)
+    {
+      map_env_min_x_ = map_index_.minX(0);
+      map_env_max_x_ = map_index_.maxX(0);
+      map_env_min_y_ = map_index_.minY(0);
+      map_env_max_y_ = map_index_.maxY(0);
+      for (size_t i = 1; i < map_index_.size(); ++i)
+        {
+          map_env_min_x_ = fminf(map_env_min_x_, map_index_.minX(i));
+          map_env_max_x_ = fmaxf(map_env_max_x_, map_index_.maxX(i));
+          map_env_min_y_ = fminf(map_env_min_y_, map_index_.minY(i));
+          map_env_max_y_ = fmaxf(map_env_max_y_, map_index_.maxY(i));
+        }
+    }
 }
 
 /** @brief process the pose of the map **/
 void LaneObservations::processPose(const nav_msgs::Odometry &odom)
 {
   pose_ = MapPose(odom.pose.pose);
+  robot_speed_ = fabs(odom.twist.twist.linear.x);
 }
 
 /** @brief Filter obstacle points to those in a road map polygon. */
-void LaneObservations::filterPointsInLocalMap() 
+void LaneObservations::filterPointsInLocalMap()
 {
   // set the exact point cloud size
   size_t npoints = obstacles_.points.size();
   added_quads_.clear();
-  for (unsigned i = 0; i < npoints; ++i)
+  if (npoints == 0)
+    return;
+
+  // Optional voxel deduplication: hundreds of points often land in
+  // the same cell without adding information to the observers'
+  // distance estimates, so keep only the first point seen per cell.
+  bool dedup = (config_.voxel_size > 0.0);
+  float inv_voxel = 0.0;
+  if (dedup)
+    {
+      inv_voxel = 1.0 / config_.voxel_size;
+      voxel_cells_.clear();
+    }
+
+  // copy coordinates into contiguous arrays for the batch kernel,
+  // tracking the cloud bounding box as we go
+  points_x_.resize(npoints);
+  points_y_.resize(npoints);
+  float cloud_min_x = obstacles_.points[0].x;
+  float cloud_max_x = cloud_min_x;
+  float cloud_min_y = obstacles_.points[0].y;
+  float cloud_max_y = cloud_min_y;
+  size_t kept = 0;
+  for (size_t i = 0; i < npoints; ++i)
+    {
+      float px = obstacles_.points[i].x;
+      float py = obstacles_.points[i].y;
+      if (dedup)
+        {
+          int64_t cx = (int64_t) rint(px * inv_voxel);
+          int64_t cy = (int64_t) rint(py * inv_voxel);
+          int64_t cell = (cx << 32) ^ (cy & 0xffffffff);
+          if (!voxel_cells_.insert(cell).second)
+            continue;                   // cell already represented
+        }
+      points_x_[kept] = px;
+      points_y_[kept] = py;
+      ++kept;
+      cloud_min_x = fminf(cloud_min_x, px);
+      cloud_max_x = fmaxf(cloud_max_x, px);
+      cloud_min_y = fminf(cloud_min_y, py);
+      cloud_max_y = fmaxf(cloud_max_y, py);
+    }
+  if (dedup)
     {
-      isPointInAPolygon(obstacles_.points[i].x,
-                        obstacles_.points[i].y);
+      ROS_DEBUG("voxel dedup kept %zu of %zu obstacle points",
+                kept, npoints);
+      npoints = kept;
+    }
+
+  // Test all points against each map quad at once.  The vectorized
+  // kernel rejects most points on the quad bounding box and exits at
+  // the first point found inside, so this replaces the per-point
+  // per-quad scalar crossing tests.
+  size_t num_polys = local_map_.polygons.size();
+  std::pair<std::tr1::unordered_set<int>::iterator, bool> pib;
+  bool have_index = (map_index_.size() == num_polys);
+  for (size_t i = 0; i < num_polys; ++i)
+    {
+      // reject quads entirely outside the cloud bounding box using
+      // the precomputed map index
+      if (have_index
+          && (map_index_.minX(i) > cloud_max_x
+              || map_index_.maxX(i) < cloud_min_x
+              || map_index_.minY(i) > cloud_max_y
+              || map_index_.maxY(i) < cloud_min_y))
+        continue;
+
+      art_msgs::ArtQuadrilateral *p = &(local_map_.polygons[i]);
+      if (quad_ops::anyPointInPoly(&points_x_[0], &points_y_[0], npoints,
+                                   *p, 0.6))
+        {
+          pib = added_quads_.insert(p->poly_id);
+          if (pib.second)
+            {
+              obs_quads_.polygons.push_back(*p);
+            }
+        }
     }
 }
 
-/** @brief Transform obstacle points into the map frame of reference. */
-void LaneObservations::transformPointCloud(const PtCloud &msg) 
+/** @brief Transform obstacle points into the map frame of reference.
+ *
+ *  Looks the transform up once per cloud and applies it as a 3x4
+ *  matrix across the contiguous point array, instead of going through
+ *  the generic per-point transform path.
+ */
+void LaneObservations::transformPointCloud(const PtCloud &msg)
 {
   try
     {
       // wait for transform to be available
       tf_listener_->waitForTransform(config_.map_frame_id, msg.header.frame_id,
 				     msg.header.stamp, ros::Duration(0.2));
-      pcl_ros::transformPointCloud(config_.map_frame_id, msg, obstacles_,
-				   *tf_listener_);
+      tf::StampedTransform transform;
+      tf_listener_->lookupTransform(config_.map_frame_id, msg.header.frame_id,
+				    msg.header.stamp, transform);
+
+      // unpack the transform into scalars so the per-point loop body
+      // has no indirection and can vectorize
+      float r00 = transform.getBasis().getRow(0).x();
+      float r01 = transform.getBasis().getRow(0).y();
+      float r02 = transform.getBasis().getRow(0).z();
+      float r10 = transform.getBasis().getRow(1).x();
+      float r11 = transform.getBasis().getRow(1).y();
+      float r12 = transform.getBasis().getRow(1).z();
+      float r20 = transform.getBasis().getRow(2).x();
+      float r21 = transform.getBasis().getRow(2).y();
+      float r22 = transform.getBasis().getRow(2).z();
+      float tx = transform.getOrigin().x();
+      float ty = transform.getOrigin().y();
+      float tz = transform.getOrigin().z();
+
+      // Region-of-interest pre-crop: map the local map envelope into
+      // the cloud frame once (bounding box of its corners under the
+      // inverse transform, over a generous z span).  Points outside
+      // it cannot land in any map quad, so four axis comparisons on
+      // the raw coordinates discard them before any transform
+      // arithmetic.
+      bool have_crop = map_env_valid_;
+      float crop_min_x = 0, crop_max_x = 0;
+      float crop_min_y = 0, crop_max_y = 0;
+      if (have_crop)
+	{
+	  tf::Transform inverse = transform.inverse();
+	  crop_min_x = crop_min_y = FLT_MAX;
+	  crop_max_x = crop_max_y = -FLT_MAX;
+	  for (int c = 0; c < 8; ++c)
+	    {
+	      tf::Vector3 corner((c & 1) ? map_env_max_x_ : map_env_min_x_,
+				 (c & 2) ? map_env_max_y_ : map_env_min_y_,
+				 (c & 4) ? 10.0 : -10.0);
+	      tf::Vector3 p = inverse * corner;
+	      crop_min_x = fminf(crop_min_x, p.x());
+	      crop_max_x = fmaxf(crop_max_x, p.x());
+	      crop_min_y = fminf(crop_min_y, p.y());
+	      crop_max_y = fmaxf(crop_max_y, p.y());
+	    }
+	  // margin for the point-in-quad overlap distance
+	  crop_min_x -= 1.0;
+	  crop_max_x += 1.0;
+	  crop_min_y -= 1.0;
+	  crop_max_y += 1.0;
+	}
+
+      // processObstacles() passes obstacles_ itself, transformed in
+      // place; only copy when called with some other cloud
+      if (&obstacles_ != &msg)
+	obstacles_ = msg;
+      obstacles_.header.frame_id = config_.map_frame_id;
+
+      size_t npoints = obstacles_.points.size();
+      size_t kept = 0;
+      for (size_t i = 0; i < npoints; ++i)
+	{
+	  float px = obstacles_.points[i].x;
+	  float py = obstacles_.points[i].y;
+	  float pz = obstacles_.points[i].z;
+	  if (have_crop
+	      && (px < crop_min_x || px > crop_max_x
+		  || py < crop_min_y || py > crop_max_y))
+	    continue;			// outside the map envelope
+	  obstacles_.points[kept].x = r00*px + r01*py + r02*pz + tx;
+	  obstacles_.points[kept].y = r10*px + r11*py + r12*pz + ty;
+	  obstacles_.points[kept].z = r20*px + r21*py + r22*pz + tz;
+	  ++kept;
+	}
+      if (kept != npoints)
+	{
+	  ROS_DEBUG("ROI pre-crop kept %zu of %zu obstacle points",
+		    kept, npoints);
+	  obstacles_.points.resize(kept);
+	  obstacles_.width = kept;
+	  obstacles_.height = 1;
+	}
+
       observations_.header.frame_id = obstacles_.header.frame_id;
 
       // hopefully not needed in future
@@ -165,21 +376,17 @@ void LaneObservations::transformPointCloud(const PtCloud &msg)
  *  @post @a added_quads contains polygon ID, if found.
  *        @a obstacle_quads contains polygon, if found.
  */
-bool LaneObservations::isPointInAPolygon(float x, float y) 
+bool LaneObservations::isPointInAPolygon(float x, float y)
 {
-  size_t num_polys = local_map_.polygons.size();
-  
   bool inside = false;
   std::pair<std::tr1::unordered_set<int>::iterator, bool> pib;
-  
-  for (size_t i=0; i<num_polys; i++)
-    {
-      art_msgs::ArtQuadrilateral *p= &(local_map_.polygons[i]);
-      float dist= ((p->midpoint.x-x)*(p->midpoint.x-x)
-                   + (p->midpoint.y-y)*(p->midpoint.y-y));
 
-      if (dist > 16)         // quick check: are we near the polygon?
-        continue;
+  // the interval index rejects most quads with two comparisons
+  map_index_.getCandidates(x, y, quad_candidates_);
+  for (size_t k = 0; k < quad_candidates_.size(); ++k)
+    {
+      art_msgs::ArtQuadrilateral *p =
+        &(local_map_.polygons[quad_candidates_[k]]);
 
       inside = quad_ops::quickPointInPolyRatio(x,y,*p,0.6);
       // Add polygon to lane if so
@@ -196,19 +403,104 @@ bool LaneObservations::isPointInAPolygon(float x, float y)
   return inside;
 }
 
+namespace
+{
+  /** float equality that treats two NaNs as equal */
+  bool sameFloat(float a, float b)
+  {
+    return (a == b || (a != a && b != b));
+  }
+
+  /** @brief true if two observations differ in any field subscribers use */
+  bool observationChanged(const art_msgs::Observation &a,
+			  const art_msgs::Observation &b)
+  {
+    return (a.clear != b.clear
+	    || a.applicable != b.applicable
+	    || a.nobjects != b.nobjects
+	    || !sameFloat(a.distance, b.distance)
+	    || !sameFloat(a.velocity, b.velocity)
+	    || !sameFloat(a.time, b.time));
+  }
+};
+
+/** @brief Run one registered observer, storing its observation.
+ *
+ *  Observers whose applicability predicate rejects the current
+ *  context are skipped, reporting their observation not applicable.
+ */
+void LaneObservations::runOneObserver(const observers::ObserverInput &input,
+                                      unsigned i)
+{
+  if (observers_[i]->applies(input))
+    observations_.obs[i] = observers_[i]->update(input);
+  else
+    observations_.obs[i] = observers_[i]->skipped();
+}
+
 /** @brief Run all registered observers and publish their observations. */
-void LaneObservations::runObservers() 
+void LaneObservations::runObservers()
 {
-  // update all the registered observers
-  for (unsigned i = 0; i < observers_.size(); ++i)
+  // Refresh the shared quad filter products once for all observers,
+  // then snapshot this cycle's observer inputs.  The snapshot stays
+  // read-only until every observer has finished.
+  filter_cache_.update(local_map_, obs_quads_, pose_, &lane_partition_);
+
+  // associate this cycle's obstacles with the track store, then
+  // publish the tracks so downstream nodes can read obstacle
+  // velocities with stable identities
+  obstacle_tracker_.update(obs_quads_, observations_.header.stamp);
+  tracks_msg_.header.stamp = observations_.header.stamp;
+  tracks_msg_.header.frame_id = local_map_.header.frame_id;
+  obstacle_tracker_.toMsg(tracks_msg_);
+  tracks_pub_.publish(tracks_msg_);
+
+  observers::ObserverInput input(local_map_, obs_quads_, pose_,
+                                 filter_cache_, &obstacle_tracker_,
+                                 robot_speed_);
+
+  if (config_.parallel_observers && observers_.size() > 1)
+    {
+      // One task per observer over the shared read-only snapshot;
+      // each writes only its own entry of the observations array.
+      boost::thread_group tasks;
+      for (unsigned i = 1; i < observers_.size(); ++i)
+	tasks.create_thread(boost::bind(&LaneObservations::runOneObserver,
+					this, boost::cref(input), i));
+      runOneObserver(input, 0);		// run one observer on this thread
+      tasks.join_all();
+    }
+  else
     {
-      observations_.obs[i] =
-	observers_[i]->update(local_map_, obs_quads_, pose_);
+      // update all the registered observers in order
+      for (unsigned i = 0; i < observers_.size(); ++i)
+	runOneObserver(input, i);
     }
 
-  // Publish their observations
-  observations_pub_.publish(observations_);
-}                                                            
+  // Publish only when some observation changed, or after the
+  // heartbeat period without one, so subscribers can still detect a
+  // dead node.
+  bool changed = (prev_obs_.size() != observations_.obs.size());
+  for (unsigned i = 0; !changed && i < observations_.obs.size(); ++i)
+    changed = observationChanged(observations_.obs[i], prev_obs_[i]);
+
+  ros::Time now = ros::Time::now();
+  if (changed
+      || (now - last_publish_time_).toSec() >= config_.heartbeat_period)
+    {
+      observations_pub_.publish(observations_);
+      prev_obs_ = observations_.obs;
+      last_publish_time_ = now;
+    }
+
+  // report latency from obstacle cloud stamp to end of processing
+  art_msgs::PipelineEvent event;
+  event.header.stamp = now;
+  event.origin = observations_.header.stamp;
+  event.node = "observers";
+  event.topic = "obstacles";
+  trace_pub_.publish(event);
+}
 
 /** @brief Calculate which polygon currently contains the robot. */
 void LaneObservations::calcRobotPolygon() 
@@ -225,20 +517,18 @@ void LaneObservations::calcRobotPolygon()
   geometry_msgs::PointStamped robot_point;
   tf_listener_->transformPoint(config_.map_frame_id, laser_point, robot_point);
 
-  size_t numPolys = local_map_.polygons.size();
-  float x = robot_point.point.x; 
+  float x = robot_point.point.x;
   float y = robot_point.point.y;
   bool inside=false;
-  for (size_t i=0; i<numPolys; i++)
-    {
-      art_msgs::ArtQuadrilateral *p= &(local_map_.polygons[i]);
-      float dist = ((p->midpoint.x-x)*(p->midpoint.x-x)
-                    + (p->midpoint.y-y)*(p->midpoint.y-y));
 
-      if (dist > 16)          // quick check: we are near the polygon?
-        continue;
+  // the interval index rejects most quads with two comparisons
+  map_index_.getCandidates(x, y, quad_candidates_);
+  for (size_t k = 0; k < quad_candidates_.size(); ++k)
+    {
+      art_msgs::ArtQuadrilateral *p =
+        &(local_map_.polygons[quad_candidates_[k]]);
 
-      inside = quad_ops::quickPointInPoly(x,y,*p); 
+      inside = quad_ops::quickPointInPoly(x,y,*p);
       if (inside)
         {
           robot_polygon_ = *p;
@@ -246,77 +536,117 @@ void LaneObservations::calcRobotPolygon()
     }
 }
 
-/** @brief Publish rviz markers for obstacles in the road. */
+/** @brief Hand the visualization thread a snapshot of this cycle.
+ *
+ *  Only copies quad midpoints and headings; marker construction and
+ *  publication happen on the worker thread.  If the worker has not
+ *  consumed the previous snapshot yet, it is simply replaced: rviz
+ *  only ever wants the latest frame.
+ */
 void LaneObservations::publishObstacleVisualization()
 {
   if (viz_pub_.getNumSubscribers()==0)
     return;
 
-  ros::Time now = ros::Time::now();
-
-  // clear message array, this is a class variable to avoid memory
-  // allocation and deallocation on every cycle
-  marks_msg_.markers.clear();
-
-  int i=0;
+  // compact snapshot: obstacle quad poses, robot polygon last
+  viz_scratch_.clear();
+  viz_scratch_.reserve(obs_quads_.polygons.size() + 1);
+  VizQuad quad;
   for (obs_it_=obs_quads_.polygons.begin();
        obs_it_!=obs_quads_.polygons.end(); obs_it_++)
     {
-      visualization_msgs::Marker mark;
-      mark.header.stamp = now;
-      mark.header.frame_id = config_.map_frame_id;
-    
-      mark.ns = "obstacle_polygons";
-      mark.id = (int32_t) i;
-      mark.type = visualization_msgs::Marker::CUBE;
-      mark.action = visualization_msgs::Marker::ADD;
-    
-      mark.pose.position = obs_it_->midpoint;
-      mark.pose.orientation =
-        tf::createQuaternionMsgFromYaw(obs_it_->heading);
-    
-      mark.scale.x = 1.5;
-      mark.scale.y = 1.5;
-      mark.scale.z = 0.1;
-      mark.lifetime =  ros::Duration(0.2);
-    
-      mark.color.a = 0.8;       // way-points are slightly transparent
-      mark.color.r = 0.0;
-      mark.color.g = 0.0;
-      mark.color.b = 1.0;
-    
-      marks_msg_.markers.push_back(mark);
-      i++;
+      quad.position = obs_it_->midpoint;
+      quad.heading = obs_it_->heading;
+      viz_scratch_.push_back(quad);
     }
+  quad.position = robot_polygon_.midpoint;
+  quad.heading = robot_polygon_.heading;
+  viz_scratch_.push_back(quad);
+
+  {
+    boost::mutex::scoped_lock lock(viz_mutex_);
+    viz_shared_.stamp = ros::Time::now();
+    viz_shared_.quads.swap(viz_scratch_);
+    viz_shared_.fresh = true;
+  }
+  viz_cond_.notify_one();
+}
 
-  // Draw the polygon containing the robot
-  visualization_msgs::Marker mark;
-  mark.header.stamp = now;
-  mark.header.frame_id = config_.map_frame_id;
-  
-  mark.ns = "obstacle_polygons";
-  mark.id = (int32_t) i;
-  mark.type = visualization_msgs::Marker::CUBE;
-  mark.action = visualization_msgs::Marker::ADD;
-    
-  mark.pose.position = robot_polygon_.midpoint;
-  mark.pose.orientation =
-    tf::createQuaternionMsgFromYaw(robot_polygon_.heading);
-    
-  mark.scale.x = 1.5;
-  mark.scale.y = 1.5;
-  mark.scale.z = 0.1;
-  mark.lifetime =  ros::Duration(0.2);
-  
-  mark.color.a = 0.8;           // way-points are slightly transparent
-  mark.color.r = 0.3;
-  mark.color.g = 0.7;
-  mark.color.b = 0.9;
-  
-  marks_msg_.markers.push_back(mark);
+/** @brief Visualization worker thread.
+ *
+ *  Builds and publishes rviz markers from snapshots handed over by
+ *  publishObstacleVisualization().  Pool entries in @c marks_msg_ are
+ *  reused across frames: constant fields (namespace, frame, type,
+ *  scale, lifetime) are filled only when an entry is first created,
+ *  so steady-state frames just update stamps and poses.
+ */
+void LaneObservations::vizThread()
+{
+  std::vector<VizQuad> quads;
+  for (;;)
+    {
+      ros::Time stamp;
+      {
+        boost::mutex::scoped_lock lock(viz_mutex_);
+        while (!viz_shared_.fresh && !viz_shutdown_)
+          viz_cond_.wait(lock);
+        if (viz_shutdown_)
+          return;
+        stamp = viz_shared_.stamp;
+        quads.swap(viz_shared_.quads);
+        viz_shared_.fresh = false;
+      }
+
+      // grow the marker pool as needed, filling constant fields once
+      size_t nmarks = quads.size();
+      while (marks_msg_.markers.size() < nmarks)
+        {
+          visualization_msgs::Marker mark;
+          mark.header.frame_id = config_.map_frame_id;
+          mark.ns = "obstacle_polygons";
+          mark.id = (int32_t) marks_msg_.markers.size();
+          mark.type = visualization_msgs::Marker::CUBE;
+          mark.action = visualization_msgs::Marker::ADD;
+          mark.scale.x = 1.5;
+          mark.scale.y = 1.5;
+          mark.scale.z = 0.1;
+          mark.lifetime = ros::Duration(0.2);
+          mark.color.a = 0.8;	// way-points are slightly transparent
+          marks_msg_.markers.push_back(mark);
+        }
+      // the pool keeps its high-water mark; entries beyond this
+      // frame's count are republished as deletions so stale markers
+      // vanish promptly instead of lingering until their lifetime
+      for (size_t i = 0; i < marks_msg_.markers.size(); ++i)
+        {
+          visualization_msgs::Marker &mark = marks_msg_.markers[i];
+          mark.header.stamp = stamp;
+          if (i >= nmarks)
+            {
+              mark.action = visualization_msgs::Marker::DELETE;
+              continue;
+            }
+          mark.action = visualization_msgs::Marker::ADD;
+          mark.pose.position = quads[i].position;
+          mark.pose.orientation =
+            tf::createQuaternionMsgFromYaw(quads[i].heading);
+          if (i + 1 < nmarks)
+            {
+              mark.color.r = 0.0;	// obstacle quad: blue
+              mark.color.g = 0.0;
+              mark.color.b = 1.0;
+            }
+          else
+            {
+              mark.color.r = 0.3;	// robot polygon: light blue
+              mark.color.g = 0.7;
+              mark.color.b = 0.9;
+            }
+        }
 
-  // Publish the markers
-  viz_pub_.publish(marks_msg_);
+      // Publish the markers
+      viz_pub_.publish(marks_msg_);
+    }
 }
 
 /** @brief Handle incoming data. */
@@ -0,0 +1,304 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/** @file
+
+    Replay benchmark for the ART lane observers.
+
+    Reads obstacle clouds, local road maps, odometry and transforms
+    from recorded bag files and feeds them directly into
+    LaneObservations, bypassing ROS transport.  Reports wall-clock
+    times for each processing phase and each observer, with
+    end-to-end cycle times bucketed by obstacle cloud size, so
+    changes to the processing pipeline can be validated on recorded
+    data before vehicle testing.
+
+    Usage:
+
+	rosrun art_observers observers_bench <file.bag> ...
+
+    @author Jack O'Quin
+
+*/
+
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+#include <nav_msgs/Odometry.h>
+#include <sensor_msgs/PointCloud.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/point_cloud_conversion.h>
+#include <tf/tfMessage.h>
+#include <tf/transform_datatypes.h>
+
+#include <art_msgs/ArtLanes.h>
+#include <art_observers/lane_observations.h>
+
+namespace
+{
+
+/** accumulated wall-clock statistics for one benchmark phase */
+class PhaseStats
+{
+public:
+
+  PhaseStats(): count_(0), total_(0.0), worst_(0.0) {}
+
+  void add(double sec)
+  {
+    ++count_;
+    total_ += sec;
+    if (sec > worst_)
+      worst_ = sec;
+  }
+
+  void report(const std::string &label) const
+  {
+    if (count_ == 0)
+      return;
+    ROS_INFO("%-20s %8lu calls, mean %8.3f ms, worst %8.3f ms",
+             label.c_str(), (unsigned long) count_,
+             1000.0 * total_ / count_, 1000.0 * worst_);
+  }
+
+private:
+
+  unsigned long count_;                 // calls accumulated
+  double total_;                        // total seconds
+  double worst_;                        // worst call (seconds)
+};
+
+} // anonymous namespace
+
+/** Replay benchmark driver.
+ *
+ *  A friend of LaneObservations: replays recorded messages straight
+ *  into its processing methods and times each phase of the obstacle
+ *  cycle, which the subscription callbacks run as one opaque unit.
+ */
+class ObserversBench
+{
+public:
+
+  ObserversBench(ros::NodeHandle &node, ros::NodeHandle &priv_nh):
+    obs_(node, priv_nh)
+  {}
+
+  int run(const std::string &bag_name);
+  void report(void);
+
+private:
+
+  void benchCloud(const sensor_msgs::PointCloud2 &msg);
+
+  /** cloud size bucket for end-to-end statistics */
+  static int sizeBucket(size_t npoints)
+  {
+    if (npoints < 1000)   return 0;
+    if (npoints < 10000)  return 1;
+    if (npoints < 100000) return 2;
+    return 3;
+  }
+
+  LaneObservations obs_;                // instrumented instance
+
+  // per-phase statistics
+  PhaseStats transform_;                // transformPointCloud()
+  PhaseStats filter_;                   // filterPointsInLocalMap()
+  PhaseStats cache_;                    // filter_cache_.update()
+  PhaseStats observer_[4];              // one per registered observer
+  PhaseStats map_;                      // processLocalMap()
+  PhaseStats cycle_[4];                 // end-to-end, by cloud size
+};
+
+/** replay one bag file
+ *
+ *  @param bag_name path of bag file to replay
+ *  @return 0 if successful, errno value otherwise
+ */
+int ObserversBench::run(const std::string &bag_name)
+{
+  rosbag::Bag bag;
+  try
+    {
+      bag.open(bag_name, rosbag::bagmode::Read);
+    }
+  catch (rosbag::BagException &e)
+    {
+      ROS_ERROR("error opening %s: %s", bag_name.c_str(), e.what());
+      return EIO;
+    }
+
+  ROS_INFO("replaying %s", bag_name.c_str());
+
+  std::vector<std::string> topics;
+  topics.push_back("tf");
+  topics.push_back("obstacles");
+  topics.push_back("velodyne/obstacles");
+  topics.push_back("roadmap_local");
+  topics.push_back("odom");
+  rosbag::View view(bag, rosbag::TopicQuery(topics));
+
+  for (rosbag::View::iterator it = view.begin(); it != view.end(); ++it)
+    {
+      if (!ros::ok())
+        break;
+
+      // transforms: feed straight into the listener, replacing the
+      // /tf subscription
+      tf::tfMessage::ConstPtr tfm = it->instantiate<tf::tfMessage>();
+      if (tfm)
+        {
+          for (size_t i = 0; i < tfm->transforms.size(); ++i)
+            {
+              tf::StampedTransform transform;
+              tf::transformStampedMsgToTF(tfm->transforms[i], transform);
+              obs_.tf_listener_->setTransform(transform);
+            }
+          continue;
+        }
+
+      nav_msgs::Odometry::ConstPtr odom =
+        it->instantiate<nav_msgs::Odometry>();
+      if (odom)
+        {
+          obs_.processPose(*odom);
+          continue;
+        }
+
+      art_msgs::ArtLanes::ConstPtr map =
+        it->instantiate<art_msgs::ArtLanes>();
+      if (map)
+        {
+          ros::WallTime start = ros::WallTime::now();
+          obs_.processLocalMap(map);
+          map_.add((ros::WallTime::now() - start).toSec());
+          continue;
+        }
+
+      sensor_msgs::PointCloud2::ConstPtr pc2 =
+        it->instantiate<sensor_msgs::PointCloud2>();
+      if (pc2)
+        {
+          benchCloud(*pc2);
+          continue;
+        }
+
+      // deprecated PointCloud input: convert, then process
+      sensor_msgs::PointCloud::ConstPtr pc =
+        it->instantiate<sensor_msgs::PointCloud>();
+      if (pc)
+        {
+          sensor_msgs::PointCloud2 converted;
+          sensor_msgs::convertPointCloudToPointCloud2(*pc, converted);
+          benchCloud(converted);
+        }
+    }
+
+  bag.close();
+  return 0;
+}
+
+/** run one obstacle cloud through the processing cycle, timing each
+ *  phase
+ *
+ *  Replicates LaneObservations::processObstacles() with timestamps
+ *  between the phases.
+ */
+void ObserversBench::benchCloud(const sensor_msgs::PointCloud2 &msg)
+{
+  pcl::fromROSMsg(msg, obs_.obstacles_);
+  int bucket = sizeBucket(obs_.obstacles_.points.size());
+
+  ros::WallTime start = ros::WallTime::now();
+
+  obs_.observations_.header.stamp = obs_.obstacles_.header.stamp;
+  obs_.obs_quads_.polygons.clear();
+  obs_.transformPointCloud(obs_.obstacles_);
+  ros::WallTime t = ros::WallTime::now();
+  transform_.add((t - start).toSec());
+
+  // skip the rest until the local road map has been received
+  if (obs_.local_map_.header.stamp == ros::Time())
+    return;
+
+  obs_.filterPointsInLocalMap();
+  ros::WallTime t2 = ros::WallTime::now();
+  filter_.add((t2 - t).toSec());
+
+  // refresh the shared quad filter products and snapshot the
+  // observer inputs, then run the observers sequentially so each
+  // gets its own timing
+  obs_.filter_cache_.update(obs_.local_map_, obs_.obs_quads_,
+                            obs_.pose_, &obs_.lane_partition_);
+  obs_.obstacle_tracker_.update(obs_.obs_quads_,
+                                obs_.observations_.header.stamp);
+  observers::ObserverInput input(obs_.local_map_, obs_.obs_quads_,
+                                 obs_.pose_, obs_.filter_cache_,
+                                 &obs_.obstacle_tracker_,
+                                 obs_.robot_speed_);
+  t = ros::WallTime::now();
+  cache_.add((t - t2).toSec());
+
+  for (unsigned i = 0; i < obs_.observers_.size(); ++i)
+    {
+      ros::WallTime before = ros::WallTime::now();
+      obs_.runOneObserver(input, i);
+      if (i < sizeof(observer_) / sizeof(observer_[0]))
+        observer_[i].add((ros::WallTime::now() - before).toSec());
+    }
+
+  cycle_[bucket].add((ros::WallTime::now() - start).toSec());
+}
+
+/** report accumulated statistics */
+void ObserversBench::report(void)
+{
+  map_.report("local map rebuild");
+  transform_.report("transform");
+  filter_.report("filter");
+  cache_.report("filter cache");
+  for (unsigned i = 0; i < obs_.observers_.size(); ++i)
+    {
+      std::string label = obs_.observations_.obs[i].name;
+      if (label.empty())                // observer never ran?
+        label = "observer";
+      if (i < sizeof(observer_) / sizeof(observer_[0]))
+        observer_[i].report(label);
+    }
+  cycle_[0].report("cycle (<1K points)");
+  cycle_[1].report("cycle (<10K points)");
+  cycle_[2].report("cycle (<100K points)");
+  cycle_[3].report("cycle (>=100K points)");
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "observers_bench");
+  ros::NodeHandle node;
+  ros::NodeHandle priv_nh("~");
+
+  if (argc < 2)
+    {
+      ROS_FATAL("usage: observers_bench <file.bag> ...");
+      return 1;
+    }
+
+  ObserversBench bench(node, priv_nh);
+
+  int rc = 0;
+  for (int i = 1; i < argc; ++i)
+    {
+      rc = bench.run(argv[i]);
+      if (rc != 0)
+        break;
+    }
+
+  bench.report();
+  return rc;
+}
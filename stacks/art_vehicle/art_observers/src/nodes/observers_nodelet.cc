@@ -0,0 +1,44 @@
+/*
+ *  Copyright (C) 2011 UT-Austin & Austin Robot Technology
+ *  License: Modified BSD Software License
+ */
+
+/** @file
+
+    Nodelet version of the lane observations node.
+
+    Loading it in the same nodelet manager as the maplanes driver
+    delivers the local road map and observation arrays by shared
+    pointer, without serialization.  The standalone observers_node
+    executable remains available for distributed deployments.
+
+    @author Jack O'Quin
+
+*/
+
+#include <ros/ros.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <art_observers/lane_observations.h>
+
+class ObserversNodelet: public nodelet::Nodelet
+{
+public:
+  ObserversNodelet() {}
+
+private:
+  virtual void onInit(void)
+  {
+    // LaneObservations is entirely callback-driven, so the manager's
+    // threads do all the work; no spin thread is needed here.
+    obs_.reset(new LaneObservations(getNodeHandle(),
+                                    getPrivateNodeHandle()));
+  }
+
+  boost::shared_ptr<LaneObservations> obs_;
+};
+
+// Register this plugin with pluginlib.
+PLUGINLIB_DECLARE_CLASS(art_observers, ObserversNodelet,
+                        ObserversNodelet, nodelet::Nodelet);
@@ -0,0 +1,137 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART observers per-lane quad partition implementation.
+
+     @author Michael Quinlan
+
+ */
+
+#include <algorithm>
+
+#include <art_observers/LanePartition.h>
+
+namespace quad_ops
+{
+  LanePartition::LaneKey LanePartition::keyOf(const Quad &q)
+  {
+    LaneKey key;
+    key.start_seg = q.start_way.seg;
+    key.start_lane = q.start_way.lane;
+    key.end_seg = q.end_way.seg;
+    key.end_lane = q.end_way.lane;
+    return key;
+  }
+
+  void LanePartition::clear(void)
+  {
+    groups_.clear();
+    indexes_.clear();
+    total_ = 0;
+  }
+
+  void LanePartition::rebuild(const art_msgs::ArtLanes &quads)
+  {
+    clear();
+    total_ = quads.polygons.size();
+
+    // collect keys of all non-transition quads (the lane comparison
+    // predicates reject transition quads unconditionally)
+    std::vector<std::pair<LaneKey, int> > entries;
+    entries.reserve(total_);
+    for (size_t i = 0; i < total_; ++i)
+      {
+	if (quads.polygons[i].is_transition)
+	  continue;
+	entries.push_back(std::make_pair(keyOf(quads.polygons[i]), (int) i));
+      }
+
+    // group by key, preserving map order within each lane
+    std::stable_sort(entries.begin(), entries.end());
+
+    indexes_.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+      {
+	if (groups_.empty() || !(groups_.back().key == entries[i].first))
+	  {
+	    Group group;
+	    group.key = entries[i].first;
+	    group.begin = (int) i;
+	    group.end = (int) i;
+	    groups_.push_back(group);
+	  }
+	indexes_.push_back(entries[i].second);
+	groups_.back().end = (int) i + 1;
+      }
+  }
+
+  art_msgs::ArtLanes
+  LanePartition::filterLanes(const Quad &base,
+			     const art_msgs::ArtLanes &quads,
+			     bool(*filter)(const Quad&, const Quad&)) const
+  {
+    art_msgs::ArtLanes filtered;
+
+    // binary search for the base quad's lane group
+    LaneKey key = keyOf(base);
+    size_t lo = 0;
+    size_t hi = groups_.size();
+    while (lo < hi)
+      {
+	size_t mid = (lo + hi) / 2;
+	if (groups_[mid].key < key)
+	  lo = mid + 1;
+	else
+	  hi = mid;
+      }
+    if (lo == groups_.size() || !(groups_[lo].key == key))
+      return filtered;			// no quads in this lane
+
+    for (int i = groups_[lo].begin; i < groups_[lo].end; ++i)
+      {
+	const Quad &comp = quads.polygons[indexes_[i]];
+	if (filter(base, comp))
+	  filtered.polygons.push_back(comp);
+      }
+    return filtered;
+  }
+
+  // View-based variant: records the matching quad indices instead of
+  // copying the quads.
+  void
+  LanePartition::filterLanes(const Quad &base,
+			     const art_msgs::ArtLanes &quads,
+			     bool(*filter)(const Quad&, const Quad&),
+			     QuadView &view) const
+  {
+    view.clear(&quads);
+
+    // binary search for the base quad's lane group
+    LaneKey key = keyOf(base);
+    size_t lo = 0;
+    size_t hi = groups_.size();
+    while (lo < hi)
+      {
+	size_t mid = (lo + hi) / 2;
+	if (groups_[mid].key < key)
+	  lo = mid + 1;
+	else
+	  hi = mid;
+      }
+    if (lo == groups_.size() || !(groups_[lo].key == key))
+      return;				// no quads in this lane
+
+    for (int i = groups_[lo].begin; i < groups_[lo].end; ++i)
+      {
+	if (filter(base, quads.polygons[indexes_[i]]))
+	  view.push_back(indexes_[i]);
+      }
+  }
+
+} // namespace quad_ops
@@ -0,0 +1,224 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART observers obstacle track store implementation.
+
+     @author Michael Quinlan
+
+ */
+
+#include <math.h>
+
+#include <art_observers/ObstacleTracker.h>
+
+/** @brief gate for associating a detection with a track (m)
+ *
+ *  A vehicle closing at 30 m/s moves 3 m between 10 Hz cycles, and
+ *  the detections snap to map quad midpoints, so the gate must span
+ *  both that motion and a quad length.
+ */
+#define MAX_ASSOC_DIST 6.0
+
+/// adjacent quads this close together are one obstacle (m)
+#define COALESCE_DIST 4.0
+
+/// drop a track unseen for this many cycles
+#define MAX_MISSES 3
+
+namespace observers
+{
+
+static inline float point_distance(float x1, float y1, float x2, float y2)
+{
+  float dx = x2 - x1;
+  float dy = y2 - y1;
+  return sqrtf(dx*dx + dy*dy);
+}
+
+/** Coalesce the obstacle quads into per-lane detections.
+ *
+ *  Obstacle quads arrive in map scan order, so the quads one vehicle
+ *  occupies are consecutive and in the same lane.  Consecutive
+ *  same-lane quads within COALESCE_DIST merge into one detection at
+ *  their mean midpoint.
+ */
+void ObstacleTracker::collectDetections(
+    const art_msgs::ArtLanes &obstacle_quads,
+    std::vector<Detection> &detections) const
+{
+  detections.clear();
+  for (size_t i = 0; i < obstacle_quads.polygons.size(); ++i)
+    {
+      const art_msgs::ArtQuadrilateral &quad = obstacle_quads.polygons[i];
+      float mx = quad.midpoint.x;
+      float my = quad.midpoint.y;
+
+      if (!detections.empty())
+	{
+	  Detection &last = detections.back();
+	  if (last.seg == quad.start_way.seg
+	      && last.lane == quad.start_way.lane
+	      && point_distance(last.x, last.y, mx, my) < COALESCE_DIST)
+	    {
+	      // same obstacle: fold the quad into the detection
+	      last.x = (last.x * last.quads + mx) / (last.quads + 1);
+	      last.y = (last.y * last.quads + my) / (last.quads + 1);
+	      ++last.quads;
+	      continue;
+	    }
+	}
+
+      Detection det;
+      det.seg = quad.start_way.seg;
+      det.lane = quad.start_way.lane;
+      det.x = mx;
+      det.y = my;
+      det.quads = 1;
+      det.track = -1;
+      detections.push_back(det);
+    }
+}
+
+void ObstacleTracker::update(const art_msgs::ArtLanes &obstacle_quads,
+			     const ros::Time &stamp)
+{
+  std::vector<Detection> detections;
+  collectDetections(obstacle_quads, detections);
+
+  double dt = (stamp - prev_update_).toSec();
+  prev_update_ = stamp;
+
+  // greedy nearest-neighbor association within each lane
+  std::vector<bool> matched(tracks_.size(), false);
+  for (size_t d = 0; d < detections.size(); ++d)
+    {
+      Detection &det = detections[d];
+      float best_dist = MAX_ASSOC_DIST;
+      int best = -1;
+      for (size_t t = 0; t < tracks_.size(); ++t)
+	{
+	  if (matched[t]
+	      || tracks_[t].seg != det.seg
+	      || tracks_[t].lane != det.lane)
+	    continue;
+	  float dist = point_distance(tracks_[t].x, tracks_[t].y,
+				      det.x, det.y);
+	  if (dist < best_dist)
+	    {
+	      best_dist = dist;
+	      best = t;
+	    }
+	}
+      if (best >= 0)
+	{
+	  matched[best] = true;
+	  det.track = best;
+	}
+    }
+
+  // apply the matched detections while track indices are stable
+  for (size_t d = 0; d < detections.size(); ++d)
+    {
+      const Detection &det = detections[d];
+      if (det.track < 0)
+	continue;
+      Track &track = tracks_[det.track];
+      if (dt > 0.0)
+	{
+	  float vx = (det.x - track.x) / dt;
+	  float vy = (det.y - track.y) / dt;
+	  track.vx_filter_.update(vx, track.vx);
+	  track.vy_filter_.update(vy, track.vy);
+	}
+      track.x = det.x;
+      track.y = det.y;
+      ++track.age;
+      track.misses = 0;
+    }
+
+  // retire tracks unseen for too long
+  size_t keep = 0;
+  for (size_t t = 0; t < tracks_.size(); ++t)
+    {
+      if (!matched[t] && ++tracks_[t].misses > MAX_MISSES)
+	continue;			// drop this track
+      if (t != keep)
+	tracks_[keep] = tracks_[t];
+      ++keep;
+    }
+  tracks_.resize(keep);
+
+  // start new tracks for the unmatched detections
+  for (size_t d = 0; d < detections.size(); ++d)
+    {
+      const Detection &det = detections[d];
+      if (det.track >= 0)
+	continue;
+      Track track;
+      track.id = next_id_++;
+      track.seg = det.seg;
+      track.lane = det.lane;
+      track.x = det.x;
+      track.y = det.y;
+      track.vx = track.vy = 0.0;
+      track.age = 0;
+      track.misses = 0;
+      tracks_.push_back(track);
+    }
+}
+
+int ObstacleTracker::trackId(const art_msgs::ArtQuadrilateral &quad) const
+{
+  float best_dist = MAX_ASSOC_DIST;
+  int best = -1;
+  for (size_t t = 0; t < tracks_.size(); ++t)
+    {
+      if (tracks_[t].seg != quad.start_way.seg
+	  || tracks_[t].lane != quad.start_way.lane)
+	continue;
+      float dist = point_distance(tracks_[t].x, tracks_[t].y,
+				  quad.midpoint.x, quad.midpoint.y);
+      if (dist < best_dist)
+	{
+	  best_dist = dist;
+	  best = t;
+	}
+    }
+  if (best < 0)
+    return -1;
+  return tracks_[best].id;
+}
+
+void ObstacleTracker::clear(void)
+{
+  tracks_.clear();
+}
+
+void ObstacleTracker::toMsg(art_msgs::ObstacleTrackArray &msg) const
+{
+  msg.tracks.resize(tracks_.size());
+  for (size_t t = 0; t < tracks_.size(); ++t)
+    {
+      const Track &track = tracks_[t];
+      art_msgs::ObstacleTrack &out = msg.tracks[t];
+      out.track_id = track.id;
+      out.lane.seg = track.seg;
+      out.lane.lane = track.lane;
+      out.lane.pt = 0;
+      out.position.x = track.x;
+      out.position.y = track.y;
+      out.position.z = 0.0;
+      out.velocity.x = track.vx;
+      out.velocity.y = track.vy;
+      out.velocity.z = 0.0;
+      out.age = track.age;
+    }
+}
+
+}; // namespace observers
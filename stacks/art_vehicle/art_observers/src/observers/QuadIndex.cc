@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART observers quadrilateral interval index implementation.
+
+     @author Michael Quinlan
+
+ */
+
+#include <math.h>
+#include <algorithm>
+
+#include <art_observers/QuadIndex.h>
+
+namespace quad_ops
+{
+  namespace
+  {
+    // indirect comparison for sorting quad indices by left edge
+    struct CompareMinX
+    {
+      const std::vector<float> &min_x;
+      explicit CompareMinX(const std::vector<float> &mx): min_x(mx) {}
+      bool operator()(int a, int b) const
+      {
+        return min_x[a] < min_x[b];
+      }
+    };
+  }
+
+  void QuadIndex::clear(void)
+  {
+    min_x_.clear();
+    max_x_.clear();
+    min_y_.clear();
+    max_y_.clear();
+    order_.clear();
+    sorted_min_x_.clear();
+    running_max_x_.clear();
+  }
+
+  void QuadIndex::rebuild(const art_msgs::ArtLanes &quads)
+  {
+    clear();
+
+    size_t n = quads.polygons.size();
+    if (n == 0)
+      return;
+
+    min_x_.resize(n);
+    max_x_.resize(n);
+    min_y_.resize(n);
+    max_y_.resize(n);
+    order_.resize(n);
+
+    for (size_t i = 0; i < n; ++i)
+      {
+        const geometry_msgs::Point32 *p = &quads.polygons[i].poly.points[0];
+        float minx = p[0].x, maxx = p[0].x;
+        float miny = p[0].y, maxy = p[0].y;
+        for (int v = 1; v < 4; ++v)
+          {
+            minx = fminf(minx, p[v].x);
+            maxx = fmaxf(maxx, p[v].x);
+            miny = fminf(miny, p[v].y);
+            maxy = fmaxf(maxy, p[v].y);
+          }
+        min_x_[i] = minx;
+        max_x_[i] = maxx;
+        min_y_[i] = miny;
+        max_y_[i] = maxy;
+        order_[i] = i;
+      }
+
+    std::sort(order_.begin(), order_.end(), CompareMinX(min_x_));
+
+    sorted_min_x_.resize(n);
+    running_max_x_.resize(n);
+    float run_max = -HUGE_VALF;
+    for (size_t k = 0; k < n; ++k)
+      {
+        sorted_min_x_[k] = min_x_[order_[k]];
+        run_max = fmaxf(run_max, max_x_[order_[k]]);
+        running_max_x_[k] = run_max;
+      }
+  }
+
+  void QuadIndex::getCandidates(float x, float y,
+                                std::vector<int> &candidates) const
+  {
+    candidates.clear();
+    if (order_.empty())
+      return;
+
+    // last sorted position whose left edge is at or before x
+    int k = std::upper_bound(sorted_min_x_.begin(), sorted_min_x_.end(), x)
+      - sorted_min_x_.begin() - 1;
+
+    // walk back while some box in the remaining prefix can still
+    // reach x
+    for (; k >= 0 && running_max_x_[k] >= x; --k)
+      {
+        int i = order_[k];
+        if (x <= max_x_[i] && y >= min_y_[i] && y <= max_y_[i])
+          candidates.push_back(i);
+      }
+  }
+
+} // namespace quad_ops
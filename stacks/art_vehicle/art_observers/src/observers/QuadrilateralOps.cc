@@ -1,6 +1,11 @@
 #include <art_map/types.h>
 #include <art_observers/QuadrilateralOps.h>
-#include <art_map/PolyOps.h> 
+#include <art_observers/LanePartition.h>
+#include <art_map/PolyOps.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace quad_ops {
 // determines if point lies in interior of given polygon points on
@@ -109,6 +114,206 @@ namespace quad_ops {
     return false;
   }
   
+  namespace
+  {
+    // per-quad constants precomputed once per batch: shrunk
+    // vertices, bounding box and edge slopes for the unrolled
+    // crossing test
+    struct QuadKernel
+    {
+      float vx[4], vy[4];		// vertices (after ratio shrink)
+      float slope[4];			// (bx-ax)/(by-ay) per edge
+      float minx, maxx, miny, maxy;	// bounding box
+
+      QuadKernel(const Quad& p, float ratio)
+      {
+        geometry_msgs::Point32 p1 = p.poly.points[0];
+        geometry_msgs::Point32 p2 = p.poly.points[1];
+        geometry_msgs::Point32 p3 = p.poly.points[2];
+        geometry_msgs::Point32 p4 = p.poly.points[3];
+
+        if (ratio < 1.0f)
+          {
+            // same ratio reduction as quickPointInPolyRatio()
+            const float diff = (1-ratio)/2;
+            p1.x=p1.x+(p4.x-p1.x)*diff;
+            p4.x=p1.x+(p4.x-p1.x)*(1-diff);
+            p1.y=p1.y+(p4.y-p1.y)*diff;
+            p4.y=p1.y+(p4.y-p1.y)*(1-diff);
+
+            p2.x=p2.x+(p3.x-p2.x)*diff;
+            p3.x=p2.x+(p3.x-p2.x)*(1-diff);
+            p2.y=p2.y+(p3.y-p2.y)*diff;
+            p3.y=p2.y+(p3.y-p2.y)*(1-diff);
+          }
+
+        vx[0]=p1.x; vx[1]=p2.x; vx[2]=p3.x; vx[3]=p4.x;
+        vy[0]=p1.y; vy[1]=p2.y; vy[2]=p3.y; vy[3]=p4.y;
+
+        minx = fminf(fminf(fminf(vx[0],vx[1]),vx[2]),vx[3]);
+        miny = fminf(fminf(fminf(vy[0],vy[1]),vy[2]),vy[3]);
+        maxx = fmaxf(fmaxf(fmaxf(vx[0],vx[1]),vx[2]),vx[3]);
+        maxy = fmaxf(fmaxf(fmaxf(vy[0],vy[1]),vy[2]),vy[3]);
+
+        for (int e = 0; e < 4; ++e)
+          {
+            int a = e;
+            int b = (e+1) & 3;
+            float dy = vy[b] - vy[a];
+            // horizontal edges never satisfy the crossing test, so
+            // the (unused) slope value does not matter
+            slope[e] = (dy != 0.0f) ? (vx[b]-vx[a])/dy : 0.0f;
+          }
+      }
+
+      // scalar crossing-number test against the precomputed quad
+      bool test(float x, float y) const
+      {
+        if (x < minx || x > maxx || y < miny || y > maxy)
+          return false;
+        bool odd = false;
+        for (int e = 0; e < 4; ++e)
+          {
+            int a = e;
+            int b = (e+1) & 3;
+            if ((vy[a] < y && vy[b] >= y) || (vy[b] < y && vy[a] >= y))
+              if (vx[a] + (y-vy[a])*slope[e] < x)
+                odd = !odd;
+          }
+        return odd;
+      }
+    };
+  } // anonymous namespace
+
+  // Batch test of N points against one quad.  The crossing tests are
+  // identical to quickPointInPolyRatio(), minus the edge-inclusion
+  // checks that function also skips.
+  size_t pointsInPolyBatch(const float *x, const float *y, size_t n,
+                           const Quad& p, float ratio,
+                           unsigned char *inside)
+  {
+    QuadKernel q(p, ratio);
+    size_t count = 0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    __m128 minx = _mm_set1_ps(q.minx);
+    __m128 maxx = _mm_set1_ps(q.maxx);
+    __m128 miny = _mm_set1_ps(q.miny);
+    __m128 maxy = _mm_set1_ps(q.maxy);
+
+    for (; i + 4 <= n; i += 4)
+      {
+        __m128 X = _mm_loadu_ps(x + i);
+        __m128 Y = _mm_loadu_ps(y + i);
+
+        // bounding box rejection
+        __m128 in_box =
+          _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(X, minx),
+                                _mm_cmple_ps(X, maxx)),
+                     _mm_and_ps(_mm_cmpge_ps(Y, miny),
+                                _mm_cmple_ps(Y, maxy)));
+        if (_mm_movemask_ps(in_box) == 0)
+          {
+            inside[i] = inside[i+1] = inside[i+2] = inside[i+3] = 0;
+            continue;
+          }
+
+        // crossing-number parity over the four edges
+        __m128 parity = _mm_setzero_ps();
+        for (int e = 0; e < 4; ++e)
+          {
+            int a = e;
+            int b = (e+1) & 3;
+            __m128 ay = _mm_set1_ps(q.vy[a]);
+            __m128 by = _mm_set1_ps(q.vy[b]);
+            __m128 crosses =
+              _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(ay, Y),
+                                   _mm_cmpge_ps(by, Y)),
+                        _mm_and_ps(_mm_cmplt_ps(by, Y),
+                                   _mm_cmpge_ps(ay, Y)));
+            __m128 t =
+              _mm_add_ps(_mm_set1_ps(q.vx[a]),
+                         _mm_mul_ps(_mm_sub_ps(Y, ay),
+                                    _mm_set1_ps(q.slope[e])));
+            __m128 left = _mm_cmplt_ps(t, X);
+            parity = _mm_xor_ps(parity, _mm_and_ps(crosses, left));
+          }
+
+        int mask = _mm_movemask_ps(_mm_and_ps(parity, in_box));
+        for (int lane = 0; lane < 4; ++lane)
+          {
+            unsigned char hit = (mask >> lane) & 1;
+            inside[i+lane] = hit;
+            count += hit;
+          }
+      }
+#endif // __SSE2__
+
+    // scalar remainder (and fallback without SSE2)
+    for (; i < n; ++i)
+      {
+        unsigned char hit = q.test(x[i], y[i]);
+        inside[i] = hit;
+        count += hit;
+      }
+
+    return count;
+  }
+
+  // Early-exit batch test: true if any of the N points is inside.
+  bool anyPointInPoly(const float *x, const float *y, size_t n,
+                      const Quad& p, float ratio)
+  {
+    QuadKernel q(p, ratio);
+    size_t i = 0;
+
+#ifdef __SSE2__
+    __m128 minx = _mm_set1_ps(q.minx);
+    __m128 maxx = _mm_set1_ps(q.maxx);
+    __m128 miny = _mm_set1_ps(q.miny);
+    __m128 maxy = _mm_set1_ps(q.maxy);
+
+    for (; i + 4 <= n; i += 4)
+      {
+        __m128 X = _mm_loadu_ps(x + i);
+        __m128 Y = _mm_loadu_ps(y + i);
+        __m128 in_box =
+          _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(X, minx),
+                                _mm_cmple_ps(X, maxx)),
+                     _mm_and_ps(_mm_cmpge_ps(Y, miny),
+                                _mm_cmple_ps(Y, maxy)));
+        int mask = _mm_movemask_ps(in_box);
+        if (mask == 0)
+          continue;
+
+        // few points survive the box test, finish them scalar
+        for (int lane = 0; lane < 4; ++lane)
+          if (((mask >> lane) & 1) && q.test(x[i+lane], y[i+lane]))
+            return true;
+      }
+#endif // __SSE2__
+
+    for (; i < n; ++i)
+      if (q.test(x[i], y[i]))
+        return true;
+
+    return false;
+  }
+
+  // Batch test of one point against N quads.
+  void pointInPolysBatch(float x, float y,
+                         const std::vector<Quad> &quads, float ratio,
+                         std::vector<unsigned char> &inside)
+  {
+    inside.resize(quads.size());
+    for (size_t i = 0; i < quads.size(); ++i)
+      {
+        QuadKernel q(quads[i], ratio);
+        inside[i] = q.test(x, y);
+      }
+  }
+
   // This function returns an ArtLanes containing all the
   // ArtQuadrilaterals in 'quads' that are satisfied by the 'filter'
   // being passed in
@@ -127,7 +332,24 @@ namespace quad_ops {
     return filtered;
   }
   
-  // This function returns an ArtLanes containing all the 
+  // View-based variant: records the indices of the matching quads
+  // instead of copying them.
+  void filterLanes(const art_msgs::ArtQuadrilateral& base_quad,
+                   const art_msgs::ArtLanes& quads,
+                   bool(*filter)(const art_msgs::ArtQuadrilateral&,
+                                 const art_msgs::ArtQuadrilateral&),
+                   QuadView &view)
+  {
+    view.clear(&quads);
+    size_t num_quads = quads.polygons.size();
+    for (size_t i=0; i<num_quads; i++) {
+      if (filter(base_quad,quads.polygons[i]))  {
+        view.push_back(i);
+      }
+    }
+  }
+
+  // This function returns an ArtLanes containing all the
   // ArtQuadrilaterals in 'quads' that are in the adjacent lane
   art_msgs::ArtLanes filterAdjacentLanes(MapPose &pose,
                                  const art_msgs::ArtLanes& quads,
@@ -140,6 +362,110 @@ namespace quad_ops {
     art_msgs::ArtLanes adjacentPolys;
     polyOps.GetLanes(to_polys, adjacentPolys);
     return adjacentPolys;
-    
+
+  }
+
+  namespace
+  {
+    // same proximity and inner-ratio test as
+    // Observer::getObstaclesInLane()
+    bool midpointInLane(float x, float y,
+                        const art_msgs::ArtLanes &lane_quads)
+    {
+      size_t num_polys = lane_quads.polygons.size();
+      for (size_t j = 0; j < num_polys; ++j)
+        {
+          const Quad &p = lane_quads.polygons[j];
+          float dx = p.midpoint.x - x;
+          float dy = p.midpoint.y - y;
+          if (dx*dx + dy*dy > 16)  // quick check: are we near the polygon?
+            continue;
+          if (quickPointInPolyRatio(x, y, p, 0.6))
+            return true;
+        }
+      return false;
+    }
+  } // anonymous namespace
+
+  // Refresh the shared per-cycle filter products.  Called once per
+  // obstacle cloud, before any observer runs.
+  void FilterCache::update(const art_msgs::ArtLanes &local_map,
+                           const art_msgs::ArtLanes &obstacles,
+                           MapPose pose,
+                           const LanePartition *partition)
+  {
+    // find the polygon containing the robot
+    PolyOps polyOps;
+    std::vector<poly> map_polys;
+    polyOps.GetPolys(local_map, map_polys);
+    int poly_index = polyOps.getClosestPoly(map_polys, pose.map.x, pose.map.y);
+    have_robot_quad = (poly_index >= 0);
+
+    if (have_robot_quad)
+      {
+        robot_quad = local_map.polygons[poly_index];
+
+        // Map quads ahead and behind in the current lane, selected
+        // as index views over the map message, not copies.  Use the
+        // per-lane partition when it matches this map, visiting only
+        // the robot's lane instead of scanning the whole map.
+        if (partition != NULL
+            && partition->size() == local_map.polygons.size())
+          {
+            partition->filterLanes(robot_quad, local_map,
+                                   *compare_forward_seg_lane,
+                                   lanes_forward);
+            partition->filterLanes(robot_quad, local_map,
+                                   *compare_backward_seg_lane,
+                                   lanes_backward);
+          }
+        else
+          {
+            filterLanes(robot_quad, local_map,
+                        *compare_forward_seg_lane, lanes_forward);
+            filterLanes(robot_quad, local_map,
+                        *compare_backward_seg_lane, lanes_backward);
+          }
+
+        // the obstacle quads change every cycle, so they are always
+        // filtered by a scan (of the small occupied-quad set)
+        obstacles_forward = filterLanes(robot_quad, obstacles,
+                                        *compare_forward_seg_lane);
+        obstacles_backward = filterLanes(robot_quad, obstacles,
+                                         *compare_backward_seg_lane);
+      }
+    else                                // no polygon near the robot
+      {
+        lanes_forward.clear();
+        obstacles_forward.polygons.clear();
+        lanes_backward.clear();
+        obstacles_backward.polygons.clear();
+      }
+
+    // One lateral-adjacency pass for both sides.  Reuse the map
+    // conversion above instead of re-converting the whole map per
+    // side as filterAdjacentLanes() does.
+    poly_list_t left_polys, right_polys;
+    polyOps.getLaneDir(map_polys, left_polys, 0, +1, pose);
+    polyOps.getLaneDir(map_polys, right_polys, 0, -1, pose);
+    polyOps.GetLanes(left_polys, lanes_left);
+    polyOps.GetLanes(right_polys, lanes_right);
+
+    // quads of each adjacent lane closest to the robot
+    index_left = polyOps.getClosestPoly(left_polys, pose.map.x, pose.map.y);
+    index_right = polyOps.getClosestPoly(right_polys, pose.map.x, pose.map.y);
+
+    // Bin the obstacle quads into either adjacent lane in one
+    // traversal, replacing a separate scan per side observer.
+    obstacles_left.polygons.clear();
+    obstacles_right.polygons.clear();
+    for (size_t i = 0; i < obstacles.polygons.size(); ++i)
+      {
+        const Quad &q = obstacles.polygons[i];
+        if (midpointInLane(q.midpoint.x, q.midpoint.y, lanes_left))
+          obstacles_left.polygons.push_back(q);
+        else if (midpointInLane(q.midpoint.x, q.midpoint.y, lanes_right))
+          obstacles_right.polygons.push_back(q);
+      }
   }
 }
@@ -39,23 +39,15 @@ AdjacentLeft::~AdjacentLeft()
  *  left lane.
  */
 art_msgs::Observation
-  AdjacentLeft::update(const art_msgs::ArtLanes &local_map,
-			 const art_msgs::ArtLanes &obstacles,
-			 MapPose pose_)
+  AdjacentLeft::update(const ObserverInput &input)
 {
-  
-  art_msgs::ArtLanes adj_lane_quads = quad_ops::filterAdjacentLanes
-					(pose_, local_map, 1);
+  // Adjacent left lane quads, their obstacle occupancy and the
+  // closest quad to the robot, all computed once per cycle by the
+  // shared lateral-adjacency pass in the filter cache.
+  const art_msgs::ArtLanes &adj_lane_quads = input.cache.lanes_left;
+  const art_msgs::ArtLanes &adj_lane_obstacles = input.cache.obstacles_left;
+  int index_adj = input.cache.index_left;
 
-  art_msgs::ArtLanes adj_lane_obstacles = getObstaclesInLane(obstacles, adj_lane_quads);
-  
-  //Finding closest poly in left lane
-  PolyOps polyOps_left;
-  std::vector<poly> adj_polys_left;
-  int index_adj = -1;
-  polyOps_left.GetPolys(adj_lane_quads, adj_polys_left);
-  index_adj = polyOps_left.getClosestPoly(adj_polys_left, pose_.map.x, pose_.map.y);
- 
   float distance = std::numeric_limits<float>::infinity();
   if (adj_lane_obstacles.polygons.size()!=0)
     {
@@ -126,4 +118,17 @@ art_msgs::Observation
                    
   return observation_;
 }
+
+/** @brief Applicable only when the map has an adjacent left lane.
+ *
+ *  In single-lane segments the shared lateral-adjacency pass finds no
+ *  left lane quads, so there is nothing this observer could report.
+ */
+bool AdjacentLeft::applies(const ObserverInput &input)
+{
+  if (!config_.gate_observers)
+    return true;
+  return !input.cache.lanes_left.polygons.empty();
+}
+
 }; // namespace observers
@@ -39,22 +39,15 @@ AdjacentRight::~AdjacentRight()
  *  right lane.
  */
 art_msgs::Observation
-  AdjacentRight::update(const art_msgs::ArtLanes &local_map,
-			 const art_msgs::ArtLanes &obstacles,
-			 MapPose pose_) {
+  AdjacentRight::update(const ObserverInput &input) {
 
-  art_msgs::ArtLanes adj_lane_quads = quad_ops::filterAdjacentLanes
-					(pose_, local_map, -1);
+  // Adjacent right lane quads, their obstacle occupancy and the
+  // closest quad to the robot, all computed once per cycle by the
+  // shared lateral-adjacency pass in the filter cache.
+  const art_msgs::ArtLanes &adj_lane_quads = input.cache.lanes_right;
+  const art_msgs::ArtLanes &adj_lane_obstacles = input.cache.obstacles_right;
+  int index_adj = input.cache.index_right;
 
-  art_msgs::ArtLanes adj_lane_obstacles = getObstaclesInLane(obstacles, adj_lane_quads);
-  
-  //Finding closest poly in left lane
-  PolyOps polyOps_right;
-  std::vector<poly> adj_polys_right;
-  int index_adj = -1;
-  polyOps_right.GetPolys(adj_lane_quads, adj_polys_right);
-  index_adj = polyOps_right.getClosestPoly(adj_polys_right, pose_.map.x, pose_.map.y);
- 
   float distance = std::numeric_limits<float>::infinity();
   if (adj_lane_obstacles.polygons.size()!=0)
     {
@@ -111,5 +104,17 @@ art_msgs::Observation
                    
   return observation_;
 }
+
+/** @brief Applicable only when the map has an adjacent right lane.
+ *
+ *  In single-lane segments the shared lateral-adjacency pass finds no
+ *  right lane quads, so there is nothing this observer could report.
+ */
+bool AdjacentRight::applies(const ObserverInput &input)
+{
+  if (!config_.gate_observers)
+    return true;
+  return !input.cache.lanes_right.polygons.empty();
 }
 
+}
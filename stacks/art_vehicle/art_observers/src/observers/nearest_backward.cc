@@ -27,6 +27,7 @@ NearestBackward::NearestBackward(art_observers::ObserversConfig &config):
 {
   distance_filter_.configure();
   velocity_filter_.configure();
+  tracked_id_ = -1;
 }
 
 NearestBackward::~NearestBackward() 
@@ -35,32 +36,17 @@ NearestBackward::~NearestBackward()
 
 // \brief  Update message with new data.
 art_msgs::Observation
-  NearestBackward::update(const art_msgs::ArtLanes &local_map,
-			  const art_msgs::ArtLanes &obstacles, 
-			  MapPose pose_)
+  NearestBackward::update(const ObserverInput &input)
 {
-
-  PolyOps polyOps;
-  std::vector<poly> map_polys;
-  int poly_index = -1;
-  polyOps.GetPolys(local_map, map_polys);
-  poly_index = polyOps.getClosestPoly(map_polys, pose_.map.x, pose_.map.y);
-
-  art_msgs::ArtQuadrilateral robot_quad1 = local_map.polygons[poly_index];
-
-  // get quadrilaterals ahead in the current lane
-  art_msgs::ArtLanes lane_quads =
-    quad_ops::filterLanes(robot_quad1, local_map,
-                          *quad_ops::compare_backward_seg_lane);
-
-  // get obstacles ahead in the current lane
-  art_msgs::ArtLanes lane_obstacles =
-    quad_ops::filterLanes(robot_quad1, obstacles,
-                          *quad_ops::compare_backward_seg_lane);
-
-  // reverse the vectors because the code that follows expects
+  // quadrilaterals and obstacles behind in the current lane, filtered
+  // once per cycle for all observers; the lane quads are a view over
+  // the local map message, walked in reverse below instead of being
+  // copied and reversed
+  const quad_ops::QuadView &lane_quads = input.cache.lanes_backward;
+  art_msgs::ArtLanes lane_obstacles = input.cache.obstacles_backward;
+
+  // reverse the obstacles because the code that follows expects
   // polygons in order of distance from base polygon
-  std::reverse(lane_quads.polygons.begin(), lane_quads.polygons.end());
   std::reverse(lane_obstacles.polygons.begin(), lane_obstacles.polygons.end());
 
   float distance = std::numeric_limits<float>::infinity();
@@ -69,25 +55,42 @@ art_msgs::Observation
       // get distance along road from robot to nearest obstacle
       int target_id = lane_obstacles.polygons[0].poly_id;
       distance = 0;
-      for (size_t i = 0; i < lane_quads.polygons.size(); i++)
+      for (size_t i = lane_quads.size(); i-- > 0; )
 	{
-	  distance += lane_quads.polygons[i].length;
-	  if (lane_quads.polygons[i].poly_id == target_id)
+	  distance += lane_quads[i].length;
+	  if (lane_quads[i].poly_id == target_id)
 	    break;
 	}
     }
 
+  // identity of the nearest obstacle, from the track store
+  int track_id = -1;
+  if (lane_obstacles.polygons.size() != 0 && input.tracks != NULL)
+    track_id = input.tracks->trackId(lane_obstacles.polygons[0]);
+
   // filter the distance by averaging over time
   float filt_distance;
   distance_filter_.update(distance, filt_distance);
-  
+
   // calculate velocity of object (including filter)
   float prev_distance = observation_.distance;
   ros::Time current_update(ros::Time::now());
   double time_change = (current_update - prev_update_).toSec();
-  float velocity = (filt_distance - prev_distance) / (time_change);
   float filt_velocity;
-  velocity_filter_.update(velocity,filt_velocity);
+  if (track_id == tracked_id_)
+    {
+      float velocity = (filt_distance - prev_distance) / (time_change);
+      velocity_filter_.update(velocity,filt_velocity);
+    }
+  else
+    {
+      // different obstacle than last cycle: the distance difference
+      // spans two objects and is not a velocity.  Restart the filter
+      // and report the observation inapplicable until it refills.
+      velocity_filter_ = MeanFilter();
+      filt_velocity = 0.0;
+      tracked_id_ = track_id;
+    }
   prev_update_ = current_update; // Reset prev_update time
 
   // Time to intersection (infinite if obstacle moving away)
@@ -111,4 +114,19 @@ art_msgs::Observation
   return observation_;
 }
 
+/** @brief Applicable unless gated off by speed on an open road.
+ *
+ *  Above the configured speed, traffic behind cannot close on the
+ *  robot, so with nothing currently detected behind in the lane this
+ *  observer has nothing to report.  It resumes the moment an obstacle
+ *  appears behind or the robot slows down.
+ */
+bool NearestBackward::applies(const ObserverInput &input)
+{
+  if (config_.backward_gate_speed <= 0.0
+      || input.robot_speed < config_.backward_gate_speed)
+    return true;
+  return !input.cache.obstacles_backward.polygons.empty();
+}
+
 }; // namespace observers
@@ -28,34 +28,22 @@ NearestForward::NearestForward(art_observers::ObserversConfig &config):
 {
   distance_filter_.configure();
   velocity_filter_.configure();
+  tracked_id_ = -1;
 }
 
-NearestForward::~NearestForward() 
+NearestForward::~NearestForward()
 {
 }
 
 // \brief Updates the message with new data received.
 art_msgs::Observation
-  NearestForward::update(const art_msgs::ArtLanes &local_map,
-			 const art_msgs::ArtLanes &obstacles,
-			 MapPose pose_)
+  NearestForward::update(const ObserverInput &input)
 {
-  PolyOps polyOps;
-  std::vector<poly> map_polys;
-  int poly_index = -1;
-  polyOps.GetPolys(local_map, map_polys);
-  poly_index = polyOps.getClosestPoly(map_polys, pose_.map.x, pose_.map.y);
-
-  art_msgs::ArtQuadrilateral robot_quad1 = local_map.polygons[poly_index];
-  // get quadrilaterals ahead in the current lane
-  art_msgs::ArtLanes lane_quads =
-    quad_ops::filterLanes(robot_quad1, local_map,
-                          *quad_ops::compare_forward_seg_lane);
-
-  // get obstacles ahead in the current lane
-  art_msgs::ArtLanes lane_obstacles =
-    quad_ops::filterLanes(robot_quad1, obstacles,
-                          *quad_ops::compare_forward_seg_lane);
+  // quadrilaterals and obstacles ahead in the current lane, filtered
+  // once per cycle for all observers; the lane quads are a view over
+  // the local map message, not a copy
+  const quad_ops::QuadView &lane_quads = input.cache.lanes_forward;
+  const art_msgs::ArtLanes &lane_obstacles = input.cache.obstacles_forward;
 
   float distance = std::numeric_limits<float>::infinity();
   if (lane_obstacles.polygons.size()!=0)
@@ -63,25 +51,42 @@ art_msgs::Observation
       // Get distance along road from robot to nearest obstacle
       int target_id = lane_obstacles.polygons[0].poly_id;
       distance = 0;
-      for (size_t i = 0; i < lane_quads.polygons.size(); i++)
+      for (size_t i = 0; i < lane_quads.size(); i++)
 	{
-	  distance += lane_quads.polygons[i].length;
-	  if (lane_quads.polygons[i].poly_id == target_id)
+	  distance += lane_quads[i].length;
+	  if (lane_quads[i].poly_id == target_id)
 	    break;
 	}
     }
 
+  // identity of the nearest obstacle, from the track store
+  int track_id = -1;
+  if (lane_obstacles.polygons.size() != 0 && input.tracks != NULL)
+    track_id = input.tracks->trackId(lane_obstacles.polygons[0]);
+
   // Filter the distance by averaging over time
   float filt_distance;
   distance_filter_.update(distance, filt_distance);
-  
+
   // Calculate velocity of object (including filter)
   float prev_distance = observation_.distance;
   ros::Time current_update(ros::Time::now());
   double time_change = (current_update - prev_update_).toSec();
-  float velocity = (filt_distance - prev_distance) / (time_change);
   float filt_velocity;
-  velocity_filter_.update(velocity,filt_velocity);
+  if (track_id == tracked_id_)
+    {
+      float velocity = (filt_distance - prev_distance) / (time_change);
+      velocity_filter_.update(velocity,filt_velocity);
+    }
+  else
+    {
+      // Different obstacle than last cycle: the distance difference
+      // spans two objects and is not a velocity.  Restart the filter
+      // and report the observation inapplicable until it refills.
+      velocity_filter_ = MeanFilter();
+      filt_velocity = 0.0;
+      tracked_id_ = track_id;
+    }
   prev_update_ = current_update; // Reset prev_update time
 
   // Time to intersection (infinite if obstacle moving away)
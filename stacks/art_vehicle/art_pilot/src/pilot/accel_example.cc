@@ -92,13 +92,13 @@ void AccelExample::adjust(art_msgs::PilotState &pstate,
   brake_request = clamp(0.0, brake_request, 1.0);
   if (fabsf(brake_request - brake->value()) > Epsilon::brake_position)
     {
-      brake->publish(brake_request, pstate.header.stamp);
+      brake->queue(brake_request, pstate.header.stamp);
     }
 
   throttle_request = clamp(0.0, throttle_request, 1.0);
   if (fabsf(throttle_request - throttle->value()) > Epsilon::throttle_position)
     {
-      throttle->publish(throttle_request, pstate.header.stamp);
+      throttle->queue(throttle_request, pstate.header.stamp);
     }
 }
 
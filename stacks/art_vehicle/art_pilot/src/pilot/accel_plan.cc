@@ -47,7 +47,7 @@ void AccelPlan::adjust(art_msgs::PilotState &pstate,
                        ServoPtr brake, ServoPtr throttle)
 {
   // check whether target has changed since previous cycle
-  float goal_speed = fabs(pstate.target.speed); 
+  float goal_speed = fabs(pstate.target.speed);
   float goal_accel = fabs(pstate.target.acceleration);
   if (goal_speed != speed_ || goal_accel !=accel_) // target changed?
     {
@@ -55,7 +55,7 @@ void AccelPlan::adjust(art_msgs::PilotState &pstate,
       speed_ = goal_speed;
       accel_ = goal_accel;
 
-      // make a new acceleration plan
+      // compile a new acceleration plan
       pstate.plan.acceleration = accel_;
       if (accel_ == 0.0)                // no acceleration limit?
         {
@@ -64,47 +64,35 @@ void AccelPlan::adjust(art_msgs::PilotState &pstate,
         }
       else
         {
-          // make plan starting with current speed
-          pstate.plan.speed = fabs(pstate.current.speed);
+          // make plan starting with current speed, backdated one
+          // nominal cycle so this cycle already makes progress
+          plan_speed_ = fabs(pstate.current.speed);
+          plan_start_ = (pstate.header.stamp
+                         - ros::Duration(1.0 / art_msgs::ArtHertz::PILOT));
         }
     }
 
-  // compute time since previous cycle
-  float dt;                             // delta T
-  if (prev_cycle_ == ros::Time())       // first cycle since reset?
-    {
-      // assume nominal cycle time
-      dt = 1.0 / art_msgs::ArtHertz::PILOT;
-    }
-  else
-    {
-      // use actual time since previous cycle
-      dt = (pstate.header.stamp - prev_cycle_).toSec();
-    }
-  
   // update plan in pilot state message
   if (accel_ != 0.0)                    // have acceleration limit?
     {
-      // gradually change planned speed
-      float error = speed_ - pstate.plan.speed;
-      float dv = accel_ * dt;           // desired delta V for this cycle
+      // Evaluate the compiled ramp at the elapsed time.  This is a
+      // single multiply per cycle, and unlike summing per-cycle
+      // increments it cannot accumulate timing error.
+      float error = speed_ - plan_speed_;
+      float dv = accel_ * (pstate.header.stamp - plan_start_).toSec();
 
-      // limit error term to absolute value of requested acceleration
       if (fabs(error) <= dv)
         {
-          pstate.plan.speed = speed_;
+          pstate.plan.speed = speed_;   // ramp complete
         }
       else
         {
-          pstate.plan.speed += dv * signum(error);
+          pstate.plan.speed = plan_speed_ + dv * signum(error);
         }
     }
 
   // request brake or throttle update to achieve planned velocity
   adjustVelocity(pstate, brake, throttle);
-
-  // remember time of this cycle
-  prev_cycle_ = pstate.header.stamp;
 }
 
 void AccelPlan::adjustVelocity(art_msgs::PilotState &pstate,
@@ -158,13 +146,13 @@ void AccelPlan::adjustVelocity(art_msgs::PilotState &pstate,
   brake_request = clamp(0.0, brake_request, 1.0);
   if (fabsf(brake_request - brake->value()) > Epsilon::brake_position)
     {
-      brake->publish(brake_request, pstate.header.stamp);
+      brake->queue(brake_request, pstate.header.stamp);
     }
 
   throttle_request = clamp(0.0, throttle_request, 1.0);
   if (fabsf(throttle_request - throttle->value()) > Epsilon::throttle_position)
     {
-      throttle->publish(throttle_request, pstate.header.stamp);
+      throttle->queue(throttle_request, pstate.header.stamp);
     }
 }
 
@@ -183,7 +171,8 @@ void AccelPlan::reconfigure(art_pilot::PilotConfig &newconfig)
 void AccelPlan::reset(void)
 {
   // clear any existing acceleration plan
-  prev_cycle_ == ros::Time();
+  plan_start_ = ros::Time();
+  plan_speed_ = 0.0;
   accel_ = 0.0;
   speed_ = 0.0;
 
@@ -64,7 +64,13 @@ private:
 
   float speed_;                   // absolute value of target velocity
   float accel_;                   // absolute value of acceleration
-  ros::Time prev_cycle_;          // previous cycle time for this plan
+
+  // Compiled plan: a ramp from plan_speed_ at plan_start_ toward
+  // speed_ at accel_ per second.  Made once when the target changes
+  // and reused, unchanged, while the target stays the same; each
+  // cycle just evaluates the ramp at the elapsed time.
+  ros::Time plan_start_;          // when this plan began
+  float plan_speed_;              // planned speed when it began
 
   // When true, brake is the controlling device, otherwise throttle.
   bool braking_;
@@ -1,12 +1,12 @@
 /*
  *  Copyright (C) 2011 Austin Robot Technology
  *  License: Modified BSD Software License Agreement
- * 
+ *
  *  $Id$
  */
 
 /**  @file
- 
+
      ART pilot acceleration controller using older speed controllers.
 
      @author Jack O'Quin
@@ -22,80 +22,47 @@
 namespace pilot
 {
 
-AccelSpeed::AccelSpeed(art_pilot::PilotConfig &config):
-  AccelBase(config)
+/** allocate the AccelSpeed variant for this configuration
+ *
+ *  The switch picks the speed controller type once, here, so each
+ *  template instance calls its controller directly with no virtual
+ *  dispatch in the control cycle.
+ */
+boost::shared_ptr<AccelBase> allocAccelSpeed(art_pilot::PilotConfig &config)
 {
+  boost::shared_ptr<AccelBase> controller;
+
   switch(config.acceleration_controller)
     {
     case art_pilot::Pilot_Speed_Learned:
       {
         ROS_INFO("using RL learned controller for speed control");
-        speed_.reset(new LearnedSpeedControl());
+        controller.reset(new AccelSpeed<LearnedSpeedControl>(config));
         break;
       }
     case art_pilot::Pilot_Speed_Matrix:
       {
         ROS_INFO("using acceleration matrix for speed control");
-        speed_.reset(new SpeedControlMatrix());
+        controller.reset(new AccelSpeed<SpeedControlMatrix>(config));
         break;
       }
+    default:
+      {
+        ROS_ERROR_STREAM("unexpected speed controller: "
+                         << config.acceleration_controller
+                         << " (using PID)");
+        config.acceleration_controller = art_pilot::Pilot_Speed_PID;
+        // no break: fall into next case...
+      }
     case art_pilot::Pilot_Speed_PID:
       {
         ROS_INFO("using brake and throttle PID for speed control");
-        speed_.reset(new SpeedControlPID());
+        controller.reset(new AccelSpeed<SpeedControlPID>(config));
         break;
       }
     }
 
-  // pass configuration parameters to the relevant speed controller
-  speed_->configure(config);
-};
-
-AccelSpeed::~AccelSpeed() {};
-
-void AccelSpeed::adjust(art_msgs::PilotState &pstate,
-                        ServoPtr brake, ServoPtr throttle)
-{
-  // initialize interface to old SpeedControl class
-  //
-  // abs_speed: absolute value of current velocity in m/s
-  // error: difference between that and our immediate goal
-  //
-  float abs_speed = fabs(pstate.current.speed);
-  float error = fabs(pstate.target.speed) - abs_speed;
-  float brake_request = brake->last_request();
-  float throttle_request = throttle->last_request();
-  speed_->set_brake_position(brake->value());
-  speed_->set_throttle_position(throttle->value());
-
-  // Adjust brake and throttle settings.
-  speed_->adjust(abs_speed, error,
-                 &brake_request, &throttle_request);
-
-  brake_request = clamp(0.0, brake_request, 1.0);
-  if (fabsf(brake_request - brake->value()) > EPSILON_BRAKE)
-    {
-      brake->publish(brake_request, pstate.header.stamp);
-    }
-
-  throttle_request = clamp(0.0, throttle_request, 1.0);
-  if (fabsf(throttle_request - throttle->value()) > EPSILON_THROTTLE)
-    {
-      throttle->publish(throttle_request, pstate.header.stamp);
-    }
-}
-
-/** allocate appropriate speed control subclass for this configuration */
-void AccelSpeed::reconfigure(art_pilot::PilotConfig &newconfig)
-{
-  // pass new configuration to underlying speed control class
-  speed_->configure(newconfig);
-}
-
-/** reset corresponding speed controller */
-void AccelSpeed::reset(void)
-{
-  speed_->reset();
+  return controller;
 }
 
-};
+}; // namespace pilot
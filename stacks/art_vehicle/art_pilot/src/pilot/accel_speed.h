@@ -2,12 +2,12 @@
  *
  *  Copyright (C) 2011 Austin Robot Technology
  *  License: Modified BSD Software License Agreement
- * 
+ *
  *  $Id$
  */
 
 /**  @file
- 
+
      ART pilot acceleration controller using older speed controllers.
 
      @author Jack O'Quin
@@ -23,13 +23,29 @@
 namespace pilot
 {
 
-/** Pilot acceleration controller for older speed control classes */
+/** Pilot acceleration controller for older speed control classes.
+ *
+ *  The speed controller type is a template parameter, selected once
+ *  at allocation by allocAccelSpeed().  Holding the controller by
+ *  value with its concrete type makes the cycle-rate adjust() call a
+ *  direct call the compiler can inline, instead of dispatching
+ *  through the SpeedControl vtable.  Reconfiguration still goes
+ *  through the dynamic path: changing the controller type allocates
+ *  a new instance.
+ */
+template <class SC>
 class AccelSpeed: public AccelBase
 {
  public:
 
-  AccelSpeed(art_pilot::PilotConfig &config);
-  virtual ~AccelSpeed();
+  AccelSpeed(art_pilot::PilotConfig &config):
+    AccelBase(config)
+  {
+    // pass configuration parameters to the speed controller
+    speed_.configure(config);
+  };
+
+  virtual ~AccelSpeed() {};
 
   typedef boost::shared_ptr<device_interface::ServoDeviceBase> ServoPtr;
 
@@ -40,19 +56,62 @@ class AccelSpeed: public AccelBase
    *  @param throttle shared pointer to throttle servo device interface
    */
   virtual void adjust(art_msgs::PilotState &pstate,
-                      ServoPtr brake, ServoPtr throttle);
+                      ServoPtr brake, ServoPtr throttle)
+  {
+    // initialize interface to old SpeedControl class
+    //
+    // abs_speed: absolute value of current velocity in m/s
+    // error: difference between that and our immediate goal
+    //
+    float abs_speed = fabs(pstate.current.speed);
+    float error = fabs(pstate.target.speed) - abs_speed;
+    float brake_request = brake->last_request();
+    float throttle_request = throttle->last_request();
+    speed_.set_brake_position(brake->value());
+    speed_.set_throttle_position(throttle->value());
+
+    // Adjust brake and throttle settings.
+    speed_.adjust(abs_speed, error,
+                  &brake_request, &throttle_request);
+
+    brake_request = clamp(0.0, brake_request, 1.0);
+    if (fabsf(brake_request - brake->value()) > EPSILON_BRAKE)
+      {
+        brake->queue(brake_request, pstate.header.stamp);
+      }
+
+    throttle_request = clamp(0.0, throttle_request, 1.0);
+    if (fabsf(throttle_request - throttle->value()) > EPSILON_THROTTLE)
+      {
+        throttle->queue(throttle_request, pstate.header.stamp);
+      }
+  }
 
   /** Reconfigure controller parameters. */
-  virtual void reconfigure(art_pilot::PilotConfig &newconfig);
+  virtual void reconfigure(art_pilot::PilotConfig &newconfig)
+  {
+    // pass new configuration to underlying speed control class
+    speed_.configure(newconfig);
+  }
 
   /** Reset accel_speed controller. */
-  virtual void reset(void);
+  virtual void reset(void)
+  {
+    speed_.reset();
+  }
 
 private:
 
-  boost::shared_ptr<SpeedControl> speed_; // speed control
+  SC speed_;                    // speed control, statically dispatched
 };
-  
+
+/** Allocate the AccelSpeed variant for this configuration.
+ *
+ *  @param config current Pilot configuration parameters
+ *  @return boost shared pointer to a newly allocated controller
+ */
+boost::shared_ptr<AccelBase> allocAccelSpeed(art_pilot::PilotConfig &config);
+
 }; // namespace pilot
 
 #endif // _ACCEL_SPEED_H_
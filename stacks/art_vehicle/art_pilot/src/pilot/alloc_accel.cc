@@ -61,7 +61,7 @@ boost::shared_ptr<AccelBase>
     case art_pilot::Pilot_Speed_PID:
       {
         // An older, speed-based controller. It will figure out which.
-        controller.reset(new AccelSpeed(config));
+        controller = allocAccelSpeed(config);
         break;
       }
     }
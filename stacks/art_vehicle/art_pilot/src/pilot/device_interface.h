@@ -57,7 +57,8 @@ class ServoDeviceBase: public DeviceBase
       @param node handle for state and command topics
   */
   ServoDeviceBase(ros::NodeHandle node):
-    DeviceBase(node)
+    DeviceBase(node),
+    pending_(false)
   {}
 
   virtual float last_request() = 0;
@@ -70,8 +71,40 @@ class ServoDeviceBase: public DeviceBase
   */
   virtual void publish(float new_position, ros::Time cycle_time) = 0;
 
+  /** Queue a servo request for the next flush().
+
+      Controllers queue their requests while deciding what to do;
+      the pilot cycle then flushes all queued actuator commands back
+      to back, in priority order, instead of publishing them from
+      scattered points in the control computation.
+
+      @param new_position new position requested
+      @param cycle_time current pilot cycle time stamp
+  */
+  void queue(float new_position, ros::Time cycle_time)
+  {
+    pending_position_ = new_position;
+    pending_time_ = cycle_time;
+    pending_ = true;
+  }
+
+  /** Publish the queued servo request, if any. */
+  void flush(void)
+  {
+    if (pending_)
+      {
+        publish(pending_position_, pending_time_);
+        pending_ = false;
+      }
+  }
+
 protected:
   ros::Publisher pub_;                  // command message publisher
+
+private:
+  bool pending_;                        // request queued, not yet sent
+  float pending_position_;              // queued position request
+  ros::Time pending_time_;              // queued request time stamp
 };
 
 }; // end device_interface namespace
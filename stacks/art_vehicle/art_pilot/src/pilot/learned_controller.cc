@@ -18,6 +18,9 @@ LearnedSpeedControl::LearnedSpeedControl():
 			    + "/src/pilot/control1400.pol");
   loadPolicy(policyPath.c_str());
 
+  // flatten the loaded policy for constant-time lookup
+  compilePolicy();
+
   // init state vector
   s.resize(4,0);
 }
@@ -28,6 +31,7 @@ LearnedSpeedControl::~LearnedSpeedControl()
   statespace.clear();
   Q.clear();
   s.clear();
+  policy_table_.clear();
 }
 
 /** Adjust speed to match goal.
@@ -135,15 +139,67 @@ void LearnedSpeedControl::reset(void)
 
 int LearnedSpeedControl::getAction(const std::vector<float> &s) {
 
-  // Get action values
-  std::vector<float> &Q_s = Q[canonicalize(s)];
-  const std::vector<float>::iterator max =
-    std::max_element(Q_s.begin(), Q_s.end());
+  // discretized state features, already integral values
+  int i0 = (int) s[0];
+  int i1 = (int) s[1];
+  int i2 = (int) s[2];
+  int i3 = (int) s[3];
+
+  if (i0 < 0 || i0 >= DIM_TARGET
+      || i1 < 0 || i1 >= DIM_SPEED
+      || i2 < 0 || i2 >= DIM_THROTTLE
+      || i3 < 0 || i3 >= DIM_BRAKE){
+    ROS_ERROR("State outside policy table: %f, %f, %f, %f",
+              s[0], s[1], s[2], s[3]);
+    return 0;                           // no change
+  }
+
+  int act = policy_table_[((i0*DIM_SPEED + i1)*DIM_THROTTLE + i2)*DIM_BRAKE
+                          + i3];
+  if (act < 0){
+    // same report canonicalize() used to make for novel states
+    ROS_ERROR("State unknown in policy: %f, %f, %f, %f",
+              s[0], s[1], s[2], s[3]);
+    return 0;                           // no change
+  }
 
-  // Choose an action
-  const std::vector<float>::iterator a = max;
+  return act;
+}
+
+void LearnedSpeedControl::compilePolicy(void) {
+
+  policy_table_.assign(DIM_TARGET * DIM_SPEED * DIM_THROTTLE * DIM_BRAKE, -1);
+
+  int skipped = 0;
+  for (std::map<state_t, std::vector<float> >::iterator it = Q.begin();
+       it != Q.end(); ++it){
+    const std::vector<float> &state = *it->first;
+    int i0 = (int) state[0];
+    int i1 = (int) state[1];
+    int i2 = (int) state[2];
+    int i3 = (int) state[3];
+
+    if (i0 < 0 || i0 >= DIM_TARGET
+        || i1 < 0 || i1 >= DIM_SPEED
+        || i2 < 0 || i2 >= DIM_THROTTLE
+        || i3 < 0 || i3 >= DIM_BRAKE){
+      skipped++;
+      continue;
+    }
 
-  return a - Q_s.begin();
+    std::vector<float> &Q_s = it->second;
+    int act = std::max_element(Q_s.begin(), Q_s.end()) - Q_s.begin();
+    policy_table_[((i0*DIM_SPEED + i1)*DIM_THROTTLE + i2)*DIM_BRAKE + i3] =
+      act;
+  }
+
+  if (skipped > 0){
+    ROS_WARN("%i policy states outside table bounds ignored", skipped);
+  }
+
+  // the loading structures are no longer needed
+  statespace.clear();
+  Q.clear();
 }
 
 
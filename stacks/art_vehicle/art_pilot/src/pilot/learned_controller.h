@@ -45,6 +45,28 @@ class LearnedSpeedControl: public SpeedControl
 
   void loadPolicy(const char* filename);
 
+  /** Table dimensions for each discretized state feature, matching
+      the quantization done in adjust(): target velocity in 0.5 m/s
+      steps up to 11, speed in 0.1 m/s steps up to 12, throttle in 0.1
+      steps up to 0.4, brake in 0.1 steps up to 1.0. */
+  enum
+    {
+      DIM_TARGET = 23,
+      DIM_SPEED = 121,
+      DIM_THROTTLE = 5,
+      DIM_BRAKE = 11
+    };
+
+  /** Compiled policy: the best action for each discretized state,
+      flattened into one contiguous array so inference is a single
+      bounds-checked read.  Entries still -1 after compilePolicy()
+      never appeared in the policy file. */
+  std::vector<signed char> policy_table_;
+
+  /** Flatten the loaded Q table into policy_table_, then release the
+      loading structures. */
+  void compilePolicy(void);
+
   const int numactions;
 
   bool LOADDEBUG;
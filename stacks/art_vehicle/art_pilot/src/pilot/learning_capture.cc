@@ -0,0 +1,131 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Asynchronous learning-data capture implementation.
+
+     @author Jack O'Quin
+
+ */
+
+#include <ros/ros.h>
+
+#include "learning_capture.h"
+
+namespace
+{
+  /** capture file header, preceding the raw Sample records */
+  struct CaptureHeader
+  {
+    uint32_t magic;                     // always CAPTURE_MAGIC
+    uint32_t version;                   // format version
+    uint32_t sample_size;               // sizeof(Sample) when written
+    uint32_t reserved;                  // padding, always zero
+  };
+
+  static const uint32_t CAPTURE_MAGIC = 0x31504341; // "ACP1"
+  static const uint32_t CAPTURE_VERSION = 1;
+}
+
+LearningCapture::LearningCapture():
+  head_(0),
+  tail_(0),
+  running_(false),
+  dropped_(0),
+  file_(NULL)
+{}
+
+LearningCapture::~LearningCapture()
+{
+  stop();
+}
+
+/** Start capturing to @a path.
+ *
+ *  @return true if the capture file opened and the writer started.
+ */
+bool LearningCapture::start(const std::string &path)
+{
+  if (running_)
+    return true;                        // already capturing
+
+  file_ = fopen(path.c_str(), "wb");
+  if (file_ == NULL)
+    {
+      ROS_ERROR("unable to open learning capture file %s", path.c_str());
+      return false;
+    }
+
+  CaptureHeader header;
+  header.magic = CAPTURE_MAGIC;
+  header.version = CAPTURE_VERSION;
+  header.sample_size = sizeof(Sample);
+  header.reserved = 0;
+  fwrite(&header, sizeof(header), 1, file_);
+
+  head_ = tail_ = 0;
+  dropped_ = 0;
+  running_ = true;
+  thread_.reset(new boost::thread(boost::bind(&LearningCapture::writerThread,
+                                              this)));
+  ROS_INFO("learning capture started: %s", path.c_str());
+  return true;
+}
+
+/** Stop capturing: drain the ring, join the writer, close the file. */
+void LearningCapture::stop(void)
+{
+  if (!running_)
+    return;
+
+  running_ = false;
+  if (thread_)
+    {
+      thread_->join();
+      thread_.reset();
+    }
+  if (file_ != NULL)
+    {
+      fclose(file_);
+      file_ = NULL;
+    }
+  ROS_INFO("learning capture stopped: %lu samples written, %lu dropped",
+           (unsigned long) tail_, dropped_);
+}
+
+/** Enqueue one sample from the control thread. */
+void LearningCapture::enqueue(const Sample &sample)
+{
+  if (!running_)
+    return;
+  if (head_ - tail_ >= QUEUE_SIZE)
+    {
+      ++dropped_;                       // writer behind: drop, never block
+      return;
+    }
+  queue_[head_ & (QUEUE_SIZE - 1)] = sample;
+  ++head_;                              // publish the sample last
+}
+
+/** Writer thread: drain the ring to disk until stopped. */
+void LearningCapture::writerThread(void)
+{
+  while (running_ || tail_ != head_)
+    {
+      if (tail_ == head_)
+        {
+          // ring empty: sleep briefly off the control path
+          boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+          continue;
+        }
+      const Sample &sample = queue_[tail_ & (QUEUE_SIZE - 1)];
+      fwrite(&sample, sizeof(sample), 1, file_);
+      ++tail_;                          // free the slot last
+    }
+  fflush(file_);
+}
@@ -0,0 +1,86 @@
+/* -*- mode: C++ -*-
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Asynchronous learning-data capture for the ART pilot.
+
+     The control loop enqueues one binary sample per cycle on a
+     bounded single-producer, single-consumer ring; a writer thread
+     drains the ring to disk.  Capture therefore costs the control
+     loop only a struct copy and an index increment, so training data
+     can be collected during real runs.
+
+     @author Jack O'Quin
+
+ */
+
+#ifndef _LEARNING_CAPTURE_H_
+#define _LEARNING_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+class LearningCapture
+{
+ public:
+
+  /** one captured training sample, written to disk verbatim */
+  struct Sample
+  {
+    double stamp;                       // ROS time of the cycle
+    float speed;                        // current speed (m/s)
+    float target_speed;                 // commanded speed (m/s)
+    float accel;                        // measured acceleration (m/s^2)
+    float brake_position;               // current brake position
+    float throttle_position;            // current throttle position
+    float steering_angle;               // current steering angle (rad)
+    float preempted;                    // 1.0 when a human is driving
+  };
+
+  LearningCapture();
+  ~LearningCapture();
+
+  /** @brief start capturing to @a path, spawning the writer thread */
+  bool start(const std::string &path);
+
+  /** @brief drain the queue, stop the writer thread, close the file */
+  void stop(void);
+
+  /** @brief true while capture is running */
+  bool enabled(void) const {return running_;}
+
+  /** @brief enqueue one sample (control thread, never blocks)
+   *
+   *  When the writer thread falls behind and the ring fills, the
+   *  sample is dropped and counted: losing a training sample is
+   *  better than stalling the control cycle.
+   */
+  void enqueue(const Sample &sample);
+
+ private:
+
+  void writerThread(void);
+
+  // ring size, must be a power of two (about 3 minutes at 20 Hz)
+  enum { QUEUE_SIZE = 4096 };
+
+  Sample queue_[QUEUE_SIZE];
+  volatile uint32_t head_;              // next slot, control thread only
+  volatile uint32_t tail_;              // next unread, writer thread only
+  volatile bool running_;               // capture active
+  unsigned long dropped_;               // samples lost to a full ring
+  FILE *file_;                          // capture output file
+  boost::shared_ptr<boost::thread> thread_; // writer thread
+};
+
+#endif // _LEARNING_CAPTURE_H_
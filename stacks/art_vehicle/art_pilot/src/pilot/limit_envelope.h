@@ -0,0 +1,95 @@
+/* -*- mode: C++ -*-
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     ART pilot command limit envelope.
+
+     @author Jack O'Quin
+
+ */
+
+#ifndef _LIMIT_ENVELOPE_H_
+#define _LIMIT_ENVELOPE_H_
+
+#include <math.h>
+
+#include <art_msgs/ArtVehicle.h>
+#include <art_msgs/CarDrive.h>
+#include <art_msgs/Gear.h>
+#include <art_msgs/PilotLimits.h>
+#include <art_pilot/PilotConfig.h>
+
+namespace pilot
+{
+
+/** Precomputed limit envelope for pilot driving commands.
+ *
+ *  The active limits only change on dynamic reconfigure, so they are
+ *  packed here once by update() and the cycle-rate clamp() reduces to
+ *  a few fminf()/fmaxf() operations, with the speed limit selected by
+ *  gear through a small table instead of a conditional chain.  The
+ *  packed limits are also available as a PilotLimits message for
+ *  publication.
+ */
+class LimitEnvelope
+{
+ public:
+
+  LimitEnvelope()
+  {
+    max_speed_[0] = 0.0;                // no motion until configured
+    max_speed_[1] = 0.0;
+    msg_.max_steering_angle = art_msgs::ArtVehicle::max_steer_radians;
+  }
+
+  /** Recompute the envelope from a new configuration.
+   *
+   *  @param config pilot configuration parameters
+   */
+  void update(const art_pilot::PilotConfig &config)
+  {
+    max_speed_[0] = config.limit_forward;
+    max_speed_[1] = config.limit_reverse;
+    msg_.max_speed_forward = config.limit_forward;
+    msg_.max_speed_reverse = config.limit_reverse;
+  }
+
+  /** Clamp a driving command to the envelope.
+   *
+   *  @param target command to clamp, modified in place
+   *  @returns true if the requested speed exceeded its limit
+   */
+  bool clamp(art_msgs::CarDrive &target) const
+  {
+    int rev = (target.gear.value == art_msgs::Gear::Reverse);
+    float limit = max_speed_[rev];
+    bool speeding = (target.speed > limit);
+    target.speed = fminf(target.speed, limit);
+    target.steering_angle = fminf(msg_.max_steering_angle,
+                                  fmaxf(-msg_.max_steering_angle,
+                                        target.steering_angle));
+    return speeding;
+  }
+
+  /** Currently active limits, ready to publish. */
+  const art_msgs::PilotLimits &limits(void) const
+  {
+    return msg_;
+  }
+
+ private:
+
+  float max_speed_[2];                  /**< speed limit, indexed by
+                                         *   (gear == Reverse) */
+  art_msgs::PilotLimits msg_;           /**< packed active limits */
+};
+
+}; // namespace pilot
+
+#endif // _LIMIT_ENVELOPE_H_
@@ -20,6 +20,12 @@
  */
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
 
 #include <angles/angles.h>
 #include <driver_base/SensorLevels.h>
@@ -29,20 +35,29 @@
 
 #include <art_msgs/ArtVehicle.h>
 #include <art_msgs/ArtHertz.h>
+#include <art_msgs/BringupState.h>
 #include <art_msgs/CarDriveStamped.h>
 #include <art_msgs/CarCommand.h>
 #include <art_msgs/Epsilon.h>
 #include <art_msgs/Gear.h>
 #include <art_msgs/LearningCommand.h>
 #include <art_msgs/PilotState.h>
+#include <art_msgs/PipelineEvent.h>
 
 #include <art/conversions.h>
+#include <art/cycle_deadline.h>
+#include <art/flight_recorder.h>
+#include <art/pose_predict.h>
+#include <art/profiler.h>
+#include <art/realtime.h>
 #include <art/steering.h>
 
 #include <art_pilot/PilotConfig.h>
 typedef art_pilot::PilotConfig Config;
 
 #include "accel.h"
+#include "learning_capture.h"
+#include "limit_envelope.h"
 
 typedef art_msgs::DriverState DriverState;
 using art_msgs::Epsilon;
@@ -71,6 +86,8 @@ Subscribes:
 Publishes:
 
 - @b pilot/state [art_msgs::PilotState] current pilot state information.
+- @b pilot/limits [art_msgs::PilotLimits] active command limits (latched,
+     published on reconfigure).
 - @b brake/cmd [art_msgs::BrakeCommand] brake commands.
 - @b shifter/cmd [art_msgs::Shifter] shifter commands.
 - @b steering/cmd [art_msgs::SteeringCommand] steering commands.
@@ -84,17 +101,20 @@ class PilotNode
 public:
 
   PilotNode(ros::NodeHandle node);
-  void spin(void);
+  void spin(bool embedded = false);
 
 private:
 
   void adjustSteering(void);
+  void announceBringup(uint8_t state, const char *detail);
+  void applyIncoming(void);
   void halt(void);
   void monitorHardware(void);
   void processCarDrive(const art_msgs::CarDriveStamped::ConstPtr &msg);
   void processCarCommand(const art_msgs::CarCommand::ConstPtr &msg);
   void processLearning(const art_msgs::LearningCommand::ConstPtr &learningIn);
   void reconfig(Config &newconfig, uint32_t level);
+  void reportFailures(const ros::TimerEvent &event);
   void speedControl(void);
   void validateTarget(void);
 
@@ -107,6 +127,36 @@ private:
   ros::Subscriber accel_cmd_;           // CarDriveStamped command
   ros::Subscriber car_cmd_;             // CarCommand
 
+  // Device state topics are serviced by the control thread through
+  // this private queue, so their data need no locking.
+  ros::CallbackQueue device_queue_;
+
+  // Complete configuration snapshot built by the message thread.
+  // reconfig() assembles the whole bundle, including any new
+  // acceleration controller, before publishing it with one shared
+  // pointer swap; the control thread picks it up at the next cycle
+  // boundary and applies it outside the critical section.
+  typedef struct
+  {
+    Config config;                      // new configuration
+    boost::shared_ptr<pilot::AccelBase> accel; // if reallocated
+  } config_snapshot_t;
+
+  // Data deposited by the message thread, applied at the start of
+  // each control cycle by applyIncoming().  Guarded by msg_mutex_.
+  typedef struct
+  {
+    bool have_target;                   // new target command arrived
+    art_msgs::CarDrive target;          // latest target command
+    ros::Time goal_time;                // its time stamp
+    bool have_preempt;                  // new preemption state arrived
+    bool preempted;                     // latest preemption state
+    boost::shared_ptr<config_snapshot_t> snapshot; // new configuration
+  } incoming_t;
+
+  boost::mutex msg_mutex_;
+  incoming_t incoming_;
+
   // Device interfaces used by pilot
   boost::shared_ptr<device_interface::DeviceBrake> brake_;
   boost::shared_ptr<device_interface::DeviceImu> imu_;
@@ -117,7 +167,16 @@ private:
 
   ros::Subscriber learning_cmd_;
 
+  ros::Publisher bringup_state_;        // bringup readiness reports
+  bool bringup_announced_;              // RUNNING already reported
   ros::Publisher pilot_state_;          // pilot state
+  ros::Publisher trace_pub_;            // pipeline latency trace events
+  ros::Publisher limits_pub_;           // active command limits
+  ros::Publisher diag_pub_;             // control section timing
+
+  // Command limit envelope, recomputed only when the configuration
+  // changes, so validateTarget() reduces to a few min/max operations.
+  pilot::LimitEnvelope envelope_;
 
   // configuration
   Config config_;                       // dynamic configuration
@@ -125,6 +184,27 @@ private:
 
   ros::Time current_time_;              // time current cycle began
 
+  // Device health bitmask: zero when every critical device is
+  // running.  The control cycle stores it with a single word-sized
+  // write; the low-rate monitor timer reads it from the message
+  // thread and does the diagnostic logging, so a device timeout
+  // never adds logging latency to a cycle that must command the
+  // brake.
+  enum FailureBits
+    {
+      FAIL_BRAKE    = 0x01,
+      FAIL_IMU      = 0x02,
+      FAIL_ODOM     = 0x04,
+      FAIL_STEERING = 0x08,
+      FAIL_THROTTLE = 0x10
+    };
+  volatile uint32_t device_failures_;
+  ros::Timer monitor_timer_;            // low-rate failure reporting
+
+  CycleDeadline deadline_;              // cycle deadline monitor
+  Profiler profiler_;                   // control section profiler
+  LearningCapture capture_;             // async learning-data capture
+
   // times when messages received
   ros::Time goal_time_;                 // latest goal command
 
@@ -141,20 +221,31 @@ private:
 /** constructor */
 PilotNode::PilotNode(ros::NodeHandle node):
   is_shifting_(false),
-  reconfig_server_(new dynamic_reconfigure::Server<Config>)
+  reconfig_server_(new dynamic_reconfigure::Server<Config>),
+  bringup_announced_(false),
+  device_failures_(0),
+  deadline_(art_msgs::ArtHertz::PILOT)
 {
+  incoming_.have_target = false;
+  incoming_.have_preempt = false;
+
   // Must declare dynamic reconfigure callback before initializing
-  // devices or subscribing to topics.
+  // devices or subscribing to topics.  The initial callback runs
+  // right here, so applyIncoming() sees a valid configuration and
+  // acceleration controller on the first cycle.
   reconfig_server_->setCallback(boost::bind(&PilotNode::reconfig,
                                             this, _1, _2));
 
-  // allocate and initialize device interfaces
-  brake_.reset(new device_interface::DeviceBrake(node));
-  imu_.reset(new device_interface::DeviceImu(node));
-  odom_.reset(new device_interface::DeviceOdom(node));
-  shifter_.reset(new device_interface::DeviceShifter(node));
-  steering_.reset(new device_interface::DeviceSteering(node));
-  throttle_.reset(new device_interface::DeviceThrottle(node));
+  // allocate and initialize device interfaces, with their state
+  // topics on the control thread's private callback queue
+  ros::NodeHandle device_node(node);
+  device_node.setCallbackQueue(&device_queue_);
+  brake_.reset(new device_interface::DeviceBrake(device_node));
+  imu_.reset(new device_interface::DeviceImu(device_node));
+  odom_.reset(new device_interface::DeviceOdom(device_node));
+  shifter_.reset(new device_interface::DeviceShifter(device_node));
+  steering_.reset(new device_interface::DeviceSteering(device_node));
+  throttle_.reset(new device_interface::DeviceThrottle(device_node));
 
   // no delay: we always want the most recent data
   ros::TransportHints noDelay = ros::TransportHints().tcpNoDelay(true);
@@ -171,27 +262,180 @@ PilotNode::PilotNode(ros::NodeHandle node):
   // topic for publishing pilot state
   pilot_state_ = node.advertise<art_msgs::PilotState>("pilot/state", qDepth);
   pstate_msg_.header.frame_id = art_msgs::ArtVehicle::frame_id;
+
+  // bringup readiness reports, latched so launch tooling that
+  // subscribes late still sees the current state
+  bringup_state_ =
+    node.advertise<art_msgs::BringupState>("bringup/state", 1, true);
+  announceBringup(DriverState::OPENED, "waiting for servo devices");
+
+  // latched topic reporting the active command limits, published
+  // whenever the configuration changes
+  limits_pub_ = node.advertise<art_msgs::PilotLimits>("pilot/limits",
+                                                      qDepth, true);
+
+  // pipeline latency trace events
+  trace_pub_ = node.advertise<art_msgs::PipelineEvent>("pipeline_trace",
+                                                       qDepth);
+
+  // control section timing diagnostics
+  diag_pub_ =
+    node.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", qDepth);
+
+  // Low-rate device failure reporting, serviced by the message
+  // thread so the diagnostic path stays off the control cycle.
+  monitor_timer_ = node.createTimer(ros::Duration(1.0),
+                                    &PilotNode::reportFailures, this);
+
+  // Learning-data capture: when ~learning_capture names a file, one
+  // binary sample per control cycle gets queued to a writer thread.
+  std::string capture_path;
+  ros::NodeHandle private_nh("~");
+  private_nh.param("learning_capture", capture_path, std::string(""));
+  if (!capture_path.empty())
+    capture_.start(capture_path);
 }
 
-/** main loop */
-void PilotNode::spin(void)
+/** main loop
+ *
+ *  This thread only runs control: a separate message thread services
+ *  the command and reconfigure callbacks from the global queue, so a
+ *  burst of incoming commands never delays actuator output.  Device
+ *  state messages stay on this thread, through a private callback
+ *  queue holding at most one message per device.
+ */
+void PilotNode::spin(bool embedded)
 {
+  // Start the message thread, unless a nodelet manager is already
+  // servicing our command and reconfigure callbacks.
+  ros::AsyncSpinner message_thread(1);
+  if (!embedded)
+    message_thread.start();
+
+  // dump flight recorder rings on fault or SIGUSR1
+  FlightRecorder::install_handlers();
+
+  // apply real-time scheduling configuration, if any
+  Realtime::configure("pilot");
+
   // Main loop
   ros::Rate cycle(art_msgs::ArtHertz::PILOT); // set driver cycle rate
+  uint32_t cycle_count = 0;
   while(ros::ok())
     {
-      ros::spinOnce();                  // handle incoming messages
+      deadline_.begin();                // start of control cycle
+
+      // handle any pending device state messages
+      device_queue_.callAvailable(ros::WallDuration());
+
+      applyIncoming();                  // latest command and config
 
       monitorHardware();                // monitor device status
 
-      // issue control commands
-      speedControl();
-      adjustSteering();
+      // issue control commands, timing each section
+      {
+        Profiler::Scope scope(&profiler_, "speed control");
+        speedControl();
+      }
+      {
+        Profiler::Scope scope(&profiler_, "adjust steering");
+        adjustSteering();
+      }
+
+      // Flush this cycle's batched actuator commands back to back,
+      // brake first: it is the most safety-critical request, and
+      // nothing else should ever delay it.
+      brake_->flush();
+      throttle_->flush();
+      steering_->flush();
+
+      // flight recorder: the command tracked and the state achieved
+      ART_RECORD4("pilot cycle",
+                  pstate_msg_.target.speed, pstate_msg_.current.speed,
+                  pstate_msg_.target.steering_angle,
+                  pstate_msg_.current.steering_angle);
+
+      // learning-data capture: one sample per cycle, just an enqueue
+      if (capture_.enabled())
+        {
+          LearningCapture::Sample sample;
+          sample.stamp = current_time_.toSec();
+          sample.speed = pstate_msg_.current.speed;
+          sample.target_speed = pstate_msg_.target.speed;
+          sample.accel = pstate_msg_.current.acceleration;
+          sample.brake_position = brake_->value();
+          sample.throttle_position = throttle_->value();
+          sample.steering_angle = pstate_msg_.current.steering_angle;
+          sample.preempted = (pstate_msg_.preempted? 1.0: 0.0);
+          capture_.enqueue(sample);
+        }
 
       pilot_state_.publish(pstate_msg_); // publish updated state message
 
+      // report latency from the goal command being tracked to the
+      // actuator command flush above
+      if (goal_time_ != ros::Time())
+        {
+          art_msgs::PipelineEvent event;
+          event.header.stamp = ros::Time::now();
+          event.origin = goal_time_;
+          event.node = "pilot";
+          event.topic = "pilot/drive";
+          trace_pub_.publish(event);
+        }
+
+      if (deadline_.end())              // end of control cycle
+        ROS_WARN_THROTTLE(10, "pilot cycle overran its deadline"
+                          " (%lu misses in %lu cycles)",
+                          deadline_.misses(), deadline_.cycles());
+
+      // publish section timing diagnostics about once a second
+      if (++cycle_count >= (uint32_t) art_msgs::ArtHertz::PILOT)
+        {
+          cycle_count = 0;
+          diagnostic_msgs::DiagnosticArray diag_msg;
+          diag_msg.header.stamp = ros::Time::now();
+          profiler_.to_message(diag_msg, "pilot");
+
+          // append deadline statistics, so cycle overruns are visible
+          // to off-board tools and not just in the log
+          diagnostic_msgs::DiagnosticStatus cycle_status;
+          cycle_status.name = "pilot: cycle";
+          cycle_status.hardware_id = "none";
+          cycle_status.level = diagnostic_msgs::DiagnosticStatus::OK;
+          cycle_status.message = "cycle deadline";
+          char buf[32];
+          diagnostic_msgs::KeyValue kv;
+          kv.key = "cycles";
+          snprintf(buf, sizeof(buf), "%lu", deadline_.cycles());
+          kv.value = buf;
+          cycle_status.values.push_back(kv);
+          kv.key = "misses";
+          snprintf(buf, sizeof(buf), "%lu", deadline_.misses());
+          kv.value = buf;
+          cycle_status.values.push_back(kv);
+          kv.key = "max (ms)";
+          snprintf(buf, sizeof(buf), "%.3f", deadline_.max_duration()*1e3);
+          kv.value = buf;
+          cycle_status.values.push_back(kv);
+          kv.key = "mean jitter (ms)";
+          snprintf(buf, sizeof(buf), "%.3f", deadline_.mean_jitter()*1e3);
+          kv.value = buf;
+          cycle_status.values.push_back(kv);
+          diag_msg.status.push_back(cycle_status);
+
+          diag_pub_.publish(diag_msg);
+        }
+
       cycle.sleep();                    // sleep until next cycle
     }
+
+  message_thread.stop();
+  capture_.stop();                      // drain any captured samples
+
+  // dump accumulated timing and deadline statistics on the way out
+  profiler_.log_summary();
+  deadline_.log_summary("pilot");
 }
 
 
@@ -215,18 +459,97 @@ void PilotNode::adjustSteering(void)
   if (config_.human_steering)           // pilot not steering?
     return;
 
-  if (fabs(pstate_msg_.target.steering_angle
+  // Steering angle to request, in degrees.
+  float steer_degrees = angles::to_degrees(pstate_msg_.target.steering_angle);
+
+  // The navigator computed that angle for its target speed, but the
+  // wheels only reach it about one cycle from now.  While the vehicle
+  // is accelerating or braking, preserve the intended yaw rate by
+  // recomputing the angle for the speed predicted at actuation time.
+  // Below the minimum speed for the bicycle model the angle passes
+  // through unchanged.
+  float est_speed = PosePredict::predict_speed(pstate_msg_.current.speed,
+                                               imu_->value(),
+                                               1.0/art_msgs::ArtHertz::PILOT);
+  if (pstate_msg_.target.speed >= Steering::steer_speed_min
+      && est_speed >= Steering::steer_speed_min)
+    {
+      double target_yaw = Steering::angle_to_yaw(pstate_msg_.target.speed,
+                                                 steer_degrees);
+      steer_degrees = Steering::steering_angle(est_speed, target_yaw);
+    }
+
+  if (fabs(angles::from_degrees(steer_degrees)
            - pstate_msg_.current.steering_angle)
       > Epsilon::steering_angle)
     {
-      // Set the steering angle in degrees.
-      float steer_degrees =
-        angles::to_degrees(pstate_msg_.target.steering_angle);
       ROS_DEBUG("requesting steering angle = %.1f (degrees)", steer_degrees);
-      steering_->publish(steer_degrees, current_time_);
+      ART_RECORD1("pilot steer request", steer_degrees);
+      steering_->queue(steer_degrees, current_time_);
     }
 }
 
+/** Apply data deposited by the message thread.
+ *
+ *  The critical section only copies a command and swaps a couple of
+ *  shared pointers, so the control thread never waits behind message
+ *  processing, no matter how many commands arrived.  A configuration
+ *  snapshot is applied after the lock is released: retuning work
+ *  never extends the critical section.
+ */
+void PilotNode::applyIncoming(void)
+{
+  bool new_target = false;
+  boost::shared_ptr<config_snapshot_t> snapshot;
+  {
+    boost::mutex::scoped_lock lock(msg_mutex_);
+
+    snapshot.swap(incoming_.snapshot);
+
+    if (incoming_.have_target)
+      {
+        goal_time_ = incoming_.goal_time;
+        pstate_msg_.target = incoming_.target;
+        incoming_.have_target = false;
+        new_target = true;
+      }
+
+    if (incoming_.have_preempt)
+      {
+        pstate_msg_.preempted = incoming_.preempted;
+        incoming_.have_preempt = false;
+        ROS_INFO_STREAM("Pilot is "
+                        << (pstate_msg_.preempted? "preempted": "active"));
+      }
+  }
+
+  if (snapshot)
+    {
+      // apply the configuration snapshot, on this thread only
+      if (snapshot->accel)
+        {
+          // newly allocated acceleration controller
+          accel_ = snapshot->accel;
+        }
+      else
+        {
+          // pass new parameters to existing controller
+          accel_->reconfigure(snapshot->config);
+        }
+      config_ = snapshot->config;
+      timeout_ = ros::Duration(config_.timeout);
+      envelope_.update(config_);
+
+      // report the new limit envelope (latched, reconfigure rate)
+      art_msgs::PilotLimits limits = envelope_.limits();
+      limits.header.stamp = ros::Time::now();
+      limits_pub_.publish(limits);
+    }
+
+  if (new_target)
+    validateTarget();
+}
+
 /** halt -- soft version of hardware E-Stop.
  *  
  *   The goal is to bring the vehicle to a halt as quickly as possible,
@@ -251,7 +574,7 @@ void PilotNode::halt(void)
       // Already stopped.  Ease up on the brake to reduce strain on
       // the actuator.  Brake hold position *must* be adequate to
       // prevent motion, even on a hill.
-      brake_->publish(config_.brake_hold, current_time_);
+      brake_->queue(config_.brake_hold, current_time_);
     }
   else
     {
@@ -261,8 +584,8 @@ void PilotNode::halt(void)
       //  an exception to the general rule of never applying brake and
       //  throttle together.  There seems to be enough inertia in the
       //  brake mechanism for this to be safe.
-      throttle_->publish(0.0, current_time_);
-      brake_->publish(1.0, current_time_);
+      throttle_->queue(0.0, current_time_);
+      brake_->queue(1.0, current_time_);
     }
   accel_->reset();
 }
@@ -301,68 +624,138 @@ void PilotNode::monitorHardware(void)
 
   /// @todo Optionally check if no commands received recently.
 
+  // Collect critical device failures in a bitmask.  The control
+  // decision below branches only on the mask; the monitor timer
+  // reports details from the message thread.
+  uint32_t failures = 0;
+  if (pstate_msg_.brake.state != DriverState::RUNNING)
+    failures |= FAIL_BRAKE;
+  if (pstate_msg_.imu.state != DriverState::RUNNING)
+    failures |= FAIL_IMU;
+  if (pstate_msg_.odom.state != DriverState::RUNNING)
+    failures |= FAIL_ODOM;
+  if (!config_.human_steering
+      && pstate_msg_.steering.state != DriverState::RUNNING)
+    failures |= FAIL_STEERING;
+  if (pstate_msg_.throttle.state != DriverState::RUNNING)
+    failures |= FAIL_THROTTLE;
+  device_failures_ = failures;          // single word-sized store
+
   pstate_msg_.pilot.state = DriverState::RUNNING;
-  if (pstate_msg_.brake.state != DriverState::RUNNING
-      || pstate_msg_.imu.state != DriverState::RUNNING
-      || pstate_msg_.odom.state != DriverState::RUNNING
-      || (!config_.human_steering
-          && pstate_msg_.steering.state != DriverState::RUNNING)
-      || pstate_msg_.throttle.state != DriverState::RUNNING)
+  if (failures != 0)
     {
       // pilot is not running
       pstate_msg_.pilot.state = DriverState::OPENED;
-      ROS_WARN_THROTTLE(40, "critical component failure, pilot not running");
       // reset latest target request
       pstate_msg_.target = art_msgs::CarDrive();
     }
+  else if (!bringup_announced_)
+    {
+      // every critical device is running for the first time
+      bringup_announced_ = true;
+      announceBringup(DriverState::RUNNING, "all devices running");
+    }
+}
+
+/** Report this node's bringup readiness.
+ *
+ *  Published latched, so launch tooling subscribing late still sees
+ *  the current state.
+ *
+ *  @param state DriverState value: OPENED while devices come up,
+ *               RUNNING once all critical devices report in
+ *  @param detail short progress note for the operator
+ */
+void PilotNode::announceBringup(uint8_t state, const char *detail)
+{
+  art_msgs::BringupState msg;
+  msg.header.stamp = ros::Time::now();
+  msg.node = ros::this_node::getName();
+  msg.state.state = state;
+  msg.detail = detail;
+  bringup_state_.publish(msg);
+}
+
+/** report device failures (runs in the message thread)
+ *
+ *  Low-rate monitor timer callback.  Reads the health bitmask
+ *  maintained by monitorHardware() and formats the diagnostic
+ *  message here, outside the control cycle.
+ */
+void PilotNode::reportFailures(const ros::TimerEvent &event)
+{
+  uint32_t failures = device_failures_;
+  if (failures == 0)
+    return;
+
+  std::string failed;
+  if (failures & FAIL_BRAKE)
+    failed += " brake";
+  if (failures & FAIL_IMU)
+    failed += " imu";
+  if (failures & FAIL_ODOM)
+    failed += " odom";
+  if (failures & FAIL_STEERING)
+    failed += " steering";
+  if (failures & FAIL_THROTTLE)
+    failed += " throttle";
+
+  ROS_WARN_THROTTLE(40, "critical component failure, pilot not running:%s",
+                    failed.c_str());
 }
 
-/** CarDriveStamped message callback */
+/** CarDriveStamped message callback (runs in the message thread) */
 void PilotNode::processCarDrive(const art_msgs::CarDriveStamped::ConstPtr &msg)
 {
-  goal_time_ = msg->header.stamp;
-  pstate_msg_.target = msg->control;
-  validateTarget();
+  boost::mutex::scoped_lock lock(msg_mutex_);
+  incoming_.goal_time = msg->header.stamp;
+  incoming_.target = msg->control;
+  incoming_.have_target = true;
 }
 
-/** CarCommand message callback (now DEPRECATED) */
+/** CarCommand message callback (now DEPRECATED, runs in the message
+ *  thread) */
 void PilotNode::processCarCommand(const art_msgs::CarCommand::ConstPtr &msg)
 {
   ROS_WARN_THROTTLE(100, "CarCommand deprecated: use CarDriveStamped.");
 
-  goal_time_ = msg->header.stamp;
-  pstate_msg_.target.steering_angle = angles::from_degrees(msg->control.angle);
-  pstate_msg_.target.behavior.value = art_msgs::PilotBehavior::Run;
+  art_msgs::CarDrive target;
+  target.steering_angle = angles::from_degrees(msg->control.angle);
+  target.behavior.value = art_msgs::PilotBehavior::Run;
 
-  pstate_msg_.target.jerk = 0.0;
-  pstate_msg_.target.acceleration = 0.0;
-  pstate_msg_.target.speed = msg->control.velocity;
-  if (pstate_msg_.target.speed > 0.0)
+  target.jerk = 0.0;
+  target.acceleration = 0.0;
+  target.speed = msg->control.velocity;
+  if (target.speed > 0.0)
     {
-      pstate_msg_.target.gear.value = art_msgs::Gear::Drive;
+      target.gear.value = art_msgs::Gear::Drive;
     }
-  else if (pstate_msg_.target.speed < 0.0)
+  else if (target.speed < 0.0)
     {
       // in reverse: make speed positive
-      pstate_msg_.target.speed = -msg->control.velocity;
-      pstate_msg_.target.gear.value = art_msgs::Gear::Reverse;
+      target.speed = -msg->control.velocity;
+      target.gear.value = art_msgs::Gear::Reverse;
     }
   else
     {
-      pstate_msg_.target.gear.value = art_msgs::Gear::Naught;
+      target.gear.value = art_msgs::Gear::Naught;
     }
 
-  validateTarget();
+  boost::mutex::scoped_lock lock(msg_mutex_);
+  incoming_.goal_time = msg->header.stamp;
+  incoming_.target = target;
+  incoming_.have_target = true;
 }
 
-/** LearningCommand message callback (DEPRECATED) */
+/** LearningCommand message callback (DEPRECATED, runs in the message
+ *  thread) */
 void PilotNode::processLearning(const art_msgs::LearningCommand::ConstPtr
                                 &learningIn)
 {
   ROS_WARN_THROTTLE(100, "LearningCommand deprecated: use CarDriveStamped.");
-  pstate_msg_.preempted = (learningIn->pilotActive == 0);
-  ROS_INFO_STREAM("Pilot is "
-                  << (pstate_msg_.preempted? "preempted": "active"));
+  boost::mutex::scoped_lock lock(msg_mutex_);
+  incoming_.preempted = (learningIn->pilotActive == 0);
+  incoming_.have_preempt = true;
 }
 
 /** handle dynamic reconfigure service request
@@ -371,26 +764,27 @@ void PilotNode::processLearning(const art_msgs::LearningCommand::ConstPtr
  *        becomes the service reply message as updated here.
  * @param level SensorLevels value (0xffffffff on initial call)
  *
- * This is done without any locking because it is called in the same
- * thread as ros::spinOnce() and all the topic subscription callbacks.
+ * This runs in the message thread.  The complete snapshot, including
+ * any new acceleration controller, is assembled here before taking
+ * the lock, then published with one shared pointer swap.  The control
+ * thread picks it up at its next cycle boundary in applyIncoming(),
+ * so retuning during motion never blocks or jitters a control cycle.
  */
 void PilotNode::reconfig(Config &newconfig, uint32_t level)
 {
   ROS_INFO("pilot dynamic reconfigure, level 0x%08x", level);
 
+  boost::shared_ptr<config_snapshot_t> snapshot(new config_snapshot_t);
+  snapshot->config = newconfig;
   if (level & driver_base::SensorLevels::RECONFIGURE_CLOSE)
     {
       // reallocate acceleration controller using new configuration
-      accel_ = pilot::allocAccel(newconfig);
-    }
-  else
-    {
-      // pass any other parameters to existing acceleration controller
-      accel_->reconfigure(newconfig);
+      snapshot->accel = pilot::allocAccel(newconfig);
     }
 
-  config_ = newconfig;
-  timeout_ = ros::Duration(config_.timeout);
+  // an unapplied older snapshot is superseded by this one
+  boost::mutex::scoped_lock lock(msg_mutex_);
+  incoming_.snapshot = snapshot;
 }
 
 
@@ -488,37 +882,16 @@ void PilotNode::validateTarget(void)
       pstate_msg_.target.jerk = fabs(pstate_msg_.target.jerk);
     }
 
-  if (pstate_msg_.target.gear.value == art_msgs::Gear::Reverse)
+  // clamp speed and steering angle to the precomputed limit envelope
+  float requested_speed = pstate_msg_.target.speed;
+  if (envelope_.clamp(pstate_msg_.target))
     {
-      if (pstate_msg_.target.speed > config_.limit_reverse)
-        {
-          ROS_WARN_STREAM_THROTTLE(100, "Requested speed ("
-                                   << pstate_msg_.target.speed
-                                   << ") exceeds reverse limit of "
-                                   << config_.limit_reverse
-                                   << " m/s");
-          pstate_msg_.target.speed = config_.limit_reverse;
-        }
+      ROS_WARN_STREAM_THROTTLE(100, "Requested speed ("
+                               << requested_speed
+                               << ") exceeds limit of "
+                               << pstate_msg_.target.speed
+                               << " m/s");
     }
-  else
-    {
-      if (pstate_msg_.target.speed > config_.limit_forward)
-        {
-          ROS_WARN_STREAM_THROTTLE(100, "Requested speed ("
-                                   << pstate_msg_.target.speed
-                                   << ") exceeds limit of "
-                                   << config_.limit_forward
-                                   << " m/s");
-          pstate_msg_.target.speed = config_.limit_forward;
-        }
-    }
-
-  // limit steering angle to permitted range
-  using namespace pilot;
-  using namespace art_msgs;
-  pstate_msg_.target.steering_angle = clamp(-ArtVehicle::max_steer_radians,
-                                            pstate_msg_.target.steering_angle,
-                                            ArtVehicle::max_steer_radians);
 }
 
 /** main entry point */
@@ -532,3 +905,47 @@ int main(int argc, char** argv)
 
   return 0;
 }
+
+/** Nodelet version of the pilot node.
+ *
+ *  Running in the same nodelet manager as the navigator delivers
+ *  driving commands by shared pointer, without serialization.  The
+ *  standalone pilot executable remains available for distributed
+ *  deployments.
+ *
+ *  Note: private parameters and dynamic reconfigure resolve in the
+ *  manager's namespace, so launch the manager with them set there.
+ */
+class PilotNodelet: public nodelet::Nodelet
+{
+public:
+  PilotNodelet() {}
+  ~PilotNodelet()
+    {
+      if (thread_)
+        thread_->join();                // wait for control thread
+    }
+
+private:
+  virtual void onInit(void)
+    {
+      // run the control cycle in a separate thread: onInit() must
+      // not block
+      thread_.reset(new boost::thread(boost::bind(&PilotNodelet::run, this)));
+    }
+
+  /** control thread: runs until ROS shutdown */
+  void run(void)
+    {
+      ros::NodeHandle node = getNodeHandle();
+      pilot_.reset(new PilotNode(node));
+      pilot_->spin(true);               // manager services our callbacks
+    }
+
+  boost::shared_ptr<PilotNode> pilot_;  ///< the wrapped node
+  boost::shared_ptr<boost::thread> thread_; ///< control thread
+};
+
+// Register this plugin with pluginlib.
+PLUGINLIB_DECLARE_CLASS(art_pilot, PilotNodelet,
+                        PilotNodelet, nodelet::Nodelet);
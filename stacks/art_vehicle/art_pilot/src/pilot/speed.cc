@@ -60,45 +60,130 @@ namespace ControlMatrix
       /*  32 */ {{-1000,6},  {-30,30}, {-30,30}, {-30,40}, {-30,50}, {-30,70}}
     };
 
-  // If it turns out that the matrix indices should be different, adjust
-  // the conversions in these functions.  The logarithmic intervals are
-  // based on intuition.
-  static inline int
-  delta_row(float mph)
+  // Dense interpolation LUT compiled from accel_matrix.
+  //
+  // The sparse matrix used to be looked up stepwise through two scan
+  // loops per cycle, with the result jumping discontinuously at
+  // every logarithmic bin edge.  The LUT resamples the matrix once
+  // on a uniform half-MPH grid, so a cycle costs one bilinear
+  // interpolation over contiguous memory and the response is
+  // continuous in both speed and speed delta.  All the logarithmic
+  // breakpoints fall on grid nodes, so the LUT passes exactly
+  // through every matrix entry.
+
+  static const int LUT_DELTA_MAX = 32;	// +/- delta range (MPH)
+  static const int LUT_SPEED_MAX = 64;	// speed range (MPH)
+  static const int LUT_PER_MPH = 2;	// grid spacing: 0.5 MPH
+  static const int N_LUT_ROWS = 2*LUT_DELTA_MAX*LUT_PER_MPH + 1;
+  static const int N_LUT_COLS = LUT_SPEED_MAX*LUT_PER_MPH + 1;
+
+  static accel_parms_t accel_lut[N_LUT_ROWS][N_LUT_COLS];
+  static bool lut_built = false;
+
+  // Sample coordinates of the sparse matrix, matching the upper
+  // edges of the old lookup bins.  The first matrix column is a
+  // special standstill case (brake_delta up to 1000 holds the
+  // vehicle stopped), so it is pinned below 0.5 MPH instead of
+  // blending across the whole 0..4 MPH range.
+  static const float delta_sample_mph[N_DELTAS] =
+    {-32, -16, -8, -4, -2, -1, 0, 1, 2, 4, 8, 16, 32};
+  static const int N_SPEED_SAMPLES = N_SPEEDS + 1;
+  static const float speed_sample_mph[N_SPEED_SAMPLES] =
+    {0.0, 0.5, 4.0, 8.0, 16.0, 32.0, 64.0};
+  static const int speed_sample_col[N_SPEED_SAMPLES] =
+    {0, 1, 1, 2, 3, 4, 5};
+
+  /** interpolation weight of x between samples, clamped to [0, 1] */
+  static inline float
+  sample_weight(float x, float s0, float s1)
   {
-    int row;
-    static float row_limits[DELTA_0+1] = {0.0, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0};
-    int mph_sign = 1;
-
-    if (mph < 0)
-      mph_sign = -1;
-
-    float abs_mph = mph * mph_sign;
-
-    for (row = 0; row < DELTA_0+1; ++row)
-      {
-        if (abs_mph <= row_limits[row])
-          return DELTA_0 + mph_sign * row;
-      }
-
-    // if delta outside the table, use the first or last entry
-    return DELTA_0 + mph_sign * DELTA_0;
+    if (x <= s0)
+      return 0.0;
+    if (x >= s1)
+      return 1.0;
+    return (x - s0) / (s1 - s0);
   }
 
-  static inline int
-  speed_col(float mph)
+  /** piecewise-bilinear sample of the sparse matrix */
+  static accel_parms_t
+  sample_matrix(float delta_mph, float speed_mph)
   {
-    int col;
-    static float col_limits[N_SPEEDS] = {0.0, 4.0, 8.0, 16.0, 32.0, 64.0};
+    int r1 = 1;
+    while (r1 < N_DELTAS-1 && delta_sample_mph[r1] < delta_mph)
+      ++r1;
+    int r0 = r1 - 1;
+    float rw = sample_weight(delta_mph,
+                             delta_sample_mph[r0], delta_sample_mph[r1]);
+
+    int s1 = 1;
+    while (s1 < N_SPEED_SAMPLES-1 && speed_sample_mph[s1] < speed_mph)
+      ++s1;
+    int s0 = s1 - 1;
+    float cw = sample_weight(speed_mph,
+                             speed_sample_mph[s0], speed_sample_mph[s1]);
+    int c0 = speed_sample_col[s0];
+    int c1 = speed_sample_col[s1];
+
+    accel_parms_t out;
+    out.brake_delta =
+      (1-rw) * ((1-cw) * accel_matrix[r0][c0].brake_delta
+                + cw * accel_matrix[r0][c1].brake_delta)
+      + rw * ((1-cw) * accel_matrix[r1][c0].brake_delta
+              + cw * accel_matrix[r1][c1].brake_delta);
+    out.throttle_delta =
+      (1-rw) * ((1-cw) * accel_matrix[r0][c0].throttle_delta
+                + cw * accel_matrix[r0][c1].throttle_delta)
+      + rw * ((1-cw) * accel_matrix[r1][c0].throttle_delta
+              + cw * accel_matrix[r1][c1].throttle_delta);
+    return out;
+  }
 
-    for (col = 0; col < N_SPEEDS; ++col)
+  /** compile the dense LUT from the sparse matrix */
+  static void
+  build_lut(void)
+  {
+    for (int r = 0; r < N_LUT_ROWS; ++r)
       {
-        if (mph <= col_limits[col])
-          return col;
+        float delta_mph = (float) (r - N_LUT_ROWS/2) / LUT_PER_MPH;
+        for (int c = 0; c < N_LUT_COLS; ++c)
+          accel_lut[r][c] = sample_matrix(delta_mph, (float) c / LUT_PER_MPH);
       }
+    lut_built = true;
+  }
 
-    // if speed beyond the table, use the last entry
-    return N_SPEEDS-1;
+  /** one bilinear interpolation over the dense LUT */
+  static inline accel_parms_t
+  lut_lookup(float delta_mph, float speed_mph)
+  {
+    float rf = (delta_mph + LUT_DELTA_MAX) * LUT_PER_MPH;
+    float cf = speed_mph * LUT_PER_MPH;
+
+    // clamp to the grid, as the old lookup clamped to the table
+    if (rf < 0.0) rf = 0.0;
+    if (rf > N_LUT_ROWS-1) rf = N_LUT_ROWS-1;
+    if (cf < 0.0) cf = 0.0;
+    if (cf > N_LUT_COLS-1) cf = N_LUT_COLS-1;
+
+    int r0 = (int) rf;
+    int c0 = (int) cf;
+    int r1 = (r0 < N_LUT_ROWS-1)? r0+1: r0;
+    int c1 = (c0 < N_LUT_COLS-1)? c0+1: c0;
+    float rw = rf - r0;
+    float cw = cf - c0;
+
+    const accel_parms_t *row0 = accel_lut[r0];
+    const accel_parms_t *row1 = accel_lut[r1];
+
+    accel_parms_t out;
+    out.brake_delta =
+      (1-rw) * ((1-cw) * row0[c0].brake_delta + cw * row0[c1].brake_delta)
+      + rw * ((1-cw) * row1[c0].brake_delta + cw * row1[c1].brake_delta);
+    out.throttle_delta =
+      (1-rw) * ((1-cw) * row0[c0].throttle_delta
+                + cw * row0[c1].throttle_delta)
+      + rw * ((1-cw) * row1[c0].throttle_delta
+              + cw * row1[c1].throttle_delta);
+    return out;
   }
 };
 
@@ -113,6 +198,8 @@ SpeedControlMatrix::SpeedControlMatrix():
   // Default PD parameters: make Kd proportional to cycle rate, higher
   // frequencies will yield lower deltaV per cycle.
   //
+  if (!ControlMatrix::lut_built)
+    ControlMatrix::build_lut();
   reset();
 }
 
@@ -139,19 +226,17 @@ void SpeedControlMatrix::adjust(float speed, float error,
 
   float delta = velpid_->Update(error, speed);
   float delta_mph = mps2mph(delta);
+  float speed_mph = mps2mph(speed);
 
-  // index into the acceleration matrix
-  int row = delta_row(delta_mph);
-  int col = speed_col(mps2mph(speed));
+  // single bilinear interpolation over the dense LUT
+  accel_parms_t parms = lut_lookup(delta_mph, speed_mph);
   float brake_delta =
-    (accel_matrix[row][col].brake_delta / art_msgs::ArtHertz::PILOT)
-    / 100.0;
+    (parms.brake_delta / art_msgs::ArtHertz::PILOT) / 100.0;
   float throttle_delta =
-    (accel_matrix[row][col].throttle_delta / art_msgs::ArtHertz::PILOT)
-    / 100.0;
+    (parms.throttle_delta / art_msgs::ArtHertz::PILOT) / 100.0;
 
-  ROS_DEBUG("accel_matrix[%d][%d] contains {%.3f, %.3f}",
-            row, col, brake_delta, throttle_delta);
+  ROS_DEBUG("accel_lut(%.1f mph, %.1f mph) yields {%.3f, %.3f}",
+            delta_mph, speed_mph, brake_delta, throttle_delta);
 
   // Do not add braking unless nearly idle throttle was previously
   // requested, or throttle unless the brake is nearly off.
@@ -167,6 +252,7 @@ void SpeedControlMatrix::adjust(float speed, float error,
 void SpeedControlMatrix::configure(art_pilot::PilotConfig &newconfig)
 {
   velpid_->Configure(node_);
+  ControlMatrix::build_lut();
 }
 
 /** Reset speed controller. */
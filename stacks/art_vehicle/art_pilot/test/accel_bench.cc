@@ -0,0 +1,252 @@
+/*
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Offline benchmark for the pilot acceleration controllers.
+
+     Replays a recorded drive trace through each acceleration
+     controller without any devices attached, measuring the per-cycle
+     adjust() latency distribution and the speed tracking error
+     against a simple vehicle model.  Run it before and after changing
+     a controller to quantify the difference without going near the
+     vehicle.
+
+     @section Synopsis
+
+     accel_bench [trace]
+
+     The trace is a text file, one sample per line:
+
+        time target_speed target_acceleration
+
+     with time in seconds and speeds in meters/second, as extracted
+     from recorded CarDriveStamped logs.  Lines starting with '#' are
+     ignored.  With no trace argument, a built-in speed-step profile
+     is used, so the benchmark also runs without log data.
+
+     @author Jack O'Quin
+
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <art_msgs/ArtHertz.h>
+#include <art_msgs/PilotState.h>
+
+#include "../src/pilot/accel.h"
+
+typedef art_pilot::PilotConfig Config;
+
+namespace
+{
+
+/** one trace sample */
+typedef struct
+{
+  double time;                          // seconds from start of trace
+  float target_speed;                   // commanded speed (m/s)
+  float target_accel;                   // commanded acceleration (m/s^2)
+} sample_t;
+
+/** Servo device stub: remembers the last position published, reports
+ *  it as the current device value, and always claims to be running.
+ */
+class StubServo: public device_interface::ServoDeviceBase
+{
+ public:
+
+  StubServo(ros::NodeHandle node):
+    ServoDeviceBase(node),
+    position_(0.0)
+  {}
+
+  virtual float last_request() {return position_;}
+  virtual float value() {return position_;}
+
+  virtual void publish(float new_position, ros::Time cycle_time)
+  {
+    position_ = new_position;
+  }
+
+  virtual DeviceState state(ros::Time recently)
+  {
+    return art_msgs::DriverState::RUNNING;
+  }
+
+ private:
+
+  float position_;                      // current == last requested
+};
+
+/** read a trace file, return true if any samples loaded */
+bool read_trace(const char *path, std::vector<sample_t> &trace)
+{
+  std::ifstream in(path);
+  if (!in)
+    {
+      ROS_ERROR("unable to open trace file %s", path);
+      return false;
+    }
+
+  std::string line;
+  while (std::getline(in, line))
+    {
+      if (line.empty() || line[0] == '#')
+        continue;
+      std::istringstream fields(line);
+      sample_t sample;
+      if (fields >> sample.time >> sample.target_speed
+          >> sample.target_accel)
+        trace.push_back(sample);
+    }
+
+  return !trace.empty();
+}
+
+/** generate a built-in speed-step profile at the pilot cycle rate */
+void synthetic_trace(std::vector<sample_t> &trace)
+{
+  float dt = 1.0 / art_msgs::ArtHertz::PILOT;
+  static const struct {float duration; float speed; float accel;} steps[] =
+    {
+      {10.0,  3.0, 1.0},                // pull away gently
+      {20.0,  9.0, 2.0},                // speed up
+      {10.0,  4.0, 2.0},                // slow for a turn
+      {10.0,  9.0, 0.0},                // no acceleration limit
+      {10.0,  0.0, 3.0},                // controlled stop
+    };
+
+  double t = 0.0;
+  for (unsigned i = 0; i < sizeof(steps)/sizeof(steps[0]); ++i)
+    {
+      for (float elapsed = 0.0; elapsed < steps[i].duration; elapsed += dt)
+        {
+          sample_t sample;
+          sample.time = t;
+          sample.target_speed = steps[i].speed;
+          sample.target_accel = steps[i].accel;
+          trace.push_back(sample);
+          t += dt;
+        }
+    }
+}
+
+/** replay the trace through one controller, report its numbers
+ *
+ *  The vehicle model is deliberately crude: full throttle accelerates
+ *  at 4 m/s^2, full brake decelerates at 8 m/s^2, rolling drag takes
+ *  0.3 m/s^2.  It only has to be the same for every controller so
+ *  their tracking errors are comparable run to run.
+ */
+void benchmark(int controller_id, const std::vector<sample_t> &trace,
+               ros::NodeHandle node)
+{
+  Config config = Config::__getDefault__();
+  config.acceleration_controller = controller_id;
+  pilot::AccelBasePtr accel = pilot::allocAccel(config);
+
+  boost::shared_ptr<StubServo> brake(new StubServo(node));
+  boost::shared_ptr<StubServo> throttle(new StubServo(node));
+
+  art_msgs::PilotState pstate;
+  float speed = 0.0;                    // modeled vehicle speed
+  double error_sum2 = 0.0;              // sum of squared tracking error
+
+  std::vector<double> latencies;
+  latencies.reserve(trace.size());
+
+  ros::Time start(1.0);                 // arbitrary nonzero epoch
+  accel->reset();
+
+  for (unsigned i = 0; i < trace.size(); ++i)
+    {
+      float dt = 1.0 / art_msgs::ArtHertz::PILOT;
+      if (i > 0)
+        dt = trace[i].time - trace[i-1].time;
+
+      pstate.header.stamp = start + ros::Duration(trace[i].time);
+      pstate.current.speed = speed;
+      pstate.current.acceleration = 0.0;
+      pstate.target.speed = trace[i].target_speed;
+      pstate.target.acceleration = trace[i].target_accel;
+
+      ros::WallTime before = ros::WallTime::now();
+      accel->adjust(pstate, brake, throttle);
+      latencies.push_back((ros::WallTime::now() - before).toSec());
+
+      // flush batched servo commands, as the pilot cycle would
+      brake->flush();
+      throttle->flush();
+
+      // advance the vehicle model
+      speed += (throttle->value() * 4.0 - brake->value() * 8.0 - 0.3) * dt;
+      if (speed < 0.0)
+        speed = 0.0;
+
+      float error = trace[i].target_speed - speed;
+      error_sum2 += error * error;
+    }
+
+  // latency distribution
+  std::sort(latencies.begin(), latencies.end());
+  double mean = 0.0;
+  for (unsigned i = 0; i < latencies.size(); ++i)
+    mean += latencies[i];
+  mean /= latencies.size();
+  double p99 = latencies[(latencies.size() * 99) / 100];
+  double worst = latencies[latencies.size() - 1];
+
+  printf("controller %d: %u cycles, "
+         "latency mean %.1f us, p99 %.1f us, max %.1f us, "
+         "tracking RMS error %.3f m/s\n",
+         controller_id, (unsigned) trace.size(),
+         mean * 1.0e6, p99 * 1.0e6, worst * 1.0e6,
+         sqrt(error_sum2 / trace.size()));
+}
+
+}; // anonymous namespace
+
+/** main entry point */
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "accel_bench");
+  ros::NodeHandle node;
+
+  std::vector<sample_t> trace;
+  if (argc > 1)
+    {
+      if (!read_trace(argv[1], trace))
+        return 1;
+      ROS_INFO("replaying %u samples from %s",
+               (unsigned) trace.size(), argv[1]);
+    }
+  else
+    {
+      synthetic_trace(trace);
+      ROS_INFO("no trace file given, using built-in profile (%u samples)",
+               (unsigned) trace.size());
+    }
+
+  // replay the same trace through every acceleration controller
+  benchmark(art_pilot::Pilot_Accel_Plan, trace, node);
+  benchmark(art_pilot::Pilot_Accel_Example, trace, node);
+  benchmark(art_pilot::Pilot_Speed_PID, trace, node);
+  benchmark(art_pilot::Pilot_Speed_Matrix, trace, node);
+  benchmark(art_pilot::Pilot_Speed_Learned, trace, node);
+
+  return 0;
+}
@@ -0,0 +1,201 @@
+#!/usr/bin/python
+#
+#  run simulated missions in parallel, aggregate their metrics
+#
+#   Copyright (C) 2011 Austin Robot Technology
+#   License: Modified BSD Software License Agreement
+#
+# $Id$
+#
+# Usage: batch_runner.py [options] scenario_file
+#
+# The scenario file names one world per line, optionally followed by a
+# simulation speedup ("#" starts a comment):
+#
+#   prc_large
+#   prc_large 4.0
+#   pickle 8.0
+#
+# Each scenario is launched headless via batch_mission.launch with its
+# own ROS master, so several run concurrently across cores.  When a
+# mission finishes (or times out) its metrics file is collected, and a
+# combined report is written at the end.  Runs entirely outside ROS:
+# the only requirement is roslaunch on the PATH.
+
+import os
+import signal
+import subprocess
+import sys
+import time
+from optparse import OptionParser
+
+# first ROS master port; each concurrent slot gets its own
+BASE_PORT = 11400
+
+class MissionRun():
+    "one scheduled mission: its scenario, working files and result"
+
+    def __init__(self, name, world, speedup, outdir):
+        self.name = name
+        self.world = world
+        self.speedup = speedup
+        self.rundir = os.path.join(outdir, name)
+        self.metrics_file = os.path.join(self.rundir, 'metrics.yaml')
+        self.metrics = {}
+        self.proc = None
+        self.console = None
+        self.start_time = None
+
+    def start(self, slot, options):
+        "launch this mission on the given concurrency slot"
+        if not os.path.isdir(self.rundir):
+            os.makedirs(self.rundir)
+        port = BASE_PORT + slot
+        env = dict(os.environ)
+        env['WORLD'] = self.world
+        env['SPEEDUP'] = '%g' % self.speedup
+        env['METRICS'] = self.metrics_file
+        env['TIMEOUT'] = '%g' % options.sim_timeout
+        env['ROS_MASTER_URI'] = 'http://localhost:%d' % port
+        # keep each master's logs and state out of the others' way
+        env['ROS_HOME'] = os.path.join(self.rundir, 'ros_home')
+        self.console = open(os.path.join(self.rundir, 'console.log'), 'w')
+        self.proc = subprocess.Popen(['roslaunch', '-p', str(port),
+                                      'art_run', 'batch_mission.launch'],
+                                     stdout=self.console,
+                                     stderr=subprocess.STDOUT,
+                                     env=env)
+        self.start_time = time.time()
+        print('started %s (world %s, speedup %g, port %d)'
+              % (self.name, self.world, self.speedup, port))
+
+    def poll(self, options):
+        "return True when this mission has finished"
+        if self.proc.poll() is None:
+            if time.time() - self.start_time > options.timeout:
+                print('%s exceeded %.0fs wall clock, killing it'
+                      % (self.name, options.timeout))
+                # let roslaunch shut its nodes down cleanly first
+                self.proc.send_signal(signal.SIGINT)
+                try:
+                    for i in range(20):
+                        if self.proc.poll() is not None:
+                            break
+                        time.sleep(1.0)
+                finally:
+                    if self.proc.poll() is None:
+                        self.proc.kill()
+                        self.proc.wait()
+            else:
+                return False
+        self.console.close()
+        self.collect()
+        return True
+
+    def collect(self):
+        "read the metrics file this run wrote, if any"
+        if not os.path.exists(self.metrics_file):
+            self.metrics = {'result': 'no metrics'}
+            return
+        for line in open(self.metrics_file):
+            if ':' in line:
+                key, value = line.split(':', 1)
+                self.metrics[key.strip()] = value.strip()
+
+    def report(self):
+        "format a one-line summary of this run"
+        return ('%-24s %-10s %9s %9s %8s %8s'
+                % (self.name,
+                   self.metrics.get('result', 'unknown'),
+                   self.metrics.get('mission_time', '-'),
+                   self.metrics.get('min_clearance', '-'),
+                   self.metrics.get('pilot_cycle_cycles', '-'),
+                   self.metrics.get('pilot_cycle_misses', '-')))
+
+def read_scenarios(path, options, outdir):
+    "parse the scenario file into a list of MissionRun"
+    runs = []
+    counts = {}
+    for line in open(path):
+        line = line.split('#')[0].strip()
+        if not line:
+            continue
+        fields = line.split()
+        world = fields[0]
+        speedup = options.speedup
+        if len(fields) > 1:
+            speedup = float(fields[1])
+        # distinguish repeated worlds: prc_large.0, prc_large.1, ...
+        seq = counts.get(world, 0)
+        counts[world] = seq + 1
+        runs.append(MissionRun('%s.%d' % (world, seq),
+                               world, speedup, outdir))
+    return runs
+
+def main():
+    parser = OptionParser(usage='usage: %prog [options] scenario_file')
+    parser.add_option('-j', '--jobs', type='int', default=2,
+                      help='missions to run concurrently (default 2)')
+    parser.add_option('-o', '--outdir', default='batch_out',
+                      help='directory for run logs and the report'
+                      ' (default batch_out)')
+    parser.add_option('-s', '--speedup', type='float', default=1.0,
+                      help='default simulation speedup (default 1.0)')
+    parser.add_option('-t', '--timeout', type='float', default=3600.0,
+                      help='wall clock seconds per run (default 3600)')
+    parser.add_option('--sim-timeout', type='float', default=0.0,
+                      help='simulated seconds per mission'
+                      ' (default 0, no limit)')
+    options, args = parser.parse_args()
+    if len(args) != 1:
+        parser.error('exactly one scenario file required')
+
+    pending = read_scenarios(args[0], options, options.outdir)
+    if not pending:
+        parser.error('no scenarios in ' + args[0])
+    finished = []
+    active = {}                         # concurrency slot -> MissionRun
+
+    while pending or active:
+        while pending and len(active) < options.jobs:
+            for slot in range(options.jobs):
+                if slot not in active:
+                    break
+            run = pending.pop(0)
+            run.start(slot, options)
+            active[slot] = run
+        time.sleep(1.0)
+        for slot in list(active.keys()):
+            if active[slot].poll(options):
+                run = active.pop(slot)
+                finished.append(run)
+                print('finished %s: %s'
+                      % (run.name, run.metrics.get('result', 'unknown')))
+
+    header = ('%-24s %-10s %9s %9s %8s %8s'
+              % ('run', 'result', 'time(s)', 'clear(m)',
+                 'cycles', 'misses'))
+    lines = [header]
+    completed = 0
+    for run in finished:
+        lines.append(run.report())
+        if run.metrics.get('result') == 'completed':
+            completed += 1
+    lines.append('%d of %d missions completed'
+                 % (completed, len(finished)))
+
+    report_file = os.path.join(options.outdir, 'report.txt')
+    f = open(report_file, 'w')
+    f.write('\n'.join(lines) + '\n')
+    f.close()
+    print('')
+    for line in lines:
+        print(line)
+    print('report written to ' + report_file)
+    if completed != len(finished):
+        return 1
+    return 0
+
+if __name__ == '__main__':
+    # run main function and exit
+    sys.exit(main())
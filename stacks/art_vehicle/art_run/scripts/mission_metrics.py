@@ -0,0 +1,132 @@
+#!/usr/bin/python
+#
+#  record metrics for one unattended simulated mission
+#
+#   Copyright (C) 2011 Austin Robot Technology
+#   License: Modified BSD Software License Agreement
+#
+# $Id$
+#
+# Watches a running mission and writes a small "key: value" metrics
+# file when it ends.  Launched with required="true" from
+# batch_mission.launch, so its exit also ends the roslaunch session:
+#
+#   mission time:     simulated seconds from E-stop Run to Done
+#   result:           completed, timeout or aborted
+#   min clearance:    closest applicable observation distance seen
+#   cycle overruns:   pilot deadline statistics from diagnostics
+#
+# Parameters:
+#   ~output   metrics file to write (default: log only)
+#   ~timeout  simulated seconds before the run is abandoned
+#             (default 0.0, no limit)
+
+PKG_NAME = 'art_run'
+
+import sys
+
+import roslib;
+roslib.load_manifest(PKG_NAME)
+import rospy
+
+from art_msgs.msg import EstopState
+from art_msgs.msg import NavigatorState
+from art_msgs.msg import ObservationArray
+from diagnostic_msgs.msg import DiagnosticArray
+
+class MissionMetrics():
+    "Metrics recorder for one simulated mission."
+
+    def __init__(self):
+        rospy.init_node('mission_metrics')
+        self.output = rospy.get_param('~output', '')
+        self.timeout = rospy.get_param('~timeout', 0.0)
+        self.start_stamp = None
+        self.mission_time = None
+        self.min_clearance = float('inf')
+        self.pilot_cycle = {}           # latest "pilot: cycle" key/values
+        self.wrote = False
+        rospy.on_shutdown(self.shutdownHook)
+        self.nav_sub = rospy.Subscriber('navigator/state', NavigatorState,
+                                        self.navCallback)
+        self.obs_sub = rospy.Subscriber('observations', ObservationArray,
+                                        self.obsCallback)
+        self.diag_sub = rospy.Subscriber('diagnostics', DiagnosticArray,
+                                         self.diagCallback)
+        self.timer = rospy.Timer(rospy.Duration(1.0), self.checkTimeout)
+
+    def navCallback(self, msg):
+        "track mission start and completion from navigator state"
+        if msg.estop.state == EstopState.Run:
+            if self.start_stamp is None:
+                self.start_stamp = msg.header.stamp
+                rospy.loginfo('mission started')
+        elif msg.estop.state == EstopState.Done:
+            if self.start_stamp is not None and not self.wrote:
+                self.mission_time = (msg.header.stamp
+                                     - self.start_stamp).to_sec()
+                rospy.loginfo('mission completed in %.1f sim seconds'
+                              % self.mission_time)
+                self.finish('completed')
+
+    def obsCallback(self, msg):
+        "track the closest applicable observation distance"
+        for obs in msg.obs:
+            if obs.applicable and 0.0 < obs.distance < self.min_clearance:
+                self.min_clearance = obs.distance
+
+    def diagCallback(self, msg):
+        "keep the latest pilot cycle deadline statistics"
+        for status in msg.status:
+            if status.name == 'pilot: cycle':
+                for kv in status.values:
+                    self.pilot_cycle[kv.key] = kv.value
+
+    def checkTimeout(self, timer_event):
+        "abandon the run when the simulated time limit expires"
+        if self.timeout <= 0.0 or self.start_stamp is None or self.wrote:
+            return
+        elapsed = (rospy.Time.now() - self.start_stamp).to_sec()
+        if elapsed > self.timeout:
+            self.mission_time = elapsed
+            rospy.logerr('mission timed out after %.1f sim seconds'
+                         % elapsed)
+            self.finish('timeout')
+
+    def shutdownHook(self):
+        "write the metrics even when roslaunch kills the session"
+        if not self.wrote:
+            self.writeMetrics('aborted')
+
+    def finish(self, result):
+        "write the metrics and end the run"
+        self.writeMetrics(result)
+        rospy.signal_shutdown('mission ' + result)
+
+    def writeMetrics(self, result):
+        "write accumulated metrics as key: value lines"
+        self.wrote = True
+        lines = ['result: %s' % result]
+        if self.mission_time is not None:
+            lines.append('mission_time: %.1f' % self.mission_time)
+        if self.min_clearance != float('inf'):
+            lines.append('min_clearance: %.2f' % self.min_clearance)
+        for key in ['cycles', 'misses', 'max (ms)']:
+            if key in self.pilot_cycle:
+                lines.append('pilot_cycle_%s: %s'
+                             % (key.split(' ')[0], self.pilot_cycle[key]))
+        for line in lines:
+            rospy.loginfo('metrics -- ' + line)
+        if self.output:
+            f = open(self.output, 'w')
+            f.write('\n'.join(lines) + '\n')
+            f.close()
+
+def main():
+    MissionMetrics()
+    rospy.spin()
+    return 0
+
+if __name__ == '__main__':
+    # run main function and exit
+    sys.exit(main())
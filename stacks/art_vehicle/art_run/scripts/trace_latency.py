@@ -0,0 +1,95 @@
+#!/usr/bin/python
+#
+#  collect pipeline latency trace events, report per-hop histograms
+#
+#   Copyright (C) 2011 Austin Robot Technology
+#   License: Modified BSD Software License Agreement
+#
+# $Id$
+
+PKG_NAME = 'art_run'
+
+import sys
+
+import roslib;
+roslib.load_manifest(PKG_NAME)
+import rospy
+
+from art_msgs.msg import PipelineEvent
+
+# histogram bucket upper bounds (milliseconds); the last bucket
+# catches everything slower
+BUCKETS = [1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0, 200.0, 500.0]
+
+class HopStats():
+    "latency statistics for one pipeline hop"
+
+    def __init__(self, label):
+        self.label = label
+        self.count = 0
+        self.total = 0.0
+        self.worst = 0.0
+        self.buckets = [0] * (len(BUCKETS) + 1)
+
+    def add(self, latency_ms):
+        "record one latency sample (milliseconds)"
+        self.count += 1
+        self.total += latency_ms
+        self.worst = max(self.worst, latency_ms)
+        for i in range(len(BUCKETS)):
+            if latency_ms <= BUCKETS[i]:
+                self.buckets[i] += 1
+                return
+        self.buckets[-1] += 1
+
+    def report(self):
+        "format a one-line summary of this hop"
+        mean = self.total / self.count
+        cells = []
+        for i in range(len(BUCKETS)):
+            cells.append('<=%.0f: %d' % (BUCKETS[i], self.buckets[i]))
+        cells.append('>%.0f: %d' % (BUCKETS[-1], self.buckets[-1]))
+        return ('%s: n=%d mean=%.1fms worst=%.1fms [%s]'
+                % (self.label, self.count, mean, self.worst,
+                   ', '.join(cells)))
+
+class TraceCollector():
+    "Pipeline latency trace collector node."
+
+    def __init__(self):
+        rospy.init_node('trace_latency')
+        self.hops = {}
+        self.period = rospy.get_param('~report_period', 10.0)
+        self.sub = rospy.Subscriber('pipeline_trace', PipelineEvent,
+                                    self.traceCallback)
+        self.timer = rospy.Timer(rospy.Duration(self.period), self.report)
+
+    def traceCallback(self, event):
+        "accumulate one trace event"
+        latency_ms = (event.header.stamp - event.origin).to_sec() * 1000.0
+        if latency_ms < 0.0:
+            rospy.logwarn('negative latency from ' + event.node
+                          + ' (clocks out of sync?)')
+            return
+        key = event.node + '(' + event.topic + ')'
+        if key not in self.hops:
+            self.hops[key] = HopStats(key)
+        self.hops[key].add(latency_ms)
+
+    def report(self, timer_event):
+        "log accumulated per-hop histograms"
+        if not self.hops:
+            rospy.loginfo('no pipeline trace events received')
+            return
+        for key in sorted(self.hops.keys()):
+            rospy.loginfo(self.hops[key].report())
+
+def main():
+    TraceCollector()
+    try:
+        rospy.spin()
+    except rospy.ROSInterruptException: pass
+
+if __name__ == '__main__':
+    # run main function and exit
+    sys.exit(main())
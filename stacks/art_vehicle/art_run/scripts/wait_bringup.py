@@ -0,0 +1,79 @@
+#!/usr/bin/python
+#
+#  block until the named nodes report bringup readiness
+#
+#   Copyright (C) 2011 Austin Robot Technology
+#   License: Modified BSD Software License Agreement
+#
+# $Id$
+#
+# Usage: wait_bringup.py [-t timeout] node [node ...]
+#
+# Subscribes to the latched "bringup/state" topic and waits until
+# every named node reports RUNNING, then exits 0.  Exits 1 if the
+# timeout expires first.  Launch tooling runs this between bringup
+# stages instead of sleeping a fixed interval.
+
+PKG_NAME = 'art_run'
+
+import sys
+from optparse import OptionParser
+
+import roslib;
+roslib.load_manifest(PKG_NAME)
+import rospy
+
+from art_msgs.msg import BringupState
+from art_msgs.msg import DriverState
+
+class BringupWaiter():
+    "Wait for a set of nodes to report bringup readiness."
+
+    def __init__(self, nodes):
+        rospy.init_node('wait_bringup', anonymous=True)
+        # remaining node names, with and without a leading slash so
+        # callers need not know how the nodes were launched
+        self.waiting = set()
+        for node in nodes:
+            self.waiting.add(node.lstrip('/'))
+        self.sub = rospy.Subscriber('bringup/state', BringupState,
+                                    self.stateCallback)
+
+    def stateCallback(self, msg):
+        "record one readiness report"
+        node = msg.node.lstrip('/')
+        if msg.state.state == DriverState.RUNNING:
+            if node in self.waiting:
+                rospy.loginfo('%s ready: %s' % (msg.node, msg.detail))
+                self.waiting.discard(node)
+        else:
+            rospy.loginfo('%s initializing: %s' % (msg.node, msg.detail))
+
+    def wait(self, timeout):
+        "poll until all nodes are ready, return True on success"
+        deadline = rospy.Time.now() + rospy.Duration(timeout)
+        rate = rospy.Rate(10)
+        while not rospy.is_shutdown():
+            if not self.waiting:
+                return True
+            if rospy.Time.now() > deadline:
+                rospy.logerr('bringup timeout, still waiting for: '
+                             + ', '.join(sorted(self.waiting)))
+                return False
+            rate.sleep()
+        return False
+
+def main():
+    parser = OptionParser(usage='usage: %prog [-t timeout] node [node ...]')
+    parser.add_option('-t', '--timeout', type='float', default=60.0,
+                      help='seconds to wait before giving up (default 60)')
+    options, nodes = parser.parse_args()
+    if not nodes:
+        parser.error('no node names given')
+    if BringupWaiter(nodes).wait(options.timeout):
+        return 0
+    return 1
+
+if __name__ == '__main__':
+    # run main function and exit
+    sys.exit(main())
@@ -20,10 +20,12 @@
 
 #include "ros/ros.h"
 
-#include <art/pid2.h>			// PID control 
+#include <art/pid2.h>			// PID control
+#include <art/realtime.h>		// real-time scheduling setup
 
 #include <art_msgs/BrakeCommand.h>
 #include <art_msgs/BrakeState.h>
+#include <art_msgs/ReloadCalibration.h>
 
 #include <art_msgs/ArtHertz.h>
 
@@ -40,6 +42,13 @@ Publishes
 
 - brake/state topic
 
+Services
+
+- brake/reload_calibration: re-read the calibration parameters and
+  apply them between control cycles, so the brake can be recalibrated
+  without restarting the driver and repeating the actuator homing
+  sequence.
+
 Commands
 
 - brake/cmd topic
@@ -92,61 +101,148 @@ namespace
   devbrake *dev;                        // servo device interface
   float	brake_pos;                      // current brake position
   float	set_point;			// requested brake setting
+
+  // Brake sensor calibration values, double-buffered: the reload
+  // service stages a validated copy here, and the main loop swaps it
+  // into the active device values between control cycles, so a
+  // reload can never tear a cycle's conversions.
+  typedef struct
+  {
+    double encoder_min;                 // brake motor encoder limits
+    double encoder_max;
+    double pot_off;                     // potentiometer limits
+    double pot_full;
+    double pressure_min;                // pressure sensor limits
+    double pressure_max;
+  } calibration_t;
+
+  calibration_t staged_cal;             // staging buffer
+  bool have_staged_cal = false;         // staging buffer filled
 }
 
 // ROS topics used by this driver
 ros::Subscriber brake_cmd;              // /brake/cmd ROS topic
 ros::Publisher brake_state;             // /brake/state ROS topic
+ros::ServiceServer reload_srv;          // /brake/reload_calibration
 
-int GetParameters(void)
+/** Read brake calibration parameters into a staging buffer.
+ *
+ *  @param cal buffer to fill
+ *  @return 0 if the calibration is usable, EINVAL otherwise
+ */
+int ReadCalibration(calibration_t &cal)
 {
   // use private node handle to get parameters
   ros::NodeHandle mynh("~");
 
-  mynh.getParam("port", port);
-  ROS_INFO("brake port = %s", port.c_str());
+  // Make sure the defaults won't strip the servo hardware gears.
+  // These values will be used for /dev/null, in training mode, or in
+  // case of failure.
 
-  mynh.getParam("training", training);
-  if (training)
-    ROS_INFO("using training mode");
+  if (!mynh.getParam("encoder_min", cal.encoder_min))
+    cal.encoder_min = 0.0;
+  if (!mynh.getParam("encoder_max", cal.encoder_max))
+    cal.encoder_max = 50000.0;
 
-  mynh.getParam("diagnostic", diagnostic);
-  if (diagnostic)
-    ROS_INFO("using diagnostic mode");
+  if (!mynh.getParam("pot_off", cal.pot_off))
+    cal.pot_off = 4.9;
+  if (!mynh.getParam("pot_full", cal.pot_full))
+    cal.pot_full = 0.49;
 
-  // allocate and initialize the devbrake interface
-  dev = new devbrake(training);
+  if (!mynh.getParam("pressure_min", cal.pressure_min))
+    cal.pressure_min = 0.85;
+  if (!mynh.getParam("pressure_max", cal.pressure_max))
+    cal.pressure_max = 4.5;
 
-  // Set brake parameters -- make sure the defaults won't strip the
-  // servo hardware gears.  These values will be used for /dev/null,
-  // in training mode, or in case of failure.  They may be updated by
-  // devbrake when it detects calibration changes.
+  // reject a calibration with any empty sensor range: it would
+  // divide by zero in the position conversions
+  if (cal.encoder_max == cal.encoder_min
+      || cal.pot_full == cal.pot_off
+      || cal.pressure_max == cal.pressure_min)
+    return EINVAL;
 
-  // TODO: move these parameters into a subordinate class.
+  return 0;
+}
 
-  if (!mynh.getParam("encoder_min", dev->encoder_min))
-    dev->encoder_min = 0.0;
-  if (!mynh.getParam("encoder_max", dev->encoder_max))
-    dev->encoder_max = 50000.0;
+/** Apply a staged calibration to the device interface.
+ *
+ *  Must run between control cycles.  The values may later be updated
+ *  by devbrake when it detects calibration changes.
+ */
+void ApplyCalibration(const calibration_t &cal)
+{
+  dev->encoder_min = cal.encoder_min;
+  dev->encoder_max = cal.encoder_max;
   dev->encoder_range = dev->encoder_max - dev->encoder_min;
   ROS_INFO("configured encoder range [%.f, %.f]",
            dev->encoder_min, dev->encoder_max);
 
-  if (!mynh.getParam("pot_off", dev->pot_off))
-    dev->pot_off = 4.9;
-  if (!mynh.getParam("pot_full", dev->pot_full))
-    dev->pot_full = 0.49;
+  dev->pot_off = cal.pot_off;
+  dev->pot_full = cal.pot_full;
   dev->pot_range = dev->pot_full - dev->pot_off;
   ROS_INFO("configured potentiometer range [%.3f, %.3f]",
            dev->pot_off, dev->pot_full);
 
-  if (!mynh.getParam("pressure_min", dev->pressure_min))
-    dev->pressure_min = 0.85;
-  if (!mynh.getParam("pressure_max", dev->pressure_max))
-    dev->pressure_max = 4.5;
+  dev->pressure_min = cal.pressure_min;
+  dev->pressure_max = cal.pressure_max;
   dev->pressure_range = dev->pressure_max - dev->pressure_min;
   ROS_INFO("configured pressure range [%.3f, %.3f]",
            dev->pressure_min, dev->pressure_max);
+}
+
+/** Reload calibration service request.
+ *
+ *  Runs on the main thread via spinOnce(), but only stages the new
+ *  values: the main loop swaps the buffer into the device at a
+ *  defined point in the cycle, so this remains safe even if the
+ *  driver ever moves its callbacks to a separate spinner thread.
+ */
+bool ReloadCalibration(art_msgs::ReloadCalibration::Request &req,
+                       art_msgs::ReloadCalibration::Response &rsp)
+{
+  if (ReadCalibration(staged_cal) == 0)
+    {
+      have_staged_cal = true;
+      rsp.success = true;
+      rsp.status = "new brake calibration staged";
+    }
+  else
+    {
+      rsp.success = false;
+      rsp.status = "invalid brake calibration (ignored)";
+      ROS_ERROR("%s", rsp.status.c_str());
+    }
+  return true;
+}
+
+int GetParameters(void)
+{
+  // use private node handle to get parameters
+  ros::NodeHandle mynh("~");
+
+  mynh.getParam("port", port);
+  ROS_INFO("brake port = %s", port.c_str());
+
+  mynh.getParam("training", training);
+  if (training)
+    ROS_INFO("using training mode");
+
+  mynh.getParam("diagnostic", diagnostic);
+  if (diagnostic)
+    ROS_INFO("using diagnostic mode");
+
+  // allocate and initialize the devbrake interface
+  dev = new devbrake(training);
+
+  // TODO: move these parameters into a subordinate class.
+
+  calibration_t initial_cal;
+  if (ReadCalibration(initial_cal) != 0)
+    {
+      ROS_FATAL("invalid brake calibration parameters");
+      return -1;
+    }
+  ApplyCalibration(initial_cal);
 
   // allocate PID control and configure parameters
   pid = new Pid("pid", 0.25, 0.0, 0.7);
@@ -248,6 +344,8 @@ int main(int argc, char** argv)
   brake_cmd = node.subscribe(NODE "/cmd", qDepth, ProcessCommand,
                              ros::TransportHints().tcpNoDelay(true));
   brake_state = node.advertise<art_msgs::BrakeState>(NODE "/state", qDepth);
+  reload_srv = node.advertiseService(NODE "/reload_calibration",
+                                     ReloadCalibration);
 
   if (GetParameters() != 0)
     return 1;
@@ -257,6 +355,9 @@ int main(int argc, char** argv)
   if (Setup() != 0)
     return 2;
 
+  // apply real-time scheduling configuration, if any
+  Realtime::configure(NODE);
+
   // Main loop; grab messages off our queue and republish them via ROS
   while(ros::ok())
     {
@@ -264,6 +365,12 @@ int main(int argc, char** argv)
 
       ros::spinOnce();                  // handle incoming commands
 
+      if (have_staged_cal)              // calibration reloaded?
+        {
+          ApplyCalibration(staged_cal);
+          have_staged_cal = false;
+        }
+
       static float const epsilon = 0.001;
       float ctlout = pid->Update(set_point - brake_pos, brake_pos);
       if (fabs(ctlout) > epsilon)       // not quite close enough?
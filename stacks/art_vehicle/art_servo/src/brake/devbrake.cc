@@ -20,6 +20,7 @@
 #include <ros/ros.h>
 
 #include <art/conversions.h>
+#include <art/flight_recorder.h>
 
 #include "devbrake.h"
 
@@ -44,8 +45,9 @@ devbrake::devbrake(bool train)
   training = train;
   already_configured = false;
   cur_position = 0.0;
-  prev_pressure = 0.0;
   sim = NULL;
+  rxbuf_next = 0;
+  rxbuf_len = 0;
 
   // use private node handle to get parameters
   ros::NodeHandle mynh("~");
@@ -54,6 +56,15 @@ devbrake::devbrake(bool train)
   mynh.param("pressure_filter_gain", pressure_filter_gain, 0.4);
   ROS_INFO("brake pressure RC filter gain is %.3f", pressure_filter_gain);
 
+  // optional potentiometer smoothing, off by default
+  mynh.param("pot_filter_gain", pot_filter_gain, 0.0);
+  if (pot_filter_gain > 0.0)
+    ROS_INFO("brake potentiometer RC filter gain is %.3f", pot_filter_gain);
+
+  // the filter bank uses EWMA smoothing factors: 1 - RC gain
+  filters_.set_smoothing(FILT_PRESSURE, 1.0f - (float) pressure_filter_gain);
+  filters_.set_smoothing(FILT_POT, 1.0f - (float) pot_filter_gain);
+
   mynh.param("use_pressure", use_pressure, true);
   ROS_INFO("use %s sensor to control brake",
 	  (use_pressure? "pressure": "position"));
@@ -155,6 +166,7 @@ int devbrake::brake_absolute(float position)
 int devbrake::brake_relative(float delta)
 {
   ROS_DEBUG("brake_relative(%.3f)", delta);
+  ART_RECORD2("brake relative", delta, cur_position);
 
   float	new_pos = limit_travel(cur_position + delta);
   if ((delta > 0.0) && (new_pos > deceleration_threshold))
@@ -194,6 +206,26 @@ int devbrake::brake_relative(float delta)
 int devbrake::get_state(float *position, float *potentiometer,
                         float *encoder, float *pressure)
 {
+  // Pipeline the three sensor queries on the real device: write them
+  // all in one burst, then collect the responses in order.  The
+  // controller executes commands sequentially, so this saves two full
+  // serial round trips per cycle compared to querying one at a time.
+  if (!sim)
+    {
+      char responses[3][MAX_SERVO_CMD_BUFFER];
+      int rc = query_batch("RP\nc=UEA Rc\nc=UAA Rc\n", 3, responses);
+      if (rc == 0)
+        {
+          // parse in query order, same side-effects as the queries below
+          parse_encoder(responses[0], encoder);
+          parse_pot(responses[1], potentiometer);
+          parse_pressure(responses[2], pressure);
+          *position = cur_position;
+          return 0;
+        }
+      // on any error, fall through and retry one command at a time
+    }
+
   // Read the primary hardware sensors, set rc to either zero or the
   // last error return code.  The query methods only modify their data
   // parameter if successful.
@@ -230,38 +262,47 @@ int devbrake::query_encoder(float *data)
 
   int rc = query_cmd("RP\n", string, MAX_SERVO_CMD_BUFFER);
   if (rc == 0)			// only update if successful
-    {
-      *data = cur_encoder = strtof(string, NULL);
-      check_encoder_limits();		// adjust limits if motor slipped
-      ROS_DEBUG("query encoder returns %.1f", *data);
-    }
+    parse_encoder(string, data);
 
   return rc;
 }
 
+void devbrake::parse_encoder(const char *string, float *data)
+{
+  *data = cur_encoder = strtof(string, NULL);
+  check_encoder_limits();		// adjust limits if motor slipped
+  ROS_DEBUG("query encoder returns %.1f", *data);
+}
+
 int devbrake::query_pot(float *data)
 {
   char string[MAX_SERVO_CMD_BUFFER];
 
   int rc = query_cmd("c=UEA Rc\n", string, MAX_SERVO_CMD_BUFFER);
   if (rc == 0)				// only update if successful
-    {
-      // A/D value of potentiometer
-      float pot_val = strtof(string, NULL);
-
-      // convert A/D input to voltage (10-bit converter with 5-volt range)
-      *data = cur_pot = analog_volts(pot_val, 5.0, 10);
-      ROS_DEBUG("brake potentiometer voltage is %.3f (A/D %.f)",
-                cur_pot, pot_val);
-
-      if (!use_pressure && already_configured)
-	// use potentiometer to estimate current position
-	cur_position = limit_travel(pot2pos(cur_pot));
-    }
+    parse_pot(string, data);
 
   return rc;
 }
 
+void devbrake::parse_pot(const char *string, float *data)
+{
+  // A/D value of potentiometer
+  float pot_val = strtof(string, NULL);
+
+  // convert A/D input to voltage (10-bit converter with 5-volt
+  // range), smoothed by its filter bank channel (pass-through unless
+  // pot_filter_gain is configured)
+  cur_pot = filters_.update(FILT_POT, analog_volts(pot_val, 5.0, 10));
+  *data = cur_pot;
+  ROS_DEBUG("brake potentiometer voltage is %.3f (A/D %.f)",
+            cur_pot, pot_val);
+
+  if (!use_pressure && already_configured)
+    // use potentiometer to estimate current position
+    cur_position = limit_travel(pot2pos(cur_pot));
+}
+
 // RC filter transfer function: y[k] = (1-a)*x[k] + a*y[k-1]
 static inline float RC_filter(float a, float xk, float yk1)
 {
@@ -274,32 +315,30 @@ int devbrake::query_pressure(float *data)
 
   int rc = query_cmd("c=UAA Rc\n", string, MAX_SERVO_CMD_BUFFER);
   if (rc == 0)			// only update if successful
-    {
-      // A/D value of pressure sensor
-      float pressure_val = strtof(string, NULL);
+    parse_pressure(string, data);
 
-      // convert A/D input to voltage (10-bit converter with 5-volt range)
-      cur_pressure = analog_volts(pressure_val, 5.0, 10);
+  return rc;
+}
 
-      // smooth the data using an RC low-pass filter to eliminate
-      // small fluctuations.
-      cur_pressure = RC_filter(pressure_filter_gain,
-			       cur_pressure, prev_pressure);
-      ROS_DEBUG("RC filter output = %.3f, previous = %.3f",
-                cur_pressure, prev_pressure);
+void devbrake::parse_pressure(const char *string, float *data)
+{
+  // A/D value of pressure sensor
+  float pressure_val = strtof(string, NULL);
 
-      ROS_DEBUG("brake pressure voltage is %.3f (A/D %.f)",
-                cur_pressure, pressure_val);
-      *data = cur_pressure;		// return result to caller
+  // convert A/D input to voltage (10-bit converter with 5-volt range)
+  cur_pressure = analog_volts(pressure_val, 5.0, 10);
 
-      if (use_pressure && already_configured)
-	// use pressure to estimate current position
-	cur_position = limit_travel(press2pos(cur_pressure));
+  // smooth the data with the filter bank channel to eliminate
+  // small fluctuations.
+  cur_pressure = filters_.update(FILT_PRESSURE, cur_pressure);
 
-      prev_pressure = cur_pressure;
-    }
+  ROS_DEBUG("brake pressure voltage is %.3f (A/D %.f)",
+            cur_pressure, pressure_val);
+  *data = cur_pressure;		// return result to caller
 
-  return rc;
+  if (use_pressure && already_configured)
+    // use pressure to estimate current position
+    cur_position = limit_travel(press2pos(cur_pressure));
 }
 
 int devbrake::query_volts(float *data)
@@ -535,6 +574,7 @@ int devbrake::configure_brake(void)
 // slipping.  Resetting the origin would prevent that.
 int devbrake::encoder_goto(int enc_delta)
 {
+  ART_RECORD1("brake encoder goto", enc_delta);
   sprintf(buffer, "D=%d RW G\n", enc_delta);
   int rc = servo_cmd(buffer);
   if (rc == 0)
@@ -601,6 +641,135 @@ int devbrake::encoder_goto(int enc_delta)
   return rc;
 }
 
+/*  Discard any stale input, both in the kernel and in our buffer.
+ *
+ *  Only called before writing a new command after an error or an
+ *  unrelated previous command, never between a pipelined write and
+ *  its responses.
+ */
+void devbrake::flush_input(void)
+{
+  tcflush(fd, TCIOFLUSH);
+  rxbuf_next = 0;
+  rxbuf_len = 0;
+}
+
+/*  Read one '\r'-terminated response line from the device.
+ *
+ *   Event-driven: poll() for input, then read whatever is available
+ *   in one gulp instead of one byte per system call.  Any bytes after
+ *   the line terminator stay in rxbuf for the next call, so pipelined
+ *   responses are never lost.
+ *
+ *  returns: 0 if successful with status holding the line (terminator
+ *           stripped), errno value otherwise.
+ */
+int devbrake::read_line(char *status, int nbytes, int timeout)
+{
+  int linelen = 0;
+  int64_t stop_time = GetTime() + timeout;
+
+  while (true)
+    {
+      // consume buffered input first
+      while (rxbuf_next < rxbuf_len)
+	{
+	  char c = rxbuf[rxbuf_next++];
+	  if (c == '\r')		// end of line?
+	    return 0;			// success
+	  status[linelen] = c;
+	  if (++linelen >= nbytes)
+	    {
+	      ROS_ERROR("buffer overflow: %s", status);
+	      return ENOSPC;
+	    }
+	}
+
+      // buffer drained, wait for more input
+      rxbuf_next = 0;
+      rxbuf_len = 0;
+
+      struct pollfd fds[1];
+      fds[0].fd = fd;
+      fds[0].events = POLLIN;
+      int64_t delay = stop_time - GetTime();
+      if (delay < 0) delay = 0;
+      int retval = ::poll(fds, 1, delay);
+      if (retval < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  ROS_ERROR("error returned on poll");
+	  return errno;
+	}
+      else if (!retval)
+	{
+	  ROS_INFO("timeout on poll");
+	  return EBUSY;
+	}
+      else if ((fds[0].revents & POLLERR) ||
+	       (fds[0].revents & POLLHUP) ||
+	       (fds[0].revents & POLLNVAL))
+	{
+	  ROS_ERROR("Device error on poll");
+	  return EIO;
+	}
+
+      int bytes = read(fd, rxbuf, sizeof(rxbuf));
+      if (bytes < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  ROS_ERROR("error: %s", strerror(errno));
+	  return errno;
+	}
+      ROS_DEBUG("read() returns %d bytes", bytes);
+      rxbuf_len = bytes;
+    }
+}
+
+/*  Pipeline several commands to the brake controller in one write.
+ *
+ *   The controller executes commands in order and responds in order,
+ *   so writing them together eliminates a serial round trip per
+ *   command.  Commands must each produce exactly one response line
+ *   and must not include a status request (RS or RW), those belong
+ *   in servo_cmd().
+ *
+ *   Unlike query_cmd() there is no retry here: with multiple
+ *   responses in flight it is not clear which command failed, so any
+ *   error returns immediately and the caller falls back to querying
+ *   one command at a time.
+ *
+ *  returns: 0 if successful with all response lines filled in,
+ *           errno value otherwise.
+ */
+int devbrake::query_batch(const char *cmds, int ncmds,
+                          char responses[][MAX_SERVO_CMD_BUFFER])
+{
+  ROS_DEBUG("query_batch %s", cmds);
+
+  // Flush stale input to ensure nothing is left over from any
+  // previous command.
+  flush_input();
+
+  // There is not much point in checking for errors on the write().
+  // If something went wrong, we'll find out reading the responses.
+  int res = write(fd, cmds, strlen(cmds));
+  if (res < 0)
+    ROS_ERROR_THROTTLE(100, "write() error: %d", errno);
+
+  for (int i = 0; i < ncmds; ++i)
+    {
+      memset(responses[i], 0, MAX_SERVO_CMD_BUFFER);
+      int rc = read_line(responses[i], MAX_SERVO_CMD_BUFFER, 16);
+      if (rc != 0)
+	return rc;
+    }
+
+  return 0;
+}
+
 /*  Query status from the brake controller.
  *
  *   Writes a command, then reads up to nbytes of status from the device.
@@ -621,9 +790,9 @@ int devbrake::query_cmd(const char *string, char *status, int nbytes)
   int attempts = 3;			// number of times to try command
   do
     {
-      // Flush the I/O buffers to ensure nothing is left over from any
+      // Flush stale input to ensure nothing is left over from any
       // previous command.
-      tcflush(fd, TCIOFLUSH);
+      flush_input();
 
       // There is not much point in checking for errors on the
       // write().  If something went wrong, we'll find out by reading
@@ -632,81 +801,13 @@ int devbrake::query_cmd(const char *string, char *status, int nbytes)
       if (res < 0)
         ROS_ERROR_THROTTLE(100, "write() error: %d", errno);
 
-      int timeout = 16;			// set timeout in msecs
-      int linelen = 0;
-
-      int64_t start_time = GetTime();
-      int64_t stop_time = start_time + timeout;
-
-      while (true)
-	{
-	  if (timeout >= 0) {
-	    struct pollfd fds[1];
-	    fds[0].fd=fd;
-	    fds[0].events = POLLIN;
-	    int64_t delay = stop_time - GetTime();
-	    if (delay < 0) delay = 0;
-	    int retval = ::poll(fds, 1, delay);
-	    if (retval < 0)
-	      {
-		if (errno == EINTR)
-		  continue;
-		ROS_ERROR("error returned on poll");
-		rc= errno;
-		break;
-	      }
-	    else if (!retval)
-	      {
-		ROS_INFO("timeout on poll");
-		rc= EBUSY;
-		break;
-	      }
-	    else {
-	      if ((fds[0].revents & POLLERR) ||
-		  (fds[0].revents & POLLHUP) ||
-		  (fds[0].revents & POLLNVAL))
-		{
-		  ROS_ERROR("Device error on poll");
-		  rc= EIO;
-		  break;
-		}
-	    }
-	  }
-
-	  int bytes = read(fd, status + linelen, 1);
-	  if (bytes < 0)
-	    {
-	      if (errno == EINTR)
-		continue;
-	      ROS_ERROR("error: %s", strerror(rc));
-	      rc = errno;
-	      break;			// retry servo command
-	    }
-
-	  ROS_DEBUG("read() returns %d, 0x%02X (%c)",
-                    bytes, (bytes > 0? status[linelen]: 0),
-                    (bytes > 0? status[linelen]: '-'));
-	  
-	  if (bytes==0)
-	    continue;
-	  else if (status[linelen] != '\r') // not end of line?
-	    {
-	      // have a new character
-	      if (++linelen >= nbytes)
-		{
-		  ROS_ERROR("buffer overflow: %s", status);
-		  rc = ENOSPC;
-		  break;		// retry servo command
-		}
-	    }
-	  else				// have a complete line
-	    {
-	      return 0;			// success
-	    }
-	}
+      memset(status, 0, nbytes);
+      rc = read_line(status, nbytes, 16); // 16 msec timeout
+      if (rc == 0)
+	return 0;			// success
     }
   while (--attempts > 0);		// retry, if error
-      
+
   return rc;
 }
 
@@ -808,9 +909,9 @@ void devbrake::servo_write_only(const char *string)
 {
   ROS_DEBUG("servo_write_only %s", string);
 
-  // Flush the I/O buffers to ensure nothing is left over from any
+  // Flush stale input to ensure nothing is left over from any
   // previous command.
-  tcflush(fd, TCIOFLUSH);
+  flush_input();
 
   // There is not much point in checking for errors on the write().
   // If something went wrong, we'll find out later on some command
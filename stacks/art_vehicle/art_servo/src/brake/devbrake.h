@@ -21,6 +21,8 @@
 #include <stdint.h>
 #include <math.h>
 
+#include <art/filter.h>
+
 #include "../servo.h"
 #include "model_brake.h"
 
@@ -76,20 +78,36 @@ public:
   double deceleration_threshold;
   double deceleration_limit;
   double pressure_filter_gain;
+  double pot_filter_gain;
   bool   use_pressure;
 
+  // sensor smoothing filter bank channels
+  enum
+    {
+      FILT_PRESSURE = 0,		// brake pressure voltage
+      FILT_POT,				// potentiometer voltage
+      N_FILTERS
+    };
+
   // current brake status
   bool	already_configured;		// brake already configured once
   brake_status_t cur_status;		// last status from servo_cmd()
   float	cur_pot;			// last potentiometer voltage
   float	cur_pressure;			// last brake pressure read
-  float	prev_pressure;			// last brake pressure read
   float	cur_encoder;			// last encoder value read
+  EWMAFilterBank<N_FILTERS> filters_;	// sensor smoothing state
 
   float	cur_position;			// last position read
 
   ArtBrakeModel *sim;                   // brake simulation model
 
+  // receive buffer for event-driven reads: read_line() pulls as many
+  // bytes as poll() says are ready in one gulp, keeping any bytes
+  // after the line terminator here for the next response
+  char	rxbuf[MAX_SERVO_CMD_BUFFER];
+  int	rxbuf_next;			// next unconsumed byte
+  int	rxbuf_len;			// bytes buffered
+
   // pointer to any of the private query_* methods
   typedef int (devbrake::*query_method_t)(float *);
 
@@ -100,11 +118,21 @@ public:
   int	query_pressure(float *data);
   int	query_volts(float *data);
 
+  // parse methods, shared by the query_* round trips and the
+  // pipelined get_state() path
+  void	parse_encoder(const char *string, float *data);
+  void	parse_pot(const char *string, float *data);
+  void	parse_pressure(const char *string, float *data);
+
   int	calibrate_brake(void);
   void	check_encoder_limits(void);
   int	configure_brake(void);
   int	encoder_goto(int enc_delta);
+  void	flush_input(void);
+  int	query_batch(const char *cmds, int ncmds,
+                    char responses[][MAX_SERVO_CMD_BUFFER]);
   int	query_cmd(const char *string, char *status, int nbytes);
+  int	read_line(char *status, int nbytes, int timeout);
   int	read_stable_value(query_method_t query_method,
 			  double *status, float epsilon);
   int	servo_cmd(const char *string);
@@ -0,0 +1,203 @@
+/*
+ *  ART brake servo controller pseudo-terminal unit test
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Exercise the devbrake serial I/O paths against a scripted
+     pseudo-terminal mock: command round trips with device latency,
+     timeout recovery with an unresponsive device, and garbage bytes
+     on the line.  These regressions used to be discovered on the
+     vehicle.
+
+     The device runs in training mode, so Open() skips the
+     configuration and calibration dialogues that need brake hardware.
+
+     @author Jack O'Quin
+
+ */
+
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include <art/conversions.h>
+
+#include "../pty_mock.h"
+#include "devbrake.h"
+
+namespace
+{
+  PtyMock *pty = NULL;
+  devbrake *dev = NULL;
+
+  /** elapsed wall clock in milliseconds */
+  double elapsed_ms(const ros::WallTime &start)
+  {
+    return (ros::WallTime::now() - start).toSec() * 1000.0;
+  }
+
+  /** Script normal responses for the three get_state() queries. */
+  void script_sensors(int encoder, int pot, int pressure, int delay_ms = 0)
+  {
+    char response[32];
+    snprintf(response, sizeof(response), "%d\r", encoder);
+    pty->add_response("RP", response, delay_ms);
+    snprintf(response, sizeof(response), "%d\r", pot);
+    pty->add_response("c=UEA", response, delay_ms);
+    snprintf(response, sizeof(response), "%d\r", pressure);
+    pty->add_response("c=UAA", response, delay_ms);
+  }
+}
+
+class DevbrakePty: public testing::Test
+{
+protected:
+
+  /** Open the device once: Open() spends three seconds switching the
+   *  controller baud rate, too slow to repeat for every test.
+   */
+  static void SetUpTestCase()
+  {
+    pty = new PtyMock();
+    ASSERT_TRUE(pty->open());
+
+    dev = new devbrake(true);           // training mode
+    ASSERT_EQ(0, dev->Open(pty->slave_name()));
+
+    // calibration limits normally configured by the brake node
+    dev->encoder_min = 0.0;
+    dev->encoder_max = 50000.0;
+    dev->encoder_range = dev->encoder_max - dev->encoder_min;
+    dev->pot_off = 4.9;
+    dev->pot_full = 0.49;
+    dev->pot_range = dev->pot_full - dev->pot_off;
+    dev->pressure_min = 0.85;
+    dev->pressure_max = 4.5;
+    dev->pressure_range = dev->pressure_max - dev->pressure_min;
+  }
+
+  static void TearDownTestCase()
+  {
+    dev->Close();
+    delete dev;
+    dev = NULL;
+    delete pty;
+    pty = NULL;
+  }
+
+  virtual void SetUp()
+  {
+    pty->clear_script();
+  }
+};
+
+// prompt responses: one pipelined round trip fills in every sensor
+TEST_F(DevbrakePty, promptRoundTrip)
+{
+  script_sensors(12345, 512, 300);
+
+  float position, pot, encoder, pressure;
+  ros::WallTime start = ros::WallTime::now();
+  int rc = dev->get_state(&position, &pot, &encoder, &pressure);
+  double ms = elapsed_ms(start);
+
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(12345.0f, encoder);
+  EXPECT_FLOAT_EQ(analog_volts(512, 5.0, 10), pot);
+  EXPECT_GT(pressure, 0.0f);
+
+  // well under one 16ms response timeout per query
+  EXPECT_LT(ms, 48.0);
+}
+
+// device latency within the response timeout: slower, still succeeds
+TEST_F(DevbrakePty, scriptedLatencyTolerated)
+{
+  script_sensors(23456, 600, 400, 5);   // 5ms per response
+
+  float position, pot, encoder, pressure;
+  ros::WallTime start = ros::WallTime::now();
+  int rc = dev->get_state(&position, &pot, &encoder, &pressure);
+  double ms = elapsed_ms(start);
+
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(23456.0f, encoder);
+
+  // three responses, 5ms each, but no retries
+  EXPECT_GE(ms, 15.0);
+  EXPECT_LT(ms, 48.0);
+}
+
+// unresponsive device: every query times out, retries, and fails
+// without touching the caller's data
+TEST_F(DevbrakePty, unresponsiveDeviceTimesOut)
+{
+  pty->set_mute(true);
+
+  float position;
+  float pot = -1.0;
+  float encoder = -1.0;
+  float pressure = -1.0;
+  ros::WallTime start = ros::WallTime::now();
+  int rc = dev->get_state(&position, &pot, &encoder, &pressure);
+  double ms = elapsed_ms(start);
+
+  EXPECT_EQ(EBUSY, rc);
+  EXPECT_EQ(-1.0f, pot);
+  EXPECT_EQ(-1.0f, encoder);
+  EXPECT_EQ(-1.0f, pressure);
+
+  // one pipelined timeout, then three queries of three 16ms attempts
+  EXPECT_GE(ms, 140.0);
+  EXPECT_LT(ms, 500.0);
+}
+
+// unsolicited garbage queued ahead of the command must be flushed,
+// not parsed as a response
+TEST_F(DevbrakePty, staleInputFlushed)
+{
+  pty->inject("@@ 99999 @@\r");
+  usleep(20*1000);                      // let it reach the input queue
+
+  script_sensors(34567, 512, 300);
+
+  float position, pot, encoder, pressure;
+  int rc = dev->get_state(&position, &pot, &encoder, &pressure);
+
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(34567.0f, encoder);
+}
+
+// garbage bytes trailing a response must not poison the next cycle
+TEST_F(DevbrakePty, trailingGarbageDiscarded)
+{
+  pty->add_response("RP", "45678\r");
+  pty->add_response("c=UEA", "512\r");
+  pty->add_response("c=UAA", "300\r@#$%"); // line noise after the response
+
+  float position, pot, encoder, pressure;
+  int rc = dev->get_state(&position, &pot, &encoder, &pressure);
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(45678.0f, encoder);
+  EXPECT_FLOAT_EQ(analog_volts(512, 5.0, 10), pot);
+
+  // second cycle: the buffered "@#$%" must not prefix this response
+  rc = dev->get_state(&position, &pot, &encoder, &pressure);
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(45678.0f, encoder);
+  EXPECT_FLOAT_EQ(analog_volts(512, 5.0, 10), pot);
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  // devbrake reads its parameters from the private node handle
+  ros::init(argc, argv, "test_devbrake_pty");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -224,6 +224,93 @@ int dev8x::read_10bit_port(int ch, int *data)
   return 0;
 }
 
+// read every scan list port in one batched transaction
+//
+//  The IOADR8x processes commands in arrival order, so the port read
+//  commands for the whole scan list can be written together, with the
+//  responses read back in sequence.  That halves the serial traffic
+//  and jitter compared to a separate write/read round trip per port.
+//
+//  returns: 0 if successful, with data filled in for every entry;
+//           errno value otherwise, data values undefined
+int dev8x::read_scan_list(scan_entry_t *scan, int nscan)
+{
+  if (relays_busy())
+    return EBUSY;
+
+  assert(nscan <= IOADR_MAX_INPUTS);
+
+  if (have_tty == false)		// simulated device?
+    {
+      for (int i = 0; i < nscan; ++i)
+	scan[i].data = sim_sawtooth(scan[i].ch,
+				    1 << (scan[i].ten_bit? 10: 8));
+      return 0;
+    }
+
+  // format one command per entry, all in a single buffer
+  uint8_t cmds[3*IOADR_MAX_INPUTS];
+  int cmdlen = 0;
+  int resplen = 0;
+  for (int i = 0; i < nscan; ++i)
+    {
+      cmds[cmdlen++] = 254;
+      cmds[cmdlen++] = 6;
+      if (scan[i].ten_bit)
+	{
+	  // can only read 10-bit data from analog ports (3-7)
+	  assert(scan[i].ch >= 3);
+	  cmds[cmdlen++] = 8 + scan[i].ch - 3;
+	  resplen += 2;
+	}
+      else
+	{
+	  cmds[cmdlen++] = scan[i].ch;
+	  resplen += 1;
+	}
+    }
+
+  DBG("read_scan_list: writing %d commands", nscan);
+  int res = write(fd, cmds, cmdlen);
+  if (res < 0)
+    ROS_ERROR_THROTTLE(100, "write() error: %d", errno);
+
+  // read all the response bytes, in as few gulps as the device allows
+  uint8_t resp[2*IOADR_MAX_INPUTS];
+  int got = 0;
+  while (got < resplen)
+    {
+      int rc = read(fd, resp + got, resplen - got);
+      if (rc <= 0)
+	{
+	  if (rc < 0 && errno == EINTR)
+	    continue;
+	  ROS_WARN("ioadr8x scan read error: rc = %d", rc);
+	  if (rc < 0)
+	    return errno;
+	  else
+	    return EIO;
+	}
+      got += rc;
+    }
+
+  // unpack response bytes in scan list order, high byte first
+  int next = 0;
+  for (int i = 0; i < nscan; ++i)
+    {
+      if (scan[i].ten_bit)
+	{
+	  scan[i].data = (resp[next]<<8) | resp[next+1];
+	  next += 2;
+	}
+      else
+	scan[i].data = resp[next++];
+      DBG("port %d returns 0x%04x", scan[i].ch, scan[i].data);
+    }
+
+  return 0;
+}
+
 // returns true if last relay write has not completed
 bool dev8x::relays_busy(void)
 {
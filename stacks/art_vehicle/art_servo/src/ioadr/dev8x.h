@@ -34,9 +34,18 @@ public:
   dev8x(const char *pn);
   ~dev8x() {};
 
+  // one entry of a batched port scan
+  typedef struct
+  {
+    int  ch;				// port number to read
+    bool ten_bit;			// 10-bit analog read
+    int  data;				// value returned
+  } scan_entry_t;
+
   int	query_relays(uint8_t *relays);
   int   read_8bit_port(int ch, int *data);
   int   read_10bit_port(int ch, int *data);
+  int   read_scan_list(scan_entry_t *scan, int nscan);
   bool	relays_busy(void);
   int	set_relays(uint8_t bitmask);
   int	setup();
@@ -10,6 +10,7 @@
 
 #include <art_msgs/ArtHertz.h>
 #include <art/conversions.h>
+#include <art/filter.h>
 
 #include <art_msgs/Shifter.h>
 #include <art_msgs/IOadrCommand.h>
@@ -66,8 +67,9 @@ public:
   int Setup(ros::NodeHandle node);
   int Shutdown();
 
-  // pointer to any of the poll_* methods
-  typedef int (IOadr::*poll_method_t)(int ch);
+  // pointer to any of the poll_* methods, which process the data
+  // returned for one scan list entry
+  typedef int (IOadr::*poll_method_t)(int ch, int data);
 
   typedef struct
   {
@@ -77,10 +79,10 @@ public:
     int field;                          // analog voltage field index
   } poll_parms_t;
 
-  int poll_Analog_8bit(int ch);
-  int poll_Analog_10bit(int ch);
-  int poll_Digital(int ch);
-  int poll_ShifterInd(int ch);
+  int poll_Analog_8bit(int ch, int data);
+  int poll_Analog_10bit(int ch, int data);
+  int poll_Digital(int ch, int data);
+  int poll_ShifterInd(int ch, int data);
 
 private:
 
@@ -108,9 +110,19 @@ private:
   uint8_t relay_mask_;
   uint8_t relay_bits_;
 
+  // cached relay image, maintained across successful writes so the
+  // relays need not be queried over the serial line every cycle
+  bool relays_known_;
+  int relay_verify_countdown_;
+
   // current device input state
   art_msgs::IOadrState ioMsg_;         // controller state message
 
+  // analog channel smoothing, one vectorized update per scan
+  // (pass-through unless ~analog_filter_gain is configured)
+  EWMAFilterBank<art_msgs::IOadrState::N_VOLTAGES> analog_filter_;
+  double analog_filter_gain_;          // RC filter gain parameter
+
   // hardware IOADR8x interface
   dev8x *dev_;
 };
@@ -145,12 +157,21 @@ IOadr::poll_parms_t *LookupInput(const char *name)
 // NOTE: these are NOT the same as the digital B input values.
 static const uint8_t relay_value_[5] = {0x00, 0x02, 0x04, 0x08, 0x10};
 
+// Cycles between relay image verification reads.  Nothing but this
+// driver writes the relays, so the cached image stays valid across
+// cycles; an occasional query guards against device glitches without
+// paying a serial round trip every cycle.
+static const int RELAY_VERIFY_CYCLES = 50;
+
 // constructor
 IOadr::IOadr()
 {
   node_name_ = ros::this_node::getName();
   ROS_INFO_STREAM("initialize node: " << node_name_);
 
+  relays_known_ = false;
+  relay_verify_countdown_ = 0;
+
   // use private node handle to get parameters
   ros::NodeHandle mynh("~");
 
@@ -158,6 +179,15 @@ IOadr::IOadr()
   if (reset_relays_ >= 0)
     ROS_INFO("reset relays to 0x%02x", reset_relays_);
 
+  // optional analog input smoothing, off by default
+  mynh.param("analog_filter_gain", analog_filter_gain_, 0.0);
+  if (analog_filter_gain_ > 0.0)
+    {
+      ROS_INFO("analog RC filter gain is %.3f", analog_filter_gain_);
+      // the filter bank uses EWMA smoothing factors: 1 - RC gain
+      analog_filter_.set_smoothing(1.0f - (float) analog_filter_gain_);
+    }
+
   mynh.param("shifter", do_shifter_, false);
   if (do_shifter_)
     {
@@ -254,8 +284,12 @@ int IOadr::Shutdown()
 
 void IOadr::processOutput(const art_msgs::IOadrCommand::ConstPtr &cmd)
 {
+  // Coalesce bursts of commands into one pending set mask, applied
+  // in a single device transaction by GetSetRelays().  Merge in
+  // arrival order, so a later command clearing a bit overrides an
+  // earlier one setting it.
   relay_mask_ |= (cmd->relays_on | cmd->relays_off);
-  relay_bits_ |= cmd->relays_on;
+  relay_bits_ = (relay_bits_ | cmd->relays_on) & (uint8_t) ~cmd->relays_off;
   ROS_DEBUG("relay bits, mask = 0x%02x, 0x%02x", relay_bits_, relay_mask_);
 }
 
@@ -272,76 +306,55 @@ void IOadr::processShifter(const art_msgs::Shifter::ConstPtr &shifterIn)
   relay_mask_ = 0xff;                   // set all relay bits
 }
 
-int IOadr::poll_Analog_8bit(int ch)
+int IOadr::poll_Analog_8bit(int ch, int data)
 {
-  int data;
-  int rc = dev_->read_8bit_port(poll_list_[ch]->devnum, &data);
-  if (rc == 0)
-    {
-      // convert A/D input to voltage (8-bit converter with 5-volt range)
-      int i = poll_list_[ch]->field;
-      ioMsg_.voltages[i] = analog_volts(data, 5.0, 8);
-      ROS_DEBUG("%s input = %.3f volts (0x%04x)",
-		poll_list_[i]->name, ioMsg_.voltages[ch], data);
-    }
-  return rc;
+  // convert A/D input to voltage (8-bit converter with 5-volt range)
+  int i = poll_list_[ch]->field;
+  ioMsg_.voltages[i] = analog_volts(data, 5.0, 8);
+  ROS_DEBUG("%s input = %.3f volts (0x%04x)",
+	    poll_list_[i]->name, ioMsg_.voltages[ch], data);
+  return 0;
 }
 
-int IOadr::poll_Analog_10bit(int ch)
+int IOadr::poll_Analog_10bit(int ch, int data)
 {
-  int data;
-  int rc = dev_->read_10bit_port(poll_list_[ch]->devnum, &data);
-  if (rc == 0)
-    {
-      // convert A/D input to voltage (10-bit converter with 5-volt range)
-      int i = poll_list_[ch]->field;
-      ioMsg_.voltages[i] = analog_volts(data, 5.0, 10);
-      ROS_DEBUG("%s input = %.3f volts (0x%04x)",
-		poll_list_[ch]->name, ioMsg_.voltages[i], data);
-    }
-  return rc;
+  // convert A/D input to voltage (10-bit converter with 5-volt range)
+  int i = poll_list_[ch]->field;
+  ioMsg_.voltages[i] = analog_volts(data, 5.0, 10);
+  ROS_DEBUG("%s input = %.3f volts (0x%04x)",
+	    poll_list_[ch]->name, ioMsg_.voltages[i], data);
+  return 0;
 }
 
-int IOadr::poll_Digital(int ch)
+int IOadr::poll_Digital(int ch, int data)
 {
-  int data;
-  int rc = dev_->read_8bit_port(poll_list_[ch]->devnum, &data);
-  if (rc == 0)
-    {
-      ioMsg_.digitalB = data;
-    }
-  return rc;
+  ioMsg_.digitalB = data;
+  return 0;
 }
 
 // translate shifter indicator into shift request ID
 // (only used when do_shifter_ true and port is a real device)
-int IOadr::poll_ShifterInd(int ch)
+int IOadr::poll_ShifterInd(int ch, int data)
 {
-  // read shifter feedback from Digital port B
-  int data;
-  int rc = dev_->read_8bit_port(1, &data);
-  if (rc == 0)
-    {
-      // ignore the results unless the I/O was successful
-      uint8_t gear;
-      uint8_t digitalB_bits = ~data;
-      if (digitalB_bits & 0x80)
-	gear = art_msgs::Shifter::Park;
-      else if (digitalB_bits & 0x40)
-	gear = art_msgs::Shifter::Reverse;
-      else if (digitalB_bits & 0x20)
-	gear = art_msgs::Shifter::Neutral;
-      else if (digitalB_bits & 0x10)
-	gear = art_msgs::Shifter::Drive;
-      else
-        // there should only be one bit on at a time, so this should
-        // not occur
-	gear = art_msgs::Shifter::Reset;
+  // shifter feedback read from Digital port B
+  uint8_t gear;
+  uint8_t digitalB_bits = ~data;
+  if (digitalB_bits & 0x80)
+    gear = art_msgs::Shifter::Park;
+  else if (digitalB_bits & 0x40)
+    gear = art_msgs::Shifter::Reverse;
+  else if (digitalB_bits & 0x20)
+    gear = art_msgs::Shifter::Neutral;
+  else if (digitalB_bits & 0x10)
+    gear = art_msgs::Shifter::Drive;
+  else
+    // there should only be one bit on at a time, so this should
+    // not occur
+    gear = art_msgs::Shifter::Reset;
 
-      // save current gear number
-      shifter_gear_ = gear;
-    }
-  return rc;
+  // save current gear number
+  shifter_gear_ = gear;
+  return 0;
 }
 
 // poll device for pending input
@@ -352,18 +365,42 @@ void IOadr::PollDevice(void)
 {
   int rc = 0;
 
-  // First, poll any analog or digital ports that are configured.
+  // Batch all configured port reads into one scan list transaction,
+  // then run each entry's processing method on the data returned.
+  // Reading every port in one transaction halves the serial traffic
+  // and jitter of polling each one with its own round trip.
+  dev8x::scan_entry_t scan[IOADR_MAX_INPUTS];
+  int entry[IOADR_MAX_INPUTS];          // poll_list_ index per scan entry
+  int nscan = 0;
   for (unsigned i = 0; i < poll_list_.size(); ++i)
     {
-      poll_method_t poll_method = poll_list_[i]->function;
-      if (poll_method)
+      if (poll_list_[i]->function == NULL)
+        continue;
+      scan[nscan].ch = poll_list_[i]->devnum;
+      scan[nscan].ten_bit =
+        (poll_list_[i]->function == &IOadr::poll_Analog_10bit);
+      entry[nscan] = i;
+      ++nscan;
+    }
+
+  if (nscan > 0)
+    {
+      rc = dev_->read_scan_list(scan, nscan);
+      if (rc == 0)
         {
-          rc = (this->*poll_method)(i);
-          if (rc != 0)
-            ROS_ERROR_THROTTLE(100, "poll method returns %d", rc);
+          for (int i = 0; i < nscan; ++i)
+            {
+              poll_method_t poll_method = poll_list_[entry[i]]->function;
+              (this->*poll_method)(entry[i], scan[i].data);
+            }
         }
+      else
+        ROS_ERROR_THROTTLE(100, "scan list poll returns %d", rc);
     }
 
+  // smooth all analog channels with one filter bank update
+  analog_filter_.update(&ioMsg_.voltages[0]);
+
   // Get relay values, set new ones if requested.  Note: setting the
   // relays MUST be the last IOADR8x operation of the cycle.  After
   // that, the device seems to stay busy for a while.  It hangs if
@@ -393,17 +430,29 @@ void IOadr::PollDevice(void)
 // If we failed to set the relays this cycle, leave relay_mask_,
 // relay_bits_ alone and try again next time.
 //
+// Since nothing else writes the relays, ioMsg_.relays is maintained
+// as a cached image across successful writes and only read back from
+// the device when the image is unknown or due for verification.
+// That leaves most cycles with no relay serial traffic at all, so
+// the analog scans sharing the device are not delayed behind relay
+// round trips.
+//
 void IOadr::GetSetRelays(void)
 {
-  // get current relay settings
-  int rc = dev_->query_relays(&ioMsg_.relays);
-  if (rc != 0)				// device busy or not working?
-    return;
+  if (!relays_known_ || --relay_verify_countdown_ <= 0)
+    {
+      // get current relay settings
+      int rc = dev_->query_relays(&ioMsg_.relays);
+      if (rc != 0)			// device busy or not working?
+	return;
+      relays_known_ = true;
+      relay_verify_countdown_ = RELAY_VERIFY_CYCLES;
+    }
 
   if (relay_mask_)			// new setting requested?
     {
       uint8_t new_relays = (ioMsg_.relays & (~relay_mask_)) | relay_bits_;
-      rc = dev_->set_relays(new_relays);
+      int rc = dev_->set_relays(new_relays);
       if (rc == 0)			// successful?
 	{
 	  // The device requires a wait after setting all relays
@@ -414,7 +463,8 @@ void IOadr::GetSetRelays(void)
 	  // problem.
 
 	  relay_mask_ = relay_bits_ = 0;
-	  ioMsg_.relays = new_relays;
+	  ioMsg_.relays = new_relays;	// image freshly written
+	  relay_verify_countdown_ = RELAY_VERIFY_CYCLES;
           ROS_DEBUG("set relays to 0x%02x", ioMsg_.relays);
 	}
     }
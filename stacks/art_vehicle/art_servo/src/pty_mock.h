@@ -0,0 +1,290 @@
+/*
+ *  Description:  Scripted pseudo-terminal mock for servo unit tests.
+ *
+ *  Plays the role of a serial device on the master side of a
+ *  pseudo-terminal, so the servo drivers can be exercised through
+ *  their real tty I/O paths without hardware attached.
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+#ifndef _PTY_MOCK_H_
+#define _PTY_MOCK_H_
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+
+/** @brief scripted serial device behind a pseudo-terminal
+ *
+ *  A responder thread reads command lines from the master side of the
+ *  pseudo-terminal and answers them from a scripted response table,
+ *  optionally after a delay, so tests can measure driver round trips
+ *  and verify timeout recovery.  Tests open the driver under test on
+ *  slave_name() exactly as they would a real serial port.
+ *
+ *  Commands are lines terminated by carriage return or newline, as
+ *  all the servo controllers use.  Responses are written verbatim:
+ *  scripts must include the terminator the driver expects, and may
+ *  append garbage bytes to simulate line noise.
+ *
+ *  For binary or stateful protocols a responder callback can be set
+ *  instead of the table; it runs on the responder thread and may
+ *  sleep to simulate device latency.
+ */
+class PtyMock
+{
+public:
+
+  /** responder callback: examine one received command line and fill
+   *  in *response, which is written to the device verbatim (leave it
+   *  empty to drop the command).  Overrides the response table.
+   */
+  typedef void (*responder_t)(const std::string &command,
+                              std::string *response, void *arg);
+
+  PtyMock():
+    master_fd_(-1),
+    running_(false),
+    mute_(false),
+    responder_(NULL),
+    responder_arg_(NULL),
+    commands_seen_(0)
+  {}
+
+  ~PtyMock()
+  {
+    close();
+  }
+
+  /** Create the pseudo-terminal pair and start the responder thread.
+   *
+   *  @return true if successful, with slave_name() valid.
+   */
+  bool open(void)
+  {
+    master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd_ < 0)
+      return false;
+    if (grantpt(master_fd_) != 0
+        || unlockpt(master_fd_) != 0)
+      {
+        ::close(master_fd_);
+        master_fd_ = -1;
+        return false;
+      }
+    slave_name_ = ptsname(master_fd_);
+    running_ = true;
+    thread_.reset(new boost::thread(boost::bind(&PtyMock::responderThread,
+                                                this)));
+    return true;
+  }
+
+  /** Stop the responder thread and close the pseudo-terminal. */
+  void close(void)
+  {
+    if (running_)
+      {
+        running_ = false;
+        thread_->join();
+        thread_.reset();
+      }
+    if (master_fd_ >= 0)
+      {
+        ::close(master_fd_);
+        master_fd_ = -1;
+      }
+  }
+
+  /** device name for the driver under test to open */
+  const char *slave_name(void) {return slave_name_.c_str();}
+
+  /** Script a response for commands starting with @a match.
+   *
+   *  Entries are searched in the order added; the first match wins.
+   *
+   *  @param match command line prefix to match
+   *  @param response bytes written back, terminator included
+   *  @param delay_ms device latency before responding
+   *  @param drop_first number of matching commands to ignore first,
+   *         for exercising driver timeout and retry paths
+   */
+  void add_response(const std::string &match,
+                    const std::string &response,
+                    int delay_ms = 0,
+                    int drop_first = 0)
+  {
+    Entry entry;
+    entry.match = match;
+    entry.response = response;
+    entry.delay_ms = delay_ms;
+    entry.drop_remaining = drop_first;
+    boost::mutex::scoped_lock lock(mutex_);
+    entries_.push_back(entry);
+  }
+
+  /** Discard the response table, callback and mute state. */
+  void clear_script(void)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    entries_.clear();
+    responder_ = NULL;
+    responder_arg_ = NULL;
+    mute_ = false;
+  }
+
+  /** Set a responder callback, overriding the response table. */
+  void set_responder(responder_t responder, void *arg)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    responder_ = responder;
+    responder_arg_ = arg;
+  }
+
+  /** When muted, commands are read but never answered. */
+  void set_mute(bool mute)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    mute_ = mute;
+  }
+
+  /** Write unsolicited bytes to the driver, like device line noise. */
+  void inject(const std::string &bytes)
+  {
+    ssize_t res = write(master_fd_, bytes.c_str(), bytes.size());
+    (void) res;
+  }
+
+  /** number of command lines received so far */
+  int commands_seen(void)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return commands_seen_;
+  }
+
+private:
+
+  /** one scripted response */
+  struct Entry
+  {
+    std::string match;                  // command line prefix
+    std::string response;               // response bytes
+    int delay_ms;                       // response latency
+    int drop_remaining;                 // matches left to ignore
+  };
+
+  /** Answer one received command line. */
+  void handle_line(const std::string &line)
+  {
+    std::string response;
+    int delay_ms = 0;
+
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      ++commands_seen_;
+      if (mute_)
+        return;
+      if (responder_ != NULL)
+        {
+          responder_(line, &response, responder_arg_);
+        }
+      else
+        {
+          for (size_t i = 0; i < entries_.size(); ++i)
+            {
+              Entry &entry = entries_[i];
+              if (line.compare(0, entry.match.size(), entry.match) == 0)
+                {
+                  if (entry.drop_remaining > 0)
+                    {
+                      --entry.drop_remaining;
+                      return;           // simulate a lost response
+                    }
+                  response = entry.response;
+                  delay_ms = entry.delay_ms;
+                  break;
+                }
+            }
+        }
+    }
+
+    if (response.empty())
+      return;                           // unscripted command, no answer
+
+    // sleep outside the lock, so the test thread can keep scripting
+    if (delay_ms > 0)
+      boost::this_thread::sleep(boost::posix_time::milliseconds(delay_ms));
+
+    ssize_t res = write(master_fd_, response.c_str(), response.size());
+    (void) res;
+  }
+
+  /** Responder thread: accumulate command lines, answer each one. */
+  void responderThread(void)
+  {
+    std::string line;
+    while (running_)
+      {
+        struct pollfd fds[1];
+        fds[0].fd = master_fd_;
+        fds[0].events = POLLIN;
+        int retval = ::poll(fds, 1, 10);
+        if (retval <= 0)
+          continue;
+        if ((fds[0].revents & POLLIN) == 0)
+          {
+            // POLLHUP until the slave side has been opened
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            continue;
+          }
+
+        char rbuf[256];
+        int bytes = read(master_fd_, rbuf, sizeof(rbuf));
+        if (bytes <= 0)
+          {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+            continue;
+          }
+
+        for (int i = 0; i < bytes; ++i)
+          {
+            char c = rbuf[i];
+            if (c == '\r' || c == '\n')
+              {
+                if (!line.empty())
+                  {
+                    handle_line(line);
+                    line.clear();
+                  }
+              }
+            else
+              line += c;
+          }
+      }
+  }
+
+  int master_fd_;                       // master side of the pty
+  std::string slave_name_;              // slave device name
+  volatile bool running_;               // responder thread active
+  bool mute_;                           // ignore all commands
+  responder_t responder_;               // responder callback, if any
+  void *responder_arg_;                 // callback argument
+  int commands_seen_;                   // command lines received
+  std::vector<Entry> entries_;          // scripted response table
+  boost::mutex mutex_;                  // guards script and counters
+  boost::shared_ptr<boost::thread> thread_; // responder thread
+};
+
+#endif // _PTY_MOCK_H_
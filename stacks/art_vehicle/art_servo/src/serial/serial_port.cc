@@ -0,0 +1,402 @@
+/*
+ *  Description:  Shared asynchronous serial I/O for servo drivers.
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Common serial I/O implementation for the art_servo drivers.
+
+     @author Jack O'Quin
+
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "serial_port.h"
+
+/////////////////////////////////////////////////////////////////
+// SerialPort
+/////////////////////////////////////////////////////////////////
+
+SerialPort::SerialPort():
+  fd_(-1),
+  have_tty_(false),
+  rx_head_(0),
+  rx_tail_(0),
+  tx_offset_(0),
+  awaiting_response_(false),
+  callback_(NULL),
+  callback_arg_(NULL)
+{}
+
+SerialPort::~SerialPort()
+{
+  if (fd_ >= 0)
+    Close();
+}
+
+int SerialPort::Open(const char *device, int flags)
+{
+  int rc = 0;
+  have_tty_ = (strcmp(device, "/dev/null") != 0);
+  devName_ = device;
+  fd_ = open(device, flags);
+  if (fd_ < 0)
+    {
+      rc = errno;
+      ROS_ERROR("SerialPort::Open(%s) error: %s", device, strerror(rc));
+    }
+  else
+    {
+      ROS_DEBUG("SerialPort::Open(%s) successful", device);
+    }
+  return rc;
+}
+
+int SerialPort::Close(void)
+{
+  int rc = close(fd_);
+  fd_ = -1;
+  if (rc < 0)
+    {
+      rc = errno;
+      ROS_ERROR("SerialPort::Close() error: %s", strerror(rc));
+    }
+  else
+    rc = 0;
+  return rc;
+}
+
+int SerialPort::configure_raw(int cflags, int iflags)
+{
+  if (!have_tty_) return 0;             // no config for /dev/null
+
+  struct termios newtio;
+  memset(&newtio, 0, sizeof(newtio));
+
+  // CLOCAL: local connection, no modem control
+  // CREAD:  enable receiving characters
+  newtio.c_cflag = cflags | CLOCAL | CREAD;
+
+  // IGNPAR: ignore bytes with parity errors, otherwise make the
+  // device raw (no other input processing)
+  newtio.c_iflag = iflags | IGNPAR;
+  newtio.c_oflag = 0;
+  newtio.c_lflag = 0;
+
+  // the poll loop never blocks in read()
+  newtio.c_cc[VTIME] = 0;
+  newtio.c_cc[VMIN] = 0;
+
+  tcflush(fd_, TCIOFLUSH);
+  int rc = tcsetattr(fd_, TCSANOW, &newtio);
+  if (rc < 0)
+    {
+      rc = errno;
+      ROS_ERROR("tcsetattr() error: %s", strerror(rc));
+    }
+  return rc;
+}
+
+size_t SerialPort::available(void)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return ring_used();
+}
+
+int SerialPort::get_byte(void)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  if (ring_used() == 0)
+    return -1;
+  return rx_ring_[rx_tail_++ & (RX_RING_SIZE-1)];
+}
+
+int SerialPort::get_line(char *buf, size_t nbytes)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+
+  // skip terminators left over from the previous line
+  while (ring_used() > 0)
+    {
+      uint8_t c = rx_ring_[rx_tail_ & (RX_RING_SIZE-1)];
+      if (c != '\r' && c != '\n')
+        break;
+      ++rx_tail_;
+    }
+
+  // find the end of a complete line
+  size_t end;
+  for (end = rx_tail_; end != rx_head_; ++end)
+    {
+      uint8_t c = rx_ring_[end & (RX_RING_SIZE-1)];
+      if (c == '\r' || c == '\n')
+        break;
+    }
+  if (end == rx_head_)
+    return -1;                          // line still incomplete
+
+  // copy the line out, truncating if the buffer is too small
+  int linelen = 0;
+  while (rx_tail_ != end)
+    {
+      uint8_t c = rx_ring_[rx_tail_++ & (RX_RING_SIZE-1)];
+      if ((size_t) linelen < nbytes-1)
+        buf[linelen++] = c;
+    }
+  ++rx_tail_;                           // consume the terminator
+  buf[linelen] = '\0';
+  return linelen;
+}
+
+void SerialPort::flush_input(void)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  rx_tail_ = rx_head_;
+}
+
+int SerialPort::queue_write(const void *data, size_t len)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  if (tx_queue_.size() >= MAX_TX_QUEUED)
+    {
+      ROS_ERROR_THROTTLE(100, "%s: output queue full, command dropped",
+                         devName_.c_str());
+      return ENOSPC;
+    }
+  tx_queue_.push_back(std::string((const char *) data, len));
+  return 0;
+}
+
+bool SerialPort::output_pending(void)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return !tx_queue_.empty();
+}
+
+void SerialPort::mark_command(void)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  mark_time_ = ros::WallTime::now();
+  awaiting_response_ = true;
+}
+
+void SerialPort::set_input_callback(input_callback_t callback, void *arg)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  callback_ = callback;
+  callback_arg_ = arg;
+}
+
+int SerialPort::handle_input(void)
+{
+  input_callback_t callback = NULL;
+  void *callback_arg = NULL;
+  int added = 0;
+
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    for (;;)
+      {
+        uint8_t rbuf[256];
+        int bytes = read(fd_, rbuf, sizeof(rbuf));
+        if (bytes <= 0)
+          break;                        // nothing more available
+        for (int i = 0; i < bytes; ++i)
+          {
+            if (ring_used() >= RX_RING_SIZE)
+              {
+                // overrun: drop the oldest byte, the newest data
+                // reflects the current device state
+                ROS_WARN_THROTTLE(100, "%s: receive ring overrun",
+                                  devName_.c_str());
+                ++rx_tail_;
+              }
+            rx_ring_[rx_head_++ & (RX_RING_SIZE-1)] = rbuf[i];
+          }
+        added += bytes;
+      }
+
+    if (added > 0)
+      {
+        if (awaiting_response_)
+          {
+            latency_.add((ros::WallTime::now() - mark_time_).toSec());
+            awaiting_response_ = false;
+          }
+        callback = callback_;
+        callback_arg = callback_arg_;
+      }
+  }
+
+  // run the callback outside the lock, it will consume the ring
+  if (callback != NULL)
+    callback(this, callback_arg);
+
+  return added;
+}
+
+int SerialPort::handle_output(void)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  if (tx_queue_.empty())
+    return 0;
+
+  // gather the queued buffers into one vectored write
+  struct iovec iov[8];
+  int niov = 0;
+  for (std::deque<std::string>::iterator it = tx_queue_.begin();
+       it != tx_queue_.end() && niov < (int) (sizeof(iov)/sizeof(iov[0]));
+       ++it, ++niov)
+    {
+      size_t skip = (niov == 0)? tx_offset_: 0;
+      iov[niov].iov_base = (void *) (it->data() + skip);
+      iov[niov].iov_len = it->size() - skip;
+    }
+
+  int res = writev(fd_, iov, niov);
+  if (res < 0)
+    {
+      if (errno != EAGAIN)
+        ROS_ERROR_THROTTLE(100, "%s: writev() error: %s",
+                           devName_.c_str(), strerror(errno));
+      return 0;
+    }
+
+  // pop the buffers the write consumed
+  int sent = res;
+  while (res > 0 && !tx_queue_.empty())
+    {
+      int front_left = tx_queue_.front().size() - tx_offset_;
+      if (res >= front_left)
+        {
+          res -= front_left;
+          tx_queue_.pop_front();
+          tx_offset_ = 0;
+        }
+      else
+        {
+          tx_offset_ += res;            // partial write
+          res = 0;
+        }
+    }
+  return sent;
+}
+
+/////////////////////////////////////////////////////////////////
+// SerialPoller
+/////////////////////////////////////////////////////////////////
+
+SerialPoller::SerialPoller():
+  running_(false)
+{}
+
+SerialPoller::~SerialPoller()
+{
+  stop();
+}
+
+void SerialPoller::add(SerialPort *port)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  ports_.push_back(port);
+}
+
+void SerialPoller::remove(SerialPort *port)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  for (size_t i = 0; i < ports_.size(); ++i)
+    {
+      if (ports_[i] == port)
+        {
+          ports_.erase(ports_.begin() + i);
+          return;
+        }
+    }
+}
+
+void SerialPoller::start(void)
+{
+  if (running_)
+    return;
+  running_ = true;
+  thread_.reset(new boost::thread(boost::bind(&SerialPoller::pollThread,
+                                              this)));
+}
+
+void SerialPoller::stop(void)
+{
+  if (!running_)
+    return;
+  running_ = false;
+  thread_->join();
+  thread_.reset();
+}
+
+/** Poll thread: multiplex every registered port.
+ *
+ *  Each port is polled for input continuously and for output when it
+ *  has queued bytes.  The timeout keeps the loop responsive to
+ *  start/stop and to output queued between wakeups.
+ */
+void SerialPoller::pollThread(void)
+{
+  while (running_)
+    {
+      // snapshot the port list, ports may be added from other threads
+      std::vector<SerialPort *> ports;
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        ports = ports_;
+      }
+
+      if (ports.empty())
+        {
+          boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+          continue;
+        }
+
+      std::vector<struct pollfd> fds(ports.size());
+      for (size_t i = 0; i < ports.size(); ++i)
+        {
+          fds[i].fd = ports[i]->fd();
+          fds[i].events = POLLIN;
+          if (ports[i]->output_pending())
+            fds[i].events |= POLLOUT;
+          fds[i].revents = 0;
+        }
+
+      int retval = ::poll(&fds[0], fds.size(), 10);
+      if (retval < 0)
+        {
+          if (errno != EINTR)
+            ROS_ERROR_THROTTLE(100, "poll() error: %s", strerror(errno));
+          continue;
+        }
+      if (retval == 0)
+        continue;                       // timeout, nothing ready
+
+      for (size_t i = 0; i < ports.size(); ++i)
+        {
+          if (fds[i].revents & POLLOUT)
+            ports[i]->handle_output();
+          if (fds[i].revents & POLLIN)
+            ports[i]->handle_input();
+          if (fds[i].revents & (POLLERR|POLLHUP|POLLNVAL))
+            ROS_WARN_THROTTLE(100, "%s: device error on poll",
+                              ports[i]->devName());
+        }
+    }
+}
@@ -0,0 +1,274 @@
+/*
+ *  Description:  Shared asynchronous serial I/O for servo drivers.
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Common serial I/O foundation for the art_servo device drivers.
+
+     Each driver currently opens and configures its own serial port
+     and blocks in its own poll/read/retry loop.  This library factors
+     that handling into one place: a SerialPort does non-blocking
+     ring-buffered reads and vectored writes with per-device latency
+     accounting, and a SerialPoller multiplexes any number of ports in
+     a single thread, so the drivers can move to asynchronous I/O on
+     one tested foundation.
+
+     @author Jack O'Quin
+
+ */
+
+#ifndef _SERIAL_PORT_H_
+#define _SERIAL_PORT_H_
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <ros/ros.h>
+
+/** @brief accumulated round-trip latency statistics for one device */
+class LatencyStats
+{
+public:
+
+  LatencyStats(): count_(0), total_(0.0), worst_(0.0) {}
+
+  /** Accumulate one round trip. */
+  void add(double sec)
+  {
+    ++count_;
+    total_ += sec;
+    if (sec > worst_)
+      worst_ = sec;
+  }
+
+  unsigned long count(void) const {return count_;}
+  double mean_ms(void) const
+  {return (count_ == 0)? 0.0: 1000.0 * total_ / count_;}
+  double worst_ms(void) const {return 1000.0 * worst_;}
+
+  /** Log the accumulated statistics. */
+  void report(const char *label) const
+  {
+    if (count_ == 0)
+      return;
+    ROS_INFO("%s: %lu round trips, mean %.3f ms, worst %.3f ms",
+             label, count_, mean_ms(), worst_ms());
+  }
+
+private:
+
+  unsigned long count_;                 // round trips accumulated
+  double total_;                        // total seconds
+  double worst_;                        // worst round trip (seconds)
+};
+
+/** @brief one non-blocking serial port
+ *
+ *  The poll loop fills a receive ring buffer and flushes the queued
+ *  output whenever the device accepts it; the driver consumes
+ *  complete lines and queues commands without ever blocking.  Reads
+ *  and writes never sleep: an incomplete line simply stays in the
+ *  ring until a later cycle.
+ *
+ *  The ring buffer is guarded by a mutex, so the driver may run on a
+ *  different thread than the SerialPoller dispatching the port.
+ */
+class SerialPort
+{
+public:
+
+  /** input callback: runs on the poller thread after new bytes have
+   *  been added to the ring
+   */
+  typedef void (*input_callback_t)(SerialPort *port, void *arg);
+
+  SerialPort();
+  ~SerialPort();
+
+  /** Open the serial device non-blocking.
+   *
+   *  @param device serial port name ("/dev/null" for testing)
+   *  @param flags open() flags
+   *  @return 0 if successful, errno value otherwise
+   */
+  int Open(const char *device, int flags = (O_RDWR|O_NOCTTY|O_NONBLOCK));
+
+  /** Close the serial device.
+   *
+   *  @return 0 if successful, errno value otherwise
+   */
+  int Close(void);
+
+  /** Configure the raw serial port.
+   *
+   *  Raw mode minimizes processing in the kernel tty driver, which
+   *  might get in the way of an accurate perception of the true state
+   *  of the device.
+   *
+   *  @param cflags c_cflag bits in addition to CLOCAL|CREAD,
+   *         normally the baud rate and CS8
+   *  @param iflags c_iflag bits in addition to IGNPAR
+   *  @return 0 if successful, errno value otherwise
+   */
+  int configure_raw(int cflags, int iflags);
+
+  int fd(void) const {return fd_;}
+  bool have_tty(void) const {return have_tty_;}
+  const char *devName(void) const {return devName_.c_str();}
+
+  // reading: the poll loop fills the ring, the driver consumes it
+
+  /** bytes waiting in the receive ring */
+  size_t available(void);
+
+  /** Consume the next received byte.
+   *
+   *  @return the byte, -1 if the ring is empty
+   */
+  int get_byte(void);
+
+  /** Consume one complete received line.
+   *
+   *  Lines are terminated by carriage return or newline, as all the
+   *  servo controllers use; leading terminators are skipped.  An
+   *  incomplete line is left in the ring for a later cycle.
+   *
+   *  @param buf returned line, NUL-terminated, terminator removed,
+   *         truncated if longer than the buffer
+   *  @param nbytes size of @a buf
+   *  @return line length, -1 if no complete line has arrived
+   */
+  int get_line(char *buf, size_t nbytes);
+
+  /** Discard all received bytes. */
+  void flush_input(void);
+
+  // writing
+
+  /** Queue bytes for the poll loop to write.
+   *
+   *  Buffers queued in one cycle are flushed together with a single
+   *  vectored write when the device accepts output.
+   *
+   *  @param data bytes to send
+   *  @param len number of bytes
+   *  @return 0 if queued, ENOSPC if the output queue is full
+   */
+  int queue_write(const void *data, size_t len);
+
+  /** true if queued output has not yet been flushed */
+  bool output_pending(void);
+
+  /** Mark the start of a command round trip.
+   *
+   *  The next received byte completes the round trip, accumulating
+   *  its latency for this device.
+   */
+  void mark_command(void);
+
+  /** accumulated round-trip latency of this device */
+  const LatencyStats &latency(void) const {return latency_;}
+
+  /** Set a callback to run when input arrives. */
+  void set_input_callback(input_callback_t callback, void *arg);
+
+  // poll loop interface, called by SerialPoller
+
+  /** Read whatever the device has sent into the ring.
+   *
+   *  @return number of bytes added, 0 if none available
+   */
+  int handle_input(void);
+
+  /** Flush the output queue with one vectored write.
+   *
+   *  @return number of bytes written, 0 if the device is busy
+   */
+  int handle_output(void);
+
+private:
+
+  // receive ring size: must be a power of two.  Big enough for every
+  // response a controller can send between driver cycles.
+  static const size_t RX_RING_SIZE = 1024;
+
+  // limit queued output, a stuck device must not grow the queue
+  // without bound
+  static const size_t MAX_TX_QUEUED = 64;
+
+  size_t ring_used(void) const {return rx_head_ - rx_tail_;}
+
+  int fd_;                              // serial port file descriptor
+  bool have_tty_;                       // real device, not /dev/null
+  std::string devName_;                 // device name for messages
+
+  boost::mutex mutex_;                  // guards all state below
+
+  uint8_t rx_ring_[RX_RING_SIZE];       // receive ring buffer
+  size_t rx_head_;                      // next slot to fill
+  size_t rx_tail_;                      // next byte to consume
+
+  std::deque<std::string> tx_queue_;    // queued output buffers
+  size_t tx_offset_;                    // bytes of front buffer sent
+
+  LatencyStats latency_;                // round-trip accounting
+  ros::WallTime mark_time_;             // pending command mark
+  bool awaiting_response_;              // mark set, no response yet
+
+  input_callback_t callback_;           // input callback, if any
+  void *callback_arg_;                  // callback argument
+};
+
+/** @brief poll loop multiplexing serial ports in one thread
+ *
+ *  Every added port is polled for input continuously and for output
+ *  whenever it has queued bytes.  One thread serves all the servo
+ *  devices, replacing the per-driver blocking loops.
+ */
+class SerialPoller
+{
+public:
+
+  SerialPoller();
+  ~SerialPoller();
+
+  /** Add a port to the poll loop.  The caller retains ownership and
+   *  must remove the port before closing it.
+   */
+  void add(SerialPort *port);
+
+  /** Remove a port from the poll loop. */
+  void remove(SerialPort *port);
+
+  /** Start the poll thread. */
+  void start(void);
+
+  /** Stop the poll thread. */
+  void stop(void);
+
+private:
+
+  void pollThread(void);
+
+  std::vector<SerialPort *> ports_;     // ports being multiplexed
+  boost::mutex mutex_;                  // guards ports_
+  volatile bool running_;               // poll thread active
+  boost::shared_ptr<boost::thread> thread_; // poll thread
+};
+
+#endif // _SERIAL_PORT_H_
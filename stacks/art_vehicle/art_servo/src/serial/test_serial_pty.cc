@@ -0,0 +1,191 @@
+/*
+ *  ART shared serial I/O library pseudo-terminal unit test
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Exercise SerialPort and SerialPoller against scripted
+     pseudo-terminal mocks: non-blocking line round trips through the
+     receive ring, vectored write coalescing, latency accounting, and
+     two devices multiplexed by one poll thread.
+
+     @author Jack O'Quin
+
+ */
+
+#include <termios.h>
+
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include "../pty_mock.h"
+#include "serial_port.h"
+
+namespace
+{
+  PtyMock *pty = NULL;
+  SerialPort *port = NULL;
+  SerialPoller *poller = NULL;
+
+  /** Queue one command line, marking the round trip. */
+  void send_command(SerialPort *p, const char *cmd)
+  {
+    p->mark_command();
+    EXPECT_EQ(0, p->queue_write(cmd, strlen(cmd)));
+  }
+
+  /** Wait for a complete response line, without ever blocking in the
+   *  port itself.
+   */
+  int wait_line(SerialPort *p, char *buf, size_t nbytes, int timeout_ms)
+  {
+    for (int ms = 0; ms < timeout_ms; ms += 5)
+      {
+        int len = p->get_line(buf, nbytes);
+        if (len >= 0)
+          return len;
+        usleep(5*1000);
+      }
+    return -1;
+  }
+}
+
+class SerialPty: public testing::Test
+{
+protected:
+
+  static void SetUpTestCase()
+  {
+    pty = new PtyMock();
+    ASSERT_TRUE(pty->open());
+
+    port = new SerialPort();
+    ASSERT_EQ(0, port->Open(pty->slave_name()));
+    ASSERT_EQ(0, port->configure_raw(B57600|CS8, 0));
+
+    poller = new SerialPoller();
+    poller->add(port);
+    poller->start();
+  }
+
+  static void TearDownTestCase()
+  {
+    poller->stop();
+    poller->remove(port);
+    delete poller;
+    poller = NULL;
+    port->Close();
+    delete port;
+    port = NULL;
+    delete pty;
+    pty = NULL;
+  }
+
+  virtual void SetUp()
+  {
+    pty->clear_script();
+    port->flush_input();
+  }
+};
+
+// one command line out, one response line back through the ring
+TEST_F(SerialPty, lineRoundTrip)
+{
+  pty->add_response("RSP", "1234\r");
+
+  send_command(port, "RSP\r");
+  char line[48];
+  ASSERT_EQ(4, wait_line(port, line, sizeof(line), 500));
+  EXPECT_STREQ("1234", line);
+  EXPECT_EQ(0u, port->available());     // terminator consumed too
+}
+
+// an unanswered command never blocks the driver cycle
+TEST_F(SerialPty, unresponsiveDeviceNonBlocking)
+{
+  pty->set_mute(true);
+
+  ros::WallTime start = ros::WallTime::now();
+  send_command(port, "RSP\r");
+  char line[48];
+  EXPECT_EQ(-1, port->get_line(line, sizeof(line)));
+  double ms = (ros::WallTime::now() - start).toSec() * 1000.0;
+  EXPECT_LT(ms, 10.0);
+}
+
+// buffers queued together reach the device in order, and the scripted
+// responses come back line by line
+TEST_F(SerialPty, vectoredWritesInOrder)
+{
+  pty->add_response("AAA", "a\r");
+  pty->add_response("BBB", "b\r");
+  pty->add_response("CCC", "c\r");
+
+  int seen = pty->commands_seen();
+  EXPECT_EQ(0, port->queue_write("AAA\r", 4));
+  EXPECT_EQ(0, port->queue_write("BBB\r", 4));
+  EXPECT_EQ(0, port->queue_write("CCC\r", 4));
+
+  char line[48];
+  ASSERT_EQ(1, wait_line(port, line, sizeof(line), 500));
+  EXPECT_STREQ("a", line);
+  ASSERT_EQ(1, wait_line(port, line, sizeof(line), 500));
+  EXPECT_STREQ("b", line);
+  ASSERT_EQ(1, wait_line(port, line, sizeof(line), 500));
+  EXPECT_STREQ("c", line);
+  EXPECT_EQ(seen + 3, pty->commands_seen());
+}
+
+// round-trip latency accounting reflects scripted device delays
+TEST_F(SerialPty, latencyAccounting)
+{
+  pty->add_response("SLOW", "ok\r", 20);
+
+  unsigned long count = port->latency().count();
+  send_command(port, "SLOW\r");
+  char line[48];
+  ASSERT_EQ(2, wait_line(port, line, sizeof(line), 500));
+
+  ASSERT_EQ(count + 1, port->latency().count());
+  EXPECT_GE(port->latency().worst_ms(), 15.0);
+}
+
+// a second device shares the same poll thread
+TEST_F(SerialPty, multiplexTwoPorts)
+{
+  pty->add_response("ONE", "first\r");
+
+  PtyMock pty2;
+  ASSERT_TRUE(pty2.open());
+  pty2.add_response("TWO", "second\r");
+
+  SerialPort port2;
+  ASSERT_EQ(0, port2.Open(pty2.slave_name()));
+  ASSERT_EQ(0, port2.configure_raw(B57600|CS8, 0));
+  poller->add(&port2);
+
+  send_command(port, "ONE\r");
+  send_command(&port2, "TWO\r");
+
+  char line[48];
+  ASSERT_EQ(5, wait_line(port, line, sizeof(line), 500));
+  EXPECT_STREQ("first", line);
+  ASSERT_EQ(6, wait_line(&port2, line, sizeof(line), 500));
+  EXPECT_STREQ("second", line);
+
+  poller->remove(&port2);
+  port2.Close();
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "test_serial_pty");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -32,6 +32,9 @@ int64_t devsteer::GetTime()
 }
 
 devsteer::devsteer(int32_t center):
+  subcycles_(1),
+  last_sim_time_(0.0),
+  cmd_angle_(0.0),
   req_angle_(0.0),
   center_ticks_(center)                 // for unit testing
 {}
@@ -52,7 +55,7 @@ int devsteer::Open()
   rc = configure_steering();
   if (rc != 0) goto fail;
 
-  req_angle_ = starting_angle_ = 0.0;	// initialize position
+  cmd_angle_ = req_angle_ = starting_angle_ = 0.0; // initialize position
   starting_ticks_ = 0;			//   assuming wheel is centered
 
   return rc;
@@ -99,6 +102,18 @@ int devsteer::Configure()
   private_nh.getParam("steering_rate", steering_rate_);
   ROS_INFO("steering rate is %.2f degrees/sec.", steering_rate_);
 
+  // micro-interpolation: stream intermediate setpoints to the
+  // controller at a multiple of the nominal driver cycle rate
+  interpolation_rate_ = 0.0;
+  private_nh.getParam("interpolation_rate", interpolation_rate_);
+  subcycles_ = 1;
+  if (interpolation_rate_ > art_msgs::ArtHertz::STEERING)
+    subcycles_ = (int) rint(interpolation_rate_
+                            / art_msgs::ArtHertz::STEERING);
+  if (subcycles_ > 1)
+    ROS_INFO("interpolating %d setpoints per cycle (%.1f Hz)",
+             subcycles_, subcycles_ * art_msgs::ArtHertz::STEERING);
+
   return 0;
 }
 
@@ -160,22 +175,30 @@ int devsteer::get_angle(float &degrees)
     }
   else
     {
-      // simulate steering motion as a constant angular velocity
+      // Simulate steering motion as a constant angular velocity,
+      // integrated in closed form over elapsed simulated time
+      // instead of a fixed step per call.  The trajectory is exact
+      // for any step size, so time-compressed runs advancing the
+      // clock in macro steps produce identical wheel positions.
+      double now = ros::Time::now().toSec();
+      double dt = (last_sim_time_ > 0.0?
+                   now - last_sim_time_:
+                   1.0 / art_msgs::ArtHertz::STEERING);
+      last_sim_time_ = now;
+
       float remaining_angle = req_angle_ - degrees;
-      float degrees_per_cycle = (steering_rate_ /
-                                 art_msgs::ArtHertz::STEERING);
+      float max_step = steering_rate_ * dt;
 
-      DBG("remaining angle %.3f, degrees per cycle %.3f",
-          remaining_angle, degrees_per_cycle);
+      DBG("remaining angle %.3f, max step %.3f",
+          remaining_angle, max_step);
 
-      if (fabs(remaining_angle) <= degrees_per_cycle)
+      if (fabs(remaining_angle) <= max_step)
 	{
 	  degrees = req_angle_;
 	}
       else
 	{
-	  degrees += ((remaining_angle >= 0.0)?
-		      degrees_per_cycle: -degrees_per_cycle);
+	  degrees += ((remaining_angle >= 0.0)? max_step: -max_step);
 	}
       ROS_DEBUG("simulated angle = %.2f degrees", degrees);
 
@@ -339,7 +362,7 @@ int devsteer::set_initial_angle(float position)
   // command has not been issued, this does not cause any movement.
   // Subsequently, encoder position zero will correspond to wheel
   // angle zero.
-  starting_angle_ = position;
+  cmd_angle_ = starting_angle_ = position;
   center_ticks_ = 0;			// TODO: remove obsolete variable?
   diag_msg_.center_ticks = center_ticks_;
   starting_ticks_ = degrees2ticks(starting_angle_);
@@ -374,10 +397,43 @@ int devsteer::set_initial_angle(float position)
   return rc;
 }
 
+/** stream one interpolated setpoint toward the requested angle
+ *
+ *  Called several times per driver cycle in micro-interpolation mode.
+ *  Instead of commanding the target position in one jump, walk the
+ *  controller toward it at the configured steering rate.  The
+ *  smaller, more frequent position steps smooth the staircase
+ *  response of whole-cycle updates and reduce torque spikes in the
+ *  steering linkage.
+ *
+ *  @return 0 if successful or nothing to do, errno value otherwise.
+ */
+int devsteer::servo_step(void)
+{
+  if (subcycles_ <= 1)			// interpolation disabled?
+    return 0;
+
+  float remaining = req_angle_ - cmd_angle_;
+  if (remaining == 0.0)			// ramp already complete?
+    return 0;
+
+  // angle change per interpolation step at the configured rate
+  float step = steering_rate_ / (subcycles_ * art_msgs::ArtHertz::STEERING);
+  if (fabs(remaining) <= step)
+    cmd_angle_ = req_angle_;		// final step of the ramp
+  else
+    cmd_angle_ += ((remaining >= 0.0)? step: -step);
+
+  return encoder_goto(cmd_angle_);
+}
+
 int devsteer::steering_absolute(float position)
 {
   DBG("steering_absolute(%.3f)", position);
   req_angle_ = limit_travel(position);
+  if (subcycles_ > 1)			// micro-interpolation mode?
+    return servo_step();		// first step toward new target
+  cmd_angle_ = req_angle_;
   return encoder_goto(req_angle_);
 }
  
@@ -32,6 +32,13 @@ Configuration options for steering servo device:
   - rate at which steering wheel turns (degrees/sec)
   - default: 14.5
 
+- interpolation_rate (float)
+  - rate at which interpolated setpoints stream to the controller (Hz),
+    smoothing the staircase response of whole-cycle position updates
+  - if no higher than the nominal cycle rate, each position request is
+    sent directly in one command
+  - default: 0.0 (no interpolation)
+
 Training mode collects data while a human driver operates the vehicle.
 */
 /** @} */
@@ -83,10 +90,14 @@ public:
   int	check_status(void);
   int	get_angle(float &degrees);
   void  publish_diag(const ros::Publisher &diag_pub);
+  int	servo_step(void);
   int	set_initial_angle(float position);
   int	steering_absolute(float position);
   int	steering_relative(float position);
 
+  // interpolation steps per nominal driver cycle (one if disabled)
+  inline int subcycles(void) {return subcycles_;}
+
   // convert steering angle to encoder ticks
   inline int32_t degrees2ticks(float degrees)
   {
@@ -109,7 +120,11 @@ public:
   bool	training_;                // use training mode
   bool	simulate_moving_errors_;  // simulate intermittent moving errors
   double steering_rate_;          // steering velocity (deg/sec)
+  double interpolation_rate_;     // setpoint streaming rate (Hz)
 
+  int	subcycles_;                    // interpolation steps per cycle
+  double last_sim_time_;               // last simulated motion update
+  float	cmd_angle_;                    // last angle sent to controller
   float	req_angle_;                    // requested angle (absolute)
   float	starting_angle_;               // starting wheel angle
   int32_t starting_ticks_;             // starting wheel encoder ticks
@@ -12,6 +12,7 @@
 
 #include <art_msgs/ArtHertz.h>
 #include <art/polynomial.h>
+#include <art/realtime.h>
 
 #include <art_msgs/SteeringCommand.h>
 #include <art_msgs/SteeringState.h>
@@ -71,6 +72,14 @@ Parameters:
 
 static float const epsilon = 0.01;	// "close enough" in degrees
 
+// State messages are published when something changed, plus a
+// heartbeat so subscribers can still detect a dead driver.  The
+// heartbeat must stay well inside the pilot's 0.5 second device
+// timeout.  Diagnostics cost an extra serial round trip to read the
+// encoder, so they go out on their own slower cadence.
+static const double HEARTBEAT_PERIOD = 0.2;	// state heartbeat (sec)
+static const double DIAG_PERIOD = 1.0;		// diagnostics interval (sec)
+
 #define CLASS "ArtSteer"
 
 class ArtSteer
@@ -105,6 +114,12 @@ private:
   ros::Publisher  steering_state_;      // steering/state
   ros::Publisher  steering_diag_;	// steering/diag
 
+  // preallocated state message; retains the last published values
+  // for change detection
+  art_msgs::SteeringState state_msg_;
+  ros::Time last_pub_time_;		// last state publication
+  ros::Time last_diag_time_;		// last diagnostics publication
+
   float	steering_angle_;                // current steering angle (degrees)
   float	steering_sensor_;		// current steering sensor reading
   double cur_sensor_time_;	        // current sensor data time (sec)
@@ -139,6 +154,7 @@ private:
   boost::shared_ptr<Polynomial> apoly_; // angle to voltage conversion
 #if defined(USE_VOLTAGE_POLYNOMIAL)
   boost::shared_ptr<Polynomial> vpoly_; // voltage to angle conversion
+  PolyTable vtable_;                    // vpoly_ sampled at startup
 #else
   std::vector<double> c_;               // volts2degrees() coefficients
 #endif
@@ -147,7 +163,7 @@ private:
   float inline volts2degrees(float volts)
   {
 #if defined(USE_VOLTAGE_POLYNOMIAL)
-    return vpoly_->value(volts);        // use polynomial
+    return vtable_.value(volts);        // one table read
 #else
     // non-linear curve fit
     return c_[0] + c_[1]*volts + c_[2]*cos(c_[3]*volts+c_[4]);
@@ -184,6 +200,12 @@ ArtSteer::ArtSteer():
   vpoly_->add_coef(-30.0634102);        // default coefficient of v
   vpoly_->add_coef(2.14785486);		// default coefficient of v**2
   //vpoly_->configure(cf, section);	// fill in .cfg values
+
+  // Sample the conversion polynomial over the sensor's voltage range,
+  // so each reading converts with one interpolated table look-up.
+  if (!vtable_.create(vpoly_.get(), 0.0, 5.0))
+    ROS_WARN("voltage conversion not monotone, "
+             "evaluating polynomial directly");
 #else
   c_.clear();				// fill in volts2degrees()
   c_.push_back(52.25490152);		//  coefficients
@@ -370,33 +392,73 @@ void ArtSteer::read_wheel_angle(void)
     }
 }
 
-/** publish current device status */
+/** publish current device status
+ *
+ *  Change-triggered: the state message goes out when the driver
+ *  state, angle or sensor reading changed, or after the heartbeat
+ *  period without a change.  Diagnostics need an extra serial round
+ *  trip to read the encoder, so they follow their own slower cadence
+ *  (and any driver state change) instead of loading the command path
+ *  every cycle.
+ */
 void ArtSteer::PublishStatus(void)
 {
-  art_msgs::SteeringState msg;         // steering state message
+  ros::Time now = ros::Time::now();
 
-  msg.driver.state = driver_state_;
-  msg.angle = steering_angle_;
-  msg.sensor = steering_sensor_;
-  msg.header.stamp = ros::Time::now();
-  steering_state_.publish(msg);
+  bool state_changed = (state_msg_.driver.state != driver_state_);
+  bool changed = (state_changed
+                  || fabs(state_msg_.angle - steering_angle_) > epsilon
+                  || fabs(state_msg_.sensor - steering_sensor_) > epsilon);
 
-  if (driver_state_ != DriverState::CLOSED)
+  if (changed || (now - last_pub_time_).toSec() >= HEARTBEAT_PERIOD)
+    {
+      state_msg_.driver.state = driver_state_;
+      state_msg_.angle = steering_angle_;
+      state_msg_.sensor = steering_sensor_;
+      state_msg_.header.stamp = now;
+      steering_state_.publish(state_msg_);
+      last_pub_time_ = now;
+    }
+
+  if (driver_state_ != DriverState::CLOSED
+      && (state_changed
+          || (now - last_diag_time_).toSec() >= DIAG_PERIOD))
     {
       // publish driver diagnostic info
       // (TODO: use ROS diagnostics package)
       dev_->publish_diag(steering_diag_);
+      last_diag_time_ = now;
     }
 }
 
 // Main function for device thread
 // TODO rationalize these states and bits
-void ArtSteer::run() 
+void ArtSteer::run()
 {
-  ros::Rate cycle(art_msgs::ArtHertz::STEERING); // set driver cycle rate
+  // Cycle at the device interpolation rate.  In micro-interpolation
+  // mode that is a multiple of the nominal driver rate; commands,
+  // status checks and state publication still happen once per nominal
+  // cycle, the extra iterations only stream interpolated setpoints to
+  // the controller.
+  // apply real-time scheduling configuration, if any
+  Realtime::configure("steering");
+
+  int subcycles = dev_->subcycles();
+  ros::Rate cycle(art_msgs::ArtHertz::STEERING * subcycles);
+  int subcycle = 0;
 
   while(ros::ok())
     {
+      if (subcycle != 0)                // between nominal cycles?
+        {
+          if (driver_state_ != DriverState::CLOSED)
+            dev_->servo_step();         // stream next setpoint
+          if (++subcycle >= subcycles)
+            subcycle = 0;
+          cycle.sleep();
+          continue;
+        }
+
       ros::spinOnce();                  // handle incoming commands
 
       switch (driver_state_)
@@ -462,12 +524,18 @@ void ArtSteer::run()
                 if (rc == 0)
                   last_set_point_ = set_point_;
               }
+            else
+              {
+                dev_->servo_step();     // continue any interpolation ramp
+              }
             break;
           }
         } // end switch on driver state
 
       PublishStatus();                  // publish current status
       last_sensor_time_ = cur_sensor_time_;
+      if (++subcycle >= subcycles)
+        subcycle = 0;
       cycle.sleep();                    // sleep until next cycle
     }
 }
@@ -48,6 +48,9 @@ devthrottle::devthrottle(bool train)
   cmd_p = (uint8_t *) &cmd;
   resp_p = (uint8_t *) &resp;
   memset(&stat, 0, sizeof(stat));
+  async_resp_bytes_ = 0;
+  async_resp_digits_ = 0;
+  async_linelen_ = 0;
 
   // Set throttle parameters -- make sure the defaults won't overrev
   // the engine.  These values will be used for /dev/null, in training
@@ -175,22 +178,30 @@ int devthrottle::query_rpms(float *data)
 //
 // updates cur_position to best available estimate
 //
-// returns:	0 if successful, updating stat
+// Asynchronous: issues the status request without waiting for its
+// round trip, then collects whatever responses have arrived from this
+// and earlier commands.  stat holds the most recent STATUS response,
+// normally one cycle old.
+//
+// returns:	0 if successful
 //		nonzero otherwise, stat unchanged
 int devthrottle::query_status()
 {
-  int rc = send_cmd(STATUS_CMD);
-  if (have_tty && rc == 0)
+  avr_set_com_len(&cmd, STATUS_CMD, 3);
+  int rc = servo_send();
+  if (rc == 0)
+    rc = poll_responses();
+
+  if (have_tty && rc == 0 && avr_get_len(&stat) > 0)
     {
       ROS_DEBUG(DEVICE " status: [G%d P%d R%d E%d]",
-		avr_get_gen(&resp), avr_get_pvld(&resp),
-		avr_get_rvld(&resp), avr_get_estop(&resp));
-      if (avr_get_gen(&resp) == 0)	// general status error?
+		avr_get_gen(&stat), avr_get_pvld(&stat),
+		avr_get_rvld(&stat), avr_get_estop(&stat));
+      if (avr_get_gen(&stat) == 0)	// general status error?
 	{
 	  ROS_WARN(DEVICE " reports general error status 0x%x",
-		   avr_get_diag(&resp));
+		   avr_get_diag(&stat));
 	}
-      stat = resp;			// save STATUS response
     }
 
   cur_position = last_req;		// good approximation
@@ -221,7 +232,16 @@ int devthrottle::throttle_absolute(float position)
   last_req = limit_travel(position);
   /// @todo once controller returns RPMs correctly, check rpm_redline
   ROS_DEBUG("requesting throttle position %.3f", last_req);
-  return send_goto(pos2avr(last_req));
+  if (already_configured)		// normal running state?
+    {
+      // Queue the goto asynchronously so the node cycle never blocks
+      // on the serial round trip.  The response is collected by
+      // poll_responses() on a later cycle.
+      avr_set_com_len(&cmd, GOTO_CMD, 4);
+      cmd.data.data08 = pos2avr(last_req);
+      return servo_send();
+    }
+  return send_goto(pos2avr(last_req));	// synchronous during setup
 }
  
 int devthrottle::throttle_relative(float delta)
@@ -230,6 +250,17 @@ int devthrottle::throttle_relative(float delta)
   return throttle_absolute(cur_position + delta);
 }
 
+/** publish current diagnostic information
+ *
+ *  @param diag_pub ROS publish object for ThrottleDiagnostics message.
+ */
+void devthrottle::publish_diag(const ros::Publisher &diag_pub)
+{
+  diag_msg_.outstanding = outstanding_.size();
+  diag_msg_.header.stamp = ros::Time::now();
+  diag_pub.publish(diag_msg_);
+}
+
 
 /////////////////////////////////////////////////////////////////
 // private methods
@@ -593,6 +624,221 @@ int devthrottle::servo_cmd(void)
   return rc;
 }
 
+// limit on simultaneously outstanding commands
+#define MAX_OUTSTANDING_CMDS 8
+
+// response timeout for asynchronous commands (msec): generous
+// compared to the normal two millisecond round trip
+#define ASYNC_RESPONSE_TIMEOUT 50
+
+/*  Write formatted command to the throttle controller asynchronously.
+ *
+ *  Unlike servo_cmd(), does not wait for the response.  The command
+ *  is tracked on the outstanding queue by sequence number until
+ *  poll_responses() matches its response, retries it after a NAK, or
+ *  times it out.
+ *
+ *  input:   cmd struct to be sent
+ *  returns: 0 if successful, errno value otherwise.
+ */
+int devthrottle::servo_send(void)
+{
+  outstanding_t out;
+  out.cmdlen = format_cmd(out.cmdstr);	// format the cmd string
+  out.cmd = cmd;
+  out.send_time = GetTime();
+  out.attempts = 1;
+
+  if (!have_tty) return 0;		// /dev/null always succeeds
+
+  // make room if the controller has stopped responding
+  if ((int) outstanding_.size() >= MAX_OUTSTANDING_CMDS)
+    {
+      ROS_WARN(DEVICE " too many outstanding commands, dropping oldest");
+      ++diag_msg_.timeouts;
+      outstanding_.pop_front();
+    }
+
+  // There is not much point in checking for errors on the write().
+  // If something went wrong, we'll find out matching the response.
+  int res = write(fd, out.cmdstr, out.cmdlen);
+  if (res < 0)
+    ROS_ERROR_THROTTLE(100, "write() error: %d", errno);
+
+  ROS_DEBUG(DEVICE " write() %s\n", out.cmdstr);
+
+  outstanding_.push_back(out);
+  ++diag_msg_.commands_sent;
+  return 0;
+}
+
+/*  Collect responses to asynchronously sent commands.
+ *
+ *  Nonblocking: reads whatever the controller has sent so far,
+ *  decoding complete packets and matching them against the
+ *  outstanding command queue.  Decode state persists across calls, so
+ *  a packet split between cycles is handled correctly.
+ *
+ *  returns: 0 normally, errno value on device error.
+ */
+int devthrottle::poll_responses(void)
+{
+  if (!have_tty)
+    return 0;
+
+  for (;;)
+    {
+      char rbuf[MAX_SERVO_CMD_BUFFER];
+      int bytes = read(fd, rbuf, sizeof(rbuf));
+      if (bytes < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  if (errno == EAGAIN)
+	    break;			// nothing more to read now
+	  ROS_WARN(DEVICE " read error: %s", strerror(errno));
+	  return errno;
+	}
+      if (bytes == 0)
+	break;
+      for (int i = 0; i < bytes; ++i)
+	handle_response_char(rbuf[i]);
+    }
+
+  check_response_timeouts();
+  return 0;
+}
+
+// feed one received character to the asynchronous packet decoder
+void devthrottle::handle_response_char(char c)
+{
+  // ignore any leading newline left from a previous packet
+  if (c == '\n' && async_linelen_ == 0)
+    return;
+
+  // Normally, we only see the carriage return, but will honor a
+  // newline, if the '\r' got lost in transmission.
+  if (c == '\r' || c == '\n')		// have a complete packet?
+    {
+      match_response(async_resp_bytes_, async_linelen_);
+      async_resp_bytes_ = 0;
+      async_resp_digits_ = 0;
+      async_linelen_ = 0;
+      return;
+    }
+
+  // Unpack the data from each packet char as it arrives.
+  buffer[async_linelen_] = c;
+  decode_char(c, &async_resp_bytes_, &async_resp_digits_);
+
+  if (++async_linelen_ >= MAX_SERVO_CMD_BUFFER)
+    {
+      buffer[MAX_SERVO_CMD_BUFFER-1] = '\0';
+      ROS_WARN(DEVICE " response buffer overflow: %s", buffer);
+      async_resp_bytes_ = 0;
+      async_resp_digits_ = 0;
+      async_linelen_ = 0;
+    }
+}
+
+// match one decoded response packet against the outstanding queue
+//
+//  updates round trip statistics in diag_msg_; resends the command
+//  with its original sequence number if the controller NAKed it;
+//  saves the latest STATUS response in stat.
+//
+void devthrottle::match_response(int resp_bytes, int linelen)
+{
+  buffer[linelen] = '\0';		// EOL is end of string
+  ROS_DEBUG(DEVICE " \"%s\" response received", buffer);
+
+  // check packet integrity
+  if (resp_bytes != avr_get_len(&resp)) // packet length mismatch
+    {
+      ROS_WARN(DEVICE " packet length error: %s", buffer);
+      return;
+    }
+
+  uint8_t resp_csum = resp_p[resp_bytes-1];
+  uint8_t csum = cmd_compute_csum(resp_p, resp_bytes-1);
+  if (csum != resp_csum)
+    {
+      ROS_WARN(DEVICE " checksum 0x%02x should be 0x%02x", csum, resp_csum);
+      return;
+    }
+
+  // Responses arrive in command order, so any outstanding command
+  // older than this response has lost its answer.
+  while (!outstanding_.empty()
+	 && outstanding_.front().cmd.seq != resp.seq)
+    {
+      ROS_WARN(DEVICE " no response for command seq 0x%02x",
+	       outstanding_.front().cmd.seq);
+      ++diag_msg_.timeouts;
+      outstanding_.pop_front();
+    }
+
+  if (outstanding_.empty())
+    {
+      ROS_WARN(DEVICE " unexpected response seq 0x%02x", resp.seq);
+      return;
+    }
+
+  outstanding_t match = outstanding_.front();
+  outstanding_.pop_front();
+
+  // update round trip statistics
+  float rtt = (GetTime() - match.send_time) / 1000.0;
+  ++diag_msg_.responses_received;
+  diag_msg_.rtt_last = rtt;
+  if (diag_msg_.responses_received == 1)
+    {
+      diag_msg_.rtt_min = rtt;
+      diag_msg_.rtt_avg = rtt;
+      diag_msg_.rtt_max = rtt;
+    }
+  else
+    {
+      if (rtt < diag_msg_.rtt_min) diag_msg_.rtt_min = rtt;
+      if (rtt > diag_msg_.rtt_max) diag_msg_.rtt_max = rtt;
+      // RC low-pass smoothing of the average
+      diag_msg_.rtt_avg += 0.1 * (rtt - diag_msg_.rtt_avg);
+    }
+
+  if (avr_get_com(&resp) == NAK_CMD)
+    {
+      ++diag_msg_.naks;
+      ROS_WARN(DEVICE " responded with NAK error %d", resp.data.data08);
+      if (++match.attempts <= 3)	// resend with original seq number
+	{
+	  match.send_time = GetTime();
+	  int res = write(fd, match.cmdstr, match.cmdlen);
+	  if (res < 0)
+	    ROS_ERROR_THROTTLE(100, "write() error: %d", errno);
+	  outstanding_.push_back(match);
+	  ++diag_msg_.commands_sent;
+	}
+      return;
+    }
+
+  if (avr_get_com(&resp) == STATUS_CMD)
+    stat = resp;			// save latest STATUS response
+}
+
+// time out commands outstanding too long
+void devthrottle::check_response_timeouts(void)
+{
+  int64_t now = GetTime();
+  while (!outstanding_.empty()
+	 && (now - outstanding_.front().send_time) > ASYNC_RESPONSE_TIMEOUT)
+    {
+      ROS_WARN(DEVICE " command seq 0x%02x timed out",
+	       outstanding_.front().cmd.seq);
+      ++diag_msg_.timeouts;
+      outstanding_.pop_front();
+    }
+}
+
 // validate response packet
 inline int devthrottle::validate_response(int resp_bytes, int linelen)
 {
@@ -15,7 +15,10 @@
 #include <stdint.h>
 #include <math.h>
 
+#include <deque>
+
 #include <ros/ros.h>
+#include <art_msgs/ThrottleDiagnostics.h>
 
 #include "../servo.h"
 #include "avr_controller.h"
@@ -62,6 +65,9 @@ public:
   int	query_rpms(float *data);
   int	query_status();
 
+  // publish command round-trip diagnostics
+  void	publish_diag(const ros::Publisher &diag_pub);
+
   // throttle command methods
   int	throttle_absolute(float position);
   int	throttle_relative(float delta);
@@ -82,11 +88,35 @@ public:
   float	cur_position;			// last position read
   float	last_req;			// last position requested
 
+  /* One command sent asynchronously, awaiting its response.  Retries
+   * reuse the original sequence number, as the protocol requires, so
+   * the formatted string is kept for resending.
+   */
+  typedef struct
+  {
+    struct avr_cmd cmd;			/* command awaiting response */
+    char    cmdstr[MAX_SERVO_CMD_BUFFER]; /* formatted command string */
+    int     cmdlen;			/* formatted string length */
+    int64_t send_time;			/* time written (msec) */
+    int     attempts;			/* send attempts so far */
+  } outstanding_t;
+
+  std::deque<outstanding_t> outstanding_; /* commands awaiting response */
+  int	async_resp_bytes_;		/* asynchronous decode state */
+  int	async_resp_digits_;
+  int	async_linelen_;
+
+  art_msgs::ThrottleDiagnostics diag_msg_;
+
   int	  calibrate_idle(void);
+  void	  check_response_timeouts(void);
   uint8_t cmd_compute_csum(uint8_t *buffer, int len);
   int	  configure_controller(void);
   void	  decode_char(char c, int *resp_bytes, int *resp_digits);
   int	  format_cmd(char *cmdstr);
+  void	  handle_response_char(char c);
+  void	  match_response(int resp_bytes, int linelen);
+  int	  poll_responses(void);
   int	  read_byte(int linelen);
   int     send_cmd(int ccode);
   int     send_cmd08(int ccode, uint8_t data);
@@ -94,6 +124,7 @@ public:
   int     send_cmd32(int ccode, uint32_t data);
   int	  send_goto(uint8_t pos);
   int     servo_cmd(void);
+  int     servo_send(void);
   int	  validate_response(int resp_bytes, int linelen);
 
   // return position valued constrained to permitted range
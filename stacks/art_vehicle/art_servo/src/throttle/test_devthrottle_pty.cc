@@ -0,0 +1,205 @@
+/*
+ *  ART throttle servo controller pseudo-terminal unit test
+ *
+ *  Copyright (C) 2011 Austin Robot Technology
+ *  License: Modified BSD Software License Agreement
+ *
+ *  $Id$
+ */
+
+/**  @file
+
+     Exercise the devthrottle asynchronous command protocol against a
+     pseudo-terminal mock speaking the AVR controller packet format:
+     delayed STATUS responses collected on a later cycle, and packet
+     decoding with garbage lines and checksum errors on the wire.
+
+     The device runs in training mode, so Open() skips the controller
+     configuration and idle calibration dialogues.
+
+     @author Jack O'Quin
+
+ */
+
+#include <ctype.h>
+
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+
+#include "../pty_mock.h"
+#include "devthrottle.h"
+
+namespace
+{
+  PtyMock *pty = NULL;
+  devthrottle *dev = NULL;
+
+  /** mock device state, read by the responder callback */
+  struct avr_script
+  {
+    int pos;                            // throttle position reported
+    int delay_ms;                       // response latency
+    bool line_noise;                    // prepend garbage packets
+  } script;
+
+  static char int2hex[] = "0123456789abcdef";
+
+  static inline uint8_t hex2int(char c)
+  {
+    if (c <= '9')
+      return c - '0';
+    return tolower(c) - 'a' + 10;
+  }
+
+  /** packet checksum, as described in avr_controller.h */
+  uint8_t avr_csum(const uint8_t *packet, int len)
+  {
+    int raw_sum = 0;
+    for (int i = 0; i < len; ++i)
+      raw_sum += packet[i];
+    return -((uint8_t) (raw_sum & 0xff));
+  }
+
+  /** Append one packet to @a response as ASCII hex characters. */
+  void encode_packet(const uint8_t *packet, int len, std::string *response)
+  {
+    for (int i = 0; i < len; ++i)
+      {
+        *response += int2hex[(packet[i] >> 4) & 0xF];
+        *response += int2hex[packet[i] & 0xF];
+      }
+    *response += '\r';
+  }
+
+  /** Answer any command with a STATUS packet echoing its sequence
+   *  number, the way the AVR controller firmware does.
+   */
+  void avr_responder(const std::string &command,
+                     std::string *response, void *arg)
+  {
+    avr_script *scr = (avr_script *) arg;
+
+    if (command.size() < 4)
+      return;                           // runt command, no response
+
+    if (scr->delay_ms > 0)
+      usleep(scr->delay_ms * 1000);
+
+    // STATUS response: COM/LEN, SEQ, position, RPM, diagnostics, CSUM
+    uint8_t packet[7];
+    packet[0] = (STATUS_CMD << 4) | sizeof(packet);
+    packet[1] = (hex2int(command[2]) << 4) | hex2int(command[3]);
+    packet[2] = scr->pos;
+    packet[3] = 0;                      // engine RPM not modeled
+    packet[4] = 0;
+    packet[5] = 0x03;                   // general OK, position valid
+    packet[6] = avr_csum(packet, sizeof(packet)-1);
+
+    if (scr->line_noise)
+      {
+        // a garbage line of noise characters, then a corrupted copy
+        // of the packet
+        *response += "Q#FF00Z\r";
+        uint8_t corrupt[sizeof(packet)];
+        memcpy(corrupt, packet, sizeof(packet));
+        ++corrupt[sizeof(packet)-1];    // bad checksum
+        encode_packet(corrupt, sizeof(corrupt), response);
+      }
+
+    encode_packet(packet, sizeof(packet), response);
+  }
+
+  /** throttle position fraction expected for an AVR position value,
+   *  using the default calibration from the constructor
+   */
+  float expected_position(int avr_pos)
+  {
+    return (avr_pos - 31) / (204.0 - 31.0);
+  }
+}
+
+class DevthrottlePty: public testing::Test
+{
+protected:
+
+  static void SetUpTestCase()
+  {
+    pty = new PtyMock();
+    ASSERT_TRUE(pty->open());
+
+    dev = new devthrottle(true);        // training mode
+    ASSERT_EQ(0, dev->Open(pty->slave_name()));
+  }
+
+  static void TearDownTestCase()
+  {
+    dev->Close();
+    delete dev;
+    dev = NULL;
+    delete pty;
+    pty = NULL;
+  }
+
+  virtual void SetUp()
+  {
+    pty->clear_script();
+    script.pos = 0;
+    script.delay_ms = 0;
+    script.line_noise = false;
+    pty->set_responder(avr_responder, &script);
+  }
+};
+
+// The status request is asynchronous: the response to one cycle's
+// command is collected by a later cycle without ever blocking.
+TEST_F(DevthrottlePty, asyncStatusRoundTrip)
+{
+  script.pos = 100;
+  script.delay_ms = 2;
+
+  // first cycle sends the request; its response is still in flight
+  EXPECT_EQ(0, dev->query_status());
+  EXPECT_FLOAT_EQ(0.0, dev->get_position());
+
+  usleep(30*1000);                      // a later cycle
+
+  EXPECT_EQ(0, dev->query_status());
+  EXPECT_NEAR(expected_position(100), dev->get_position(), 1e-3);
+}
+
+// garbage lines and checksum errors are discarded by the packet
+// decoder without losing the valid response behind them
+TEST_F(DevthrottlePty, lineNoiseIgnored)
+{
+  script.pos = 150;
+  script.line_noise = true;
+
+  EXPECT_EQ(0, dev->query_status());
+  usleep(30*1000);
+  EXPECT_EQ(0, dev->query_status());
+
+  EXPECT_NEAR(expected_position(150), dev->get_position(), 1e-3);
+}
+
+// an unresponsive device never blocks the status cycle
+TEST_F(DevthrottlePty, unresponsiveDeviceNonBlocking)
+{
+  pty->set_responder(NULL, NULL);       // table empty: drop everything
+  pty->set_mute(true);
+
+  ros::WallTime start = ros::WallTime::now();
+  EXPECT_EQ(0, dev->query_status());
+  double ms = (ros::WallTime::now() - start).toSec() * 1000.0;
+
+  // no serial round trip on the control path
+  EXPECT_LT(ms, 10.0);
+}
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  // devthrottle reads its parameters from the private node handle
+  ros::init(argc, argv, "test_devthrottle_pty");
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -11,7 +11,9 @@
 #include <ros/ros.h>
 
 #include <art_msgs/ArtHertz.h>
+#include <art/realtime.h>
 #include <art_msgs/ThrottleCommand.h>
+#include <art_msgs/ThrottleDiagnostics.h>
 #include <art_msgs/ThrottleState.h>
 
 #include "devthrottle.h"		// servo device interface
@@ -28,6 +30,8 @@ vehicle.
 Publishes
 
 - \b throttle/state [art_msgs::ThrottleState] throttle status.
+- \b throttle/diag [art_msgs::ThrottleDiagnostics] command round-trip
+  statistics and other driver diagnostics.
 
 Subscribes
 
@@ -86,6 +90,7 @@ private:
 
   ros::Subscriber throttle_cmd_;        // throttle/cmd
   ros::Publisher  throttle_state_;      // throttle/state
+  ros::Publisher  throttle_diag_;       // throttle/diag
 
   devthrottle *dev_;			// servo device interface
 };
@@ -138,6 +143,8 @@ int Throttle::Setup(ros::NodeHandle node)
     node.subscribe("throttle/cmd", qDepth, &Throttle::GetCmd, this, noDelay);
   throttle_state_ =
     node.advertise<art_msgs::ThrottleState>("throttle/state", qDepth);
+  throttle_diag_ =
+    node.advertise<art_msgs::ThrottleDiagnostics>("throttle/diag", qDepth);
 
   return 0;
 }
@@ -195,11 +202,17 @@ void Throttle::PollDevice(void)
       msg.header.stamp = ros::Time::now();
       throttle_state_.publish(msg);
     }
+
+  // publish driver diagnostic info
+  dev_->publish_diag(throttle_diag_);
 }
 
 // Main function for device thread
-void Throttle::Main() 
+void Throttle::Main()
 {
+  // apply real-time scheduling configuration, if any
+  Realtime::configure("throttle");
+
   ros::Rate cycle(art_msgs::ArtHertz::THROTTLE); // set driver cycle rate
 
   while(ros::ok())
@@ -62,6 +62,10 @@ class JoyNode():
         self.brake = 19                 # brake axis (square)
         self.brake_start = True
 
+        # steering smoothing state
+        self.last_steer_angle = 0.0     # last commanded wheel angle
+        self.last_joy_time = None       # previous joystick event time
+
         # initialize ROS topics
         rospy.init_node('joy_teleop')
         self.pilot = pilot_cmd.PilotCommand()
@@ -72,6 +76,14 @@ class JoyNode():
         "invoked every time a joystick message arrives"
         rospy.logdebug('joystick input:\n' + str(joy))
 
+        # joystick event time for the latency metric; the older joy
+        # package message has no header
+        header = getattr(joy, 'header', None)
+        if header and header.stamp != rospy.Time():
+            event_time = header.stamp
+        else:
+            event_time = rospy.get_rostime()
+
         # handle E-stop buttons
         if joy.buttons[self.estop]:
             rospy.logwarn('emergency stop')
@@ -98,7 +110,7 @@ class JoyNode():
             rospy.loginfo('shifting to park')
 
         # set steering angle
-        self.setAngle(joy.axes[self.steer])
+        self.setAngle(joy.axes[self.steer], event_time)
 
         # adjust speed -- the brake and throttle controls both
         # return 1.0 when released, -1.0 when completely on
@@ -121,16 +133,19 @@ class JoyNode():
             else:
                 self.throttle_start = False
 
-        # set acceleration from brake and throttle controls
+        # Set acceleration from brake and throttle controls.  The
+        # pedal travel can reach 2.0, so clamp the request here
+        # instead of having the pilot clip it after the fact.
         dv = 0.0
         if br < 1.0:
             dv = br - 1.0
         elif th < 1.0:
             dv = 1.0 - th
+        dv = clamp(-1.0, dv, 1.0)
         self.pilot.accelerate(dv * self.config['max_accel'])
 
         if self.nav.is_suspended(): # OK to issue command?
-            self.pilot.publish()
+            self.pilot.publish(event_time)
         else:
             rospy.logdebug('car running autonomously (command ignored)')
 
@@ -152,7 +167,7 @@ class JoyNode():
         self.config = config
         return config
 
-    def setAngle(self, turn):
+    def setAngle(self, turn, event_time):
         "set wheel angle"
 
         # Try various functions with domain [-1..1] to improve
@@ -162,6 +177,19 @@ class JoyNode():
         turn = math.pow(turn, 3) * ArtVehicle.max_steer_radians
         #turn = math.tan(turn) * ArtVehicle.max_steer_radians
 
+        # Optional predictive smoothing: rate-limit the wheel angle
+        # here, so aggressive inputs are shaped to what the servo can
+        # actually track instead of being clipped late by the pilot.
+        if self.config['smooth_steering']:
+            dt = 0.05
+            if self.last_joy_time is not None:
+                dt = max(0.0, (event_time - self.last_joy_time).to_sec())
+            limit = self.config['max_steer_rate'] * dt
+            turn = clamp(self.last_steer_angle - limit, turn,
+                         self.last_steer_angle + limit)
+        self.last_steer_angle = turn
+        self.last_joy_time = event_time
+
         # ensure maximum wheel angle never exceeded
         self.pilot.steer(turn)
 
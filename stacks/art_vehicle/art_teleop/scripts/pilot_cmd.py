@@ -22,6 +22,7 @@ from art_msgs.msg import DriverState
 from art_msgs.msg import Epsilon
 from art_msgs.msg import Gear
 from art_msgs.msg import PilotState
+from std_msgs.msg import Float32
 
 def clamp(minimum, value, maximum):
     "constrain value to the range [minimum .. maximum]"
@@ -40,6 +41,11 @@ class PilotCommand():
         self.sub = rospy.Subscriber('pilot/state', PilotState,
                                     self.pilotCallback)
 
+        # end-to-end latency metric: joystick event time stamp of the
+        # oldest command still awaiting a pilot state echo
+        self.cmd_event_stamp = None
+        self.latency_pub = rospy.Publisher('teleop/latency', Float32)
+
     def accelerate(self, dv):
         "accelerate dv meters/second^2"
         rospy.logdebug('acceleration: ' + str(dv))
@@ -89,11 +95,21 @@ class PilotCommand():
         # Base future commands on current state, not target.
         self.car_ctl = pstate.current
 
-    def publish(self):
+        # publish joystick event to pilot echo latency (seconds)
+        if self.cmd_event_stamp is not None:
+            delay = pstate.header.stamp - self.cmd_event_stamp
+            self.latency_pub.publish(Float32(delay.to_sec()))
+            self.cmd_event_stamp = None
+
+    def publish(self, event_stamp=None):
         "publish pilot command message"
         self.car_msg.header.stamp = rospy.Time.now()
         self.car_msg.control = self.car_ctl
         self.pub.publish(self.car_msg)
+        # remember the joystick event behind the oldest command not
+        # yet echoed by the pilot, for the latency metric
+        if event_stamp is not None and self.cmd_event_stamp is None:
+            self.cmd_event_stamp = event_stamp
 
     def reconfigure(self, limit_forward, limit_reverse):
         "reconfigure forward and reverse speed limits"
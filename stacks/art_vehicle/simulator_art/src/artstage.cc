@@ -28,9 +28,9 @@
  
      ROS node for simulating the ART autonomous vehicle with Stage..
 
-     \todo handle multiple robots (code partially exists from stageros.cpp)
-
-     \todo map multiple lasers to their own frame and topic names
+     Multiple vehicles share one stepped world: each position/laser
+     pair gets its own ArtVehicleModel with "/robot_N/" topic and
+     frame names.
 
      \todo terminate when stage window terminates
  
@@ -56,6 +56,7 @@
 #include <ros/ros.h>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <sensor_msgs/LaserScan.h>
 #include <tf/transform_broadcaster.h>
 
@@ -92,7 +93,6 @@ class StageNode
 {
   private:
     // Messages that we'll send or receive
-    sensor_msgs::LaserScan *laserMsgs;
     Clock clockMsg;
 
     // roscpp-related bookkeeping
@@ -105,11 +105,45 @@ class StageNode
     std::vector<StgLaser *> lasermodels;
     std::vector<Stg::ModelPosition *> positionmodels;
     std::vector<ros::Publisher> laser_pubs_;
+    std::vector<std::string> laser_frames_; // per-robot laser frame IDs
     ros::Publisher clock_pub_;
 
     // ART vehicle dynamics simulation
     std::vector<ArtVehicleModel *> vehicleModels_;
 
+    // Decoupled laser publishing.  The Stage update thread only
+    // copies raw scan snapshots under snap_lock_; a worker thread
+    // formats and publishes the ROS messages, so simulation stepping
+    // does not wait on message serialization.
+    struct LaserSnapshot
+    {
+      LaserSnapshot(): fresh(false) {}
+      bool fresh;                       // new data since last publish
+      ros::Time stamp;
+      float angle_min;
+      float angle_max;
+      float angle_increment;
+      float range_min;
+      float range_max;
+      std::vector<float> ranges;
+      std::vector<float> intensities;
+    };
+    std::vector<LaserSnapshot> snapshots_;
+    boost::mutex snap_lock_;
+    boost::condition_variable snap_cond_;
+    boost::thread *laser_thread_;
+    bool laser_thread_quit_;
+
+    // Pool of preallocated scan messages per laser.  Publishing a
+    // shared pointer lets intraprocess subscribers use the message
+    // without a copy; a pooled message is reused (keeping its sample
+    // capacity) once every subscriber has released it.
+    std::vector<std::vector<sensor_msgs::LaserScan::Ptr> > laser_pools_;
+    sensor_msgs::LaserScan::Ptr allocScanMsg(size_t r, size_t nsamples);
+
+    // laser publish worker thread body
+    void publishLasers();
+
     // A helper function that is executed for each stage model.  We use it
     // to search for models of interest.
     static void ghfunc(Stg::Model* mod, StageNode* node);
@@ -133,6 +167,9 @@ class StageNode
     // Current simulation time
     ros::Time sim_time;
 
+    // wall clock when PaceWorld() started pacing
+    ros::WallTime start_wall_;
+
   public:
     // Constructor; stage itself needs argc/argv.  fname is the .world file
     // that stage should load.
@@ -151,6 +188,9 @@ class StageNode
     // has not yet arrived.
     bool UpdateWorld();
 
+    // Pace the simulation at a multiple of real time.
+    void PaceWorld(double speedup);
+
     // The main simulator object
     Stg::World* world;
 };
@@ -175,15 +215,8 @@ StageNode::ghfunc(Stg::Model* mod, StageNode* node)
   if (dynamic_cast<StgLaser *>(mod))
     node->lasermodels.push_back(dynamic_cast<StgLaser *>(mod));
 
-#if 0  // newer version
   if (dynamic_cast<Stg::ModelPosition *>(mod))
     node->positionmodels.push_back(dynamic_cast<Stg::ModelPosition *>(mod));
-#else  // earlier version
-  // only use the first position model
-  if (dynamic_cast<Stg::ModelPosition *>(mod)
-      && node->positionmodels.size() == 0)
-    node->positionmodels.push_back(dynamic_cast<Stg::ModelPosition *>(mod));
-#endif
 }
 
 StageNode::StageNode(int argc, char** argv, bool gui, const char* fname)
@@ -226,26 +259,34 @@ StageNode::StageNode(int argc, char** argv, bool gui, const char* fname)
   this->world->ForEachDescendant((model_callback_t)ghfunc, this);
 
   size_t numRobots = positionmodels.size();
-  ROS_INFO_STREAM("found " << numRobots << " position model(s) in the file");
+  ROS_INFO("found %u position/laser pair%s in the file",
+           (unsigned int)numRobots, (numRobots==1) ? "" : "s");
 
-  /// \todo support more than one simulated robot
-  if (numRobots != 1)
+  // every vehicle needs a matching laser, in world file order
+  if (lasermodels.size() != numRobots)
   {
-#if 0
-    ROS_FATAL("artstage currently only simulates one position model");
+    ROS_FATAL("found %u laser model(s) for %u position model(s)",
+              (unsigned int)lasermodels.size(), (unsigned int)numRobots);
     ROS_BREAK();
-#endif
-    size_t numRobots = positionmodels.size();
-    ROS_INFO("found %u position/laser pair%s in the file", 
-             (unsigned int)numRobots, (numRobots==1) ? "" : "s");
   }
 
-  this->laserMsgs = new sensor_msgs::LaserScan[numRobots];
+  this->laser_pools_.resize(numRobots);
+  this->snapshots_.resize(numRobots);
+  this->laser_thread_ = NULL;
+  this->laser_thread_quit_ = false;
 
   for (size_t r = 0; r < numRobots; r++)
   {
-    // TODO assign a namespace to each robot (from stage??)
-    vehicleModels_.push_back(new ArtVehicleModel(positionmodels[r], &tf, ""));
+    // Namespace each vehicle when several share the world, matching
+    // the "/robot_N/" laser topic names from mapName().
+    std::string ns("");
+    if (numRobots > 1)
+    {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "/robot_%lu", (long unsigned) r);
+      ns = buf;
+    }
+    vehicleModels_.push_back(new ArtVehicleModel(positionmodels[r], &tf, ns));
   }
 }
 
@@ -286,26 +327,153 @@ StageNode::SubscribeModels()
     laser_pubs_.push_back(n_.advertise<sensor_msgs::LaserScan>
                           (mapName(FRONT_LASER,r), 10));
 
+    // per-robot laser frame ID, matching the vehicle tf prefix
+    std::string frame = mapName(ArtFrames::front_sick, r);
+    if (frame[0] != '/')
+      frame = "/" + frame;
+    laser_frames_.push_back(frame);
+
     // set up vehicle model ROS topics
     vehicleModels_[r]->setup();
   }
   clock_pub_ = n_.advertise<Clock>("/clock",10);
+
+  // start the laser publishing worker now that the topics exist
+  laser_thread_ =
+    new boost::thread(boost::bind(&StageNode::publishLasers, this));
   return(0);
 }
 
 StageNode::~StageNode()
 {
-  delete[] laserMsgs;
+  if (laser_thread_)
+  {
+    {
+      boost::mutex::scoped_lock lock(snap_lock_);
+      laser_thread_quit_ = true;
+    }
+    snap_cond_.notify_one();
+    laser_thread_->join();
+    delete laser_thread_;
+  }
   for (size_t r = 0; r < vehicleModels_.size(); r++)
     delete vehicleModels_[r];
 }
 
+// Get a scan message for laser r from its pool.
+//
+// Reuses a pooled message once every subscriber has released it,
+// reserving the sample capacity when a fresh one must be added, so
+// steady-state publication allocates nothing.
+sensor_msgs::LaserScan::Ptr
+StageNode::allocScanMsg(size_t r, size_t nsamples)
+{
+  std::vector<sensor_msgs::LaserScan::Ptr> &pool = laser_pools_[r];
+  for (size_t i = 0; i < pool.size(); i++)
+  {
+    if (pool[i].unique())
+      return pool[i];
+  }
+
+  // all pooled messages still referenced by subscribers: grow the pool
+  sensor_msgs::LaserScan::Ptr fresh(new sensor_msgs::LaserScan());
+  fresh->ranges.reserve(nsamples);
+  fresh->intensities.reserve(nsamples);
+  pool.push_back(fresh);
+  return fresh;
+}
+
+// Laser publish worker thread.
+//
+// Waits for WorldCallback() to copy fresh scan snapshots, then
+// formats and publishes the ROS messages.  The sample vectors are
+// swapped out of the snapshots while the lock is held, so neither
+// thread copies samples while the other waits.
+void
+StageNode::publishLasers()
+{
+  size_t nlasers = snapshots_.size();
+  std::vector<sensor_msgs::LaserScan::Ptr> publish_r(nlasers);
+
+  boost::unique_lock<boost::mutex> lock(snap_lock_);
+  while (!laser_thread_quit_)
+  {
+    bool fresh = false;
+    for (size_t r = 0; r < nlasers; r++)
+    {
+      publish_r[r].reset();
+      if (!snapshots_[r].fresh)
+        continue;
+      fresh = true;
+
+      LaserSnapshot &snap = snapshots_[r];
+      sensor_msgs::LaserScan::Ptr msg =
+        allocScanMsg(r, snap.ranges.size());
+      msg->angle_min = snap.angle_min;
+      msg->angle_max = snap.angle_max;
+      msg->angle_increment = snap.angle_increment;
+      msg->range_min = snap.range_min;
+      msg->range_max = snap.range_max;
+      msg->ranges.swap(snap.ranges);
+      msg->intensities.swap(snap.intensities);
+
+      msg->header.frame_id = laser_frames_[r];
+      msg->header.stamp = snap.stamp;
+      publish_r[r] = msg;
+      snap.fresh = false;
+    }
+
+    if (!fresh)
+    {
+      snap_cond_.wait(lock);
+      continue;
+    }
+
+    // publish with the lock released, so the simulation never waits;
+    // publishing the shared pointer avoids serialization and copying
+    // for intraprocess subscribers
+    lock.unlock();
+    for (size_t r = 0; r < nlasers; r++)
+    {
+      if (publish_r[r])
+      {
+        this->laser_pubs_[r].publish(publish_r[r]);
+        publish_r[r].reset();           // release our reference
+      }
+    }
+    lock.lock();
+  }
+}
+
 bool
 StageNode::UpdateWorld()
 {
   return this->world->UpdateAll();
 }
 
+// Pace the simulation at a multiple of real time.
+//
+// With speedup <= 0.0 the world free-runs as fast as the host
+// allows.  Otherwise, sleep whenever simulated time gets ahead of
+// speedup times the elapsed wall clock.  Since the rest of the stack
+// follows /clock, regression sweeps can run time-compressed with a
+// larger speedup without changing mission behavior.
+void
+StageNode::PaceWorld(double speedup)
+{
+  if (speedup <= 0.0)
+    return;                             // free-running
+
+  if (start_wall_.isZero())
+    start_wall_ = ros::WallTime::now();
+
+  double elapsed_sim = world->SimTimeNow() / 1e6;
+  double elapsed_wall = (ros::WallTime::now() - start_wall_).toSec();
+  double ahead = elapsed_sim / speedup - elapsed_wall;
+  if (ahead > 0.0)
+    ros::WallDuration(ahead).sleep();
+}
+
 void
 StageNode::WorldCallback()
 {
@@ -320,73 +488,73 @@ StageNode::WorldCallback()
     return;
   }
 
-  // Get latest laser data
-  for (size_t r = 0; r < this->lasermodels.size(); r++)
+  // Snapshot the latest laser data for the publishing worker
   {
+    boost::mutex::scoped_lock snap_lock(snap_lock_);
+    for (size_t r = 0; r < this->lasermodels.size(); r++)
+    {
+      LaserSnapshot &snap = snapshots_[r];
 
 #if STAGE_VERSION == 4
 
-    const std::vector<Stg::ModelRanger::Sensor>& sensors =
-      this->lasermodels[r]->GetSensors();
-		
-    if( sensors.size() > 1 )
-      ROS_WARN( "ART Stage currently supports rangers with 1 sensor only." );
-
-    // for now we access only the zeroth sensor of the ranger - good
-    // enough for most laser models that have a single beam origin
-    const Stg::ModelRanger::Sensor& s = sensors[0];
-		
-    if( s.ranges.size() )
-      {
-        // Translate into ROS message format and publish
-        this->laserMsgs[r].angle_min = -s.fov/2.0;
-        this->laserMsgs[r].angle_max = +s.fov/2.0;
-        this->laserMsgs[r].angle_increment = s.fov/(double)(s.sample_count-1);
-        this->laserMsgs[r].range_min = s.range.min;
-        this->laserMsgs[r].range_max = s.range.max;
-        this->laserMsgs[r].ranges.resize(s.ranges.size());
-        this->laserMsgs[r].intensities.resize(s.intensities.size());
-      		
-        for(unsigned int i=0; i<s.ranges.size(); i++)
-          {
-            this->laserMsgs[r].ranges[i] = s.ranges[i];
-            this->laserMsgs[r].intensities[i] = (uint8_t)s.intensities[i];
-          }
-
-        // TODO map each laser to separate frame and topic names
-        this->laserMsgs[r].header.frame_id = "/" + ArtFrames::front_sick;
-        this->laserMsgs[r].header.stamp = sim_time;
-        this->laser_pubs_[r].publish(this->laserMsgs[r]);
-      }
+      const std::vector<Stg::ModelRanger::Sensor>& sensors =
+        this->lasermodels[r]->GetSensors();
+
+      if( sensors.size() > 1 )
+        ROS_WARN( "ART Stage currently supports rangers with 1 sensor only." );
+
+      // for now we access only the zeroth sensor of the ranger - good
+      // enough for most laser models that have a single beam origin
+      const Stg::ModelRanger::Sensor& s = sensors[0];
+
+      if( s.ranges.size() )
+        {
+          snap.angle_min = -s.fov/2.0;
+          snap.angle_max = +s.fov/2.0;
+          snap.angle_increment = s.fov/(double)(s.sample_count-1);
+          snap.range_min = s.range.min;
+          snap.range_max = s.range.max;
+          snap.ranges.resize(s.ranges.size());
+          snap.intensities.resize(s.intensities.size());
+
+          for(unsigned int i=0; i<s.ranges.size(); i++)
+            {
+              snap.ranges[i] = s.ranges[i];
+              snap.intensities[i] = (uint8_t)s.intensities[i];
+            }
+
+          snap.stamp = sim_time;
+          snap.fresh = true;
+        }
 
 #else // STAGE_VERSION 3
 
-    std::vector<StgLaser::Sample> samples = this->lasermodels[r]->GetSamples();
-    if(samples.size())
-    {
-      // Translate into ROS message format and publish
-      StgLaser::Config cfg = this->lasermodels[r]->GetConfig();
-      this->laserMsgs[r].angle_min = -cfg.fov/2.0;
-      this->laserMsgs[r].angle_max = +cfg.fov/2.0;
-      this->laserMsgs[r].angle_increment = cfg.fov/(double)(cfg.sample_count-1);
-      this->laserMsgs[r].range_min = 0.0;
-      this->laserMsgs[r].range_max = cfg.range_bounds.max;
-      this->laserMsgs[r].ranges.resize(cfg.sample_count);
-      this->laserMsgs[r].intensities.resize(cfg.sample_count);
-      for(unsigned int i=0;i<cfg.sample_count;i++)
+      std::vector<StgLaser::Sample> samples =
+        this->lasermodels[r]->GetSamples();
+      if(samples.size())
       {
-        this->laserMsgs[r].ranges[i] = samples[i].range;
-        this->laserMsgs[r].intensities[i] = (uint8_t)samples[i].reflectance;
-      }
+        StgLaser::Config cfg = this->lasermodels[r]->GetConfig();
+        snap.angle_min = -cfg.fov/2.0;
+        snap.angle_max = +cfg.fov/2.0;
+        snap.angle_increment = cfg.fov/(double)(cfg.sample_count-1);
+        snap.range_min = 0.0;
+        snap.range_max = cfg.range_bounds.max;
+        snap.ranges.resize(cfg.sample_count);
+        snap.intensities.resize(cfg.sample_count);
+        for(unsigned int i=0;i<cfg.sample_count;i++)
+        {
+          snap.ranges[i] = samples[i].range;
+          snap.intensities[i] = (uint8_t)samples[i].reflectance;
+        }
 
-      // TODO map each laser to separate frame and topic names
-      this->laserMsgs[r].header.frame_id = "/" + ArtFrames::front_sick;
-      this->laserMsgs[r].header.stamp = sim_time;
-      this->laser_pubs_[r].publish(this->laserMsgs[r]);
-    }
+        snap.stamp = sim_time;
+        snap.fresh = true;
+      }
 
 #endif // STAGE_VERSION
+    }
   }
+  snap_cond_.notify_one();
 
   // update latest position data
   for (size_t r = 0; r < this->positionmodels.size(); r++)
@@ -454,6 +622,13 @@ main(int argc, char** argv)
   sn.world->Start();
 #endif
 
+  // Desired ratio of simulated time to wall-clock time.  The default
+  // of 1.0 tracks real time; larger values compress time for
+  // regression sweeps, and values <= 0.0 free-run as fast as the
+  // host allows.  Only used without the GUI.
+  double speedup;
+  private_nh.param("speedup", speedup, 1.0);
+
   // TODO: get rid of this fixed-duration sleep, using some Stage builtin
   // PauseUntilNextUpdate() functionality.
   ros::WallRate r(10.0);
@@ -466,7 +641,7 @@ main(int argc, char** argv)
     else
     {
       sn.UpdateWorld();
-      r.sleep();
+      sn.PaceWorld(speedup);
     }
   }
   t.join();
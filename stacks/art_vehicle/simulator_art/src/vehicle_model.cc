@@ -58,8 +58,18 @@ void ArtVehicleModel::setup(void)
     node_.subscribe(ns_prefix_ + "throttle/state", qDepth,
                     &ArtVehicleModel::throttleReceived, this, noDelay);
 
-  // set default GPS origin, from SwRI site visit in San Antonio
+  // Simulated sensor rates.  Zero publishes in lockstep with the
+  // world update, like before; the real vehicle runs 100 Hz odometry
+  // with 10 Hz GPS.
   ros::NodeHandle private_nh("~");
+  private_nh.param("odom_rate", odom_rate_, 0.0);
+  private_nh.param("gps_rate", gps_rate_, 0.0);
+  if (odom_rate_ > 0.0)
+    ROS_INFO("simulated odometry rate: %.1f Hz", odom_rate_);
+  if (gps_rate_ > 0.0)
+    ROS_INFO("simulated GPS rate: %.1f Hz", gps_rate_);
+
+  // set default GPS origin, from SwRI site visit in San Antonio
   private_nh.param("latitude",  origin_lat_,   29.446018);
   private_nh.param("longitude", origin_long_, -98.607024);
   private_nh.param("elevation", origin_elev_, 100.0);
@@ -93,7 +103,7 @@ ArtVehicleModel::brakeReceived(const art_msgs::BrakeState::ConstPtr &msg)
 {
   //ROS_DEBUG("brake state received: position %.3f", msg->position);
   boost::mutex::scoped_lock lock(msg_lock_);
-  brake_position_ = msg->position;
+  servos_.brake_position = msg->position;
 }
 
 void
@@ -101,7 +111,7 @@ ArtVehicleModel::shifterReceived(const art_msgs::Shifter::ConstPtr &msg)
 {
   ROS_DEBUG("shifter state received: gear %u", msg->gear);
   boost::mutex::scoped_lock lock(msg_lock_);
-  shifter_gear_ = msg->gear;
+  servos_.shifter_gear = msg->gear;
 }
 
 void 
@@ -109,7 +119,7 @@ ArtVehicleModel::steeringReceived(const art_msgs::SteeringState::ConstPtr &msg)
 {
   //ROS_DEBUG("steering state received: %.1f (degrees)", msg->angle);
   boost::mutex::scoped_lock lock(msg_lock_);
-  steering_angle_ = msg->angle;
+  servos_.steering_angle = msg->angle;
 }
 
 void
@@ -117,7 +127,7 @@ ArtVehicleModel::throttleReceived(const art_msgs::ThrottleState::ConstPtr &msg)
 {
   //ROS_DEBUG("throttle state received: position %.3f", msg->position);
   boost::mutex::scoped_lock lock(msg_lock_);
-  throttle_position_ = msg->position;
+  servos_.throttle_position = msg->position;
 }
 
 /** Model vehicle acceleration
@@ -138,8 +148,12 @@ void ArtVehicleModel::ModelAcceleration(geometry_msgs::Twist *odomVel,
                                         sensor_msgs::Imu *imuMsg,
                                         ros::Time sim_time)
 {
-  // MUST serialize with updates from incoming messages
-  boost::mutex::scoped_lock lock(msg_lock_);
+  // Snapshot the latest servo state.  The lock only covers this
+  // struct copy, never the dynamics integration below.
+  {
+    boost::mutex::scoped_lock lock(msg_lock_);
+    servo_snap_ = servos_;
+  }
 
   double speed = fabs(odomVel->linear.x);
 
@@ -157,8 +171,8 @@ void ArtVehicleModel::ModelAcceleration(geometry_msgs::Twist *odomVel,
 
   double wind_resistance = drag_coeff * speed * speed;
   double accel = (idle_accel
-                  + throttle_position_ * throttle_accel
-                  - brake_position_ * brake_decel
+                  + servo_snap_.throttle_position * throttle_accel
+                  - servo_snap_.brake_position * brake_decel
                   - rolling_resistance
                   - wind_resistance);
 
@@ -177,17 +191,17 @@ void ArtVehicleModel::ModelAcceleration(geometry_msgs::Twist *odomVel,
 
   // Set velocity sign based on gear.
   odomVel->linear.x = speed;            // forward movement
-  if (shifter_gear_ ==  art_msgs::Shifter::Reverse)
+  if (servo_snap_.shifter_gear ==  art_msgs::Shifter::Reverse)
     odomVel->linear.x = -speed;         // reverse movement
 
   // set yaw rate (radians/second) from velocity and steering angle
   odomVel->angular.z = Steering::angle_to_yaw(odomVel->linear.x,
-                                              steering_angle_);
+                                              servo_snap_.steering_angle);
   imuMsg->angular_velocity.z = odomVel->angular.z;
 
   // set simulated vehicle velocity using the "car" steering model,
   // which uses steering angle in radians instead of yaw rate.
-  double angleRadians = angles::from_degrees(steering_angle_);
+  double angleRadians = angles::from_degrees(servo_snap_.steering_angle);
   ROS_DEBUG("Stage SetSpeed(%.3f, %.3f, %.3f)",
             odomVel->linear.x, odomVel->linear.y, angleRadians);
   stgp_->SetSpeed(odomVel->linear.x, odomVel->linear.y, angleRadians);
@@ -212,34 +226,41 @@ void ArtVehicleModel::update(ros::Time sim_time)
   odomMsg_.header.stamp = sim_time;
   odomMsg_.header.frame_id = tf_prefix_ + ArtFrames::earth;
   odomMsg_.child_frame_id = tf_prefix_ + ArtFrames::vehicle;
-  odom_pub_.publish(odomMsg_);
 
-  // publish simulated IMU data
+  // fill in simulated IMU data
   imu_msg.header.stamp = sim_time;
   imu_msg.header.frame_id = tf_prefix_ + ArtFrames::vehicle;
   imu_msg.orientation = odomMsg_.pose.pose.orientation;
-  imu_pub_.publish(imu_msg);
 
-  // broadcast /earth transform relative to sea level
-  tf::Quaternion vehicleQ;
-  tf::quaternionMsgToTF(odomMsg_.pose.pose.orientation, vehicleQ);
-  tf::Transform txEarth(vehicleQ, 
-                       tf::Point(odomMsg_.pose.pose.position.x,
-                                 odomMsg_.pose.pose.position.y,
-                                 odomMsg_.pose.pose.position.z));
-  tf_->sendTransform(tf::StampedTransform(txEarth, sim_time,
-                                          tf_prefix_ + ArtFrames::earth,
-                                          tf_prefix_ + ArtFrames::vehicle));
+  if (last_update_time_.isZero())
+    {
+      // first update: no previous state to interpolate from
+      last_odom_msg_ = odomMsg_;
+      last_imu_msg_ = imu_msg;
+    }
 
-  // Also publish /odom frame with same elevation as /vehicle and same
-  // orientation as /earth
-  tf::Transform txOdom(tf::Quaternion(0.0, 0.0, 0.0, 1.0), 
-                       tf::Point(0.0, 0.0, -odomMsg_.pose.pose.position.z));
-  tf_->sendTransform(tf::StampedTransform(txOdom, sim_time,
-                                          tf_prefix_ + ArtFrames::odom,
-                                          tf_prefix_ + ArtFrames::earth));
+  // publish odometry, IMU and the vehicle transforms
+  if (odom_rate_ <= 0.0)
+    {
+      publishOdometry(odomMsg_, imu_msg); // lockstep with the world
+    }
+  else
+    {
+      if (next_odom_time_.isZero())
+        next_odom_time_ = sim_time;
+      ros::Duration period(1.0 / odom_rate_);
+      nav_msgs::Odometry odom_sample;
+      sensor_msgs::Imu imu_sample;
+      while (next_odom_time_ <= sim_time)
+        {
+          interpolateState(next_odom_time_, odomMsg_, imu_msg,
+                           &odom_sample, &imu_sample);
+          publishOdometry(odom_sample, imu_sample);
+          next_odom_time_ += period;
+        }
+    }
 
-  // Also publish the ground truth pose and velocity, correcting for
+  // Publish the ground truth pose and velocity, correcting for
   // Stage's screwed-up coord system.
   Stg::Pose gpose = stgp_->GetGlobalPose();
   Stg::Velocity gvel = stgp_->GetGlobalVelocity();
@@ -265,29 +286,147 @@ void ArtVehicleModel::update(ros::Time sim_time)
   groundTruthMsg_.child_frame_id = tf_prefix_ + ArtFrames::vehicle;
   ground_truth_pub_.publish(groundTruthMsg_);
 
-  publishGPS(sim_time);
+  // publish simulated GPS fixes
+  if (gps_rate_ <= 0.0)
+    {
+      publishGPS(odomMsg_);             // lockstep with the world
+    }
+  else
+    {
+      if (next_gps_time_.isZero())
+        next_gps_time_ = sim_time;
+      ros::Duration period(1.0 / gps_rate_);
+      nav_msgs::Odometry odom_sample;
+      sensor_msgs::Imu imu_sample;
+      while (next_gps_time_ <= sim_time)
+        {
+          interpolateState(next_gps_time_, odomMsg_, imu_msg,
+                           &odom_sample, &imu_sample);
+          publishGPS(odom_sample);
+          next_gps_time_ += period;
+        }
+    }
 
+  last_odom_msg_ = odomMsg_;
+  last_imu_msg_ = imu_msg;
   last_update_time_ = sim_time;
 }
 
-void ArtVehicleModel::publishGPS(ros::Time sim_time)
+/** Publish one odometry and IMU sample with the vehicle transforms.
+ *
+ *  @param odom odometry sample, already stamped
+ *  @param imu corresponding IMU sample
+ */
+void ArtVehicleModel::publishOdometry(const nav_msgs::Odometry &odom,
+                                      const sensor_msgs::Imu &imu)
+{
+  odom_pub_.publish(odom);
+  imu_pub_.publish(imu);
+
+  // broadcast /earth transform relative to sea level
+  tf::Quaternion vehicleQ;
+  tf::quaternionMsgToTF(odom.pose.pose.orientation, vehicleQ);
+  tf::Transform txEarth(vehicleQ,
+                       tf::Point(odom.pose.pose.position.x,
+                                 odom.pose.pose.position.y,
+                                 odom.pose.pose.position.z));
+  tf_->sendTransform(tf::StampedTransform(txEarth, odom.header.stamp,
+                                          tf_prefix_ + ArtFrames::earth,
+                                          tf_prefix_ + ArtFrames::vehicle));
+
+  // Also publish /odom frame with same elevation as /vehicle and same
+  // orientation as /earth
+  tf::Transform txOdom(tf::Quaternion(0.0, 0.0, 0.0, 1.0),
+                       tf::Point(0.0, 0.0, -odom.pose.pose.position.z));
+  tf_->sendTransform(tf::StampedTransform(txOdom, odom.header.stamp,
+                                          tf_prefix_ + ArtFrames::odom,
+                                          tf_prefix_ + ArtFrames::earth));
+}
+
+/** Interpolate the vehicle state at an intermediate sample time.
+ *
+ *  @pre last_odom_msg_ and last_imu_msg_ hold the state at the
+ *       previous world update.
+ *  @param t sample time, normally within (last update, current update]
+ *  @param cur_odom odometry state at the current world update
+ *  @param cur_imu IMU state at the current world update
+ *  @param odom[out] -> interpolated odometry, stamped at @a t
+ *  @param imu[out] -> interpolated IMU state, stamped at @a t
+ *
+ *  Position, speed and acceleration blend linearly between the two
+ *  updates; yaw follows the shortest arc.  Times at or beyond the
+ *  current update just get the current state.
+ */
+void ArtVehicleModel::interpolateState(ros::Time t,
+                                       const nav_msgs::Odometry &cur_odom,
+                                       const sensor_msgs::Imu &cur_imu,
+                                       nav_msgs::Odometry *odom,
+                                       sensor_msgs::Imu *imu)
+{
+  double span = (cur_odom.header.stamp
+                 - last_odom_msg_.header.stamp).toSec();
+  double alpha = 1.0;
+  if (span > 0.0)
+    {
+      alpha = (t - last_odom_msg_.header.stamp).toSec() / span;
+      alpha = fmax(0.0, fmin(1.0, alpha));
+    }
+
+  *odom = cur_odom;
+  *imu = cur_imu;
+
+  const geometry_msgs::Point &p0 = last_odom_msg_.pose.pose.position;
+  const geometry_msgs::Point &p1 = cur_odom.pose.pose.position;
+  odom->pose.pose.position.x = p0.x + alpha * (p1.x - p0.x);
+  odom->pose.pose.position.y = p0.y + alpha * (p1.y - p0.y);
+
+  double yaw0 = tf::getYaw(last_odom_msg_.pose.pose.orientation);
+  double yaw1 = tf::getYaw(cur_odom.pose.pose.orientation);
+  double yaw = yaw0 + alpha * angles::shortest_angular_distance(yaw0, yaw1);
+  odom->pose.pose.orientation = tf::createQuaternionMsgFromYaw(yaw);
+
+  odom->twist.twist.linear.x =
+    (last_odom_msg_.twist.twist.linear.x
+     + alpha * (cur_odom.twist.twist.linear.x
+                - last_odom_msg_.twist.twist.linear.x));
+  odom->twist.twist.angular.z =
+    (last_odom_msg_.twist.twist.angular.z
+     + alpha * (cur_odom.twist.twist.angular.z
+                - last_odom_msg_.twist.twist.angular.z));
+
+  imu->orientation = odom->pose.pose.orientation;
+  imu->angular_velocity.z = odom->twist.twist.angular.z;
+  imu->linear_acceleration.x =
+    (last_imu_msg_.linear_acceleration.x
+     + alpha * (cur_imu.linear_acceleration.x
+                - last_imu_msg_.linear_acceleration.x));
+
+  odom->header.stamp = t;
+  imu->header.stamp = t;
+}
+
+/** Publish a simulated GPS fix for an odometry sample.
+ *
+ *  @param odom odometry sample supplying the fix time and position
+ */
+void ArtVehicleModel::publishGPS(const nav_msgs::Odometry &odom)
 {
   art_msgs::GpsInfo gpsi;
 
-  gpsi.header.stamp = sim_time;
+  gpsi.header.stamp = odom.header.stamp;
   gpsi.header.frame_id = tf_prefix_ + ArtFrames::odom;
 
   // relocate pose relative to map origin
-  gpsi.utm_e = (odomMsg_.pose.pose.position.x
+  gpsi.utm_e = (odom.pose.pose.position.x
                 - map_origin_x_ + origin_easting_);
-  gpsi.utm_n = (odomMsg_.pose.pose.position.y
+  gpsi.utm_n = (odom.pose.pose.position.y
                 - map_origin_y_ + origin_northing_);
 
   UTM::UTMtoLL(gpsi.utm_n, gpsi.utm_e, origin_zone_,
                gpsi.latitude, gpsi.longitude);
 
   gpsi.zone = origin_zone_;
-  gpsi.altitude   = odomMsg_.pose.pose.position.z;
+  gpsi.altitude   = odom.pose.pose.position.z;
   gpsi.quality = art_msgs::GpsInfo::DGPS_FIX;
   gpsi.num_sats = 9;
 
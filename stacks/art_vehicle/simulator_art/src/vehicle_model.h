@@ -54,12 +54,15 @@ public:
     tf_ = tfBroad;                      // ROS transform broadcaster
     ns_prefix_ = ns_prefix;             // namespace prefix
     tf_prefix_ = ns_prefix + "/";       // transform ID prefix
+    if (!ns_prefix_.empty())
+      ns_prefix_ += "/";                // separate relative topic names
 
     // servo control status
-    brake_position_ = 1.0;
-    shifter_gear_ = art_msgs::Shifter::Drive;
-    steering_angle_ = 0.0;
-    throttle_position_ = 0.0;
+    servos_.brake_position = 1.0;
+    servos_.shifter_gear = art_msgs::Shifter::Drive;
+    servos_.steering_angle = 0.0;
+    servos_.throttle_position = 0.0;
+    servo_snap_ = servos_;
   }
   ~ArtVehicleModel() {};
 
@@ -104,15 +107,46 @@ private:
 
   // servo control status
   //
-  // The mutex serializes access to these fields, which are set by
-  // message callbacks running in a separate thread.
+  // Message callbacks running in a separate thread store the latest
+  // state in servos_ under the mutex.  Each dynamics step copies it
+  // into the servo_snap_ snapshot in one short critical section, so
+  // the lock is never held while integrating, and a burst of
+  // brake/throttle/steering messages cannot stall the simulation.
+  typedef struct
+  {
+    float brake_position;
+    uint8_t shifter_gear;
+    float steering_angle;
+    float throttle_position;
+  } servo_state_t;
+
   boost::mutex msg_lock_;
-  float brake_position_;
-  uint8_t shifter_gear_;
-  float steering_angle_;
-  float throttle_position_;
+  servo_state_t servos_;                // latest received servo state
+  servo_state_t servo_snap_;            // dynamics step snapshot
 
-  void publishGPS(ros::Time sim_time);
+  // Decoupled sensor rates.
+  //
+  // Each simulated sensor publishes on its own schedule instead of in
+  // lockstep with the world update, so simulation can mirror the real
+  // vehicle's sensor mix (100 Hz odometry, 10 Hz GPS).  Samples due
+  // between world updates are interpolated between the previous and
+  // current vehicle state and stamped on the sensor's own time grid.
+  // A rate of zero keeps the old behavior: publish every update.
+  void publishOdometry(const nav_msgs::Odometry &odom,
+                       const sensor_msgs::Imu &imu);
+  void publishGPS(const nav_msgs::Odometry &odom);
+  void interpolateState(ros::Time t,
+                        const nav_msgs::Odometry &cur_odom,
+                        const sensor_msgs::Imu &cur_imu,
+                        nav_msgs::Odometry *odom,
+                        sensor_msgs::Imu *imu);
+
+  double odom_rate_;                    // odometry/IMU rate (Hz)
+  double gps_rate_;                     // GPS fix rate (Hz)
+  ros::Time next_odom_time_;            // next odometry sample due
+  ros::Time next_gps_time_;             // next GPS fix due
+  nav_msgs::Odometry last_odom_msg_;    // state at previous update
+  sensor_msgs::Imu last_imu_msg_;
 
   double origin_lat_;
   double origin_long_;